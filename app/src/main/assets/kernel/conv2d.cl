@@ -1185,10 +1185,24 @@ __kernel void im2win_channel_reg_transpose_reorder_vector_v8_matmul(
     const int kernel_size,
     const int stride
 ) {
+#ifdef CONV_M
+    /* shape 특화 (SpecializedKernel) : argument 대신 상수 */
+#define M CONV_M
+#define N CONV_N
+#define width_win CONV_WIDTH_WIN
+#define in_channel CONV_IN_CHANNEL
+#define kernel_size CONV_KERNEL_SIZE
+#define stride CONV_STRIDE
+#endif
     const int reg_size_c = 4;
     const int reg_size_m = 4;
+#ifdef CONV_LOCAL_M
+    const int local_size_c = 1;
+    const int local_size_m = CONV_LOCAL_M;
+#else
     const int local_size_c = get_local_size(0);
     const int local_size_m = get_local_size(2);
+#endif
     const int c = get_group_id(0) * local_size_c * reg_size_c + get_local_id(0);
     const int n = get_group_id(1) * get_local_size(1) + get_local_id(1);
     const int m = get_group_id(2) * local_size_m * reg_size_m + get_local_id(2) * reg_size_m;
@@ -1259,4 +1273,107 @@ __kernel void im2win_channel_reg_transpose_reorder_vector_v8_matmul(
             output[(c + reg_c * local_size_c) * M * N + ((m + reg_m) * N + n)] = sum[reg_c][reg_m] + bias[c + reg_c * local_size_c];
         }
     }
-}
\ No newline at end of file
+#ifdef CONV_M
+#undef M
+#undef N
+#undef width_win
+#undef in_channel
+#undef kernel_size
+#undef stride
+#endif
+}
+/*
+ * implicit GEMM: read NCHW `input` directly, no im2win buffer.
+ * work group = (1, tile_n, tile_m / reg_size_m) computes reg_size_c output channels
+ * of a (tile_m x tile_n) output tile. For every `tile_k` input channels the
+ * ((tile_m-1)*stride+k) x ((tile_n-1)*stride+k) input patch is staged in local memory,
+ * and out-of-range (padding) positions are filled with zero.
+ */
+__kernel void implicit_gemm_conv2d(
+    __global const float *weight,
+    __global const float *bias,
+    __global const float *input,
+    __global float *output,
+    const int in_channel,
+    const int height,
+    const int width,
+    const int out_height,
+    const int out_width,
+    const int kernel_size,
+    const int stride,
+    const int padding,
+    const int tile_k,
+    __local float *input_sub,
+    __local float *weight_sub
+) {
+    const int reg_size_c = 4;
+    const int reg_size_m = 4;
+    const int tile_n = get_local_size(1);
+    const int tile_m = get_local_size(2) * reg_size_m;
+    const int local_n = get_local_id(1);
+    const int local_m = get_local_id(2) * reg_size_m;
+    const int c = get_group_id(0) * reg_size_c;
+    const int n = get_global_id(1);
+    const int m = get_group_id(2) * tile_m + local_m;
+
+    const int patch_h = (tile_m - 1) * stride + kernel_size;
+    const int patch_w = (tile_n - 1) * stride + kernel_size;
+    const int patch_size = patch_h * patch_w;
+    const int origin_h = get_group_id(2) * tile_m * stride - padding;
+    const int origin_w = get_group_id(1) * tile_n * stride - padding;
+    const int kernel_area = kernel_size * kernel_size;
+
+    const int lid = get_local_id(2) * tile_n + local_n;
+    const int group_size = tile_n * get_local_size(2);
+
+    float sum[reg_size_c][reg_size_m];
+    for (int i = 0; i < reg_size_c; i++) {
+        for (int j = 0; j < reg_size_m; j++) {
+            sum[i][j] = 0.0f;
+        }
+    }
+
+    for (int c_in_base = 0; c_in_base < in_channel; c_in_base += tile_k) {
+        for (int index = lid; index < tile_k * patch_size; index += group_size) {
+            int k = index / patch_size;
+            int p = index % patch_size;
+            int h = origin_h + p / patch_w;
+            int w = origin_w + p % patch_w;
+            float value = 0.0f;
+            if (h >= 0 && h < height && w >= 0 && w < width) {
+                value = input[((c_in_base + k) * height + h) * width + w];
+            }
+            input_sub[index] = value;
+        }
+        for (int index = lid; index < reg_size_c * tile_k * kernel_area; index += group_size) {
+            int reg_c = index / (tile_k * kernel_area);
+            int rest = index % (tile_k * kernel_area);
+            weight_sub[index] = weight[((c + reg_c) * in_channel + c_in_base) * kernel_area + rest];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (int k = 0; k < tile_k; k++) {
+            for (int i = 0; i < kernel_size; i++) {
+                for (int j = 0; j < kernel_size; j++) {
+                    float input_tmp[reg_size_m];
+                    for (int reg_m = 0; reg_m < reg_size_m; reg_m++) {
+                        input_tmp[reg_m] = input_sub[k * patch_size + ((local_m + reg_m) * stride + i) * patch_w + local_n * stride + j];
+                    }
+                    for (int reg_c = 0; reg_c < reg_size_c; reg_c++) {
+                        float weight_tmp = weight_sub[(reg_c * tile_k + k) * kernel_area + i * kernel_size + j];
+                        for (int reg_m = 0; reg_m < reg_size_m; reg_m++) {
+                            sum[reg_c][reg_m] += weight_tmp * input_tmp[reg_m];
+                        }
+                    }
+                }
+            }
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    for (int reg_c = 0; reg_c < reg_size_c; reg_c++) {
+        for (int reg_m = 0; reg_m < reg_size_m; reg_m++) {
+            output[(c + reg_c) * out_height * out_width + (m + reg_m) * out_width + n] = sum[reg_c][reg_m] + bias[c + reg_c];
+        }
+    }
+}
@@ -44,7 +44,9 @@ __kernel void einsum_bij_bjk_bik(
 }
 
 // tiled local, register, vector
+#ifndef WIDTH
 #define WIDTH 4
+#endif
 #if WIDTH == 1
     typedef float floatX;
 #elif WIDTH == 2
@@ -154,10 +156,19 @@ __kernel void optimized_einsum_bik_bkj_bij(
     __global float *C,
     const int K
 ) {
+#ifdef EINSUM_K
+    /* shape 특화 (SpecializedKernel) : argument 대신 상수 */
+#define K EINSUM_K
+#endif
 
     const int reg_size_m = 4;
+#ifdef EINSUM_LOCAL_M
+    const int local_size_i = EINSUM_LOCAL_M;
+    const int local_size_j = EINSUM_LOCAL_N;
+#else
     const int local_size_i = get_local_size(1);
     const int local_size_j = get_local_size(2);
+#endif
 
     const int group_i = get_group_id(1);
     const int group_j = get_group_id(2);
@@ -165,8 +176,13 @@ __kernel void optimized_einsum_bik_bkj_bij(
     const int local_id_i = get_local_id(1);
     const int local_id_j = get_local_id(2);
 
+#ifdef EINSUM_M
+    const int M = EINSUM_M;
+    const int N_div_width = EINSUM_N / WIDTH;
+#else
     const int M = get_global_size(1) * reg_size_m;
     const int N_div_width = get_global_size(2);
+#endif
     const int bi_offset = get_global_id(0) * M;
     const int bj_offset = get_global_id(0) * K * N_div_width;
 
@@ -301,6 +317,9 @@ __kernel void optimized_einsum_bik_bkj_bij(
             C[(i + wm * local_size_i) * (N_div_width * WIDTH) + (group_j * local_size_j * WIDTH + local_id_j*WIDTH+wn)] = acc[wm][wn];
         }
     }
+#ifdef EINSUM_K
+#undef K
+#endif
 }
 
 __kernel void optimized_einsum_bik_bkj_bij_general(
@@ -461,4 +480,30 @@ __kernel void optimized_einsum_bik_bkj_bij_general(
             }
         }
     }
-}
\ No newline at end of file
+}
+/*
+ * fused to_qkv 결과 (M, 3 * H * D) (q | k | v) -> head-major Q (H, M, D), K, V (H, M, D).
+ * transpose_k 이면 K 는 (H, D, ldk) (optimized_einsum_bik_bkj_bij_general 의 입력, ldk >= M).
+ * global size = (M, H, D)
+ */
+__kernel void split_qkv_heads(
+    __global const float *qkv,
+    __global float *q,
+    __global float *k,
+    __global float *v,
+    const int transpose_k,
+    const int ldk
+) {
+    const int m = get_global_id(0);
+    const int h = get_global_id(1);
+    const int d = get_global_id(2);
+    const int M = get_global_size(0);
+    const int D = get_global_size(2);
+    const int E = get_global_size(1) * D;
+
+    const int src = m * 3 * E + h * D + d;
+    const int dst = (h * M + m) * D + d;
+    q[dst] = qkv[src];
+    k[transpose_k ? (h * D + d) * ldk + m : dst] = qkv[src + E];
+    v[dst] = qkv[src + 2 * E];
+}
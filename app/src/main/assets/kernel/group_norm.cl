@@ -73,4 +73,34 @@ __kernel void group_norm(__global const float *input,
     float temp = input[globalID] - mean[groupID];
     temp /= sqrt(variance[groupID] + epsilon);
     output[globalID] = fma(temp, weight[channelID], bias[channelID]);
-}
\ No newline at end of file
+}
+
+/*
+ * group_norm + (C, HW) -> (HW, C) permute. channel 4 개씩 float4 로 씀.
+ * channelsPerGroup 은 4 의 배수가 아니어도 됨 (e.g. 320 / 32 = 10).
+ * global size = (HW, C / 4)
+ */
+__kernel void group_norm_channel_last(__global const float *input,
+                        __global const float *mean,
+                        __global const float *variance,
+                        __global const float *weight,
+                        __global const float *bias,
+                        const int channelsPerGroup,
+                        const float epsilon,
+                        __global float4 *output
+) {
+    const int p = get_global_id(0);
+    const int c4 = get_global_id(1);
+    const int HW = get_global_size(0);
+    const int c = c4 * 4;
+
+    const int4 group = (int4)(c, c + 1, c + 2, c + 3) / channelsPerGroup;
+    const float4 x = (float4)(input[c * HW + p], input[(c + 1) * HW + p],
+                              input[(c + 2) * HW + p], input[(c + 3) * HW + p]);
+    const float4 m = (float4)(mean[group.x], mean[group.y], mean[group.z], mean[group.w]);
+    const float4 v = (float4)(variance[group.x], variance[group.y],
+                              variance[group.z], variance[group.w]);
+
+    output[p * get_global_size(1) + c4] = fma((x - m) / sqrt(v + epsilon), vload4(c4, weight),
+                                              vload4(c4, bias));
+}
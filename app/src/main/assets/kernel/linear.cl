@@ -329,7 +329,9 @@ __kernel void tile_reg_n_linear(
     }
 }
 
+#ifndef WIDTH
 #define WIDTH 4
+#endif
 #if WIDTH == 1
     typedef float floatX;
 #elif WIDTH == 2
@@ -546,10 +548,27 @@ __kernel void tile_reg_m_vector_n_linear(
     const int N,
     const int K
 ) {
+#ifdef LINEAR_M
+    /* shape 특화 (SpecializedKernel) : argument 대신 상수 */
+#define M LINEAR_M
+#define N LINEAR_N
+#define K LINEAR_K
+#endif
 
     const int reg_size_m = 4;
+#ifdef LINEAR_LOCAL_M
+    const int local_size_i = LINEAR_LOCAL_M;
+    const int local_size_j = LINEAR_LOCAL_N;
+#else
     const int local_size_i = get_local_size(1);
     const int local_size_j = get_local_size(2);
+#endif
+#if LINEAR_ALIGNED_M
+    /* M % (local_size_i * reg_size_m) == 0 */
+#define IN_M(row) true
+#else
+#define IN_M(row) ((row) < M)
+#endif
 
     const int group_i = get_group_id(1);
     const int group_j = get_group_id(2);
@@ -557,7 +576,11 @@ __kernel void tile_reg_m_vector_n_linear(
     const int local_id_i = get_local_id(1);
     const int local_id_j = get_local_id(2);
 
+#ifdef LINEAR_N
+    const int N_div_width = N / WIDTH;
+#else
     const int N_div_width = get_global_size(2);
+#endif
 
     int b = get_global_id(0);
     int i = group_i * local_size_i * reg_size_m + local_id_i;
@@ -576,14 +599,14 @@ __kernel void tile_reg_m_vector_n_linear(
     for (int k = 0; k < K; k++) {
         if (k % WIDTH == 0) {
             for (int wm=0; wm<reg_size_m; wm++) {
-                if (i + wm * local_size_i < M) {
+                if (IN_M(i + wm * local_size_i)) {
                     vecA[wm] = A[((b * M) + i + wm * local_size_i) * K_div_width + (k / WIDTH)];
                 }
             }
         }
         vecB = B[((b * K) + k) * N_div_width + j_div_WIDTH];
         for (int wm=0; wm<reg_size_m; wm++) {
-            if (i + wm * local_size_i >= M) break;
+            if (!IN_M(i + wm * local_size_i)) break;
             float A;
 #if WIDTH == 1
             acc[wm][0] += vecA[wm] * vecB;
@@ -691,7 +714,7 @@ __kernel void tile_reg_m_vector_n_linear(
     }
 
     for (int wm=0; wm<reg_size_m; wm++) {
-        if (i + wm * local_size_i >= M) break;
+        if (!IN_M(i + wm * local_size_i)) break;
         for (int wn=0; wn<WIDTH; wn++) {
             int j = j_div_WIDTH * WIDTH + wn;
             if (j < N) {
@@ -702,4 +725,11 @@ __kernel void tile_reg_m_vector_n_linear(
             }
         }
     }
+
+#undef IN_M
+#ifdef LINEAR_M
+#undef M
+#undef N
+#undef K
+#endif
 }
\ No newline at end of file
@@ -308,4 +308,80 @@ __kernel void batch_matmul(
             C[global_m*N + global_n + offset_batch_C] = acc[wm][wn];
         }
     }
-}
\ No newline at end of file
+}
+#ifndef CAUSAL_HEAD_DIM
+#define CAUSAL_HEAD_DIM 64
+#endif
+#define CAUSAL_TILE 16
+
+/*
+ * causal self attention (CLIP text encoder), launch 하나.
+ * qkv = in_proj 결과 (L, 3E) (q | k | v), output = (L, E) (out_proj 입력, head 는 E 방향으로 이어짐)
+ * global size = (L 을 local size 의 배수로, heads), work-item 하나가 query 하나의 head 하나.
+ * K, V 는 CAUSAL_TILE 개 key 씩 local memory 에 올리고 online softmax 로 누적, j > i (mask -inf) 는 계산하지 않음.
+ */
+__kernel void causal_attention(
+    __global const float4 *qkv,
+    __global float4 *output,
+    const int L,
+    const int E,
+    const float scale,
+    __local float4 *localK,
+    __local float4 *localV
+) {
+    const int i = get_global_id(0);
+    const int h = get_global_id(1);
+    const int lid = get_local_id(0);
+    const int localSize = get_local_size(0);
+
+    const int D4 = CAUSAL_HEAD_DIM / 4;
+    const int E4 = E / 4;
+    const int stride = 3 * E4;
+    const int offset = h * D4;
+
+    float4 q[CAUSAL_HEAD_DIM / 4];
+    float4 acc[CAUSAL_HEAD_DIM / 4];
+    for (int d = 0; d < D4; d++) {
+        q[d] = i < L ? qkv[i * stride + offset + d] * scale : (float4) 0.0f;
+        acc[d] = (float4) 0.0f;
+    }
+    float m = -INFINITY;
+    float l = 0.0f;
+
+    /* group 의 마지막 query 까지의 key 만 */
+    const int end = min((int) (get_group_id(0) + 1) * localSize, L);
+    for (int t = 0; t < end; t += CAUSAL_TILE) {
+        const int count = min(CAUSAL_TILE, L - t);
+        barrier(CLK_LOCAL_MEM_FENCE);
+        for (int x = lid; x < count * D4; x += localSize) {
+            const int row = (t + x / D4) * stride + offset + x % D4;
+            localK[x] = qkv[row + E4];
+            localV[x] = qkv[row + 2 * E4];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        const int keys = i < L ? min(count, i - t + 1) : 0;
+        for (int j = 0; j < keys; j++) {
+            float4 s4 = (float4) 0.0f;
+            for (int d = 0; d < D4; d++) {
+                s4 += q[d] * localK[j * D4 + d];
+            }
+            const float s = s4.x + s4.y + s4.z + s4.w;
+            const float mNew = fmax(m, s);
+            const float correction = exp(m - mNew);
+            const float p = exp(s - mNew);
+            l = l * correction + p;
+            for (int d = 0; d < D4; d++) {
+                acc[d] = acc[d] * correction + p * localV[j * D4 + d];
+            }
+            m = mNew;
+        }
+    }
+
+    if (i < L) {
+        const float inv = 1.0f / l;
+        for (int d = 0; d < D4; d++) {
+            output[i * E4 + offset + d] = acc[d] * inv;
+        }
+    }
+}
@@ -63,6 +63,27 @@ __kernel void permute3D__0_2_1(__global float *src,
     dst[dst_idx] = src[src_idx];
 }
 
+/*
+ * output (C, HW) = src (HW, C) 를 transpose + residual (C, HW).
+ * SpatialTransformer proj_out 결과를 permute 없이 residual 에 더함. src 는 channel 4 개씩 float4 로 읽음.
+ * global size = (HW, C / 4)
+ */
+__kernel void channel_first_add(__global const float4 *src,
+                                __global const float *residual,
+                                __global float *output)
+{
+    const int p = get_global_id(0);
+    const int c4 = get_global_id(1);
+    const int HW = get_global_size(0);
+    const int c = c4 * 4;
+
+    const float4 x = src[p * get_global_size(1) + c4];
+    output[c * HW + p] = x.x + residual[c * HW + p];
+    output[(c + 1) * HW + p] = x.y + residual[(c + 1) * HW + p];
+    output[(c + 2) * HW + p] = x.z + residual[(c + 2) * HW + p];
+    output[(c + 3) * HW + p] = x.w + residual[(c + 3) * HW + p];
+}
+
 __kernel void permute3D(
     __global float *src,
     __global float *dst,
@@ -325,6 +346,114 @@ __kernel void batch_matmul_scale(
     }
 }
 
+/*
+ * batch 마다 C (M, N) = A (M, K) x B (K, N) * scale.
+ * layout (int4) : (offset, batch stride, row stride, col stride). transpose, head 분할을 stride 로 읽고 써서 permute 가 필요 없음.
+ * e.g. head h 의 Q (M, D) = to_q 결과 (M, H * D) 에서 (h * D, D, H * D, 1), K^T (D, N) = (h * D, D, 1, H * D)
+ * M, N, K 가 tile 배수가 아니어도 됨 (tile 밖은 0).
+ * local size = (1, STRIDED_TILE_M / STRIDED_REG_M, STRIDED_TILE_N / STRIDED_REG_N)
+ * global size = (batch, ceil(M / STRIDED_TILE_M) * local size m, ceil(N / STRIDED_TILE_N) * local size n)
+ */
+#define STRIDED_TILE_M 64
+#define STRIDED_TILE_N 64
+#define STRIDED_TILE_K 16
+#define STRIDED_REG_M 4
+#define STRIDED_REG_N 4
+
+__kernel void strided_batch_matmul(
+    __global const float *A,
+    __global const float *B,
+    __global float *C,
+    const int M,
+    const int N,
+    const int K,
+    const int4 layoutA,
+    const int4 layoutB,
+    const int4 layoutC,
+    const float scale
+) {
+    const int localSizeM = STRIDED_TILE_M / STRIDED_REG_M;
+    const int localSizeN = STRIDED_TILE_N / STRIDED_REG_N;
+    const int localM = get_local_id(1);
+    const int localN = get_local_id(2);
+    const int localID = localM * localSizeN + localN;
+    const int localSize = localSizeM * localSizeN;
+    const int offsetM = get_group_id(1) * STRIDED_TILE_M;
+    const int offsetN = get_group_id(2) * STRIDED_TILE_N;
+
+    const int batch = get_global_id(0);
+    __global const float *a = A + layoutA.x + batch * layoutA.y;
+    __global const float *b = B + layoutB.x + batch * layoutB.y;
+    __global float *c = C + layoutC.x + batch * layoutC.y;
+
+    __local float Asub[STRIDED_TILE_K][STRIDED_TILE_M];
+    __local float Bsub[STRIDED_TILE_K][STRIDED_TILE_N];
+
+    float acc[STRIDED_REG_M][STRIDED_REG_N];
+    for (int wm = 0; wm < STRIDED_REG_M; wm++) {
+        for (int wn = 0; wn < STRIDED_REG_N; wn++) {
+            acc[wm][wn] = 0.0f;
+        }
+    }
+
+    for (int t = 0; t < K; t += STRIDED_TILE_K) {
+        /* 연속 (stride 1) 인 차원이 id 를 따라가도록 읽음 (coalescing) */
+        for (int id = localID; id < STRIDED_TILE_M * STRIDED_TILE_K; id += localSize) {
+            int m, k;
+            if (layoutA.w == 1) {
+                m = id / STRIDED_TILE_K;
+                k = id % STRIDED_TILE_K;
+            } else {
+                k = id / STRIDED_TILE_M;
+                m = id % STRIDED_TILE_M;
+            }
+            const int globalM = offsetM + m;
+            const int globalK = t + k;
+            Asub[k][m] = (globalM < M && globalK < K) ?
+                         a[globalM * layoutA.z + globalK * layoutA.w] : 0.0f;
+        }
+        for (int id = localID; id < STRIDED_TILE_N * STRIDED_TILE_K; id += localSize) {
+            int n, k;
+            if (layoutB.z == 1) {
+                n = id / STRIDED_TILE_K;
+                k = id % STRIDED_TILE_K;
+            } else {
+                k = id / STRIDED_TILE_N;
+                n = id % STRIDED_TILE_N;
+            }
+            const int globalN = offsetN + n;
+            const int globalK = t + k;
+            Bsub[k][n] = (globalN < N && globalK < K) ?
+                         b[globalK * layoutB.z + globalN * layoutB.w] : 0.0f;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (int k = 0; k < STRIDED_TILE_K; k++) {
+            float Breg[STRIDED_REG_N];
+            for (int wn = 0; wn < STRIDED_REG_N; wn++) {
+                Breg[wn] = Bsub[k][localN + wn * localSizeN];
+            }
+            for (int wm = 0; wm < STRIDED_REG_M; wm++) {
+                const float Areg = Asub[k][localM + wm * localSizeM];
+                for (int wn = 0; wn < STRIDED_REG_N; wn++) {
+                    acc[wm][wn] += Areg * Breg[wn];
+                }
+            }
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    for (int wm = 0; wm < STRIDED_REG_M; wm++) {
+        const int globalM = offsetM + localM + wm * localSizeM;
+        for (int wn = 0; wn < STRIDED_REG_N; wn++) {
+            const int globalN = offsetN + localN + wn * localSizeN;
+            if (globalM < M && globalN < N) {
+                c[globalM * layoutC.z + globalN * layoutC.w] = acc[wm][wn] * scale;
+            }
+        }
+    }
+}
+
 __kernel void permute3D_copy(
     __global float *src,
     __global float *dst,
@@ -366,4 +495,171 @@ __kernel void permute3D_copy(
     dst_idx += dstOffset;
 
     dst[dst_idx] = src[src_idx];
-}
\ No newline at end of file
+}
+/*
+ * latent (4, H, W) -> preview rgb (3, H, W), [-1, 1].
+ * rgb[c] = bias[c] + sum_k weight[c][k] * latent[k] (pixel 별 4x3 linear)
+ */
+__kernel void latent_preview(
+    __global const float *latent,
+    __global const float *weight,
+    __global const float *bias,
+    __global float *output
+) {
+    const int i = get_global_id(0);
+    const int size = get_global_size(0);
+
+    const float l0 = latent[i];
+    const float l1 = latent[size + i];
+    const float l2 = latent[2 * size + i];
+    const float l3 = latent[3 * size + i];
+
+    for (int c = 0; c < 3; c++) {
+        float v = bias[c] + weight[c * 4] * l0 + weight[c * 4 + 1] * l1
+                + weight[c * 4 + 2] * l2 + weight[c * 4 + 3] * l3;
+        output[c * size + i] = clamp(v, -1.0f, 1.0f);
+    }
+}
+
+/*
+ * output[i] = table[tokens[i]] + positional[i], global size = (tokens, dim / 4)
+ */
+__kernel void token_embedding(
+    __global const int *tokens,
+    __global const float4 *table,
+    __global const float4 *positional,
+    __global float4 *output
+) {
+    const int i = get_global_id(0);
+    const int j = get_global_id(1);
+    const int dim4 = get_global_size(1);
+
+    output[i * dim4 + j] = table[tokens[i] * dim4 + j] + positional[i * dim4 + j];
+}
+
+/* fp16 table (vload_half 는 cl_khr_fp16 없이 사용 가능) */
+__kernel void token_embedding_half(
+    __global const int *tokens,
+    __global const half *table,
+    __global const float4 *positional,
+    __global float4 *output
+) {
+    const int i = get_global_id(0);
+    const int j = get_global_id(1);
+    const int dim4 = get_global_size(1);
+
+    output[i * dim4 + j] = vload_half4(tokens[i] * dim4 + j, table) + positional[i * dim4 + j];
+}
+
+/* (m, s) : row 의 max 와 sum(exp(x - m)). m 이 -inf 이면 아직 유한한 값이 없음 */
+inline void softmax_merge(float *m, float *s, float m2, float s2) {
+    const float mNew = fmax(*m, m2);
+    if (mNew == -INFINITY) {
+        return;
+    }
+    *s = (*m == -INFINITY ? 0.0f : *s * exp(*m - mNew)) +
+         (m2 == -INFINITY ? 0.0f : s2 * exp(m2 - mNew));
+    *m = mNew;
+}
+
+/* work-group (local size 는 2 의 거듭제곱) 의 (m, s) 를 합침. 모든 work-item 이 같은 결과 */
+inline void softmax_reduce(float *m, float *s, __local float *localMax, __local float *localSum) {
+    const int localID = get_local_id(0);
+    localMax[localID] = *m;
+    localSum[localID] = *s;
+    for (int offset = get_local_size(0) / 2; offset > 0; offset /= 2) {
+        barrier(CLK_LOCAL_MEM_FENCE);
+        if (localID < offset) {
+            float m1 = localMax[localID];
+            float s1 = localSum[localID];
+            softmax_merge(&m1, &s1, localMax[localID + offset], localSum[localID + offset]);
+            localMax[localID] = m1;
+            localSum[localID] = s1;
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    *m = localMax[0];
+    *s = localSum[0];
+}
+
+/*
+ * row (chunkSize) 마다 work-group 하나. max 를 빼는 online softmax (max 와 sum 을 한 번에 구함).
+ * row 를 local memory 에 두지 않으므로 길이 제한 없음, in-place 가능.
+ * float4 (vload4 는 float 정렬만 필요) 로 읽고 4 로 나눠지지 않는 끝은 scalar.
+ */
+__kernel void softmax_online(
+    __global const float *input,
+    __global float *output,
+    __local float *localMax,
+    __local float *localSum,
+    const int chunkSize
+) {
+    const int localID = get_local_id(0);
+    const int localSize = get_local_size(0);
+    __global const float *in = input + get_group_id(0) * chunkSize;
+    __global float *out = output + get_group_id(0) * chunkSize;
+    const int n4 = chunkSize / 4;
+
+    float m = -INFINITY;
+    float s = 0.0f;
+    for (int j = localID; j < n4; j += localSize) {
+        const float4 x = vload4(j, in);
+        const float xMax = fmax(fmax(x.x, x.y), fmax(x.z, x.w));
+        if (xMax == -INFINITY) {
+            continue;
+        }
+        const float4 e = exp(x - xMax);
+        softmax_merge(&m, &s, xMax, e.x + e.y + e.z + e.w);
+    }
+    for (int j = n4 * 4 + localID; j < chunkSize; j += localSize) {
+        softmax_merge(&m, &s, in[j], 1.0f);
+    }
+    softmax_reduce(&m, &s, localMax, localSum);
+
+    const float inv = 1.0f / s;
+    for (int j = localID; j < n4; j += localSize) {
+        vstore4(exp(vload4(j, in) - m) * inv, j, out);
+    }
+    for (int j = n4 * 4 + localID; j < chunkSize; j += localSize) {
+        out[j] = exp(in[j] - m) * inv;
+    }
+}
+
+/* fp16 input / output (계산은 float, vload_half 는 cl_khr_fp16 없이 사용 가능) */
+__kernel void softmax_online_half(
+    __global const half *input,
+    __global half *output,
+    __local float *localMax,
+    __local float *localSum,
+    const int chunkSize
+) {
+    const int localID = get_local_id(0);
+    const int localSize = get_local_size(0);
+    __global const half *in = input + get_group_id(0) * chunkSize;
+    __global half *out = output + get_group_id(0) * chunkSize;
+    const int n4 = chunkSize / 4;
+
+    float m = -INFINITY;
+    float s = 0.0f;
+    for (int j = localID; j < n4; j += localSize) {
+        const float4 x = vload_half4(j, in);
+        const float xMax = fmax(fmax(x.x, x.y), fmax(x.z, x.w));
+        if (xMax == -INFINITY) {
+            continue;
+        }
+        const float4 e = exp(x - xMax);
+        softmax_merge(&m, &s, xMax, e.x + e.y + e.z + e.w);
+    }
+    for (int j = n4 * 4 + localID; j < chunkSize; j += localSize) {
+        softmax_merge(&m, &s, vload_half(j, in), 1.0f);
+    }
+    softmax_reduce(&m, &s, localMax, localSum);
+
+    const float inv = 1.0f / s;
+    for (int j = localID; j < n4; j += localSize) {
+        vstore_half4(exp(vload_half4(j, in) - m) * inv, j, out);
+    }
+    for (int j = n4 * 4 + localID; j < chunkSize; j += localSize) {
+        vstore_half(exp(vload_half(j, in) - m) * inv, j, out);
+    }
+}
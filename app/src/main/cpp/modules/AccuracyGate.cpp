@@ -0,0 +1,536 @@
+//
+// Created by 구현우 on 2024/07/12.
+//
+
+#include "AccuracyGate.h"
+#include "Tracer.h"
+#include "cpu/CpuBackend.h"
+#include "nn/Conv2D.h"
+#include "nn/UpSample.h"
+#include "nn/AttnBlock.h"
+#include "nn/LayerNorm.h"
+#include "nn/ResidualAttentionBlock.h"
+
+#include <android/log.h>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#define LOG_TAG "ACCURACY_GATE"
+
+#define MEDIA_PATH "/sdcard/Android/media/com.example.myopencl/"
+
+#define MODEL_CHANNELS 320
+#define TIME_EMBED_DIM (4 * MODEL_CHANNELS)
+#define CONTEXT_DIM 1024
+#define NUM_HEAD_CHANNELS 64
+#define EMBEDDING_SIZE 1024
+#define NUM_HEADS 16
+/* golden 은 512x512 image (64x64 latent) */
+#define LATENT_SIZE 64
+
+#define CHECK_ERROR_THROW(err) \
+    if (err != CL_SUCCESS) { \
+      __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "[%s:%d] OpenCL error %d\n", __FILE__, __LINE__, err); \
+      throw std::runtime_error("OpenCL error."); \
+    }
+
+/* JSON 에는 nan, inf 가 없으므로 null */
+static void writeNumber(std::ostringstream &oss, double value) {
+    if (std::isfinite(value)) {
+        oss << value;
+    } else {
+        oss << "null";
+    }
+}
+
+AccuracyGate::AccuracyGate(cl_context context, cl_command_queue cmdQueue, cl_device_id deviceId,
+                           AAssetManager *assetManager, float atol, float rtol)
+        : context(context), cmdQueue(cmdQueue), deviceId(deviceId), assetManager(assetManager),
+          atol(atol), rtol(rtol) {
+    layerNormKernel = std::make_shared<LayerNormKernel>(context, deviceId, assetManager);
+    linearKernel = std::make_shared<LinearKernel>(context, deviceId, assetManager);
+    utilKernel = std::make_shared<UtilKernel>(context, deviceId, assetManager);
+    convKernel = std::make_shared<ConvKernel>(context, deviceId, assetManager);
+    crossAttentionKernel = std::make_shared<CrossAttentionKernel>(context, deviceId, assetManager);
+    gegluKernel = std::make_shared<GEGLUKernel>(context, deviceId, assetManager);
+    groupNormKernel = std::make_shared<GroupNormKernel>(context, deviceId, assetManager);
+    upSampleKernel = std::make_shared<UpSampleKernel>(context, deviceId, assetManager);
+    multiHeadAttentionKernel = std::make_shared<MultiHeadAttentionKernel>(context, deviceId,
+                                                                          assetManager);
+}
+
+AccuracyGate::~AccuracyGate() = default;
+
+std::string AccuracyGate::run() {
+    Tracer::Scope scope("accuracy_gate");
+    results.clear();
+
+    checkTextEncoder();
+    checkUNet();
+    checkDecoder();
+
+    auto json = toJson();
+    mkdir(MEDIA_PATH "accuracy", 0777);
+    std::ofstream file(MEDIA_PATH "accuracy/accuracy_gate.json", std::ios::trunc);
+    if (file.is_open()) {
+        file << json;
+    } else {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to open %s",
+                            MEDIA_PATH "accuracy/accuracy_gate.json");
+    }
+
+    size_t failed = 0;
+    for (auto &result: results) {
+        failed += result.accuracy.passed ? 0 : 1;
+    }
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "run: %ld / %ld passed",
+                        results.size() - failed, results.size());
+    return json;
+}
+
+/*
+ * `input_name` 을 읽어 `forward` 를 실행하고 `golden_name` 과 비교.
+ * output buffer 크기는 golden 의 크기. 파일이 없거나 OpenCL error 가 나면 error 로 기록하고 다음 case 진행.
+ */
+void AccuracyGate::check(const std::string &name, const std::string &input_name,
+                         const std::string &golden_name, const Forward &forward) {
+    Tracer::Scope scope(name);
+    Result result{name, golden_name, {0, 0, 0, 0, 0, false}, 0, ""};
+    cl_mem bufferInput = nullptr, bufferOutput = nullptr;
+    try {
+        cl_int err;
+        auto golden = util::load_npy_file(golden_name);
+        bufferInput = util::load_npy_file(input_name, nullptr, context, cmdQueue);
+        bufferOutput = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                      sizeof(float) * golden.num_vals,
+                                      nullptr, &err);
+        CHECK_ERROR_THROW(err);
+        /* load_npy_file 의 unmap 이 끝난 후 실행 (out of order queue) */
+        clFinish(cmdQueue);
+
+        cl_event event;
+        auto start = std::chrono::steady_clock::now();
+        err = forward(bufferInput, bufferOutput, &event);
+        CHECK_ERROR_THROW(err);
+        err = clWaitForEvents(1, &event);
+        auto end = std::chrono::steady_clock::now();
+        clReleaseEvent(event);
+        CHECK_ERROR_THROW(err);
+        result.time = std::chrono::duration_cast<std::chrono::microseconds>(
+                end - start).count() / 1000.0;
+
+        std::vector<float> output(golden.num_vals);
+        err = clEnqueueReadBuffer(cmdQueue, bufferOutput, CL_TRUE, 0,
+                                  sizeof(float) * output.size(), output.data(),
+                                  0, nullptr, nullptr);
+        CHECK_ERROR_THROW(err);
+
+        result.accuracy = util::compare(output, golden.data<float>(), golden.num_vals, atol, rtol);
+    } catch (const std::exception &e) {
+        result.error = e.what();
+    }
+    clFinish(cmdQueue);
+    if (bufferInput != nullptr) clReleaseMemObject(bufferInput);
+    if (bufferOutput != nullptr) clReleaseMemObject(bufferOutput);
+
+    if (result.error.empty()) {
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG,
+                            "%s: %s / max abs diff: %.8f / max rel diff: %.8f / psnr: %.3f / mismatches: %ld",
+                            name.c_str(), result.accuracy.passed ? "PASS" : "FAIL",
+                            result.accuracy.maxAbsDiff, result.accuracy.maxRelDiff,
+                            result.accuracy.psnr, result.accuracy.mismatches);
+    } else {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "%s: ERROR %s", name.c_str(),
+                            result.error.c_str());
+    }
+    results.push_back(result);
+}
+
+/* input : positional embedding + permute 까지 적용된 token embedding (77, 1, 1024) */
+void AccuracyGate::checkTextEncoder() {
+    auto bufferAttentionMask = util::load_npy_file("encoder/attn_mask_fp32.npy", nullptr, context,
+                                                   cmdQueue);
+
+    {
+        auto prefix = std::string("encoder/resblock/0/resblock_0");
+        auto block = std::unique_ptr<ResidualAttentionBlock>(new ResidualAttentionBlock(
+                context, cmdQueue, EMBEDDING_SIZE, NUM_HEADS,
+                prefix + "_ln_1_weight_fp32.npy", prefix + "_ln_1_bias_fp32.npy",
+                prefix + "_ln_2_weight_fp32.npy", prefix + "_ln_2_bias_fp32.npy",
+                prefix + "_attn_in_proj_weight_fp32.npy", prefix + "_attn_in_proj_bias_fp32.npy",
+                prefix + "_attn_out_proj_weight_fp32.npy", prefix + "_attn_out_proj_bias_fp32.npy",
+                prefix + "_mlp_c_fc_weight_fp32.npy", prefix + "_mlp_c_fc_bias_fp32.npy",
+                prefix + "_mlp_c_proj_weight_fp32.npy", prefix + "_mlp_c_proj_bias_fp32.npy",
+                bufferAttentionMask, layerNormKernel, linearKernel, multiHeadAttentionKernel,
+                utilKernel));
+        check("text_encoder/resblocks/0",
+              "encoder/test/permute_test_fp32.npy",
+              "encoder/test/resblock_0_test_fp32.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  block->init();
+                  return block->forward(input, output, 0, nullptr, event);
+              });
+    }
+
+    {
+        /* (77, 1, 1024) -> (1, 77, 1024) permute 는 memory layout 이 같음 */
+        auto ln_final = std::unique_ptr<LayerNorm>(new LayerNorm(
+                context, cmdQueue, EMBEDDING_SIZE,
+                "encoder/ln_final_weight_fp32.npy", "encoder/ln_final_bias_fp32.npy",
+                layerNormKernel));
+        check("text_encoder/ln_final",
+              "encoder/test/resblock_22_test_fp32.npy",
+              "encoder/test/ln_final_test_fp32.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  ln_final->init();
+                  return ln_final->forward(input, output, 0, nullptr, event);
+              });
+    }
+
+    clReleaseMemObject(bufferAttentionMask);
+}
+
+/* x=seed45.npy, timestep=981, condition=ln_final_test_fp32.npy */
+void AccuracyGate::checkUNet() {
+    auto bufferEmbed = util::load_npy_file("unet/time_embed/test/test_time_embed.npy", nullptr,
+                                           context, cmdQueue);
+    auto bufferCondition = util::load_npy_file("encoder/test/ln_final_test_fp32.npy", nullptr,
+                                               context, cmdQueue);
+
+    {
+        auto conv2d = std::unique_ptr<Conv2D>(new Conv2D(
+                context, cmdQueue, 4, MODEL_CHANNELS, 3, 1, 1,
+                "unet/input_block/0/input_block_0_conv2d_weight.npy",
+                "unet/input_block/0/input_block_0_conv2d_bias.npy",
+                convKernel));
+        check("unet/input_block/0/conv2d",
+              "sampler/test/test_seed_45_img.npy",
+              "unet/input_block/test/test_input_block_0_conv2d.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  conv2d->init();
+                  return conv2d->forward(input, output, LATENT_SIZE, LATENT_SIZE, 0, nullptr,
+                                         event);
+              });
+    }
+
+    {
+        auto spatial = std::unique_ptr<SpatialTransformer>(
+                createSpatialTransformer("unet/input_block/2/input_blocks_2_1", 320, 5));
+        check("unet/input_block/2/spatial",
+              "unet/input_block/test/test_input_block_2_res.npy",
+              "unet/input_block/test/test_input_block_2.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  spatial->init();
+                  return spatial->forward(input, bufferCondition, output, 0, nullptr, event);
+              });
+    }
+
+    {
+        auto conv2d = std::unique_ptr<Conv2D>(new Conv2D(
+                context, cmdQueue, 320, 320, 3, 2, 1,
+                "unet/input_block/3/input_blocks_3_0_op_weight.npy",
+                "unet/input_block/3/input_blocks_3_0_op_bias.npy",
+                convKernel));
+        check("unet/input_block/3/conv2d",
+              "unet/input_block/test/test_input_block_2.npy",
+              "unet/input_block/test/test_input_block_3.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  conv2d->init();
+                  return conv2d->forward(input, output, LATENT_SIZE, LATENT_SIZE, 0, nullptr,
+                                         event);
+              });
+    }
+
+    {
+        auto resBlock = std::unique_ptr<ResBlock>(
+                createResBlock("unet/input_block/4/input_blocks_4_0", 320, 640, true));
+        check("unet/input_block/4/res_block",
+              "unet/input_block/test/test_input_block_3.npy",
+              "unet/input_block/test/test_input_block_4_res.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  resBlock->init();
+                  return resBlock->forward(input, bufferEmbed, output, LATENT_SIZE / 2,
+                                           LATENT_SIZE / 2, 0, nullptr, 0, nullptr, event);
+              });
+    }
+
+    {
+        auto spatial = std::unique_ptr<SpatialTransformer>(
+                createSpatialTransformer("unet/input_block/4/input_blocks_4_1", 640, 10));
+        check("unet/input_block/4/spatial",
+              "unet/input_block/test/test_input_block_4_res.npy",
+              "unet/input_block/test/test_input_block_4.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  spatial->init();
+                  return spatial->forward(input, bufferCondition, output, 0, nullptr, event);
+              });
+    }
+
+    {
+        auto resBlock = std::unique_ptr<ResBlock>(
+                createResBlock("unet/input_block/5/input_blocks_5_0", 640, 640, false));
+        auto spatial = std::unique_ptr<SpatialTransformer>(
+                createSpatialTransformer("unet/input_block/5/input_blocks_5_1", 640, 10));
+        check("unet/input_block/5",
+              "unet/input_block/test/test_input_block_4.npy",
+              "unet/input_block/test/test_input_block_5.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  cl_int err;
+                  cl_event event0;
+                  resBlock->init();
+                  spatial->init();
+                  err = resBlock->forward(input, bufferEmbed, output, LATENT_SIZE / 2,
+                                          LATENT_SIZE / 2, 0, nullptr, 0, nullptr, &event0);
+                  if (err != CL_SUCCESS) {
+                      return err;
+                  }
+                  err = spatial->forward(output, bufferCondition, output, 1, &event0, event);
+                  clReleaseEvent(event0);
+                  return err;
+              });
+    }
+
+    {
+        auto resBlock0 = std::unique_ptr<ResBlock>(
+                createResBlock("unet/middle_block/0/middle_block_0", 1280, 1280, false));
+        auto spatial = std::unique_ptr<SpatialTransformer>(
+                createSpatialTransformer("unet/middle_block/1/middle_block_1", 1280, 20));
+        auto resBlock2 = std::unique_ptr<ResBlock>(
+                createResBlock("unet/middle_block/2/middle_block_2", 1280, 1280, false));
+        check("unet/middle_block",
+              "unet/input_block/test/test_input_block_11.npy",
+              "unet/middle_block/test/test_middle_block.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  cl_int err;
+                  cl_event event0, event1;
+                  resBlock0->init();
+                  spatial->init();
+                  resBlock2->init();
+                  err = resBlock0->forward(input, bufferEmbed, output, LATENT_SIZE / 8,
+                                           LATENT_SIZE / 8, 0, nullptr, 0, nullptr, &event0);
+                  if (err != CL_SUCCESS) {
+                      return err;
+                  }
+                  err = spatial->forward(output, bufferCondition, output, 1, &event0, &event1);
+                  clReleaseEvent(event0);
+                  if (err != CL_SUCCESS) {
+                      return err;
+                  }
+                  err = resBlock2->forward(output, bufferEmbed, output, LATENT_SIZE / 8,
+                                           LATENT_SIZE / 8, 0, nullptr, 1, &event1, event);
+                  clReleaseEvent(event1);
+                  return err;
+              });
+    }
+
+    clReleaseMemObject(bufferEmbed);
+    clReleaseMemObject(bufferCondition);
+}
+
+/* x=test_seed_45_step_50_sample.npy */
+void AccuracyGate::checkDecoder() {
+    {
+        auto resBlock = std::unique_ptr<ResBlock>(
+                createDecoderResBlock("decoder/mid/decoder_mid_block_1", 512));
+        check("decoder/mid/res_block/1",
+              "decoder/test/test_conv_in.npy",
+              "decoder/test/test_mid_block_1.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  resBlock->init();
+                  return resBlock->forward(input, nullptr, output, LATENT_SIZE, LATENT_SIZE,
+                                           0, nullptr, 0, nullptr, event);
+              });
+    }
+
+    {
+        auto prefix = std::string("decoder/mid/decoder_mid_attn_1");
+        auto attnBlock = std::unique_ptr<AttnBlock>(new AttnBlock(
+                context, cmdQueue, deviceId, assetManager, 512,
+                prefix + "_norm_weight.npy", prefix + "_norm_bias.npy",
+                prefix + "_q_weight.npy", prefix + "_q_bias.npy",
+                prefix + "_k_weight.npy", prefix + "_k_bias.npy",
+                prefix + "_v_weight.npy", prefix + "_v_bias.npy",
+                prefix + "_proj_out_weight.npy", prefix + "_proj_out_bias.npy",
+                convKernel, utilKernel, groupNormKernel));
+        check("decoder/mid/attn_block",
+              "decoder/test/test_mid_block_1.npy",
+              "decoder/test/test_mid_attn_1.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  attnBlock->init();
+                  return attnBlock->forward(input, output, LATENT_SIZE, LATENT_SIZE, 0, nullptr,
+                                            event);
+              });
+    }
+
+    {
+        auto resBlock = std::unique_ptr<ResBlock>(
+                createDecoderResBlock("decoder/mid/decoder_mid_block_2", 512));
+        check("decoder/mid/res_block/2",
+              "decoder/test/test_mid_attn_1.npy",
+              "decoder/test/test_mid_block_2.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  resBlock->init();
+                  return resBlock->forward(input, nullptr, output, LATENT_SIZE, LATENT_SIZE,
+                                           0, nullptr, 0, nullptr, event);
+              });
+    }
+
+    {
+        std::vector<std::unique_ptr<ResBlock>> resBlocks;
+        for (int i = 0; i < 3; i++) {
+            resBlocks.emplace_back(
+                    createDecoderResBlock("decoder/up/3/decoder_up_3_block_" + std::to_string(i),
+                                          512));
+        }
+        auto upSample = std::unique_ptr<UpSample>(new UpSample(
+                context, cmdQueue, 512, 512, 3, 1, 1,
+                "decoder/up/3/decoder_up_3_upsample_conv_weight.npy",
+                "decoder/up/3/decoder_up_3_upsample_conv_bias.npy",
+                convKernel, upSampleKernel));
+        check("decoder/up/3",
+              "decoder/test/test_mid_block_2.npy",
+              "decoder/test/test_up_3.npy",
+              [&](cl_mem input, cl_mem output, cl_event *event) {
+                  cl_int err;
+                  cl_event events[3];
+                  for (int i = 0; i < resBlocks.size(); i++) {
+                      resBlocks[i]->init();
+                      /* input 에 in-place */
+                      err = resBlocks[i]->forward(input, nullptr, input, LATENT_SIZE,
+                                                  LATENT_SIZE, 0, nullptr, i > 0 ? 1 : 0, i > 0 ? &events[i - 1] : nullptr,
+                                                  &events[i]);
+                      if (err != CL_SUCCESS) {
+                          for (int j = 0; j < i; j++) clReleaseEvent(events[j]);
+                          return err;
+                      }
+                  }
+                  upSample->init();
+                  err = upSample->forward(input, output, LATENT_SIZE, LATENT_SIZE, 1, &events[2],
+                                          event);
+                  for (auto &e: events) {
+                      clReleaseEvent(e);
+                  }
+                  return err;
+              });
+    }
+}
+
+ResBlock *AccuracyGate::createResBlock(const std::string &prefix, size_t in_channels,
+                                       size_t out_channels, bool skip) {
+    return new ResBlock(context, cmdQueue,
+                        in_channels, TIME_EMBED_DIM, out_channels,
+                        prefix + "_in_layers_0_weight.npy",
+                        prefix + "_in_layers_0_bias.npy",
+                        prefix + "_in_layers_2_weight.npy",
+                        prefix + "_in_layers_2_bias.npy",
+                        prefix + "_emb_layers_1_weight.npy",
+                        prefix + "_emb_layers_1_bias.npy",
+                        prefix + "_out_layers_0_weight.npy",
+                        prefix + "_out_layers_0_bias.npy",
+                        prefix + "_out_layers_3_weight.npy",
+                        prefix + "_out_layers_3_bias.npy",
+                        skip ? prefix + "_skip_connection_weight.npy" : "",
+                        skip ? prefix + "_skip_connection_bias.npy" : "",
+                        linearKernel, convKernel, groupNormKernel, utilKernel);
+}
+
+SpatialTransformer *AccuracyGate::createSpatialTransformer(const std::string &prefix,
+                                                           size_t channels, size_t numHeads) {
+    auto block = prefix + "_transformer_blocks_0";
+    return new SpatialTransformer(context, cmdQueue,
+                                  channels, CONTEXT_DIM, numHeads, NUM_HEAD_CHANNELS,
+                                  prefix + "_norm_weight.npy",
+                                  prefix + "_norm_bias.npy",
+                                  prefix + "_proj_in_weight.npy",
+                                  prefix + "_proj_in_bias.npy",
+                                  block + "_norm1_weight.npy",
+                                  block + "_norm1_bias.npy",
+                                  block + "_norm2_weight.npy",
+                                  block + "_norm2_bias.npy",
+                                  block + "_norm3_weight.npy",
+                                  block + "_norm3_bias.npy",
+                                  block + "_attn1_to_q_weight.npy",
+                                  block + "_attn1_to_k_weight.npy",
+                                  block + "_attn1_to_v_weight.npy",
+                                  block + "_attn1_to_out_0_weight.npy",
+                                  block + "_attn1_to_out_0_bias.npy",
+                                  block + "_attn2_to_q_weight.npy",
+                                  block + "_attn2_to_k_weight.npy",
+                                  block + "_attn2_to_v_weight.npy",
+                                  block + "_attn2_to_out_0_weight.npy",
+                                  block + "_attn2_to_out_0_bias.npy",
+                                  block + "_ff_net_0_proj_weight.npy",
+                                  block + "_ff_net_0_proj_bias.npy",
+                                  block + "_ff_net_2_weight.npy",
+                                  block + "_ff_net_2_bias.npy",
+                                  prefix + "_proj_out_weight.npy",
+                                  prefix + "_proj_out_bias.npy",
+                                  layerNormKernel, linearKernel, utilKernel, crossAttentionKernel,
+                                  gegluKernel, groupNormKernel);
+}
+
+ResBlock *AccuracyGate::createDecoderResBlock(const std::string &prefix, size_t channels) {
+    return new ResBlock(context, cmdQueue,
+                        channels, 0, channels,
+                        prefix + "_norm1_weight.npy",
+                        prefix + "_norm1_bias.npy",
+                        prefix + "_conv1_weight.npy",
+                        prefix + "_conv1_bias.npy",
+                        "", "",
+                        prefix + "_norm2_weight.npy",
+                        prefix + "_norm2_bias.npy",
+                        prefix + "_conv2_weight.npy",
+                        prefix + "_conv2_bias.npy",
+                        "", "",
+                        linearKernel, convKernel, groupNormKernel, utilKernel);
+}
+
+/* psnr 이 inf (완전히 같음) 이거나 nan 이 나오면 null */
+std::string AccuracyGate::toJson() {
+    char deviceName[256] = {0};
+    cl_device_type deviceType = 0;
+    clGetDeviceInfo(deviceId, CL_DEVICE_NAME, sizeof(deviceName) - 1, deviceName, nullptr);
+    clGetDeviceInfo(deviceId, CL_DEVICE_TYPE, sizeof(cl_device_type), &deviceType, nullptr);
+
+    bool passed = !results.empty();
+    for (auto &result: results) {
+        passed &= result.accuracy.passed;
+    }
+
+    std::ostringstream oss;
+    oss << "{\n";
+    oss << "  \"device\": \"" << deviceName << "\",\n";
+    oss << "  \"device_type\": \"" << (deviceType & CL_DEVICE_TYPE_CPU ? "cpu" : "gpu") << "\",\n";
+    oss << "  \"backend\": \"" << (CpuBackend::isEnabled() ? "cpu" : "opencl") << "\",\n";
+    oss << "  \"atol\": " << atol << ",\n";
+    oss << "  \"rtol\": " << rtol << ",\n";
+    oss << "  \"passed\": " << (passed ? "true" : "false") << ",\n";
+    oss << "  \"results\": [\n";
+    for (int i = 0; i < results.size(); i++) {
+        auto &result = results[i];
+        auto &accuracy = result.accuracy;
+        oss << "    {\"name\": \"" << result.name << "\", \"golden\": \"" << result.golden
+            << "\", ";
+        if (!result.error.empty()) {
+            oss << "\"passed\": false, \"error\": \"" << result.error << "\"";
+        } else {
+            oss << "\"passed\": " << (accuracy.passed ? "true" : "false")
+                << ", \"max_abs_diff\": ";
+            writeNumber(oss, accuracy.maxAbsDiff);
+            oss << ", \"max_rel_diff\": ";
+            writeNumber(oss, accuracy.maxRelDiff);
+            oss << ", \"psnr\": ";
+            writeNumber(oss, accuracy.psnr);
+            oss << ", \"mismatches\": " << accuracy.mismatches
+                << ", \"size\": " << accuracy.size
+                << ", \"time_ms\": " << result.time;
+        }
+        oss << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    oss << "  ]\n";
+    oss << "}\n";
+    return oss.str();
+}
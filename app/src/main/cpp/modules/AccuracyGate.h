@@ -0,0 +1,104 @@
+//
+// Created by 구현우 on 2024/07/12.
+//
+
+#ifndef MY_OPENCL_ACCURACYGATE_H
+#define MY_OPENCL_ACCURACYGATE_H
+
+#define CL_TARGET_OPENCL_VERSION 200
+
+#include "CL/opencl.h"
+
+#include <android/asset_manager_jni.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "util.h"
+#include "nn/ResBlock.h"
+#include "nn/SpatialTransformer.h"
+#include "kernel/unit/LayerNormKernel.h"
+#include "kernel/unit/LinearKernel.h"
+#include "kernel/unit/UtilKernel.h"
+#include "kernel/unit/ConvKernel.h"
+#include "kernel/unit/CrossAttentionKernel.h"
+#include "kernel/unit/GEGLUKernel.h"
+#include "kernel/unit/GroupNormKernel.h"
+#include "kernel/unit/UpSampleKernel.h"
+#include "kernel/unit/MultiHeadAttentionKernel.h"
+
+/*
+ * layer (block) 단위 golden tensor 비교.
+ * 기록된 input (.npy) 으로 layer 를 실행하고 golden output (.npy) 과
+ * max abs / rel diff, PSNR 를 비교 (|result - golden| <= atol + rtol * |golden|).
+ * kernel version (fp16, fusion 등) 을 바꾸면 이 gate 를 통과해야 함.
+ *
+ * result : MEDIA_PATH/accuracy/accuracy_gate.json
+ */
+class AccuracyGate {
+public:
+    AccuracyGate(cl_context context, cl_command_queue cmdQueue, cl_device_id deviceId,
+                 AAssetManager *assetManager, float atol, float rtol);
+
+    ~AccuracyGate();
+
+    /* @return: JSON */
+    std::string run();
+
+private:
+    typedef std::function<cl_int(cl_mem input, cl_mem output, cl_event *event)> Forward;
+
+    struct Result {
+        std::string name;
+        std::string golden;
+        util::Accuracy accuracy;
+        double time;
+        std::string error;
+    };
+
+    void check(const std::string &name, const std::string &input_name,
+               const std::string &golden_name, const Forward &forward);
+
+    void checkTextEncoder();
+
+    void checkUNet();
+
+    void checkDecoder();
+
+    /* unet/<...>/<prefix>_in_layers_0_weight.npy, ... */
+    ResBlock *createResBlock(const std::string &prefix, size_t in_channels,
+                             size_t out_channels, bool skip);
+
+    /* unet/<...>/<prefix>_norm_weight.npy, ... */
+    SpatialTransformer *createSpatialTransformer(const std::string &prefix, size_t channels,
+                                                 size_t numHeads);
+
+    /* decoder/<...>/<prefix>_norm1_weight.npy, ... */
+    ResBlock *createDecoderResBlock(const std::string &prefix, size_t channels);
+
+    std::string toJson();
+
+    cl_context context;
+    cl_command_queue cmdQueue;
+    cl_device_id deviceId;
+    AAssetManager *assetManager;
+
+    float atol;
+    float rtol;
+
+    std::shared_ptr<LayerNormKernel> layerNormKernel;
+    std::shared_ptr<LinearKernel> linearKernel;
+    std::shared_ptr<UtilKernel> utilKernel;
+    std::shared_ptr<ConvKernel> convKernel;
+    std::shared_ptr<CrossAttentionKernel> crossAttentionKernel;
+    std::shared_ptr<GEGLUKernel> gegluKernel;
+    std::shared_ptr<GroupNormKernel> groupNormKernel;
+    std::shared_ptr<UpSampleKernel> upSampleKernel;
+    std::shared_ptr<MultiHeadAttentionKernel> multiHeadAttentionKernel;
+
+    std::vector<Result> results;
+};
+
+
+#endif //MY_OPENCL_ACCURACYGATE_H
@@ -0,0 +1,70 @@
+//
+// Created by 구현우 on 2024/07/16.
+//
+
+#ifndef MY_OPENCL_BOUNDEDQUEUE_H
+#define MY_OPENCL_BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/*
+ * stage 사이의 blocking queue. capacity 가 0 이면 unbounded.
+ * close 이후 push 는 false, pop 은 남은 item 을 모두 꺼낸 후 false.
+ */
+template<typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+    /* 가득 차 있으면 대기 */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] {
+            return closed || capacity == 0 || items.size() < capacity;
+        });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /* 비어 있으면 대기 */
+    bool pop(T *item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) {
+            return false;
+        }
+        *item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size();
+    }
+
+private:
+    const size_t capacity;
+    std::deque<T> items;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+};
+
+
+#endif //MY_OPENCL_BOUNDEDQUEUE_H
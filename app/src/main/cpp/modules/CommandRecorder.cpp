@@ -0,0 +1,634 @@
+//
+// Created by 구현우 on 2024/07/22.
+//
+
+#include "CommandRecorder.h"
+
+#include <algorithm>
+#include <android/log.h>
+#include <cstring>
+#include <string>
+
+#include "Tracer.h"
+
+#define LOG_TAG "COMMAND_RECORDER"
+
+#define CHECK_ERROR(err) \
+    if (err != CL_SUCCESS) { \
+      __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "[%s:%d] OpenCL error %d\n", __FILE__, __LINE__, err); \
+      return err;                     \
+    }                    \
+
+static thread_local CommandRecorder *recording = nullptr;
+
+cl_mem record::clCreateBuffer(cl_context context, cl_mem_flags flags, size_t size, void *host_ptr,
+                              cl_int *errcode_ret) {
+    auto recorder = CommandRecorder::current();
+    if (recorder != nullptr) {
+        return recorder->createBuffer(context, flags, size, host_ptr, errcode_ret);
+    }
+    return ::clCreateBuffer(context, flags, size, host_ptr, errcode_ret);
+}
+
+cl_int record::clReleaseMemObject(cl_mem memobj) {
+    auto recorder = CommandRecorder::current();
+    if (recorder != nullptr) {
+        return recorder->releaseBuffer(memobj);
+    }
+    return ::clReleaseMemObject(memobj);
+}
+
+cl_int record::clSetKernelArg(cl_kernel kernel, cl_uint arg_index, size_t arg_size,
+                              const void *arg_value) {
+    auto err = ::clSetKernelArg(kernel, arg_index, arg_size, arg_value);
+    auto recorder = CommandRecorder::current();
+    if (recorder != nullptr && err == CL_SUCCESS) {
+        recorder->setArg(kernel, arg_index, arg_size, arg_value);
+    }
+    return err;
+}
+
+cl_int record::clEnqueueNDRangeKernel(cl_command_queue command_queue, cl_kernel kernel,
+                                      cl_uint work_dim, const size_t *global_work_offset,
+                                      const size_t *global_work_size,
+                                      const size_t *local_work_size,
+                                      cl_uint num_events_in_wait_list,
+                                      const cl_event *event_wait_list, cl_event *event) {
+    auto recorder = CommandRecorder::current();
+    if (recorder != nullptr) {
+        return recorder->enqueueKernel(command_queue, kernel, work_dim, global_work_offset,
+                                       global_work_size, local_work_size,
+                                       num_events_in_wait_list, event_wait_list, event);
+    }
+    return ::clEnqueueNDRangeKernel(command_queue, kernel, work_dim, global_work_offset,
+                                    global_work_size, local_work_size, num_events_in_wait_list,
+                                    event_wait_list, event);
+}
+
+cl_int record::clEnqueueCopyBuffer(cl_command_queue command_queue, cl_mem src_buffer,
+                                   cl_mem dst_buffer, size_t src_offset, size_t dst_offset,
+                                   size_t size, cl_uint num_events_in_wait_list,
+                                   const cl_event *event_wait_list, cl_event *event) {
+    auto recorder = CommandRecorder::current();
+    if (recorder != nullptr) {
+        return recorder->enqueueCopy(command_queue, src_buffer, dst_buffer, src_offset,
+                                     dst_offset, size, num_events_in_wait_list, event_wait_list,
+                                     event);
+    }
+    return ::clEnqueueCopyBuffer(command_queue, src_buffer, dst_buffer, src_offset, dst_offset,
+                                 size, num_events_in_wait_list, event_wait_list, event);
+}
+
+cl_int record::clEnqueueMarkerWithWaitList(cl_command_queue command_queue,
+                                           cl_uint num_events_in_wait_list,
+                                           const cl_event *event_wait_list, cl_event *event) {
+    auto recorder = CommandRecorder::current();
+    if (recorder != nullptr) {
+        return recorder->enqueueMarker(command_queue, num_events_in_wait_list, event_wait_list,
+                                       event);
+    }
+    return ::clEnqueueMarkerWithWaitList(command_queue, num_events_in_wait_list, event_wait_list,
+                                         event);
+}
+
+CommandRecorder::CommandRecorder(cl_context context, cl_command_queue cmdQueue,
+                                 cl_device_id deviceId, bool useCommandBuffer)
+        : context(context), cmdQueue(cmdQueue), deviceId(deviceId),
+          useCommandBuffer(useCommandBuffer) {
+    cl_command_queue_properties properties = 0;
+    clGetCommandQueueInfo(cmdQueue, CL_QUEUE_PROPERTIES, sizeof(properties), &properties,
+                          nullptr);
+    inOrder = (properties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) == 0;
+}
+
+CommandRecorder::~CommandRecorder() {
+    if (recording == this) {
+        recording = nullptr;
+    }
+    if (commandBuffer != nullptr) {
+        releaseCommandBuffer(commandBuffer);
+    }
+    for (auto &command: commands) {
+        if (command.kernel != nullptr) {
+            clReleaseKernel(command.kernel);
+        }
+    }
+    for (auto &buffer: buffers) {
+        ::clReleaseMemObject(buffer.buffer);
+    }
+    for (auto event: events) {
+        clReleaseEvent(event);
+    }
+    for (auto event: inputEvents) {
+        if (event != nullptr) {
+            clReleaseEvent(event);
+        }
+    }
+}
+
+CommandRecorder *CommandRecorder::current() {
+    return recording;
+}
+
+void CommandRecorder::begin(const std::vector<cl_event> &inputs) {
+    if (recording != nullptr || !commands.empty()) {
+        throw std::runtime_error("CommandRecorder: already recorded");
+    }
+    for (auto event: inputs) {
+        if (event != nullptr) {
+            clRetainEvent(event);
+        }
+    }
+    inputEvents = inputs;
+    valid = true;
+    recording = this;
+}
+
+bool CommandRecorder::end() {
+    recording = nullptr;
+    if (valid) {
+        compile();
+        if (useCommandBuffer && !buildCommandBuffer()) {
+            __android_log_print(ANDROID_LOG_INFO, LOG_TAG,
+                                "cl_khr_command_buffer not available, replay launch list");
+        }
+    }
+    ready = valid;
+
+    for (auto event: events) {
+        clReleaseEvent(event);
+    }
+    events.clear();
+    eventIndex.clear();
+    args.clear();
+
+    size_t bytes = 0;
+    for (auto &buffer: buffers) {
+        bytes += buffer.bytes;
+    }
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG,
+                        "end: ready(%d) commands(%ld) buffers(%ld, %ld bytes) command_buffer(%d)",
+                        ready, commands.size(), buffers.size(), bytes, commandBuffer != nullptr);
+    return ready;
+}
+
+bool CommandRecorder::isReady() const {
+    return ready;
+}
+
+bool CommandRecorder::isCommandBuffer() const {
+    return commandBuffer != nullptr;
+}
+
+size_t CommandRecorder::size() const {
+    return commands.size();
+}
+
+cl_mem CommandRecorder::createBuffer(cl_context _context, cl_mem_flags flags, size_t size,
+                                     void *host_ptr, cl_int *errcode_ret) {
+    if (host_ptr == nullptr) {
+        for (auto &buffer: buffers) {
+            if (buffer.free && buffer.flags == flags && buffer.bytes == size) {
+                buffer.free = false;
+                /* users 는 이미 previous 이후에 실행 */
+                if (!buffer.users.empty()) {
+                    buffer.previous = std::move(buffer.users);
+                    buffer.users.clear();
+                }
+                if (errcode_ret != nullptr) {
+                    *errcode_ret = CL_SUCCESS;
+                }
+                return buffer.buffer;
+            }
+        }
+    }
+
+    auto mem = ::clCreateBuffer(_context, flags, size, host_ptr, errcode_ret);
+    if (mem != nullptr) {
+        bufferIndex[mem] = buffers.size();
+        buffers.push_back({mem, flags, size, false, {}, {}});
+    }
+    return mem;
+}
+
+cl_int CommandRecorder::releaseBuffer(cl_mem buffer) {
+    auto it = bufferIndex.find(buffer);
+    if (it == bufferIndex.end()) {
+        return ::clReleaseMemObject(buffer);
+    }
+    buffers[it->second].free = true;
+    return CL_SUCCESS;
+}
+
+void CommandRecorder::setArg(cl_kernel kernel, cl_uint index, size_t size, const void *value) {
+    auto &arg = args[kernel][index];
+    arg.size = size;
+    if (value == nullptr) {
+        arg.value.clear();
+    } else {
+        auto bytes = static_cast<const unsigned char *>(value);
+        arg.value.assign(bytes, bytes + size);
+    }
+}
+
+void CommandRecorder::use(cl_mem buffer, std::vector<cl_event> &waitList) {
+    auto it = bufferIndex.find(buffer);
+    if (it == bufferIndex.end()) {
+        return;
+    }
+    auto &state = buffers[it->second];
+    for (auto previous: state.previous) {
+        waitList.push_back(events[previous]);
+    }
+    state.users.push_back(commands.size());
+}
+
+void CommandRecorder::addCommand(Command command, const std::vector<cl_event> &waitList,
+                                 cl_event recorded, cl_event *event) {
+    for (auto wait: waitList) {
+        auto it = eventIndex.find(wait);
+        if (it != eventIndex.end()) {
+            command.deps.push_back(it->second);
+            continue;
+        }
+        auto input = std::find(inputEvents.begin(), inputEvents.end(), wait);
+        if (wait != nullptr && input != inputEvents.end()) {
+            command.inputs.push_back(input - inputEvents.begin());
+            continue;
+        }
+        if (valid) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                                "command(%ld) waits for event not recorded", commands.size());
+        }
+        valid = false;
+    }
+
+    eventIndex[recorded] = commands.size();
+    events.push_back(recorded);
+    commands.push_back(std::move(command));
+
+    /* 기록용으로 하나는 recorder 가 가짐 */
+    if (event != nullptr) {
+        clRetainEvent(recorded);
+        *event = recorded;
+    }
+}
+
+cl_kernel CommandRecorder::cloneKernel(cl_kernel kernel) {
+    cl_int err;
+    cl_uint numArgs;
+    cl_program program;
+    size_t nameSize;
+    err = clGetKernelInfo(kernel, CL_KERNEL_NUM_ARGS, sizeof(cl_uint), &numArgs, nullptr);
+    err |= clGetKernelInfo(kernel, CL_KERNEL_PROGRAM, sizeof(cl_program), &program, nullptr);
+    err |= clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME, 0, nullptr, &nameSize);
+    if (err != CL_SUCCESS) {
+        return nullptr;
+    }
+    std::string name(nameSize, '\0');
+    err = clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME, nameSize, &name[0], nullptr);
+    if (err != CL_SUCCESS) {
+        return nullptr;
+    }
+
+    /* 기록 전에 set 한 argument 는 값을 알 수 없음 */
+    auto &kernelArgs = args[kernel];
+    for (cl_uint i = 0; i < numArgs; i++) {
+        if (kernelArgs.find(i) == kernelArgs.end()) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "%s: arg(%d) is set before begin",
+                                name.c_str(), i);
+            return nullptr;
+        }
+    }
+
+    auto clone = clCreateKernel(program, name.c_str(), &err);
+    if (err != CL_SUCCESS) {
+        return nullptr;
+    }
+    for (auto &arg: kernelArgs) {
+        err = ::clSetKernelArg(clone, arg.first, arg.second.size,
+                               arg.second.value.empty() ? nullptr : arg.second.value.data());
+        if (err != CL_SUCCESS) {
+            clReleaseKernel(clone);
+            return nullptr;
+        }
+    }
+    return clone;
+}
+
+cl_int CommandRecorder::enqueueKernel(cl_command_queue queue, cl_kernel kernel, cl_uint workDim,
+                                      const size_t *offset, const size_t *global,
+                                      const size_t *local, cl_uint num_events_in_list,
+                                      const cl_event *event_wait_list, cl_event *event) {
+    cl_int err;
+    std::vector<cl_event> waitList(event_wait_list, event_wait_list + num_events_in_list);
+
+    /* mem object 인지는 알 수 없으므로 값이 기록 중인 buffer 와 같은 argument 를 사용으로 봄 */
+    for (auto &arg: args[kernel]) {
+        if (arg.second.value.size() == sizeof(cl_mem)) {
+            cl_mem buffer;
+            memcpy(&buffer, arg.second.value.data(), sizeof(cl_mem));
+            use(buffer, waitList);
+        }
+    }
+    std::sort(waitList.begin(), waitList.end());
+    waitList.erase(std::unique(waitList.begin(), waitList.end()), waitList.end());
+
+    cl_event recorded;
+    err = ::clEnqueueNDRangeKernel(queue, kernel, workDim, offset, global, local,
+                                   waitList.size(), waitList.empty() ? nullptr : waitList.data(),
+                                   &recorded);
+    if (err != CL_SUCCESS) {
+        valid = false;
+        return err;
+    }
+
+    Command command{};
+    command.type = KERNEL;
+    command.workDim = workDim;
+    for (cl_uint i = 0; i < workDim && i < 3; i++) {
+        command.offset[i] = offset != nullptr ? offset[i] : 0;
+        command.global[i] = global[i];
+        command.local[i] = local != nullptr ? local[i] : 0;
+    }
+    command.hasOffset = offset != nullptr;
+    command.hasLocal = local != nullptr;
+    if (valid) {
+        command.kernel = cloneKernel(kernel);
+        valid = command.kernel != nullptr;
+    }
+    addCommand(std::move(command), waitList, recorded, event);
+    return CL_SUCCESS;
+}
+
+cl_int CommandRecorder::enqueueCopy(cl_command_queue queue, cl_mem src, cl_mem dst,
+                                    size_t srcOffset, size_t dstOffset, size_t size,
+                                    cl_uint num_events_in_list, const cl_event *event_wait_list,
+                                    cl_event *event) {
+    cl_int err;
+    std::vector<cl_event> waitList(event_wait_list, event_wait_list + num_events_in_list);
+    use(src, waitList);
+    if (dst != src) {
+        use(dst, waitList);
+    }
+    std::sort(waitList.begin(), waitList.end());
+    waitList.erase(std::unique(waitList.begin(), waitList.end()), waitList.end());
+
+    cl_event recorded;
+    err = ::clEnqueueCopyBuffer(queue, src, dst, srcOffset, dstOffset, size, waitList.size(),
+                                waitList.empty() ? nullptr : waitList.data(), &recorded);
+    if (err != CL_SUCCESS) {
+        valid = false;
+        return err;
+    }
+
+    Command command{};
+    command.type = COPY;
+    command.src = src;
+    command.dst = dst;
+    command.srcOffset = srcOffset;
+    command.dstOffset = dstOffset;
+    command.size = size;
+    addCommand(std::move(command), waitList, recorded, event);
+    return CL_SUCCESS;
+}
+
+cl_int CommandRecorder::enqueueMarker(cl_command_queue queue, cl_uint num_events_in_list,
+                                      const cl_event *event_wait_list, cl_event *event) {
+    cl_int err;
+    std::vector<cl_event> waitList(event_wait_list, event_wait_list + num_events_in_list);
+
+    cl_event recorded;
+    err = ::clEnqueueMarkerWithWaitList(queue, num_events_in_list, event_wait_list, &recorded);
+    if (err != CL_SUCCESS) {
+        valid = false;
+        return err;
+    }
+
+    Command command{};
+    command.type = MARKER;
+    addCommand(std::move(command), waitList, recorded, event);
+    return CL_SUCCESS;
+}
+
+void CommandRecorder::compile() {
+    /* marker 는 자신의 dependency 를 넘겨주고 제거 */
+    std::vector<long> index(commands.size(), -1);
+    std::vector<std::vector<size_t>> markerDeps(commands.size());
+    std::vector<std::vector<size_t>> markerInputs(commands.size());
+    std::vector<Command> list;
+
+    for (size_t i = 0; i < commands.size(); i++) {
+        auto &command = commands[i];
+        std::vector<size_t> deps;
+        std::vector<size_t> inputs(command.inputs);
+        for (auto dep: command.deps) {
+            if (commands[dep].type == MARKER) {
+                deps.insert(deps.end(), markerDeps[dep].begin(), markerDeps[dep].end());
+                inputs.insert(inputs.end(), markerInputs[dep].begin(), markerInputs[dep].end());
+            } else {
+                deps.push_back(index[dep]);
+            }
+        }
+        std::sort(deps.begin(), deps.end());
+        deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+        std::sort(inputs.begin(), inputs.end());
+        inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+
+        if (command.type == MARKER) {
+            markerDeps[i] = std::move(deps);
+            markerInputs[i] = std::move(inputs);
+            continue;
+        }
+        command.deps = std::move(deps);
+        command.inputs = std::move(inputs);
+        index[i] = static_cast<long>(list.size());
+        list.push_back(std::move(command));
+    }
+    commands = std::move(list);
+
+    /* in-order queue 는 queue 순서로 충분하므로 list replay 에서 event 가 필요 없음 */
+    std::vector<bool> dependent(commands.size(), false);
+    for (auto &command: commands) {
+        for (auto dep: command.deps) {
+            dependent[dep] = true;
+        }
+    }
+    sinks.clear();
+    for (size_t i = 0; i < commands.size(); i++) {
+        commands[i].needed = !inOrder;
+        if (!inOrder && !dependent[i]) {
+            sinks.push_back(i);
+        }
+    }
+}
+
+bool CommandRecorder::buildCommandBuffer() {
+    cl_int err;
+    size_t extensionSize;
+    err = clGetDeviceInfo(deviceId, CL_DEVICE_EXTENSIONS, 0, nullptr, &extensionSize);
+    if (err != CL_SUCCESS) {
+        return false;
+    }
+    std::string extensions(extensionSize, '\0');
+    clGetDeviceInfo(deviceId, CL_DEVICE_EXTENSIONS, extensionSize, &extensions[0], nullptr);
+    if (extensions.find(CL_KHR_COMMAND_BUFFER_EXTENSION_NAME) == std::string::npos) {
+        return false;
+    }
+
+    cl_command_queue_properties required = 0, properties = 0;
+    clGetDeviceInfo(deviceId, CL_DEVICE_COMMAND_BUFFER_REQUIRED_QUEUE_PROPERTIES_KHR,
+                    sizeof(required), &required, nullptr);
+    clGetCommandQueueInfo(cmdQueue, CL_QUEUE_PROPERTIES, sizeof(properties), &properties,
+                          nullptr);
+    if ((properties & required) != required) {
+        return false;
+    }
+
+    cl_platform_id platform;
+    err = clGetDeviceInfo(deviceId, CL_DEVICE_PLATFORM, sizeof(cl_platform_id), &platform,
+                          nullptr);
+    if (err != CL_SUCCESS) {
+        return false;
+    }
+    createCommandBuffer = reinterpret_cast<clCreateCommandBufferKHR_fn>(
+            clGetExtensionFunctionAddressForPlatform(platform, "clCreateCommandBufferKHR"));
+    finalizeCommandBuffer = reinterpret_cast<clFinalizeCommandBufferKHR_fn>(
+            clGetExtensionFunctionAddressForPlatform(platform, "clFinalizeCommandBufferKHR"));
+    releaseCommandBuffer = reinterpret_cast<clReleaseCommandBufferKHR_fn>(
+            clGetExtensionFunctionAddressForPlatform(platform, "clReleaseCommandBufferKHR"));
+    enqueueCommandBuffer = reinterpret_cast<clEnqueueCommandBufferKHR_fn>(
+            clGetExtensionFunctionAddressForPlatform(platform, "clEnqueueCommandBufferKHR"));
+    commandNDRangeKernel = reinterpret_cast<clCommandNDRangeKernelKHR_fn>(
+            clGetExtensionFunctionAddressForPlatform(platform, "clCommandNDRangeKernelKHR"));
+    commandCopyBuffer = reinterpret_cast<clCommandCopyBufferKHR_fn>(
+            clGetExtensionFunctionAddressForPlatform(platform, "clCommandCopyBufferKHR"));
+    if (createCommandBuffer == nullptr || finalizeCommandBuffer == nullptr ||
+        releaseCommandBuffer == nullptr || enqueueCommandBuffer == nullptr ||
+        commandNDRangeKernel == nullptr || commandCopyBuffer == nullptr) {
+        return false;
+    }
+
+    commandBuffer = createCommandBuffer(1, &cmdQueue, nullptr, &err);
+    if (err != CL_SUCCESS) {
+        commandBuffer = nullptr;
+        return false;
+    }
+
+    std::vector<cl_sync_point_khr> syncPoints(commands.size());
+    std::vector<cl_sync_point_khr> waitList;
+    for (size_t i = 0; i < commands.size() && err == CL_SUCCESS; i++) {
+        auto &command = commands[i];
+        waitList.clear();
+        for (auto dep: command.deps) {
+            waitList.push_back(syncPoints[dep]);
+        }
+        if (inOrder && i > 0) {
+            waitList.push_back(syncPoints[i - 1]);
+        }
+
+        if (command.type == KERNEL) {
+            err = commandNDRangeKernel(commandBuffer, nullptr, nullptr, command.kernel,
+                                       command.workDim,
+                                       command.hasOffset ? command.offset : nullptr,
+                                       command.global,
+                                       command.hasLocal ? command.local : nullptr,
+                                       waitList.size(),
+                                       waitList.empty() ? nullptr : waitList.data(),
+                                       &syncPoints[i], nullptr);
+        } else {
+            err = commandCopyBuffer(commandBuffer, nullptr, command.src, command.dst,
+                                    command.srcOffset, command.dstOffset, command.size,
+                                    waitList.size(),
+                                    waitList.empty() ? nullptr : waitList.data(),
+                                    &syncPoints[i], nullptr);
+        }
+    }
+    if (err == CL_SUCCESS) {
+        err = finalizeCommandBuffer(commandBuffer);
+    }
+    if (err != CL_SUCCESS) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "command buffer error %d", err);
+        releaseCommandBuffer(commandBuffer);
+        commandBuffer = nullptr;
+        return false;
+    }
+    return true;
+}
+
+cl_int CommandRecorder::replay(const std::vector<cl_event> &inputs, cl_event *event) {
+    cl_int err;
+    if (!ready) {
+        return CL_INVALID_OPERATION;
+    }
+    if (inputs.size() != inputEvents.size()) {
+        return CL_INVALID_VALUE;
+    }
+
+    if (commandBuffer != nullptr) {
+        std::vector<cl_event> waitList;
+        for (auto input: inputs) {
+            if (input != nullptr) {
+                waitList.push_back(input);
+            }
+        }
+        err = enqueueCommandBuffer(0, nullptr, commandBuffer, waitList.size(),
+                                   waitList.empty() ? nullptr : waitList.data(), event);
+    } else {
+        err = replayList(inputs, event);
+    }
+    CHECK_ERROR(err);
+    Tracer::getInstance().record("replay", *event);
+    return CL_SUCCESS;
+}
+
+cl_int CommandRecorder::replayList(const std::vector<cl_event> &inputs, cl_event *event) {
+    cl_int err = CL_SUCCESS;
+    std::vector<cl_event> issued(commands.size(), nullptr);
+    std::vector<cl_event> waitList;
+
+    for (size_t i = 0; i < commands.size() && err == CL_SUCCESS; i++) {
+        auto &command = commands[i];
+        waitList.clear();
+        if (!inOrder) {
+            for (auto dep: command.deps) {
+                waitList.push_back(issued[dep]);
+            }
+        }
+        for (auto input: command.inputs) {
+            if (inputs[input] != nullptr) {
+                waitList.push_back(inputs[input]);
+            }
+        }
+
+        auto e = command.needed ? &issued[i] : nullptr;
+        if (command.type == KERNEL) {
+            err = ::clEnqueueNDRangeKernel(cmdQueue, command.kernel, command.workDim,
+                                           command.hasOffset ? command.offset : nullptr,
+                                           command.global,
+                                           command.hasLocal ? command.local : nullptr,
+                                           waitList.size(),
+                                           waitList.empty() ? nullptr : waitList.data(), e);
+        } else {
+            err = ::clEnqueueCopyBuffer(cmdQueue, command.src, command.dst, command.srcOffset,
+                                        command.dstOffset, command.size, waitList.size(),
+                                        waitList.empty() ? nullptr : waitList.data(), e);
+        }
+    }
+
+    if (err == CL_SUCCESS) {
+        waitList.clear();
+        for (auto sink: sinks) {
+            waitList.push_back(issued[sink]);
+        }
+        err = ::clEnqueueMarkerWithWaitList(cmdQueue, waitList.size(),
+                                            waitList.empty() ? nullptr : waitList.data(), event);
+    }
+
+    for (auto e: issued) {
+        if (e != nullptr) {
+            clReleaseEvent(e);
+        }
+    }
+    return err;
+}
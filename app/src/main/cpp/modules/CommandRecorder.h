@@ -0,0 +1,188 @@
+//
+// Created by 구현우 on 2024/07/22.
+//
+
+#ifndef MY_OPENCL_COMMANDRECORDER_H
+#define MY_OPENCL_COMMANDRECORDER_H
+
+#define CL_TARGET_OPENCL_VERSION 200
+
+#include "CL/opencl.h"
+
+#include <map>
+#include <vector>
+
+/*
+ * layer 가 쓰는 OpenCL 호출. CommandRecorder 가 기록 중인 thread 에서는 기록하고, 아니면 그대로 호출.
+ */
+namespace record {
+    cl_mem clCreateBuffer(cl_context context, cl_mem_flags flags, size_t size, void *host_ptr,
+                          cl_int *errcode_ret);
+
+    cl_int clReleaseMemObject(cl_mem memobj);
+
+    cl_int clSetKernelArg(cl_kernel kernel, cl_uint arg_index, size_t arg_size,
+                          const void *arg_value);
+
+    cl_int clEnqueueNDRangeKernel(cl_command_queue command_queue, cl_kernel kernel,
+                                  cl_uint work_dim, const size_t *global_work_offset,
+                                  const size_t *global_work_size, const size_t *local_work_size,
+                                  cl_uint num_events_in_wait_list, const cl_event *event_wait_list,
+                                  cl_event *event);
+
+    cl_int clEnqueueCopyBuffer(cl_command_queue command_queue, cl_mem src_buffer,
+                               cl_mem dst_buffer, size_t src_offset, size_t dst_offset,
+                               size_t size, cl_uint num_events_in_wait_list,
+                               const cl_event *event_wait_list, cl_event *event);
+
+    cl_int clEnqueueMarkerWithWaitList(cl_command_queue command_queue,
+                                       cl_uint num_events_in_wait_list,
+                                       const cl_event *event_wait_list, cl_event *event);
+}
+
+/*
+ * 한 번 실행 (e.g. UNet 1 step) 의 kernel launch 를 기록해서 다시 enqueue.
+ * begin ~ end 사이에 현재 thread 에서 record:: 로 enqueue 한 kernel 을 argument 가 bind 된 kernel 로 복제하고
+ * event wait list 는 launch 사이의 dependency 로 바꿔 둠. replay 는 clSetKernelArg, clGetMemObjectInfo,
+ * layer 의 host 코드 없이 enqueue 만 (cl_khr_command_buffer 가 있으면 command buffer 1 개).
+ *
+ * - 기록 중에 생성한 buffer 는 recorder 소유. release 하면 pool 로 돌아가고 같은 크기의 다음 buffer 로 재사용
+ *   (이전 사용이 끝난 뒤 쓰도록 dependency 추가), 따라서 replay 의 memory 는 한 번 실행한 것과 비슷.
+ * - 기록 밖에서 만든 buffer (weight, 입력) 는 recorder 보다 오래 유지되어야 함.
+ * - 입력은 begin 의 event 순서로 구분. replay 전에 같은 buffer 에 새 값을 쓰고 그 event 를 전달.
+ * - 기록할 수 없는 호출 (기록 밖의 event 를 기다림, argument 가 기록 전에 set 됨 등) 이 있으면 end 가 false.
+ */
+class CommandRecorder {
+public:
+    CommandRecorder(cl_context context, cl_command_queue cmdQueue, cl_device_id deviceId,
+                    bool useCommandBuffer);
+
+    ~CommandRecorder();
+
+    /* `inputs`: 입력을 쓴 event (nullptr 가능) */
+    void begin(const std::vector<cl_event> &inputs);
+
+    /* @return: replay 가능 여부 */
+    bool end();
+
+    bool isReady() const;
+
+    bool isCommandBuffer() const;
+
+    size_t size() const;
+
+    /* `inputs`: begin 과 같은 순서, 바뀌지 않은 입력은 nullptr. `event`: 모든 launch 가 끝나는 event */
+    cl_int replay(const std::vector<cl_event> &inputs, cl_event *event);
+
+    /* 현재 thread 에서 기록 중인 recorder (record:: 에서 사용) */
+    static CommandRecorder *current();
+
+    cl_mem createBuffer(cl_context context, cl_mem_flags flags, size_t size, void *host_ptr,
+                        cl_int *errcode_ret);
+
+    cl_int releaseBuffer(cl_mem buffer);
+
+    void setArg(cl_kernel kernel, cl_uint index, size_t size, const void *value);
+
+    cl_int enqueueKernel(cl_command_queue queue, cl_kernel kernel, cl_uint workDim,
+                         const size_t *offset, const size_t *global, const size_t *local,
+                         cl_uint num_events_in_list, const cl_event *event_wait_list,
+                         cl_event *event);
+
+    cl_int enqueueCopy(cl_command_queue queue, cl_mem src, cl_mem dst, size_t srcOffset,
+                       size_t dstOffset, size_t size, cl_uint num_events_in_list,
+                       const cl_event *event_wait_list, cl_event *event);
+
+    cl_int enqueueMarker(cl_command_queue queue, cl_uint num_events_in_list,
+                         const cl_event *event_wait_list, cl_event *event);
+
+private:
+    enum Type {
+        KERNEL, COPY, MARKER
+    };
+
+    struct Arg {
+        size_t size;
+        /* local memory 이면 empty */
+        std::vector<unsigned char> value;
+    };
+
+    struct Command {
+        Type type;
+        /* KERNEL: argument 가 bind 된 복제 */
+        cl_kernel kernel;
+        cl_uint workDim;
+        size_t offset[3];
+        size_t global[3];
+        size_t local[3];
+        bool hasOffset;
+        bool hasLocal;
+        /* COPY */
+        cl_mem src;
+        cl_mem dst;
+        size_t srcOffset;
+        size_t dstOffset;
+        size_t size;
+        /* 앞선 command, 입력 index */
+        std::vector<size_t> deps;
+        std::vector<size_t> inputs;
+        /* list replay 에서 event 를 만들지 */
+        bool needed;
+    };
+
+    struct Buffer {
+        cl_mem buffer;
+        cl_mem_flags flags;
+        size_t bytes;
+        bool free;
+        /* 이전에 이 buffer 를 쓰던 command, 현재 사용 중인 command */
+        std::vector<size_t> previous;
+        std::vector<size_t> users;
+    };
+
+    /* 기록 중에 만든 buffer 이면 사용으로 기록하고, 재사용된 buffer 면 이전 사용의 event 를 `waitList` 에 추가 */
+    void use(cl_mem buffer, std::vector<cl_event> &waitList);
+
+    void addCommand(Command command, const std::vector<cl_event> &waitList, cl_event recorded,
+                    cl_event *event);
+
+    cl_kernel cloneKernel(cl_kernel kernel);
+
+    /* marker 제거, in-order queue 의 순서를 dependency 로 */
+    void compile();
+
+    bool buildCommandBuffer();
+
+    cl_int replayList(const std::vector<cl_event> &inputs, cl_event *event);
+
+    cl_context context;
+    cl_command_queue cmdQueue;
+    cl_device_id deviceId;
+    bool useCommandBuffer;
+    bool inOrder;
+
+    bool valid = false;
+    bool ready = false;
+
+    std::vector<cl_event> inputEvents;
+    std::vector<Command> commands;
+    std::vector<size_t> sinks;
+    std::vector<Buffer> buffers;
+    std::map<cl_mem, size_t> bufferIndex;
+    std::map<cl_kernel, std::map<cl_uint, Arg>> args;
+
+    /* 기록 중 command 의 event (retain) */
+    std::vector<cl_event> events;
+    std::map<cl_event, size_t> eventIndex;
+
+    cl_command_buffer_khr commandBuffer = nullptr;
+    clCreateCommandBufferKHR_fn createCommandBuffer = nullptr;
+    clFinalizeCommandBufferKHR_fn finalizeCommandBuffer = nullptr;
+    clReleaseCommandBufferKHR_fn releaseCommandBuffer = nullptr;
+    clEnqueueCommandBufferKHR_fn enqueueCommandBuffer = nullptr;
+    clCommandNDRangeKernelKHR_fn commandNDRangeKernel = nullptr;
+    clCommandCopyBufferKHR_fn commandCopyBuffer = nullptr;
+};
+
+
+#endif //MY_OPENCL_COMMANDRECORDER_H
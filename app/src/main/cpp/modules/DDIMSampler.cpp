@@ -6,7 +6,9 @@
 #include <algorithm>
 #include <numeric>
 #include <random>
+#include <stdexcept>
 #include "util.h"
+#include "Tracer.h"
 #include <android/log.h>
 
 #define LOG_TAG "DDIM_SAMPLER"
@@ -40,6 +42,10 @@ DDIMSampler::DDIMSampler(const std::function<std::vector<float>(
 
 DDIMSampler::~DDIMSampler() = default;
 
+void DDIMSampler::setProgress(const Progress &callback) {
+    progress = callback;
+}
+
 std::vector<float> DDIMSampler::sample(
         std::vector<float> *x_T,
         int ddim_num_steps,
@@ -75,11 +81,19 @@ std::vector<float> DDIMSampler::sample(
     // util::testBuffer(alphas_prev, "sampler/test/test_alphas_prev.npy");
     // util::testBuffer(sqrt_one_minus_alphas, "sampler/test/test_sqrt_one_minus_alphas.npy");
 
-    for (int index = static_cast<int>(ddim_timesteps.size()) - 1; index >= 0; index--) {
+    std::vector<float> pred_x0;
+    auto steps = static_cast<int>(ddim_timesteps.size());
+    for (int index = steps - 1; index >= 0; index--) {
         auto step = ddim_timesteps[index];
+        Tracer::Scope scope("step/" + std::to_string(index));
 
         img = p_sample_ddim(img, step, conditioning, index, alphas, alphas_prev,
-                            sqrt_one_minus_alphas);
+                            sqrt_one_minus_alphas, progress ? &pred_x0 : nullptr);
+        if (progress && !progress(steps - index, steps, pred_x0)) {
+            __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "cancelled at step %d / %d",
+                                steps - index, steps);
+            throw std::runtime_error("sampling cancelled");
+        }
         // max diff: 0.00000047683715820312
         // util::testBuffer(img, "sampler/test/test_img_after.npy");
     }
@@ -96,7 +110,8 @@ std::vector<float> DDIMSampler::p_sample_ddim(
         size_t index,
         std::vector<float> &alphas,
         std::vector<float> &alphas_prev,
-        std::vector<float> &sqrt_one_minus_alphas) {
+        std::vector<float> &sqrt_one_minus_alphas,
+        std::vector<float> *pred_x0_out) {
     std::vector<float> e_t, dir_xt(x.size()), x_prev(x.size()), pred_x0(x.size());
     float a_t, a_prev, sqrt_one_minus_at;
 
@@ -117,6 +132,10 @@ std::vector<float> DDIMSampler::p_sample_ddim(
     for (int i = 0; i < e_t.size(); i++) {
         x_prev[i] = sqrt(a_prev) * pred_x0[i] + dir_xt[i];
     }
+
+    if (pred_x0_out != nullptr) {
+        *pred_x0_out = std::move(pred_x0);
+    }
     return x_prev;
 }
 
@@ -5,10 +5,17 @@
 #ifndef MY_OPENCL_DDIMSAMPLER_H
 #define MY_OPENCL_DDIMSAMPLER_H
 
+#include <functional>
 #include <vector>
 
 class DDIMSampler {
 public:
+    /*
+     * step 마다 호출. `step`: 끝난 step 수 (1 ~ `steps`), `pred_x0`: 이번 step 의 x_0 예측 (latent).
+     * false 를 반환하면 sample 을 중단 (runtime_error).
+     */
+    typedef std::function<bool(int step, int steps, const std::vector<float> &pred_x0)> Progress;
+
     DDIMSampler(const std::function<std::vector<float>(const std::vector<float> &, int,
                                                        const std::vector<float> &)> &apply_model);
 
@@ -20,12 +27,15 @@ public:
             const int shape[3],
             const std::vector<float> &conditioning);
 
+    void setProgress(const Progress &callback);
+
 private:
     std::vector<float>
     p_sample_ddim(const std::vector<float> &x, int t, const std::vector<float> &c, size_t index,
                   std::vector<float> &alphas,
                   std::vector<float> &alphas_prev,
-                  std::vector<float> &sqrt_one_minus_alphas);
+                  std::vector<float> &sqrt_one_minus_alphas,
+                  std::vector<float> *pred_x0_out = nullptr);
 
     std::pair<std::vector<float>, std::vector<float>>
     make_schedule(const std::vector<int> &ddim_timesteps);
@@ -37,6 +47,8 @@ private:
 
     const std::function<std::vector<float>(const std::vector<float> &, int,
                                            const std::vector<float> &)> apply_model;
+
+    Progress progress;
 };
 
 
@@ -4,12 +4,19 @@
 
 #include "Decoder.h"
 
+#include <algorithm>
 #include <android/log.h>
 #include "util.h"
+#include "Tracer.h"
+#include "ResidencyManager.h"
+#include "setting.h"
+#include "cpu/CpuBackend.h"
 
 #define LOG_TAG "DECODER"
 
 #define SCALE_FACTOR 0.18215f
+#define LATENT_CHANNELS 4
+#define NUM_RES_BLOCKS 3
 
 #define CHECK_ERROR_THROW(err) \
     if (err != CL_SUCCESS) {   \
@@ -17,566 +24,281 @@
       throw std::runtime_error("OpenCL error."); \
     }
 
+/*
+ * decoder up[3] -> up[0] (ch 128, ch_mult (1, 2, 4, 4), num_res_blocks 2 + 1).
+ * channels: ResBlock 출력 채널 (입력과 다르면 nin_shortcut), sample: 마지막에 UpSample
+ */
+struct DecoderLevel {
+    int level;
+    size_t channels;
+    bool sample;
+};
+
+static const DecoderLevel UP_LEVELS[] = {
+        {3, 512, true},
+        {2, 512, true},
+        {1, 256, true},
+        {0, 128, false},
+};
+
 Decoder::Decoder(
         cl_context context, cl_command_queue cmdQueue, cl_device_id deviceId,
-        AAssetManager *assetManager
-) : context(context), cmdQueue(cmdQueue) {
-
-    linearKernel = std::make_shared<LinearKernel>(context, deviceId, assetManager);
-    utilKernel = std::make_shared<UtilKernel>(context, deviceId, assetManager);
-    convKernel = std::make_shared<ConvKernel>(context, deviceId, assetManager);
-    groupNormKernel = std::make_shared<GroupNormKernel>(context, deviceId, assetManager);
-    upSampleKernel = std::make_shared<UpSampleKernel>(context, deviceId, assetManager);
-
-    post_quant_conv2d = new Conv2D(context, cmdQueue,
-                                   4, 4, 1, 1, 0,
-                                   "decoder/post_quant_conv_weight.npy",
-                                   "decoder/post_quant_conv_bias.npy", convKernel);
-
-    in_conv2d = new Conv2D(context, cmdQueue,
-                           4, 512, 3, 1, 1,
-                           "decoder/decoder_conv_in_weight.npy",
-                           "decoder/decoder_conv_in_bias.npy", convKernel);
-
-    mid_res_block_1 = new ResBlock(context, cmdQueue,
-                                   512, 0, 512,
-                                   "decoder/mid/decoder_mid_block_1_norm1_weight.npy",
-                                   "decoder/mid/decoder_mid_block_1_norm1_bias.npy",
-                                   "decoder/mid/decoder_mid_block_1_conv1_weight.npy",
-                                   "decoder/mid/decoder_mid_block_1_conv1_bias.npy",
-                                   "", "",
-                                   "decoder/mid/decoder_mid_block_1_norm2_weight.npy",
-                                   "decoder/mid/decoder_mid_block_1_norm2_bias.npy",
-                                   "decoder/mid/decoder_mid_block_1_conv2_weight.npy",
-                                   "decoder/mid/decoder_mid_block_1_conv2_bias.npy",
-                                   "", "",
-                                   linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    mid_attn_block = new AttnBlock(context, cmdQueue, deviceId, assetManager,
-                                   512,
-                                   "decoder/mid/decoder_mid_attn_1_norm_weight.npy",
-                                   "decoder/mid/decoder_mid_attn_1_norm_bias.npy",
-                                   "decoder/mid/decoder_mid_attn_1_q_weight.npy",
-                                   "decoder/mid/decoder_mid_attn_1_q_bias.npy",
-                                   "decoder/mid/decoder_mid_attn_1_k_weight.npy",
-                                   "decoder/mid/decoder_mid_attn_1_k_bias.npy",
-                                   "decoder/mid/decoder_mid_attn_1_v_weight.npy",
-                                   "decoder/mid/decoder_mid_attn_1_v_bias.npy",
-                                   "decoder/mid/decoder_mid_attn_1_proj_out_weight.npy",
-                                   "decoder/mid/decoder_mid_attn_1_proj_out_bias.npy",
-                                   convKernel, utilKernel, groupNormKernel);
-
-    mid_res_block_2 = new ResBlock(context, cmdQueue,
-                                   512, 0, 512,
-                                   "decoder/mid/decoder_mid_block_2_norm1_weight.npy",
-                                   "decoder/mid/decoder_mid_block_2_norm1_bias.npy",
-                                   "decoder/mid/decoder_mid_block_2_conv1_weight.npy",
-                                   "decoder/mid/decoder_mid_block_2_conv1_bias.npy",
-                                   "", "",
-                                   "decoder/mid/decoder_mid_block_2_norm2_weight.npy",
-                                   "decoder/mid/decoder_mid_block_2_norm2_bias.npy",
-                                   "decoder/mid/decoder_mid_block_2_conv2_weight.npy",
-                                   "decoder/mid/decoder_mid_block_2_conv2_bias.npy",
-                                   "", "",
-                                   linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    for (int i = 0; i < 3; i++) {
-        auto folder_prefix =
-                "decoder/up/3/decoder_up_3_block_" + std::to_string(i);
-        auto in_group_norm_weight_name = folder_prefix + "_norm1_weight.npy";
-        auto in_group_norm_bias_name = folder_prefix + "_norm1_bias.npy";
-        auto in_conv2d_weight_name = folder_prefix + "_conv1_weight.npy";
-        auto in_conv2d_bias_name = folder_prefix + "_conv1_bias.npy";
-        auto out_group_norm_weight_name = folder_prefix + "_norm2_weight.npy";
-        auto out_group_norm_bias_name = folder_prefix + "_norm2_bias.npy";
-        auto out_conv2d_weight_name = folder_prefix + "_conv2_weight.npy";
-        auto out_conv2d_bias_name = folder_prefix + "_conv2_bias.npy";
-        up_3_res_blocks[i] = new ResBlock(context, cmdQueue,
-                                          512, 0, 512,
-                                          in_group_norm_weight_name,
-                                          in_group_norm_bias_name,
-                                          in_conv2d_weight_name,
-                                          in_conv2d_bias_name,
-                                          "", "",
-                                          out_group_norm_weight_name,
-                                          out_group_norm_bias_name,
-                                          out_conv2d_weight_name,
-                                          out_conv2d_bias_name,
-                                          "", "",
-                                          linearKernel, convKernel, groupNormKernel, utilKernel);
-    }
+        AAssetManager *assetManager, size_t height, size_t width
+) : context(context), cmdQueue(cmdQueue), deviceId(deviceId), assetManager(assetManager),
+    height(height), width(width), graph(context, cmdQueue, deviceId, assetManager),
+    tileGraph(context, cmdQueue, deviceId, assetManager) {
+    build();
+}
 
-    up_3_up_sample = new UpSample(context, cmdQueue,
-                                  512, 512, 3, 1, 1,
-                                  "decoder/up/3/decoder_up_3_upsample_conv_weight.npy",
-                                  "decoder/up/3/decoder_up_3_upsample_conv_bias.npy",
-                                  convKernel, upSampleKernel);
-
-    for (int i = 0; i < 3; i++) {
-        auto folder_prefix =
-                "decoder/up/2/decoder_up_2_block_" + std::to_string(i);
-        auto in_group_norm_weight_name = folder_prefix + "_norm1_weight.npy";
-        auto in_group_norm_bias_name = folder_prefix + "_norm1_bias.npy";
-        auto in_conv2d_weight_name = folder_prefix + "_conv1_weight.npy";
-        auto in_conv2d_bias_name = folder_prefix + "_conv1_bias.npy";
-        auto out_group_norm_weight_name = folder_prefix + "_norm2_weight.npy";
-        auto out_group_norm_bias_name = folder_prefix + "_norm2_bias.npy";
-        auto out_conv2d_weight_name = folder_prefix + "_conv2_weight.npy";
-        auto out_conv2d_bias_name = folder_prefix + "_conv2_bias.npy";
-        up_2_res_blocks[i] = new ResBlock(context, cmdQueue,
-                                          512, 0, 512,
-                                          in_group_norm_weight_name,
-                                          in_group_norm_bias_name,
-                                          in_conv2d_weight_name,
-                                          in_conv2d_bias_name,
-                                          "", "",
-                                          out_group_norm_weight_name,
-                                          out_group_norm_bias_name,
-                                          out_conv2d_weight_name,
-                                          out_conv2d_bias_name,
-                                          "", "",
-                                          linearKernel, convKernel, groupNormKernel, utilKernel);
-    }
+void Decoder::build() {
+    graph.setResidency("decoder", ResidencyManager::NORMAL);
+    tileGraph.setResidency("decoder/tile", ResidencyManager::NORMAL);
+    inputId = graph.input(LATENT_CHANNELS, height, width);
 
-    up_2_up_sample = new UpSample(context, cmdQueue,
-                                  512, 512, 3, 1, 1,
-                                  "decoder/up/2/decoder_up_2_upsample_conv_weight.npy",
-                                  "decoder/up/2/decoder_up_2_upsample_conv_bias.npy",
-                                  convKernel, upSampleKernel);
-
-    for (int i = 0; i < 3; i++) {
-        auto folder_prefix =
-                "decoder/up/1/decoder_up_1_block_" + std::to_string(i);
-        auto in_group_norm_weight_name = folder_prefix + "_norm1_weight.npy";
-        auto in_group_norm_bias_name = folder_prefix + "_norm1_bias.npy";
-        auto in_conv2d_weight_name = folder_prefix + "_conv1_weight.npy";
-        auto in_conv2d_bias_name = folder_prefix + "_conv1_bias.npy";
-        auto out_group_norm_weight_name = folder_prefix + "_norm2_weight.npy";
-        auto out_group_norm_bias_name = folder_prefix + "_norm2_bias.npy";
-        auto out_conv2d_weight_name = folder_prefix + "_conv2_weight.npy";
-        auto out_conv2d_bias_name = folder_prefix + "_conv2_bias.npy";
-        size_t in_channel, out_channel;
-        std::string in_skip_conv2d_weight_name, in_skip_conv2d_bias_name;
-        if (i == 0) {
-            in_channel = 512;
-            out_channel = 256;
-            in_skip_conv2d_weight_name = "decoder/up/1/decoder_up_1_block_0_nin_shortcut_weight.npy";
-            in_skip_conv2d_bias_name = "decoder/up/1/decoder_up_1_block_0_nin_shortcut_bias.npy";
-        } else {
-            in_channel = 256;
-            out_channel = 256;
-            in_skip_conv2d_weight_name = "";
-            in_skip_conv2d_bias_name = "";
-        }
-        up_1_res_blocks[i] = new ResBlock(context, cmdQueue,
-                                          in_channel, 0, out_channel,
-                                          in_group_norm_weight_name, in_group_norm_bias_name,
-                                          in_conv2d_weight_name, in_conv2d_bias_name,
-                                          "", "",
-                                          out_group_norm_weight_name, out_group_norm_bias_name,
-                                          out_conv2d_weight_name, out_conv2d_bias_name,
-                                          in_skip_conv2d_weight_name, in_skip_conv2d_bias_name,
-                                          linearKernel, convKernel, groupNormKernel, utilKernel);
+    auto h = graph.conv2d("post_quant_conv2d", "decoder/post_quant_conv", inputId,
+                          LATENT_CHANNELS, 1, 1, 0);
+
+    /* Decoder */
+    h = graph.conv2d("in_conv2d", "decoder/decoder_conv_in", h, 512, 3, 1, 1);
+
+    /* mid */
+    h = graph.resBlock("mid/res_block/1", "decoder/mid/decoder_mid_block_1",
+                       ModelGraph::VAE, h, -1, 512);
+    h = graph.attnBlock("mid/attn_block", "decoder/mid/decoder_mid_attn_1", h);
+    midId = graph.resBlock("mid/res_block/2", "decoder/mid/decoder_mid_block_2",
+                           ModelGraph::VAE, h, -1, 512);
+
+    size_t tileHeight = height, tileWidth = width;
+    if (DECODER_TILE_MODE == 1) {
+        tileHeight = std::min<size_t>(DECODER_TILE_SIZE, height);
+        tileWidth = std::min<size_t>(DECODER_TILE_SIZE, width);
     }
+    h = tileInputId = tileGraph.input(512, tileHeight, tileWidth);
 
-    up_1_up_sample = new UpSample(context, cmdQueue,
-                                  256, 256, 3, 1, 1,
-                                  "decoder/up/1/decoder_up_1_upsample_conv_weight.npy",
-                                  "decoder/up/1/decoder_up_1_upsample_conv_bias.npy",
-                                  convKernel, upSampleKernel);
-
-    for (int i = 0; i < 3; i++) {
-        auto folder_prefix =
-                "decoder/up/0/decoder_up_0_block_" + std::to_string(i);
-        auto in_group_norm_weight_name = folder_prefix + "_norm1_weight.npy";
-        auto in_group_norm_bias_name = folder_prefix + "_norm1_bias.npy";
-        auto in_conv2d_weight_name = folder_prefix + "_conv1_weight.npy";
-        auto in_conv2d_bias_name = folder_prefix + "_conv1_bias.npy";
-        auto out_group_norm_weight_name = folder_prefix + "_norm2_weight.npy";
-        auto out_group_norm_bias_name = folder_prefix + "_norm2_bias.npy";
-        auto out_conv2d_weight_name = folder_prefix + "_conv2_weight.npy";
-        auto out_conv2d_bias_name = folder_prefix + "_conv2_bias.npy";
-        size_t in_channel, out_channel;
-        std::string in_skip_conv2d_weight_name, in_skip_conv2d_bias_name;
-        if (i == 0) {
-            in_channel = 256;
-            out_channel = 128;
-            in_skip_conv2d_weight_name = "decoder/up/0/decoder_up_0_block_0_nin_shortcut_weight.npy";
-            in_skip_conv2d_bias_name = "decoder/up/0/decoder_up_0_block_0_nin_shortcut_bias.npy";
-        } else {
-            in_channel = 128;
-            out_channel = 128;
-            in_skip_conv2d_weight_name = "";
-            in_skip_conv2d_bias_name = "";
+    /* up */
+    size_t preload = 0;
+    for (auto &up: UP_LEVELS) {
+        auto level = std::to_string(up.level);
+        auto prefix = "decoder/up/" + level + "/decoder_up_" + level;
+        for (int i = 0; i < NUM_RES_BLOCKS; i++) {
+            h = tileGraph.resBlock("up/" + level + "/res_blocks/" + std::to_string(i),
+                                   prefix + "_block_" + std::to_string(i),
+                                   ModelGraph::VAE, h, -1, up.channels);
+        }
+        if (up.sample) {
+            h = tileGraph.upSample("up/" + level + "/up_sample", prefix + "_upsample_conv", h);
+        }
+        /* up[2] 까지 미리 load */
+        if (up.level == 2) {
+            preload = tileGraph.size();
         }
-        up_0_res_blocks[i] = new ResBlock(context, cmdQueue,
-                                          in_channel, 0, out_channel,
-                                          in_group_norm_weight_name, in_group_norm_bias_name,
-                                          in_conv2d_weight_name, in_conv2d_bias_name,
-                                          "", "",
-                                          out_group_norm_weight_name, out_group_norm_bias_name,
-                                          out_conv2d_weight_name, out_conv2d_bias_name,
-                                          in_skip_conv2d_weight_name, in_skip_conv2d_bias_name,
-                                          linearKernel, convKernel, groupNormKernel, utilKernel);
     }
 
-    out_group_norm = new GroupNorm(context, cmdQueue,
-                                   32, 128, 1e-6,
-                                   "decoder/out/decoder_norm_out_weight.npy",
-                                   "decoder/out/decoder_norm_out_bias.npy",
-                                   groupNormKernel);
-
-    out_conv2d = new Conv2D(context, cmdQueue,
-                            128, 3, 3, 1, 1,
-                            "decoder/out/decoder_conv_out_weight.npy",
-                            "decoder/out/decoder_conv_out_bias.npy", convKernel);
-
-    post_quant_conv2d->init();
-    in_conv2d->init();
-    mid_res_block_1->init();
-    mid_attn_block->init();
-    mid_res_block_2->init();
-    for (auto &block: up_3_res_blocks) {
-        block->init();
-    }
-    up_3_up_sample->init();
-    for (auto &block: up_2_res_blocks) {
-        block->init();
-    }
-    up_2_up_sample->init();
-//    for (auto &block: up_1_res_blocks) {
-//        block->init();
-//    }
-//    up_1_up_sample->init();
-//    for (auto &block: up_0_res_blocks) {
-//        block->init();
-//    }
-//    out_group_norm->init();
-//    out_conv2d->init();
-}
+    /* out */
+    h = tileGraph.groupNorm("out/group_norm", "decoder/out/decoder_norm_out", h, 32, 1e-6);
+    h = tileGraph.silu("out/silu", h);
+    outputId = tileGraph.conv2d("out/conv2d", "decoder/out/decoder_conv_out", h, 3, 3, 1, 1);
 
-Decoder::~Decoder() {
-    delete post_quant_conv2d;
-    delete in_conv2d;
-    delete mid_res_block_1;
-    delete mid_attn_block;
-    delete mid_res_block_2;
-    for (auto &block: up_3_res_blocks) {
-        delete block;
-    }
-    delete up_3_up_sample;
-    for (auto &block: up_2_res_blocks) {
-        delete block;
-    }
-    delete up_2_up_sample;
-    for (auto &block: up_1_res_blocks) {
-        delete block;
-    }
-    delete up_1_up_sample;
-    for (auto &block: up_0_res_blocks) {
-        delete block;
-    }
-    delete out_group_norm;
-    delete out_conv2d;
+    graph.load(0, graph.size(), false);
+    tileGraph.load(0, preload, false);
 }
 
+Decoder::~Decoder() = default;
+
 std::vector<float> Decoder::decode(const std::vector<float> &x) {
+    Tracer::Scope scope("decoder");
+    CpuBackend::Scope cpuScope(CPU_BACKEND_MODE >= 2);
+    if (x.size() != LATENT_CHANNELS * height * width) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "x size(%ld) != 4 x %ld x %ld", x.size(),
+                            height, width);
+        throw std::runtime_error("Decoder input size != latent shape");
+    }
     std::vector<float> y(x.size());
     for (int i = 0; i < x.size(); i++) {
         y[i] = 1.f / SCALE_FACTOR * x[i];
     }
 
     cl_int err;
-    cl_event event[24];
-    cl_mem bufferX, buffer_4_64, buffer_512_64, buffer_512_128, buffer_512_256, buffer_256_256, buffer_256_512, buffer_128_512, buffer_3_512;
+    cl_event event[2];
+    cl_mem bufferX, bufferOut;
 
     bufferX = clCreateBuffer(context, CL_MEM_READ_ONLY,
                              sizeof(float) * x.size(),
                              nullptr, &err);
     CHECK_ERROR_THROW(err);
 
-    buffer_4_64 = clCreateBuffer(context, CL_MEM_READ_ONLY,
-                                 sizeof(float) * 4 * 64 * 64,
-                                 nullptr, &err);
-    CHECK_ERROR_THROW(err);
-
     err = clEnqueueWriteBuffer(cmdQueue, bufferX, CL_FALSE, 0,
                                sizeof(float) * y.size(), y.data(),
                                0, nullptr, &event[0]);
     CHECK_ERROR_THROW(err);
 
-    post_quant_conv2d->init();
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process 0");
-    err = post_quant_conv2d->forward(bufferX, buffer_4_64, 1, &event[0], &event[1]);
-    CHECK_ERROR_THROW(err);
-    delete post_quant_conv2d;
-    post_quant_conv2d = nullptr;
-
-    /* Decoder */
-    buffer_512_64 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 512 * 64 * 64,
-                                   nullptr, &err);
-    CHECK_ERROR_THROW(err);
-
-    in_conv2d->init();
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process 1");
-    err = in_conv2d->forward(buffer_4_64, buffer_512_64, 1, &event[1], &event[2]);
-    CHECK_ERROR_THROW(err);
-    delete in_conv2d;
-    in_conv2d = nullptr;
-
-    // test_conv_in.npy max diff: 0.00000238418579101562
-    // util::testBuffer(cmdQueue, buffer_512_64, "decoder/test/test_conv_in.npy");
-
-    /* mid */
-    mid_res_block_1->init();
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process 2");
-    err = mid_res_block_1->forward(buffer_512_64, nullptr, buffer_512_64,
-                                   0, nullptr,
-                                   1, &event[2], &event[3]);
-    CHECK_ERROR_THROW(err);
-    delete mid_res_block_1;
-    mid_res_block_1 = nullptr;
-
-    // test_mid_block_1.npy max diff: 0.00001192092895507812
-    // util::testBuffer(cmdQueue, buffer_512_64, "decoder/test/test_mid_block_1.npy");
+    cl_event eventMid;
+    cl_mem bufferMid = graph.run({bufferX}, {event[0]}, midId, &eventMid);
+
+    auto &mid = graph.getTensor(midId);
+    auto &tile = tileGraph.getTensor(tileInputId);
+    if (tile.height != mid.height || tile.width != mid.width) {
+        std::vector<float> result;
+        try {
+            result = decodeTiles(bufferMid, eventMid);
+        } catch (...) {
+            clReleaseEvent(event[0]);
+            clReleaseEvent(eventMid);
+            clReleaseMemObject(bufferX);
+            clReleaseMemObject(bufferMid);
+            throw;
+        }
+        clReleaseEvent(event[0]);
+        clReleaseEvent(eventMid);
+        clReleaseMemObject(bufferX);
+        clReleaseMemObject(bufferMid);
+        return result;
+    }
 
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process 3");
-    mid_attn_block->init();
-    err = mid_attn_block->forward(buffer_512_64, buffer_512_64,
-                                  1, &event[3], &event[4]);
-    CHECK_ERROR_THROW(err);
-    delete mid_attn_block;
-    mid_attn_block = nullptr;
+    bufferOut = tileGraph.run({bufferMid}, {eventMid}, outputId, &event[1]);
 
-    // test_mid_attn_1.npy max diff: 0.00001525878906250000
-    // util::testBuffer(cmdQueue, buffer_512_64, "decoder/test/test_mid_attn_1.npy");
+    // test_out.npy max diff: 0.00000357627868652344
+    // util::testBuffer(cmdQueue, bufferOut, "decoder/test/test_out.npy");
 
-    mid_res_block_2->init();
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process 4");
-    err = mid_res_block_2->forward(buffer_512_64, nullptr, buffer_512_64,
-                                   0, nullptr,
-                                   1, &event[4], &event[5]);
+    /* result */
+    auto &shape = tileGraph.getTensor(outputId);
+    std::vector<float> result(shape.channels * shape.height * shape.width);
+    err = clEnqueueReadBuffer(cmdQueue, bufferOut, CL_FALSE, 0,
+                              sizeof(float) * result.size(), result.data(),
+                              1, &event[1], nullptr);
     CHECK_ERROR_THROW(err);
-    delete mid_res_block_2;
-    mid_res_block_2 = nullptr;
-
-    // test_mid_block_2.npy max diff: 0.00003004074096679688
-    // util::testBuffer(cmdQueue, buffer_512_64, "decoder/test/test_mid_block_2.npy");
-    /* mid */
+    /* result */
 
-    /* up */
-    /* up[3] */
-    buffer_512_128 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * 512 * 128 * 128,
-                                    nullptr, &err);
-    CHECK_ERROR_THROW(err);
+    clFinish(cmdQueue);
 
-    int event_idx = 5;
-    for (auto &block: up_3_res_blocks) {
-        block->init();
-        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process %d", event_idx);
-        err = block->forward(buffer_512_64, nullptr, buffer_512_64,
-                             0, nullptr,
-                             1, &event[event_idx], &event[event_idx + 1]);
-        CHECK_ERROR_THROW(err);
-        delete block;
-        block = nullptr;
-
-        event_idx++;
+    for (auto &e: event) {
+        clReleaseEvent(e);
     }
+    clReleaseEvent(eventMid);
+    clReleaseMemObject(bufferX);
+    clReleaseMemObject(bufferMid);
+    clReleaseMemObject(bufferOut);
+    return result;
+}
 
-    up_3_up_sample->init();
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process 8");
-    err = up_3_up_sample->forward(buffer_512_64, buffer_512_128,
-                                  1, &event[8], &event[9]);
-    CHECK_ERROR_THROW(err);
-    delete up_3_up_sample;
-    up_3_up_sample = nullptr;
-
-    // test_up_3.npy max diff: 0.00012969970703125000
-    // util::testBuffer(cmdQueue, buffer_512_128, "decoder/test/test_up_3.npy");
-    /* up[3] */
-
-    /* up[2] */
-    buffer_512_256 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * 512 * 256 * 256,
-                                    nullptr, &err);
-    CHECK_ERROR_THROW(err);
-
-    event_idx = 9;
-    for (auto &block: up_2_res_blocks) {
-        block->init();
-        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process %d", event_idx);
-        err = block->forward(buffer_512_128, nullptr, buffer_512_128,
-                             0, nullptr,
-                             1, &event[event_idx], &event[event_idx + 1]);
-        CHECK_ERROR_THROW(err);
-        delete block;
-        block = nullptr;
-
-        event_idx++;
+std::vector<size_t> Decoder::tileOffsets(size_t size, size_t tile, size_t overlap) {
+    std::vector<size_t> offsets = {0};
+    auto stride = tile > overlap ? tile - overlap : 1;
+    while (offsets.back() + tile < size) {
+        offsets.push_back(std::min(offsets.back() + stride, size - tile));
     }
+    return offsets;
+}
 
-    up_2_up_sample->init();
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process 12");
-    err = up_2_up_sample->forward(buffer_512_128, buffer_512_256,
-                                  1, &event[12], &event[13]);
-    CHECK_ERROR_THROW(err);
-    delete up_2_up_sample;
-    up_2_up_sample = nullptr;
-
-    // test_up_2.npy max diff: 0.00060272216796875000
-    // util::testBuffer(cmdQueue, buffer_512_256, "decoder/test/test_up_2.npy");
-    /* up[2] */
-
-    /* up[1] */
-    buffer_256_256 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * 256 * 256 * 256,
-                                    nullptr, &err);
-    CHECK_ERROR_THROW(err);
-
-    buffer_256_512 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * 256 * 512 * 512,
-                                    nullptr, &err);
-    CHECK_ERROR_THROW(err);
-
-    up_1_res_blocks[0]->init();
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process 13");
-    err = up_1_res_blocks[0]->forward(buffer_512_256, nullptr, buffer_256_256,
-                                      0, nullptr,
-                                      1, &event[13], &event[14]);
-    CHECK_ERROR_THROW(err);
-    delete up_1_res_blocks[0];
-    up_1_res_blocks[0] = nullptr;
-
-    event_idx = 14;
-    for (int i = 1; i < 3; i++) {
-        auto &block = up_1_res_blocks[i];
-        block->init();
-        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process %d", event_idx);
-        err = block->forward(buffer_256_256, nullptr, buffer_256_256,
-                             0, nullptr,
-                             1, &event[event_idx], &event[event_idx + 1]);
-        CHECK_ERROR_THROW(err);
-        delete block;
-        block = nullptr;
-
-        event_idx++;
+/* tile 안의 위치 `i` 의 가중치. 이웃 tile 이 있는 쪽 가장자리 `ramp` 픽셀은 선형으로 줄임 */
+static float blendWeight(size_t i, size_t size, size_t ramp, bool first, bool last) {
+    float weight = 1.f;
+    if (!first) {
+        weight = std::min(weight, (static_cast<float>(i) + 0.5f) / static_cast<float>(ramp));
     }
-
-    up_1_up_sample->init();
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process 16");
-    err = up_1_up_sample->forward(buffer_256_256, buffer_256_512,
-                                  1, &event[16], &event[17]);
-    CHECK_ERROR_THROW(err);
-    delete up_1_up_sample;
-    up_1_up_sample = nullptr;
-
-    // test_up_1.npy max diff: 0.00213623046875000000
-    // util::testBuffer(cmdQueue, buffer_256_512, "decoder/test/test_up_1.npy");
-    /* up[1] */
-
-    /* up[0] */
-    buffer_128_512 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * 128 * 512 * 512,
-                                    nullptr, &err);
-    CHECK_ERROR_THROW(err);
-
-    up_0_res_blocks[0]->init();
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process 17");
-    err = up_0_res_blocks[0]->forward(buffer_256_512, nullptr, buffer_128_512,
-                                      0, nullptr,
-                                      1, &event[17], &event[18]);
-    CHECK_ERROR_THROW(err);
-    delete up_0_res_blocks[0];
-    up_0_res_blocks[0] = nullptr;
-
-    event_idx = 18;
-    for (int i = 1; i < 3; i++) {
-        auto &block = up_0_res_blocks[i];
-        block->init();
-        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process %d", event_idx);
-        err = block->forward(buffer_128_512, nullptr, buffer_128_512,
-                             0, nullptr,
-                             1, &event[event_idx], &event[event_idx + 1]);
-        CHECK_ERROR_THROW(err);
-        delete block;
-        block = nullptr;
-
-        event_idx++;
+    if (!last) {
+        weight = std::min(weight,
+                          (static_cast<float>(size - i) - 0.5f) / static_cast<float>(ramp));
     }
+    return weight;
+}
 
-    // test_up_0.npy max diff: 0.00390625000000000000
-    // util::testBuffer(cmdQueue, buffer_128_512, "decoder/test/test_up_0.npy");
-    /* up[0] */
-    /* up */
-
-    /* out */
-    buffer_3_512 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                  sizeof(float) * 3 * 512 * 512,
-                                  nullptr, &err);
-    CHECK_ERROR_THROW(err);
-
-    out_group_norm->init();
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process 20");
-    err = out_group_norm->forward(buffer_128_512, buffer_128_512,
-                                  1, &event[20], &event[21]);
-    CHECK_ERROR_THROW(err);
-    delete out_group_norm;
-    out_group_norm = nullptr;
-
-    err = clSetKernelArg(utilKernel->silu, 0, sizeof(cl_mem), &buffer_128_512);
-    err |= clSetKernelArg(utilKernel->silu, 1, sizeof(cl_mem), &buffer_128_512);
-    CHECK_ERROR_THROW(err);
-
-    size_t outWorkSize[3] = {128 * 512 * 512};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->silu, 1, nullptr,
-                                 outWorkSize, nullptr,
-                                 1, &event[21], &event[22]);
-    CHECK_ERROR_THROW(err);
-
-    out_conv2d->init();
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "process 21");
-    err = out_conv2d->forward(buffer_128_512, buffer_3_512,
-                              1, &event[22], &event[23]);
+std::vector<float> Decoder::decodeTiles(cl_mem bufferMid, cl_event eventMid) {
+    cl_int err;
+    auto &mid = graph.getTensor(midId);
+    auto &tile = tileGraph.getTensor(tileInputId);
+    auto &out = tileGraph.getTensor(outputId);
+    auto scale = out.height / tile.height;
+    auto imageHeight = mid.height * scale;
+    auto imageWidth = mid.width * scale;
+    auto ramp = std::max<size_t>(1, DECODER_TILE_OVERLAP * scale);
+
+    auto rows = tileOffsets(mid.height, tile.height, DECODER_TILE_OVERLAP);
+    auto cols = tileOffsets(mid.width, tile.width, DECODER_TILE_OVERLAP);
+
+    std::vector<float> result(out.channels * imageHeight * imageWidth, 0.f);
+    std::vector<float> weights(imageHeight * imageWidth, 0.f);
+    std::vector<float> tileResult(out.channels * out.height * out.width);
+
+    cl_mem bufferTile = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                       sizeof(float) * tile.channels * tile.height * tile.width,
+                                       nullptr, &err);
     CHECK_ERROR_THROW(err);
-    delete out_conv2d;
-    out_conv2d = nullptr;
 
-    // test_out.npy max diff: 0.00000357627868652344
-    // util::testBuffer(cmdQueue, buffer_3_512, "decoder/test/test_out.npy");
-    /* out */
-    /* Decoder */
-
-    /* result */
-    std::vector<float> result(3 * 512 * 512);
-    err = clEnqueueReadBuffer(cmdQueue, buffer_3_512, CL_FALSE, 0,
-                              sizeof(float) * result.size(), result.data(),
-                              1, &event[23], nullptr);
-    CHECK_ERROR_THROW(err);
-    /* result */
+    /* 중간에 throw 해도 bufferTile, pin 된 tileGraph weight 는 정리 */
+    try {
+        /* tile 마다 weight 를 다시 load 하지 않도록 */
+        tileGraph.load(0, tileGraph.size(), true);
+
+        for (auto y0: rows) {
+            for (auto x0: cols) {
+                Tracer::Scope scope("tile");
+                cl_event eventCopy, eventOut;
+                size_t srcOrigin[3] = {sizeof(float) * x0, y0, 0};
+                size_t dstOrigin[3] = {0, 0, 0};
+                size_t region[3] = {sizeof(float) * tile.width, tile.height, tile.channels};
+                err = clEnqueueCopyBufferRect(cmdQueue, bufferMid, bufferTile,
+                                              srcOrigin, dstOrigin, region,
+                                              sizeof(float) * mid.width,
+                                              sizeof(float) * mid.width * mid.height,
+                                              sizeof(float) * tile.width,
+                                              sizeof(float) * tile.width * tile.height,
+                                              1, &eventMid, &eventCopy);
+                CHECK_ERROR_THROW(err);
+                Tracer::getInstance().record("copy_buffer_rect", eventCopy);
+
+                auto bufferOut = tileGraph.run({bufferTile}, {eventCopy}, outputId, &eventOut);
+                err = clEnqueueReadBuffer(cmdQueue, bufferOut, CL_TRUE, 0,
+                                          sizeof(float) * tileResult.size(), tileResult.data(),
+                                          1, &eventOut, nullptr);
+                clReleaseEvent(eventCopy);
+                clReleaseEvent(eventOut);
+                clReleaseMemObject(bufferOut);
+                CHECK_ERROR_THROW(err);
+
+                /* 가중치 합으로 섞음 */
+                auto top = y0 * scale;
+                auto left = x0 * scale;
+                for (size_t i = 0; i < out.height; i++) {
+                    auto wy = blendWeight(i, out.height, ramp, y0 == 0,
+                                          y0 + tile.height == mid.height);
+                    for (size_t j = 0; j < out.width; j++) {
+                        auto w = wy * blendWeight(j, out.width, ramp, x0 == 0,
+                                                  x0 + tile.width == mid.width);
+                        auto index = (top + i) * imageWidth + (left + j);
+                        weights[index] += w;
+                        for (size_t c = 0; c < out.channels; c++) {
+                            result[c * imageHeight * imageWidth + index] +=
+                                    w * tileResult[(c * out.height + i) * out.width + j];
+                        }
+                    }
+                }
+            }
+        }
+    } catch (...) {
+        tileGraph.unload(0, tileGraph.size());
+        clReleaseMemObject(bufferTile);
+        throw;
+    }
 
-    clFinish(cmdQueue);
+    tileGraph.unload(0, tileGraph.size());
+    clReleaseMemObject(bufferTile);
 
-    for (auto &e: event) {
-        clReleaseEvent(e);
+    for (size_t c = 0; c < out.channels; c++) {
+        for (size_t index = 0; index < imageHeight * imageWidth; index++) {
+            result[c * imageHeight * imageWidth + index] /= weights[index];
+        }
     }
-    clReleaseMemObject(bufferX);
-    clReleaseMemObject(buffer_4_64);
-    clReleaseMemObject(buffer_512_64);
-    clReleaseMemObject(buffer_512_128);
-    clReleaseMemObject(buffer_512_256);
-    clReleaseMemObject(buffer_256_256);
-    clReleaseMemObject(buffer_256_512);
-    clReleaseMemObject(buffer_128_512);
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "decode %ldx%ld tiles (%ldx%ld, overlap %d)",
+                        rows.size(), cols.size(), tile.height, tile.width,
+                        DECODER_TILE_OVERLAP);
     return result;
 }
 
 void Decoder::test(const std::vector<float> &x) {
     cl_int err;
     cl_event event[2];
-    cl_mem bufferX, buffer_512_64;
+    cl_mem bufferX, bufferOut;
 
     bufferX = clCreateBuffer(context, CL_MEM_READ_ONLY,
                              sizeof(float) * x.size(),
@@ -588,23 +310,19 @@ void Decoder::test(const std::vector<float> &x) {
                                0, nullptr, &event[0]);
     CHECK_ERROR_THROW(err);
 
-    buffer_512_64 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 512 * 64 * 64,
-                                   nullptr, &err);
-    CHECK_ERROR_THROW(err);
-
     /* test logic */
-    mid_attn_block->init();
-    err = mid_attn_block->forward(bufferX, buffer_512_64,
-                                  1, &event[0], &event[1]);
-    CHECK_ERROR_THROW(err);
+    ModelGraph testGraph(context, cmdQueue, deviceId, assetManager);
+    auto input = testGraph.input(512, height, width);
+    auto output = testGraph.attnBlock("mid/attn_block", "decoder/mid/decoder_mid_attn_1", input);
+    bufferOut = testGraph.run({bufferX}, {event[0]}, output, &event[1]);
+    clWaitForEvents(1, &event[1]);
     /* test logic */
 
-    util::testBuffer(cmdQueue, buffer_512_64, "decoder/test/test_mid_attn_1.npy");
+    util::testBuffer(cmdQueue, bufferOut, "decoder/test/test_mid_attn_1.npy");
 
     for (auto &e: event) {
         clReleaseEvent(e);
     }
     clReleaseMemObject(bufferX);
-    clReleaseMemObject(buffer_512_64);
-}
\ No newline at end of file
+    clReleaseMemObject(bufferOut);
+}
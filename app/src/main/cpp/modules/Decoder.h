@@ -7,25 +7,17 @@
 
 #include <android/asset_manager_jni.h>
 #include <vector>
-#include "nn/Conv2D.h"
-#include "nn/ResBlock.h"
-#include "nn/AttnBlock.h"
-#include "nn/UpSample.h"
-#include "nn/GroupNorm.h"
+#include "ModelGraph.h"
 
 #define CL_TARGET_OPENCL_VERSION 200
 
 #include "CL/opencl.h"
-#include "kernel/unit/LinearKernel.h"
-#include "kernel/unit/UtilKernel.h"
-#include "kernel/unit/ConvKernel.h"
-#include "kernel/unit/GroupNormKernel.h"
-#include "kernel/unit/UpSampleKernel.h"
 
 class Decoder {
 public:
+    /* `height`, `width`: latent 크기 (image / 8) */
     Decoder(cl_context context, cl_command_queue cmdQueue, cl_device_id deviceId,
-            AAssetManager *assetManager);
+            AAssetManager *assetManager, size_t height = 64, size_t width = 64);
 
     ~Decoder();
 
@@ -34,38 +26,32 @@ public:
     void test(const std::vector<float> &x);
 
 private:
-    cl_context context;
-    cl_command_queue cmdQueue;
-
-    Conv2D *post_quant_conv2d;
-
-    Conv2D *in_conv2d;
-
-    ResBlock *mid_res_block_1;
+    /* level table (Decoder.cpp) 을 graph 로 */
+    void build();
 
-    AttnBlock *mid_attn_block;
+    /* DECODER_TILE_MODE: mid 출력을 겹치는 tile 로 잘라 tileGraph 실행 후 섞음 */
+    std::vector<float> decodeTiles(cl_mem bufferMid, cl_event eventMid);
 
-    ResBlock *mid_res_block_2;
+    /* 길이 `size` 를 덮는 `tile` 크기 구간의 시작 위치 (이웃 구간과 `overlap` 이상 겹침) */
+    static std::vector<size_t> tileOffsets(size_t size, size_t tile, size_t overlap);
 
-    ResBlock *up_3_res_blocks[3]{};
-    UpSample *up_3_up_sample;
-
-    ResBlock *up_2_res_blocks[3]{};
-    UpSample *up_2_up_sample;
-
-    ResBlock *up_1_res_blocks[3]{};
-    UpSample *up_1_up_sample;
+    cl_context context;
+    cl_command_queue cmdQueue;
+    cl_device_id deviceId;
+    AAssetManager *assetManager;
 
-    ResBlock *up_0_res_blocks[3]{};
+    size_t height;
+    size_t width;
 
-    GroupNorm *out_group_norm;
-    Conv2D *out_conv2d;
+    /* post_quant_conv ~ mid (전체 latent) */
+    ModelGraph graph;
+    /* up ~ out (DECODER_TILE_MODE 이면 tile 마다, 아니면 전체) */
+    ModelGraph tileGraph;
 
-    std::shared_ptr<LinearKernel> linearKernel;
-    std::shared_ptr<UtilKernel> utilKernel;
-    std::shared_ptr<ConvKernel> convKernel;
-    std::shared_ptr<GroupNormKernel> groupNormKernel;
-    std::shared_ptr<UpSampleKernel> upSampleKernel;
+    int inputId;
+    int midId;
+    int tileInputId;
+    int outputId;
 };
 
 
@@ -0,0 +1,196 @@
+//
+// Created by 구현우 on 2024/07/26.
+//
+
+#include "EmbeddingCache.h"
+#include "setting.h"
+
+#include <android/log.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#define LOG_TAG "EMBEDDING_CACHE"
+
+#define MEDIA_PATH "/sdcard/Android/media/com.example.myopencl/"
+
+/* "EMB1", 파일 형식이 바뀌면 올림 */
+#define FILE_MAGIC 0x31424d45u
+
+EmbeddingCache &EmbeddingCache::getInstance() {
+    static EmbeddingCache instance;
+    return instance;
+}
+
+EmbeddingCache::EmbeddingCache()
+        : capacity(EMBEDDING_CACHE_MODE >= 1 ? EMBEDDING_CACHE_SIZE : 0),
+          useDisk(EMBEDDING_CACHE_MODE >= 2) {
+    if (useDisk) {
+        mkdir(MEDIA_PATH "embedding", 0777);
+    }
+}
+
+/* FNV-1a (64 bit) */
+uint64_t EmbeddingCache::hash(const std::vector<long> &token) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (auto id: token) {
+        auto value = static_cast<uint64_t>(id);
+        for (int i = 0; i < 8; i++) {
+            h ^= (value >> (i * 8)) & 0xff;
+            h *= 0x100000001b3ull;
+        }
+    }
+    return h;
+}
+
+std::string EmbeddingCache::path(uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return std::string(MEDIA_PATH "embedding/") + name;
+}
+
+bool EmbeddingCache::get(const std::vector<long> &token, std::vector<float> *condition) {
+    if (capacity == 0 && !useDisk) {
+        return false;
+    }
+    auto key = hash(token);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end() && it->second->token == token) {
+            entries.splice(entries.begin(), entries, it->second);
+            *condition = it->second->condition;
+            memoryHits++;
+            return true;
+        }
+    }
+
+    if (useDisk && load(key, token, condition)) {
+        diskHits++;
+        std::lock_guard<std::mutex> lock(mutex);
+        insert(key, token, *condition);
+        return true;
+    }
+    misses++;
+    return false;
+}
+
+void EmbeddingCache::put(const std::vector<long> &token, const std::vector<float> &condition) {
+    if (capacity == 0 && !useDisk) {
+        return;
+    }
+    auto key = hash(token);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        insert(key, token, condition);
+    }
+    if (useDisk) {
+        save(key, token, condition);
+    }
+}
+
+void EmbeddingCache::insert(uint64_t key, const std::vector<long> &token,
+                            const std::vector<float> &condition) {
+    if (capacity == 0) {
+        return;
+    }
+    auto it = index.find(key);
+    if (it != index.end()) {
+        /* 같은 token 이면 갱신, hash 충돌이면 교체 */
+        entries.erase(it->second);
+        index.erase(it);
+    }
+    entries.push_front(Entry{key, token, condition});
+    index[key] = entries.begin();
+    while (entries.size() > capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
+
+void EmbeddingCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+}
+
+/* magic, token 수, token ids (int64), condition 크기, condition (float) */
+bool EmbeddingCache::load(uint64_t key, const std::vector<long> &token,
+                          std::vector<float> *condition) {
+    std::ifstream file(path(key), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    uint32_t magic = 0;
+    uint64_t numTokens = 0, size = 0;
+    file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char *>(&numTokens), sizeof(numTokens));
+    if (!file || magic != FILE_MAGIC || numTokens != token.size()) {
+        return false;
+    }
+    for (auto id: token) {
+        int64_t stored;
+        file.read(reinterpret_cast<char *>(&stored), sizeof(stored));
+        if (!file || stored != static_cast<int64_t>(id)) {
+            return false;
+        }
+    }
+    file.read(reinterpret_cast<char *>(&size), sizeof(size));
+    if (!file || size == 0 || size > (1u << 26)) {
+        return false;
+    }
+    std::vector<float> result(size);
+    file.read(reinterpret_cast<char *>(result.data()), sizeof(float) * size);
+    if (!file) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "truncated %s", path(key).c_str());
+        return false;
+    }
+    *condition = std::move(result);
+    return true;
+}
+
+void EmbeddingCache::save(uint64_t key, const std::vector<long> &token,
+                          const std::vector<float> &condition) {
+    auto target = path(key);
+    auto temp = target + ".tmp";
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to open %s", temp.c_str());
+        return;
+    }
+    uint32_t magic = FILE_MAGIC;
+    uint64_t numTokens = token.size(), size = condition.size();
+    file.write(reinterpret_cast<const char *>(&magic), sizeof(magic));
+    file.write(reinterpret_cast<const char *>(&numTokens), sizeof(numTokens));
+    for (auto id: token) {
+        auto stored = static_cast<int64_t>(id);
+        file.write(reinterpret_cast<const char *>(&stored), sizeof(stored));
+    }
+    file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    file.write(reinterpret_cast<const char *>(condition.data()), sizeof(float) * size);
+    file.close();
+    if (!file || rename(temp.c_str(), target.c_str()) != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to write %s", target.c_str());
+        remove(temp.c_str());
+    }
+}
+
+std::string EmbeddingCache::getStats() {
+    size_t size;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size = entries.size();
+    }
+    auto hits = memoryHits.load() + diskHits.load();
+    auto total = hits + misses.load();
+
+    std::ostringstream oss;
+    oss.setf(std::ios::fixed);
+    oss.precision(3);
+    oss << "{\"entries\": " << size << ", \"capacity\": " << capacity
+        << ", \"memory_hits\": " << memoryHits.load() << ", \"disk_hits\": " << diskHits.load()
+        << ", \"misses\": " << misses.load()
+        << ", \"hit_rate\": " << (total > 0 ? static_cast<double>(hits) / total : 0.0) << "}";
+    return oss.str();
+}
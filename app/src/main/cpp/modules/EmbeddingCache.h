@@ -0,0 +1,70 @@
+//
+// Created by 구현우 on 2024/07/26.
+//
+
+#ifndef MY_OPENCL_EMBEDDINGCACHE_H
+#define MY_OPENCL_EMBEDDINGCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * token ids -> condition (TextEncoder 출력) cache (EMBEDDING_CACHE_MODE).
+ * key 는 token ids 의 hash (content-addressed), 충돌은 저장한 token ids 와 비교.
+ * memory tier : LRU (EMBEDDING_CACHE_SIZE), disk tier : MEDIA_PATH/embedding/<hash>.bin (memory 에서 밀려나도 유지).
+ * JNI encode 와 Pipeline encode stage 가 공유 (thread safe).
+ */
+class EmbeddingCache {
+public:
+    static EmbeddingCache &getInstance();
+
+    /* @return: hit 이면 true (`condition` 에 복사) */
+    bool get(const std::vector<long> &token, std::vector<float> *condition);
+
+    void put(const std::vector<long> &token, const std::vector<float> &condition);
+
+    /* memory tier 만 비움 (counter 유지) */
+    void clear();
+
+    /* hit (memory / disk), miss, entry 수 (JSON) */
+    std::string getStats();
+
+private:
+    struct Entry {
+        uint64_t key;
+        std::vector<long> token;
+        std::vector<float> condition;
+    };
+
+    EmbeddingCache();
+
+    static uint64_t hash(const std::vector<long> &token);
+
+    static std::string path(uint64_t key);
+
+    bool load(uint64_t key, const std::vector<long> &token, std::vector<float> *condition);
+
+    void save(uint64_t key, const std::vector<long> &token, const std::vector<float> &condition);
+
+    /* lock 안에서. 앞이 최근 */
+    void insert(uint64_t key, const std::vector<long> &token, const std::vector<float> &condition);
+
+    size_t capacity;
+    bool useDisk;
+
+    std::list<Entry> entries;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    std::mutex mutex;
+
+    std::atomic<size_t> memoryHits{0};
+    std::atomic<size_t> diskHits{0};
+    std::atomic<size_t> misses{0};
+};
+
+
+#endif //MY_OPENCL_EMBEDDINGCACHE_H
@@ -0,0 +1,142 @@
+//
+// Created by 구현우 on 2024/07/18.
+//
+
+#include "Graph.h"
+
+#include <algorithm>
+#include <android/log.h>
+#include <numeric>
+
+#define LOG_TAG "GRAPH"
+
+#define CHECK_ERROR(err) \
+    if (err != CL_SUCCESS) { \
+      __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "[%s:%d] OpenCL error %d\n", __FILE__, __LINE__, err); \
+      return err;                     \
+    }                    \
+
+Graph::Graph(std::vector<cl_command_queue> cmdQueues) : cmdQueues(std::move(cmdQueues)) {}
+
+Graph::~Graph() {
+    for (auto &node: nodes) {
+        if (node.event != nullptr) {
+            clReleaseEvent(node.event);
+        }
+    }
+    for (auto event: retained) {
+        clReleaseEvent(event);
+    }
+}
+
+void Graph::input(cl_mem tensor, cl_uint num_events_in_list, const cl_event *event_wait_list) {
+    auto &state = tensors[tensor];
+    for (cl_uint i = 0; i < num_events_in_list; i++) {
+        clRetainEvent(event_wait_list[i]);
+        retained.push_back(event_wait_list[i]);
+        state.externals.push_back(event_wait_list[i]);
+    }
+}
+
+void Graph::addDep(Node &node, long dep) {
+    if (dep < 0) {
+        return;
+    }
+    if (std::find(node.deps.begin(), node.deps.end(), dep) == node.deps.end()) {
+        node.deps.push_back(dep);
+    }
+}
+
+void Graph::add(const std::string &name, const std::vector<cl_mem> &inputs,
+                const std::vector<cl_mem> &outputs, Op op) {
+    size_t index = nodes.size();
+    Node node;
+    node.name = name;
+    node.op = std::move(op);
+
+    /* RAW */
+    for (auto tensor: inputs) {
+        auto &state = tensors[tensor];
+        addDep(node, state.writer);
+        node.externals.insert(node.externals.end(), state.externals.begin(), state.externals.end());
+    }
+    /* WAW, WAR */
+    for (auto tensor: outputs) {
+        auto &state = tensors[tensor];
+        addDep(node, state.writer);
+        for (auto reader: state.readers) {
+            addDep(node, static_cast<long>(reader));
+        }
+        node.externals.insert(node.externals.end(), state.externals.begin(), state.externals.end());
+    }
+
+    for (auto tensor: inputs) {
+        tensors[tensor].readers.push_back(index);
+    }
+    for (auto tensor: outputs) {
+        auto &state = tensors[tensor];
+        state.writer = static_cast<long>(index);
+        state.externals.clear();
+        state.readers.clear();
+    }
+
+    for (auto dep: node.deps) {
+        node.depth = std::max(node.depth, nodes[dep].depth + 1);
+    }
+    nodes.push_back(std::move(node));
+}
+
+cl_int Graph::run() {
+    cl_int err;
+    std::vector<size_t> order(nodes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return nodes[a].depth < nodes[b].depth;
+    });
+
+    for (auto index: order) {
+        auto &node = nodes[index];
+
+        /* 아직 이어지지 않은 가장 깊은 dependency 의 queue 를 이어받음 */
+        long parent = -1;
+        for (auto dep: node.deps) {
+            if (!nodes[dep].claimed && (parent < 0 || nodes[dep].depth > nodes[parent].depth)) {
+                parent = static_cast<long>(dep);
+            }
+        }
+        if (parent >= 0) {
+            nodes[parent].claimed = true;
+            node.queue = nodes[parent].queue;
+        } else {
+            node.queue = nextQueue++ % cmdQueues.size();
+        }
+
+        std::vector<cl_event> waitList(node.externals);
+        for (auto dep: node.deps) {
+            waitList.push_back(nodes[dep].event);
+        }
+
+        err = node.op(cmdQueues[node.queue], waitList.size(),
+                      waitList.empty() ? nullptr : waitList.data(), &node.event);
+        if (err != CL_SUCCESS) {
+            node.event = nullptr;
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "op(%s) failed", node.name.c_str());
+        }
+        CHECK_ERROR(err);
+    }
+    return CL_SUCCESS;
+}
+
+cl_int Graph::getEvent(cl_mem tensor, cl_event *event) {
+    auto it = tensors.find(tensor);
+    if (it == tensors.end() || it->second.writer < 0) {
+        return CL_INVALID_MEM_OBJECT;
+    }
+    auto &node = nodes[it->second.writer];
+    if (node.event == nullptr) {
+        return CL_INVALID_EVENT;
+    }
+    clRetainEvent(node.event);
+    *event = node.event;
+    return CL_SUCCESS;
+}
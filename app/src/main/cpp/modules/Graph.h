@@ -0,0 +1,79 @@
+//
+// Created by 구현우 on 2024/07/18.
+//
+
+#ifndef MY_OPENCL_GRAPH_H
+#define MY_OPENCL_GRAPH_H
+
+#define CL_TARGET_OPENCL_VERSION 200
+
+#include "CL/opencl.h"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * layer 내부 op 의 dependency graph.
+ * op 는 읽고 쓰는 tensor (cl_mem) 와 함께 선언 순서대로 add 하고,
+ * RAW / WAR / WAW 관계로 event wait list 를 만들어서 run 에서 한 번에 issue.
+ * 선언 순서가 아니라 depth (dependency 깊이) 순서로 enqueue 하므로
+ * 서로 독립인 branch (e.g. ResBlock 의 embedding / in_layers / skip) 의 첫 kernel 이 먼저 queue 에 들어감.
+ *
+ * queue 가 여러 개이면 branch 마다 round-robin 으로 배정 (chain 은 같은 queue 유지).
+ * child layer 의 forward 는 자기 cmdQueue 를 쓰므로 배정된 queue 는 op 가 직접 enqueue 하는 kernel 에만 적용.
+ */
+class Graph {
+public:
+    /* (queue, num_events_in_list, event_wait_list, event) */
+    typedef std::function<cl_int(cl_command_queue, cl_uint, const cl_event *, cl_event *)> Op;
+
+    explicit Graph(std::vector<cl_command_queue> cmdQueues);
+
+    ~Graph();
+
+    /* 외부에서 쓴 tensor, `event_wait_list` 이후 사용 가능 (retain) */
+    void input(cl_mem tensor, cl_uint num_events_in_list, const cl_event *event_wait_list);
+
+    /* in-place op 는 같은 tensor 를 inputs, outputs 모두에 */
+    void add(const std::string &name, const std::vector<cl_mem> &inputs,
+             const std::vector<cl_mem> &outputs, Op op);
+
+    /* 모든 op 를 enqueue, 첫 error 에서 중단 */
+    cl_int run();
+
+    /* `tensor` 를 마지막으로 쓴 op 의 event (retain, 호출한 쪽에서 release) */
+    cl_int getEvent(cl_mem tensor, cl_event *event);
+
+private:
+    struct Node {
+        std::string name;
+        Op op;
+        std::vector<size_t> deps;
+        std::vector<cl_event> externals;
+        size_t depth = 0;
+        size_t queue = 0;
+        bool claimed = false;
+        cl_event event = nullptr;
+    };
+
+    struct Tensor {
+        /* 마지막으로 쓴 node, 없으면 externals */
+        long writer = -1;
+        std::vector<cl_event> externals;
+        /* 마지막 write 이후 읽은 node */
+        std::vector<size_t> readers;
+    };
+
+    static void addDep(Node &node, long dep);
+
+    std::vector<cl_command_queue> cmdQueues;
+    std::vector<Node> nodes;
+    std::map<cl_mem, Tensor> tensors;
+    std::vector<cl_event> retained;
+    size_t nextQueue = 0;
+};
+
+
+#endif //MY_OPENCL_GRAPH_H
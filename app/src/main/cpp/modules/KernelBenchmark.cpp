@@ -0,0 +1,1738 @@
+//
+// Created by 구현우 on 2024/07/08.
+//
+
+#include "KernelBenchmark.h"
+#include "util.h"
+
+#include <algorithm>
+#include <android/log.h>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#define LOG_TAG "KERNEL_BENCHMARK"
+
+#define MEDIA_PATH "/sdcard/Android/media/com.example.myopencl/"
+
+#define BENCHMARK_WARM_UP 1
+#define BENCHMARK_REPEAT 5
+
+#define WORK_GROUP_SIZE 64
+#define WIDTH 4
+
+#define CONTEXT_LENGTH 77
+#define EMBEDDING_SIZE 1024
+#define VOCAB_SIZE 49408
+#define NUM_GROUPS 32
+
+/* causal_attention (multi_head_attention.cl) */
+#define CAUSAL_HEAD_DIM 64
+#define CAUSAL_TILE 16
+
+/* strided_batch_matmul (util.cl) : STRIDED_TILE_M/N, STRIDED_REG_M/N */
+#define STRIDED_TILE 64
+#define STRIDED_REG 4
+
+#define CHECK_ERROR_THROW(err) \
+    if (err != CL_SUCCESS) { \
+      __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "[%s:%d] OpenCL error %d\n", __FILE__, __LINE__, err); \
+      throw std::runtime_error("OpenCL error."); \
+    }
+
+/* skip the rest of the case when arguments are not set */
+#define CHECK_ARG(err, kernel, model, shape) \
+    if (err != CL_SUCCESS) { \
+      skip(kernel, model, shape, err); \
+      releaseBuffers(); \
+      return; \
+    }
+
+/* first index of `sizes` which divides `size`, or -1 */
+static int findTile(size_t size, const std::vector<size_t> &sizes) {
+    for (int i = 0; i < sizes.size(); i++) {
+        if (size % sizes[i] == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* layout : (offset, batch stride, row stride, col stride) */
+static cl_int setStridedMatmulArgs(cl_kernel kernel, cl_mem *A, cl_mem *B, cl_mem *C, size_t M,
+                                   size_t N, size_t K, cl_int4 layoutA, cl_int4 layoutB,
+                                   cl_int4 layoutC, float scale) {
+    int m = static_cast<int>(M), n = static_cast<int>(N), k = static_cast<int>(K);
+    cl_int err = clSetKernelArg(kernel, 0, sizeof(cl_mem), A);
+    err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), B);
+    err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), C);
+    err |= clSetKernelArg(kernel, 3, sizeof(int), &m);
+    err |= clSetKernelArg(kernel, 4, sizeof(int), &n);
+    err |= clSetKernelArg(kernel, 5, sizeof(int), &k);
+    err |= clSetKernelArg(kernel, 6, sizeof(cl_int4), &layoutA);
+    err |= clSetKernelArg(kernel, 7, sizeof(cl_int4), &layoutB);
+    err |= clSetKernelArg(kernel, 8, sizeof(cl_int4), &layoutC);
+    err |= clSetKernelArg(kernel, 9, sizeof(float), &scale);
+    return err;
+}
+
+/* strided_batch_matmul global size of one dimension */
+static size_t stridedGlobalSize(size_t size) {
+    return (size + STRIDED_TILE - 1) / STRIDED_TILE * (STRIDED_TILE / STRIDED_REG);
+}
+
+KernelBenchmark::KernelBenchmark(cl_context context, cl_command_queue cmdQueue,
+                                 cl_device_id deviceId, AAssetManager *assetManager)
+        : context(context), cmdQueue(cmdQueue), deviceId(deviceId) {
+    linearKernel = std::make_shared<LinearKernel>(context, deviceId, assetManager);
+    convKernel = std::make_shared<ConvKernel>(context, deviceId, assetManager);
+    crossAttentionKernel = std::make_shared<CrossAttentionKernel>(context, deviceId,
+                                                                  assetManager);
+    multiHeadAttentionKernel = std::make_shared<MultiHeadAttentionKernel>(context, deviceId,
+                                                                          assetManager);
+    groupNormKernel = std::make_shared<GroupNormKernel>(context, deviceId, assetManager);
+    utilKernel = std::make_shared<UtilKernel>(context, deviceId, assetManager);
+
+    cl_int err = clGetDeviceInfo(deviceId, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong),
+                                 &maxAllocSize, nullptr);
+    CHECK_ERROR_THROW(err);
+}
+
+KernelBenchmark::~KernelBenchmark() {
+    releaseBuffers();
+}
+
+std::string KernelBenchmark::run() {
+    results.clear();
+
+    /* text encoder : (77, 1024), 16 heads */
+    benchmarkLinear("text_encoder", CONTEXT_LENGTH, 3 * EMBEDDING_SIZE, EMBEDDING_SIZE);
+    benchmarkLinear("text_encoder", CONTEXT_LENGTH, EMBEDDING_SIZE, EMBEDDING_SIZE);
+    benchmarkLinear("text_encoder", CONTEXT_LENGTH, 4 * EMBEDDING_SIZE, EMBEDDING_SIZE);
+    benchmarkLinear("text_encoder", CONTEXT_LENGTH, EMBEDDING_SIZE, 4 * EMBEDDING_SIZE);
+    benchmarkMultiHeadAttention("text_encoder", 16, CONTEXT_LENGTH, 64);
+    benchmarkElemwise("text_encoder", CONTEXT_LENGTH, EMBEDDING_SIZE);
+    benchmarkTokenEmbedding("text_encoder", CONTEXT_LENGTH, EMBEDDING_SIZE, VOCAB_SIZE);
+
+    /* unet : latent (4, 64, 64), (channels, height * width) of each level */
+    benchmarkLinear("unet", 1, 1280, 320);
+    benchmarkLinear("unet", 1, 1280, 1280);
+    std::vector<std::pair<size_t, size_t>> levels = {{320,  64 * 64},
+                                                     {640,  32 * 32},
+                                                     {1280, 16 * 16},
+                                                     {1280, 8 * 8}};
+    for (auto &level: levels) {
+        auto channels = level.first;
+        auto heightXwidth = level.second;
+        benchmarkLinear("unet", heightXwidth, channels, channels);
+        benchmarkLinear("unet", CONTEXT_LENGTH, channels, EMBEDDING_SIZE);
+        benchmarkLinear("unet", heightXwidth, channels * 8, channels);
+        benchmarkLinear("unet", heightXwidth, channels, channels * 4);
+        /* attn1 (self), attn2 (cross) */
+        benchmarkCrossAttention("unet", channels / 64, heightXwidth, heightXwidth, 64);
+        benchmarkCrossAttention("unet", channels / 64, heightXwidth, CONTEXT_LENGTH, 64);
+        /* ResBlock norm, SpatialTransformer norm (ACTIVATION_LAYOUT_MODE 1) */
+        benchmarkGroupNorm("unet", channels, heightXwidth, true);
+        benchmarkElemwise("unet", channels, heightXwidth);
+    }
+    benchmarkGroupNorm("unet", 640, 64 * 64);
+    benchmarkGroupNorm("unet", 960, 64 * 64);
+    benchmarkGroupNorm("unet", 1920, 16 * 16);
+    benchmarkGroupNorm("unet", 2560, 8 * 8);
+
+    /* in_channel, out_channel, input size, kernel size, stride */
+    std::vector<std::vector<size_t>> unetConvs = {
+            {4,    320,  64, 3, 1},
+            {320,  320,  64, 3, 1},
+            {320,  320,  64, 3, 2},
+            {320,  640,  32, 3, 1},
+            {640,  640,  32, 3, 1},
+            {640,  640,  32, 3, 2},
+            {640,  1280, 16, 3, 1},
+            {1280, 1280, 16, 3, 1},
+            {1280, 1280, 16, 3, 2},
+            {1280, 1280, 8,  3, 1},
+            {2560, 1280, 8,  3, 1},
+            {2560, 1280, 8,  1, 1},
+            {1920, 1280, 16, 3, 1},
+            {1920, 640,  32, 3, 1},
+            {960,  320,  64, 3, 1},
+            {960,  320,  64, 1, 1},
+            {320,  4,    64, 3, 1},
+    };
+    for (auto &conv: unetConvs) {
+        benchmarkConv2D("unet", conv[0], conv[1], conv[2], conv[3], static_cast<int>(conv[4]));
+    }
+    /* preview of the latent after each step */
+    benchmarkLatentPreview("unet", 4, 64 * 64);
+
+    /* decoder : latent (4, 64, 64) -> image (3, 512, 512) */
+    std::vector<std::vector<size_t>> decoderConvs = {
+            {4,   4,   64,  1, 1},
+            {4,   512, 64,  3, 1},
+            {512, 512, 64,  3, 1},
+            {512, 512, 64,  1, 1},
+            {512, 512, 128, 3, 1},
+            {512, 512, 256, 3, 1},
+            {512, 256, 256, 3, 1},
+            {512, 256, 256, 1, 1},
+            {256, 256, 256, 3, 1},
+            {256, 256, 512, 3, 1},
+            {256, 128, 512, 3, 1},
+            {256, 128, 512, 1, 1},
+            {128, 128, 512, 3, 1},
+            {128, 3,   512, 3, 1},
+    };
+    for (auto &conv: decoderConvs) {
+        benchmarkConv2D("decoder", conv[0], conv[1], conv[2], conv[3],
+                        static_cast<int>(conv[4]));
+    }
+    benchmarkAttnBlock("decoder", 512, 64 * 64);
+    benchmarkGroupNorm("decoder", 512, 64 * 64);
+    benchmarkGroupNorm("decoder", 512, 128 * 128);
+    benchmarkGroupNorm("decoder", 512, 256 * 256);
+    benchmarkGroupNorm("decoder", 256, 256 * 256);
+    benchmarkGroupNorm("decoder", 256, 512 * 512);
+    benchmarkGroupNorm("decoder", 128, 512 * 512);
+    benchmarkElemwise("decoder", 512, 64 * 64);
+    benchmarkElemwise("decoder", 256, 512 * 512);
+
+    auto json = toJson();
+    mkdir(MEDIA_PATH "benchmark", 0777);
+    std::ofstream file(MEDIA_PATH "benchmark/kernel_benchmark.json", std::ios::trunc);
+    if (file.is_open()) {
+        file << json;
+    } else {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to open %s",
+                            MEDIA_PATH "benchmark/kernel_benchmark.json");
+    }
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "run: %ld results", results.size());
+    return json;
+}
+
+/* filled with small constant. returns nullptr when `size` is larger than the device allows */
+cl_mem KernelBenchmark::createBuffer(size_t size) {
+    cl_int err;
+    if (size == 0 || sizeof(float) * size > maxAllocSize) {
+        return nullptr;
+    }
+    cl_mem buffer = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(float) * size, nullptr,
+                                   &err);
+    if (err != CL_SUCCESS) {
+        return nullptr;
+    }
+    float pattern = 0.01f;
+    err = clEnqueueFillBuffer(cmdQueue, buffer, &pattern, sizeof(float), 0,
+                              sizeof(float) * size, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        clReleaseMemObject(buffer);
+        return nullptr;
+    }
+    buffers.push_back(buffer);
+    return buffer;
+}
+
+void KernelBenchmark::releaseBuffers() {
+    if (!buffers.empty()) {
+        clFinish(cmdQueue);
+    }
+    for (auto buffer: buffers) {
+        clReleaseMemObject(buffer);
+    }
+    buffers.clear();
+}
+
+void KernelBenchmark::measure(const std::string &kernel, const std::string &model,
+                              const std::string &shape, cl_kernel clKernel, cl_uint work_dim,
+                              const size_t *globalWorkSize, const size_t *localWorkSize,
+                              double flops, double bytes) {
+    cl_int err;
+    double minTime = -1, sumTime = 0;
+
+    /* out of order queue : fill buffer must be done before the first launch */
+    clFinish(cmdQueue);
+    for (int i = 0; i < BENCHMARK_WARM_UP + BENCHMARK_REPEAT; i++) {
+        cl_event event;
+        err = clEnqueueNDRangeKernel(cmdQueue, clKernel, work_dim, nullptr, globalWorkSize,
+                                     localWorkSize, 0, nullptr, &event);
+        if (err != CL_SUCCESS) {
+            skip(kernel, model, shape, err);
+            return;
+        }
+        clWaitForEvents(1, &event);
+        auto time = util::getEventTime(event);
+        clReleaseEvent(event);
+        if (i < BENCHMARK_WARM_UP) {
+            continue;
+        }
+        sumTime += time;
+        if (minTime < 0 || time < minTime) {
+            minTime = time;
+        }
+    }
+
+    Result result = {kernel, model, shape, CL_SUCCESS, minTime, sumTime / BENCHMARK_REPEAT,
+                     flops, bytes};
+    results.push_back(result);
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "%s, %s, %s, %0.3f ms", model.c_str(),
+                        kernel.c_str(), shape.c_str(), minTime);
+}
+
+void KernelBenchmark::skip(const std::string &kernel, const std::string &model,
+                           const std::string &shape, cl_int err) {
+    Result result = {kernel, model, shape, err, 0, 0, 0, 0};
+    results.push_back(result);
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "%s, %s, %s, skip(%d)", model.c_str(),
+                        kernel.c_str(), shape.c_str(), err);
+}
+
+/*
+ * Linear.cpp forwardVersion0 ~ 6 tile size
+ */
+void KernelBenchmark::benchmarkLinear(const std::string &model, size_t M, size_t N, size_t K) {
+    cl_int err;
+    auto shape = "M=" + std::to_string(M) + " N=" + std::to_string(N) + " K=" + std::to_string(K);
+    double flops = 2.0 * M * N * K;
+    double bytes = sizeof(float) * (1.0 * M * K + 1.0 * N * K + N + 1.0 * M * N);
+    int _M = static_cast<int>(M), _N = static_cast<int>(N), _K = static_cast<int>(K);
+
+    auto input = createBuffer(M * K);
+    auto weight = createBuffer(N * K);
+    auto bias = createBuffer(N);
+    auto output = createBuffer(M * N);
+    if (input == nullptr || weight == nullptr || bias == nullptr || output == nullptr) {
+        skip("linear", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+        releaseBuffers();
+        return;
+    }
+
+    /* version 0 */
+    {
+        auto kernel = linearKernel->naive_linear;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &weight);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &bias);
+        err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+        err |= clSetKernelArg(kernel, 4, sizeof(int), &_K);
+        if (err == CL_SUCCESS) {
+            size_t globalWorkSize[2] = {M, N};
+            measure("linear/linear", model, shape, kernel, 2, globalWorkSize, nullptr, flops,
+                    bytes);
+        } else {
+            skip("linear/linear", model, shape, err);
+        }
+    }
+
+    /* version 1, reg_linear_v2 (no host path, same arguments without the local memory copy) */
+    std::vector<std::pair<std::string, cl_kernel>> regKernels = {
+            {"linear/reg_linear",    linearKernel->register_linear},
+            {"linear/reg_linear_v2", linearKernel->register_linear_v2},
+    };
+    for (auto &regKernel: regKernels) {
+        std::vector<size_t> tile_size_ms = {128, 77, 1};
+        std::vector<size_t> reg_size_ms = {8, 7, 1};
+        size_t reg_size_n = 8, tile_size_k = 16;
+        auto m_index = findTile(M, tile_size_ms);
+        auto n_index = findTile(N, {128, 64});
+        if (m_index < 0 || n_index < 0 || K % tile_size_k != 0) {
+            skip(regKernel.first, model, shape, CL_INVALID_VALUE);
+        } else {
+            auto kernel = regKernel.second;
+            cl_uchar tile_size_m = tile_size_ms[m_index];
+            cl_uchar reg_size_m = reg_size_ms[m_index];
+            cl_uchar tile_size_n = n_index == 0 ? 128 : 64;
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &weight);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &bias);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &_M);
+            err |= clSetKernelArg(kernel, 5, sizeof(int), &_N);
+            err |= clSetKernelArg(kernel, 6, sizeof(int), &_K);
+            err |= clSetKernelArg(kernel, 7, sizeof(cl_uchar), &reg_size_m);
+            err |= clSetKernelArg(kernel, 8, sizeof(cl_uchar), &tile_size_m);
+            err |= clSetKernelArg(kernel, 9, sizeof(cl_uchar), &tile_size_n);
+            err |= clSetKernelArg(kernel, 10, sizeof(float) * tile_size_m * tile_size_k, nullptr);
+            err |= clSetKernelArg(kernel, 11, sizeof(float) * tile_size_k * tile_size_n, nullptr);
+            if (err == CL_SUCCESS) {
+                size_t globalWorkSize[2] = {M / reg_size_m, N / reg_size_n};
+                size_t localWorkSize[2] = {static_cast<size_t>(tile_size_m / reg_size_m),
+                                           tile_size_n / reg_size_n};
+                measure(regKernel.first, model, shape, kernel, 2, globalWorkSize,
+                        localWorkSize, flops, bytes);
+            } else {
+                skip(regKernel.first, model, shape, err);
+            }
+        }
+    }
+
+    /* version 2, 3 */
+    {
+        auto m_index = findTile(M, {32, 11, 1});
+        size_t tile_size_m = std::vector<size_t>({32, 11, 1})[m_index];
+        size_t tile_size_n = 32;
+        std::vector<std::pair<std::string, cl_kernel>> kernels = {
+                {"linear/tile_linear",       linearKernel->tile_linear},
+                {"linear/tile_reg_n_linear", linearKernel->tile_reg_n_linear},
+        };
+        for (int i = 0; i < kernels.size(); i++) {
+            auto kernel = kernels[i].second;
+            size_t reg_size_n = i == 0 ? 1 : 2;
+            if (N % tile_size_n != 0) {
+                skip(kernels[i].first, model, shape, CL_INVALID_VALUE);
+                continue;
+            }
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &weight);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &bias);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &_K);
+            if (err != CL_SUCCESS) {
+                skip(kernels[i].first, model, shape, err);
+                continue;
+            }
+            size_t globalWorkSize[2] = {M, N / reg_size_n};
+            size_t localWorkSize[2] = {tile_size_m, tile_size_n / reg_size_n};
+            measure(kernels[i].first, model, shape, kernel, 2, globalWorkSize, localWorkSize,
+                    flops, bytes);
+        }
+    }
+
+    /* version 4 */
+    {
+        auto m_index = findTile(M, {32, 11, 1});
+        auto n_index = findTile(N, {128, 64});
+        size_t reg_size_n = 8;
+        if (n_index < 0) {
+            skip("linear/tile_reg_n_vector_linear", model, shape, CL_INVALID_VALUE);
+        } else {
+            auto kernel = linearKernel->tile_reg_n_vector_linear;
+            size_t tile_size_m = std::vector<size_t>({32, 11, 1})[m_index];
+            size_t tile_size_n = std::vector<size_t>({128, 64})[n_index];
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &weight);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &bias);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &_K);
+            if (err == CL_SUCCESS) {
+                size_t globalWorkSize[2] = {M, N / reg_size_n};
+                size_t localWorkSize[2] = {tile_size_m, tile_size_n / reg_size_n};
+                measure("linear/tile_reg_n_vector_linear", model, shape, kernel, 2,
+                        globalWorkSize, localWorkSize, flops, bytes);
+            } else {
+                skip("linear/tile_reg_n_vector_linear", model, shape, err);
+            }
+        }
+    }
+
+    /* version 5 */
+    {
+        auto m_index = findTile(M, {32, 11, 1});
+        size_t reg_size_m = 2, reg_size_n = 4, tile_size_n = 128;
+        if (N % tile_size_n != 0) {
+            skip("linear/tile_reg_m_n_vector_linear", model, shape, CL_INVALID_VALUE);
+        } else {
+            auto kernel = linearKernel->tile_reg_m_n_vector_linear;
+            size_t tile_size_m = std::vector<size_t>({32, 11, 1})[m_index];
+            auto globalWorkSizeM = M / reg_size_m;
+            auto localWorkSizeM = tile_size_m / reg_size_m;
+            if (tile_size_m % reg_size_m != 0) {
+                localWorkSizeM = tile_size_m / reg_size_m + 1;
+                globalWorkSizeM = (M / tile_size_m) * localWorkSizeM;
+            }
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &weight);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &bias);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &_M);
+            err |= clSetKernelArg(kernel, 5, sizeof(int), &_K);
+            if (err == CL_SUCCESS) {
+                size_t globalWorkSize[2] = {globalWorkSizeM, N / reg_size_n};
+                size_t localWorkSize[2] = {localWorkSizeM, tile_size_n / reg_size_n};
+                measure("linear/tile_reg_m_n_vector_linear", model, shape, kernel, 2,
+                        globalWorkSize, localWorkSize, flops, bytes);
+            } else {
+                skip("linear/tile_reg_m_n_vector_linear", model, shape, err);
+            }
+        }
+    }
+
+    /* version 6 : weight is permuted to (K, N) in advance */
+    {
+        size_t reg_size_m = 4, tile_size_m = 40, tile_size_n = 128;
+        size_t paddingM = M;
+        if (paddingM % reg_size_m != 0) {
+            paddingM = (paddingM / reg_size_m + 1) * reg_size_m;
+        }
+        if (paddingM % tile_size_m != 0 || N % tile_size_n != 0) {
+            skip("linear/tile_reg_m_vector_n_linear", model, shape, CL_INVALID_VALUE);
+        } else {
+            auto kernel = linearKernel->tile_reg_m_vector_n_linear;
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &weight);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &bias);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &_M);
+            err |= clSetKernelArg(kernel, 5, sizeof(int), &_N);
+            err |= clSetKernelArg(kernel, 6, sizeof(int), &_K);
+            if (err == CL_SUCCESS) {
+                size_t globalWorkSize[3] = {1, paddingM / reg_size_m, N / WIDTH};
+                size_t localWorkSize[3] = {1, tile_size_m / reg_size_m, tile_size_n / WIDTH};
+                measure("linear/tile_reg_m_vector_n_linear", model, shape, kernel, 3,
+                        globalWorkSize, localWorkSize, flops, bytes);
+            } else {
+                skip("linear/tile_reg_m_vector_n_linear", model, shape, err);
+            }
+        }
+    }
+
+    /* util permute3D : weight permute of version 6 */
+    {
+        auto kernel = utilKernel->permute3D;
+        int permuteWeight[3] = {0, 2, 1};
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &weight);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &output);
+        err |= clSetKernelArg(kernel, 2, sizeof(int), &permuteWeight[0]);
+        err |= clSetKernelArg(kernel, 3, sizeof(int), &permuteWeight[1]);
+        err |= clSetKernelArg(kernel, 4, sizeof(int), &permuteWeight[2]);
+        if (err == CL_SUCCESS && M * N >= N * K) {
+            size_t globalWorkSize[3] = {1, N, K};
+            measure("util/permute3D", model, shape, kernel, 3, globalWorkSize, nullptr, 0,
+                    2.0 * sizeof(float) * N * K);
+        }
+    }
+
+    releaseBuffers();
+}
+
+/*
+ * Conv2D.cpp : im2win (+ transpose, reorder) -> matmul version 0 ~ 8, implicit GEMM (version 9)
+ * naive conv2d, im2col + conv2d_matmul 도 포함.
+ */
+void KernelBenchmark::benchmarkConv2D(const std::string &model, size_t in_channel,
+                                      size_t out_channel, size_t inputSize, size_t kernel_size,
+                                      int stride) {
+    cl_int err;
+    int padding = static_cast<int>(kernel_size / 2);
+    size_t outputSize = (inputSize + 2 * padding - kernel_size) / stride + 1;
+    auto shape = "C=" + std::to_string(in_channel) + " O=" + std::to_string(out_channel) +
+                 " H=" + std::to_string(inputSize) + " k=" + std::to_string(kernel_size) +
+                 " s=" + std::to_string(stride);
+    double flops = 2.0 * out_channel * outputSize * outputSize * in_channel * kernel_size *
+                   kernel_size;
+    double weightBytes = sizeof(float) * (1.0 * out_channel * in_channel * kernel_size *
+                                          kernel_size + out_channel);
+    double inputBytes = sizeof(float) * 1.0 * in_channel * inputSize * inputSize;
+    double outputBytes = sizeof(float) * 1.0 * out_channel * outputSize * outputSize;
+
+    int _in_channel = static_cast<int>(in_channel);
+    int _out_channel = static_cast<int>(out_channel);
+    int _inputSize = static_cast<int>(inputSize);
+    int _outputSize = static_cast<int>(outputSize);
+    int _kernel_size = static_cast<int>(kernel_size);
+    int im_offset = 0, col_offset = 0;
+
+    auto input = createBuffer(in_channel * inputSize * inputSize);
+    auto weight = createBuffer(out_channel * in_channel * kernel_size * kernel_size);
+    auto bias = createBuffer(out_channel);
+    auto output = createBuffer(out_channel * outputSize * outputSize);
+    if (input == nullptr || weight == nullptr || bias == nullptr || output == nullptr) {
+        skip("conv2d", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+        releaseBuffers();
+        return;
+    }
+
+    /* naive */
+    {
+        auto kernel = convKernel->conv2d;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &weight);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &bias);
+        err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+        err |= clSetKernelArg(kernel, 4, sizeof(int), &_inputSize);
+        err |= clSetKernelArg(kernel, 5, sizeof(int), &_in_channel);
+        err |= clSetKernelArg(kernel, 6, sizeof(int), &_kernel_size);
+        err |= clSetKernelArg(kernel, 7, sizeof(int), &stride);
+        err |= clSetKernelArg(kernel, 8, sizeof(int), &padding);
+        if (err == CL_SUCCESS) {
+            size_t globalSize[3] = {out_channel, outputSize, outputSize};
+            measure("conv2d/conv2d", model, shape, convKernel->conv2d, 3, globalSize, nullptr,
+                    flops, inputBytes + weightBytes + outputBytes);
+        } else {
+            skip("conv2d/conv2d", model, shape, err);
+        }
+    }
+
+    /* im2col + conv2d_matmul */
+    auto col = createBuffer(in_channel * kernel_size * kernel_size * outputSize * outputSize);
+    if (col == nullptr) {
+        skip("conv2d/im2col", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+    } else {
+        auto kernel = convKernel->im2col;
+        int num_kernels = static_cast<int>(in_channel * outputSize * outputSize);
+        double colBytes = sizeof(float) * 1.0 * in_channel * kernel_size * kernel_size *
+                          outputSize * outputSize;
+        err = clSetKernelArg(kernel, 0, sizeof(int), &num_kernels);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &input);
+        err |= clSetKernelArg(kernel, 2, sizeof(int), &im_offset);
+        err |= clSetKernelArg(kernel, 3, sizeof(int), &_inputSize);
+        err |= clSetKernelArg(kernel, 4, sizeof(int), &_inputSize);
+        err |= clSetKernelArg(kernel, 5, sizeof(int), &_kernel_size);
+        err |= clSetKernelArg(kernel, 6, sizeof(int), &padding);
+        err |= clSetKernelArg(kernel, 7, sizeof(int), &stride);
+        err |= clSetKernelArg(kernel, 8, sizeof(int), &_outputSize);
+        err |= clSetKernelArg(kernel, 9, sizeof(int), &_outputSize);
+        err |= clSetKernelArg(kernel, 10, sizeof(cl_mem), &col);
+        err |= clSetKernelArg(kernel, 11, sizeof(int), &col_offset);
+        CHECK_ARG(err, "conv2d/im2col", model, shape);
+        size_t globalSize_im2col[1] = {static_cast<size_t>(num_kernels)};
+        measure("conv2d/im2col", model, shape, kernel, 1, globalSize_im2col, nullptr, 0,
+                inputBytes + colBytes);
+
+        kernel = convKernel->conv2d_matmul;
+        int N = static_cast<int>(outputSize * outputSize);
+        int K = static_cast<int>(in_channel * kernel_size * kernel_size);
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &weight);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &bias);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &col);
+        err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+        err |= clSetKernelArg(kernel, 4, sizeof(int), &_out_channel);
+        err |= clSetKernelArg(kernel, 5, sizeof(int), &N);
+        err |= clSetKernelArg(kernel, 6, sizeof(int), &K);
+        CHECK_ARG(err, "conv2d/conv2d_matmul", model, shape);
+        size_t globalSize_conv2d_matmul[1] = {out_channel * N};
+        measure("conv2d/conv2d_matmul", model, shape, kernel, 1, globalSize_conv2d_matmul,
+                nullptr, flops, colBytes + weightBytes + outputBytes);
+        clReleaseMemObject(col);
+        buffers.pop_back();
+    }
+
+    /* im2win : the same window buffer size for every version */
+    size_t width_pad = inputSize + 2 * padding;
+    int num_windows = static_cast<int>(in_channel * outputSize * width_pad);
+    int width_win = static_cast<int>(width_pad * kernel_size);
+    double winBytes = sizeof(float) * 1.0 * in_channel * outputSize * width_pad * kernel_size;
+    auto win = createBuffer(in_channel * outputSize * width_pad * kernel_size);
+    if (win == nullptr) {
+        skip("conv2d/im2win", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+    } else {
+        std::vector<std::pair<std::string, cl_kernel>> im2winKernels = {
+                {"conv2d/im2win",                   convKernel->im2win},
+                {"conv2d/im2win_transpose",         convKernel->im2win_transpose},
+                {"conv2d/im2win_transpose_reorder", convKernel->im2win_transpose_reorder},
+        };
+        for (auto &im2win: im2winKernels) {
+            auto kernel = im2win.second;
+            err = clSetKernelArg(kernel, 0, sizeof(int), &num_windows);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &input);
+            err |= clSetKernelArg(kernel, 2, sizeof(int), &im_offset);
+            err |= clSetKernelArg(kernel, 3, sizeof(int), &_inputSize);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &_inputSize);
+            err |= clSetKernelArg(kernel, 5, sizeof(int), &_kernel_size);
+            err |= clSetKernelArg(kernel, 6, sizeof(int), &padding);
+            err |= clSetKernelArg(kernel, 7, sizeof(int), &stride);
+            err |= clSetKernelArg(kernel, 8, sizeof(int), &_outputSize);
+            err |= clSetKernelArg(kernel, 9, sizeof(int), &width_win);
+            err |= clSetKernelArg(kernel, 10, sizeof(cl_mem), &win);
+            err |= clSetKernelArg(kernel, 11, sizeof(int), &col_offset);
+            if (err != CL_SUCCESS) {
+                skip(im2win.first, model, shape, err);
+                continue;
+            }
+            size_t globalSize_im2win[1] = {static_cast<size_t>(num_windows)};
+            measure(im2win.first, model, shape, kernel, 1, globalSize_im2win, nullptr, 0,
+                    inputBytes + winBytes);
+        }
+
+        double matmulBytes = winBytes + weightBytes + outputBytes;
+        size_t MN = outputSize * outputSize;
+
+        /* version 0 */
+        {
+            auto kernel = convKernel->im2win_matmul;
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &weight);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &bias);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &win);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &_out_channel);
+            err |= clSetKernelArg(kernel, 5, sizeof(int), &_outputSize);
+            err |= clSetKernelArg(kernel, 6, sizeof(int), &_outputSize);
+            err |= clSetKernelArg(kernel, 7, sizeof(int), &width_win);
+            err |= clSetKernelArg(kernel, 8, sizeof(int), &_in_channel);
+            err |= clSetKernelArg(kernel, 9, sizeof(int), &_kernel_size);
+            err |= clSetKernelArg(kernel, 10, sizeof(int), &stride);
+            CHECK_ARG(err, "conv2d/im2win_matmul", model, shape);
+            size_t globalSize[1] = {out_channel * MN};
+            measure("conv2d/im2win_matmul", model, shape, kernel, 1, globalSize, nullptr,
+                    flops, matmulBytes);
+        }
+
+        /* im2win_batch_matmul (Conv2D.cpp 주석 처리된 version) */
+        {
+            auto kernel = convKernel->im2win_batch_matmul;
+            size_t tile_size_m = 1, reg_size_n = 4;
+            auto n_index = findTile(outputSize, {128, 64, 32, 16, 8});
+            auto k_index = findTile(in_channel, {16, 4});
+            if (n_index < 0 || k_index < 0) {
+                skip("conv2d/im2win_batch_matmul", model, shape, CL_INVALID_VALUE);
+            } else {
+                int tile_size_n = static_cast<int>(std::vector<size_t>({128, 64, 32, 16, 8})[n_index]);
+                int tile_size_k = static_cast<int>(std::vector<size_t>({16, 4})[k_index]);
+                err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &win);
+                err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &weight);
+                err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &bias);
+                err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+                err |= clSetKernelArg(kernel, 4, sizeof(int), &_outputSize);
+                err |= clSetKernelArg(kernel, 5, sizeof(int), &_outputSize);
+                err |= clSetKernelArg(kernel, 6, sizeof(int), &_in_channel);
+                err |= clSetKernelArg(kernel, 7, sizeof(int), &width_win);
+                err |= clSetKernelArg(kernel, 8, sizeof(int), &_kernel_size);
+                err |= clSetKernelArg(kernel, 9, sizeof(int), &stride);
+                err |= clSetKernelArg(kernel, 10,
+                                      sizeof(float) * tile_size_k * tile_size_m *
+                                      (kernel_size * kernel_size +
+                                       (tile_size_n - 1) * stride * kernel_size),
+                                      nullptr);
+                err |= clSetKernelArg(kernel, 11,
+                                      sizeof(float) * tile_size_k * kernel_size * kernel_size,
+                                      nullptr);
+                err |= clSetKernelArg(kernel, 12, sizeof(int), &tile_size_n);
+                err |= clSetKernelArg(kernel, 13, sizeof(int), &tile_size_k);
+                CHECK_ARG(err, "conv2d/im2win_batch_matmul", model, shape);
+                size_t globalSize[3] = {out_channel, outputSize, outputSize / reg_size_n};
+                size_t localSize[3] = {1, 1, tile_size_n / reg_size_n};
+                measure("conv2d/im2win_batch_matmul", model, shape, kernel, 3, globalSize,
+                        localSize, flops, matmulBytes);
+            }
+        }
+
+        /* version 1 ~ 4 : (out_channel / reg_size_c, MN / reg_size_n) */
+        struct Version2D {
+            std::string name;
+            cl_kernel kernel;
+            size_t reg_size_c;
+            size_t reg_size_n;
+            size_t tile_size_n;
+        };
+        std::vector<Version2D> versions2D = {
+                {"conv2d/im2win_reg_n_matmul",          convKernel->im2win_reg_n_matmul,          1,  16, 256},
+                {"conv2d/im2win_v2_matmul",             convKernel->im2win_v2_matmul,             1,  32, 32 * 16},
+                {"conv2d/im2win_channel_reg_matmul",    convKernel->im2win_channel_reg_matmul,    2,  1,  16},
+                {"conv2d/im2win_channel_reg_v4_matmul", convKernel->im2win_channel_reg_v4_matmul, 16, 1,  64},
+        };
+        for (auto &version: versions2D) {
+            if (MN % version.tile_size_n != 0 || out_channel % version.reg_size_c != 0) {
+                skip(version.name, model, shape, CL_INVALID_VALUE);
+                continue;
+            }
+            auto kernel = version.kernel;
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &weight);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &bias);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &win);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &_outputSize);
+            err |= clSetKernelArg(kernel, 5, sizeof(int), &_outputSize);
+            err |= clSetKernelArg(kernel, 6, sizeof(int), &width_win);
+            err |= clSetKernelArg(kernel, 7, sizeof(int), &_in_channel);
+            err |= clSetKernelArg(kernel, 8, sizeof(int), &_kernel_size);
+            err |= clSetKernelArg(kernel, 9, sizeof(int), &stride);
+            if (err != CL_SUCCESS) {
+                skip(version.name, model, shape, err);
+                continue;
+            }
+            size_t globalSize[2] = {out_channel / version.reg_size_c, MN / version.reg_size_n};
+            size_t localSize[2] = {1, version.tile_size_n / version.reg_size_n};
+            measure(version.name, model, shape, kernel, 2, globalSize, localSize, flops,
+                    matmulBytes);
+        }
+
+        /* version 5 ~ 8 : (out_channel / reg_size_c, N, M / reg_size_m) */
+        struct Version3D {
+            std::string name;
+            cl_kernel kernel;
+            size_t reg_size_c;
+            size_t reg_size_m;
+            std::vector<size_t> tile_size_ns;
+        };
+        std::vector<Version3D> versions3D = {
+                {"conv2d/im2win_channel_reg_transpose_v5_matmul",
+                        convKernel->im2win_channel_reg_transpose_v5_matmul,                4, 4, {1, 8, 16, 8}},
+                {"conv2d/im2win_channel_reg_transpose_vector_v6_matmul",
+                        convKernel->im2win_channel_reg_transpose_vector_v6_matmul,         4, 4, {8, 8, 16, 8}},
+                {"conv2d/im2win_channel_reg_transpose_weight_vector_v7_matmul",
+                        convKernel->im2win_channel_reg_transpose_weight_vector_v7_matmul,  1, 8, {8, 8, 16, 8}},
+                {"conv2d/im2win_channel_reg_transpose_reorder_vector_v8_matmul",
+                        convKernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul, 4, 4, {8, 8, 16, 8}},
+        };
+        std::vector<size_t> tile_size_ms = {64, 32, 16, 8};
+        auto m_index = findTile(outputSize, tile_size_ms);
+        for (auto &version: versions3D) {
+            if (m_index < 0 || out_channel % version.reg_size_c != 0) {
+                skip(version.name, model, shape, CL_INVALID_VALUE);
+                continue;
+            }
+            auto kernel = version.kernel;
+            size_t tile_size_m = tile_size_ms[m_index];
+            size_t tile_size_n = version.tile_size_ns[m_index];
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &weight);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &bias);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &win);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &_outputSize);
+            err |= clSetKernelArg(kernel, 5, sizeof(int), &_outputSize);
+            err |= clSetKernelArg(kernel, 6, sizeof(int), &width_win);
+            err |= clSetKernelArg(kernel, 7, sizeof(int), &_in_channel);
+            err |= clSetKernelArg(kernel, 8, sizeof(int), &_kernel_size);
+            err |= clSetKernelArg(kernel, 9, sizeof(int), &stride);
+            if (err != CL_SUCCESS) {
+                skip(version.name, model, shape, err);
+                continue;
+            }
+            size_t globalSize[3] = {out_channel / version.reg_size_c, outputSize,
+                                    outputSize / version.reg_size_m};
+            size_t localSize[3] = {1, tile_size_n, tile_size_m / version.reg_size_m};
+            measure(version.name, model, shape, kernel, 3, globalSize, localSize, flops,
+                    matmulBytes);
+        }
+    }
+
+    /* version 9 : implicit GEMM */
+    {
+        size_t reg_size_c = 4, reg_size_m = 4;
+        std::vector<size_t> tile_size_ms = {64, 32, 16, 8};
+        std::vector<size_t> tile_size_ns = {8, 8, 16, 8};
+        std::vector<size_t> tile_size_ks = {8, 4, 2, 1};
+        int m_index;
+        for (m_index = 0; m_index < tile_size_ms.size(); m_index++) {
+            if (outputSize % tile_size_ms[m_index] == 0 &&
+                outputSize % tile_size_ns[m_index] == 0) {
+                break;
+            }
+        }
+        if (m_index >= tile_size_ms.size() || out_channel % reg_size_c != 0) {
+            skip("conv2d/implicit_gemm_conv2d", model, shape, CL_INVALID_VALUE);
+        } else {
+            auto kernel = convKernel->implicit_gemm_conv2d;
+            size_t tile_size_m = tile_size_ms[m_index];
+            size_t tile_size_n = tile_size_ns[m_index];
+            size_t patch_size = ((tile_size_m - 1) * stride + kernel_size) *
+                                ((tile_size_n - 1) * stride + kernel_size);
+            int k_index;
+            for (k_index = 0; k_index < tile_size_ks.size() - 1; k_index++) {
+                if (in_channel % tile_size_ks[k_index] == 0 &&
+                    sizeof(float) * tile_size_ks[k_index] * patch_size <= 16 * 1024) {
+                    break;
+                }
+            }
+            int tile_size_k = static_cast<int>(tile_size_ks[k_index]);
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &weight);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &bias);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &input);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &_in_channel);
+            err |= clSetKernelArg(kernel, 5, sizeof(int), &_inputSize);
+            err |= clSetKernelArg(kernel, 6, sizeof(int), &_inputSize);
+            err |= clSetKernelArg(kernel, 7, sizeof(int), &_outputSize);
+            err |= clSetKernelArg(kernel, 8, sizeof(int), &_outputSize);
+            err |= clSetKernelArg(kernel, 9, sizeof(int), &_kernel_size);
+            err |= clSetKernelArg(kernel, 10, sizeof(int), &stride);
+            err |= clSetKernelArg(kernel, 11, sizeof(int), &padding);
+            err |= clSetKernelArg(kernel, 12, sizeof(int), &tile_size_k);
+            err |= clSetKernelArg(kernel, 13, sizeof(float) * tile_size_k * patch_size, nullptr);
+            err |= clSetKernelArg(kernel, 14,
+                                  sizeof(float) * reg_size_c * tile_size_k * kernel_size *
+                                  kernel_size, nullptr);
+            CHECK_ARG(err, "conv2d/implicit_gemm_conv2d", model, shape);
+            size_t globalSize[3] = {out_channel / reg_size_c, outputSize, outputSize / reg_size_m};
+            size_t localSize[3] = {1, tile_size_n, tile_size_m / reg_size_m};
+            measure("conv2d/implicit_gemm_conv2d", model, shape, kernel, 3, globalSize,
+                    localSize, flops, inputBytes + weightBytes + outputBytes);
+        }
+    }
+
+    releaseBuffers();
+}
+
+/*
+ * CrossAttention.cpp : Q (B, M, K), K (B, N, K), V (B, N, K)
+ * einsum QK (version 0 ~ 2) -> softmax -> einsum V (version 0, 1)
+ */
+void KernelBenchmark::benchmarkCrossAttention(const std::string &model, size_t B, size_t M,
+                                              size_t N, size_t K) {
+    cl_int err;
+    auto shape = "B=" + std::to_string(B) + " M=" + std::to_string(M) + " N=" +
+                 std::to_string(N) + " K=" + std::to_string(K);
+    size_t N_pad = N % WIDTH == 0 ? N : N + WIDTH - N % WIDTH;
+    float scale = 1.0f / sqrtf(static_cast<float>(K));
+    double qkFlops = 2.0 * B * M * N * K;
+    double qkBytes = sizeof(float) * (1.0 * B * M * K + 1.0 * B * N * K + 1.0 * B * M * N);
+    double vFlops = 2.0 * B * M * N * K;
+    double vBytes = sizeof(float) * (1.0 * B * M * N + 1.0 * B * N * K + 1.0 * B * M * K);
+
+    auto q = createBuffer(B * M * K);
+    auto k = createBuffer(B * N_pad * K);
+    auto v = createBuffer(B * N * K);
+    auto qk = createBuffer(B * M * N_pad);
+    auto out = createBuffer(B * M * K);
+    if (q == nullptr || k == nullptr || v == nullptr || qk == nullptr || out == nullptr) {
+        skip("cross_attention", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+        releaseBuffers();
+        return;
+    }
+
+    /* version 0 */
+    {
+        auto kernel = crossAttentionKernel->einsum_bik_bjk_bij;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &q);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &k);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 3, sizeof(size_t), &K);
+        err |= clSetKernelArg(kernel, 4, sizeof(float), &scale);
+        CHECK_ARG(err, "cross_attention/einsum_bik_bjk_bij", model, shape);
+        size_t globalSize[3] = {B, M, N};
+        measure("cross_attention/einsum_bik_bjk_bij", model, shape, kernel, 3, globalSize,
+                nullptr, qkFlops, qkBytes);
+    }
+
+    /* version 1 */
+    {
+        size_t reg_size_m = 8, tile_size_m = 128;
+        auto n_index = findTile(N, {32, 11, 1});
+        if (M % tile_size_m != 0) {
+            skip("cross_attention/optimized_einsum_bik_bjk_bij", model, shape, CL_INVALID_VALUE);
+        } else {
+            auto kernel = crossAttentionKernel->optimized_einsum_bik_bjk_bij;
+            size_t tile_size_n = std::vector<size_t>({32, 11, 1})[n_index];
+            int _K = static_cast<int>(K);
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &q);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &k);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &qk);
+            err |= clSetKernelArg(kernel, 3, sizeof(int), &_K);
+            err |= clSetKernelArg(kernel, 4, sizeof(float), &scale);
+            CHECK_ARG(err, "cross_attention/optimized_einsum_bik_bjk_bij", model, shape);
+            size_t globalSize[3] = {B, M / reg_size_m, N};
+            size_t localSize[3] = {1, tile_size_m / reg_size_m, tile_size_n};
+            measure("cross_attention/optimized_einsum_bik_bjk_bij", model, shape, kernel, 3,
+                    globalSize, localSize, qkFlops, qkBytes);
+        }
+    }
+
+    /* version 2 : K is permuted to (B, K, N_pad) */
+    {
+        size_t reg_size_m = 4, tile_size_m = 32;
+        auto n_index = findTile(N_pad, {80, 64, 11, 1});
+        if (M % tile_size_m != 0) {
+            skip("cross_attention/optimized_einsum_bik_bkj_bij_general", model, shape,
+                 CL_INVALID_VALUE);
+        } else {
+            auto kernel = crossAttentionKernel->optimized_einsum_bik_bkj_bij_general;
+            size_t tile_size_n = std::vector<size_t>({80, 64, 11, 1})[n_index];
+            int _N = static_cast<int>(N), _K = static_cast<int>(K);
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &q);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &k);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &qk);
+            err |= clSetKernelArg(kernel, 3, sizeof(int), &_N);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &_K);
+            err |= clSetKernelArg(kernel, 5, sizeof(float), &scale);
+            CHECK_ARG(err, "cross_attention/optimized_einsum_bik_bkj_bij_general", model, shape);
+            size_t globalSize[3] = {B, M / reg_size_m, N_pad / WIDTH};
+            size_t localSize[3] = {1, tile_size_m / reg_size_m, tile_size_n / WIDTH};
+            measure("cross_attention/optimized_einsum_bik_bkj_bij_general", model, shape,
+                    kernel, 3, globalSize, localSize, qkFlops, qkBytes);
+        }
+    }
+
+    /* version 3 : Q, K are read through strides from the Linear output (M, B * K) */
+    {
+        auto kernel = utilKernel->strided_batch_matmul;
+        int _K = static_cast<int>(K), ld = static_cast<int>(B * K);
+        cl_int4 layoutQ = {{0, _K, ld, 1}};
+        cl_int4 layoutK = {{0, _K, 1, ld}};
+        cl_int4 layoutQK = {{0, static_cast<int>(M * N), static_cast<int>(N), 1}};
+        err = setStridedMatmulArgs(kernel, &q, &k, &qk, M, N, K, layoutQ, layoutK, layoutQK,
+                                   scale);
+        CHECK_ARG(err, "util/strided_batch_matmul", model, shape);
+        size_t globalSize[3] = {B, stridedGlobalSize(M), stridedGlobalSize(N)};
+        size_t localSize[3] = {1, STRIDED_TILE / STRIDED_REG, STRIDED_TILE / STRIDED_REG};
+        measure("util/strided_batch_matmul", model, shape, kernel, 3, globalSize, localSize,
+                qkFlops, qkBytes);
+    }
+
+    /* softmax (util.cl) */
+    {
+        auto kernel = utilKernel->softmax;
+        size_t workGroupSize = WORK_GROUP_SIZE;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 2, sizeof(float) * workGroupSize, nullptr);
+        err |= clSetKernelArg(kernel, 3, sizeof(float) * N, nullptr);
+        err |= clSetKernelArg(kernel, 4, sizeof(size_t), &N);
+        CHECK_ARG(err, "util/softmax", model, shape);
+        size_t globalSize[1] = {B * M * workGroupSize};
+        size_t localSize[1] = {workGroupSize};
+        measure("util/softmax", model, shape, kernel, 1, globalSize, localSize,
+                3.0 * B * M * N, 2.0 * sizeof(float) * B * M * N);
+    }
+
+    /* softmax_online (util.cl) */
+    {
+        auto kernel = utilKernel->softmax_online;
+        size_t workGroupSize = WORK_GROUP_SIZE;
+        int rowSize = static_cast<int>(N);
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 2, sizeof(float) * workGroupSize, nullptr);
+        err |= clSetKernelArg(kernel, 3, sizeof(float) * workGroupSize, nullptr);
+        err |= clSetKernelArg(kernel, 4, sizeof(int), &rowSize);
+        CHECK_ARG(err, "util/softmax_online", model, shape);
+        size_t globalSize[1] = {B * M * workGroupSize};
+        size_t localSize[1] = {workGroupSize};
+        measure("util/softmax_online", model, shape, kernel, 1, globalSize, localSize,
+                4.0 * B * M * N, 3.0 * sizeof(float) * B * M * N);
+    }
+
+    /* softmax_online_half (util.cl) : the float buffer is read as half (same row count) */
+    {
+        auto kernel = utilKernel->softmax_online_half;
+        size_t workGroupSize = WORK_GROUP_SIZE;
+        int rowSize = static_cast<int>(N);
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 2, sizeof(float) * workGroupSize, nullptr);
+        err |= clSetKernelArg(kernel, 3, sizeof(float) * workGroupSize, nullptr);
+        err |= clSetKernelArg(kernel, 4, sizeof(int), &rowSize);
+        CHECK_ARG(err, "util/softmax_online_half", model, shape);
+        size_t globalSize[1] = {B * M * workGroupSize};
+        size_t localSize[1] = {workGroupSize};
+        measure("util/softmax_online_half", model, shape, kernel, 1, globalSize, localSize,
+                4.0 * B * M * N, 3.0 * sizeof(cl_half) * B * M * N);
+    }
+
+    /* version 0 */
+    {
+        auto kernel = crossAttentionKernel->einsum_bij_bjk_bik;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &v);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &out);
+        err |= clSetKernelArg(kernel, 3, sizeof(size_t), &N);
+        CHECK_ARG(err, "cross_attention/einsum_bij_bjk_bik", model, shape);
+        size_t globalSize[3] = {B, M, K};
+        measure("cross_attention/einsum_bij_bjk_bik", model, shape, kernel, 3, globalSize,
+                nullptr, vFlops, vBytes);
+    }
+
+    /* version 1, 2 */
+    {
+        size_t reg_size_m = 4, tile_size_m = 32;
+        auto n_index = findTile(K, {64, 11, 1});
+        if (M % tile_size_m != 0 || K % WIDTH != 0) {
+            skip("cross_attention/optimized_einsum_bik_bkj_bij", model, shape, CL_INVALID_VALUE);
+        } else {
+            auto kernel = crossAttentionKernel->optimized_einsum_bik_bkj_bij;
+            size_t tile_size_n = std::vector<size_t>({64, 11, 1})[n_index];
+            int _N = static_cast<int>(N);
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qk);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &v);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &out);
+            err |= clSetKernelArg(kernel, 3, sizeof(int), &_N);
+            CHECK_ARG(err, "cross_attention/optimized_einsum_bik_bkj_bij", model, shape);
+            size_t globalSize[3] = {B, M / reg_size_m, K / WIDTH};
+            size_t localSize[3] = {1, tile_size_m / reg_size_m, tile_size_n / WIDTH};
+            measure("cross_attention/optimized_einsum_bik_bkj_bij", model, shape, kernel, 3,
+                    globalSize, localSize, vFlops, vBytes);
+        }
+    }
+
+    /* version 3 : V is read through strides, out is written in the to_out input layout */
+    {
+        auto kernel = utilKernel->strided_batch_matmul;
+        int _K = static_cast<int>(K), ld = static_cast<int>(B * K);
+        cl_int4 layoutQK = {{0, static_cast<int>(M * N), static_cast<int>(N), 1}};
+        cl_int4 layoutV = {{0, _K, ld, 1}};
+        cl_int4 layoutOut = {{0, _K, ld, 1}};
+        err = setStridedMatmulArgs(kernel, &qk, &v, &out, M, K, N, layoutQK, layoutV, layoutOut,
+                                   1.0f);
+        CHECK_ARG(err, "util/strided_batch_matmul", model, shape);
+        size_t globalSize[3] = {B, stridedGlobalSize(M), stridedGlobalSize(K)};
+        size_t localSize[3] = {1, STRIDED_TILE / STRIDED_REG, STRIDED_TILE / STRIDED_REG};
+        auto vShape = "B=" + std::to_string(B) + " M=" + std::to_string(M) + " N=" +
+                      std::to_string(K) + " K=" + std::to_string(N);
+        measure("util/strided_batch_matmul", model, vShape, kernel, 3, globalSize, localSize,
+                vFlops, vBytes);
+    }
+
+    /* permute (M, B, K) <-> (B, M, K) */
+    {
+        auto kernel = utilKernel->permute3D_1_0_2;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &out);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &q);
+        CHECK_ARG(err, "util/permute3D__1_0_2", model, shape);
+        size_t globalSize[3] = {M, B, K};
+        measure("util/permute3D__1_0_2", model, shape, kernel, 3, globalSize, nullptr, 0,
+                2.0 * sizeof(float) * B * M * K);
+    }
+
+    /* permute K of version 2 : (N, B, K) -> (B, K, N_pad) */
+    {
+        auto kernel = utilKernel->permute3D_copy;
+        int permuteKDim[3] = {1, 2, 0};
+        int _N_pad = static_cast<int>(N_pad), _B = static_cast<int>(B);
+        int _K = static_cast<int>(K);
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &v);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &k);
+        err |= clSetKernelArg(kernel, 2, sizeof(int), &permuteKDim[0]);
+        err |= clSetKernelArg(kernel, 3, sizeof(int), &permuteKDim[1]);
+        err |= clSetKernelArg(kernel, 4, sizeof(int), &permuteKDim[2]);
+        err |= clSetKernelArg(kernel, 5, sizeof(int), &_N_pad);
+        err |= clSetKernelArg(kernel, 6, sizeof(int), &_B);
+        err |= clSetKernelArg(kernel, 7, sizeof(int), &_K);
+        CHECK_ARG(err, "util/permute3D_copy", model, shape);
+        size_t globalSize[3] = {N, B, K};
+        measure("util/permute3D_copy", model, shape, kernel, 3, globalSize, nullptr, 0,
+                2.0 * sizeof(float) * B * N * K);
+    }
+
+    /* QKV_FUSE_MODE 1 : to_qkv output (M, 3 * B * K) -> head-major Q, K, V (attn1 only) */
+    if (M == N) {
+        auto qkv = createBuffer(3 * B * M * K);
+        if (qkv == nullptr) {
+            skip("cross_attention/split_qkv_heads", model, shape,
+                 CL_MEM_OBJECT_ALLOCATION_FAILURE);
+        } else {
+            auto kernel = crossAttentionKernel->split_qkv_heads;
+            int transposeK = 0, ldk = static_cast<int>(N);
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qkv);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &q);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &k);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &v);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &transposeK);
+            err |= clSetKernelArg(kernel, 5, sizeof(int), &ldk);
+            CHECK_ARG(err, "cross_attention/split_qkv_heads", model, shape);
+            size_t globalSize[3] = {M, B, K};
+            measure("cross_attention/split_qkv_heads", model, shape, kernel, 3, globalSize,
+                    nullptr, 0, 6.0 * sizeof(float) * B * M * K);
+        }
+    }
+
+    releaseBuffers();
+}
+
+/*
+ * MultiHeadAttention.cpp : causal self attention of text encoder
+ */
+void KernelBenchmark::benchmarkMultiHeadAttention(const std::string &model, size_t numHeads,
+                                                  size_t contextLength, size_t headDim) {
+    cl_int err;
+    auto shape = "B=" + std::to_string(numHeads) + " M=" + std::to_string(contextLength) +
+                 " N=" + std::to_string(contextLength) + " K=" + std::to_string(headDim);
+    size_t L = contextLength;
+    double qkFlops = 2.0 * numHeads * L * L * headDim;
+    double qkBytes = sizeof(float) * (2.0 * numHeads * L * headDim + L * L + numHeads * L * L);
+    double vFlops = 2.0 * numHeads * L * L * headDim;
+    double vBytes = sizeof(float) * (numHeads * L * L + 2.0 * numHeads * L * headDim);
+
+    auto qkv = createBuffer(3 * numHeads * L * headDim);
+    auto mask = createBuffer(L * L);
+    auto qk = createBuffer(numHeads * L * L);
+    auto out = createBuffer(numHeads * L * headDim);
+    if (qkv == nullptr || mask == nullptr || qk == nullptr || out == nullptr) {
+        skip("multi_head_attention", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+        releaseBuffers();
+        return;
+    }
+
+    /* naive QxK */
+    {
+        auto kernel = multiHeadAttentionKernel->add_matmul_attention;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qkv);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &mask);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 3, sizeof(size_t), &headDim);
+        CHECK_ARG(err, "multi_head_attention/add_matmul_attention", model, shape);
+        size_t globalSize[3] = {numHeads, L, L};
+        measure("multi_head_attention/add_matmul_attention", model, shape, kernel, 3,
+                globalSize, nullptr, qkFlops, qkBytes);
+    }
+
+    /* optimized QxK : Q and K share the (3, B, L, K) buffer */
+    size_t reg_size = 7, tile_size = 77;
+    {
+        auto kernel = multiHeadAttentionKernel->batch_matmul_mask;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qkv);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &qkv);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &mask);
+        err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 4, sizeof(size_t), &L);
+        err |= clSetKernelArg(kernel, 5, sizeof(size_t), &L);
+        err |= clSetKernelArg(kernel, 6, sizeof(size_t), &headDim);
+        CHECK_ARG(err, "multi_head_attention/batch_matmul_mask", model, shape);
+        size_t globalSize[3] = {numHeads, L / reg_size, L / reg_size};
+        size_t localSize[3] = {1, tile_size / reg_size, tile_size / reg_size};
+        measure("multi_head_attention/batch_matmul_mask", model, shape, kernel, 3, globalSize,
+                localSize, qkFlops, qkBytes);
+    }
+
+    {
+        auto kernel = multiHeadAttentionKernel->softmax;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 2, sizeof(float) * L, nullptr);
+        CHECK_ARG(err, "multi_head_attention/local_softmax", model, shape);
+        size_t globalSize[1] = {numHeads * L * L};
+        size_t localSize[1] = {L};
+        measure("multi_head_attention/local_softmax", model, shape, kernel, 1, globalSize,
+                localSize, 3.0 * numHeads * L * L, 2.0 * sizeof(float) * numHeads * L * L);
+    }
+
+    /* naive QK x V */
+    {
+        auto kernel = multiHeadAttentionKernel->matmul_attention;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &qkv);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &out);
+        err |= clSetKernelArg(kernel, 3, sizeof(size_t), &L);
+        CHECK_ARG(err, "multi_head_attention/batch_matmul_attention", model, shape);
+        size_t globalSize[3] = {numHeads, L, headDim};
+        measure("multi_head_attention/batch_matmul_attention", model, shape, kernel, 3,
+                globalSize, nullptr, vFlops, vBytes);
+    }
+
+    /* optimized QK x V */
+    {
+        size_t tile_size1 = 64, reg_size1 = 8;
+        auto kernel = multiHeadAttentionKernel->batch_matmul;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &qkv);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &out);
+        err |= clSetKernelArg(kernel, 3, sizeof(size_t), &L);
+        err |= clSetKernelArg(kernel, 4, sizeof(size_t), &headDim);
+        err |= clSetKernelArg(kernel, 5, sizeof(size_t), &L);
+        CHECK_ARG(err, "multi_head_attention/batch_matmul", model, shape);
+        size_t globalSize[3] = {numHeads, L / reg_size, headDim / reg_size1};
+        size_t localSize[3] = {1, tile_size / reg_size, tile_size1 / reg_size1};
+        measure("multi_head_attention/batch_matmul", model, shape, kernel, 3, globalSize,
+                localSize, vFlops, vBytes);
+    }
+
+    /* (L, 3, E) -> (3, L, E) */
+    {
+        auto kernel = utilKernel->permute3D_1_0_2;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qkv);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &qkv);
+        CHECK_ARG(err, "util/permute3D__1_0_2", model, shape);
+        size_t globalSize[3] = {L, 3, numHeads * headDim};
+        auto qkvShape = "L=" + std::to_string(L) + " 3 E=" + std::to_string(numHeads * headDim);
+        measure("util/permute3D__1_0_2", model, qkvShape, kernel, 3, globalSize, nullptr, 0,
+                2.0 * sizeof(float) * 3 * L * numHeads * headDim);
+    }
+
+    /*
+     * version 1 : fused (L, 3E) -> (L, E), replaces the 5 launches above.
+     * flops of unmasked QxK + QKxV, to compare with them
+     */
+    if (headDim != CAUSAL_HEAD_DIM) {
+        skip("multi_head_attention/causal_attention", model, shape, CL_INVALID_VALUE);
+    } else {
+        auto kernel = multiHeadAttentionKernel->causal_attention;
+        size_t maxLocalSize;
+        err = clGetKernelWorkGroupInfo(kernel, deviceId, CL_KERNEL_WORK_GROUP_SIZE,
+                                       sizeof(size_t), &maxLocalSize, nullptr);
+        cl_int length = static_cast<cl_int>(L);
+        cl_int embedDim = static_cast<cl_int>(numHeads * headDim);
+        float scale = 1.f / sqrtf(static_cast<float>(headDim));
+        size_t localBytes = sizeof(float) * CAUSAL_TILE * CAUSAL_HEAD_DIM;
+        err |= clSetKernelArg(kernel, 0, sizeof(cl_mem), &qkv);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &out);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_int), &length);
+        err |= clSetKernelArg(kernel, 3, sizeof(cl_int), &embedDim);
+        err |= clSetKernelArg(kernel, 4, sizeof(float), &scale);
+        err |= clSetKernelArg(kernel, 5, localBytes, nullptr);
+        err |= clSetKernelArg(kernel, 6, localBytes, nullptr);
+        CHECK_ARG(err, "multi_head_attention/causal_attention", model, shape);
+        size_t localSize = std::min<size_t>(L, maxLocalSize);
+        size_t globalSize[2] = {(L + localSize - 1) / localSize * localSize, numHeads};
+        size_t localSizeAttention[2] = {localSize, 1};
+        measure("multi_head_attention/causal_attention", model, shape, kernel, 2, globalSize,
+                localSizeAttention, qkFlops + vFlops,
+                sizeof(float) * 4.0 * L * numHeads * headDim);
+    }
+
+    releaseBuffers();
+}
+
+/*
+ * TextEncoder.cpp : token embedding lookup + positional embedding (TOKEN_EMBEDDING_MODE 1, 2)
+ */
+void KernelBenchmark::benchmarkTokenEmbedding(const std::string &model, size_t contextLength,
+                                              size_t embeddingSize, size_t vocabSize) {
+    cl_int err;
+    auto shape = "L=" + std::to_string(contextLength) + " E=" + std::to_string(embeddingSize) +
+                 " V=" + std::to_string(vocabSize);
+    size_t size = contextLength * embeddingSize;
+
+    auto tokens = createBuffer(contextLength);
+    auto positional = createBuffer(size);
+    auto output = createBuffer(size);
+    if (tokens == nullptr || positional == nullptr || output == nullptr) {
+        skip("util/token_embedding", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+        releaseBuffers();
+        return;
+    }
+    /* token ids spread over the whole table */
+    std::vector<cl_int> ids(contextLength);
+    for (size_t i = 0; i < contextLength; i++) {
+        ids[i] = static_cast<cl_int>(i * 997 % vocabSize);
+    }
+    err = clEnqueueWriteBuffer(cmdQueue, tokens, CL_TRUE, 0, sizeof(cl_int) * ids.size(),
+                               ids.data(), 0, nullptr, nullptr);
+    CHECK_ARG(err, "util/token_embedding", model, shape);
+    size_t globalSize[2] = {contextLength, embeddingSize / 4};
+
+    /* TOKEN_EMBEDDING_MODE 1 : fp32 table */
+    auto table = createBuffer(vocabSize * embeddingSize);
+    if (table == nullptr) {
+        skip("util/token_embedding", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+    } else {
+        auto kernel = utilKernel->token_embedding;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &tokens);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &table);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &positional);
+        err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+        CHECK_ARG(err, "util/token_embedding", model, shape);
+        measure("util/token_embedding", model, shape, kernel, 2, globalSize, nullptr,
+                1.0 * size, 3.0 * sizeof(float) * size);
+    }
+
+    /* TOKEN_EMBEDDING_MODE 2 : fp16 table (two halves per float of createBuffer) */
+    auto tableHalf = createBuffer(vocabSize * embeddingSize / 2);
+    if (tableHalf == nullptr) {
+        skip("util/token_embedding_half", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+    } else {
+        auto kernel = utilKernel->token_embedding_half;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &tokens);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &tableHalf);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &positional);
+        err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+        CHECK_ARG(err, "util/token_embedding_half", model, shape);
+        measure("util/token_embedding_half", model, shape, kernel, 2, globalSize, nullptr,
+                1.0 * size, (sizeof(cl_half) + 2.0 * sizeof(float)) * size);
+    }
+
+    releaseBuffers();
+}
+
+/*
+ * LatentPreview.cpp : latent (4, HW) -> rgb (3, HW), per-pixel 4x3 linear
+ */
+void KernelBenchmark::benchmarkLatentPreview(const std::string &model, size_t channels,
+                                             size_t heightXwidth) {
+    cl_int err;
+    auto shape = "C=" + std::to_string(channels) + " HW=" + std::to_string(heightXwidth);
+
+    auto latent = createBuffer(channels * heightXwidth);
+    auto weight = createBuffer(3 * channels);
+    auto bias = createBuffer(3);
+    auto output = createBuffer(3 * heightXwidth);
+    if (latent == nullptr || weight == nullptr || bias == nullptr || output == nullptr) {
+        skip("util/latent_preview", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+        releaseBuffers();
+        return;
+    }
+
+    if (channels != 4) {
+        skip("util/latent_preview", model, shape, CL_INVALID_VALUE);
+    } else {
+        auto kernel = utilKernel->latent_preview;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &latent);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &weight);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &bias);
+        err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+        CHECK_ARG(err, "util/latent_preview", model, shape);
+        size_t globalSize[1] = {heightXwidth};
+        measure("util/latent_preview", model, shape, kernel, 1, globalSize, nullptr,
+                2.0 * 3 * channels * heightXwidth,
+                sizeof(float) * (1.0 * channels * heightXwidth + 3.0 * heightXwidth));
+    }
+
+    releaseBuffers();
+}
+
+/*
+ * GroupNorm.cpp : 32 groups, mean -> variance -> normalize
+ */
+void KernelBenchmark::benchmarkGroupNorm(const std::string &model, size_t channels,
+                                         size_t heightXwidth, bool channelLast) {
+    cl_int err;
+    auto shape = "C=" + std::to_string(channels) + " HW=" + std::to_string(heightXwidth) +
+                 " G=" + std::to_string(NUM_GROUPS);
+    size_t inputSize = channels * heightXwidth;
+    size_t groupSize = inputSize / NUM_GROUPS;
+    size_t reductionSize = groupSize / WORK_GROUP_SIZE;
+    float eps = 1e-5;
+    if (groupSize % WORK_GROUP_SIZE != 0) {
+        skip("group_norm", model, shape, CL_INVALID_VALUE);
+        return;
+    }
+
+    auto input = createBuffer(inputSize);
+    auto mean = createBuffer(NUM_GROUPS);
+    auto variance = createBuffer(NUM_GROUPS);
+    auto weight = createBuffer(channels);
+    auto bias = createBuffer(channels);
+    auto output = createBuffer(inputSize);
+    if (input == nullptr || mean == nullptr || variance == nullptr || weight == nullptr ||
+        bias == nullptr || output == nullptr) {
+        skip("group_norm", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+        releaseBuffers();
+        return;
+    }
+
+    size_t globalReductionSize[1] = {NUM_GROUPS * WORK_GROUP_SIZE};
+    size_t localReductionSize[1] = {WORK_GROUP_SIZE};
+    {
+        auto kernel = groupNormKernel->local_reduction_mean;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &mean);
+        err |= clSetKernelArg(kernel, 2, sizeof(float) * groupSize / reductionSize, nullptr);
+        err |= clSetKernelArg(kernel, 3, sizeof(size_t), &reductionSize);
+        CHECK_ARG(err, "group_norm/local_reduction_mean", model, shape);
+        measure("group_norm/local_reduction_mean", model, shape, kernel, 1,
+                globalReductionSize, localReductionSize, 1.0 * inputSize,
+                sizeof(float) * 1.0 * inputSize);
+    }
+
+    {
+        auto kernel = groupNormKernel->local_reduction_variance;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &mean);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &variance);
+        err |= clSetKernelArg(kernel, 3, sizeof(float) * groupSize / reductionSize, nullptr);
+        err |= clSetKernelArg(kernel, 4, sizeof(size_t), &reductionSize);
+        CHECK_ARG(err, "group_norm/local_reduction_variance", model, shape);
+        measure("group_norm/local_reduction_variance", model, shape, kernel, 1,
+                globalReductionSize, localReductionSize, 3.0 * inputSize,
+                sizeof(float) * 1.0 * inputSize);
+    }
+
+    {
+        auto kernel = groupNormKernel->group_norm;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &mean);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &variance);
+        err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &weight);
+        err |= clSetKernelArg(kernel, 4, sizeof(cl_mem), &bias);
+        err |= clSetKernelArg(kernel, 5, sizeof(size_t), &groupSize);
+        err |= clSetKernelArg(kernel, 6, sizeof(size_t), &heightXwidth);
+        err |= clSetKernelArg(kernel, 7, sizeof(float), &eps);
+        err |= clSetKernelArg(kernel, 8, sizeof(cl_mem), &output);
+        CHECK_ARG(err, "group_norm/group_norm", model, shape);
+        size_t globalSize[1] = {inputSize};
+        measure("group_norm/group_norm", model, shape, kernel, 1, globalSize, nullptr,
+                4.0 * inputSize, 2.0 * sizeof(float) * inputSize);
+    }
+
+    if (!channelLast) {
+        releaseBuffers();
+        return;
+    }
+
+    /* (C, HW) -> (HW, C) : SpatialTransformer input, replaces group_norm + permute */
+    if (channels % 4 != 0) {
+        skip("group_norm/group_norm_channel_last", model, shape, CL_INVALID_VALUE);
+    } else {
+        auto kernel = groupNormKernel->group_norm_channel_last;
+        int channelsPerGroup = static_cast<int>(channels / NUM_GROUPS);
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &mean);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &variance);
+        err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &weight);
+        err |= clSetKernelArg(kernel, 4, sizeof(cl_mem), &bias);
+        err |= clSetKernelArg(kernel, 5, sizeof(int), &channelsPerGroup);
+        err |= clSetKernelArg(kernel, 6, sizeof(float), &eps);
+        err |= clSetKernelArg(kernel, 7, sizeof(cl_mem), &output);
+        CHECK_ARG(err, "group_norm/group_norm_channel_last", model, shape);
+        size_t globalSize[2] = {heightXwidth, channels / 4};
+        measure("group_norm/group_norm_channel_last", model, shape, kernel, 2, globalSize,
+                nullptr, 4.0 * inputSize, 2.0 * sizeof(float) * inputSize);
+    }
+
+    /* (HW, C) + residual (C, HW) -> (C, HW) : SpatialTransformer output, replaces permute + add */
+    if (channels % 4 != 0) {
+        skip("util/channel_first_add", model, shape, CL_INVALID_VALUE);
+    } else {
+        auto kernel = utilKernel->channel_first_add;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &output);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &input);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &input);
+        CHECK_ARG(err, "util/channel_first_add", model, shape);
+        size_t globalSize[2] = {heightXwidth, channels / 4};
+        measure("util/channel_first_add", model, shape, kernel, 2, globalSize, nullptr,
+                1.0 * inputSize, 3.0 * sizeof(float) * inputSize);
+    }
+
+    releaseBuffers();
+}
+
+/*
+ * ResBlock.cpp, ResidualAttentionBlock.cpp : element-wise kernels of (channels, height * width)
+ */
+void KernelBenchmark::benchmarkElemwise(const std::string &model, size_t channels,
+                                        size_t heightXwidth) {
+    cl_int err;
+    auto shape = "C=" + std::to_string(channels) + " HW=" + std::to_string(heightXwidth);
+    size_t size = channels * heightXwidth;
+
+    auto a = createBuffer(size);
+    auto b = createBuffer(size);
+    auto c = createBuffer(size);
+    auto chunk = createBuffer(channels);
+    if (a == nullptr || b == nullptr || c == nullptr || chunk == nullptr) {
+        skip("util", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+        releaseBuffers();
+        return;
+    }
+    size_t globalSize[1] = {size};
+
+    {
+        auto kernel = utilKernel->elemwise_add;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &a);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &b);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &c);
+        CHECK_ARG(err, "util/elemwise_add", model, shape);
+        measure("util/elemwise_add", model, shape, kernel, 1, globalSize, nullptr, 1.0 * size,
+                3.0 * sizeof(float) * size);
+    }
+
+    /* no host path */
+    {
+        auto kernel = utilKernel->elemwise_multiply;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &a);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &b);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &c);
+        CHECK_ARG(err, "util/elemwise_multiply", model, shape);
+        measure("util/elemwise_multiply", model, shape, kernel, 1, globalSize, nullptr,
+                1.0 * size, 3.0 * sizeof(float) * size);
+    }
+
+    {
+        auto kernel = utilKernel->chunkwise_add;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &a);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &chunk);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &c);
+        err |= clSetKernelArg(kernel, 3, sizeof(size_t), &heightXwidth);
+        CHECK_ARG(err, "util/chunkwise_add", model, shape);
+        measure("util/chunkwise_add", model, shape, kernel, 1, globalSize, nullptr, 1.0 * size,
+                sizeof(float) * (2.0 * size + channels));
+    }
+
+    std::vector<std::pair<std::string, cl_kernel>> activations = {
+            {"util/silu", utilKernel->silu},
+            {"util/gelu", utilKernel->gelu},
+    };
+    for (auto &activation: activations) {
+        auto kernel = activation.second;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &a);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &c);
+        CHECK_ARG(err, activation.first, model, shape);
+        measure(activation.first, model, shape, kernel, 1, globalSize, nullptr, 8.0 * size,
+                2.0 * sizeof(float) * size);
+    }
+
+    releaseBuffers();
+}
+
+/*
+ * AttnBlock.cpp : single head attention of decoder, Q (C, HW), K (C, HW), V (C, HW)
+ */
+void KernelBenchmark::benchmarkAttnBlock(const std::string &model, size_t channels,
+                                         size_t heightXwidth) {
+    cl_int err;
+    auto shape = "C=" + std::to_string(channels) + " HW=" + std::to_string(heightXwidth);
+    size_t C = channels, HW = heightXwidth;
+    float scale = 1.0f / sqrtf(static_cast<float>(C));
+    double flops = 2.0 * HW * HW * C;
+    double bytes = sizeof(float) * (2.0 * C * HW + 1.0 * HW * HW);
+
+    auto q = createBuffer(C * HW);
+    auto k = createBuffer(C * HW);
+    auto qk = createBuffer(HW * HW);
+    auto permuteQK = createBuffer(HW * HW);
+    if (q == nullptr || k == nullptr || qk == nullptr || permuteQK == nullptr) {
+        skip("attn_block", model, shape, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+        releaseBuffers();
+        return;
+    }
+
+    {
+        auto kernel = utilKernel->permute3D_0_2_1;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &q);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &k);
+        CHECK_ARG(err, "util/permute3D__0_2_1", model, shape);
+        size_t globalSize[3] = {1, C, HW};
+        measure("util/permute3D__0_2_1", model, shape, kernel, 3, globalSize, nullptr, 0,
+                2.0 * sizeof(float) * C * HW);
+    }
+
+    /* naive */
+    {
+        auto kernel = utilKernel->batch_matmul;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &q);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &k);
+        err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 3, sizeof(size_t), &C);
+        err |= clSetKernelArg(kernel, 4, sizeof(float), &scale);
+        CHECK_ARG(err, "util/batch_matmul", model, shape);
+        size_t globalSize[3] = {1, HW, HW};
+        measure("util/batch_matmul", model, shape, kernel, 3, globalSize, nullptr, flops,
+                bytes);
+    }
+
+    /* optimized */
+    {
+        size_t tile_size = 128, reg_size = 8, tile_size_k = 16;
+        if (HW % tile_size != 0 || C % tile_size_k != 0) {
+            skip("util/batch_matmul_scale", model, shape, CL_INVALID_VALUE);
+        } else {
+            auto kernel = utilKernel->batch_matmul_scale;
+            err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &q);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &k);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &qk);
+            err |= clSetKernelArg(kernel, 3, sizeof(size_t), &HW);
+            err |= clSetKernelArg(kernel, 4, sizeof(size_t), &HW);
+            err |= clSetKernelArg(kernel, 5, sizeof(size_t), &C);
+            err |= clSetKernelArg(kernel, 6, sizeof(float), &scale);
+            CHECK_ARG(err, "util/batch_matmul_scale", model, shape);
+            size_t globalSize[3] = {1, HW / reg_size, HW / reg_size};
+            size_t localSize[3] = {1, tile_size / reg_size, tile_size / reg_size};
+            measure("util/batch_matmul_scale", model, shape, kernel, 3, globalSize, localSize,
+                    flops, bytes);
+        }
+    }
+
+    /* strided : QK (HW, HW) = Q^T (HW, C) x K (C, HW) without permuting Q */
+    int _HW = static_cast<int>(HW);
+    cl_int4 rowMajor = {{0, 0, _HW, 1}};
+    cl_int4 transposed = {{0, 0, 1, _HW}};
+    size_t stridedLocalSize[3] = {1, STRIDED_TILE / STRIDED_REG, STRIDED_TILE / STRIDED_REG};
+    {
+        auto kernel = utilKernel->strided_batch_matmul;
+        err = setStridedMatmulArgs(kernel, &q, &k, &qk, HW, HW, C, transposed, rowMajor, rowMajor,
+                                   scale);
+        CHECK_ARG(err, "util/strided_batch_matmul", model, shape);
+        size_t globalSize[3] = {1, stridedGlobalSize(HW), stridedGlobalSize(HW)};
+        measure("util/strided_batch_matmul", model, shape, kernel, 3, globalSize,
+                stridedLocalSize, flops, bytes);
+    }
+
+    {
+        auto kernel = utilKernel->softmax;
+        size_t workGroupSize = WORK_GROUP_SIZE;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 2, sizeof(float) * workGroupSize, nullptr);
+        err |= clSetKernelArg(kernel, 3, sizeof(float) * HW, nullptr);
+        err |= clSetKernelArg(kernel, 4, sizeof(size_t), &HW);
+        CHECK_ARG(err, "util/softmax", model, shape);
+        size_t globalSize[1] = {HW * workGroupSize};
+        size_t localSize[1] = {workGroupSize};
+        measure("util/softmax", model, shape, kernel, 1, globalSize, localSize,
+                3.0 * HW * HW, 2.0 * sizeof(float) * HW * HW);
+    }
+
+    /* softmax_online (util.cl) */
+    {
+        auto kernel = utilKernel->softmax_online;
+        size_t workGroupSize = WORK_GROUP_SIZE;
+        int rowSize = static_cast<int>(HW);
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 2, sizeof(float) * workGroupSize, nullptr);
+        err |= clSetKernelArg(kernel, 3, sizeof(float) * workGroupSize, nullptr);
+        err |= clSetKernelArg(kernel, 4, sizeof(int), &rowSize);
+        CHECK_ARG(err, "util/softmax_online", model, shape);
+        size_t globalSize[1] = {HW * workGroupSize};
+        size_t localSize[1] = {workGroupSize};
+        measure("util/softmax_online", model, shape, kernel, 1, globalSize, localSize,
+                4.0 * HW * HW, 3.0 * sizeof(float) * HW * HW);
+    }
+
+    /* softmax_online_half (util.cl) : the float buffer is read as half (same row count) */
+    {
+        auto kernel = utilKernel->softmax_online_half;
+        size_t workGroupSize = WORK_GROUP_SIZE;
+        int rowSize = static_cast<int>(HW);
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 2, sizeof(float) * workGroupSize, nullptr);
+        err |= clSetKernelArg(kernel, 3, sizeof(float) * workGroupSize, nullptr);
+        err |= clSetKernelArg(kernel, 4, sizeof(int), &rowSize);
+        CHECK_ARG(err, "util/softmax_online_half", model, shape);
+        size_t globalSize[1] = {HW * workGroupSize};
+        size_t localSize[1] = {workGroupSize};
+        measure("util/softmax_online_half", model, shape, kernel, 1, globalSize, localSize,
+                4.0 * HW * HW, 3.0 * sizeof(cl_half) * HW * HW);
+    }
+
+    {
+        auto kernel = utilKernel->permute3D_0_2_1;
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &qk);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &permuteQK);
+        CHECK_ARG(err, "util/permute3D__0_2_1", model, shape);
+        size_t globalSize[3] = {1, HW, HW};
+        auto qkShape = "HW=" + std::to_string(HW) + " HW=" + std::to_string(HW);
+        measure("util/permute3D__0_2_1", model, qkShape, kernel, 3, globalSize, nullptr, 0,
+                2.0 * sizeof(float) * HW * HW);
+    }
+
+    /* strided : out (C, HW) = V (C, HW) x QK^T (HW, HW) without permuting QK */
+    {
+        auto kernel = utilKernel->strided_batch_matmul;
+        err = setStridedMatmulArgs(kernel, &q, &qk, &k, C, HW, HW, rowMajor, transposed, rowMajor,
+                                   1.0f);
+        CHECK_ARG(err, "util/strided_batch_matmul", model, shape);
+        size_t globalSize[3] = {1, stridedGlobalSize(C), stridedGlobalSize(HW)};
+        auto vShape = "C=" + std::to_string(C) + " HW=" + std::to_string(HW) + " HW=" +
+                      std::to_string(HW);
+        measure("util/strided_batch_matmul", model, vShape, kernel, 3, globalSize,
+                stridedLocalSize, flops, bytes);
+    }
+
+    releaseBuffers();
+}
+
+/* one result per line, so that two runs can be compared with diff */
+std::string KernelBenchmark::toJson() {
+    char deviceName[256] = {0};
+    char driverVersion[256] = {0};
+    clGetDeviceInfo(deviceId, CL_DEVICE_NAME, sizeof(deviceName) - 1, deviceName, nullptr);
+    clGetDeviceInfo(deviceId, CL_DRIVER_VERSION, sizeof(driverVersion) - 1, driverVersion,
+                    nullptr);
+
+    std::ostringstream oss;
+    oss.setf(std::ios::fixed);
+    oss.precision(3);
+    oss << "{\n";
+    oss << "  \"device\": \"" << deviceName << "\",\n";
+    oss << "  \"driver\": \"" << driverVersion << "\",\n";
+    oss << "  \"warm_up\": " << BENCHMARK_WARM_UP << ",\n";
+    oss << "  \"repeat\": " << BENCHMARK_REPEAT << ",\n";
+    oss << "  \"results\": [\n";
+    for (int i = 0; i < results.size(); i++) {
+        auto &result = results[i];
+        oss << "    {\"model\": \"" << result.model << "\", \"kernel\": \"" << result.kernel
+            << "\", \"shape\": \"" << result.shape << "\", ";
+        if (result.err != CL_SUCCESS) {
+            oss << "\"error\": " << result.err;
+        } else {
+            /* ms -> s */
+            auto seconds = result.time / 1000.0;
+            oss << "\"time_ms\": " << result.time << ", \"mean_ms\": " << result.mean
+                << ", \"gflops\": " << (seconds > 0 ? result.flops / seconds / 1e9 : 0)
+                << ", \"gbps\": " << (seconds > 0 ? result.bytes / seconds / 1e9 : 0);
+        }
+        oss << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    oss << "  ]\n";
+    oss << "}\n";
+    return oss.str();
+}
@@ -0,0 +1,108 @@
+//
+// Created by 구현우 on 2024/07/08.
+//
+
+#ifndef MY_OPENCL_KERNELBENCHMARK_H
+#define MY_OPENCL_KERNELBENCHMARK_H
+
+#define CL_TARGET_OPENCL_VERSION 200
+
+#include "CL/opencl.h"
+
+#include <android/asset_manager_jni.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kernel/unit/LinearKernel.h"
+#include "kernel/unit/ConvKernel.h"
+#include "kernel/unit/CrossAttentionKernel.h"
+#include "kernel/unit/MultiHeadAttentionKernel.h"
+#include "kernel/unit/GroupNormKernel.h"
+#include "kernel/unit/UtilKernel.h"
+
+/*
+ * kernel 단위 micro benchmark.
+ * SD2 TextEncoder / UNet / Decoder 에서 사용하는 shape 으로 각 kernel 을 직접 launch 하고
+ * OpenCL event time (min, mean) 과 GFLOP/s, GB/s 를 JSON 으로 저장.
+ * GB/s 는 compulsory traffic (input + weight + output 1회) 기준.
+ *
+ * result : MEDIA_PATH/benchmark/kernel_benchmark.json
+ */
+class KernelBenchmark {
+public:
+    KernelBenchmark(cl_context context, cl_command_queue cmdQueue, cl_device_id deviceId,
+                    AAssetManager *assetManager);
+
+    ~KernelBenchmark();
+
+    /* @return: JSON */
+    std::string run();
+
+private:
+    struct Result {
+        std::string kernel;
+        std::string model;
+        std::string shape;
+        cl_int err;
+        double time;
+        double mean;
+        double flops;
+        double bytes;
+    };
+
+    cl_mem createBuffer(size_t size);
+
+    void releaseBuffers();
+
+    void measure(const std::string &kernel, const std::string &model, const std::string &shape,
+                 cl_kernel clKernel, cl_uint work_dim, const size_t *globalWorkSize,
+                 const size_t *localWorkSize, double flops, double bytes);
+
+    void skip(const std::string &kernel, const std::string &model, const std::string &shape,
+              cl_int err);
+
+    void benchmarkLinear(const std::string &model, size_t M, size_t N, size_t K);
+
+    void benchmarkConv2D(const std::string &model, size_t in_channel, size_t out_channel,
+                         size_t inputSize, size_t kernel_size, int stride);
+
+    void benchmarkCrossAttention(const std::string &model, size_t B, size_t M, size_t N,
+                                 size_t K);
+
+    void benchmarkMultiHeadAttention(const std::string &model, size_t numHeads,
+                                     size_t contextLength, size_t headDim);
+
+    void benchmarkTokenEmbedding(const std::string &model, size_t contextLength,
+                                 size_t embeddingSize, size_t vocabSize);
+
+    void benchmarkLatentPreview(const std::string &model, size_t channels, size_t heightXwidth);
+
+    /* channelLast : SpatialTransformer 경계의 group_norm_channel_last, channel_first_add 도 측정 */
+    void benchmarkGroupNorm(const std::string &model, size_t channels, size_t heightXwidth,
+                            bool channelLast = false);
+
+    void benchmarkElemwise(const std::string &model, size_t channels, size_t heightXwidth);
+
+    void benchmarkAttnBlock(const std::string &model, size_t channels, size_t heightXwidth);
+
+    std::string toJson();
+
+    cl_context context;
+    cl_command_queue cmdQueue;
+    cl_device_id deviceId;
+
+    std::shared_ptr<LinearKernel> linearKernel;
+    std::shared_ptr<ConvKernel> convKernel;
+    std::shared_ptr<CrossAttentionKernel> crossAttentionKernel;
+    std::shared_ptr<MultiHeadAttentionKernel> multiHeadAttentionKernel;
+    std::shared_ptr<GroupNormKernel> groupNormKernel;
+    std::shared_ptr<UtilKernel> utilKernel;
+
+    cl_ulong maxAllocSize;
+    std::vector<cl_mem> buffers;
+    std::vector<Result> results;
+};
+
+
+#endif //MY_OPENCL_KERNELBENCHMARK_H
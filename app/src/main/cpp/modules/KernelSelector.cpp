@@ -0,0 +1,121 @@
+//
+// Created by 구현우 on 2024/07/05.
+//
+
+#include "KernelSelector.h"
+
+#include <android/log.h>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#define LOG_TAG "KERNEL_SELECTOR"
+
+#define MEDIA_PATH "/sdcard/Android/media/com.example.myopencl/"
+
+static const char *kernelNames[KernelSelector::NUM_KERNELS] = {
+        "linear", "cross_attention", "conv2d"
+};
+
+static int findKernel(const std::string &name) {
+    for (int i = 0; i < KernelSelector::NUM_KERNELS; i++) {
+        if (name == kernelNames[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+KernelSelector &KernelSelector::getInstance() {
+    static KernelSelector instance;
+    return instance;
+}
+
+void KernelSelector::init() {
+    std::lock_guard<std::mutex> lock(mutex);
+    versions.clear();
+    for (auto &version: forced) {
+        version = -1;
+    }
+
+    std::ifstream file(MEDIA_PATH "kernel_config.txt");
+    if (!file.is_open()) {
+        return;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        std::string first, second;
+        int version;
+        if (!(iss >> first >> second >> version)) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "invalid line: %s", line.c_str());
+            continue;
+        }
+
+        if (first == "force") {
+            auto kernel = findKernel(second);
+            if (kernel >= 0) {
+                forced[kernel] = version;
+                __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "force %s version(%d)",
+                                    second.c_str(), version);
+            }
+            continue;
+        }
+
+        auto kernel = findKernel(first);
+        if (kernel < 0) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "unknown kernel: %s", first.c_str());
+            continue;
+        }
+        versions[std::make_pair(kernel, second)] = version;
+    }
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "init: %ld layer versions", versions.size());
+}
+
+void KernelSelector::force(int kernel, int version) {
+    std::lock_guard<std::mutex> lock(mutex);
+    forced[kernel] = version;
+}
+
+void KernelSelector::set(int kernel, const std::string &layer, int version) {
+    std::lock_guard<std::mutex> lock(mutex);
+    versions[std::make_pair(kernel, layer)] = version;
+}
+
+int KernelSelector::select(int kernel, const std::string &layer, int defaultVersion,
+                           bool *configured) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool tmp;
+    auto _configured = configured ?: &tmp;
+    *_configured = true;
+
+    if (forced[kernel] >= 0) {
+        return forced[kernel];
+    }
+
+    auto it = versions.find(std::make_pair(kernel, layer));
+    if (it != versions.end()) {
+        return it->second;
+    }
+
+    it = versions.find(std::make_pair(kernel, std::string("*")));
+    if (it != versions.end()) {
+        return it->second;
+    }
+
+    *_configured = false;
+    return defaultVersion;
+}
+
+bool KernelSelector::isForced(int kernel) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return forced[kernel] >= 0;
+}
+
+const char *KernelSelector::getKernelName(int kernel) {
+    return kernelNames[kernel];
+}
@@ -0,0 +1,60 @@
+//
+// Created by 구현우 on 2024/07/05.
+//
+
+#ifndef MY_OPENCL_KERNELSELECTOR_H
+#define MY_OPENCL_KERNELSELECTOR_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+/*
+ * runtime kernel version selection (replaces recompiling with setting.h)
+ * priority : force > config(layer) > config(*) > default (setting.h)
+ *
+ * config file : MEDIA_PATH/kernel_config.txt
+ *   # <kernel> <layer weight name | *> <version>
+ *   conv2d * 8
+ *   linear unet/input_block/1/..._proj_in_weight.npy 5
+ *   force conv2d 6
+ */
+class KernelSelector {
+public:
+    enum Kernel {
+        LINEAR = 0,
+        CROSS_ATTENTION = 1,
+        CONV_2D = 2,
+        NUM_KERNELS = 3,
+    };
+
+    static KernelSelector &getInstance();
+
+    void init();
+
+    /* `version` < 0 : release */
+    void force(int kernel, int version);
+
+    void set(int kernel, const std::string &layer, int version);
+
+    /*
+     * @return: version for `layer`. `configured` = forced or set in config
+     */
+    int select(int kernel, const std::string &layer, int defaultVersion,
+               bool *configured = nullptr);
+
+    bool isForced(int kernel);
+
+    static const char *getKernelName(int kernel);
+
+private:
+    KernelSelector() = default;
+
+    int forced[NUM_KERNELS] = {-1, -1, -1};
+    std::map<std::pair<int, std::string>, int> versions;
+    std::mutex mutex;
+};
+
+
+#endif //MY_OPENCL_KERNELSELECTOR_H
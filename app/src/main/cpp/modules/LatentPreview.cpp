@@ -0,0 +1,109 @@
+//
+// Created by 구현우 on 2024/07/25.
+//
+
+#include "LatentPreview.h"
+
+#include <android/log.h>
+#include <stdexcept>
+
+#include "Tracer.h"
+
+#define LOG_TAG "LATENT_PREVIEW"
+
+#define LATENT_CHANNELS 4
+
+#define CHECK_ERROR_THROW(err) \
+    if (err != CL_SUCCESS) { \
+      __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "[%s:%d] OpenCL error %d\n", __FILE__, __LINE__, err); \
+      throw std::runtime_error("OpenCL error."); \
+    }
+
+/* (r, g, b) x latent channel. SD 1.x latent (scale 전) 기준 */
+static const float DEFAULT_WEIGHT[3 * LATENT_CHANNELS] = {
+        0.3512f, 0.3250f, -0.2829f, -0.2120f,
+        0.2297f, 0.4974f, 0.1762f, -0.2616f,
+        0.3227f, 0.2350f, 0.2721f, -0.7177f,
+};
+
+static const float DEFAULT_BIAS[3] = {0.f, 0.f, 0.f};
+
+LatentPreview::LatentPreview(
+        cl_context context, cl_command_queue cmdQueue, cl_device_id deviceId,
+        AAssetManager *assetManager, const std::vector<float> &weight,
+        const std::vector<float> &bias
+) : context(context), cmdQueue(cmdQueue) {
+    if ((!weight.empty() && weight.size() != 3 * LATENT_CHANNELS) ||
+        (!bias.empty() && bias.size() != 3)) {
+        throw std::runtime_error("LatentPreview weight must be (3, 4) and bias (3)");
+    }
+    cl_int err;
+    utilKernel = std::make_shared<UtilKernel>(context, deviceId, assetManager);
+
+    bufferWeight = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                  sizeof(float) * 3 * LATENT_CHANNELS,
+                                  const_cast<float *>(weight.empty() ? DEFAULT_WEIGHT
+                                                                     : weight.data()),
+                                  &err);
+    CHECK_ERROR_THROW(err);
+
+    bufferBias = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                sizeof(float) * 3,
+                                const_cast<float *>(bias.empty() ? DEFAULT_BIAS : bias.data()),
+                                &err);
+    CHECK_ERROR_THROW(err);
+}
+
+LatentPreview::~LatentPreview() {
+    clReleaseMemObject(bufferWeight);
+    clReleaseMemObject(bufferBias);
+}
+
+std::vector<float>
+LatentPreview::preview(const std::vector<float> &latent, size_t height, size_t width) {
+    if (latent.size() != LATENT_CHANNELS * height * width) {
+        throw std::runtime_error("LatentPreview input size != latent shape");
+    }
+
+    cl_int err;
+    cl_event event[2];
+    cl_mem bufferLatent, bufferOut;
+    std::vector<float> result(3 * height * width);
+
+    bufferLatent = clCreateBuffer(context, CL_MEM_READ_ONLY, sizeof(float) * latent.size(),
+                                  nullptr, &err);
+    CHECK_ERROR_THROW(err);
+
+    bufferOut = clCreateBuffer(context, CL_MEM_WRITE_ONLY, sizeof(float) * result.size(),
+                               nullptr, &err);
+    CHECK_ERROR_THROW(err);
+
+    err = clEnqueueWriteBuffer(cmdQueue, bufferLatent, CL_FALSE, 0,
+                               sizeof(float) * latent.size(), latent.data(),
+                               0, nullptr, &event[0]);
+    CHECK_ERROR_THROW(err);
+
+    err = clSetKernelArg(utilKernel->latent_preview, 0, sizeof(cl_mem), &bufferLatent);
+    err |= clSetKernelArg(utilKernel->latent_preview, 1, sizeof(cl_mem), &bufferWeight);
+    err |= clSetKernelArg(utilKernel->latent_preview, 2, sizeof(cl_mem), &bufferBias);
+    err |= clSetKernelArg(utilKernel->latent_preview, 3, sizeof(cl_mem), &bufferOut);
+    CHECK_ERROR_THROW(err);
+
+    size_t globalSize[1] = {height * width};
+    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->latent_preview, 1, nullptr,
+                                 globalSize, nullptr, 1, &event[0], &event[1]);
+    CHECK_ERROR_THROW(err);
+    Tracer::getInstance().record("latent_preview", event[1]);
+
+    err = clEnqueueReadBuffer(cmdQueue, bufferOut, CL_TRUE, 0,
+                              sizeof(float) * result.size(), result.data(),
+                              1, &event[1], nullptr);
+    CHECK_ERROR_THROW(err);
+
+    for (auto &e: event) {
+        clReleaseEvent(e);
+    }
+    clReleaseMemObject(bufferLatent);
+    clReleaseMemObject(bufferOut);
+    return result;
+}
@@ -0,0 +1,46 @@
+//
+// Created by 구현우 on 2024/07/25.
+//
+
+#ifndef MY_OPENCL_LATENTPREVIEW_H
+#define MY_OPENCL_LATENTPREVIEW_H
+
+#define CL_TARGET_OPENCL_VERSION 200
+
+#include "CL/opencl.h"
+
+#include <android/asset_manager.h>
+#include <memory>
+#include <vector>
+
+#include "kernel/unit/UtilKernel.h"
+
+/*
+ * denoise 중간 결과를 decoder 없이 보여주기 위한 저해상도 preview.
+ * latent 4 channel 을 pixel 별 4x3 linear 로 rgb 로 (latent_preview kernel). 크기는 latent 그대로 (image / 8).
+ * weight 는 SD latent -> rgb 근사 계수가 기본값. 학습한 계수가 있으면 생성자로 교체.
+ */
+class LatentPreview {
+public:
+    /* `weight`: (3, 4) row-major, `bias`: (3). empty 이면 기본값 */
+    LatentPreview(cl_context context, cl_command_queue cmdQueue, cl_device_id deviceId,
+                  AAssetManager *assetManager, const std::vector<float> &weight = {},
+                  const std::vector<float> &bias = {});
+
+    ~LatentPreview();
+
+    /* `latent`: (4, height, width) -> (3, height, width), [-1, 1] */
+    std::vector<float> preview(const std::vector<float> &latent, size_t height, size_t width);
+
+private:
+    cl_context context;
+    cl_command_queue cmdQueue;
+
+    std::shared_ptr<UtilKernel> utilKernel;
+
+    cl_mem bufferWeight;
+    cl_mem bufferBias;
+};
+
+
+#endif //MY_OPENCL_LATENTPREVIEW_H
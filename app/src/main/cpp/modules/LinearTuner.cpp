@@ -0,0 +1,180 @@
+//
+// Created by 구현우 on 2024/07/02.
+//
+
+#include "LinearTuner.h"
+#include "util.h"
+
+#include <android/log.h>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#define LOG_TAG "LINEAR_TUNER"
+
+#define MEDIA_PATH "/sdcard/Android/media/com.example.myopencl/"
+
+#define TUNE_WARM_UP 1
+#define TUNE_REPEAT 3
+
+LinearTuner &LinearTuner::getInstance() {
+    static LinearTuner instance;
+    return instance;
+}
+
+void LinearTuner::init(cl_device_id deviceId, int _mode) {
+    std::lock_guard<std::mutex> lock(mutex);
+    mode = _mode;
+
+    char deviceName[256] = {0};
+    char driverVersion[256] = {0};
+    clGetDeviceInfo(deviceId, CL_DEVICE_NAME, sizeof(deviceName) - 1, deviceName, nullptr);
+    clGetDeviceInfo(deviceId, CL_DRIVER_VERSION, sizeof(driverVersion) - 1, driverVersion,
+                    nullptr);
+
+    auto key = std::string(deviceName) + "_" + std::string(driverVersion);
+    for (auto &c: key) {
+        if (!isalnum(c) && c != '.') {
+            c = '_';
+        }
+    }
+    path = std::string(MEDIA_PATH) + "tuning/linear_" + key + ".txt";
+
+    table.clear();
+    load();
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "init: mode(%d) %s (%ld entries)",
+                        mode, path.c_str(), table.size());
+}
+
+void LinearTuner::setMode(int _mode) {
+    std::lock_guard<std::mutex> lock(mutex);
+    mode = _mode;
+}
+
+int LinearTuner::getMode() const {
+    return mode;
+}
+
+bool LinearTuner::find(size_t M, size_t N, size_t K, LinearConfig *config) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (mode == OFF) {
+        return false;
+    }
+    auto it = table.find(std::make_tuple(M, N, K));
+    if (it == table.end()) {
+        return false;
+    }
+    *config = it->second;
+    return true;
+}
+
+bool LinearTuner::tune(size_t M, size_t N, size_t K,
+                       const std::function<cl_int(const LinearConfig &, cl_event *)> &launch,
+                       LinearConfig *config) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (mode != TUNE) {
+        return false;
+    }
+
+    bool found = false;
+    LinearConfig best{};
+    for (auto candidate: getCandidates(M, N)) {
+        double minTime = -1;
+        for (int i = 0; i < TUNE_WARM_UP + TUNE_REPEAT; i++) {
+            cl_event event;
+            if (launch(candidate, &event) != CL_SUCCESS) {
+                minTime = -1;
+                break;
+            }
+            clWaitForEvents(1, &event);
+            auto time = util::getEventTime(event);
+            clReleaseEvent(event);
+            if (i >= TUNE_WARM_UP && (minTime < 0 || time < minTime)) {
+                minTime = time;
+            }
+        }
+        if (minTime < 0) {
+            continue;
+        }
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG,
+                            "tune (%ld, %ld, %ld) version(%d) tile(%ld, %ld): %0.3f ms",
+                            M, N, K, candidate.version, candidate.tile_size_m,
+                            candidate.tile_size_n, minTime);
+        if (!found || minTime < best.time) {
+            best = candidate;
+            best.time = minTime;
+            found = true;
+        }
+    }
+
+    if (!found) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "tune (%ld, %ld, %ld): no valid config",
+                            M, N, K);
+        return false;
+    }
+
+    table[std::make_tuple(M, N, K)] = best;
+    save();
+    *config = best;
+    return true;
+}
+
+std::vector<LinearConfig> LinearTuner::getCandidates(size_t M, size_t N) {
+    std::vector<size_t> tile_size_ms = {64, 32, 16, 11, 8, 7, 4, 2, 1};
+    std::vector<size_t> tile_size_ns = {256, 128, 64, 32};
+
+    std::vector<LinearConfig> candidates;
+    for (auto tile_size_m: tile_size_ms) {
+        if (M % tile_size_m != 0) {
+            continue;
+        }
+        for (auto tile_size_n: tile_size_ns) {
+            if (N % tile_size_n != 0) {
+                continue;
+            }
+            candidates.push_back({4, tile_size_m, tile_size_n, 0});
+            if (tile_size_m % 2 == 0) {
+                candidates.push_back({5, tile_size_m, tile_size_n, 0});
+            }
+        }
+    }
+    return candidates;
+}
+
+void LinearTuner::load() {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        size_t M, N, K;
+        LinearConfig config{};
+        if (iss >> M >> N >> K >> config.version >> config.tile_size_m >> config.tile_size_n
+                >> config.time) {
+            table[std::make_tuple(M, N, K)] = config;
+        }
+    }
+}
+
+void LinearTuner::save() {
+    mkdir((std::string(MEDIA_PATH) + "tuning").c_str(), 0777);
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to open %s", path.c_str());
+        return;
+    }
+
+    file << "# M N K version tile_size_m tile_size_n time(ms)\n";
+    for (auto &entry: table) {
+        auto &config = entry.second;
+        file << std::get<0>(entry.first) << " " << std::get<1>(entry.first) << " "
+             << std::get<2>(entry.first) << " " << config.version << " "
+             << config.tile_size_m << " " << config.tile_size_n << " " << config.time << "\n";
+    }
+}
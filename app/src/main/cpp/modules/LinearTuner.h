@@ -0,0 +1,76 @@
+//
+// Created by 구현우 on 2024/07/02.
+//
+
+#ifndef MY_OPENCL_LINEARTUNER_H
+#define MY_OPENCL_LINEARTUNER_H
+
+#define CL_TARGET_OPENCL_VERSION 200
+
+#include "CL/opencl.h"
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/*
+ * version 4 : tile_reg_n_vector_linear (reg_size_n = 8, WIDTH = 4)
+ * version 5 : tile_reg_m_n_vector_linear (reg_size_m = 2, reg_size_n = 4, WIDTH = 4)
+ */
+struct LinearConfig {
+    int version;
+    size_t tile_size_m;
+    size_t tile_size_n;
+    double time;
+};
+
+/*
+ * (M, N, K) 별 Linear kernel config 를 device 마다 benchmark 후 저장.
+ * tuning database : MEDIA_PATH/tuning/linear_<device>_<driver>.txt
+ */
+class LinearTuner {
+public:
+    enum Mode {
+        OFF = 0,
+        LOOKUP = 1,
+        TUNE = 2,
+    };
+
+    static LinearTuner &getInstance();
+
+    void init(cl_device_id deviceId, int mode);
+
+    void setMode(int mode);
+
+    int getMode() const;
+
+    bool find(size_t M, size_t N, size_t K, LinearConfig *config);
+
+    /*
+     * `launch` enqueues one run of `config` and returns its event.
+     * Failed launches (e.g. invalid work group size) are skipped.
+     */
+    bool tune(size_t M, size_t N, size_t K,
+              const std::function<cl_int(const LinearConfig &, cl_event *)> &launch,
+              LinearConfig *config);
+
+private:
+    LinearTuner() = default;
+
+    std::vector<LinearConfig> getCandidates(size_t M, size_t N);
+
+    void load();
+
+    void save();
+
+    int mode = OFF;
+    std::string path;
+    std::map<std::tuple<size_t, size_t, size_t>, LinearConfig> table;
+    std::mutex mutex;
+};
+
+
+#endif //MY_OPENCL_LINEARTUNER_H
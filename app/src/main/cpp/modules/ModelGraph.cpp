@@ -0,0 +1,717 @@
+//
+// Created by 구현우 on 2024/07/20.
+//
+
+#include "ModelGraph.h"
+
+#include <algorithm>
+#include <android/log.h>
+
+#include "Tracer.h"
+#include "CommandRecorder.h"
+#include "ResidencyManager.h"
+#include "nn/Conv2D.h"
+#include "nn/Linear.h"
+#include "nn/GroupNorm.h"
+#include "nn/ResBlock.h"
+#include "nn/SpatialTransformer.h"
+#include "nn/AttnBlock.h"
+#include "nn/UpSample.h"
+
+#define LOG_TAG "MODEL_GRAPH"
+
+#define CHECK_ERROR_THROW(err) \
+    if (err != CL_SUCCESS) { \
+      __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "[%s:%d] OpenCL error %d\n", __FILE__, __LINE__, err); \
+      throw std::runtime_error("OpenCL error."); \
+    }
+
+class ModelGraph::Layer {
+public:
+    virtual ~Layer() = default;
+
+    virtual void init() = 0;
+
+    /* `shape`: inputs[0] 의 shape (shape 을 쓰지 않는 layer 의 forwardLayer 는 이름 없이 받음) */
+    virtual cl_int forward(const std::vector<cl_mem> &inputs, const Tensor &shape, cl_mem output,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event) = 0;
+};
+
+static cl_int forwardLayer(Conv2D *layer, const std::vector<cl_mem> &inputs,
+                           const ModelGraph::Tensor &shape, cl_mem output,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event) {
+    return layer->forward(inputs[0], output, shape.height, shape.width, num_events_in_list,
+                          event_wait_list, event);
+}
+
+static cl_int forwardLayer(Linear *layer, const std::vector<cl_mem> &inputs,
+                           const ModelGraph::Tensor &, cl_mem output,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event) {
+    return layer->forward(inputs[0], output, num_events_in_list, event_wait_list, event);
+}
+
+static cl_int forwardLayer(GroupNorm *layer, const std::vector<cl_mem> &inputs,
+                           const ModelGraph::Tensor &, cl_mem output,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event) {
+    return layer->forward(inputs[0], output, num_events_in_list, event_wait_list, event);
+}
+
+static cl_int forwardLayer(AttnBlock *layer, const std::vector<cl_mem> &inputs,
+                           const ModelGraph::Tensor &shape, cl_mem output,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event) {
+    return layer->forward(inputs[0], output, shape.height, shape.width, num_events_in_list,
+                          event_wait_list, event);
+}
+
+static cl_int forwardLayer(UpSample *layer, const std::vector<cl_mem> &inputs,
+                           const ModelGraph::Tensor &shape, cl_mem output,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event) {
+    return layer->forward(inputs[0], output, shape.height, shape.width, num_events_in_list,
+                          event_wait_list, event);
+}
+
+/* input 과 embedding 모두 같은 wait list */
+static cl_int forwardLayer(ResBlock *layer, const std::vector<cl_mem> &inputs,
+                           const ModelGraph::Tensor &shape, cl_mem output,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event) {
+    cl_mem input = inputs[0];
+    cl_mem embed = inputs.size() > 1 ? inputs[1] : nullptr;
+    return layer->forward(input, embed, output, shape.height, shape.width,
+                          embed != nullptr ? num_events_in_list : 0,
+                          embed != nullptr ? event_wait_list : nullptr,
+                          num_events_in_list, event_wait_list, event);
+}
+
+static cl_int forwardLayer(SpatialTransformer *layer, const std::vector<cl_mem> &inputs,
+                           const ModelGraph::Tensor &, cl_mem output,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event) {
+    return layer->forward(inputs[0], inputs[1], output, num_events_in_list, event_wait_list,
+                          event);
+}
+
+template<typename T>
+class LayerImpl : public ModelGraph::Layer {
+public:
+    explicit LayerImpl(T *layer) : layer(layer) {}
+
+    void init() override {
+        layer->init();
+    }
+
+    cl_int forward(const std::vector<cl_mem> &inputs, const ModelGraph::Tensor &shape,
+                   cl_mem output, cl_uint num_events_in_list, const cl_event *event_wait_list,
+                   cl_event *event) override {
+        return forwardLayer(layer.get(), inputs, shape, output, num_events_in_list,
+                            event_wait_list, event);
+    }
+
+private:
+    std::unique_ptr<T> layer;
+};
+
+template<typename T>
+static std::unique_ptr<ModelGraph::Layer> makeLayer(T *layer) {
+    return std::unique_ptr<ModelGraph::Layer>(new LayerImpl<T>(layer));
+}
+
+static bool isInPlace(ModelGraph::OpType type) {
+    switch (type) {
+        case ModelGraph::RES_BLOCK:
+        case ModelGraph::SPATIAL_TRANSFORMER:
+        case ModelGraph::ATTN_BLOCK:
+        case ModelGraph::GROUP_NORM:
+        case ModelGraph::SILU:
+            return true;
+        default:
+            return false;
+    }
+}
+
+ModelGraph::ModelGraph(cl_context context, cl_command_queue cmdQueue, cl_device_id deviceId,
+                       AAssetManager *assetManager)
+        : context(context), cmdQueue(cmdQueue), deviceId(deviceId), assetManager(assetManager) {}
+
+ModelGraph::~ModelGraph() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    for (size_t i = 0; i < residency.size(); i++) {
+        release(i);
+    }
+}
+
+int ModelGraph::input(size_t channels, size_t height, size_t width) {
+    auto id = addTensor({channels, height, width});
+    inputIds.push_back(id);
+    return id;
+}
+
+int ModelGraph::conv2d(const std::string &name, const std::string &prefix, int x,
+                       size_t out_channels, size_t kernel_size, int stride, int padding) {
+    auto node = makeNode(CONV_2D, name, prefix, x);
+    node.out_channels = out_channels;
+    node.kernel_size = kernel_size;
+    node.stride = stride;
+    node.padding = padding;
+    auto &in = tensors[x];
+    return addNode(node, {out_channels,
+                          (in.height + 2 * padding - kernel_size) / stride + 1,
+                          (in.width + 2 * padding - kernel_size) / stride + 1});
+}
+
+int ModelGraph::linear(const std::string &name, const std::string &prefix, int x,
+                       size_t out_features) {
+    auto node = makeNode(LINEAR, name, prefix, x);
+    node.out_channels = out_features;
+    return addNode(node, {out_features, 1, 1});
+}
+
+int ModelGraph::groupNorm(const std::string &name, const std::string &prefix, int x,
+                          size_t groups, float eps) {
+    auto node = makeNode(GROUP_NORM, name, prefix, x);
+    node.groups = groups;
+    node.eps = eps;
+    return addNode(node, tensors[x]);
+}
+
+int ModelGraph::silu(const std::string &name, int x) {
+    return addNode(makeNode(SILU, name, "", x), tensors[x]);
+}
+
+int ModelGraph::concat(const std::string &name, int a, int b) {
+    auto node = makeNode(CONCAT, name, "", a);
+    node.inputs.push_back(b);
+    auto &x = tensors[a], &y = tensors[b];
+    if (x.height != y.height || x.width != y.width) {
+        throw std::runtime_error("concat: height, width mismatch (" + name + ")");
+    }
+    node.out_channels = x.channels + y.channels;
+    return addNode(node, {node.out_channels, x.height, x.width});
+}
+
+int ModelGraph::resBlock(const std::string &name, const std::string &prefix, Naming naming,
+                         int x, int emb, size_t out_channels) {
+    auto node = makeNode(RES_BLOCK, name, prefix, x);
+    node.naming = naming;
+    node.out_channels = out_channels;
+    if (emb >= 0) {
+        node.inputs.push_back(emb);
+    }
+    auto &in = tensors[x];
+    return addNode(node, {out_channels, in.height, in.width});
+}
+
+int ModelGraph::spatialTransformer(const std::string &name, const std::string &prefix,
+                                   Naming naming, int x, int context, size_t heads) {
+    auto node = makeNode(SPATIAL_TRANSFORMER, name, prefix, x);
+    node.naming = naming;
+    node.inputs.push_back(context);
+    node.heads = heads;
+    return addNode(node, tensors[x]);
+}
+
+int ModelGraph::attnBlock(const std::string &name, const std::string &prefix, int x) {
+    return addNode(makeNode(ATTN_BLOCK, name, prefix, x), tensors[x]);
+}
+
+int ModelGraph::upSample(const std::string &name, const std::string &prefix, int x) {
+    auto node = makeNode(UP_SAMPLE, name, prefix, x);
+    auto &in = tensors[x];
+    return addNode(node, {in.channels, in.height * 2, in.width * 2});
+}
+
+void ModelGraph::load(size_t begin, size_t end, bool resident) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    for (size_t i = begin; i < end && i < nodes.size(); i++) {
+        if (nodes[i].type == SILU || nodes[i].type == CONCAT) {
+            nodes[i].resident = resident;
+            continue;
+        }
+        if (nodes[i].resident != resident) {
+            /* pinned <-> budget 안에서 유지 */
+            release(i);
+        }
+        nodes[i].resident = resident;
+        if (layers[i] == nullptr) {
+            layers[i] = createLayer(nodes[i]);
+        }
+        layers[i]->init();
+        if (resident && !residencyName.empty() && residency[i] == 0) {
+            residency[i] = ResidencyManager::getInstance().add(
+                    this, residencyName + "/" + nodes[i].name, weightBytesOf(nodes[i]),
+                    residencyPriority, true, nullptr);
+        }
+    }
+}
+
+void ModelGraph::unload(size_t begin, size_t end) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    for (size_t i = begin; i < end && i < nodes.size(); i++) {
+        nodes[i].resident = false;
+        release(i);
+        layers[i].reset();
+    }
+}
+
+void ModelGraph::setResidency(const std::string &name, int priority) {
+    residencyName = name;
+    residencyPriority = priority;
+}
+
+size_t ModelGraph::size() const {
+    return nodes.size();
+}
+
+const ModelGraph::Tensor &ModelGraph::getTensor(int id) const {
+    return tensors[id];
+}
+
+cl_mem ModelGraph::run(const std::vector<cl_mem> &inputs, const std::vector<cl_event> &events,
+                       int output, cl_event *event) {
+    cl_int err;
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (inputs.size() != inputIds.size() || events.size() != inputIds.size()) {
+        throw std::runtime_error("ModelGraph: input size mismatch");
+    }
+
+    long last = -1;
+    for (size_t i = 0; i < nodes.size() && last < 0; i++) {
+        if (nodes[i].output == output) {
+            last = static_cast<long>(i);
+        }
+    }
+    if (last < 0) {
+        throw std::runtime_error("ModelGraph: output is not produced by any node");
+    }
+
+    /* tensor 별 마지막으로 읽는 node (output 은 반환하므로 해제하지 않음) */
+    std::vector<long> lastUse(tensors.size(), -1);
+    for (long i = 0; i <= last; i++) {
+        for (auto x: nodes[i].inputs) {
+            lastUse[x] = i;
+        }
+    }
+    lastUse[output] = last + 1;
+
+    std::vector<Buffer> buffers;
+    std::vector<bool> owned;
+    std::vector<long> bufferOf(tensors.size(), -1);
+    std::vector<cl_event> producer(tensors.size(), nullptr);
+    std::vector<size_t> freeList;
+    std::vector<cl_event> issued;
+
+    for (size_t i = 0; i < inputIds.size(); i++) {
+        bufferOf[inputIds[i]] = static_cast<long>(buffers.size());
+        buffers.push_back({inputs[i], bytesOf(tensors[inputIds[i]]), {}});
+        owned.push_back(false);
+        producer[inputIds[i]] = events[i];
+    }
+
+    for (long i = 0; i <= last; i++) {
+        auto &node = nodes[i];
+        auto bytes = bytesOf(tensors[node.output]);
+
+        std::vector<cl_event> waitList;
+        std::vector<cl_mem> in;
+        for (auto x: node.inputs) {
+            if (bufferOf[x] < 0) {
+                throw std::runtime_error("ModelGraph: tensor is not ready (" + node.name + ")");
+            }
+            in.push_back(buffers[bufferOf[x]].buffer);
+            if (producer[x] != nullptr) {
+                waitList.push_back(producer[x]);
+            }
+        }
+
+        /* output buffer: in-place -> pool -> 새로 생성 */
+        long target = -1;
+        if (isInPlace(node.type)) {
+            auto x = node.inputs[0];
+            auto b = bufferOf[x];
+            if (lastUse[x] == i && owned[b] && buffers[b].bytes == bytes &&
+                std::count(node.inputs.begin(), node.inputs.end(), x) == 1) {
+                target = b;
+            }
+        }
+        if (target < 0) {
+            auto it = std::find_if(freeList.begin(), freeList.end(), [&](size_t b) {
+                return buffers[b].bytes == bytes;
+            });
+            if (it != freeList.end()) {
+                target = static_cast<long>(*it);
+                freeList.erase(it);
+            } else {
+                auto buffer = record::clCreateBuffer(context, CL_MEM_READ_WRITE, bytes, nullptr,
+                                                     &err);
+                CHECK_ERROR_THROW(err);
+                target = static_cast<long>(buffers.size());
+                buffers.push_back({buffer, bytes, {}});
+                owned.push_back(true);
+            }
+        }
+        /* 이전 tensor 를 읽던 node 가 끝난 후 덮어씀 */
+        waitList.insert(waitList.end(), buffers[target].events.begin(),
+                        buffers[target].events.end());
+        std::sort(waitList.begin(), waitList.end());
+        waitList.erase(std::unique(waitList.begin(), waitList.end()), waitList.end());
+
+        cl_event e;
+        {
+            Tracer::Scope scope(node.name);
+            auto out = buffers[target].buffer;
+            if (node.type == SILU) {
+                err = enqueueSilu(in[0], out, bytes / sizeof(float), waitList.size(),
+                                  waitList.empty() ? nullptr : waitList.data(), &e);
+            } else if (node.type == CONCAT) {
+                err = enqueueConcat(in[0], in[1], out, waitList.size(),
+                                    waitList.empty() ? nullptr : waitList.data(), &e);
+            } else {
+                if (layers[i] == nullptr) {
+                    layers[i] = createLayer(node);
+                }
+                layers[i]->init();
+                err = layers[i]->forward(in, tensors[node.inputs[0]], out, waitList.size(),
+                                         waitList.empty() ? nullptr : waitList.data(), &e);
+            }
+        }
+        CHECK_ERROR_THROW(err);
+        issued.push_back(e);
+
+        if (!node.resident && layers[i] != nullptr) {
+            retain(i);
+        }
+
+        producer[node.output] = e;
+        bufferOf[node.output] = target;
+        buffers[target].events = {e};
+        for (auto x: node.inputs) {
+            if (bufferOf[x] != target) {
+                buffers[bufferOf[x]].events.push_back(e);
+            }
+        }
+
+        /* 더 이상 읽지 않는 tensor 의 buffer 는 pool 로 */
+        for (auto x: node.inputs) {
+            auto b = bufferOf[x];
+            if (lastUse[x] == i && b != target && owned[b] &&
+                std::find(freeList.begin(), freeList.end(), b) == freeList.end()) {
+                freeList.push_back(b);
+            }
+        }
+        if (lastUse[node.output] < i) {
+            freeList.push_back(target);
+        }
+    }
+
+    auto result = buffers[bufferOf[output]].buffer;
+    clRetainEvent(producer[output]);
+    *event = producer[output];
+
+    for (size_t b = 0; b < buffers.size(); b++) {
+        if (owned[b] && buffers[b].buffer != result) {
+            record::clReleaseMemObject(buffers[b].buffer);
+        }
+    }
+    for (auto e: issued) {
+        clReleaseEvent(e);
+    }
+    return result;
+}
+
+int ModelGraph::addTensor(const Tensor &tensor) {
+    tensors.push_back(tensor);
+    return static_cast<int>(tensors.size() - 1);
+}
+
+int ModelGraph::addNode(Node node, const Tensor &output) {
+    node.output = addTensor(output);
+    nodes.push_back(node);
+    layers.emplace_back();
+    residency.push_back(0);
+    return node.output;
+}
+
+ModelGraph::Node ModelGraph::makeNode(OpType type, const std::string &name,
+                                      const std::string &prefix, int x) {
+    if (x < 0 || x >= static_cast<int>(tensors.size())) {
+        throw std::runtime_error("ModelGraph: unknown tensor (" + name + ")");
+    }
+    Node node{};
+    node.type = type;
+    node.name = name;
+    node.prefix = prefix;
+    node.naming = LDM;
+    node.inputs = {x};
+    node.output = -1;
+    node.in_channels = tensors[x].channels;
+    node.out_channels = tensors[x].channels;
+    node.resident = false;
+    return node;
+}
+
+template<typename K>
+std::shared_ptr<K> &ModelGraph::getKernel(std::shared_ptr<K> &kernel) {
+    if (kernel == nullptr) {
+        kernel = std::make_shared<K>(context, deviceId, assetManager);
+    }
+    return kernel;
+}
+
+std::unique_ptr<ModelGraph::Layer> ModelGraph::createLayer(const Node &node) {
+    auto &prefix = node.prefix;
+    auto weight = [&](const std::string &suffix) { return prefix + suffix + "_weight.npy"; };
+    auto bias = [&](const std::string &suffix) { return prefix + suffix + "_bias.npy"; };
+
+    switch (node.type) {
+        case CONV_2D:
+            return makeLayer(new Conv2D(context, cmdQueue,
+                                        node.in_channels, node.out_channels, node.kernel_size,
+                                        node.stride, node.padding,
+                                        weight(""), bias(""),
+                                        getKernel(convKernel)));
+        case LINEAR:
+            return makeLayer(new Linear(context, cmdQueue,
+                                        node.in_channels, node.out_channels,
+                                        weight(""), bias(""),
+                                        getKernel(linearKernel), getKernel(utilKernel)));
+        case GROUP_NORM:
+            return makeLayer(new GroupNorm(context, cmdQueue,
+                                           node.groups, node.in_channels, node.eps,
+                                           weight(""), bias(""),
+                                           getKernel(groupNormKernel)));
+        case UP_SAMPLE:
+            return makeLayer(new UpSample(context, cmdQueue,
+                                          node.in_channels, node.in_channels, 3, 1, 1,
+                                          weight(""), bias(""),
+                                          getKernel(convKernel), getKernel(upSampleKernel)));
+        case ATTN_BLOCK:
+            return makeLayer(new AttnBlock(context, cmdQueue, deviceId, assetManager,
+                                           node.in_channels,
+                                           weight("_norm"), bias("_norm"),
+                                           weight("_q"), bias("_q"),
+                                           weight("_k"), bias("_k"),
+                                           weight("_v"), bias("_v"),
+                                           weight("_proj_out"), bias("_proj_out"),
+                                           getKernel(convKernel), getKernel(utilKernel),
+                                           getKernel(groupNormKernel)));
+        case RES_BLOCK: {
+            /* in_norm, in_conv, emb_linear, out_norm, out_conv, skip */
+            std::vector<std::string> parts;
+            if (node.naming == LDM) {
+                parts = {"_in_layers_0", "_in_layers_2", "_emb_layers_1",
+                         "_out_layers_0", "_out_layers_3", "_skip_connection"};
+            } else if (node.naming == LEGACY) {
+                parts = {"_res_block_in_group_norm", "_res_block_in_conv2d",
+                         "_res_block_embed_linear", "_res_block_out_group_norm",
+                         "_res_block_out_conv2d", "_res_block_skip_conv2d"};
+            } else {
+                parts = {"_norm1", "_conv1", "", "_norm2", "_conv2", "_nin_shortcut"};
+            }
+            bool embed = node.inputs.size() > 1;
+            bool skip = node.in_channels != node.out_channels;
+            return makeLayer(new ResBlock(context, cmdQueue,
+                                          node.in_channels,
+                                          embed ? tensors[node.inputs[1]].channels : 0,
+                                          node.out_channels,
+                                          weight(parts[0]), bias(parts[0]),
+                                          weight(parts[1]), bias(parts[1]),
+                                          embed ? weight(parts[2]) : "",
+                                          embed ? bias(parts[2]) : "",
+                                          weight(parts[3]), bias(parts[3]),
+                                          weight(parts[4]), bias(parts[4]),
+                                          skip ? weight(parts[5]) : "",
+                                          skip ? bias(parts[5]) : "",
+                                          getKernel(linearKernel), getKernel(convKernel),
+                                          getKernel(groupNormKernel), getKernel(utilKernel)));
+        }
+        case SPATIAL_TRANSFORMER: {
+            /*
+             * norm, proj_in, norm1, norm2, norm3, attn1 (q, k, v, out), attn2 (q, k, v, out),
+             * ff_net_0, ff_net_2, proj_out
+             */
+            std::vector<std::string> parts;
+            if (node.naming == LEGACY) {
+                parts = {"_spatial_group_norm", "_spatial_in_linear",
+                         "_basic_layer_norm_1", "_basic_layer_norm_2", "_basic_layer_norm_3",
+                         "_cross_1_q_linear", "_cross_1_k_linear", "_cross_1_v_linear",
+                         "_cross_1_out_linear",
+                         "_cross_2_q_linear", "_cross_2_k_linear", "_cross_2_v_linear",
+                         "_cross_2_out_linear",
+                         "_ff_geglu_linear", "_ff_net_linear", "_spatial_out_linear"};
+            } else {
+                std::string block = "_transformer_blocks_0";
+                parts = {"_norm", "_proj_in",
+                         block + "_norm1", block + "_norm2", block + "_norm3",
+                         block + "_attn1_to_q", block + "_attn1_to_k", block + "_attn1_to_v",
+                         block + "_attn1_to_out_0",
+                         block + "_attn2_to_q", block + "_attn2_to_k", block + "_attn2_to_v",
+                         block + "_attn2_to_out_0",
+                         block + "_ff_net_0_proj", block + "_ff_net_2", "_proj_out"};
+            }
+            return makeLayer(new SpatialTransformer(
+                    context, cmdQueue,
+                    node.in_channels, tensors[node.inputs[1]].width, node.heads,
+                    node.in_channels / node.heads,
+                    weight(parts[0]), bias(parts[0]),
+                    weight(parts[1]), bias(parts[1]),
+                    weight(parts[2]), bias(parts[2]),
+                    weight(parts[3]), bias(parts[3]),
+                    weight(parts[4]), bias(parts[4]),
+                    weight(parts[5]), weight(parts[6]), weight(parts[7]),
+                    weight(parts[8]), bias(parts[8]),
+                    weight(parts[9]), weight(parts[10]), weight(parts[11]),
+                    weight(parts[12]), bias(parts[12]),
+                    weight(parts[13]), bias(parts[13]),
+                    weight(parts[14]), bias(parts[14]),
+                    weight(parts[15]), bias(parts[15]),
+                    getKernel(layerNormKernel), getKernel(linearKernel), getKernel(utilKernel),
+                    getKernel(crossAttentionKernel), getKernel(gegluKernel),
+                    getKernel(groupNormKernel)));
+        }
+        default:
+            throw std::runtime_error("ModelGraph: no layer for node (" + node.name + ")");
+    }
+}
+
+cl_int ModelGraph::enqueueSilu(cl_mem input, cl_mem output, size_t size,
+                               cl_uint num_events_in_list, const cl_event *event_wait_list,
+                               cl_event *event) {
+    cl_int err;
+    auto &kernel = getKernel(utilKernel);
+    err = record::clSetKernelArg(kernel->silu, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->silu, 1, sizeof(cl_mem), &output);
+    if (err != CL_SUCCESS) {
+        return err;
+    }
+
+    size_t globalSize[1] = {size};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->silu, 1, nullptr, globalSize, nullptr,
+                                         num_events_in_list, event_wait_list, event);
+    if (err != CL_SUCCESS) {
+        return err;
+    }
+    Tracer::getInstance().record("silu", *event);
+    return CL_SUCCESS;
+}
+
+cl_int ModelGraph::enqueueConcat(cl_mem input1, cl_mem input2, cl_mem output,
+                                 cl_uint num_events_in_list, const cl_event *event_wait_list,
+                                 cl_event *event) {
+    cl_int err;
+    cl_event events[2];
+    size_t input1_bytes, input2_bytes;
+    err = clGetMemObjectInfo(input1, CL_MEM_SIZE, sizeof(size_t), &input1_bytes, nullptr);
+    err |= clGetMemObjectInfo(input2, CL_MEM_SIZE, sizeof(size_t), &input2_bytes, nullptr);
+    if (err != CL_SUCCESS) {
+        return err;
+    }
+
+    err = record::clEnqueueCopyBuffer(cmdQueue, input1, output, 0, 0, input1_bytes,
+                                      num_events_in_list, event_wait_list, &events[0]);
+    if (err != CL_SUCCESS) {
+        return err;
+    }
+    Tracer::getInstance().record("copy_buffer", events[0]);
+
+    err = record::clEnqueueCopyBuffer(cmdQueue, input2, output, 0, input1_bytes, input2_bytes,
+                                      num_events_in_list, event_wait_list, &events[1]);
+    if (err != CL_SUCCESS) {
+        clReleaseEvent(events[0]);
+        return err;
+    }
+    Tracer::getInstance().record("copy_buffer", events[1]);
+
+    err = record::clEnqueueMarkerWithWaitList(cmdQueue, 2, events, event);
+    clReleaseEvent(events[0]);
+    clReleaseEvent(events[1]);
+    return err;
+}
+
+size_t ModelGraph::bytesOf(const Tensor &tensor) {
+    return sizeof(float) * tensor.channels * tensor.height * tensor.width;
+}
+
+size_t ModelGraph::weightBytesOf(const Node &node) const {
+    auto in = node.in_channels;
+    auto out = node.out_channels;
+    size_t count = 0;
+    switch (node.type) {
+        case CONV_2D:
+            count = out * in * node.kernel_size * node.kernel_size + out;
+            break;
+        case LINEAR:
+            count = out * in + out;
+            break;
+        case GROUP_NORM:
+            count = 2 * in;
+            break;
+        case UP_SAMPLE:
+            count = in * in * 9 + in;
+            break;
+        case ATTN_BLOCK:
+            /* norm, q, k, v, proj_out */
+            count = 2 * in + 4 * (in * in + in);
+            break;
+        case RES_BLOCK: {
+            size_t emb = node.inputs.size() > 1 ? tensors[node.inputs[1]].channels : 0;
+            count = 2 * in + out * in * 9 + out + 2 * out + out * out * 9 + out;
+            if (emb > 0) {
+                count += out * emb + out;
+            }
+            if (in != out) {
+                count += out * in + out;
+            }
+            break;
+        }
+        case SPATIAL_TRANSFORMER: {
+            size_t dim = tensors[node.inputs[1]].width;
+            /* norm, proj_in, norm1 ~ 3, attn1, attn2, ff (GEGLU 4 * 2), proj_out */
+            count = 2 * in + in * in + in + 6 * in +
+                    4 * in * in + in +
+                    2 * in * in + 2 * dim * in + in +
+                    in * in * 8 + in * 8 + in * 4 * in + in +
+                    in * in + in;
+            break;
+        }
+        default:
+            break;
+    }
+    return count * sizeof(float);
+}
+
+void ModelGraph::retain(size_t i) {
+    auto &manager = ResidencyManager::getInstance();
+    if (residency[i] != 0) {
+        manager.touch(residency[i]);
+        return;
+    }
+    if (!residencyName.empty()) {
+        residency[i] = manager.add(this, residencyName + "/" + nodes[i].name,
+                                   weightBytesOf(nodes[i]), residencyPriority, false, [this, i]() {
+                    /* run 중이면 (다른 thread) 건너뜀 */
+                    if (!mutex.try_lock()) {
+                        return false;
+                    }
+                    residency[i] = 0;
+                    layers[i].reset();
+                    mutex.unlock();
+                    return true;
+                });
+    }
+    if (residency[i] == 0) {
+        layers[i].reset();
+    }
+}
+
+void ModelGraph::release(size_t i) {
+    if (residency[i] != 0) {
+        ResidencyManager::getInstance().remove(residency[i]);
+        residency[i] = 0;
+    }
+}
@@ -0,0 +1,204 @@
+//
+// Created by 구현우 on 2024/07/20.
+//
+
+#ifndef MY_OPENCL_MODELGRAPH_H
+#define MY_OPENCL_MODELGRAPH_H
+
+#define CL_TARGET_OPENCL_VERSION 200
+
+#include "CL/opencl.h"
+
+#include <android/asset_manager_jni.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "kernel/unit/LayerNormKernel.h"
+#include "kernel/unit/LinearKernel.h"
+#include "kernel/unit/UtilKernel.h"
+#include "kernel/unit/ConvKernel.h"
+#include "kernel/unit/CrossAttentionKernel.h"
+#include "kernel/unit/GEGLUKernel.h"
+#include "kernel/unit/GroupNormKernel.h"
+#include "kernel/unit/UpSampleKernel.h"
+
+/*
+ * UNet / Decoder 의 block table 을 펼친 layer graph.
+ * node 는 layer 종류, 채널 수, head 수, weight prefix 만 가지고, layer 객체는 실행 직전에 생성 후 init (weight load)
+ * 하고 실행이 끝나면 바로 삭제 (resident 제외). tensor 는 id 로 참조하고 shape 은 add 할 때 추론.
+ * RESIDENCY_MODE 이면 실행이 끝난 layer 를 ResidencyManager 의 budget 안에서 유지 (evict 되면 다음 실행에서 다시 load).
+ *
+ * buffer 는 run 에서 계획:
+ *  - 마지막 사용인 input 과 크기가 같으면 in-place (ResBlock, SpatialTransformer, AttnBlock, GroupNorm, SiLU)
+ *  - 더 이상 쓰지 않는 buffer 는 pool 로 돌려서 같은 크기의 다음 tensor 가 재사용
+ * fusion / batching / caching 등 여러 block 에 걸친 최적화는 이 곳의 nodes 를 다루는 pass 로 추가.
+ */
+class ModelGraph {
+public:
+    enum OpType {
+        CONV_2D, LINEAR, GROUP_NORM, SILU, CONCAT,
+        RES_BLOCK, SPATIAL_TRANSFORMER, ATTN_BLOCK, UP_SAMPLE
+    };
+
+    /* weight 이름 규칙 */
+    enum Naming {
+        /* ldm UNet state dict (e.g. input_blocks_2_0_in_layers_0) */
+        LDM,
+        /* 초기 export (unet input_block 1, e.g. input_block_1_res_block_in_group_norm) */
+        LEGACY,
+        /* VAE decoder (e.g. decoder_up_1_block_0_norm1) */
+        VAE
+    };
+
+    /* (channels, height, width). linear 는 (features, 1, 1), condition 은 (1, tokens, dim) */
+    struct Tensor {
+        size_t channels;
+        size_t height;
+        size_t width;
+    };
+
+    struct Node {
+        OpType type;
+        /* trace scope */
+        std::string name;
+        /* weight 이름 prefix (".npy" 와 layer 별 suffix 제외) */
+        std::string prefix;
+        Naming naming;
+        std::vector<int> inputs;
+        int output;
+        size_t in_channels;
+        size_t out_channels;
+        /* CONV_2D */
+        size_t kernel_size;
+        int stride;
+        int padding;
+        /* SPATIAL_TRANSFORMER */
+        size_t heads;
+        /* GROUP_NORM */
+        size_t groups;
+        float eps;
+        /* run 후에도 layer 를 유지 */
+        bool resident;
+    };
+
+    ModelGraph(cl_context context, cl_command_queue cmdQueue, cl_device_id deviceId,
+               AAssetManager *assetManager);
+
+    ~ModelGraph();
+
+    /* @return: tensor id */
+    int input(size_t channels, size_t height, size_t width);
+
+    int conv2d(const std::string &name, const std::string &prefix, int x, size_t out_channels,
+               size_t kernel_size, int stride, int padding);
+
+    int linear(const std::string &name, const std::string &prefix, int x, size_t out_features);
+
+    int groupNorm(const std::string &name, const std::string &prefix, int x, size_t groups,
+                  float eps);
+
+    int silu(const std::string &name, int x);
+
+    /* channel 방향 concat (a, b) */
+    int concat(const std::string &name, int a, int b);
+
+    /* `emb` 가 -1 이면 embedding 없음. in != out 이면 skip connection conv */
+    int resBlock(const std::string &name, const std::string &prefix, Naming naming, int x, int emb,
+                 size_t out_channels);
+
+    int spatialTransformer(const std::string &name, const std::string &prefix, Naming naming,
+                           int x, int context, size_t heads);
+
+    int attnBlock(const std::string &name, const std::string &prefix, int x);
+
+    /* nearest x2 + 3x3 conv */
+    int upSample(const std::string &name, const std::string &prefix, int x);
+
+    /* [begin, end) node 의 layer 를 미리 생성, init */
+    void load(size_t begin, size_t end, bool resident);
+
+    /* [begin, end) node 의 layer 삭제 (weight release), resident 해제 */
+    void unload(size_t begin, size_t end);
+
+    /* ResidencyManager 에 등록할 때의 이름 (`name`/<node>) 과 priority. 부르지 않으면 등록하지 않음 */
+    void setResidency(const std::string &name, int priority);
+
+    size_t size() const;
+
+    const Tensor &getTensor(int id) const;
+
+    /*
+     * `inputs`: input() 순서의 buffer (호출한 쪽 소유), `events`: 각 input 의 준비 event (nullptr 가능).
+     * `output` 을 만드는 node 까지 실행하고 output buffer 를 반환 (호출한 쪽에서 release).
+     */
+    cl_mem run(const std::vector<cl_mem> &inputs, const std::vector<cl_event> &events, int output,
+               cl_event *event);
+
+    class Layer;
+
+private:
+    struct Buffer {
+        cl_mem buffer;
+        size_t bytes;
+        /* 이 buffer 를 마지막으로 쓰거나 읽은 node 의 event */
+        std::vector<cl_event> events;
+    };
+
+    int addTensor(const Tensor &tensor);
+
+    int addNode(Node node, const Tensor &output);
+
+    Node makeNode(OpType type, const std::string &name, const std::string &prefix, int x);
+
+    std::unique_ptr<Layer> createLayer(const Node &node);
+
+    template<typename K>
+    std::shared_ptr<K> &getKernel(std::shared_ptr<K> &kernel);
+
+    cl_int enqueueSilu(cl_mem input, cl_mem output, size_t size, cl_uint num_events_in_list,
+                       const cl_event *event_wait_list, cl_event *event);
+
+    cl_int enqueueConcat(cl_mem input1, cl_mem input2, cl_mem output, cl_uint num_events_in_list,
+                         const cl_event *event_wait_list, cl_event *event);
+
+    static size_t bytesOf(const Tensor &tensor);
+
+    /* node 의 weight bytes (fp32 추정) */
+    size_t weightBytesOf(const Node &node) const;
+
+    /* run 이 끝난 layer 를 ResidencyManager 에 등록 (또는 touch). 공간이 없으면 삭제 */
+    void retain(size_t i);
+
+    void release(size_t i);
+
+    cl_context context;
+    cl_command_queue cmdQueue;
+    cl_device_id deviceId;
+    AAssetManager *assetManager;
+
+    std::vector<Tensor> tensors;
+    std::vector<int> inputIds;
+    std::vector<Node> nodes;
+    std::vector<std::unique_ptr<Layer>> layers;
+
+    /* node 별 ResidencyManager handle (0 : 등록 안 됨) */
+    std::vector<size_t> residency;
+    std::string residencyName;
+    int residencyPriority = 0;
+    /* run / load 와 evict (다른 thread) 사이 */
+    std::recursive_mutex mutex;
+
+    std::shared_ptr<LayerNormKernel> layerNormKernel;
+    std::shared_ptr<LinearKernel> linearKernel;
+    std::shared_ptr<UtilKernel> utilKernel;
+    std::shared_ptr<ConvKernel> convKernel;
+    std::shared_ptr<CrossAttentionKernel> crossAttentionKernel;
+    std::shared_ptr<GEGLUKernel> gegluKernel;
+    std::shared_ptr<GroupNormKernel> groupNormKernel;
+    std::shared_ptr<UpSampleKernel> upSampleKernel;
+};
+
+
+#endif //MY_OPENCL_MODELGRAPH_H
@@ -0,0 +1,303 @@
+//
+// Created by 구현우 on 2024/07/16.
+//
+
+#include "Pipeline.h"
+
+#include <android/log.h>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include "tokenizer.h"
+#include "TextEncoder.h"
+#include "DDIMSampler.h"
+#include "UNetModel.h"
+#include "Decoder.h"
+#include "LatentPreview.h"
+#include "EmbeddingCache.h"
+#include "ResidencyManager.h"
+
+#define LOG_TAG "PIPELINE"
+
+#define LATENT_CHANNELS 4
+/* image / latent */
+#define DOWN_SAMPLING 8
+
+#define CHECK_ERROR_THROW(err) \
+    if (err != CL_SUCCESS) { \
+      __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "[%s:%d] OpenCL error %d\n", __FILE__, __LINE__, err); \
+      throw std::runtime_error("OpenCL error."); \
+    }
+
+Pipeline::Pipeline(cl_context context, cl_device_id deviceId, AAssetManager *assetManager,
+                   size_t capacity)
+        : context(context), deviceId(deviceId), assetManager(assetManager),
+          encodeQueue(capacity), denoiseQueue(capacity), decodeQueue(capacity), resultQueue(0),
+          started(now()) {
+    cl_int err;
+    const char *names[3] = {"encode", "denoise", "decode"};
+    cl_queue_properties properties[] = {CL_QUEUE_PROPERTIES,
+                                        CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE |
+                                        CL_QUEUE_PROFILING_ENABLE, 0};
+    for (int i = 0; i < 3; i++) {
+        stages[i].name = names[i];
+        stages[i].cmdQueue = clCreateCommandQueueWithProperties(context, deviceId, properties,
+                                                                &err);
+        CHECK_ERROR_THROW(err);
+    }
+
+    stages[0].worker = std::thread(&Pipeline::runEncode, this);
+    stages[1].worker = std::thread(&Pipeline::runDenoise, this);
+    stages[2].worker = std::thread(&Pipeline::runDecode, this);
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "capacity(%ld)", capacity);
+}
+
+Pipeline::~Pipeline() {
+    join();
+    for (auto &stage: stages) {
+        clReleaseCommandQueue(stage.cmdQueue);
+    }
+}
+
+size_t Pipeline::submit(const std::string &prompt, int steps, unsigned int seed, size_t height,
+                        size_t width) {
+    /* latent 가 UNet 의 down sample 3 번으로 나누어 떨어지도록 */
+    if (height == 0 || width == 0 || height % (DOWN_SAMPLING * 8) != 0 ||
+        width % (DOWN_SAMPLING * 8) != 0) {
+        throw std::invalid_argument("image size must be a multiple of 64");
+    }
+
+    auto job = std::make_unique<Job>();
+    job->id = nextId++;
+    job->prompt = prompt;
+    job->steps = steps;
+    job->seed = seed;
+    job->height = height;
+    job->width = width;
+    job->submitted = now();
+    job->finished = job->submitted;
+
+    auto id = job->id;
+    if (!encodeQueue.push(std::move(job))) {
+        throw std::runtime_error("Pipeline is closed");
+    }
+    return id;
+}
+
+bool Pipeline::take(Result *result) {
+    JobPtr job;
+    if (!resultQueue.pop(&job)) {
+        return false;
+    }
+    result->id = job->id;
+    result->prompt = std::move(job->prompt);
+    result->image = std::move(job->image);
+    result->height = job->height;
+    result->width = job->width;
+    result->error = std::move(job->error);
+    result->latency = static_cast<double>(job->finished - job->submitted) / 1e6;
+
+    std::lock_guard<std::mutex> lock(cancelMutex);
+    cancelled.erase(job->id);
+    return true;
+}
+
+void Pipeline::setProgress(int interval, const Progress &callback) {
+    progressInterval = interval;
+    progress = callback;
+}
+
+void Pipeline::cancel(size_t id) {
+    std::lock_guard<std::mutex> lock(cancelMutex);
+    cancelled.insert(id);
+}
+
+bool Pipeline::isCancelled(size_t id) {
+    std::lock_guard<std::mutex> lock(cancelMutex);
+    return cancelled.count(id) > 0;
+}
+
+void Pipeline::close() {
+    encodeQueue.close();
+}
+
+void Pipeline::join() {
+    close();
+    for (auto &stage: stages) {
+        if (stage.worker.joinable()) {
+            stage.worker.join();
+        }
+    }
+}
+
+template<typename Process>
+void Pipeline::runStage(Stage &stage, BoundedQueue<JobPtr> &input, BoundedQueue<JobPtr> &output,
+                        Process process) {
+    while (true) {
+        JobPtr job;
+        auto wait = now();
+        if (!input.pop(&job)) {
+            break;
+        }
+        auto start = now();
+        stage.idle += start - wait;
+
+        if (job->error.empty() && isCancelled(job->id)) {
+            job->error = "cancelled";
+        }
+        if (job->error.empty()) {
+            try {
+                process(*job);
+            } catch (const std::exception &e) {
+                job->error = isCancelled(job->id) ? "cancelled"
+                                                  : std::string(stage.name) + ": " + e.what();
+                __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "job(%ld) %s", job->id,
+                                    job->error.c_str());
+            }
+        }
+
+        auto stop = now();
+        stage.busy += stop - start;
+        stage.count++;
+        job->finished = stop;
+        output.push(std::move(job));
+        stage.blocked += now() - stop;
+    }
+    output.close();
+}
+
+void Pipeline::runEncode() {
+    auto &stage = stages[0];
+    std::unique_ptr<SimpleTokenizer> tokenizer;
+    std::unique_ptr<TextEncoder> encoder;
+    runStage(stage, encodeQueue, denoiseQueue, [&](Job &job) {
+        if (tokenizer == nullptr) {
+            tokenizer = std::make_unique<SimpleTokenizer>();
+        }
+        auto token = tokenizer->tokenize(job.prompt);
+        auto &cache = EmbeddingCache::getInstance();
+        if (cache.get(token, &job.condition)) {
+            return;
+        }
+        /* 모두 cache hit 이면 text encoder weight 를 load 하지 않음 */
+        if (encoder == nullptr) {
+            encoder = std::make_unique<TextEncoder>(assetManager, context, stage.cmdQueue,
+                                                    deviceId);
+        }
+        job.condition = encoder->encode(token);
+        cache.put(token, job.condition);
+    });
+}
+
+/* DDIMSampler::sample 과 같은 방식으로 seed 별 x_T 생성 */
+void Pipeline::runDenoise() {
+    auto &stage = stages[1];
+    std::unique_ptr<UNetModel> unet;
+    std::unique_ptr<LatentPreview> previewer;
+    size_t unetHeight = 0, unetWidth = 0;
+    runStage(stage, denoiseQueue, decodeQueue, [&](Job &job) {
+        auto height = job.height / DOWN_SAMPLING;
+        auto width = job.width / DOWN_SAMPLING;
+        if (unet == nullptr || height != unetHeight || width != unetWidth) {
+            unet.reset();
+            unet = std::make_unique<UNetModel>(assetManager, context, stage.cmdQueue, deviceId,
+                                               height, width);
+            unetHeight = height;
+            unetWidth = width;
+        }
+        auto sampler = DDIMSampler([&](const std::vector<float> &x, int t,
+                                       const std::vector<float> &c) {
+            return unet->forward(x, t, c);
+        });
+        sampler.setProgress([&](int step, int steps, const std::vector<float> &pred_x0) {
+            if (isCancelled(job.id)) {
+                return false;
+            }
+            if (!progress || progressInterval <= 0 ||
+                (step % progressInterval != 0 && step != steps)) {
+                return true;
+            }
+            if (previewer == nullptr) {
+                previewer = std::make_unique<LatentPreview>(context, stage.cmdQueue, deviceId,
+                                                            assetManager);
+            }
+            if (!progress(job.id, step, steps, previewer->preview(pred_x0, height, width),
+                          height, width)) {
+                cancel(job.id);
+                return false;
+            }
+            return true;
+        });
+
+        std::mt19937 gen(job.seed);
+        std::normal_distribution<float> normalDist(0.0f, 1.0f);
+        std::vector<float> x(LATENT_CHANNELS * height * width);
+        for (float &i: x) {
+            i = normalDist(gen);
+        }
+        int shape[3] = {LATENT_CHANNELS, static_cast<int>(height), static_cast<int>(width)};
+        job.latent = sampler.sample(&x, job.steps, shape, job.condition);
+        job.condition = std::vector<float>();
+    });
+}
+
+void Pipeline::runDecode() {
+    auto &stage = stages[2];
+    std::unique_ptr<Decoder> decoder;
+    size_t decoderHeight = 0, decoderWidth = 0;
+    runStage(stage, decodeQueue, resultQueue, [&](Job &job) {
+        auto height = job.height / DOWN_SAMPLING;
+        auto width = job.width / DOWN_SAMPLING;
+        if (decoder == nullptr || height != decoderHeight || width != decoderWidth) {
+            decoder.reset();
+            decoder = std::make_unique<Decoder>(context, stage.cmdQueue, deviceId, assetManager,
+                                                height, width);
+            decoderHeight = height;
+            decoderWidth = width;
+        }
+        job.image = decoder->decode(job.latent);
+        job.latent = std::vector<float>();
+    });
+}
+
+std::string Pipeline::getStats() {
+    auto elapsed = static_cast<double>(now() - started) / 1e6;
+    auto completed = stages[2].count.load();
+
+    std::ostringstream oss;
+    oss.setf(std::ios::fixed);
+    oss.precision(3);
+    oss << "{\n";
+    oss << "  \"elapsed_ms\": " << elapsed << ",\n";
+    oss << "  \"submitted\": " << nextId.load() << ",\n";
+    oss << "  \"completed\": " << completed << ",\n";
+    oss << "  \"images_per_minute\": " << (elapsed > 0 ? completed * 60000.0 / elapsed : 0.0)
+        << ",\n";
+    oss << "  \"embedding_cache\": " << EmbeddingCache::getInstance().getStats() << ",\n";
+    oss << "  \"residency\": " << ResidencyManager::getInstance().getStats() << ",\n";
+    oss << "  \"queued\": {\"encode\": " << encodeQueue.size() << ", \"denoise\": "
+        << denoiseQueue.size() << ", \"decode\": " << decodeQueue.size() << "},\n";
+    oss << "  \"stages\": [\n";
+    for (int i = 0; i < 3; i++) {
+        auto &stage = stages[i];
+        auto count = stage.count.load();
+        auto busy = static_cast<double>(stage.busy.load()) / 1e6;
+        oss << "    {\"name\": \"" << stage.name << "\", \"count\": " << count
+            << ", \"busy_ms\": " << busy
+            << ", \"idle_ms\": " << static_cast<double>(stage.idle.load()) / 1e6
+            << ", \"blocked_ms\": " << static_cast<double>(stage.blocked.load()) / 1e6
+            << ", \"per_minute\": " << (busy > 0 ? count * 60000.0 / busy : 0.0)
+            << ", \"utilization\": " << (elapsed > 0 ? busy / elapsed : 0.0) << "}"
+            << (i < 2 ? ",\n" : "\n");
+    }
+    oss << "  ]\n}\n";
+    return oss.str();
+}
+
+long long Pipeline::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
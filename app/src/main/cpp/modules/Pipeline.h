@@ -0,0 +1,155 @@
+//
+// Created by 구현우 on 2024/07/16.
+//
+
+#ifndef MY_OPENCL_PIPELINE_H
+#define MY_OPENCL_PIPELINE_H
+
+#define CL_TARGET_OPENCL_VERSION 200
+
+#include "CL/opencl.h"
+
+#include <android/asset_manager_jni.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.h"
+
+/*
+ * 여러 image 요청을 encode -> denoise -> decode stage 로 pipelining.
+ * stage 마다 worker thread 와 command queue 를 따로 두고, stage 사이는 BoundedQueue (capacity) 로 연결.
+ * model 은 stage thread 에서 한 번만 생성하므로 weight load 는 처음 요청에만 발생 (image 크기가 바뀌면 다시 생성).
+ * (image i 의 decode 와 image i + 1 의 denoise 가 겹침)
+ *
+ * submit -> take 순서는 submit 순서와 같음.
+ */
+class Pipeline {
+public:
+    struct Result {
+        size_t id;
+        std::string prompt;
+        /* (3, height, width), error 이면 empty */
+        std::vector<float> image;
+        size_t height;
+        size_t width;
+        std::string error;
+        /* submit ~ take 가능 시점 */
+        double latency;
+    };
+
+    /*
+     * denoise 진행 상황. `image`: pred_x0 의 latent preview (3, height, width), [-1, 1], latent 크기 (image / 8).
+     * denoise thread 에서 호출. false 를 반환하면 해당 요청을 cancel.
+     */
+    typedef std::function<bool(size_t id, int step, int steps, const std::vector<float> &image,
+                               size_t height, size_t width)> Progress;
+
+    Pipeline(cl_context context, cl_device_id deviceId, AAssetManager *assetManager,
+             size_t capacity);
+
+    ~Pipeline();
+
+    /*
+     * 입력 queue 가 가득 차 있으면 대기. @return: request id
+     * `height`, `width`: image 크기 (64 의 배수, e.g. 384x384 preview, 768x512 portrait)
+     * @throw: std::invalid_argument (image 크기), std::runtime_error (join 이후)
+     */
+    size_t submit(const std::string &prompt, int steps, unsigned int seed, size_t height = 512,
+                  size_t width = 512);
+
+    /* `interval` step 마다 (와 마지막 step) preview. submit 전에 설정 */
+    void setProgress(int interval, const Progress &callback);
+
+    /* 남은 stage 를 건너뜀 (denoise 중이면 다음 step 에서 중단). Result::error 는 "cancelled" */
+    void cancel(size_t id);
+
+    /* 완료된 image 를 기다림. close 후 모두 꺼내면 false */
+    bool take(Result *result);
+
+    /* 더 이상 submit 하지 않음. 남은 요청은 끝까지 실행 */
+    void close();
+
+    /* close 후 모든 stage 가 끝날 때까지 대기 */
+    void join();
+
+    /* stage 별 count, busy / idle / blocked time, images per minute (JSON) */
+    std::string getStats();
+
+private:
+    struct Job {
+        size_t id;
+        std::string prompt;
+        int steps;
+        unsigned int seed;
+        /* image 크기 */
+        size_t height;
+        size_t width;
+        std::vector<float> condition;
+        std::vector<float> latent;
+        std::vector<float> image;
+        std::string error;
+        long long submitted;
+        /* 마지막으로 처리한 stage 의 종료 시점 */
+        long long finished;
+    };
+
+    typedef std::unique_ptr<Job> JobPtr;
+
+    struct Stage {
+        const char *name;
+        cl_command_queue cmdQueue;
+        std::thread worker;
+        std::atomic<size_t> count{0};
+        /* ns */
+        std::atomic<long long> busy{0};
+        /* 입력 queue 대기 */
+        std::atomic<long long> idle{0};
+        /* 출력 queue 가 가득 차서 대기 */
+        std::atomic<long long> blocked{0};
+    };
+
+    void runEncode();
+
+    void runDenoise();
+
+    void runDecode();
+
+    /* input 에서 꺼내 process 후 output 으로. 앞 stage 에서 error 인 job 은 그대로 전달 */
+    template<typename Process>
+    void runStage(Stage &stage, BoundedQueue<JobPtr> &input, BoundedQueue<JobPtr> &output,
+                  Process process);
+
+    bool isCancelled(size_t id);
+
+    static long long now();
+
+    cl_context context;
+    cl_device_id deviceId;
+    AAssetManager *assetManager;
+
+    BoundedQueue<JobPtr> encodeQueue;
+    BoundedQueue<JobPtr> denoiseQueue;
+    BoundedQueue<JobPtr> decodeQueue;
+    /* unbounded (take 하지 않아도 stage 가 멈추지 않음) */
+    BoundedQueue<JobPtr> resultQueue;
+
+    Stage stages[3];
+
+    int progressInterval = 0;
+    Progress progress;
+
+    std::set<size_t> cancelled;
+    std::mutex cancelMutex;
+
+    std::atomic<size_t> nextId{0};
+    long long started;
+};
+
+
+#endif //MY_OPENCL_PIPELINE_H
@@ -0,0 +1,59 @@
+//
+// Created by 구현우 on 2024/07/24.
+//
+
+#include "ProgramCache.h"
+#include "util.h"
+
+#include <android/log.h>
+
+#define LOG_TAG "PROGRAM_CACHE"
+
+ProgramCache &ProgramCache::getInstance() {
+    static ProgramCache instance;
+    return instance;
+}
+
+cl_program ProgramCache::get(cl_context context, cl_device_id deviceId,
+                             AAssetManager *assetManager, const char *fileName,
+                             const std::string &options) {
+    auto key = std::make_tuple(context, deviceId, std::string(fileName), options);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = programs.find(key);
+        if (it != programs.end()) {
+            clRetainProgram(it->second);
+            return it->second;
+        }
+    }
+
+    /* build 는 lock 밖에서 (다른 thread 의 model 초기화를 막지 않도록) */
+    auto program = util::create_and_build_program_with_source(context, deviceId, assetManager,
+                                                              fileName, options.c_str());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = programs.find(key);
+    if (it != programs.end()) {
+        /* 다른 thread 가 먼저 build */
+        clReleaseProgram(program);
+        program = it->second;
+    } else {
+        programs[key] = program;
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "%s [%s] cached (%ld programs)", fileName,
+                            options.c_str(), programs.size());
+    }
+    clRetainProgram(program);
+    return program;
+}
+
+void ProgramCache::release(cl_context context) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = programs.begin(); it != programs.end();) {
+        if (std::get<0>(it->first) == context) {
+            clReleaseProgram(it->second);
+            it = programs.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
@@ -0,0 +1,42 @@
+//
+// Created by 구현우 on 2024/07/24.
+//
+
+#ifndef MY_OPENCL_PROGRAMCACHE_H
+#define MY_OPENCL_PROGRAMCACHE_H
+
+#ifndef CL_TARGET_OPENCL_VERSION
+#define CL_TARGET_OPENCL_VERSION 200
+#endif
+
+#include "CL/opencl.h"
+
+#include <android/asset_manager.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+/*
+ * (context, device, .cl file, build options) 별 cl_program.
+ * 같은 .cl 을 쓰는 model (text encoder, unet, decoder) 과 shape 특화 kernel (SpecializedKernel) 이 build 를 공유.
+ * get 은 retain 한 program 을 반환하므로 caller 가 release. context 를 release 하기 전에 release(context).
+ */
+class ProgramCache {
+public:
+    static ProgramCache &getInstance();
+
+    cl_program get(cl_context context, cl_device_id deviceId, AAssetManager *assetManager,
+                   const char *fileName, const std::string &options = "");
+
+    void release(cl_context context);
+
+private:
+    ProgramCache() = default;
+
+    std::map<std::tuple<cl_context, cl_device_id, std::string, std::string>, cl_program> programs;
+    std::mutex mutex;
+};
+
+
+#endif //MY_OPENCL_PROGRAMCACHE_H
@@ -0,0 +1,189 @@
+//
+// Created by 구현우 on 2024/07/26.
+//
+
+#include "ResidencyManager.h"
+
+#include <algorithm>
+#include <android/log.h>
+#include <sstream>
+
+#define LOG_TAG "RESIDENCY"
+
+#define MB (1024.0 * 1024.0)
+
+ResidencyManager &ResidencyManager::getInstance() {
+    static ResidencyManager instance;
+    return instance;
+}
+
+void ResidencyManager::init(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = bytes;
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "budget: %.1f MB", budget / MB);
+}
+
+bool ResidencyManager::isEnabled() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budget > 0;
+}
+
+size_t ResidencyManager::add(const void *owner, const std::string &name, size_t bytes,
+                             int priority, bool pinned, const Evict &evict) {
+    std::vector<std::shared_ptr<void>> released;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (budget == 0) {
+        return 0;
+    }
+    if (!pinned && !reserve(owner, bytes, priority, &released)) {
+        rejects++;
+        return 0;
+    }
+    return insert(Entry{owner, name, bytes, priority, pinned, 0, evict, nullptr});
+}
+
+void ResidencyManager::touch(size_t handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(handle);
+    if (it != entries.end()) {
+        it->second.lastUse = ++clock;
+    }
+}
+
+void ResidencyManager::remove(size_t handle) {
+    std::shared_ptr<void> model;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(handle);
+    if (it == entries.end()) {
+        return;
+    }
+    used -= it->second.bytes;
+    if (it->second.model != nullptr) {
+        models.erase(it->second.name);
+        model = std::move(it->second.model);
+    }
+    entries.erase(it);
+}
+
+std::shared_ptr<void> ResidencyManager::find(const std::string &name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = models.find(name);
+    if (it == models.end()) {
+        return nullptr;
+    }
+    auto &entry = entries[it->second];
+    entry.lastUse = ++clock;
+    modelHits++;
+    return entry.model;
+}
+
+void ResidencyManager::addModel(const std::string &name, size_t bytes, int priority,
+                                const std::shared_ptr<void> &model) {
+    std::vector<std::shared_ptr<void>> released;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (budget == 0 || models.count(name) > 0) {
+        return;
+    }
+    /* model 끼리는 owner 가 다름 (nullptr) */
+    if (!reserve(nullptr, bytes, priority, &released)) {
+        rejects++;
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "%s (%.1f MB) not resident", name.c_str(),
+                            bytes / MB);
+        return;
+    }
+    models[name] = insert(Entry{nullptr, name, bytes, priority, false, 0, nullptr, model});
+}
+
+bool ResidencyManager::reserve(const void *owner, size_t bytes, int priority,
+                               std::vector<std::shared_ptr<void>> *released) {
+    if (used + bytes <= budget) {
+        return true;
+    }
+    if (bytes > budget) {
+        return false;
+    }
+
+    std::vector<std::map<size_t, Entry>::iterator> candidates;
+    size_t available = 0;
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+        auto &entry = it->second;
+        if (entry.pinned || entry.bytes == 0 || entry.priority > priority ||
+            (entry.priority == priority && owner != nullptr && entry.owner == owner)) {
+            continue;
+        }
+        candidates.push_back(it);
+        available += entry.bytes;
+    }
+    /* 모두 evict 해도 부족하면 아무것도 evict 하지 않음 */
+    if (used + bytes - available > budget) {
+        return false;
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+        if (a->second.priority != b->second.priority) {
+            return a->second.priority < b->second.priority;
+        }
+        return a->second.lastUse < b->second.lastUse;
+    });
+
+    for (auto it: candidates) {
+        if (used + bytes <= budget) {
+            break;
+        }
+        auto &entry = it->second;
+        if (entry.model != nullptr) {
+            models.erase(entry.name);
+            released->push_back(std::move(entry.model));
+        } else if (!entry.evict()) {
+            continue;
+        }
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "evict %s (%.1f MB)", entry.name.c_str(),
+                            entry.bytes / MB);
+        used -= entry.bytes;
+        evictions++;
+        evictedBytes += entry.bytes;
+        entries.erase(it);
+    }
+    return used + bytes <= budget;
+}
+
+size_t ResidencyManager::insert(Entry entry) {
+    auto handle = nextHandle++;
+    entry.lastUse = ++clock;
+    used += entry.bytes;
+    peak = std::max(peak, used);
+    loads++;
+    entries.emplace(handle, std::move(entry));
+    return handle;
+}
+
+void ResidencyManager::clear() {
+    std::vector<std::shared_ptr<void>> released;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &model: models) {
+        auto it = entries.find(model.second);
+        used -= it->second.bytes;
+        released.push_back(std::move(it->second.model));
+        entries.erase(it);
+    }
+    models.clear();
+}
+
+std::string ResidencyManager::getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t pinned = 0;
+    for (auto &entry: entries) {
+        if (entry.second.pinned) {
+            pinned += entry.second.bytes;
+        }
+    }
+    std::ostringstream oss;
+    oss.setf(std::ios::fixed);
+    oss.precision(1);
+    oss << "{\"budget_mb\": " << budget / MB << ", \"used_mb\": " << used / MB
+        << ", \"pinned_mb\": " << pinned / MB << ", \"peak_mb\": " << peak / MB
+        << ", \"entries\": " << entries.size() << ", \"models\": " << models.size()
+        << ", \"loads\": " << loads << ", \"model_hits\": " << modelHits
+        << ", \"evictions\": " << evictions << ", \"evicted_mb\": " << evictedBytes / MB
+        << ", \"rejects\": " << rejects << "}";
+    return oss.str();
+}
@@ -0,0 +1,127 @@
+//
+// Created by 구현우 on 2024/07/26.
+//
+
+#ifndef MY_OPENCL_RESIDENCYMANAGER_H
+#define MY_OPENCL_RESIDENCYMANAGER_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * device memory budget 안에서 model (TextEncoder 등) 과 block (ModelGraph layer) 의 weight 를 유지 (RESIDENCY_MODE).
+ * 각 entry 는 weight bytes 와 priority 를 가지고, budget 을 넘으면 priority 가 낮은 것부터, 같으면 LRU 로 evict.
+ * evict 된 block 은 다음 사용 시 다시 load.
+ *
+ * - 같은 owner, 같은 priority 의 entry 는 서로 evict 하지 않음. graph 는 매 step 같은 순서로 layer 를 쓰므로
+ *   LRU 로 밀어내면 모든 layer 를 다시 load 하게 됨 (앞쪽 layer 가 남고 나머지는 매번 load).
+ * - pinned entry (명시적으로 resident, e.g. replay 중인 UNet) 는 bytes 만 세고 evict 하지 않음.
+ * - evict callback 은 manager lock 안에서 호출. owner 가 사용 중이면 (try_lock 실패) false 를 반환하고 건너뜀.
+ */
+class ResidencyManager {
+public:
+    /* 높을수록 오래 유지 */
+    enum Priority {
+        /* image 마다 한 번 (TextEncoder 는 EmbeddingCache 로 더 드묾) */
+        LOW = 0,
+        NORMAL = 1,
+        /* step 마다 (UNet) */
+        HIGH = 2
+    };
+
+    /* @return: false 이면 지금 evict 할 수 없음 */
+    typedef std::function<bool()> Evict;
+
+    static ResidencyManager &getInstance();
+
+    /* `budget`: bytes. 0 이면 off (add 는 항상 실패, acquire 는 매번 생성) */
+    void init(size_t budget);
+
+    bool isEnabled();
+
+    /*
+     * `bytes` 만큼 공간을 만들고 (필요하면 evict) 등록.
+     * @return: handle, 0 이면 공간 부족 (등록하지 않음, caller 가 바로 해제)
+     */
+    size_t add(const void *owner, const std::string &name, size_t bytes, int priority,
+               bool pinned, const Evict &evict);
+
+    /* 사용 (LRU 갱신) */
+    void touch(size_t handle);
+
+    /* owner 가 직접 해제. evict callback 은 호출하지 않음 */
+    void remove(size_t handle);
+
+    /*
+     * `name` 의 model 을 반환. 없으면 `create` 로 생성 후 (`bytes` 로) 등록.
+     * manager 가 꺼져 있거나 공간이 없으면 등록하지 않고 생성한 것을 반환 (caller 가 끝나면 해제).
+     */
+    template<typename T>
+    std::shared_ptr<T> acquire(const std::string &name, size_t bytes, int priority,
+                               const std::function<std::shared_ptr<T>()> &create) {
+        auto model = find(name);
+        if (model != nullptr) {
+            return std::static_pointer_cast<T>(model);
+        }
+        auto instance = create();
+        addModel(name, bytes, priority, instance);
+        return instance;
+    }
+
+    /* 모든 model 을 놓음 (context release 전) */
+    void clear();
+
+    /* budget, used, peak, entry 수, load / evict / reject 횟수 (JSON) */
+    std::string getStats();
+
+private:
+    struct Entry {
+        const void *owner;
+        std::string name;
+        size_t bytes;
+        int priority;
+        bool pinned;
+        long long lastUse;
+        Evict evict;
+        /* model entry (acquire) */
+        std::shared_ptr<void> model;
+    };
+
+    ResidencyManager() = default;
+
+    std::shared_ptr<void> find(const std::string &name);
+
+    void addModel(const std::string &name, size_t bytes, int priority,
+                  const std::shared_ptr<void> &model);
+
+    /* lock 안에서. evict 한 model 은 `released` 로 (lock 밖에서 해제) */
+    bool reserve(const void *owner, size_t bytes, int priority,
+                 std::vector<std::shared_ptr<void>> *released);
+
+    size_t insert(Entry entry);
+
+    std::map<size_t, Entry> entries;
+    /* model name -> handle */
+    std::map<std::string, size_t> models;
+
+    size_t budget = 0;
+    size_t used = 0;
+    size_t peak = 0;
+    size_t nextHandle = 1;
+    long long clock = 0;
+
+    size_t loads = 0;
+    size_t evictions = 0;
+    size_t evictedBytes = 0;
+    size_t rejects = 0;
+    size_t modelHits = 0;
+
+    std::mutex mutex;
+};
+
+
+#endif //MY_OPENCL_RESIDENCYMANAGER_H
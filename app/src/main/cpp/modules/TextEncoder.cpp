@@ -4,6 +4,9 @@
 
 #include "TextEncoder.h"
 #include "util.h"
+#include "Tracer.h"
+#include "setting.h"
+#include "cpu/CpuBackend.h"
 
 #include <chrono>
 
@@ -12,6 +15,7 @@
 #define NUM_HEADS 16
 #define CONTEXT_LENGTH 77
 #define LAYERS (24-1)
+#define VOCAB_SIZE 49408
 
 #define CHECK_ERROR(err) \
     if (err != CL_SUCCESS) { \
@@ -33,7 +37,20 @@ TextEncoder::TextEncoder(
         cl_command_queue cmdQueue,
         cl_device_id deviceId
 ) : context(context), cmdQueue(cmdQueue) {
+#if TOKEN_EMBEDDING_MODE == 0
     embedding = util::load_npy_file("encoder/embedding_fp32.npy");
+#elif TOKEN_EMBEDDING_MODE == 1
+    bufferEmbeddingTable = util::load_npy_file("encoder/embedding_fp32.npy", nullptr, context,
+                                               cmdQueue);
+#else
+    try {
+        bufferEmbeddingTable = util::load_npy_file_half("encoder/embedding_fp16.npy", nullptr,
+                                                        context, cmdQueue);
+    } catch (const std::runtime_error &e) {
+        bufferEmbeddingTable = util::load_npy_file_half("encoder/embedding_fp32.npy", nullptr,
+                                                        context, cmdQueue);
+    }
+#endif
     bufferPositionalEmbedding = util::load_npy_file("encoder/positional_embedding_fp32.npy",
                                                     nullptr, context, cmdQueue);
     bufferAttentionMask = util::load_npy_file("encoder/attn_mask_fp32.npy", nullptr, context,
@@ -96,6 +113,21 @@ TextEncoder::~TextEncoder() {
     delete ln_final;
     clReleaseMemObject(bufferPositionalEmbedding);
     clReleaseMemObject(bufferAttentionMask);
+    if (bufferEmbeddingTable != nullptr) {
+        clReleaseMemObject(bufferEmbeddingTable);
+    }
+}
+
+size_t TextEncoder::weightBytes() {
+    size_t d = EMBEDDING_SIZE;
+    /* ln_1, attn (in_proj, out_proj), ln_2, mlp (c_fc, c_proj) */
+    size_t block = 2 * d + (3 * d * d + 3 * d) + (d * d + d) + 2 * d +
+                   (d * 4 * d + 4 * d) + (4 * d * d + d);
+    /* positional embedding, attention mask, ln_final */
+    size_t count = LAYERS * block + CONTEXT_LENGTH * d + CONTEXT_LENGTH * CONTEXT_LENGTH + 2 * d;
+    size_t table = TOKEN_EMBEDDING_MODE == 0 ? 0 : VOCAB_SIZE * d *
+                                                   (TOKEN_EMBEDDING_MODE == 2 ? 2 : sizeof(float));
+    return count * sizeof(float) + table;
 }
 
 /*
@@ -124,11 +156,48 @@ cl_mem TextEncoder::createTokenEmbeddingBuffer(const std::vector<long> &token) {
     return buffer;
 }
 
+/*
+ * batch 1 이므로 (CONTEXT_LENGTH, 1, EMBEDDING_SIZE) 와 permute 한 (1, CONTEXT_LENGTH, EMBEDDING_SIZE) 의 layout 이 같음.
+ * `output` 은 permute 결과로 바로 사용.
+ */
+cl_int TextEncoder::enqueueTokenEmbedding(const std::vector<long> &token, cl_mem output,
+                                          cl_event *event) {
+    cl_int err;
+    std::vector<cl_int> ids(token.begin(), token.end());
+    auto bufferTokens = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                       sizeof(cl_int) * ids.size(), ids.data(), &err);
+    if (err != CL_SUCCESS) {
+        return err;
+    }
+
+    auto kernel = TOKEN_EMBEDDING_MODE == 2 ? utilKernel->token_embedding_half
+                                            : utilKernel->token_embedding;
+    err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &bufferTokens);
+    err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &bufferEmbeddingTable);
+    err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &bufferPositionalEmbedding);
+    err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &output);
+    if (err == CL_SUCCESS) {
+        size_t globalSize[2] = {token.size(), EMBEDDING_SIZE / 4};
+        err = clEnqueueNDRangeKernel(cmdQueue, kernel, 2, nullptr, globalSize, nullptr, 0,
+                                     nullptr, event);
+    }
+    /* kernel 이 끝날 때까지 runtime 이 유지 */
+    clReleaseMemObject(bufferTokens);
+    if (err != CL_SUCCESS) {
+        return err;
+    }
+    Tracer::getInstance().record("token_embedding", *event);
+    return CL_SUCCESS;
+}
+
 std::vector<float> TextEncoder::encode(const std::vector<long> &token) {
+    Tracer::Scope scope("text_encoder");
+    CpuBackend::Scope cpuScope(CPU_BACKEND_MODE >= 1);
     cl_int err;
     cl_event event1, event2, event3, event4, event5, event6;
     cl_mem bufferEmbedding, bufferTemp;
 
+#if TOKEN_EMBEDDING_MODE == 0
     // elemwise_add
     bufferEmbedding = createTokenEmbeddingBuffer(token);
     // util::testBuffer(cmdQueue, bufferEmbedding, "encoder/test/embedding_test_fp32.npy");
@@ -149,6 +218,7 @@ std::vector<float> TextEncoder::encode(const std::vector<long> &token) {
                                  nullptr,
                                  &event1);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("elemwise_add", event1);
 
 
 //    util::testBuffer(cmdQueue, bufferEmbedding, "encoder/test/positional_embedding_test_fp32.npy");
@@ -167,22 +237,40 @@ std::vector<float> TextEncoder::encode(const std::vector<long> &token) {
                                  &event1,
                                  &event2);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("permute3D_1_0_2", event2);
 
 //    util::testBuffer(cmdQueue, bufferTemp, "encoder/test/permute_test_fp32.npy");
 //    );
 
+#else
+    bufferEmbedding = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                     sizeof(float) * token.size() * EMBEDDING_SIZE,
+                                     nullptr, &err);
+    CHECK_ERROR(err);
+    bufferTemp = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                sizeof(float) * token.size() * EMBEDDING_SIZE,
+                                nullptr, &err);
+    CHECK_ERROR(err);
+
+    // gather + elemwise_add + permute
+    err = enqueueTokenEmbedding(token, bufferTemp, &event2);
+    CHECK_ERROR(err);
+    event1 = nullptr;
+#endif
+
     /* text_transformer_forward(x) */
     // init swapped state
     auto &inBuffer = bufferEmbedding;
     auto &outBuffer = bufferTemp;
     auto &inEvent = event3;
     auto &outEvent = event2;
-    for (auto block: resBlocks) {
+    for (int i = 0; i < resBlocks.size(); i++) {
+        Tracer::Scope scope("resblocks/" + std::to_string(i));
         // swap buffer and event
         std::swap(inBuffer, outBuffer);
         std::swap(inEvent, outEvent);
 
-        err = block->forward(inBuffer, outBuffer, 1, &inEvent, &outEvent);
+        err = resBlocks[i]->forward(inBuffer, outBuffer, 1, &inEvent, &outEvent);
         CHECK_ERROR(err);
     }
 
@@ -201,9 +289,13 @@ std::vector<float> TextEncoder::encode(const std::vector<long> &token) {
                                  &outEvent,
                                  &event4);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("permute3D_1_0_2", event4);
 
     /* ln_final(x) */
-    err = ln_final->forward(inBuffer, outBuffer, 1, &event4, &event5);
+    {
+        Tracer::Scope scope("ln_final");
+        err = ln_final->forward(inBuffer, outBuffer, 1, &event4, &event5);
+    }
     CHECK_ERROR(err);
 
     // max diff: 0.00002861022949218750
@@ -217,7 +309,9 @@ std::vector<float> TextEncoder::encode(const std::vector<long> &token) {
 
     clReleaseMemObject(bufferTemp);
     clReleaseMemObject(bufferEmbedding);
-    clReleaseEvent(event1);
+    if (event1 != nullptr) {
+        clReleaseEvent(event1);
+    }
     clReleaseEvent(event2);
     clReleaseEvent(event3);
     clReleaseEvent(event4);
@@ -35,13 +35,22 @@ public:
 
     std::vector<float> encode(const std::vector<long> &token);
 
+    /* device 에 올리는 weight bytes (token embedding 은 host) */
+    static size_t weightBytes();
+
 private:
     cl_mem createTokenEmbeddingBuffer(const std::vector<long> &token);
 
+    /* table[token] + positional embedding -> `output` (device gather) */
+    cl_int enqueueTokenEmbedding(const std::vector<long> &token, cl_mem output, cl_event *event);
+
     cl_context context;
     cl_command_queue cmdQueue;
 
+    /* TOKEN_EMBEDDING_MODE 0 */
     cnpy::NpyArray embedding;
+    /* TOKEN_EMBEDDING_MODE 1, 2 : (vocab, EMBEDDING_SIZE) fp32 / fp16 */
+    cl_mem bufferEmbeddingTable = nullptr;
 
     std::vector<ResidualAttentionBlock *> resBlocks;
     LayerNorm *ln_final;
@@ -0,0 +1,124 @@
+//
+// Created by 구현우 on 2024/07/25.
+//
+
+#include "TokenizerBenchmark.h"
+#include "tokenizer.h"
+
+#include <android/log.h>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <sys/stat.h>
+
+#define LOG_TAG "TOKENIZER_BENCHMARK"
+
+#define MEDIA_PATH "/sdcard/Android/media/com.example.myopencl/"
+
+static const char *SUBJECTS[] = {
+        "an astronaut riding a horse", "a cat sitting on a sofa", "a lighthouse at sunset",
+        "a portrait of an old fisherman", "a cyberpunk city street at night",
+        "a bowl of ramen", "a red sports car", "a castle on a hill", "a dragon's nest",
+        "a cozy café interior",
+};
+
+static const char *STYLES[] = {
+        "professional photograph", "oil painting", "watercolor", "digital art",
+        "trending on artstation", "highly detailed", "4k", "35mm film", "studio lighting",
+        "unreal engine", "concept art", "bokeh", "volumetric light", "sharp focus",
+};
+
+TokenizerBenchmark::TokenizerBenchmark(size_t numPrompts, int repeat)
+        : numPrompts(numPrompts), repeat(repeat) {
+}
+
+TokenizerBenchmark::~TokenizerBenchmark() = default;
+
+std::vector<std::string> TokenizerBenchmark::makePrompts() const {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> subject(0, sizeof(SUBJECTS) / sizeof(SUBJECTS[0]) - 1);
+    std::uniform_int_distribution<size_t> style(0, sizeof(STYLES) / sizeof(STYLES[0]) - 1);
+    std::uniform_int_distribution<int> numStyles(1, 8);
+    std::uniform_int_distribution<int> number(0, 99999);
+
+    std::vector<std::string> prompts;
+    prompts.reserve(numPrompts);
+    for (size_t i = 0; i < numPrompts; i++) {
+        /* 숫자 (seed 값 같은) 로 cache 에 없는 pre-token 도 섞음 */
+        std::string prompt = std::string(SUBJECTS[subject(gen)]) + ", seed " +
+                             std::to_string(number(gen));
+        for (int j = numStyles(gen); j > 0; j--) {
+            prompt += ", ";
+            prompt += STYLES[style(gen)];
+        }
+        prompts.push_back(std::move(prompt));
+    }
+    return prompts;
+}
+
+/* padding (0) 제외. 마지막 0 이 아닌 token 이 eot */
+static size_t countTokens(const std::vector<long> &tokens) {
+    size_t count = 0;
+    for (size_t i = 0; i < tokens.size(); i += CONTEXT_LENGTH) {
+        size_t length = CONTEXT_LENGTH;
+        while (length > 0 && tokens[i + length - 1] == 0) {
+            length--;
+        }
+        count += length;
+    }
+    return count;
+}
+
+std::string TokenizerBenchmark::run() {
+    auto prompts = makePrompts();
+
+    auto start = std::chrono::steady_clock::now();
+    SimpleTokenizer tokenizer;
+    auto stop = std::chrono::steady_clock::now();
+    auto construct = std::chrono::duration<double, std::milli>(stop - start).count();
+
+    std::vector<long> tokens;
+    start = std::chrono::steady_clock::now();
+    tokens = tokenizer.tokenize(prompts);
+    stop = std::chrono::steady_clock::now();
+    auto cold = std::chrono::duration<double, std::milli>(stop - start).count();
+    auto numTokens = countTokens(tokens);
+
+    double warm = 0;
+    for (int i = 0; i < repeat; i++) {
+        start = std::chrono::steady_clock::now();
+        tokens = tokenizer.tokenize(prompts);
+        stop = std::chrono::steady_clock::now();
+        warm += std::chrono::duration<double, std::milli>(stop - start).count();
+    }
+    warm /= repeat > 0 ? repeat : 1;
+
+    std::ostringstream oss;
+    oss.setf(std::ios::fixed);
+    oss.precision(3);
+    oss << "{\n";
+    oss << "  \"prompts\": " << prompts.size() << ",\n";
+    oss << "  \"tokens\": " << numTokens << ",\n";
+    oss << "  \"construct_ms\": " << construct << ",\n";
+    auto pass = [&](const char *name, double ms, bool last) {
+        oss << "  \"" << name << "\": {\"ms\": " << ms
+            << ", \"prompts_per_sec\": " << (ms > 0 ? prompts.size() * 1000.0 / ms : 0.0)
+            << ", \"tokens_per_sec\": " << (ms > 0 ? numTokens * 1000.0 / ms : 0.0) << "}"
+            << (last ? "\n" : ",\n");
+    };
+    pass("cold", cold, false);
+    pass("warm", warm, true);
+    oss << "}\n";
+
+    auto json = oss.str();
+    mkdir(MEDIA_PATH "benchmark", 0777);
+    std::ofstream file(MEDIA_PATH "benchmark/tokenizer_benchmark.json", std::ios::trunc);
+    if (file.is_open()) {
+        file << json;
+    } else {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to open %s",
+                            MEDIA_PATH "benchmark/tokenizer_benchmark.json");
+    }
+    return json;
+}
@@ -0,0 +1,37 @@
+//
+// Created by 구현우 on 2024/07/25.
+//
+
+#ifndef MY_OPENCL_TOKENIZERBENCHMARK_H
+#define MY_OPENCL_TOKENIZERBENCHMARK_H
+
+#include <string>
+#include <vector>
+
+/*
+ * SimpleTokenizer throughput.
+ * 단어 조합으로 만든 prompt batch 를 cold (bpe cache 비움) / warm 으로 tokenize 해서
+ * 생성 시간, prompts/s, tokens/s (padding 제외) 를 JSON 으로 저장.
+ *
+ * result : MEDIA_PATH/benchmark/tokenizer_benchmark.json
+ */
+class TokenizerBenchmark {
+public:
+    /* `numPrompts`: batch 크기, `repeat`: warm 반복 횟수 */
+    explicit TokenizerBenchmark(size_t numPrompts = 10000, int repeat = 5);
+
+    ~TokenizerBenchmark();
+
+    /* @return: JSON */
+    std::string run();
+
+private:
+    /* seed 고정 */
+    std::vector<std::string> makePrompts() const;
+
+    size_t numPrompts;
+    int repeat;
+};
+
+
+#endif //MY_OPENCL_TOKENIZERBENCHMARK_H
@@ -0,0 +1,275 @@
+//
+// Created by 구현우 on 2024/07/10.
+//
+
+#include "Tracer.h"
+
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#define LOG_TAG "TRACER"
+
+#define MEDIA_PATH "/sdcard/Android/media/com.example.myopencl/"
+
+/* pid of Chrome trace */
+#define HOST_PID 1
+#define DEVICE_PID 2
+
+#define CHECK_ERROR_THROW(err) \
+    if (err != CL_SUCCESS) { \
+      __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "[%s:%d] OpenCL error %d\n", __FILE__, __LINE__, err); \
+      throw std::runtime_error("OpenCL error."); \
+    }
+
+static thread_local std::vector<std::string> path;
+
+Tracer::Scope::Scope(const std::string &name) : depth(path.size()) {
+    active = Tracer::getInstance().isEnabled();
+    if (active) {
+        Tracer::getInstance().push(name);
+    }
+}
+
+Tracer::Scope::~Scope() {
+    if (active) {
+        path.resize(depth);
+    }
+}
+
+Tracer::HostSpan::HostSpan(const std::string &name) : begin(0) {
+    active = Tracer::getInstance().isEnabled();
+    if (active) {
+        this->name = name;
+        begin = Tracer::now();
+    }
+}
+
+Tracer::HostSpan::~HostSpan() {
+    end();
+}
+
+void Tracer::HostSpan::end() {
+    if (active) {
+        Tracer::getInstance().addHostSpan(name, begin, Tracer::now());
+        active = false;
+    }
+}
+
+Tracer &Tracer::getInstance() {
+    static Tracer instance;
+    return instance;
+}
+
+void Tracer::init(cl_command_queue _cmdQueue, bool _enabled) {
+    cmdQueue = _cmdQueue;
+    enabled = _enabled;
+    clear();
+    if (enabled) {
+        calibrate();
+    }
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "init: enabled(%d)", _enabled);
+}
+
+bool Tracer::isEnabled() const {
+    return enabled;
+}
+
+void Tracer::record(const std::string &name, cl_event event) {
+    if (!enabled || event == nullptr) {
+        return;
+    }
+
+    auto prefix = currentPath();
+    auto pendingEvent = new Pending{this, prefix.empty() ? name : prefix + "/" + name};
+    clRetainEvent(event);
+    pending++;
+    cl_int err = clSetEventCallback(event, CL_COMPLETE, &Tracer::onComplete, pendingEvent);
+    if (err != CL_SUCCESS) {
+        pending--;
+        clReleaseEvent(event);
+        delete pendingEvent;
+    }
+}
+
+/* profiling info 만 읽고 return. blocking OpenCL call 은 하지 않음 */
+void CL_CALLBACK Tracer::onComplete(cl_event event, cl_int status, void *userData) {
+    auto pendingEvent = static_cast<Pending *>(userData);
+    auto tracer = pendingEvent->tracer;
+
+    cl_ulong queued, start, end;
+    cl_int err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_QUEUED, sizeof(cl_ulong),
+                                         &queued, nullptr);
+    err |= clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start,
+                                   nullptr);
+    err |= clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end,
+                                   nullptr);
+    if (status == CL_COMPLETE && err == CL_SUCCESS) {
+        std::lock_guard<std::mutex> lock(tracer->mutex);
+        tracer->entries.push_back(
+                {pendingEvent->name,
+                 static_cast<long long>(start) + tracer->offset,
+                 static_cast<long long>(end) + tracer->offset,
+                 static_cast<long long>(queued) + tracer->offset,
+                 0, true});
+    }
+
+    clReleaseEvent(event);
+    delete pendingEvent;
+    {
+        std::lock_guard<std::mutex> lock(tracer->mutex);
+        tracer->pending--;
+    }
+    tracer->pendingDone.notify_all();
+}
+
+void Tracer::save(const std::string &name) {
+    if (!enabled) {
+        return;
+    }
+
+    clFinish(cmdQueue);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        /* callback 은 clFinish 이후에 호출될 수 있음 */
+        if (!pendingDone.wait_for(lock, std::chrono::seconds(1), [this] { return pending == 0; })) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "save: %d events not completed",
+                                pending.load());
+        }
+    }
+
+    auto json = toJson();
+    mkdir(MEDIA_PATH "trace", 0777);
+    auto fileName = std::string(MEDIA_PATH) + "trace/" + name + ".json";
+    std::ofstream file(fileName, std::ios::trunc);
+    if (file.is_open()) {
+        file << json;
+    } else {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to open %s", fileName.c_str());
+    }
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "save: %s (%ld events)", fileName.c_str(),
+                        entries.size());
+
+    clear();
+    calibrate();
+}
+
+/*
+ * device event 는 out of order queue 에서 겹칠 수 있으므로 겹치지 않는 lane (tid) 에 배치.
+ * ts, dur : us
+ */
+std::string Tracer::toJson() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<Entry *> deviceEntries;
+    for (auto &entry: entries) {
+        if (entry.device) {
+            deviceEntries.push_back(&entry);
+        }
+    }
+    std::sort(deviceEntries.begin(), deviceEntries.end(), [](const Entry *a, const Entry *b) {
+        return a->begin < b->begin;
+    });
+    std::vector<long long> lanes;
+    for (auto entry: deviceEntries) {
+        int lane;
+        for (lane = 0; lane < lanes.size(); lane++) {
+            if (lanes[lane] <= entry->begin) {
+                break;
+            }
+        }
+        if (lane == lanes.size()) {
+            lanes.push_back(0);
+        }
+        lanes[lane] = entry->end;
+        entry->tid = lane;
+    }
+
+    std::ostringstream oss;
+    oss.setf(std::ios::fixed);
+    oss.precision(3);
+    oss << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    oss << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << HOST_PID
+        << ", \"args\": {\"name\": \"host\"}},\n";
+    oss << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << DEVICE_PID
+        << ", \"args\": {\"name\": \"gpu\"}}";
+    for (auto &entry: entries) {
+        auto category = entry.name.substr(0, entry.name.find('/'));
+        oss << ",\n{\"name\": \"" << entry.name << "\", \"cat\": \"" << category
+            << "\", \"ph\": \"X\", \"ts\": " << (entry.begin - origin) / 1000.0
+            << ", \"dur\": " << (entry.end - entry.begin) / 1000.0
+            << ", \"pid\": " << (entry.device ? DEVICE_PID : HOST_PID)
+            << ", \"tid\": " << entry.tid;
+        if (entry.device) {
+            oss << ", \"args\": {\"queued_us\": " << (entry.begin - entry.queued) / 1000.0 << "}";
+        }
+        oss << "}";
+    }
+    oss << "\n]}\n";
+    return oss.str();
+}
+
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    origin = now();
+}
+
+long long Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string Tracer::currentPath() {
+    std::string result;
+    for (auto &name: path) {
+        if (!result.empty()) {
+            result += "/";
+        }
+        result += name;
+    }
+    return result;
+}
+
+/*
+ * device clock 과 host clock 의 offset.
+ * OpenCL 2.0 에는 clGetDeviceAndHostTimer 가 없으므로 marker 완료 직후의 host time 과 비교.
+ * (clWaitForEvents return latency 만큼 device event 가 늦게 보임)
+ */
+void Tracer::calibrate() {
+    cl_int err;
+    cl_event marker;
+    err = clEnqueueMarkerWithWaitList(cmdQueue, 0, nullptr, &marker);
+    CHECK_ERROR_THROW(err);
+    err = clWaitForEvents(1, &marker);
+    auto host = now();
+    CHECK_ERROR_THROW(err);
+
+    cl_ulong end;
+    err = clGetEventProfilingInfo(marker, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end,
+                                  nullptr);
+    clReleaseEvent(marker);
+    CHECK_ERROR_THROW(err);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    offset = host - static_cast<long long>(end);
+}
+
+void Tracer::push(const std::string &name) {
+    path.push_back(name);
+}
+
+void Tracer::addHostSpan(const std::string &name, long long begin, long long end) {
+    auto prefix = currentPath();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto id = std::this_thread::get_id();
+    if (threads.find(id) == threads.end()) {
+        auto tid = static_cast<int>(threads.size());
+        threads[id] = tid;
+    }
+    entries.push_back({prefix.empty() ? name : prefix + "/" + name, begin, end, begin,
+                       threads[id], false});
+}
@@ -0,0 +1,119 @@
+//
+// Created by 구현우 on 2024/07/10.
+//
+
+#ifndef MY_OPENCL_TRACER_H
+#define MY_OPENCL_TRACER_H
+
+#define CL_TARGET_OPENCL_VERSION 200
+
+#include "CL/opencl.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * layer 별 kernel execution trace.
+ * enqueue 한 cl_event 를 현재 scope 이름 (e.g. unet/input_block/4/spatial/attn2/einsum_qk) 으로
+ * 등록하면 CL_COMPLETE callback 에서 profiling time 을 비동기로 수집.
+ * host 구간 (weight load 등) 은 HostSpan 으로 기록.
+ *
+ * result : MEDIA_PATH/trace/<name>.json (Chrome trace, chrome://tracing or ui.perfetto.dev)
+ */
+class Tracer {
+public:
+    /* scope 이름을 push, 소멸 시 생성 시점의 depth 로 복구 (exception 포함) */
+    class Scope {
+    public:
+        explicit Scope(const std::string &name);
+
+        ~Scope();
+
+    private:
+        size_t depth;
+        bool active;
+    };
+
+    /* 현재 scope 아래 host 구간 */
+    class HostSpan {
+    public:
+        explicit HostSpan(const std::string &name);
+
+        ~HostSpan();
+
+        /* 소멸 전에 구간을 끝낼 때 */
+        void end();
+
+    private:
+        std::string name;
+        long long begin;
+        bool active;
+    };
+
+    static Tracer &getInstance();
+
+    void init(cl_command_queue cmdQueue, bool enabled);
+
+    bool isEnabled() const;
+
+    /* `event` 는 retain 되므로 호출한 쪽에서 바로 release 해도 됨 */
+    void record(const std::string &name, cl_event event);
+
+    /* 수집이 끝날 때까지 기다린 후 MEDIA_PATH/trace/<name>.json 에 저장하고 clear */
+    void save(const std::string &name);
+
+    std::string toJson();
+
+    void clear();
+
+private:
+    struct Entry {
+        std::string name;
+        long long begin;
+        long long end;
+        long long queued;
+        int tid;
+        bool device;
+    };
+
+    struct Pending {
+        Tracer *tracer;
+        std::string name;
+    };
+
+    Tracer() = default;
+
+    static void CL_CALLBACK onComplete(cl_event event, cl_int status, void *userData);
+
+    static long long now();
+
+    static std::string currentPath();
+
+    void calibrate();
+
+    void push(const std::string &name);
+
+    void addHostSpan(const std::string &name, long long begin, long long end);
+
+    cl_command_queue cmdQueue = nullptr;
+    std::atomic<bool> enabled{false};
+
+    /* host time (ns) = device time (ns) + offset */
+    long long offset = 0;
+    long long origin = 0;
+
+    std::vector<Entry> entries;
+    std::map<std::thread::id, int> threads;
+    std::mutex mutex;
+
+    std::atomic<int> pending{0};
+    std::condition_variable pendingDone;
+};
+
+
+#endif //MY_OPENCL_TRACER_H
@@ -5,14 +5,19 @@
 #include "UNetModel.h"
 
 #include "util.h"
+#include "Tracer.h"
+#include "ResidencyManager.h"
 #include <android/log.h>
 #include "setting.h"
+#include "cpu/CpuBackend.h"
 
 #define LOG_TAG "UNET_MODEL"
 #define MODEL_CHANNELS 320
 #define TIME_EMBED_DIM (4 * MODEL_CHANNELS)
+#define CONTEXT_LENGTH 77
 #define CONTEXT_DIM 1024
-#define NUM_HEAD_CHANNELS 64
+#define LATENT_CHANNELS 4
+#define MIDDLE_BLOCK_HEADS 20
 
 #define CHECK_ERROR(err) \
     if (err != CL_SUCCESS) { \
@@ -20,1921 +25,326 @@
       throw std::runtime_error("OpenCL error."); \
     }
 
+/*
+ * input_blocks[1:] / output_blocks (SD 2.x, model_channels 320, channel_mult (1, 2, 4, 4)).
+ * channels: ResBlock 출력 채널 (input block 의 down sample 은 0)
+ * heads: SpatialTransformer head 수 (0 이면 없음), head dim 은 64
+ * sample: input block 은 stride 2 conv (op), output block 은 마지막에 UpSample (conv)
+ * 입력 채널은 이전 block (output block 은 + skip) 에서 추론.
+ */
+struct UNetBlock {
+    size_t channels;
+    size_t heads;
+    bool sample;
+    ModelGraph::Naming naming;
+};
+
+static const UNetBlock INPUT_BLOCKS[] = {
+        {320,  5,  false, ModelGraph::LEGACY},
+        {320,  5,  false, ModelGraph::LDM},
+        {0,    0,  true,  ModelGraph::LDM},
+        {640,  10, false, ModelGraph::LDM},
+        {640,  10, false, ModelGraph::LDM},
+        {0,    0,  true,  ModelGraph::LDM},
+        {1280, 20, false, ModelGraph::LDM},
+        {1280, 20, false, ModelGraph::LDM},
+        {0,    0,  true,  ModelGraph::LDM},
+        {1280, 0,  false, ModelGraph::LDM},
+        {1280, 0,  false, ModelGraph::LDM},
+};
+
+static const UNetBlock OUTPUT_BLOCKS[] = {
+        {1280, 0,  false, ModelGraph::LDM},
+        {1280, 0,  false, ModelGraph::LDM},
+        {1280, 0,  true,  ModelGraph::LDM},
+        {1280, 20, false, ModelGraph::LDM},
+        {1280, 20, false, ModelGraph::LDM},
+        {1280, 20, true,  ModelGraph::LDM},
+        {640,  10, false, ModelGraph::LDM},
+        {640,  10, false, ModelGraph::LDM},
+        {640,  10, true,  ModelGraph::LDM},
+        {320,  5,  false, ModelGraph::LDM},
+        {320,  5,  false, ModelGraph::LDM},
+        {320,  5,  false, ModelGraph::LDM},
+};
+
+/*
+ * e.g. ("input_block", 2, 1) -> unet/input_block/2/input_blocks_2_1
+ * LEGACY 는 layer 위치 없이 unet/input_block/1/input_block_1
+ */
+static std::string blockPrefix(const std::string &section, size_t index, size_t position,
+                               ModelGraph::Naming naming) {
+    auto i = std::to_string(index);
+    if (naming == ModelGraph::LEGACY) {
+        return "unet/" + section + "/" + i + "/" + section + "_" + i;
+    }
+    return "unet/" + section + "/" + i + "/" + section + "s_" + i + "_" + std::to_string(position);
+}
+
 UNetModel::UNetModel(
         AAssetManager *assetManager,
         cl_context context,
         cl_command_queue cmdQueue,
-        cl_device_id deviceId
-) : context(context), cmdQueue(cmdQueue), deviceId(deviceId), assetManager(assetManager) {
-    layerNormKernel = std::make_shared<LayerNormKernel>(context, deviceId, assetManager);
-    linearKernel = std::make_shared<LinearKernel>(context, deviceId, assetManager);
-    utilKernel = std::make_shared<UtilKernel>(context, deviceId, assetManager);
-    convKernel = std::make_shared<ConvKernel>(context, deviceId, assetManager);
-    crossAttentionKernel = std::make_shared<CrossAttentionKernel>(context, deviceId, assetManager);
-    gegluKernel = std::make_shared<GEGLUKernel>(context, deviceId, assetManager);
-    groupNormKernel = std::make_shared<GroupNormKernel>(context, deviceId, assetManager);
-    upSampleKernel = std::make_shared<UpSampleKernel>(context, deviceId, assetManager);
-    time_embed_0 = new Linear(context, cmdQueue,
-                              320, 1280,
-                              "unet/time_embed/time_embed_0_weight.npy",
-                              "unet/time_embed/time_embed_0_bias.npy",
-                              linearKernel, utilKernel);
-    time_embed_0->init();
-
-    time_embed_2 = new Linear(context, cmdQueue,
-                              1280, 1280,
-                              "unet/time_embed/time_embed_2_weight.npy",
-                              "unet/time_embed/time_embed_2_bias.npy",
-                              linearKernel, utilKernel);
-    time_embed_2->init();
-
-#if UNET_LOAD_MODE == 1
-    initInputBlock0();
-    initInputBlock1();
-    initInputBlock2();
-    initInputBlock3();
-    initInputBlock4();
-    initInputBlock5();
-    initInputBlock6();
-    initInputBlock7();
-    initInputBlock8();
-    initInputBlock9();
-    initInputBlock10();
-    initInputBlock11();
-
-    input_block_0_conv2d->init();
-    input_block_1_res_block->init();
-    input_block_1_spatial->init();
-    input_block_2_res_block->init();
-    input_block_2_spatial->init();
-    input_block_3_conv2d->init();
-    input_block_4_res_block->init();
-    input_block_4_spatial->init();
-    input_block_5_res_block->init();
-    input_block_5_spatial->init();
-    input_block_6_conv2d->init();
-    input_block_7_res_block->init();
-    input_block_7_spatial->init();
-    input_block_8_res_block->init();
-    input_block_8_spatial->init();
-    input_block_9_conv2d->init();
-    input_block_10_res_block->init();
-    input_block_11_res_block->init();
-#endif
-}
-
-void UNetModel::initInputBlock0() {
-    input_block_0_conv2d = new Conv2D(context, cmdQueue,
-                                      4, 320, 3, 1, 1,
-                                      "unet/input_block/0/input_block_0_conv2d_weight.npy",
-                                      "unet/input_block/0/input_block_0_conv2d_bias.npy",
-                                      convKernel);
-}
-
-void UNetModel::initInputBlock1() {
-    input_block_1_res_block = new ResBlock(context, cmdQueue,
-                                           320, TIME_EMBED_DIM, 320,
-                                           "unet/input_block/1/input_block_1_res_block_in_group_norm_weight.npy",
-                                           "unet/input_block/1/input_block_1_res_block_in_group_norm_bias.npy",
-                                           "unet/input_block/1/input_block_1_res_block_in_conv2d_weight.npy",
-                                           "unet/input_block/1/input_block_1_res_block_in_conv2d_bias.npy",
-                                           "unet/input_block/1/input_block_1_res_block_embed_linear_weight.npy",
-                                           "unet/input_block/1/input_block_1_res_block_embed_linear_bias.npy",
-                                           "unet/input_block/1/input_block_1_res_block_out_group_norm_weight.npy",
-                                           "unet/input_block/1/input_block_1_res_block_out_group_norm_bias.npy",
-                                           "unet/input_block/1/input_block_1_res_block_out_conv2d_weight.npy",
-                                           "unet/input_block/1/input_block_1_res_block_out_conv2d_bias.npy",
-                                           "", "",
-                                           linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    input_block_1_spatial = new SpatialTransformer(context, cmdQueue,
-                                                   320, CONTEXT_DIM, 5, NUM_HEAD_CHANNELS,
-                                                   "unet/input_block/1/input_block_1_spatial_group_norm_weight.npy",
-                                                   "unet/input_block/1/input_block_1_spatial_group_norm_bias.npy",
-                                                   "unet/input_block/1/input_block_1_spatial_in_linear_weight.npy",
-                                                   "unet/input_block/1/input_block_1_spatial_in_linear_bias.npy",
-                                                   "unet/input_block/1/input_block_1_basic_layer_norm_1_weight.npy",
-                                                   "unet/input_block/1/input_block_1_basic_layer_norm_1_bias.npy",
-                                                   "unet/input_block/1/input_block_1_basic_layer_norm_2_weight.npy",
-                                                   "unet/input_block/1/input_block_1_basic_layer_norm_2_bias.npy",
-                                                   "unet/input_block/1/input_block_1_basic_layer_norm_3_weight.npy",
-                                                   "unet/input_block/1/input_block_1_basic_layer_norm_3_bias.npy",
-                                                   "unet/input_block/1/input_block_1_cross_1_q_linear_weight.npy",
-                                                   "unet/input_block/1/input_block_1_cross_1_k_linear_weight.npy",
-                                                   "unet/input_block/1/input_block_1_cross_1_v_linear_weight.npy",
-                                                   "unet/input_block/1/input_block_1_cross_1_out_linear_weight.npy",
-                                                   "unet/input_block/1/input_block_1_cross_1_out_linear_bias.npy",
-                                                   "unet/input_block/1/input_block_1_cross_2_q_linear_weight.npy",
-                                                   "unet/input_block/1/input_block_1_cross_2_k_linear_weight.npy",
-                                                   "unet/input_block/1/input_block_1_cross_2_v_linear_weight.npy",
-                                                   "unet/input_block/1/input_block_1_cross_2_out_linear_weight.npy",
-                                                   "unet/input_block/1/input_block_1_cross_2_out_linear_bias.npy",
-                                                   "unet/input_block/1/input_block_1_ff_geglu_linear_weight.npy",
-                                                   "unet/input_block/1/input_block_1_ff_geglu_linear_bias.npy",
-                                                   "unet/input_block/1/input_block_1_ff_net_linear_weight.npy",
-                                                   "unet/input_block/1/input_block_1_ff_net_linear_bias.npy",
-                                                   "unet/input_block/1/input_block_1_spatial_out_linear_weight.npy",
-                                                   "unet/input_block/1/input_block_1_spatial_out_linear_bias.npy",
-                                                   layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-}
-
-void UNetModel::initInputBlock2() {
-    input_block_2_res_block = new ResBlock(context, cmdQueue,
-                                           320, TIME_EMBED_DIM, 320,
-                                           "unet/input_block/2/input_blocks_2_0_in_layers_0_weight.npy",
-                                           "unet/input_block/2/input_blocks_2_0_in_layers_0_bias.npy",
-                                           "unet/input_block/2/input_blocks_2_0_in_layers_2_weight.npy",
-                                           "unet/input_block/2/input_blocks_2_0_in_layers_2_bias.npy",
-                                           "unet/input_block/2/input_blocks_2_0_emb_layers_1_weight.npy",
-                                           "unet/input_block/2/input_blocks_2_0_emb_layers_1_bias.npy",
-                                           "unet/input_block/2/input_blocks_2_0_out_layers_0_weight.npy",
-                                           "unet/input_block/2/input_blocks_2_0_out_layers_0_bias.npy",
-                                           "unet/input_block/2/input_blocks_2_0_out_layers_3_weight.npy",
-                                           "unet/input_block/2/input_blocks_2_0_out_layers_3_bias.npy",
-                                           "", "",
-                                           linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    input_block_2_spatial = new SpatialTransformer(context, cmdQueue,
-                                                   320, CONTEXT_DIM, 5, NUM_HEAD_CHANNELS,
-                                                   "unet/input_block/2/input_blocks_2_1_norm_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_norm_bias.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_proj_in_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_proj_in_bias.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_norm1_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_norm1_bias.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_norm2_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_norm2_bias.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_norm3_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_norm3_bias.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_proj_out_weight.npy",
-                                                   "unet/input_block/2/input_blocks_2_1_proj_out_bias.npy",
-                                                   layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-
-}
-
-void UNetModel::initInputBlock3() {
-    input_block_3_conv2d = new Conv2D(context, cmdQueue,
-                                      320, 320, 3, 2, 1,
-                                      "unet/input_block/3/input_blocks_3_0_op_weight.npy",
-                                      "unet/input_block/3/input_blocks_3_0_op_bias.npy",
-                                      convKernel);
-}
-
-void UNetModel::initInputBlock4() {
-    input_block_4_res_block = new ResBlock(context, cmdQueue,
-                                           320, TIME_EMBED_DIM, 640,
-                                           "unet/input_block/4/input_blocks_4_0_in_layers_0_weight.npy",
-                                           "unet/input_block/4/input_blocks_4_0_in_layers_0_bias.npy",
-                                           "unet/input_block/4/input_blocks_4_0_in_layers_2_weight.npy",
-                                           "unet/input_block/4/input_blocks_4_0_in_layers_2_bias.npy",
-                                           "unet/input_block/4/input_blocks_4_0_emb_layers_1_weight.npy",
-                                           "unet/input_block/4/input_blocks_4_0_emb_layers_1_bias.npy",
-                                           "unet/input_block/4/input_blocks_4_0_out_layers_0_weight.npy",
-                                           "unet/input_block/4/input_blocks_4_0_out_layers_0_bias.npy",
-                                           "unet/input_block/4/input_blocks_4_0_out_layers_3_weight.npy",
-                                           "unet/input_block/4/input_blocks_4_0_out_layers_3_bias.npy",
-                                           "unet/input_block/4/input_blocks_4_0_skip_connection_weight.npy",
-                                           "unet/input_block/4/input_blocks_4_0_skip_connection_bias.npy",
-                                           linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    input_block_4_spatial = new SpatialTransformer(context, cmdQueue,
-                                                   640, CONTEXT_DIM, 10, NUM_HEAD_CHANNELS,
-                                                   "unet/input_block/4/input_blocks_4_1_norm_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_norm_bias.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_proj_in_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_proj_in_bias.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_norm1_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_norm1_bias.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_norm2_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_norm2_bias.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_norm3_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_norm3_bias.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_proj_out_weight.npy",
-                                                   "unet/input_block/4/input_blocks_4_1_proj_out_bias.npy",
-                                                   layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-}
-
-void UNetModel::initInputBlock5() {
-    input_block_5_res_block = new ResBlock(context, cmdQueue,
-                                           640, TIME_EMBED_DIM, 640,
-                                           "unet/input_block/5/input_blocks_5_0_in_layers_0_weight.npy",
-                                           "unet/input_block/5/input_blocks_5_0_in_layers_0_bias.npy",
-                                           "unet/input_block/5/input_blocks_5_0_in_layers_2_weight.npy",
-                                           "unet/input_block/5/input_blocks_5_0_in_layers_2_bias.npy",
-                                           "unet/input_block/5/input_blocks_5_0_emb_layers_1_weight.npy",
-                                           "unet/input_block/5/input_blocks_5_0_emb_layers_1_bias.npy",
-                                           "unet/input_block/5/input_blocks_5_0_out_layers_0_weight.npy",
-                                           "unet/input_block/5/input_blocks_5_0_out_layers_0_bias.npy",
-                                           "unet/input_block/5/input_blocks_5_0_out_layers_3_weight.npy",
-                                           "unet/input_block/5/input_blocks_5_0_out_layers_3_bias.npy",
-                                           "", "",
-                                           linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    input_block_5_spatial = new SpatialTransformer(context, cmdQueue,
-                                                   640, CONTEXT_DIM, 10, NUM_HEAD_CHANNELS,
-                                                   "unet/input_block/5/input_blocks_5_1_norm_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_norm_bias.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_proj_in_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_proj_in_bias.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_norm1_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_norm1_bias.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_norm2_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_norm2_bias.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_norm3_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_norm3_bias.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_proj_out_weight.npy",
-                                                   "unet/input_block/5/input_blocks_5_1_proj_out_bias.npy",
-                                                   layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-
-}
-
-void UNetModel::initInputBlock6() {
-    input_block_6_conv2d = new Conv2D(context, cmdQueue,
-                                      640, 640, 3, 2, 1,
-                                      "unet/input_block/6/input_blocks_6_0_op_weight.npy",
-                                      "unet/input_block/6/input_blocks_6_0_op_bias.npy",
-                                      convKernel);
-}
-
-void UNetModel::initInputBlock7() {
-    input_block_7_res_block = new ResBlock(context, cmdQueue,
-                                           640, TIME_EMBED_DIM, 1280,
-                                           "unet/input_block/7/input_blocks_7_0_in_layers_0_weight.npy",
-                                           "unet/input_block/7/input_blocks_7_0_in_layers_0_bias.npy",
-                                           "unet/input_block/7/input_blocks_7_0_in_layers_2_weight.npy",
-                                           "unet/input_block/7/input_blocks_7_0_in_layers_2_bias.npy",
-                                           "unet/input_block/7/input_blocks_7_0_emb_layers_1_weight.npy",
-                                           "unet/input_block/7/input_blocks_7_0_emb_layers_1_bias.npy",
-                                           "unet/input_block/7/input_blocks_7_0_out_layers_0_weight.npy",
-                                           "unet/input_block/7/input_blocks_7_0_out_layers_0_bias.npy",
-                                           "unet/input_block/7/input_blocks_7_0_out_layers_3_weight.npy",
-                                           "unet/input_block/7/input_blocks_7_0_out_layers_3_bias.npy",
-                                           "unet/input_block/7/input_blocks_7_0_skip_connection_weight.npy",
-                                           "unet/input_block/7/input_blocks_7_0_skip_connection_bias.npy",
-                                           linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    input_block_7_spatial = new SpatialTransformer(context, cmdQueue,
-                                                   1280, CONTEXT_DIM, 20, NUM_HEAD_CHANNELS,
-                                                   "unet/input_block/7/input_blocks_7_1_norm_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_norm_bias.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_proj_in_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_proj_in_bias.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_norm1_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_norm1_bias.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_norm2_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_norm2_bias.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_norm3_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_norm3_bias.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_proj_out_weight.npy",
-                                                   "unet/input_block/7/input_blocks_7_1_proj_out_bias.npy",
-                                                   layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-}
-
-void UNetModel::initInputBlock8() {
-    input_block_8_res_block = new ResBlock(context, cmdQueue,
-                                           1280, TIME_EMBED_DIM, 1280,
-                                           "unet/input_block/8/input_blocks_8_0_in_layers_0_weight.npy",
-                                           "unet/input_block/8/input_blocks_8_0_in_layers_0_bias.npy",
-                                           "unet/input_block/8/input_blocks_8_0_in_layers_2_weight.npy",
-                                           "unet/input_block/8/input_blocks_8_0_in_layers_2_bias.npy",
-                                           "unet/input_block/8/input_blocks_8_0_emb_layers_1_weight.npy",
-                                           "unet/input_block/8/input_blocks_8_0_emb_layers_1_bias.npy",
-                                           "unet/input_block/8/input_blocks_8_0_out_layers_0_weight.npy",
-                                           "unet/input_block/8/input_blocks_8_0_out_layers_0_bias.npy",
-                                           "unet/input_block/8/input_blocks_8_0_out_layers_3_weight.npy",
-                                           "unet/input_block/8/input_blocks_8_0_out_layers_3_bias.npy",
-                                           "", "",
-                                           linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    input_block_8_spatial = new SpatialTransformer(context, cmdQueue,
-                                                   1280, CONTEXT_DIM, 20, NUM_HEAD_CHANNELS,
-                                                   "unet/input_block/8/input_blocks_8_1_norm_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_norm_bias.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_proj_in_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_proj_in_bias.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_norm1_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_norm1_bias.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_norm2_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_norm2_bias.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_norm3_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_norm3_bias.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_proj_out_weight.npy",
-                                                   "unet/input_block/8/input_blocks_8_1_proj_out_bias.npy",
-                                                   layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-}
-
-void UNetModel::initInputBlock9() {
-    input_block_9_conv2d = new Conv2D(context, cmdQueue,
-                                      1280, 1280, 3, 2, 1,
-                                      "unet/input_block/9/input_blocks_9_0_op_weight.npy",
-                                      "unet/input_block/9/input_blocks_9_0_op_bias.npy",
-                                      convKernel);
-}
-
-void UNetModel::initInputBlock10() {
-    input_block_10_res_block = new ResBlock(context, cmdQueue,
-                                            1280, TIME_EMBED_DIM, 1280,
-                                            "unet/input_block/10/input_blocks_10_0_in_layers_0_weight.npy",
-                                            "unet/input_block/10/input_blocks_10_0_in_layers_0_bias.npy",
-                                            "unet/input_block/10/input_blocks_10_0_in_layers_2_weight.npy",
-                                            "unet/input_block/10/input_blocks_10_0_in_layers_2_bias.npy",
-                                            "unet/input_block/10/input_blocks_10_0_emb_layers_1_weight.npy",
-                                            "unet/input_block/10/input_blocks_10_0_emb_layers_1_bias.npy",
-                                            "unet/input_block/10/input_blocks_10_0_out_layers_0_weight.npy",
-                                            "unet/input_block/10/input_blocks_10_0_out_layers_0_bias.npy",
-                                            "unet/input_block/10/input_blocks_10_0_out_layers_3_weight.npy",
-                                            "unet/input_block/10/input_blocks_10_0_out_layers_3_bias.npy",
-                                            "", "",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-}
-
-void UNetModel::initInputBlock11() {
-    input_block_11_res_block = new ResBlock(context, cmdQueue,
-                                            1280, TIME_EMBED_DIM, 1280,
-                                            "unet/input_block/11/input_blocks_11_0_in_layers_0_weight.npy",
-                                            "unet/input_block/11/input_blocks_11_0_in_layers_0_bias.npy",
-                                            "unet/input_block/11/input_blocks_11_0_in_layers_2_weight.npy",
-                                            "unet/input_block/11/input_blocks_11_0_in_layers_2_bias.npy",
-                                            "unet/input_block/11/input_blocks_11_0_emb_layers_1_weight.npy",
-                                            "unet/input_block/11/input_blocks_11_0_emb_layers_1_bias.npy",
-                                            "unet/input_block/11/input_blocks_11_0_out_layers_0_weight.npy",
-                                            "unet/input_block/11/input_blocks_11_0_out_layers_0_bias.npy",
-                                            "unet/input_block/11/input_blocks_11_0_out_layers_3_weight.npy",
-                                            "unet/input_block/11/input_blocks_11_0_out_layers_3_bias.npy",
-                                            "", "",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-}
-
-
-void UNetModel::initMiddleBlock() {
-    middle_block_0_res_block = new ResBlock(context, cmdQueue,
-                                            1280, TIME_EMBED_DIM, 1280,
-                                            "unet/middle_block/0/middle_block_0_in_layers_0_weight.npy",
-                                            "unet/middle_block/0/middle_block_0_in_layers_0_bias.npy",
-                                            "unet/middle_block/0/middle_block_0_in_layers_2_weight.npy",
-                                            "unet/middle_block/0/middle_block_0_in_layers_2_bias.npy",
-                                            "unet/middle_block/0/middle_block_0_emb_layers_1_weight.npy",
-                                            "unet/middle_block/0/middle_block_0_emb_layers_1_bias.npy",
-                                            "unet/middle_block/0/middle_block_0_out_layers_0_weight.npy",
-                                            "unet/middle_block/0/middle_block_0_out_layers_0_bias.npy",
-                                            "unet/middle_block/0/middle_block_0_out_layers_3_weight.npy",
-                                            "unet/middle_block/0/middle_block_0_out_layers_3_bias.npy",
-                                            "", "",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    middle_block_1_spatial = new SpatialTransformer(context, cmdQueue,
-                                                    1280, CONTEXT_DIM, 20, NUM_HEAD_CHANNELS,
-                                                    "unet/middle_block/1/middle_block_1_norm_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_norm_bias.npy",
-                                                    "unet/middle_block/1/middle_block_1_proj_in_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_proj_in_bias.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_norm1_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_norm1_bias.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_norm2_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_norm2_bias.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_norm3_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_norm3_bias.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                    "unet/middle_block/1/middle_block_1_proj_out_weight.npy",
-                                                    "unet/middle_block/1/middle_block_1_proj_out_bias.npy",
-                                                    layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-
-    middle_block_2_res_block = new ResBlock(context, cmdQueue,
-                                            1280, TIME_EMBED_DIM, 1280,
-                                            "unet/middle_block/2/middle_block_2_in_layers_0_weight.npy",
-                                            "unet/middle_block/2/middle_block_2_in_layers_0_bias.npy",
-                                            "unet/middle_block/2/middle_block_2_in_layers_2_weight.npy",
-                                            "unet/middle_block/2/middle_block_2_in_layers_2_bias.npy",
-                                            "unet/middle_block/2/middle_block_2_emb_layers_1_weight.npy",
-                                            "unet/middle_block/2/middle_block_2_emb_layers_1_bias.npy",
-                                            "unet/middle_block/2/middle_block_2_out_layers_0_weight.npy",
-                                            "unet/middle_block/2/middle_block_2_out_layers_0_bias.npy",
-                                            "unet/middle_block/2/middle_block_2_out_layers_3_weight.npy",
-                                            "unet/middle_block/2/middle_block_2_out_layers_3_bias.npy",
-                                            "", "",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-}
-
-void UNetModel::initOutputBlock0() {
-    output_block_0_res_block = new ResBlock(context, cmdQueue,
-                                            2560, TIME_EMBED_DIM, 1280,
-                                            "unet/output_block/0/output_blocks_0_0_in_layers_0_weight.npy",
-                                            "unet/output_block/0/output_blocks_0_0_in_layers_0_bias.npy",
-                                            "unet/output_block/0/output_blocks_0_0_in_layers_2_weight.npy",
-                                            "unet/output_block/0/output_blocks_0_0_in_layers_2_bias.npy",
-                                            "unet/output_block/0/output_blocks_0_0_emb_layers_1_weight.npy",
-                                            "unet/output_block/0/output_blocks_0_0_emb_layers_1_bias.npy",
-                                            "unet/output_block/0/output_blocks_0_0_out_layers_0_weight.npy",
-                                            "unet/output_block/0/output_blocks_0_0_out_layers_0_bias.npy",
-                                            "unet/output_block/0/output_blocks_0_0_out_layers_3_weight.npy",
-                                            "unet/output_block/0/output_blocks_0_0_out_layers_3_bias.npy",
-                                            "unet/output_block/0/output_blocks_0_0_skip_connection_weight.npy",
-                                            "unet/output_block/0/output_blocks_0_0_skip_connection_bias.npy",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-}
-
-
-void UNetModel::initOutputBlock1() {
-    output_block_1_res_block = new ResBlock(context, cmdQueue,
-                                            2560, TIME_EMBED_DIM, 1280,
-                                            "unet/output_block/1/output_blocks_1_0_in_layers_0_weight.npy",
-                                            "unet/output_block/1/output_blocks_1_0_in_layers_0_bias.npy",
-                                            "unet/output_block/1/output_blocks_1_0_in_layers_2_weight.npy",
-                                            "unet/output_block/1/output_blocks_1_0_in_layers_2_bias.npy",
-                                            "unet/output_block/1/output_blocks_1_0_emb_layers_1_weight.npy",
-                                            "unet/output_block/1/output_blocks_1_0_emb_layers_1_bias.npy",
-                                            "unet/output_block/1/output_blocks_1_0_out_layers_0_weight.npy",
-                                            "unet/output_block/1/output_blocks_1_0_out_layers_0_bias.npy",
-                                            "unet/output_block/1/output_blocks_1_0_out_layers_3_weight.npy",
-                                            "unet/output_block/1/output_blocks_1_0_out_layers_3_bias.npy",
-                                            "unet/output_block/1/output_blocks_1_0_skip_connection_weight.npy",
-                                            "unet/output_block/1/output_blocks_1_0_skip_connection_bias.npy",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-}
-
-void UNetModel::initOutputBlock2() {
-    output_block_2_res_block = new ResBlock(context, cmdQueue,
-                                            2560, TIME_EMBED_DIM, 1280,
-                                            "unet/output_block/2/output_blocks_2_0_in_layers_0_weight.npy",
-                                            "unet/output_block/2/output_blocks_2_0_in_layers_0_bias.npy",
-                                            "unet/output_block/2/output_blocks_2_0_in_layers_2_weight.npy",
-                                            "unet/output_block/2/output_blocks_2_0_in_layers_2_bias.npy",
-                                            "unet/output_block/2/output_blocks_2_0_emb_layers_1_weight.npy",
-                                            "unet/output_block/2/output_blocks_2_0_emb_layers_1_bias.npy",
-                                            "unet/output_block/2/output_blocks_2_0_out_layers_0_weight.npy",
-                                            "unet/output_block/2/output_blocks_2_0_out_layers_0_bias.npy",
-                                            "unet/output_block/2/output_blocks_2_0_out_layers_3_weight.npy",
-                                            "unet/output_block/2/output_blocks_2_0_out_layers_3_bias.npy",
-                                            "unet/output_block/2/output_blocks_2_0_skip_connection_weight.npy",
-                                            "unet/output_block/2/output_blocks_2_0_skip_connection_bias.npy",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    output_block_2_up_sample = new UpSample(context, cmdQueue,
-                                            1280, 1280, 3, 1, 1,
-                                            "unet/output_block/2/output_blocks_2_1_conv_weight.npy",
-                                            "unet/output_block/2/output_blocks_2_1_conv_bias.npy",
-                                            convKernel, upSampleKernel);
-}
-
-void UNetModel::initOutputBlock3() {
-    output_block_3_res_block = new ResBlock(context, cmdQueue,
-                                            2560, TIME_EMBED_DIM, 1280,
-                                            "unet/output_block/3/output_blocks_3_0_in_layers_0_weight.npy",
-                                            "unet/output_block/3/output_blocks_3_0_in_layers_0_bias.npy",
-                                            "unet/output_block/3/output_blocks_3_0_in_layers_2_weight.npy",
-                                            "unet/output_block/3/output_blocks_3_0_in_layers_2_bias.npy",
-                                            "unet/output_block/3/output_blocks_3_0_emb_layers_1_weight.npy",
-                                            "unet/output_block/3/output_blocks_3_0_emb_layers_1_bias.npy",
-                                            "unet/output_block/3/output_blocks_3_0_out_layers_0_weight.npy",
-                                            "unet/output_block/3/output_blocks_3_0_out_layers_0_bias.npy",
-                                            "unet/output_block/3/output_blocks_3_0_out_layers_3_weight.npy",
-                                            "unet/output_block/3/output_blocks_3_0_out_layers_3_bias.npy",
-                                            "unet/output_block/3/output_blocks_3_0_skip_connection_weight.npy",
-                                            "unet/output_block/3/output_blocks_3_0_skip_connection_bias.npy",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    output_block_3_spatial = new SpatialTransformer(context, cmdQueue,
-                                                    1280, CONTEXT_DIM, 20, NUM_HEAD_CHANNELS,
-                                                    "unet/output_block/3/output_blocks_3_1_norm_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_norm_bias.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_proj_in_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_proj_in_bias.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_norm1_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_norm1_bias.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_norm2_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_norm2_bias.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_norm3_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_norm3_bias.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_proj_out_weight.npy",
-                                                    "unet/output_block/3/output_blocks_3_1_proj_out_bias.npy",
-                                                    layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-}
-
-void UNetModel::initOutputBlock4() {
-    output_block_4_res_block = new ResBlock(context, cmdQueue,
-                                            2560, TIME_EMBED_DIM, 1280,
-                                            "unet/output_block/4/output_blocks_4_0_in_layers_0_weight.npy",
-                                            "unet/output_block/4/output_blocks_4_0_in_layers_0_bias.npy",
-                                            "unet/output_block/4/output_blocks_4_0_in_layers_2_weight.npy",
-                                            "unet/output_block/4/output_blocks_4_0_in_layers_2_bias.npy",
-                                            "unet/output_block/4/output_blocks_4_0_emb_layers_1_weight.npy",
-                                            "unet/output_block/4/output_blocks_4_0_emb_layers_1_bias.npy",
-                                            "unet/output_block/4/output_blocks_4_0_out_layers_0_weight.npy",
-                                            "unet/output_block/4/output_blocks_4_0_out_layers_0_bias.npy",
-                                            "unet/output_block/4/output_blocks_4_0_out_layers_3_weight.npy",
-                                            "unet/output_block/4/output_blocks_4_0_out_layers_3_bias.npy",
-                                            "unet/output_block/4/output_blocks_4_0_skip_connection_weight.npy",
-                                            "unet/output_block/4/output_blocks_4_0_skip_connection_bias.npy",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    output_block_4_spatial = new SpatialTransformer(context, cmdQueue,
-                                                    1280, CONTEXT_DIM, 20, NUM_HEAD_CHANNELS,
-                                                    "unet/output_block/4/output_blocks_4_1_norm_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_norm_bias.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_proj_in_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_proj_in_bias.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_norm1_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_norm1_bias.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_norm2_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_norm2_bias.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_norm3_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_norm3_bias.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_proj_out_weight.npy",
-                                                    "unet/output_block/4/output_blocks_4_1_proj_out_bias.npy",
-                                                    layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-}
-
-void UNetModel::initOutputBlock5() {
-    output_block_5_res_block = new ResBlock(context, cmdQueue,
-                                            1920, TIME_EMBED_DIM, 1280,
-                                            "unet/output_block/5/output_blocks_5_0_in_layers_0_weight.npy",
-                                            "unet/output_block/5/output_blocks_5_0_in_layers_0_bias.npy",
-                                            "unet/output_block/5/output_blocks_5_0_in_layers_2_weight.npy",
-                                            "unet/output_block/5/output_blocks_5_0_in_layers_2_bias.npy",
-                                            "unet/output_block/5/output_blocks_5_0_emb_layers_1_weight.npy",
-                                            "unet/output_block/5/output_blocks_5_0_emb_layers_1_bias.npy",
-                                            "unet/output_block/5/output_blocks_5_0_out_layers_0_weight.npy",
-                                            "unet/output_block/5/output_blocks_5_0_out_layers_0_bias.npy",
-                                            "unet/output_block/5/output_blocks_5_0_out_layers_3_weight.npy",
-                                            "unet/output_block/5/output_blocks_5_0_out_layers_3_bias.npy",
-                                            "unet/output_block/5/output_blocks_5_0_skip_connection_weight.npy",
-                                            "unet/output_block/5/output_blocks_5_0_skip_connection_bias.npy",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    output_block_5_spatial = new SpatialTransformer(context, cmdQueue,
-                                                    1280, CONTEXT_DIM, 20, NUM_HEAD_CHANNELS,
-                                                    "unet/output_block/5/output_blocks_5_1_norm_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_norm_bias.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_proj_in_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_proj_in_bias.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_norm1_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_norm1_bias.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_norm2_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_norm2_bias.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_norm3_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_norm3_bias.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_proj_out_weight.npy",
-                                                    "unet/output_block/5/output_blocks_5_1_proj_out_bias.npy",
-                                                    layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-
-    output_block_5_up_sample = new UpSample(context, cmdQueue,
-                                            1280, 1280, 3, 1, 1,
-                                            "unet/output_block/5/output_blocks_5_2_conv_weight.npy",
-                                            "unet/output_block/5/output_blocks_5_2_conv_bias.npy",
-                                            convKernel, upSampleKernel);
-}
-
-void UNetModel::initOutputBlock6() {
-    output_block_6_res_block = new ResBlock(context, cmdQueue,
-                                            1920, TIME_EMBED_DIM, 640,
-                                            "unet/output_block/6/output_blocks_6_0_in_layers_0_weight.npy",
-                                            "unet/output_block/6/output_blocks_6_0_in_layers_0_bias.npy",
-                                            "unet/output_block/6/output_blocks_6_0_in_layers_2_weight.npy",
-                                            "unet/output_block/6/output_blocks_6_0_in_layers_2_bias.npy",
-                                            "unet/output_block/6/output_blocks_6_0_emb_layers_1_weight.npy",
-                                            "unet/output_block/6/output_blocks_6_0_emb_layers_1_bias.npy",
-                                            "unet/output_block/6/output_blocks_6_0_out_layers_0_weight.npy",
-                                            "unet/output_block/6/output_blocks_6_0_out_layers_0_bias.npy",
-                                            "unet/output_block/6/output_blocks_6_0_out_layers_3_weight.npy",
-                                            "unet/output_block/6/output_blocks_6_0_out_layers_3_bias.npy",
-                                            "unet/output_block/6/output_blocks_6_0_skip_connection_weight.npy",
-                                            "unet/output_block/6/output_blocks_6_0_skip_connection_bias.npy",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    output_block_6_spatial = new SpatialTransformer(context, cmdQueue,
-                                                    640, CONTEXT_DIM, 10, NUM_HEAD_CHANNELS,
-                                                    "unet/output_block/6/output_blocks_6_1_norm_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_norm_bias.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_proj_in_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_proj_in_bias.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_norm1_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_norm1_bias.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_norm2_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_norm2_bias.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_norm3_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_norm3_bias.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_proj_out_weight.npy",
-                                                    "unet/output_block/6/output_blocks_6_1_proj_out_bias.npy",
-                                                    layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-}
-
-void UNetModel::initOutputBlock7() {
-    output_block_7_res_block = new ResBlock(context, cmdQueue,
-                                            1280, TIME_EMBED_DIM, 640,
-                                            "unet/output_block/7/output_blocks_7_0_in_layers_0_weight.npy",
-                                            "unet/output_block/7/output_blocks_7_0_in_layers_0_bias.npy",
-                                            "unet/output_block/7/output_blocks_7_0_in_layers_2_weight.npy",
-                                            "unet/output_block/7/output_blocks_7_0_in_layers_2_bias.npy",
-                                            "unet/output_block/7/output_blocks_7_0_emb_layers_1_weight.npy",
-                                            "unet/output_block/7/output_blocks_7_0_emb_layers_1_bias.npy",
-                                            "unet/output_block/7/output_blocks_7_0_out_layers_0_weight.npy",
-                                            "unet/output_block/7/output_blocks_7_0_out_layers_0_bias.npy",
-                                            "unet/output_block/7/output_blocks_7_0_out_layers_3_weight.npy",
-                                            "unet/output_block/7/output_blocks_7_0_out_layers_3_bias.npy",
-                                            "unet/output_block/7/output_blocks_7_0_skip_connection_weight.npy",
-                                            "unet/output_block/7/output_blocks_7_0_skip_connection_bias.npy",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    output_block_7_spatial = new SpatialTransformer(context, cmdQueue,
-                                                    640, CONTEXT_DIM, 10, NUM_HEAD_CHANNELS,
-                                                    "unet/output_block/7/output_blocks_7_1_norm_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_norm_bias.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_proj_in_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_proj_in_bias.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_norm1_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_norm1_bias.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_norm2_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_norm2_bias.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_norm3_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_norm3_bias.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_proj_out_weight.npy",
-                                                    "unet/output_block/7/output_blocks_7_1_proj_out_bias.npy",
-                                                    layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-}
-
-void UNetModel::initOutputBlock8() {
-    output_block_8_res_block = new ResBlock(context, cmdQueue,
-                                            960, TIME_EMBED_DIM, 640,
-                                            "unet/output_block/8/output_blocks_8_0_in_layers_0_weight.npy",
-                                            "unet/output_block/8/output_blocks_8_0_in_layers_0_bias.npy",
-                                            "unet/output_block/8/output_blocks_8_0_in_layers_2_weight.npy",
-                                            "unet/output_block/8/output_blocks_8_0_in_layers_2_bias.npy",
-                                            "unet/output_block/8/output_blocks_8_0_emb_layers_1_weight.npy",
-                                            "unet/output_block/8/output_blocks_8_0_emb_layers_1_bias.npy",
-                                            "unet/output_block/8/output_blocks_8_0_out_layers_0_weight.npy",
-                                            "unet/output_block/8/output_blocks_8_0_out_layers_0_bias.npy",
-                                            "unet/output_block/8/output_blocks_8_0_out_layers_3_weight.npy",
-                                            "unet/output_block/8/output_blocks_8_0_out_layers_3_bias.npy",
-                                            "unet/output_block/8/output_blocks_8_0_skip_connection_weight.npy",
-                                            "unet/output_block/8/output_blocks_8_0_skip_connection_bias.npy",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    output_block_8_spatial = new SpatialTransformer(context, cmdQueue,
-                                                    640, CONTEXT_DIM, 10, NUM_HEAD_CHANNELS,
-                                                    "unet/output_block/8/output_blocks_8_1_norm_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_norm_bias.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_proj_in_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_proj_in_bias.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_norm1_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_norm1_bias.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_norm2_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_norm2_bias.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_norm3_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_norm3_bias.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_proj_out_weight.npy",
-                                                    "unet/output_block/8/output_blocks_8_1_proj_out_bias.npy",
-                                                    layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-
-    output_block_8_up_sample = new UpSample(context, cmdQueue,
-                                            640, 640, 3, 1, 1,
-                                            "unet/output_block/8/output_blocks_8_2_conv_weight.npy",
-                                            "unet/output_block/8/output_blocks_8_2_conv_bias.npy",
-                                            convKernel, upSampleKernel);
-}
-
-void UNetModel::initOutputBlock9() {
-    output_block_9_res_block = new ResBlock(context, cmdQueue,
-                                            960, TIME_EMBED_DIM, 320,
-                                            "unet/output_block/9/output_blocks_9_0_in_layers_0_weight.npy",
-                                            "unet/output_block/9/output_blocks_9_0_in_layers_0_bias.npy",
-                                            "unet/output_block/9/output_blocks_9_0_in_layers_2_weight.npy",
-                                            "unet/output_block/9/output_blocks_9_0_in_layers_2_bias.npy",
-                                            "unet/output_block/9/output_blocks_9_0_emb_layers_1_weight.npy",
-                                            "unet/output_block/9/output_blocks_9_0_emb_layers_1_bias.npy",
-                                            "unet/output_block/9/output_blocks_9_0_out_layers_0_weight.npy",
-                                            "unet/output_block/9/output_blocks_9_0_out_layers_0_bias.npy",
-                                            "unet/output_block/9/output_blocks_9_0_out_layers_3_weight.npy",
-                                            "unet/output_block/9/output_blocks_9_0_out_layers_3_bias.npy",
-                                            "unet/output_block/9/output_blocks_9_0_skip_connection_weight.npy",
-                                            "unet/output_block/9/output_blocks_9_0_skip_connection_bias.npy",
-                                            linearKernel, convKernel, groupNormKernel, utilKernel);
-
-    output_block_9_spatial = new SpatialTransformer(context, cmdQueue,
-                                                    320, CONTEXT_DIM, 5, NUM_HEAD_CHANNELS,
-                                                    "unet/output_block/9/output_blocks_9_1_norm_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_norm_bias.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_proj_in_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_proj_in_bias.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_norm1_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_norm1_bias.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_norm2_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_norm2_bias.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_norm3_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_norm3_bias.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_proj_out_weight.npy",
-                                                    "unet/output_block/9/output_blocks_9_1_proj_out_bias.npy",
-                                                    layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
+        cl_device_id deviceId,
+        size_t height,
+        size_t width
+) : context(context), cmdQueue(cmdQueue), deviceId(deviceId), assetManager(assetManager),
+    height(height), width(width), graph(context, cmdQueue, deviceId, assetManager),
+    replayEnabled(UNET_REPLAY_MODE != 0) {
+    /* down sample 3 번 후 output block 에서 skip 과 concat */
+    if (height == 0 || width == 0 || height % 8 != 0 || width % 8 != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "latent %ldx%ld is not a multiple of 8",
+                            height, width);
+        throw std::runtime_error("UNet latent size must be a multiple of 8");
+    }
+    build();
 }
 
-void UNetModel::initOutputBlock10() {
-    output_block_10_res_block = new ResBlock(context, cmdQueue,
-                                             640, TIME_EMBED_DIM, 320,
-                                             "unet/output_block/10/output_blocks_10_0_in_layers_0_weight.npy",
-                                             "unet/output_block/10/output_blocks_10_0_in_layers_0_bias.npy",
-                                             "unet/output_block/10/output_blocks_10_0_in_layers_2_weight.npy",
-                                             "unet/output_block/10/output_blocks_10_0_in_layers_2_bias.npy",
-                                             "unet/output_block/10/output_blocks_10_0_emb_layers_1_weight.npy",
-                                             "unet/output_block/10/output_blocks_10_0_emb_layers_1_bias.npy",
-                                             "unet/output_block/10/output_blocks_10_0_out_layers_0_weight.npy",
-                                             "unet/output_block/10/output_blocks_10_0_out_layers_0_bias.npy",
-                                             "unet/output_block/10/output_blocks_10_0_out_layers_3_weight.npy",
-                                             "unet/output_block/10/output_blocks_10_0_out_layers_3_bias.npy",
-                                             "unet/output_block/10/output_blocks_10_0_skip_connection_weight.npy",
-                                             "unet/output_block/10/output_blocks_10_0_skip_connection_bias.npy",
-                                             linearKernel, convKernel, groupNormKernel, utilKernel);
+void UNetModel::build() {
+    graph.setResidency("unet/" + std::to_string(height) + "x" + std::to_string(width),
+                       ResidencyManager::HIGH);
+    timestepId = graph.input(MODEL_CHANNELS, 1, 1);
+    inputId = graph.input(LATENT_CHANNELS, height, width);
+    conditionId = graph.input(1, CONTEXT_LENGTH, CONTEXT_DIM);
 
-    output_block_10_spatial = new SpatialTransformer(context, cmdQueue,
-                                                     320, CONTEXT_DIM, 5, NUM_HEAD_CHANNELS,
-                                                     "unet/output_block/10/output_blocks_10_1_norm_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_norm_bias.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_proj_in_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_proj_in_bias.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_norm1_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_norm1_bias.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_norm2_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_norm2_bias.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_norm3_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_norm3_bias.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_proj_out_weight.npy",
-                                                     "unet/output_block/10/output_blocks_10_1_proj_out_bias.npy",
-                                                     layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-}
+    /* time_embed layer (항상 load) */
+    auto emb = graph.linear("time_embed/0", "unet/time_embed/time_embed_0", timestepId,
+                            TIME_EMBED_DIM);
+    emb = graph.silu("time_embed/1", emb);
+    emb = graph.linear("time_embed/2", "unet/time_embed/time_embed_2", emb, TIME_EMBED_DIM);
+    graph.load(0, graph.size(), true);
 
-void UNetModel::initOutputBlock11() {
-    output_block_11_res_block = new ResBlock(context, cmdQueue,
-                                             640, TIME_EMBED_DIM, 320,
-                                             "unet/output_block/11/output_blocks_11_0_in_layers_0_weight.npy",
-                                             "unet/output_block/11/output_blocks_11_0_in_layers_0_bias.npy",
-                                             "unet/output_block/11/output_blocks_11_0_in_layers_2_weight.npy",
-                                             "unet/output_block/11/output_blocks_11_0_in_layers_2_bias.npy",
-                                             "unet/output_block/11/output_blocks_11_0_emb_layers_1_weight.npy",
-                                             "unet/output_block/11/output_blocks_11_0_emb_layers_1_bias.npy",
-                                             "unet/output_block/11/output_blocks_11_0_out_layers_0_weight.npy",
-                                             "unet/output_block/11/output_blocks_11_0_out_layers_0_bias.npy",
-                                             "unet/output_block/11/output_blocks_11_0_out_layers_3_weight.npy",
-                                             "unet/output_block/11/output_blocks_11_0_out_layers_3_bias.npy",
-                                             "unet/output_block/11/output_blocks_11_0_skip_connection_weight.npy",
-                                             "unet/output_block/11/output_blocks_11_0_skip_connection_bias.npy",
-                                             linearKernel, convKernel, groupNormKernel, utilKernel);
+    /* input_block layer */
+    auto inputBegin = graph.size();
+    auto h = graph.conv2d("input_block/0/conv2d", "unet/input_block/0/input_block_0_conv2d",
+                          inputId, MODEL_CHANNELS, 3, 1, 1);
+    inputBlockIds = {h};
+    for (size_t k = 0; k < sizeof(INPUT_BLOCKS) / sizeof(UNetBlock); k++) {
+        auto &block = INPUT_BLOCKS[k];
+        auto i = k + 1;
+        auto name = "input_block/" + std::to_string(i);
+        if (block.sample) {
+            h = graph.conv2d(name + "/conv2d",
+                             blockPrefix("input_block", i, 0, block.naming) + "_op",
+                             h, graph.getTensor(h).channels, 3, 2, 1);
+        } else {
+            h = graph.resBlock(name + "/res_block", blockPrefix("input_block", i, 0, block.naming),
+                               block.naming, h, emb, block.channels);
+            if (block.heads > 0) {
+                h = graph.spatialTransformer(name + "/spatial",
+                                             blockPrefix("input_block", i, 1, block.naming),
+                                             block.naming, h, conditionId, block.heads);
+            }
+        }
+        inputBlockIds.push_back(h);
+    }
+#if UNET_LOAD_MODE == 1
+    graph.load(inputBegin, graph.size(), false);
+#endif
 
-    output_block_11_spatial = new SpatialTransformer(context, cmdQueue,
-                                                     320, CONTEXT_DIM, 5, NUM_HEAD_CHANNELS,
-                                                     "unet/output_block/11/output_blocks_11_1_norm_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_norm_bias.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_proj_in_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_proj_in_bias.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_norm1_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_norm1_bias.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_norm2_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_norm2_bias.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_norm3_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_norm3_bias.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_attn1_to_q_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_attn1_to_k_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_attn1_to_v_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_attn1_to_out_0_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_attn1_to_out_0_bias.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_attn2_to_q_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_attn2_to_k_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_attn2_to_v_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_attn2_to_out_0_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_attn2_to_out_0_bias.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_ff_net_0_proj_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_ff_net_0_proj_bias.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_ff_net_2_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_transformer_blocks_0_ff_net_2_bias.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_proj_out_weight.npy",
-                                                     "unet/output_block/11/output_blocks_11_1_proj_out_bias.npy",
-                                                     layerNormKernel, linearKernel, utilKernel, crossAttentionKernel, gegluKernel, groupNormKernel);
-}
+    /* middle_block layer */
+    auto channels = graph.getTensor(h).channels;
+    h = graph.resBlock("middle_block/0/res_block", "unet/middle_block/0/middle_block_0",
+                       ModelGraph::LDM, h, emb, channels);
+    h = graph.spatialTransformer("middle_block/1/spatial", "unet/middle_block/1/middle_block_1",
+                                 ModelGraph::LDM, h, conditionId, MIDDLE_BLOCK_HEADS);
+    h = graph.resBlock("middle_block/2/res_block", "unet/middle_block/2/middle_block_2",
+                       ModelGraph::LDM, h, emb, channels);
 
-void UNetModel::initOut() {
-    out_group_norm = new GroupNorm(context, cmdQueue,
-                                   32, 320, 1e-5,
-                                   "unet/out/out_group_norm_weight.npy",
-                                   "unet/out/out_group_norm_bias.npy",
-                                   groupNormKernel);
+    /* output_block layer */
+    auto skip = inputBlockIds.rbegin();
+    for (size_t i = 0; i < sizeof(OUTPUT_BLOCKS) / sizeof(UNetBlock); i++) {
+        auto &block = OUTPUT_BLOCKS[i];
+        auto name = "output_block/" + std::to_string(i);
+        size_t position = 0;
+        h = graph.concat(name + "/concat", h, *skip++);
+        h = graph.resBlock(name + "/res_block",
+                           blockPrefix("output_block", i, position++, block.naming),
+                           block.naming, h, emb, block.channels);
+        if (block.heads > 0) {
+            h = graph.spatialTransformer(name + "/spatial",
+                                         blockPrefix("output_block", i, position++, block.naming),
+                                         block.naming, h, conditionId, block.heads);
+        }
+        if (block.sample) {
+            h = graph.upSample(name + "/up_sample",
+                               blockPrefix("output_block", i, position, block.naming) + "_conv",
+                               h);
+        }
+    }
 
-    out_conv2d = new Conv2D(context, cmdQueue,
-                            320, 4, 3, 1, 1,
-                            "unet/out/out_conv2d_weight.npy",
-                            "unet/out/out_conv2d_bias.npy",
-                            convKernel);
+    /* out */
+    h = graph.groupNorm("out/group_norm", "unet/out/out_group_norm", h, 32, 1e-5);
+    h = graph.silu("out/silu", h);
+    outputId = graph.conv2d("out/conv2d", "unet/out/out_conv2d", h, LATENT_CHANNELS, 3, 1, 1);
 }
 
 UNetModel::~UNetModel() {
-    delete time_embed_0;
-    delete time_embed_2;
-    delete input_block_0_conv2d;
-    delete input_block_1_res_block;
-    delete input_block_1_spatial;
-    delete input_block_2_res_block;
-    delete input_block_2_spatial;
-    delete input_block_3_conv2d;
-    delete input_block_4_res_block;
-    delete input_block_4_spatial;
-    delete input_block_5_res_block;
-    delete input_block_5_spatial;
-    delete input_block_6_conv2d;
-    delete input_block_7_res_block;
-    delete input_block_7_spatial;
-    delete input_block_8_res_block;
-    delete input_block_8_spatial;
-    delete input_block_9_conv2d;
-    delete input_block_10_res_block;
-    delete input_block_11_res_block;
-    delete middle_block_0_res_block;
-    delete middle_block_1_spatial;
-    delete middle_block_2_res_block;
-    delete output_block_0_res_block;
-    delete output_block_1_res_block;
-    delete output_block_2_res_block;
-    delete output_block_2_up_sample;
-    delete output_block_3_res_block;
-    delete output_block_3_spatial;
-    delete output_block_4_res_block;
-    delete output_block_4_spatial;
-    delete output_block_5_res_block;
-    delete output_block_5_spatial;
-    delete output_block_5_up_sample;
-    delete output_block_6_res_block;
-    delete output_block_6_spatial;
-    delete output_block_7_res_block;
-    delete output_block_7_spatial;
-    delete output_block_8_res_block;
-    delete output_block_8_spatial;
-    delete output_block_8_up_sample;
-    delete output_block_9_res_block;
-    delete output_block_9_spatial;
-    delete output_block_10_res_block;
-    delete output_block_10_spatial;
-    delete output_block_11_res_block;
-    delete output_block_11_spatial;
-    delete out_group_norm;
-    delete out_conv2d;
+    recorder.reset();
+    if (replayTimeEmbed != nullptr) {
+        clReleaseMemObject(replayTimeEmbed);
+        clReleaseMemObject(replayInput);
+        clReleaseMemObject(replayCondition);
+    }
 }
 
 /*
  * Assume Batch size 'B' is 1.
- * @param x: [B, LATENT_CHANNEL(4), HEIGHT/DOWN_SAMPLING(512/8=64), WIDTH/DOWN_SAMPLING(512/8=64)]
+ * @param x: [B, LATENT_CHANNEL(4), height (HEIGHT/DOWN_SAMPLING), width (WIDTH/DOWN_SAMPLING)]
  * @param timestep: long. originally [B]
  * @param condition: [B, CONTEXT_LENGTH(77), EMBEDDING_SIZE(1024)]
  */
 std::vector<float> UNetModel::forward(const std::vector<float> &x, long timestep,
                                       const std::vector<float> &condition) {
+    Tracer::Scope scope("unet");
+    CpuBackend::Scope cpuScope(CPU_BACKEND_MODE >= 2);
+    if (x.size() != LATENT_CHANNELS * height * width) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "x size(%ld) != 4 x %ld x %ld", x.size(),
+                            height, width);
+        throw std::runtime_error("UNet input size != latent shape");
+    }
+    if (replayEnabled && !CpuBackend::isEnabled()) {
+        return replay(x, timestep, condition);
+    }
+
     cl_int err;
-    cl_event event0_0, event0_1, event0_2;
-    cl_event event1_0, event1_1, event1_3, event1_4, event1_5, event1_6, event1_7, event1_8, event1_9, event1_10, event1_11;
-    cl_event event1_12, event1_13, event1_14, event1_15, event1_16, event1_17, event1_18;
-    cl_event event2_0, event2_1, event2_2;
-    cl_event event3_0, event3_1, event3_2, event3_3, event3_4, event3_5, event3_6, event3_7, event3_8, event3_9, event3_10, event3_11;
-    cl_event event3_12, event3_13, event3_14, event3_15, event3_16, event3_17, event3_18, event3_19, event3_20, event3_21, event3_22;
-    cl_event event3_23, event3_24, event3_25, event3_26, event3_27, event3_28, event3_29, event3_30, event3_31, event3_32, event3_33;
-    cl_event event3_34, event3_35, event3_36, event3_37, event3_38;
-    cl_mem bufferTimeEmbed, bufferEmbedTemp, bufferEmbed, bufferCondition;
-    cl_mem bufferInput, bufferInput_0, bufferInput_1, bufferInput_2, bufferInput_3, bufferInput_4, bufferInput_5, bufferInput_6, bufferInput_7, bufferInput_8, bufferInput_9, bufferInput_10, bufferInput_11;
-    cl_mem buffer_640_32, buffer_1280_16, buffer_1280_8;
-    cl_mem buffer_2560_8, buffer_2560_16, buffer_1920_16, buffer_1280_32, buffer_1920_32, buffer_960_32, buffer_640_64, buffer_960_64, buffer_320_64, buffer_4_64;
+    cl_event event;
+    cl_mem bufferTimeEmbed, bufferInput, bufferCondition, bufferOut;
 
-    /* time_embed layer */
     bufferTimeEmbed = createTimestepEmbedding(timestep);
 
-    bufferEmbedTemp = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                     sizeof(float) * MODEL_CHANNELS * 4,
-                                     nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferEmbed = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                 sizeof(float) * MODEL_CHANNELS * 4,
-                                 nullptr, &err);
-    CHECK_ERROR(err);
-
-    err = time_embed_0->forward(bufferTimeEmbed, bufferEmbedTemp, 0, nullptr, &event0_0);
-    CHECK_ERROR(err);
-
-    err = clSetKernelArg(utilKernel->silu, 0, sizeof(cl_mem), &bufferEmbedTemp);
-    err |= clSetKernelArg(utilKernel->silu, 1, sizeof(cl_mem), &bufferEmbedTemp);
-    CHECK_ERROR(err);
-
-    size_t embedWorkSize[1] = {MODEL_CHANNELS * 4};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->silu, 1, nullptr,
-                                 embedWorkSize, nullptr, 1, &event0_0, &event0_1);
-    CHECK_ERROR(err);
-
-    err = time_embed_2->forward(bufferEmbedTemp, bufferEmbed, 1, &event0_1, &event0_2);
-    CHECK_ERROR(err);
-
-    // timestep=981. max diff: 0.00000476837158203125
-    // util::testBuffer(cmdQueue, bufferEmbed, "unet/time_embed/test/test_time_embed.npy");
-    /* time_embed layer */
-
-    /* input_block layer */
-    /* input_block layer[0] */
-#if UNET_LOAD_MODE == 0
-    initInputBlock0();
-#endif
-    bufferInput_0 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * MODEL_CHANNELS * 64 * 64,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
     bufferInput = util::clCreateBuffer(x, context, cmdQueue, &err);
     CHECK_ERROR(err);
 
-    input_block_0_conv2d->init();
-    err = input_block_0_conv2d->forward(bufferInput, bufferInput_0, 0, nullptr, &event1_0);
-    CHECK_ERROR(err);
-    delete input_block_0_conv2d;
-    input_block_0_conv2d = nullptr;
-
-    // x=seed45.npy. timestep=981. max diff: 0.00000059604644775391
-    // util::testBuffer(cmdQueue, bufferInput_0, "unet/input_block/test/test_input_block_0_conv2d.npy");
-    /* input_block layer[0] */
-
-    /* input_block layer[1] */
-#if UNET_LOAD_MODE == 0
-    initInputBlock1();
-#endif
-    bufferInput_1 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * MODEL_CHANNELS * 64 * 64,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
     bufferCondition = util::clCreateBuffer(condition, context, cmdQueue, &err);
     CHECK_ERROR(err);
 
-    input_block_1_res_block->init();
-    err = input_block_1_res_block->forward(bufferInput_0, bufferEmbed, bufferInput_1,
-                                           1, &event0_2,
-                                           1, &event1_0, &event1_1);
-    CHECK_ERROR(err);
-    delete input_block_1_res_block;
-    input_block_1_res_block = nullptr;
-
-    input_block_1_spatial->init();
-    err = input_block_1_spatial->forward(bufferInput_1, bufferCondition, bufferInput_1,
-                                         1, &event1_1, &event1_3);
-    CHECK_ERROR(err);
-    delete input_block_1_spatial;
-    input_block_1_spatial = nullptr;
-    /* input_block layer[1] */
-
-    // clWaitForEvents(1, &event1_3);
-    // return std::vector<float>();
-
-    /* input_block layer[2] */
-#if UNET_LOAD_MODE == 0
-    initInputBlock2();
-#endif
-    bufferInput_2 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * MODEL_CHANNELS * 64 * 64,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    input_block_2_res_block->init();
-    err = input_block_2_res_block->forward(bufferInput_1, bufferEmbed, bufferInput_2,
-                                           1, &event0_2,
-                                           1, &event1_3, &event1_4);
-    CHECK_ERROR(err);
-    delete input_block_2_res_block;
-    input_block_2_res_block = nullptr;
-
-    // test_input_block_2_res.npy max diff: 0.00001192092895507812
-    // util::testBuffer(cmdQueue, bufferInput_2, "unet/input_block/test/test_input_block_2_res.npy");
-
-    input_block_2_spatial->init();
-    err = input_block_2_spatial->forward(bufferInput_2, bufferCondition, bufferInput_2,
-                                         1, &event1_4, &event1_5);
-    CHECK_ERROR(err);
-    delete input_block_2_spatial;
-    input_block_2_spatial = nullptr;
-
-    // max diff: 0.00001168251037597656
-    // util::testBuffer(cmdQueue, bufferInput_2, "unet/input_block/test/test_input_block_2.npy");
-    /* input_block layer[2] */
-
-    /* input_block layer[3] */
-#if UNET_LOAD_MODE == 0
-    initInputBlock3();
-#endif
-    bufferInput_3 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * MODEL_CHANNELS * 32 * 32,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    input_block_3_conv2d->init();
-    err = input_block_3_conv2d->forward(bufferInput_2, bufferInput_3,
-                                        1, &event1_5, &event1_6);
-    CHECK_ERROR(err);
-    delete input_block_3_conv2d;
-    input_block_3_conv2d = nullptr;
-
-    // max diff: 0.00001525878906250000
-    // util::testBuffer(cmdQueue, bufferInput_3, "unet/input_block/test/test_input_block_3.npy");
-    /* input_block layer[3] */
-
-    /* input_block layer[4] */
-#if UNET_LOAD_MODE == 0
-    initInputBlock4();
-#endif
-    bufferInput_4 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 2 * MODEL_CHANNELS * 32 * 32,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    input_block_4_res_block->init();
-    err = input_block_4_res_block->forward(bufferInput_3, bufferEmbed, bufferInput_4,
-                                           1, &event0_2,
-                                           1, &event1_6, &event1_7);
-    CHECK_ERROR(err);
-    delete input_block_4_res_block;
-    input_block_4_res_block = nullptr;
-
-    // max diff: 0.00001382827758789062
-    // util::testBuffer(cmdQueue, bufferInput_4, "unet/input_block/test/test_input_block_4_res.npy");
+    bufferOut = graph.run({bufferTimeEmbed, bufferInput, bufferCondition},
+                          {nullptr, nullptr, nullptr}, outputId, &event);
 
-    input_block_4_spatial->init();
-    err = input_block_4_spatial->forward(bufferInput_4, bufferCondition, bufferInput_4,
-                                         1, &event1_7, &event1_8);
-    CHECK_ERROR(err);
-    delete input_block_4_spatial;
-    input_block_4_spatial = nullptr;
-
-    // max diff: 0.00002956390380859375
-    // util::testBuffer(cmdQueue, bufferInput_4, "unet/input_block/test/test_input_block_4.npy");
-    /* input_block layer[4] */
-
-    /* input_block layer[5] */
-#if UNET_LOAD_MODE == 0
-    initInputBlock5();
-#endif
-    bufferInput_5 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 2 * MODEL_CHANNELS * 32 * 32,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    input_block_5_res_block->init();
-    err = input_block_5_res_block->forward(bufferInput_4, bufferEmbed, bufferInput_5,
-                                           1, &event0_2,
-                                           1, &event1_8, &event1_9);
-    CHECK_ERROR(err);
-    delete input_block_5_res_block;
-    input_block_5_res_block = nullptr;
-
-    input_block_5_spatial->init();
-    err = input_block_5_spatial->forward(bufferInput_5, bufferCondition, bufferInput_5,
-                                         1, &event1_9, &event1_10);
-    CHECK_ERROR(err);
-    delete input_block_5_spatial;
-    input_block_5_spatial = nullptr;
-
-    // max diff: 0.00013732910156250000
-    // util::testBuffer(cmdQueue, bufferInput_5, "unet/input_block/test/test_input_block_5.npy");
-
-    /* input_block layer[5] */
-
-    /* input_block layer[6] */
-#if UNET_LOAD_MODE == 0
-    initInputBlock6();
-#endif
-    bufferInput_6 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 2 * MODEL_CHANNELS * 16 * 16,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    input_block_6_conv2d->init();
-    err = input_block_6_conv2d->forward(bufferInput_5, bufferInput_6,
-                                        1, &event1_10, &event1_11);
-    CHECK_ERROR(err);
-    delete input_block_6_conv2d;
-    input_block_6_conv2d = nullptr;
-
-    // max diff: 0.00004652142524719238
-    // util::testBuffer(cmdQueue, bufferInput_6, "unet/input_block/test/test_input_block_6.npy");
-    /* input_block layer[6] */
-
-    /* input_block layer[7] */
-#if UNET_LOAD_MODE == 0
-    initInputBlock7();
-#endif
-    bufferInput_7 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 4 * MODEL_CHANNELS * 16 * 16,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    input_block_7_res_block->init();
-    err = input_block_7_res_block->forward(bufferInput_6, bufferEmbed, bufferInput_7,
-                                           1, &event0_2,
-                                           1, &event1_11, &event1_12);
-    CHECK_ERROR(err);
-    delete input_block_7_res_block;
-    input_block_7_res_block = nullptr;
-
-    input_block_7_spatial->init();
-    err = input_block_7_spatial->forward(bufferInput_7, bufferCondition, bufferInput_7,
-                                         1, &event1_12, &event1_13);
-    CHECK_ERROR(err);
-    delete input_block_7_spatial;
-    input_block_7_spatial = nullptr;
-
-    // max diff: 0.00004172325134277344
-    // util::testBuffer(cmdQueue, bufferInput_7, "unet/input_block/test/test_input_block_7.npy");
-    /* input_block layer[7] */
-
-    /* input_block layer[8] */
-#if UNET_LOAD_MODE == 0
-    initInputBlock8();
-#endif
-    bufferInput_8 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 4 * MODEL_CHANNELS * 16 * 16,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    input_block_8_res_block->init();
-    err = input_block_8_res_block->forward(bufferInput_7, bufferEmbed, bufferInput_8,
-                                           1, &event0_2,
-                                           1, &event1_13, &event1_14);
-    CHECK_ERROR(err);
-    delete input_block_8_res_block;
-    input_block_8_res_block = nullptr;
-
-    input_block_8_spatial->init();
-    err = input_block_8_spatial->forward(bufferInput_8, bufferCondition, bufferInput_8,
-                                         1, &event1_14, &event1_15);
-    CHECK_ERROR(err);
-    delete input_block_8_spatial;
-    input_block_8_spatial = nullptr;
-
-    // max diff: 0.00004684925079345703
-    // util::testBuffer(cmdQueue, bufferInput_8, "unet/input_block/test/test_input_block_8.npy");
-    /* input_block layer[8] */
-
-    /* input_block layer[9] */
-#if UNET_LOAD_MODE == 0
-    initInputBlock9();
-#endif
-    bufferInput_9 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 4 * MODEL_CHANNELS * 8 * 8,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    input_block_9_conv2d->init();
-    err = input_block_9_conv2d->forward(bufferInput_8, bufferInput_9,
-                                        1, &event1_15, &event1_16);
-    CHECK_ERROR(err);
-    delete input_block_9_conv2d;
-    input_block_9_conv2d = nullptr;
-    /* input_block layer[9] */
-
-    /* input_block layer[10] */
-#if UNET_LOAD_MODE == 0
-    initInputBlock10();
-#endif
-    bufferInput_10 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * 4 * MODEL_CHANNELS * 8 * 8,
-                                    nullptr, &err);
-    CHECK_ERROR(err);
-
-    input_block_10_res_block->init();
-    err = input_block_10_res_block->forward(bufferInput_9, bufferEmbed, bufferInput_10,
-                                            1, &event0_2,
-                                            1, &event1_16, &event1_17);
-    CHECK_ERROR(err);
-    delete input_block_10_res_block;
-    input_block_10_res_block = nullptr;
-    /* input_block layer[10] */
-
-    /* input_block layer[11] */
-#if UNET_LOAD_MODE == 0
-    initInputBlock11();
-#endif
-    bufferInput_11 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * 4 * MODEL_CHANNELS * 8 * 8,
-                                    nullptr, &err);
-    CHECK_ERROR(err);
-
-    input_block_11_res_block->init();
-    err = input_block_11_res_block->forward(bufferInput_10, bufferEmbed, bufferInput_11,
-                                            1, &event0_2,
-                                            1, &event1_17, &event1_18);
-    CHECK_ERROR(err);
-    delete input_block_11_res_block;
-    input_block_11_res_block = nullptr;
+    // x=seed45.npy. timestep=981.
+    // util::testBuffer(cmdQueue, bufferOut, "unet/out/test/test_out.npy");
 
-    // max diff: 0.00013542175292968750
-    // util::testBuffer(cmdQueue, buffer_1280_8, "unet/input_block/test/test_input_block_11.npy");
-    /* input_block layer[11] */
-    /* input_block layer */
-
-    /* middle_block layer */
-    initMiddleBlock();
-    buffer_1280_8 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 4 * MODEL_CHANNELS * 8 * 8,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    middle_block_0_res_block->init();
-    err = middle_block_0_res_block->forward(bufferInput_11, bufferEmbed, buffer_1280_8,
-                                            1, &event0_2,
-                                            1, &event1_18, &event2_0);
-    CHECK_ERROR(err);
-    delete middle_block_0_res_block;
-    middle_block_0_res_block = nullptr;
-
-    middle_block_1_spatial->init();
-    err = middle_block_1_spatial->forward(buffer_1280_8, bufferCondition, buffer_1280_8,
-                                          1, &event2_0, &event2_1);
-    CHECK_ERROR(err);
-    delete middle_block_1_spatial;
-    middle_block_1_spatial = nullptr;
-
-    middle_block_2_res_block->init();
-    err = middle_block_2_res_block->forward(buffer_1280_8, bufferEmbed, buffer_1280_8,
-                                            1, &event0_2,
-                                            1, &event2_1, &event2_2);
-    CHECK_ERROR(err);
-    delete middle_block_2_res_block;
-    middle_block_2_res_block = nullptr;
-
-    // max diff: 0.00013828277587890625
-    // util::testBuffer(cmdQueue, buffer_1280_8, "unet/middle_block/test/test_middle_block.npy");
-    /* middle_block layer */
-
-    /* output_block layer */
-    /* output_block layer[0] */
-    initOutputBlock0();
-    buffer_2560_8 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 8 * MODEL_CHANNELS * 8 * 8,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    concat_buffer(buffer_1280_8, bufferInput_11, buffer_2560_8,
-                  1, &event2_2, &event3_0);
-
-    output_block_0_res_block->init();
-    err = output_block_0_res_block->forward(buffer_2560_8, bufferEmbed, buffer_1280_8,
-                                            1, &event0_2,
-                                            1, &event3_0, &event3_1);
-    CHECK_ERROR(err);
-    delete output_block_0_res_block;
-    output_block_0_res_block = nullptr;
-    // test_output_block_0.npy max diff: 0.00009822845458984375
-    // util::testBuffer(cmdQueue, buffer_1280_8, "unet/output_block/test/test_output_block_0.npy");
-    /* output_block layer[0] */
-
-    /* output_block layer[1] */
-    initOutputBlock1();
-    concat_buffer(buffer_1280_8, bufferInput_10, buffer_2560_8,
-                  1, &event3_1, &event3_2);
-
-    output_block_1_res_block->init();
-    err = output_block_1_res_block->forward(buffer_2560_8, bufferEmbed, buffer_1280_8,
-                                            1, &event0_2,
-                                            1, &event3_2, &event3_3);
-    CHECK_ERROR(err);
-    delete output_block_1_res_block;
-    output_block_1_res_block = nullptr;
-
-    // test_output_block_1.npy max diff: 0.00010108947753906250
-    // util::testBuffer(cmdQueue, buffer_1280_8, "unet/output_block/test/test_output_block_1.npy");
-    /* output_block layer[1] */
-
-    /* output_block layer[2] */
-    initOutputBlock2();
-    buffer_1280_16 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * 4 * MODEL_CHANNELS * 16 * 16,
-                                    nullptr, &err);
-    CHECK_ERROR(err);
-
-    concat_buffer(buffer_1280_8, bufferInput_9, buffer_2560_8,
-                  1, &event3_3, &event3_4);
-
-    output_block_2_res_block->init();
-    err = output_block_2_res_block->forward(buffer_2560_8, bufferEmbed, buffer_1280_8,
-                                            1, &event0_2,
-                                            1, &event3_4, &event3_5);
-    CHECK_ERROR(err);
-    delete output_block_2_res_block;
-    output_block_2_res_block = nullptr;
-
-    output_block_2_up_sample->init();
-    err = output_block_2_up_sample->forward(buffer_1280_8, buffer_1280_16,
-                                            1, &event3_5, &event3_6);
-    CHECK_ERROR(err);
-    delete output_block_2_up_sample;
-    output_block_2_up_sample = nullptr;
-
-    // test_output_block_2.npy max diff: 0.00007247924804687500
-    // util::testBuffer(cmdQueue, buffer_1280_16, "unet/output_block/test/test_output_block_2.npy");
-    /* output_block layer[2] */
-
-    /* output_block layer[3] */
-    initOutputBlock3();
-    buffer_2560_16 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * 8 * MODEL_CHANNELS * 16 * 16,
-                                    nullptr, &err);
-    CHECK_ERROR(err);
-
-    concat_buffer(buffer_1280_16, bufferInput_8, buffer_2560_16,
-                  1, &event3_6, &event3_7);
-
-    output_block_3_res_block->init();
-    err = output_block_3_res_block->forward(buffer_2560_16, bufferEmbed, buffer_1280_16,
-                                            1, &event0_2,
-                                            1, &event3_7, &event3_8);
-    CHECK_ERROR(err);
-    delete output_block_3_res_block;
-    output_block_3_res_block = nullptr;
-
-    output_block_3_spatial->init();
-    err = output_block_3_spatial->forward(buffer_1280_16, bufferCondition, buffer_1280_16,
-                                          1, &event3_8, &event3_9);
-    CHECK_ERROR(err);
-    delete output_block_3_spatial;
-    output_block_3_spatial = nullptr;
-
-    // test_output_block_3.npy max diff: 0.00009536743164062500
-    // util::testBuffer(cmdQueue, buffer_1280_16, "unet/output_block/test/test_output_block_3.npy");
-    /* output_block layer[3] */
-
-    /* output_block layer[4] */
-    initOutputBlock4();
-
-    concat_buffer(buffer_1280_16, bufferInput_7, buffer_2560_16,
-                  1, &event3_9, &event3_10);
-
-    output_block_4_res_block->init();
-    err = output_block_4_res_block->forward(buffer_2560_16, bufferEmbed, buffer_1280_16,
-                                            1, &event0_2,
-                                            1, &event3_10, &event3_11);
-    CHECK_ERROR(err);
-    delete output_block_4_res_block;
-    output_block_4_res_block = nullptr;
-
-    output_block_4_spatial->init();
-    err = output_block_4_spatial->forward(buffer_1280_16, bufferCondition, buffer_1280_16,
-                                          1, &event3_11, &event3_12);
-    CHECK_ERROR(err);
-    delete output_block_4_spatial;
-    output_block_4_spatial = nullptr;
-    /* output_block layer[4] */
-
-    /* output_block layer[5] */
-    initOutputBlock5();
-
-    buffer_1920_16 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * 6 * MODEL_CHANNELS * 16 * 16,
-                                    nullptr, &err);
-    CHECK_ERROR(err);
-
-    buffer_1280_32 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * 4 * MODEL_CHANNELS * 32 * 32,
-                                    nullptr, &err);
-    CHECK_ERROR(err);
-
-    concat_buffer(buffer_1280_16, bufferInput_6, buffer_1920_16,
-                  1, &event3_12, &event3_13);
-
-    output_block_5_res_block->init();
-    err = output_block_5_res_block->forward(buffer_1920_16, bufferEmbed, buffer_1280_16,
-                                            1, &event0_2,
-                                            1, &event3_13, &event3_14);
-    CHECK_ERROR(err);
-    delete output_block_5_res_block;
-    output_block_5_res_block = nullptr;
-
-    output_block_5_spatial->init();
-    err = output_block_5_spatial->forward(buffer_1280_16, bufferCondition, buffer_1280_16,
-                                          1, &event3_14, &event3_15);
-    CHECK_ERROR(err);
-    delete output_block_5_spatial;
-    output_block_5_spatial = nullptr;
-
-    output_block_5_up_sample->init();
-    err = output_block_5_up_sample->forward(buffer_1280_16, buffer_1280_32,
-                                            1, &event3_15, &event3_16);
-    CHECK_ERROR(err);
-    delete output_block_5_up_sample;
-    output_block_5_up_sample = nullptr;
-    /* output_block layer[5] */
-
-    /* output_block layer[6] */
-    initOutputBlock6();
-    buffer_1920_32 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * 6 * MODEL_CHANNELS * 32 * 32,
-                                    nullptr, &err);
-    CHECK_ERROR(err);
-
-    buffer_640_32 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 2 * MODEL_CHANNELS * 32 * 32,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    concat_buffer(buffer_1280_32, bufferInput_5, buffer_1920_32,
-                  1, &event3_16, &event3_17);
-
-    output_block_6_res_block->init();
-    err = output_block_6_res_block->forward(buffer_1920_32, bufferEmbed, buffer_640_32,
-                                            1, &event0_2,
-                                            1, &event3_17, &event3_18);
-    CHECK_ERROR(err);
-    delete output_block_6_res_block;
-    output_block_6_res_block = nullptr;
-
-    output_block_6_spatial->init();
-    err = output_block_6_spatial->forward(buffer_640_32, bufferCondition, buffer_640_32,
-                                          1, &event3_18, &event3_19);
-    CHECK_ERROR(err);
-    delete output_block_6_spatial;
-    output_block_6_spatial = nullptr;
-    /* output_block layer[6] */
-
-    /* output_block layer[7] */
-    initOutputBlock7();
-
-    concat_buffer(buffer_640_32, bufferInput_4, buffer_1280_32,
-                  1, &event3_19, &event3_20);
-
-    output_block_7_res_block->init();
-    err = output_block_7_res_block->forward(buffer_1280_32, bufferEmbed, buffer_640_32,
-                                            1, &event0_2,
-                                            1, &event3_20, &event3_21);
-    CHECK_ERROR(err);
-    delete output_block_7_res_block;
-    output_block_7_res_block = nullptr;
-
-    output_block_7_spatial->init();
-    err = output_block_7_spatial->forward(buffer_640_32, bufferCondition, buffer_640_32,
-                                          1, &event3_21, &event3_22);
-    CHECK_ERROR(err);
-    delete output_block_7_spatial;
-    output_block_7_spatial = nullptr;
-    /* output_block layer[7] */
-
-    /* output_block layer[8] */
-    initOutputBlock8();
-
-    buffer_960_32 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 3 * MODEL_CHANNELS * 32 * 32,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    buffer_640_64 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 2 * MODEL_CHANNELS * 64 * 64,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    concat_buffer(buffer_640_32, bufferInput_3, buffer_960_32,
-                  1, &event3_22, &event3_23);
-
-    output_block_8_res_block->init();
-    err = output_block_8_res_block->forward(buffer_960_32, bufferEmbed, buffer_640_32,
-                                            1, &event0_2,
-                                            1, &event3_23, &event3_24);
-    CHECK_ERROR(err);
-    delete output_block_8_res_block;
-    output_block_8_res_block = nullptr;
-
-    output_block_8_spatial->init();
-    err = output_block_8_spatial->forward(buffer_640_32, bufferCondition, buffer_640_32,
-                                          1, &event3_24, &event3_25);
-    CHECK_ERROR(err);
-    delete output_block_8_spatial;
-    output_block_8_spatial = nullptr;
-
-    output_block_8_up_sample->init();
-    err = output_block_8_up_sample->forward(buffer_640_32, buffer_640_64,
-                                            1, &event3_25, &event3_26);
-    CHECK_ERROR(err);
-    delete output_block_8_up_sample;
-    output_block_8_up_sample = nullptr;
-    /* output_block layer[8] */
-
-    /* output_block layer[9] */
-    initOutputBlock9();
-
-    buffer_960_64 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * 3 * MODEL_CHANNELS * 64 * 64,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    buffer_320_64 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * MODEL_CHANNELS * 64 * 64,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    concat_buffer(buffer_640_64, bufferInput_2, buffer_960_64,
-                  1, &event3_26, &event3_27);
-
-    output_block_9_res_block->init();
-    err = output_block_9_res_block->forward(buffer_960_64, bufferEmbed, buffer_320_64,
-                                            1, &event0_2,
-                                            1, &event3_27, &event3_28);
-    CHECK_ERROR(err);
-    delete output_block_9_res_block;
-    output_block_9_res_block = nullptr;
-
-    output_block_9_spatial->init();
-    err = output_block_9_spatial->forward(buffer_320_64, bufferCondition, buffer_320_64,
-                                          1, &event3_28, &event3_29);
-    CHECK_ERROR(err);
-    delete output_block_9_spatial;
-    output_block_9_spatial = nullptr;
-    /* output_block layer[9] */
-
-    /* output_block layer[10] */
-    initOutputBlock10();
-
-    concat_buffer(buffer_320_64, bufferInput_1, buffer_640_64,
-                  1, &event3_29, &event3_30);
-
-    output_block_10_res_block->init();
-    err = output_block_10_res_block->forward(buffer_640_64, bufferEmbed, buffer_320_64,
-                                             1, &event0_2,
-                                             1, &event3_30, &event3_31);
-    CHECK_ERROR(err);
-    delete output_block_10_res_block;
-    output_block_10_res_block = nullptr;
-
-    output_block_10_spatial->init();
-    err = output_block_10_spatial->forward(buffer_320_64, bufferCondition, buffer_320_64,
-                                           1, &event3_31, &event3_32);
-    CHECK_ERROR(err);
-    delete output_block_10_spatial;
-    output_block_10_spatial = nullptr;
-    /* output_block layer[10] */
-
-    /* output_block layer[11] */
-    initOutputBlock11();
-
-    concat_buffer(buffer_320_64, bufferInput_0, buffer_640_64,
-                  1, &event3_32, &event3_33);
-
-    output_block_11_res_block->init();
-    err = output_block_11_res_block->forward(buffer_640_64, bufferEmbed, buffer_320_64,
-                                             1, &event0_2,
-                                             1, &event3_33, &event3_34);
-    CHECK_ERROR(err);
-    delete output_block_11_res_block;
-    output_block_11_res_block = nullptr;
-
-    output_block_11_spatial->init();
-    err = output_block_11_spatial->forward(buffer_320_64, bufferCondition, buffer_320_64,
-                                           1, &event3_34, &event3_35);
+    /* result */
+    std::vector<float> result(LATENT_CHANNELS * height * width);
+    err = clEnqueueReadBuffer(cmdQueue, bufferOut, CL_TRUE, 0,
+                              sizeof(float) * result.size(),
+                              result.data(), 1, &event, nullptr);
     CHECK_ERROR(err);
-    delete output_block_11_spatial;
-    output_block_11_spatial = nullptr;
+    /* result */
 
-    // test_output_block_11.npy max diff: 0.00001716613769531250
-    // util::testBuffer(cmdQueue, buffer_320_64, "unet/output_block/test/test_output_block_11.npy");
-    /* output_block layer[11] */
-    /* output_block layer */
+    clFinish(cmdQueue);
 
-    /* out */
-    initOut();
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "Finished");
 
-    buffer_4_64 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                 sizeof(float) * 4 * 64 * 64,
-                                 nullptr, &err);
-    CHECK_ERROR(err);
+    clReleaseEvent(event);
+    clReleaseMemObject(bufferTimeEmbed);
+    clReleaseMemObject(bufferInput);
+    clReleaseMemObject(bufferCondition);
+    clReleaseMemObject(bufferOut);
 
-    out_group_norm->init();
-    err = out_group_norm->forward(buffer_320_64, buffer_320_64,
-                                  1, &event3_35, &event3_36);
-    CHECK_ERROR(err);
-    delete out_group_norm;
-    out_group_norm = nullptr;
+    return result;
+}
 
-    err = clSetKernelArg(utilKernel->silu, 0, sizeof(cl_mem), &buffer_320_64);
-    err |= clSetKernelArg(utilKernel->silu, 1, sizeof(cl_mem), &buffer_320_64);
-    CHECK_ERROR(err);
+/*
+ * step 마다 바뀌는 입력 (timestep embedding, x) 만 쓰고 기록한 launch 를 replay.
+ * 첫 호출은 모든 layer 를 load 한 후 graph 를 실행하면서 기록 (기록할 수 없으면 이후 일반 forward).
+ */
+std::vector<float> UNetModel::replay(const std::vector<float> &x, long timestep,
+                                     const std::vector<float> &condition) {
+    cl_int err;
+    cl_event event;
+    cl_event events[3] = {nullptr, nullptr, nullptr};
+    std::vector<float> embedding(MODEL_CHANNELS);
+    fillTimestepEmbedding(timestep, embedding.data());
+
+    if (replayTimeEmbed == nullptr) {
+        replayTimeEmbed = clCreateBuffer(context, CL_MEM_READ_ONLY, sizeof(float) * MODEL_CHANNELS,
+                                         nullptr, &err);
+        CHECK_ERROR(err);
+        replayInput = clCreateBuffer(context, CL_MEM_READ_ONLY, sizeof(float) * x.size(), nullptr,
+                                     &err);
+        CHECK_ERROR(err);
+        replayCondition = clCreateBuffer(context, CL_MEM_READ_ONLY,
+                                         sizeof(float) * condition.size(), nullptr, &err);
+        CHECK_ERROR(err);
+    }
 
-    size_t outSiluSize[1] = {MODEL_CHANNELS * 64 * 64};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->silu, 1, nullptr,
-                                 outSiluSize, nullptr, 1, &event3_36, &event3_37);
+    err = clEnqueueWriteBuffer(cmdQueue, replayTimeEmbed, CL_FALSE, 0,
+                               sizeof(float) * embedding.size(), embedding.data(), 0, nullptr,
+                               &events[0]);
     CHECK_ERROR(err);
-
-    out_conv2d->init();
-    err = out_conv2d->forward(buffer_320_64, buffer_4_64,
-                              1, &event3_37, &event3_38);
+    err = clEnqueueWriteBuffer(cmdQueue, replayInput, CL_FALSE, 0, sizeof(float) * x.size(),
+                               x.data(), 0, nullptr, &events[1]);
     CHECK_ERROR(err);
-    delete out_conv2d;
-    out_conv2d = nullptr;
+    if (condition != replayConditionData) {
+        replayConditionData = condition;
+        err = clEnqueueWriteBuffer(cmdQueue, replayCondition, CL_FALSE, 0,
+                                   sizeof(float) * condition.size(), replayConditionData.data(),
+                                   0, nullptr, &events[2]);
+        CHECK_ERROR(err);
+    }
 
-    // util::testBuffer(cmdQueue, buffer_4_64, "unet/out/test/test_out.npy");
-    /* out */
+    bool recorded = recorder != nullptr;
+    if (!recorded) {
+        graph.load(0, graph.size(), true);
+        recorder = std::make_unique<CommandRecorder>(context, cmdQueue, deviceId,
+                                                     UNET_REPLAY_MODE == 2);
+        recorder->begin({events[0], events[1], events[2]});
+        try {
+            replayOut = graph.run({replayTimeEmbed, replayInput, replayCondition},
+                                  {events[0], events[1], events[2]}, outputId, &event);
+        } catch (...) {
+            recorder->end();
+            throw;
+        }
+        recorder->end();
+    } else {
+        err = recorder->replay({events[0], events[1], events[2]}, &event);
+        CHECK_ERROR(err);
+    }
 
-    /* result */
-    std::vector<float> result(4 * 64 * 64);
-    err = clEnqueueReadBuffer(cmdQueue, buffer_4_64, CL_TRUE, 0,
-                              sizeof(float) * result.size(),
-                              result.data(), 1, &event3_38, nullptr);
+    std::vector<float> result(LATENT_CHANNELS * height * width);
+    err = clEnqueueReadBuffer(cmdQueue, replayOut, CL_TRUE, 0, sizeof(float) * result.size(),
+                              result.data(), 1, &event, nullptr);
     CHECK_ERROR(err);
-    /* result */
-
-    clFinish(cmdQueue);
 
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "Finished");
-
-    clReleaseEvent(event0_0);
-    clReleaseEvent(event0_1);
-    clReleaseEvent(event0_2);
-    clReleaseEvent(event1_0);
-    clReleaseEvent(event1_1);
-    clReleaseEvent(event1_3);
-    clReleaseEvent(event1_4);
-    clReleaseEvent(event1_5);
-    clReleaseEvent(event1_6);
-    clReleaseEvent(event1_7);
-    clReleaseEvent(event1_8);
-    clReleaseEvent(event1_9);
-    clReleaseEvent(event1_10);
-    clReleaseEvent(event1_11);
-    clReleaseEvent(event1_12);
-    clReleaseEvent(event1_13);
-    clReleaseEvent(event1_14);
-    clReleaseEvent(event1_15);
-    clReleaseEvent(event1_16);
-    clReleaseEvent(event1_17);
-    clReleaseEvent(event1_18);
-    clReleaseEvent(event2_0);
-    clReleaseEvent(event2_1);
-    clReleaseEvent(event2_2);
-    clReleaseEvent(event3_0);
-    clReleaseEvent(event3_1);
-    clReleaseEvent(event3_2);
-    clReleaseEvent(event3_3);
-    clReleaseEvent(event3_4);
-    clReleaseEvent(event3_5);
-    clReleaseEvent(event3_6);
-    clReleaseEvent(event3_7);
-    clReleaseEvent(event3_8);
-    clReleaseEvent(event3_9);
-    clReleaseEvent(event3_10);
-    clReleaseEvent(event3_11);
-    clReleaseEvent(event3_12);
-    clReleaseEvent(event3_13);
-    clReleaseEvent(event3_14);
-    clReleaseEvent(event3_15);
-    clReleaseEvent(event3_16);
-    clReleaseEvent(event3_17);
-    clReleaseEvent(event3_18);
-    clReleaseEvent(event3_19);
-    clReleaseEvent(event3_20);
-    clReleaseEvent(event3_21);
-    clReleaseEvent(event3_22);
-    clReleaseEvent(event3_23);
-    clReleaseEvent(event3_24);
-    clReleaseEvent(event3_25);
-    clReleaseEvent(event3_26);
-    clReleaseEvent(event3_27);
-    clReleaseEvent(event3_28);
-    clReleaseEvent(event3_29);
-    clReleaseEvent(event3_30);
-    clReleaseEvent(event3_31);
-    clReleaseEvent(event3_32);
-    clReleaseEvent(event3_33);
-    clReleaseEvent(event3_34);
-    clReleaseEvent(event3_35);
-    clReleaseEvent(event3_36);
-    clReleaseEvent(event3_37);
-    clReleaseEvent(event3_38);
-    clReleaseMemObject(bufferTimeEmbed);
-    clReleaseMemObject(bufferEmbedTemp);
-    clReleaseMemObject(bufferEmbed);
-    clReleaseMemObject(bufferInput);
-    clReleaseMemObject(buffer_320_64);
-    clReleaseMemObject(bufferCondition);
-    clReleaseMemObject(buffer_640_32);
-    clReleaseMemObject(buffer_1280_16);
-    clReleaseMemObject(buffer_1280_8);
-    clReleaseMemObject(bufferInput_0);
-    clReleaseMemObject(bufferInput_1);
-    clReleaseMemObject(bufferInput_2);
-    clReleaseMemObject(bufferInput_3);
-    clReleaseMemObject(bufferInput_4);
-    clReleaseMemObject(bufferInput_5);
-    clReleaseMemObject(bufferInput_6);
-    clReleaseMemObject(bufferInput_7);
-    clReleaseMemObject(bufferInput_8);
-    clReleaseMemObject(bufferInput_9);
-    clReleaseMemObject(bufferInput_10);
-    clReleaseMemObject(bufferInput_11);
-    clReleaseMemObject(buffer_2560_8);
-    clReleaseMemObject(buffer_2560_16);
-    clReleaseMemObject(buffer_1920_16);
-    clReleaseMemObject(buffer_1280_32);
-    clReleaseMemObject(buffer_1920_32);
-    clReleaseMemObject(buffer_960_32);
-    clReleaseMemObject(buffer_640_64);
-    clReleaseMemObject(buffer_960_64);
-    clReleaseMemObject(buffer_4_64);
+    clReleaseEvent(event);
+    for (auto e: events) {
+        if (e != nullptr) {
+            clReleaseEvent(e);
+        }
+    }
 
+    if (!recorded) {
+        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "replay: ready(%d) commands(%ld)",
+                            recorder->isReady(), recorder->size());
+        if (!recorder->isReady()) {
+            /* layer 는 resident 로 남기고 이후 일반 forward */
+            replayEnabled = false;
+            recorder.reset();
+            replayOut = nullptr;
+        }
+    }
     return result;
 }
 
+void UNetModel::fillTimestepEmbedding(long timestep, float *data) {
+    float max_period = 10000.0f;
+    int half = MODEL_CHANNELS / 2;
+    for (int i = 0; i < half; i++) {
+        auto freq = exp((-log(max_period)) * static_cast<float>(i) / static_cast<float>(half));
+        auto arg = static_cast<float>(timestep) * freq;
+        data[i] = cos(arg);
+        data[i + half] = sin(arg);
+    }
+}
+
 /*
  * @param timestep: long. originally [B]
  * @return [B, MODEL_CHANNELS(320)]
  */
 cl_mem UNetModel::createTimestepEmbedding(long timestep) {
-    float max_period = 10000.0f;
-    int half = MODEL_CHANNELS / 2;
     cl_int err;
     auto bufferTimeEmbed = clCreateBuffer(context, CL_MEM_ALLOC_HOST_PTR,
                                      sizeof(float) * MODEL_CHANNELS,
@@ -1946,118 +356,33 @@ cl_mem UNetModel::createTimestepEmbedding(long timestep) {
                                             &err);
     CHECK_ERROR(err)
 
-    for (int i = 0; i < half; i++) {
-        auto freq = exp((-log(max_period)) * static_cast<float>(i) / static_cast<float>(half));
-        auto arg = static_cast<float>(timestep) * freq;
-        static_cast<float *>(dataTimeEmbed)[i] = cos(arg);
-        static_cast<float *>(dataTimeEmbed)[i + half] = sin(arg);
-    }
+    fillTimestepEmbedding(timestep, static_cast<float *>(dataTimeEmbed));
 
     clEnqueueUnmapMemObject(cmdQueue, bufferTimeEmbed, dataTimeEmbed, 0, nullptr, nullptr);
     return bufferTimeEmbed;
 }
 
-void
-UNetModel::concat_buffer(
-        cl_mem input1, cl_mem input2, cl_mem output, cl_uint num_events_in_list,
-        const cl_event *event_wait_list, cl_event *event
-) {
-    cl_int err;
-    cl_event event0;
-
-    size_t input1_bytes, input2_bytes, output_bytes;
-    err = clGetMemObjectInfo(input1, CL_MEM_SIZE, sizeof(size_t), &input1_bytes, nullptr);
-    CHECK_ERROR(err);
-    err = clGetMemObjectInfo(input2, CL_MEM_SIZE, sizeof(size_t), &input2_bytes, nullptr);
-    CHECK_ERROR(err);
-    err = clGetMemObjectInfo(output, CL_MEM_SIZE, sizeof(size_t), &output_bytes, nullptr);
-    CHECK_ERROR(err);
-
-    if (input1_bytes + input2_bytes != output_bytes) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "concat_buffer: input1_size(%ld) + input2_size(%ld) != output_size(%ld)",
-                            input1_bytes, input2_bytes, output_bytes);
-        throw std::runtime_error("concat_buffer: input1_size + input2_size != output_size");
-    }
-
-    err = clEnqueueCopyBuffer(cmdQueue, input1, output, 0, 0, input1_bytes,
-                              num_events_in_list, event_wait_list, &event0);
-    CHECK_ERROR(err);
-
-    err = clEnqueueCopyBuffer(cmdQueue, input2, output, 0, input1_bytes, input2_bytes,
-                              1, &event0, event);
-    CHECK_ERROR(err);
-}
-
 void
 UNetModel::test(const std::vector<float> &x, long timestep, const std::vector<float> &condition) {
     cl_int err;
-    cl_event event[4];
-    cl_mem bufferTimeEmbed, bufferEmbedTemp, bufferEmbed, bufferCondition, bufferInput;
-    cl_mem buffer_320_64;
+    cl_event event;
+    cl_mem bufferTimeEmbed, bufferInput, bufferCondition, bufferOut;
 
     bufferTimeEmbed = createTimestepEmbedding(timestep);
 
-    bufferEmbed = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                 sizeof(float) * MODEL_CHANNELS * 4,
-                                 nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferCondition = clCreateBuffer(context, CL_MEM_READ_ONLY,
-                                     sizeof(float) * condition.size(),
-                                     nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferInput = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                 sizeof(float) * x.size(),
-                                 nullptr, &err);
-    CHECK_ERROR(err);
-
-    err = clEnqueueWriteBuffer(cmdQueue, bufferCondition, CL_TRUE, 0,
-                               sizeof(float) * condition.size(),
-                               condition.data(), 0, nullptr, nullptr);
-    CHECK_ERROR(err);
-
-    err = clEnqueueWriteBuffer(cmdQueue, bufferInput, CL_TRUE, 0,
-                               sizeof(float) * x.size(),
-                               x.data(), 0, nullptr, nullptr);
-    CHECK_ERROR(err);
-
-    bufferEmbedTemp = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                     sizeof(float) * MODEL_CHANNELS * 4,
-                                     nullptr, &err);
-    CHECK_ERROR(err);
-
-    err = time_embed_0->forward(bufferTimeEmbed, bufferEmbedTemp, 0, nullptr, &event[0]);
-    CHECK_ERROR(err);
-
-    err = clSetKernelArg(utilKernel->silu, 0, sizeof(cl_mem), &bufferEmbedTemp);
-    err |= clSetKernelArg(utilKernel->silu, 1, sizeof(cl_mem), &bufferEmbedTemp);
-    CHECK_ERROR(err);
-
-    size_t embedWorkSize[1] = {MODEL_CHANNELS * 4};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->silu, 1, nullptr,
-                                 embedWorkSize, nullptr, 1, &event[0], &event[1]);
+    bufferInput = util::clCreateBuffer(x, context, cmdQueue, &err);
     CHECK_ERROR(err);
 
-    err = time_embed_2->forward(bufferEmbedTemp, bufferEmbed, 1, &event[1], &event[2]);
+    bufferCondition = util::clCreateBuffer(condition, context, cmdQueue, &err);
     CHECK_ERROR(err);
 
     /* test section */
-    buffer_320_64 = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * MODEL_CHANNELS * 64 * 64,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    initInputBlock0();
-    input_block_0_conv2d->init();
-    err = input_block_0_conv2d->forward(bufferInput, buffer_320_64,
-                                        1, &event[2], &event[3]);
-    CHECK_ERROR(err);
+    bufferOut = graph.run({bufferTimeEmbed, bufferInput, bufferCondition},
+                          {nullptr, nullptr, nullptr}, inputBlockIds[0], &event);
+    clWaitForEvents(1, &event);
 
-    util::testBuffer(cmdQueue, buffer_320_64,
+    util::testBuffer(cmdQueue, bufferOut,
                      "unet/input_block/test/test_input_block_0_conv2d.npy");
-
     /* test section */
 
     // test_output_block_0 max diff: 0.00002098083496093750
@@ -2073,13 +398,9 @@ UNetModel::test(const std::vector<float> &x, long timestep, const std::vector<fl
     // test_output_block_10.npy max diff: 0.00000619888305664062
     // test_output_block_11.npy max diff: 0.00001430511474609375
     // test_out.npy max diff: 0.00000190734863281250
-    for (auto &e: event) {
-        clReleaseEvent(e);
-    }
+    clReleaseEvent(event);
     clReleaseMemObject(bufferTimeEmbed);
-    clReleaseMemObject(bufferEmbedTemp);
-    clReleaseMemObject(bufferEmbed);
     clReleaseMemObject(bufferInput);
     clReleaseMemObject(bufferCondition);
-    clReleaseMemObject(buffer_320_64);
+    clReleaseMemObject(bufferOut);
 }
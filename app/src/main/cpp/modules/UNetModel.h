@@ -5,21 +5,11 @@
 #ifndef MY_OPENCL_UNETMODEL_H
 #define MY_OPENCL_UNETMODEL_H
 
+#include <memory>
 #include <vector>
 #include <android/asset_manager_jni.h>
-#include "nn/Linear.h"
-#include "nn/Conv2D.h"
-#include "nn/ResBlock.h"
-#include "nn/SpatialTransformer.h"
-#include "nn/UpSample.h"
-#include "kernel/unit/LayerNormKernel.h"
-#include "kernel/unit/LinearKernel.h"
-#include "kernel/unit/UtilKernel.h"
-#include "kernel/unit/ConvKernel.h"
-#include "kernel/unit/CrossAttentionKernel.h"
-#include "kernel/unit/GEGLUKernel.h"
-#include "kernel/unit/GroupNormKernel.h"
-#include "kernel/unit/UpSampleKernel.h"
+#include "ModelGraph.h"
+#include "CommandRecorder.h"
 
 #define CL_TARGET_OPENCL_VERSION 200
 
@@ -27,8 +17,9 @@
 
 class UNetModel {
 public:
+    /* `height`, `width`: latent 크기 (image / 8, 8 의 배수) */
     UNetModel(AAssetManager *assetManager, cl_context context, cl_command_queue cmdQueue,
-              cl_device_id deviceId);
+              cl_device_id deviceId, size_t height = 64, size_t width = 64);
 
     ~UNetModel();
 
@@ -39,130 +30,43 @@ public:
     test(const std::vector<float> &x, long timestep, const std::vector<float> &condition);
 private:
     cl_mem createTimestepEmbedding(long timestep);
-    void concat_buffer(cl_mem input1, cl_mem input2, cl_mem output,
-                         cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event);
-
-    void initInputBlock0();
-    void initInputBlock1();
-    void initInputBlock2();
-    void initInputBlock3();
-    void initInputBlock4();
-    void initInputBlock5();
-    void initInputBlock6();
-    void initInputBlock7();
-    void initInputBlock8();
-    void initInputBlock9();
-    void initInputBlock10();
-    void initInputBlock11();
-
-    void initMiddleBlock();
-
-    void initOutputBlock0();
-    void initOutputBlock1();
-    void initOutputBlock2();
-    void initOutputBlock3();
-    void initOutputBlock4();
-    void initOutputBlock5();
-    void initOutputBlock6();
-    void initOutputBlock7();
-    void initOutputBlock8();
-    void initOutputBlock9();
-    void initOutputBlock10();
-    void initOutputBlock11();
-
-    void initOut();
+
+    static void fillTimestepEmbedding(long timestep, float *data);
+
+    /* UNET_REPLAY_MODE: 첫 호출을 기록하고 이후는 입력만 새로 써서 replay */
+    std::vector<float>
+    replay(const std::vector<float> &x, long timestep, const std::vector<float> &condition);
+
+    /* block table (UNetModel.cpp) 을 graph 로 */
+    void build();
 
     cl_context context;
     cl_command_queue cmdQueue;
     cl_device_id deviceId;
     AAssetManager *assetManager;
 
-    Linear *time_embed_0;
-    Linear *time_embed_2;
-
-    Conv2D *input_block_0_conv2d;
-
-    ResBlock *input_block_1_res_block;
-    SpatialTransformer *input_block_1_spatial;
-
-    ResBlock *input_block_2_res_block;
-    SpatialTransformer *input_block_2_spatial;
-
-    Conv2D *input_block_3_conv2d;
-
-    ResBlock *input_block_4_res_block;
-    SpatialTransformer *input_block_4_spatial;
-
-    ResBlock *input_block_5_res_block;
-    SpatialTransformer *input_block_5_spatial;
-
-    Conv2D *input_block_6_conv2d;
-
-    ResBlock *input_block_7_res_block;
-    SpatialTransformer *input_block_7_spatial;
-
-    ResBlock *input_block_8_res_block;
-    SpatialTransformer *input_block_8_spatial;
-
-    Conv2D *input_block_9_conv2d;
-
-    ResBlock *input_block_10_res_block;
-
-    ResBlock *input_block_11_res_block;
-
-    ResBlock *middle_block_0_res_block;
-
-    SpatialTransformer *middle_block_1_spatial;
-
-    ResBlock *middle_block_2_res_block;
-
-    ResBlock *output_block_0_res_block;
-
-    ResBlock *output_block_1_res_block;
-
-    ResBlock *output_block_2_res_block;
-    UpSample *output_block_2_up_sample;
-
-    ResBlock *output_block_3_res_block;
-    SpatialTransformer *output_block_3_spatial;
-
-    ResBlock *output_block_4_res_block;
-    SpatialTransformer *output_block_4_spatial;
-
-    ResBlock *output_block_5_res_block;
-    SpatialTransformer *output_block_5_spatial;
-    UpSample *output_block_5_up_sample;
-
-    ResBlock *output_block_6_res_block;
-    SpatialTransformer *output_block_6_spatial;
-
-    ResBlock *output_block_7_res_block;
-    SpatialTransformer *output_block_7_spatial;
-
-    ResBlock *output_block_8_res_block;
-    SpatialTransformer *output_block_8_spatial;
-    UpSample *output_block_8_up_sample;
-
-    ResBlock *output_block_9_res_block;
-    SpatialTransformer *output_block_9_spatial;
+    size_t height;
+    size_t width;
 
-    ResBlock *output_block_10_res_block;
-    SpatialTransformer *output_block_10_spatial;
+    ModelGraph graph;
 
-    ResBlock *output_block_11_res_block;
-    SpatialTransformer *output_block_11_spatial;
+    /* graph input */
+    int timestepId;
+    int inputId;
+    int conditionId;
 
-    GroupNorm *out_group_norm;
-    Conv2D *out_conv2d;
+    /* input_blocks 출력 (output_blocks 의 skip) */
+    std::vector<int> inputBlockIds;
+    int outputId;
 
-    std::shared_ptr<LayerNormKernel> layerNormKernel;
-    std::shared_ptr<LinearKernel> linearKernel;
-    std::shared_ptr<UtilKernel> utilKernel;
-    std::shared_ptr<ConvKernel> convKernel;
-    std::shared_ptr<CrossAttentionKernel> crossAttentionKernel;
-    std::shared_ptr<GEGLUKernel> gegluKernel;
-    std::shared_ptr<GroupNormKernel> groupNormKernel;
-    std::shared_ptr<UpSampleKernel> upSampleKernel;
+    std::unique_ptr<CommandRecorder> recorder;
+    bool replayEnabled;
+    /* replay 입력 (기록과 같은 buffer), 출력은 recorder 소유 */
+    cl_mem replayTimeEmbed = nullptr;
+    cl_mem replayInput = nullptr;
+    cl_mem replayCondition = nullptr;
+    cl_mem replayOut = nullptr;
+    std::vector<float> replayConditionData;
 };
 
 
@@ -0,0 +1,123 @@
+//
+// Created by 구현우 on 2024/07/14.
+//
+
+#include "CpuBackend.h"
+
+#include <android/log.h>
+#include <stdexcept>
+
+#define LOG_TAG "CPU_BACKEND"
+
+#define CHECK_ERROR(err) \
+    if (err != CL_SUCCESS) { \
+      __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "[%s:%d] OpenCL error %d\n", __FILE__, __LINE__, err); \
+      return err; \
+    }
+
+#define CHECK_ERROR_THROW(err) \
+    if (err != CL_SUCCESS) { \
+      __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "[%s:%d] OpenCL error %d\n", __FILE__, __LINE__, err); \
+      throw std::runtime_error("OpenCL error."); \
+    }
+
+static thread_local bool enabled = false;
+
+CpuBackend::Scope::Scope(bool _enabled) : previous(enabled) {
+    enabled = _enabled;
+}
+
+CpuBackend::Scope::~Scope() {
+    enabled = previous;
+}
+
+CpuBackend::Mapping::Mapping(cl_command_queue cmdQueue, cl_uint num_events_in_list,
+                             const cl_event *event_wait_list) : cmdQueue(cmdQueue) {
+    if (num_events_in_list > 0) {
+        cl_int err = clWaitForEvents(num_events_in_list, event_wait_list);
+        CHECK_ERROR_THROW(err);
+    }
+}
+
+/* unmap 전에 error 로 return 한 경우 */
+CpuBackend::Mapping::~Mapping() {
+    for (auto &buffer: buffers) {
+        clEnqueueUnmapMemObject(cmdQueue, buffer.first, buffer.second, 0, nullptr, nullptr);
+    }
+}
+
+float *CpuBackend::Mapping::map(cl_mem buffer, cl_int *err) {
+    return map(buffer, CL_MAP_READ | CL_MAP_WRITE, err);
+}
+
+const float *CpuBackend::Mapping::mapRead(cl_mem buffer, cl_int *err) {
+    return map(buffer, CL_MAP_READ, err);
+}
+
+float *CpuBackend::Mapping::map(cl_mem buffer, cl_map_flags flags, cl_int *err) {
+    for (auto &mapped: buffers) {
+        if (mapped.first == buffer) {
+            *err = CL_SUCCESS;
+            return static_cast<float *>(mapped.second);
+        }
+    }
+
+    size_t size;
+    *err = clGetMemObjectInfo(buffer, CL_MEM_SIZE, sizeof(size_t), &size, nullptr);
+    if (*err != CL_SUCCESS) {
+        return nullptr;
+    }
+    auto ptr = clEnqueueMapBuffer(cmdQueue, buffer, CL_TRUE, flags, 0, size, 0, nullptr,
+                                  nullptr, err);
+    if (*err != CL_SUCCESS) {
+        return nullptr;
+    }
+    buffers.emplace_back(buffer, ptr);
+    return static_cast<float *>(ptr);
+}
+
+cl_int CpuBackend::Mapping::unmap(cl_event *event) {
+    cl_int err;
+    std::vector<cl_event> events;
+    for (auto &buffer: buffers) {
+        cl_event unmapEvent;
+        err = clEnqueueUnmapMemObject(cmdQueue, buffer.first, buffer.second, 0, nullptr,
+                                      &unmapEvent);
+        if (err != CL_SUCCESS) {
+            buffers.erase(buffers.begin(), buffers.begin() + events.size());
+            for (auto e: events) {
+                clReleaseEvent(e);
+            }
+            CHECK_ERROR(err);
+        }
+        events.push_back(unmapEvent);
+    }
+    buffers.clear();
+
+    err = clEnqueueMarkerWithWaitList(cmdQueue, events.size(),
+                                      events.empty() ? nullptr : events.data(), event);
+    for (auto e: events) {
+        clReleaseEvent(e);
+    }
+    CHECK_ERROR(err);
+    return CL_SUCCESS;
+}
+
+CpuBackend::CpuBackend() {
+    auto cpus = ThreadPool::getBigCores();
+    auto numThreads = cpus.empty() ? std::thread::hardware_concurrency() : cpus.size();
+    threadPool = std::make_unique<ThreadPool>(numThreads > 0 ? numThreads : 1, cpus);
+}
+
+CpuBackend &CpuBackend::getInstance() {
+    static CpuBackend instance;
+    return instance;
+}
+
+bool CpuBackend::isEnabled() {
+    return enabled;
+}
+
+ThreadPool &CpuBackend::getThreadPool() {
+    return *threadPool;
+}
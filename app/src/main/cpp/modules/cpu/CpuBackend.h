@@ -0,0 +1,78 @@
+//
+// Created by 구현우 on 2024/07/14.
+//
+
+#ifndef MY_OPENCL_CPUBACKEND_H
+#define MY_OPENCL_CPUBACKEND_H
+
+#define CL_TARGET_OPENCL_VERSION 200
+
+#include "CL/opencl.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+
+/*
+ * nn layer 의 CPU backend (CPU_BACKEND_MODE).
+ * tensor 는 그대로 cl_mem 이고, Scope 가 켜진 thread 에서 layer forward 는
+ * buffer 를 host 에 map 해서 cpu:: kernel (CpuKernel.h) 로 계산한 후 unmap.
+ * unmap 완료 event 를 output event 로 돌려주므로 OpenCL kernel 과 event chain 으로 섞어 쓸 수 있음.
+ */
+class CpuBackend {
+public:
+    /* 현재 thread 의 CPU backend 사용 여부, 소멸 시 이전 값으로 복구 */
+    class Scope {
+    public:
+        explicit Scope(bool enabled);
+
+        ~Scope();
+
+    private:
+        bool previous;
+    };
+
+    /*
+     * `event_wait_list` 를 기다린 후 buffer 를 blocking map.
+     * 같은 buffer 는 한 번만 map 되므로 input == output 이면 output 을 먼저 map.
+     * unmap 은 소멸 전에 호출.
+     */
+    class Mapping {
+    public:
+        Mapping(cl_command_queue cmdQueue, cl_uint num_events_in_list,
+                const cl_event *event_wait_list);
+
+        ~Mapping();
+
+        /* read / write */
+        float *map(cl_mem buffer, cl_int *err);
+
+        /* read only (weight) */
+        const float *mapRead(cl_mem buffer, cl_int *err);
+
+        /* 모든 buffer 를 unmap, 완료 event 를 `event` 로 */
+        cl_int unmap(cl_event *event);
+
+    private:
+        float *map(cl_mem buffer, cl_map_flags flags, cl_int *err);
+
+        cl_command_queue cmdQueue;
+        std::vector<std::pair<cl_mem, void *>> buffers;
+    };
+
+    static CpuBackend &getInstance();
+
+    static bool isEnabled();
+
+    ThreadPool &getThreadPool();
+
+private:
+    CpuBackend();
+
+    std::unique_ptr<ThreadPool> threadPool;
+};
+
+
+#endif //MY_OPENCL_CPUBACKEND_H
@@ -0,0 +1,434 @@
+//
+// Created by 구현우 on 2024/07/14.
+//
+
+#include "CpuKernel.h"
+#include "CpuBackend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define USE_AVX2_DISPATCH
+#endif
+
+/* micro kernel tile */
+#define MR 8
+#define NR 8
+
+/* cache block. packed A (MC x KC) : L1/L2, packed B (KC x NC) : L2/L3 */
+#define MC 64
+#define KC 256
+#define NC 2048
+
+/* gemm task 당 column 수 (M 이 작을 때도 thread 를 채우기 위함) */
+#define NB 64
+
+/* conv2d im2col buffer (float) */
+#define COL_BUFFER_SIZE (1 << 22)
+
+/* attention task 당 query row 수 */
+#define ATTENTION_ROWS 16
+
+static void parallelFor(size_t n, const std::function<void(size_t)> &fn) {
+    CpuBackend::getInstance().getThreadPool().parallelFor(n, fn);
+}
+
+/* [0, size) 를 `grain` 단위로 나눠 fn(begin, end) */
+static void parallelRange(size_t size, size_t grain,
+                          const std::function<void(size_t, size_t)> &fn) {
+    auto tasks = (size + grain - 1) / grain;
+    parallelFor(tasks, [&](size_t t) {
+        fn(t * grain, std::min(size, (t + 1) * grain));
+    });
+}
+
+static size_t ceilDiv(size_t a, size_t b) {
+    return (a + b - 1) / b;
+}
+
+/* MR row strip 단위, strip 안에서는 k major. 남는 row 는 0 */
+static void packA(const float *A, size_t lda, size_t mc, size_t kc, float *packed) {
+    for (size_t i = 0; i < mc; i += MR) {
+        auto rows = std::min<size_t>(MR, mc - i);
+        for (size_t k = 0; k < kc; k++) {
+            for (size_t r = 0; r < MR; r++) {
+                *packed++ = r < rows ? A[(i + r) * lda + k] : 0.f;
+            }
+        }
+    }
+}
+
+/* NR column strip 하나, k major. 남는 column 은 0 */
+static void packB(const float *B, size_t ldb, bool transB, size_t kc, size_t cols,
+                  float *packed) {
+    if (transB) {
+        for (size_t c = 0; c < NR; c++) {
+            for (size_t k = 0; k < kc; k++) {
+                packed[k * NR + c] = c < cols ? B[c * ldb + k] : 0.f;
+            }
+        }
+    } else {
+        for (size_t k = 0; k < kc; k++) {
+            for (size_t c = 0; c < NR; c++) {
+                packed[k * NR + c] = c < cols ? B[k * ldb + c] : 0.f;
+            }
+        }
+    }
+}
+
+/* tile(MR, NR) = packed A strip * packed B strip */
+#if defined(__ARM_NEON)
+
+static void microKernel(size_t kc, const float *a, const float *b, float *tile) {
+    float32x4_t acc[MR][2];
+    for (size_t r = 0; r < MR; r++) {
+        acc[r][0] = vdupq_n_f32(0.f);
+        acc[r][1] = vdupq_n_f32(0.f);
+    }
+    for (size_t k = 0; k < kc; k++) {
+        auto b0 = vld1q_f32(b);
+        auto b1 = vld1q_f32(b + 4);
+        for (size_t r = 0; r < MR; r++) {
+#if defined(__aarch64__)
+            acc[r][0] = vfmaq_n_f32(acc[r][0], b0, a[r]);
+            acc[r][1] = vfmaq_n_f32(acc[r][1], b1, a[r]);
+#else
+            acc[r][0] = vmlaq_n_f32(acc[r][0], b0, a[r]);
+            acc[r][1] = vmlaq_n_f32(acc[r][1], b1, a[r]);
+#endif
+        }
+        a += MR;
+        b += NR;
+    }
+    for (size_t r = 0; r < MR; r++) {
+        vst1q_f32(tile + r * NR, acc[r][0]);
+        vst1q_f32(tile + r * NR + 4, acc[r][1]);
+    }
+}
+
+#else
+
+static void microKernelScalar(size_t kc, const float *a, const float *b, float *tile) {
+    float acc[MR * NR] = {0.f};
+    for (size_t k = 0; k < kc; k++) {
+        for (size_t r = 0; r < MR; r++) {
+            auto value = a[r];
+            for (size_t c = 0; c < NR; c++) {
+                acc[r * NR + c] += value * b[c];
+            }
+        }
+        a += MR;
+        b += NR;
+    }
+    std::copy(acc, acc + MR * NR, tile);
+}
+
+#if defined(USE_AVX2_DISPATCH)
+
+/* x86 ABI 의 baseline 은 SSE 이므로 AVX2 는 runtime 에 확인 */
+__attribute__((target("avx2,fma")))
+static void microKernelAvx2(size_t kc, const float *a, const float *b, float *tile) {
+    __m256 acc[MR];
+    for (size_t r = 0; r < MR; r++) {
+        acc[r] = _mm256_setzero_ps();
+    }
+    for (size_t k = 0; k < kc; k++) {
+        auto vb = _mm256_loadu_ps(b);
+        for (size_t r = 0; r < MR; r++) {
+            acc[r] = _mm256_fmadd_ps(_mm256_broadcast_ss(a + r), vb, acc[r]);
+        }
+        a += MR;
+        b += NR;
+    }
+    for (size_t r = 0; r < MR; r++) {
+        _mm256_storeu_ps(tile + r * NR, acc[r]);
+    }
+}
+
+static bool hasAvx2() {
+    static const bool result = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return result;
+}
+
+#endif
+
+static void microKernel(size_t kc, const float *a, const float *b, float *tile) {
+#if defined(USE_AVX2_DISPATCH)
+    if (hasAvx2()) {
+        microKernelAvx2(kc, a, b, tile);
+        return;
+    }
+#endif
+    microKernelScalar(kc, a, b, tile);
+}
+
+#endif
+
+void cpu::gemm(size_t M, size_t N, size_t K, const float *A, size_t lda, const float *B,
+               size_t ldb, bool transB, float *C, size_t ldc, bool parallel) {
+    if (M == 0 || N == 0 || K == 0) {
+        return;
+    }
+
+    auto run = [parallel](size_t n, const std::function<void(size_t)> &fn) {
+        if (parallel) {
+            parallelFor(n, fn);
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                fn(i);
+            }
+        }
+    };
+
+    /* parallel 일 때 worker 는 호출한 thread 의 packedB 를 읽음 */
+    thread_local std::vector<float> packedB;
+    packedB.resize(std::max(packedB.size(), KC * ceilDiv(std::min<size_t>(N, NC), NR) * NR));
+
+    for (size_t jc = 0; jc < N; jc += NC) {
+        auto nc = std::min<size_t>(NC, N - jc);
+        auto strips = ceilDiv(nc, NR);
+        for (size_t pc = 0; pc < K; pc += KC) {
+            auto kc = std::min<size_t>(KC, K - pc);
+            auto packedBData = packedB.data();
+
+            run(strips, [&](size_t s) {
+                auto j = s * NR;
+                auto src = transB ? B + (jc + j) * ldb + pc : B + pc * ldb + jc + j;
+                packB(src, ldb, transB, kc, std::min<size_t>(NR, nc - j),
+                      packedBData + j * kc);
+            });
+
+            auto blocksM = ceilDiv(M, MC);
+            auto blocksN = ceilDiv(nc, NB);
+            run(blocksM * blocksN, [&](size_t t) {
+                auto ic = (t / blocksN) * MC;
+                auto jb = (t % blocksN) * NB;
+                auto mc = std::min<size_t>(MC, M - ic);
+                auto jEnd = std::min<size_t>(jb + NB, nc);
+
+                thread_local std::vector<float> packedA(MC * KC);
+                packA(A + ic * lda + pc, lda, mc, kc, packedA.data());
+
+                float tile[MR * NR];
+                for (size_t jr = jb; jr < jEnd; jr += NR) {
+                    auto cols = std::min<size_t>(NR, nc - jr);
+                    for (size_t ir = 0; ir < mc; ir += MR) {
+                        auto rows = std::min<size_t>(MR, mc - ir);
+                        microKernel(kc, packedA.data() + ir * kc, packedBData + jr * kc, tile);
+                        for (size_t r = 0; r < rows; r++) {
+                            auto dst = C + (ic + ir + r) * ldc + jc + jr;
+                            for (size_t c = 0; c < cols; c++) {
+                                dst[c] += tile[r * NR + c];
+                            }
+                        }
+                    }
+                }
+            });
+        }
+    }
+}
+
+void cpu::linear(const float *input, const float *weight, const float *bias, float *output,
+                 size_t M, size_t N, size_t K) {
+    parallelRange(M, 64, [&](size_t begin, size_t end) {
+        for (size_t m = begin; m < end; m++) {
+            if (bias != nullptr) {
+                std::copy(bias, bias + N, output + m * N);
+            } else {
+                std::fill(output + m * N, output + (m + 1) * N, 0.f);
+            }
+        }
+    });
+    gemm(M, N, K, input, K, weight, K, true, output, N);
+}
+
+/* im2col (column 을 COL_BUFFER_SIZE 로 나눔) + gemm. 1x1 (stride 1, padding 0) 은 im2col 없음 */
+void cpu::conv2d(const float *input, const float *weight, const float *bias, float *output,
+                 size_t inChannel, size_t inputHeight, size_t inputWidth, size_t outChannel,
+                 size_t kernelSize, size_t stride, size_t padding, size_t outputHeight,
+                 size_t outputWidth) {
+    auto spatial = outputHeight * outputWidth;
+    parallelFor(outChannel, [&](size_t o) {
+        std::fill(output + o * spatial, output + (o + 1) * spatial,
+                  bias != nullptr ? bias[o] : 0.f);
+    });
+
+    if (kernelSize == 1 && stride == 1 && padding == 0) {
+        gemm(outChannel, spatial, inChannel, weight, inChannel, input, spatial, false, output,
+             spatial);
+        return;
+    }
+
+    auto kernelArea = kernelSize * kernelSize;
+    auto depth = inChannel * kernelArea;
+    auto chunk = std::max<size_t>(NR, COL_BUFFER_SIZE / depth / NR * NR);
+    chunk = std::min(chunk, spatial);
+    std::vector<float> col(depth * chunk);
+
+    for (size_t p0 = 0; p0 < spatial; p0 += chunk) {
+        auto n = std::min(chunk, spatial - p0);
+        parallelFor(depth, [&](size_t row) {
+            auto c = row / kernelArea;
+            auto ky = static_cast<long>((row / kernelSize) % kernelSize);
+            auto kx = static_cast<long>(row % kernelSize);
+            auto src = input + c * inputHeight * inputWidth;
+            auto dst = col.data() + row * n;
+            for (size_t q = 0; q < n; q++) {
+                auto oy = static_cast<long>((p0 + q) / outputWidth);
+                auto ox = static_cast<long>((p0 + q) % outputWidth);
+                auto iy = oy * static_cast<long>(stride) + ky - static_cast<long>(padding);
+                auto ix = ox * static_cast<long>(stride) + kx - static_cast<long>(padding);
+                auto inside = iy >= 0 && iy < inputHeight && ix >= 0 && ix < inputWidth;
+                dst[q] = inside ? src[iy * inputWidth + ix] : 0.f;
+            }
+        });
+        gemm(outChannel, n, depth, weight, depth, col.data(), n, false, output + p0, spatial);
+    }
+}
+
+void cpu::groupNorm(const float *input, const float *weight, const float *bias, float *output,
+                    size_t channels, size_t size, size_t numGroups, float eps) {
+    auto channelsPerGroup = channels / numGroups;
+    auto groupSize = channelsPerGroup * size;
+    parallelFor(numGroups, [&](size_t g) {
+        auto src = input + g * groupSize;
+        double sum = 0;
+        for (size_t i = 0; i < groupSize; i++) {
+            sum += src[i];
+        }
+        auto mean = static_cast<float>(sum / groupSize);
+        double var = 0;
+        for (size_t i = 0; i < groupSize; i++) {
+            auto diff = src[i] - mean;
+            var += diff * diff;
+        }
+        auto inv = 1.f / std::sqrt(static_cast<float>(var / groupSize) + eps);
+
+        for (size_t c = g * channelsPerGroup; c < (g + 1) * channelsPerGroup; c++) {
+            auto scale = inv * weight[c];
+            auto shift = bias[c] - mean * scale;
+            for (size_t i = c * size; i < (c + 1) * size; i++) {
+                output[i] = input[i] * scale + shift;
+            }
+        }
+    });
+}
+
+void cpu::layerNorm(const float *input, const float *weight, const float *bias, float *output,
+                    size_t rows, size_t size, float eps) {
+    parallelRange(rows, 8, [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; row++) {
+            auto src = input + row * size;
+            auto dst = output + row * size;
+            float sum = 0.f;
+            for (size_t i = 0; i < size; i++) {
+                sum += src[i];
+            }
+            auto mean = sum / size;
+            float var = 0.f;
+            for (size_t i = 0; i < size; i++) {
+                var += (src[i] - mean) * (src[i] - mean);
+            }
+            auto inv = 1.f / std::sqrt(var / size + eps);
+            for (size_t i = 0; i < size; i++) {
+                dst[i] = (src[i] - mean) * inv * weight[i] + bias[i];
+            }
+        }
+    });
+}
+
+void cpu::geluMultiply(const float *input, float *output, size_t rows, size_t size) {
+    parallelRange(rows, 16, [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; row++) {
+            auto a = input + row * size * 2;
+            auto b = a + size;
+            auto dst = output + row * size;
+            for (size_t i = 0; i < size; i++) {
+                dst[i] = a[i] * 0.5f * b[i] * (1.f + std::erf(b[i] * (float) M_SQRT1_2));
+            }
+        }
+    });
+}
+
+void cpu::upSampleNearest(const float *input, float *output, size_t channels, size_t height,
+                          size_t width, size_t scale) {
+    auto outWidth = width * scale;
+    parallelFor(channels, [&](size_t c) {
+        auto src = input + c * height * width;
+        auto dst = output + c * height * width * scale * scale;
+        for (size_t y = 0; y < height * scale; y++) {
+            auto srcRow = src + (y / scale) * width;
+            auto dstRow = dst + y * outWidth;
+            for (size_t x = 0; x < outWidth; x++) {
+                dstRow[x] = srcRow[x / scale];
+            }
+        }
+    });
+}
+
+/* (head, ATTENTION_ROWS query) task 별로 score 를 만들고 safe softmax 후 V 를 곱함 */
+void cpu::attention(const float *Q, size_t ldq, const float *K, size_t ldk, const float *V,
+                    size_t ldv, float *O, size_t ldo, size_t numHeads, size_t M, size_t N,
+                    size_t D, float scale, const float *mask) {
+    auto rowBlocks = ceilDiv(M, ATTENTION_ROWS);
+    parallelFor(numHeads * rowBlocks, [&](size_t t) {
+        auto h = t / rowBlocks;
+        auto i0 = (t % rowBlocks) * ATTENTION_ROWS;
+        auto rows = std::min<size_t>(ATTENTION_ROWS, M - i0);
+
+        thread_local std::vector<float> scores;
+        scores.assign(rows * N, 0.f);
+        gemm(rows, N, D, Q + i0 * ldq + h * D, ldq, K + h * D, ldk, true, scores.data(), N,
+             false);
+
+        for (size_t r = 0; r < rows; r++) {
+            auto row = scores.data() + r * N;
+            auto maskRow = mask != nullptr ? mask + (i0 + r) * N : nullptr;
+            auto max = -INFINITY;
+            for (size_t j = 0; j < N; j++) {
+                row[j] = row[j] * scale + (maskRow != nullptr ? maskRow[j] : 0.f);
+                max = std::max(max, row[j]);
+            }
+            float sum = 0.f;
+            for (size_t j = 0; j < N; j++) {
+                row[j] = std::exp(row[j] - max);
+                sum += row[j];
+            }
+            for (size_t j = 0; j < N; j++) {
+                row[j] /= sum;
+            }
+            std::fill(O + (i0 + r) * ldo + h * D, O + (i0 + r) * ldo + (h + 1) * D, 0.f);
+        }
+
+        gemm(rows, D, N, scores.data(), N, V + h * D, ldv, false, O + i0 * ldo + h * D, ldo,
+             false);
+    });
+}
+
+void cpu::transpose(const float *input, float *output, size_t rows, size_t cols) {
+    const size_t block = 32;
+    parallelRange(rows, block, [&](size_t begin, size_t end) {
+        for (size_t j0 = 0; j0 < cols; j0 += block) {
+            auto jEnd = std::min(cols, j0 + block);
+            for (size_t i = begin; i < end; i++) {
+                for (size_t j = j0; j < jEnd; j++) {
+                    output[j * rows + i] = input[i * cols + j];
+                }
+            }
+        }
+    });
+}
+
+void cpu::add(const float *a, const float *b, float *output, size_t size) {
+    parallelRange(size, 1 << 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            output[i] = a[i] + b[i];
+        }
+    });
+}
@@ -0,0 +1,64 @@
+//
+// Created by 구현우 on 2024/07/14.
+//
+
+#ifndef MY_OPENCL_CPUKERNEL_H
+#define MY_OPENCL_CPUKERNEL_H
+
+#include <cstddef>
+
+/*
+ * CPU backend kernel. 모든 tensor 는 row major float32, 결과는 OpenCL kernel 과 같은 layout.
+ * gemm : MC x KC x NC block + packing, MR x NR micro kernel (NEON / AVX2 / scalar)
+ */
+namespace cpu {
+
+    /*
+     * C(M, N) += A(M, K) * B
+     * B = (K, N), transB : B = (N, K)
+     * `parallel` = false : 호출한 thread 에서만 실행 (parallelFor 안에서 사용)
+     */
+    void gemm(size_t M, size_t N, size_t K, const float *A, size_t lda, const float *B,
+              size_t ldb, bool transB, float *C, size_t ldc, bool parallel = true);
+
+    /* output(M, N) = input(M, K) * weight(N, K)^T + bias(N), bias nullable */
+    void linear(const float *input, const float *weight, const float *bias, float *output,
+                size_t M, size_t N, size_t K);
+
+    /* input (inChannel, inputHeight, inputWidth), weight (outChannel, inChannel, k, k) */
+    void conv2d(const float *input, const float *weight, const float *bias, float *output,
+                size_t inChannel, size_t inputHeight, size_t inputWidth, size_t outChannel,
+                size_t kernelSize, size_t stride, size_t padding, size_t outputHeight,
+                size_t outputWidth);
+
+    /* input (channels, size), channel 이 연속된 numGroups 개의 group */
+    void groupNorm(const float *input, const float *weight, const float *bias, float *output,
+                   size_t channels, size_t size, size_t numGroups, float eps);
+
+    /* input (rows, size) 의 마지막 dim */
+    void layerNorm(const float *input, const float *weight, const float *bias, float *output,
+                   size_t rows, size_t size, float eps);
+
+    /* input (rows, 2 * size) = [a, b] -> output (rows, size) = a * gelu(b) */
+    void geluMultiply(const float *input, float *output, size_t rows, size_t size);
+
+    /* nearest, (channels, height, width) -> (channels, height * scale, width * scale) */
+    void upSampleNearest(const float *input, float *output, size_t channels, size_t height,
+                         size_t width, size_t scale);
+
+    /*
+     * O_h = softmax(scale * Q_h * K_h^T + mask) * V_h, head h 는 column [h * D, (h + 1) * D)
+     * Q (M, ldq), K / V (N, ldk / ldv), O (M, ldo), mask (M, N) nullable
+     */
+    void attention(const float *Q, size_t ldq, const float *K, size_t ldk, const float *V,
+                   size_t ldv, float *O, size_t ldo, size_t numHeads, size_t M, size_t N,
+                   size_t D, float scale, const float *mask);
+
+    /* output (cols, rows) = input (rows, cols)^T */
+    void transpose(const float *input, float *output, size_t rows, size_t cols);
+
+    void add(const float *a, const float *b, float *output, size_t size);
+}
+
+
+#endif //MY_OPENCL_CPUKERNEL_H
@@ -0,0 +1,142 @@
+//
+// Created by 구현우 on 2024/07/14.
+//
+
+#include "ThreadPool.h"
+
+#include <android/log.h>
+#include <algorithm>
+#include <fstream>
+#include <sched.h>
+#include <string>
+
+#define LOG_TAG "THREAD_POOL"
+
+/* task 실행 중 (worker 또는 parallelFor 를 호출한 thread) */
+static thread_local bool insideTask = false;
+
+ThreadPool::ThreadPool(size_t numThreads, const std::vector<int> &cpus) : cpus(cpus) {
+    for (size_t i = 1; i < numThreads; i++) {
+        workers.emplace_back(&ThreadPool::work, this, i - 1);
+    }
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "threads(%ld), pinned cpus(%ld)",
+                        numThreads, cpus.size());
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wake.notify_all();
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return workers.size() + 1;
+}
+
+void ThreadPool::parallelFor(size_t n, const std::function<void(size_t)> &fn) {
+    if (workers.empty() || n <= 1 || insideTask) {
+        for (size_t i = 0; i < n; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> run(runMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        count = n;
+        next = 0;
+        pending = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    insideTask = true;
+    runTasks();
+    insideTask = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return pending == 0; });
+    task = nullptr;
+}
+
+void ThreadPool::work(size_t index) {
+    insideTask = true;
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[index % cpus.size()], &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            __android_log_print(ANDROID_LOG_WARN, LOG_TAG, "Failed to pin worker %ld to cpu %d",
+                                index, cpus[index % cpus.size()]);
+        }
+    }
+
+    unsigned long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stop || generation != seen; });
+            if (stop) {
+                return;
+            }
+            seen = generation;
+        }
+
+        runTasks();
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            last = --pending == 0;
+        }
+        if (last) {
+            done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::runTasks() {
+    size_t i;
+    while ((i = next++) < count) {
+        (*task)(i);
+    }
+}
+
+std::vector<int> ThreadPool::getBigCores() {
+    std::vector<long> freqs;
+    auto numCpus = std::thread::hardware_concurrency();
+    for (int cpu = 0; cpu < numCpus; cpu++) {
+        std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                           "/cpufreq/cpuinfo_max_freq");
+        long freq;
+        if (!(file >> freq)) {
+            return {};
+        }
+        freqs.push_back(freq);
+    }
+    if (freqs.empty()) {
+        return {};
+    }
+
+    /* little cluster 제외 (모든 core 가 같으면 전체) */
+    auto minFreq = *std::min_element(freqs.begin(), freqs.end());
+    std::vector<int> cores;
+    for (int cpu = 0; cpu < freqs.size(); cpu++) {
+        if (freqs[cpu] > minFreq) {
+            cores.push_back(cpu);
+        }
+    }
+    if (cores.empty()) {
+        for (int cpu = 0; cpu < freqs.size(); cpu++) {
+            cores.push_back(cpu);
+        }
+    }
+    return cores;
+}
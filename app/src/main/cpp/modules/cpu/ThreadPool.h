@@ -0,0 +1,59 @@
+//
+// Created by 구현우 on 2024/07/14.
+//
+
+#ifndef MY_OPENCL_THREADPOOL_H
+#define MY_OPENCL_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * 고정된 worker thread pool.
+ * parallelFor 는 호출한 thread 도 task 를 나눠 실행하고, 모든 task 가 끝나야 return.
+ * 한 번에 하나의 parallelFor 만 실행 (다른 thread 의 호출은 대기),
+ * worker 안에서의 nested parallelFor 는 serial 로 실행.
+ */
+class ThreadPool {
+public:
+    /* `cpus` 가 비어있지 않으면 worker 를 해당 core 에 pinning */
+    ThreadPool(size_t numThreads, const std::vector<int> &cpus);
+
+    ~ThreadPool();
+
+    /* caller 포함 */
+    size_t size() const;
+
+    /* fn(0) ... fn(n - 1) */
+    void parallelFor(size_t n, const std::function<void(size_t)> &fn);
+
+    /* cpuinfo_max_freq 가 가장 낮은 cluster 를 제외한 core (big core). 읽을 수 없으면 empty */
+    static std::vector<int> getBigCores();
+
+private:
+    void work(size_t index);
+
+    void runTasks();
+
+    std::vector<std::thread> workers;
+    std::vector<int> cpus;
+
+    std::mutex runMutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t)> *task = nullptr;
+    size_t count = 0;
+    std::atomic<size_t> next{0};
+    size_t pending = 0;
+    unsigned long generation = 0;
+    bool stop = false;
+};
+
+
+#endif //MY_OPENCL_THREADPOOL_H
@@ -4,6 +4,7 @@
 
 #include "ConvKernel.h"
 #include "../../util.h"
+#include "../../ProgramCache.h"
 #include <android/log.h>
 
 #define LOG_TAG "CONV_KERNEL"
@@ -19,10 +20,12 @@ ConvKernel::ConvKernel(
         cl_context context,
         cl_device_id deviceId,
         AAssetManager *assetManager
-) {
+) : im2win_channel_reg_transpose_reorder_vector_v8_matmul_specialized(
+        context, deviceId, assetManager, "kernel/conv2d.cl",
+        "im2win_channel_reg_transpose_reorder_vector_v8_matmul") {
     cl_int err;
 
-    auto program = util::create_and_build_program_with_source(
+    auto program = ProgramCache::getInstance().get(
             context,
             deviceId,
             assetManager,
@@ -77,6 +80,9 @@ ConvKernel::ConvKernel(
     im2win_channel_reg_transpose_reorder_vector_v8_matmul = clCreateKernel(program, "im2win_channel_reg_transpose_reorder_vector_v8_matmul", &err);
     CHECK_ERROR_THROW(err);
 
+    implicit_gemm_conv2d = clCreateKernel(program, "implicit_gemm_conv2d", &err);
+    CHECK_ERROR_THROW(err);
+
     clReleaseProgram(program);
 }
 
@@ -97,4 +103,5 @@ ConvKernel::~ConvKernel() {
     clReleaseKernel(im2win_channel_reg_transpose_weight_vector_v7_matmul);
     clReleaseKernel(im2win_transpose_reorder);
     clReleaseKernel(im2win_channel_reg_transpose_reorder_vector_v8_matmul);
+    clReleaseKernel(implicit_gemm_conv2d);
 }
\ No newline at end of file
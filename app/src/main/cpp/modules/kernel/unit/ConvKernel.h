@@ -7,6 +7,7 @@
 
 #include <CL/opencl.h>
 #include <android/asset_manager.h>
+#include "SpecializedKernel.h"
 
 class ConvKernel {
 public:
@@ -30,6 +31,10 @@ public:
     cl_kernel im2win_channel_reg_transpose_weight_vector_v7_matmul;
     cl_kernel im2win_transpose_reorder;
     cl_kernel im2win_channel_reg_transpose_reorder_vector_v8_matmul;
+
+    /* shape 특화 im2win_channel_reg_transpose_reorder_vector_v8_matmul */
+    SpecializedKernel im2win_channel_reg_transpose_reorder_vector_v8_matmul_specialized;
+    cl_kernel implicit_gemm_conv2d;
 };
 
 
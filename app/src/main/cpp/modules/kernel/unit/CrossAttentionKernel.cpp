@@ -4,6 +4,7 @@
 
 #include "CrossAttentionKernel.h"
 #include "../../util.h"
+#include "../../ProgramCache.h"
 #include <android/log.h>
 
 #define LOG_TAG "CROSS_ATTENTION_KERNEL"
@@ -19,10 +20,11 @@ CrossAttentionKernel::CrossAttentionKernel(
         cl_context context,
         cl_device_id deviceId,
         AAssetManager *assetManager
-) {
+) : optimized_einsum_bik_bkj_bij_specialized(
+        context, deviceId, assetManager, "kernel/cross_attention.cl", "optimized_einsum_bik_bkj_bij") {
     cl_int err;
 
-    auto program = util::create_and_build_program_with_source(
+    auto program = ProgramCache::getInstance().get(
             context,
             deviceId,
             assetManager,
@@ -44,6 +46,9 @@ CrossAttentionKernel::CrossAttentionKernel(
     optimized_einsum_bik_bkj_bij_general = clCreateKernel(program, "optimized_einsum_bik_bkj_bij_general", &err);
     CHECK_ERROR_THROW(err);
 
+    split_qkv_heads = clCreateKernel(program, "split_qkv_heads", &err);
+    CHECK_ERROR_THROW(err);
+
     clReleaseProgram(program);
 }
 
@@ -53,4 +58,5 @@ CrossAttentionKernel::~CrossAttentionKernel() {
     clReleaseKernel(optimized_einsum_bik_bjk_bij);
     clReleaseKernel(optimized_einsum_bik_bkj_bij);
     clReleaseKernel(optimized_einsum_bik_bkj_bij_general);
+    clReleaseKernel(split_qkv_heads);
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 
 #include <CL/opencl.h>
 #include <android/asset_manager.h>
+#include "SpecializedKernel.h"
 
 class CrossAttentionKernel {
 public:
@@ -19,7 +20,13 @@ public:
 
     cl_kernel optimized_einsum_bik_bjk_bij;
     cl_kernel optimized_einsum_bik_bkj_bij;
+
+    /* shape 특화 optimized_einsum_bik_bkj_bij */
+    SpecializedKernel optimized_einsum_bik_bkj_bij_specialized;
     cl_kernel optimized_einsum_bik_bkj_bij_general;
+
+    /* fused to_qkv -> Q, K, V (head-major) */
+    cl_kernel split_qkv_heads;
 };
 
 
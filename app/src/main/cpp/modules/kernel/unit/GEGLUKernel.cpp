@@ -4,6 +4,7 @@
 
 #include "GEGLUKernel.h"
 #include "../../util.h"
+#include "../../ProgramCache.h"
 #include <android/log.h>
 
 #define LOG_TAG "GEGLU_KERNEL"
@@ -21,7 +22,7 @@ GEGLUKernel::GEGLUKernel(
 ) {
     cl_int err;
 
-    auto program = util::create_and_build_program_with_source(
+    auto program = ProgramCache::getInstance().get(
             context,
             deviceId,
             assetManager,
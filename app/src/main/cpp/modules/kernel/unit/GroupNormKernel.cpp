@@ -4,6 +4,7 @@
 
 #include "GroupNormKernel.h"
 #include "../../util.h"
+#include "../../ProgramCache.h"
 #include <android/log.h>
 
 #define LOG_TAG "GROUP_NORM_KERNEL"
@@ -21,7 +22,7 @@ GroupNormKernel::GroupNormKernel(
 ) {
     cl_int err;
 
-    auto program = util::create_and_build_program_with_source(
+    auto program = ProgramCache::getInstance().get(
             context,
             deviceId,
             assetManager,
@@ -37,6 +38,9 @@ GroupNormKernel::GroupNormKernel(
     group_norm = clCreateKernel(program, "group_norm", &err);
     CHECK_ERROR_THROW(err);
 
+    group_norm_channel_last = clCreateKernel(program, "group_norm_channel_last", &err);
+    CHECK_ERROR_THROW(err);
+
     clReleaseProgram(program);
 }
 
@@ -44,4 +48,5 @@ GroupNormKernel::~GroupNormKernel() {
     clReleaseKernel(local_reduction_mean);
     clReleaseKernel(local_reduction_variance);
     clReleaseKernel(group_norm);
+    clReleaseKernel(group_norm_channel_last);
 }
\ No newline at end of file
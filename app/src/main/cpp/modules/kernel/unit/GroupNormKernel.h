@@ -17,6 +17,7 @@ public:
     cl_kernel local_reduction_mean;
     cl_kernel local_reduction_variance;
     cl_kernel group_norm;
+    cl_kernel group_norm_channel_last;
 };
 
 
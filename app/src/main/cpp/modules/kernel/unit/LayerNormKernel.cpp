@@ -4,6 +4,7 @@
 
 #include "LayerNormKernel.h"
 #include "../../util.h"
+#include "../../ProgramCache.h"
 #include <android/log.h>
 
 #define LOG_TAG "LAYER_NORM_KERNEL"
@@ -21,8 +22,8 @@ LayerNormKernel::LayerNormKernel(
 ) {
     cl_int err;
 
-    auto program = util::create_and_build_program_with_source(context, deviceId, assetManager,
-                                                              "kernel/layer_norm.cl");
+    auto program = ProgramCache::getInstance().get(context, deviceId, assetManager,
+                                                   "kernel/layer_norm.cl");
     mean = clCreateKernel(program, "local_reduction_mean", &err);
     CHECK_ERROR_THROW(err);
 
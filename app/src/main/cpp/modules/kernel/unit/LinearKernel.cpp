@@ -4,6 +4,7 @@
 
 #include "LinearKernel.h"
 #include "../../util.h"
+#include "../../ProgramCache.h"
 #include <android/log.h>
 
 #define LOG_TAG "LAYER_NORM_KERNEL"
@@ -18,11 +19,12 @@ LinearKernel::LinearKernel(
         cl_context context,
         cl_device_id deviceId,
         AAssetManager *assetManager
-) {
+) : tile_reg_m_vector_n_linear_specialized(context, deviceId, assetManager, "kernel/linear.cl",
+                                           "tile_reg_m_vector_n_linear") {
     cl_int err;
 
-    auto program = util::create_and_build_program_with_source(context, deviceId, assetManager,
-                                                              "kernel/linear.cl");
+    auto program = ProgramCache::getInstance().get(context, deviceId, assetManager,
+                                                   "kernel/linear.cl");
 
     naive_linear = clCreateKernel(program, "linear", &err);
     CHECK_ERROR_THROW(err);
@@ -30,6 +32,9 @@ LinearKernel::LinearKernel(
     register_linear = clCreateKernel(program, "reg_linear", &err);
     CHECK_ERROR_THROW(err);
 
+    register_linear_v2 = clCreateKernel(program, "reg_linear_v2", &err);
+    CHECK_ERROR_THROW(err);
+
     tile_linear = clCreateKernel(program, "tile_linear", &err);
     CHECK_ERROR_THROW(err);
 
@@ -51,6 +56,7 @@ LinearKernel::LinearKernel(
 LinearKernel::~LinearKernel() {
     clReleaseKernel(naive_linear);
     clReleaseKernel(register_linear);
+    clReleaseKernel(register_linear_v2);
     clReleaseKernel(tile_linear);
     clReleaseKernel(tile_reg_n_linear);
     clReleaseKernel(tile_reg_n_vector_linear);
@@ -7,6 +7,7 @@
 
 #include <CL/opencl.h>
 #include <android/asset_manager.h>
+#include "SpecializedKernel.h"
 
 class LinearKernel {
 public:
@@ -16,11 +17,16 @@ public:
 
     cl_kernel naive_linear;
     cl_kernel register_linear;
+    /* reg_linear 에서 local memory copy 를 뺀 version (KernelBenchmark 만 사용) */
+    cl_kernel register_linear_v2;
     cl_kernel tile_linear;
     cl_kernel tile_reg_n_linear;
     cl_kernel tile_reg_n_vector_linear;
     cl_kernel tile_reg_m_n_vector_linear;
     cl_kernel tile_reg_m_vector_n_linear;
+
+    /* shape 특화 tile_reg_m_vector_n_linear */
+    SpecializedKernel tile_reg_m_vector_n_linear_specialized;
 };
 
 
@@ -4,6 +4,7 @@
 
 #include "MultiHeadAttentionKernel.h"
 #include "../../util.h"
+#include "../../ProgramCache.h"
 #include <android/log.h>
 
 #define LOG_TAG "MULTI_HEAD_ATTENTION_KERNEL"
@@ -21,8 +22,8 @@ MultiHeadAttentionKernel::MultiHeadAttentionKernel(
         ) {
     cl_int err;
 
-    cl_program program = util::create_and_build_program_with_source(context, deviceId, assetManager,
-                                                                    "kernel/multi_head_attention.cl");
+    cl_program program = ProgramCache::getInstance().get(context, deviceId, assetManager,
+                                                         "kernel/multi_head_attention.cl");
     add_matmul_attention = clCreateKernel(program, "add_matmul_attention", &err);
     CHECK_ERROR_THROW(err);
 
@@ -38,6 +39,9 @@ MultiHeadAttentionKernel::MultiHeadAttentionKernel(
     batch_matmul = clCreateKernel(program, "batch_matmul", &err);
     CHECK_ERROR_THROW(err);
 
+    causal_attention = clCreateKernel(program, "causal_attention", &err);
+    CHECK_ERROR_THROW(err);
+
     clReleaseProgram(program);
 }
 
@@ -47,4 +51,5 @@ MultiHeadAttentionKernel::~MultiHeadAttentionKernel() {
     clReleaseKernel(matmul_attention);
     clReleaseKernel(batch_matmul_mask);
     clReleaseKernel(batch_matmul);
+    clReleaseKernel(causal_attention);
 }
\ No newline at end of file
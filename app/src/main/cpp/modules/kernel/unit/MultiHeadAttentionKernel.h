@@ -20,6 +20,7 @@ public:
     cl_kernel matmul_attention;
     cl_kernel batch_matmul_mask;
     cl_kernel batch_matmul;
+    cl_kernel causal_attention;
 };
 
 
@@ -0,0 +1,67 @@
+//
+// Created by 구현우 on 2024/07/24.
+//
+
+#include "SpecializedKernel.h"
+#include "../../ProgramCache.h"
+#include "../../setting.h"
+#include <android/log.h>
+#include <stdexcept>
+
+#define LOG_TAG "SPECIALIZED_KERNEL"
+
+SpecializedKernel::SpecializedKernel(
+        cl_context context,
+        cl_device_id deviceId,
+        AAssetManager *assetManager,
+        const char *fileName,
+        const char *kernelName
+) : context(context), deviceId(deviceId), assetManager(assetManager), fileName(fileName),
+    kernelName(kernelName) {
+}
+
+SpecializedKernel::~SpecializedKernel() {
+    for (auto &kernel: kernels) {
+        if (kernel.second != nullptr) {
+            clReleaseKernel(kernel.second);
+        }
+    }
+}
+
+cl_kernel SpecializedKernel::get(std::initializer_list<std::pair<const char *, size_t>> constants) {
+    if (SHAPE_SPECIALIZE_MODE == 0) {
+        return nullptr;
+    }
+
+    std::string options;
+    for (auto &constant: constants) {
+        if (!options.empty()) {
+            options += " ";
+        }
+        options += "-D " + std::string(constant.first) + "=" + std::to_string(constant.second);
+    }
+
+    auto it = kernels.find(options);
+    if (it != kernels.end()) {
+        return it->second;
+    }
+
+    cl_kernel kernel = nullptr;
+    try {
+        auto program = ProgramCache::getInstance().get(context, deviceId, assetManager, fileName,
+                                                       options);
+        cl_int err;
+        kernel = clCreateKernel(program, kernelName, &err);
+        clReleaseProgram(program);
+        if (err != CL_SUCCESS) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "clCreateKernel(%s) error %d",
+                                kernelName, err);
+            kernel = nullptr;
+        }
+    } catch (const std::runtime_error &e) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "%s [%s] build failed: %s", kernelName,
+                            options.c_str(), e.what());
+    }
+    kernels[options] = kernel;
+    return kernel;
+}
@@ -0,0 +1,46 @@
+//
+// Created by 구현우 on 2024/07/24.
+//
+
+#ifndef MY_OPENCL_SPECIALIZEDKERNEL_H
+#define MY_OPENCL_SPECIALIZEDKERNEL_H
+
+#include <CL/opencl.h>
+#include <android/asset_manager.h>
+
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <utility>
+
+/*
+ * shape 특화 kernel (SHAPE_SPECIALIZE_MODE).
+ * M, N, K, tile size 같은 runtime argument 를 -D 상수로 build 한 variant 를 shape 마다 하나씩 (program 은 ProgramCache).
+ * kernel 은 clSetKernelArg 때문에 owner (*Kernel) 마다 따로. argument 순서는 일반 kernel 과 같음.
+ */
+class SpecializedKernel {
+public:
+    SpecializedKernel(cl_context context, cl_device_id deviceId, AAssetManager *assetManager,
+                      const char *fileName, const char *kernelName);
+
+    ~SpecializedKernel();
+
+    /*
+     * `constants`: -D <name>=<value>
+     * @return: nullptr if specialization is off or build failed (use the generic kernel)
+     */
+    cl_kernel get(std::initializer_list<std::pair<const char *, size_t>> constants);
+
+private:
+    cl_context context;
+    cl_device_id deviceId;
+    AAssetManager *assetManager;
+    const char *fileName;
+    const char *kernelName;
+
+    /* build options -> kernel (nullptr : build failed) */
+    std::map<std::string, cl_kernel> kernels;
+};
+
+
+#endif //MY_OPENCL_SPECIALIZEDKERNEL_H
@@ -4,6 +4,7 @@
 
 #include "UpSampleKernel.h"
 #include "../../util.h"
+#include "../../ProgramCache.h"
 #include <android/log.h>
 
 #define LOG_TAG "UP_SAMPLE_KERNEL"
@@ -21,7 +22,7 @@ UpSampleKernel::UpSampleKernel(
 ) {
     cl_int err;
 
-    auto program = util::create_and_build_program_with_source(
+    auto program = ProgramCache::getInstance().get(
             context,
             deviceId,
             assetManager,
@@ -4,6 +4,7 @@
 
 #include "UtilKernel.h"
 #include "../../util.h"
+#include "../../ProgramCache.h"
 #include <android/log.h>
 
 #define LOG_TAG "UTIL_KERNEL"
@@ -17,13 +18,16 @@
 UtilKernel::UtilKernel(cl_context context, cl_device_id deviceId, AAssetManager *assetManager) {
     cl_int err;
 
-    auto program = util::create_and_build_program_with_source(
+    auto program = ProgramCache::getInstance().get(
             context, deviceId, assetManager, "kernel/util.cl"
     );
 
     elemwise_add = clCreateKernel(program, "elemwise_add", &err);
     CHECK_ERROR_THROW(err);
 
+    elemwise_multiply = clCreateKernel(program, "elemwise_multiply", &err);
+    CHECK_ERROR_THROW(err);
+
     permute3D_1_0_2 = clCreateKernel(program, "permute3D__1_0_2", &err);
     CHECK_ERROR_THROW(err);
 
@@ -54,11 +58,33 @@ UtilKernel::UtilKernel(cl_context context, cl_device_id deviceId, AAssetManager
     permute3D_copy = clCreateKernel(program, "permute3D_copy", &err);
     CHECK_ERROR_THROW(err);
 
+    latent_preview = clCreateKernel(program, "latent_preview", &err);
+    CHECK_ERROR_THROW(err);
+
+    token_embedding = clCreateKernel(program, "token_embedding", &err);
+    CHECK_ERROR_THROW(err);
+
+    token_embedding_half = clCreateKernel(program, "token_embedding_half", &err);
+    CHECK_ERROR_THROW(err);
+
+    softmax_online = clCreateKernel(program, "softmax_online", &err);
+    CHECK_ERROR_THROW(err);
+
+    softmax_online_half = clCreateKernel(program, "softmax_online_half", &err);
+    CHECK_ERROR_THROW(err);
+
+    strided_batch_matmul = clCreateKernel(program, "strided_batch_matmul", &err);
+    CHECK_ERROR_THROW(err);
+
+    channel_first_add = clCreateKernel(program, "channel_first_add", &err);
+    CHECK_ERROR_THROW(err);
+
     clReleaseProgram(program);
 }
 
 UtilKernel::~UtilKernel() {
     clReleaseKernel(elemwise_add);
+    clReleaseKernel(elemwise_multiply);
     clReleaseKernel(permute3D_1_0_2);
     clReleaseKernel(permute3D_0_2_1);
     clReleaseKernel(permute3D);
@@ -69,4 +95,11 @@ UtilKernel::~UtilKernel() {
     clReleaseKernel(batch_matmul_scale);
     clReleaseKernel(chunkwise_add);
     clReleaseKernel(permute3D_copy);
+    clReleaseKernel(latent_preview);
+    clReleaseKernel(token_embedding);
+    clReleaseKernel(token_embedding_half);
+    clReleaseKernel(softmax_online);
+    clReleaseKernel(softmax_online_half);
+    clReleaseKernel(strided_batch_matmul);
+    clReleaseKernel(channel_first_add);
 }
\ No newline at end of file
@@ -15,6 +15,8 @@ public:
     ~UtilKernel();
 
     cl_kernel elemwise_add;
+    /* KernelBenchmark 만 사용 */
+    cl_kernel elemwise_multiply;
     cl_kernel permute3D_1_0_2;
     cl_kernel permute3D_0_2_1;
     cl_kernel permute3D;
@@ -25,6 +27,13 @@ public:
     cl_kernel batch_matmul_scale;
     cl_kernel chunkwise_add;
     cl_kernel permute3D_copy;
+    cl_kernel latent_preview;
+    cl_kernel token_embedding;
+    cl_kernel token_embedding_half;
+    cl_kernel softmax_online;
+    cl_kernel softmax_online_half;
+    cl_kernel strided_batch_matmul;
+    cl_kernel channel_first_add;
 };
 
 
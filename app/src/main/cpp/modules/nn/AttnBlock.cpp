@@ -5,6 +5,11 @@
 #include "AttnBlock.h"
 
 #include "../util.h"
+#include "../Tracer.h"
+#include "../CommandRecorder.h"
+#include "../setting.h"
+#include "../cpu/CpuBackend.h"
+#include "../cpu/CpuKernel.h"
 
 #include <android/log.h>
 
@@ -76,219 +81,436 @@ void AttnBlock::init() {
     out_conv2d->init();
 }
 
-cl_int AttnBlock::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
-                          const cl_event *event_wait_list, cl_event *event) {
+cl_int AttnBlock::forward(cl_mem input, cl_mem output, size_t height, size_t width,
+                          cl_uint num_events_in_list, const cl_event *event_wait_list,
+                          cl_event *event) {
+    if (CpuBackend::isEnabled()) {
+        return forwardCpu(input, output, height, width, num_events_in_list, event_wait_list,
+                          event);
+    }
+
     cl_int err;
-    cl_event events[10];
+    cl_event events[10] = {};
 
     size_t inputBytes;
-    cl_mem bufferNorm, bufferQ, bufferK, bufferV, bufferPermuteQ, bufferQK, bufferPermuteQK;
+    cl_mem bufferNorm, bufferQ, bufferK, bufferV, bufferQK;
+    cl_mem bufferPermuteQ = nullptr, bufferPermuteQK = nullptr;
     err = clGetMemObjectInfo(input, CL_MEM_SIZE, sizeof(size_t), &inputBytes, nullptr);
     CHECK_ERROR(err);
 
-    size_t heightXwidth = inputBytes / sizeof(float) / in_channels;
-
-    bufferNorm = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                inputBytes,
-                                nullptr, &err);
-    CHECK_ERROR(err);
+    size_t heightXwidth = height * width;
+    /* strided : Q^T, softmax 결과^T 를 stride 로 읽음 (bufferPermuteQ, bufferPermuteQK 없음) */
+    bool strided = ATTN_BLOCK_KERNEL_VERSION == 1;
 
-    bufferQ = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                             inputBytes,
-                             nullptr, &err);
+    bufferNorm = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                        inputBytes,
+                                        nullptr, &err);
     CHECK_ERROR(err);
 
-    bufferK = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                             inputBytes,
-                             nullptr, &err);
+    bufferQ = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                     inputBytes,
+                                     nullptr, &err);
     CHECK_ERROR(err);
 
-    bufferV = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                             inputBytes,
-                             nullptr, &err);
+    bufferK = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                     inputBytes,
+                                     nullptr, &err);
     CHECK_ERROR(err);
 
-    bufferPermuteQ = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    inputBytes,
-                                    nullptr, &err);
+    bufferV = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                     inputBytes,
+                                     nullptr, &err);
     CHECK_ERROR(err);
 
-    bufferQK = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                              sizeof(float) * heightXwidth * heightXwidth,
-                              nullptr, &err);
+    bufferQK = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                      sizeof(float) * heightXwidth * heightXwidth,
+                                      nullptr, &err);
     CHECK_ERROR(err)
 
-    bufferPermuteQK = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                     sizeof(float) * heightXwidth * heightXwidth,
-                                     nullptr, &err);
-    CHECK_ERROR(err)
+    if (!strided) {
+        bufferPermuteQ = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                                inputBytes,
+                                                nullptr, &err);
+        CHECK_ERROR(err);
+
+        bufferPermuteQK = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                                 sizeof(float) * heightXwidth * heightXwidth,
+                                                 nullptr, &err);
+        CHECK_ERROR(err)
+    }
 
     groupNorm->init();
-    err = groupNorm->forward(input, bufferNorm, num_events_in_list, event_wait_list, &events[0]);
+    {
+        Tracer::Scope scope("norm");
+        err = groupNorm->forward(input, bufferNorm, num_events_in_list, event_wait_list, &events[0]);
+    }
     CHECK_ERROR(err);
 
     to_q_conv2d->init();
-    err = to_q_conv2d->forward(bufferNorm, bufferQ, 1, &events[0], &events[1]);
+    {
+        Tracer::Scope scope("q");
+        err = to_q_conv2d->forward(bufferNorm, bufferQ, height, width, 1, &events[0], &events[1]);
+    }
     CHECK_ERROR(err);
 
     to_k_conv2d->init();
-    err = to_k_conv2d->forward(bufferNorm, bufferK, 1, &events[0], &events[2]);
+    {
+        Tracer::Scope scope("k");
+        err = to_k_conv2d->forward(bufferNorm, bufferK, height, width, 1, &events[0], &events[2]);
+    }
     CHECK_ERROR(err);
 
     to_v_conv2d->init();
-    err = to_v_conv2d->forward(bufferNorm, bufferV, 1, &events[0], &events[7]);
+    {
+        Tracer::Scope scope("v");
+        err = to_v_conv2d->forward(bufferNorm, bufferV, height, width, 1, &events[0], &events[7]);
+    }
     CHECK_ERROR(err);
 
-    err = clSetKernelArg(utilKernel->permute3D_0_2_1, 0, sizeof(cl_mem), &bufferQ);
-    err |= clSetKernelArg(utilKernel->permute3D_0_2_1, 1, sizeof(cl_mem), &bufferPermuteQ);
-    CHECK_ERROR(err);
+    if (!strided) {
+        err = record::clSetKernelArg(utilKernel->permute3D_0_2_1, 0, sizeof(cl_mem), &bufferQ);
+        err |= record::clSetKernelArg(utilKernel->permute3D_0_2_1, 1, sizeof(cl_mem), &bufferPermuteQ);
+        CHECK_ERROR(err);
 
-    size_t global_size[3] = {1, in_channels, heightXwidth};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_0_2_1, 3, nullptr,
-                                 global_size, nullptr, 1, &events[1], &events[3]);
-    CHECK_ERROR(err);
+        size_t global_size[3] = {1, in_channels, heightXwidth};
+        err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_0_2_1, 3, nullptr,
+                                             global_size, nullptr, 1, &events[1], &events[3]);
+        CHECK_ERROR(err);
+        Tracer::getInstance().record("permute3D_0_2_1", events[3]);
+    }
 
     float scale = 1.f / sqrtf(static_cast<float>(in_channels));
     /* naive - batch matmul
-    err = clSetKernelArg(utilKernel->batch_matmul, 0, sizeof(cl_mem), &bufferPermuteQ);
-    err |= clSetKernelArg(utilKernel->batch_matmul, 1, sizeof(cl_mem), &bufferK);
-    err |= clSetKernelArg(utilKernel->batch_matmul, 2, sizeof(cl_mem), &bufferQK);
-    err |= clSetKernelArg(utilKernel->batch_matmul, 3, sizeof(size_t), &in_channels);
-    err |= clSetKernelArg(utilKernel->batch_matmul, 4, sizeof(float), &scale);
+    err = record::clSetKernelArg(utilKernel->batch_matmul, 0, sizeof(cl_mem), &bufferPermuteQ);
+    err |= record::clSetKernelArg(utilKernel->batch_matmul, 1, sizeof(cl_mem), &bufferK);
+    err |= record::clSetKernelArg(utilKernel->batch_matmul, 2, sizeof(cl_mem), &bufferQK);
+    err |= record::clSetKernelArg(utilKernel->batch_matmul, 3, sizeof(size_t), &in_channels);
+    err |= record::clSetKernelArg(utilKernel->batch_matmul, 4, sizeof(float), &scale);
     CHECK_ERROR(err);
 
     size_t QKGlobalSize[3] = {1, heightXwidth, heightXwidth};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->batch_matmul, 3, nullptr,
-                                 QKGlobalSize, nullptr, 2, &events[2], &events[4]);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->batch_matmul, 3, nullptr,
+                                         QKGlobalSize, nullptr, 2, &events[2], &events[4]);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("batch_matmul", events[4]);
     naive - batch matmul */
 
     size_t tile_size = 128, reg_size = 8, tile_size_k = 16;
-    /* optimized batch matmul - Q x K */
-    if (heightXwidth % tile_size != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] heightXwidth(%ld) %% tile_size(%ld) != 0\n", __FILE__,
-                            __LINE__, heightXwidth, tile_size);
-        return CL_INVALID_VALUE;
+    /* tile 로 나누어 떨어지지 않는 해상도 (e.g. 40x40 latent) 는 naive batch matmul */
+    bool tiled = heightXwidth % tile_size == 0 && in_channels % tile_size == 0 &&
+                 in_channels % tile_size_k == 0;
+    int HW = static_cast<int>(heightXwidth);
+    /* (offset, batch stride, row stride, col stride) */
+    cl_int4 rowMajor = {{0, 0, HW, 1}};
+    cl_int4 transposed = {{0, 0, 1, HW}};
+    if (strided) {
+        /* QK (HW, HW) = Q^T (HW, C) x K (C, HW) */
+        cl_event qk[2] = {events[1], events[2]};
+        err = stridedMatmul(bufferQ, bufferK, bufferQK, heightXwidth, heightXwidth, in_channels,
+                            transposed, rowMajor, rowMajor, scale, 2, qk, &events[4]);
+        CHECK_ERROR(err);
+    } else if (!tiled) {
+        err = batchMatmul(bufferPermuteQ, bufferK, bufferQK, heightXwidth, heightXwidth,
+                          in_channels, scale, 2, &events[2], &events[4]);
+        CHECK_ERROR(err);
+    } else {
+        /* optimized batch matmul - Q x K */
+        err = record::clSetKernelArg(utilKernel->batch_matmul_scale, 0, sizeof(cl_mem), &bufferPermuteQ);
+        err |= record::clSetKernelArg(utilKernel->batch_matmul_scale, 1, sizeof(cl_mem), &bufferK);
+        err |= record::clSetKernelArg(utilKernel->batch_matmul_scale, 2, sizeof(cl_mem), &bufferQK);
+        err |= record::clSetKernelArg(utilKernel->batch_matmul_scale, 3, sizeof(size_t), &heightXwidth);
+        err |= record::clSetKernelArg(utilKernel->batch_matmul_scale, 4, sizeof(size_t), &heightXwidth);
+        err |= record::clSetKernelArg(utilKernel->batch_matmul_scale, 5, sizeof(size_t), &in_channels);
+        err |= record::clSetKernelArg(utilKernel->batch_matmul_scale, 6, sizeof(float), &scale);
+        CHECK_ERROR(err);
+
+        size_t QxKGlobalSize[3] = {1, heightXwidth/reg_size, heightXwidth/reg_size};
+        size_t QxKLocalSize[3] = {1, tile_size/reg_size, tile_size/reg_size};
+        err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->batch_matmul_scale, 3, nullptr,
+                                             QxKGlobalSize, QxKLocalSize, 2, &events[2], &events[4]);
+        CHECK_ERROR(err);
+        Tracer::getInstance().record("batch_matmul_scale", events[4]);
+        /* optimized batch matmul - Q x K */
     }
-    if (in_channels % tile_size_k != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] in_channels(%ld) %% tile_size(16) != 0\n", __FILE__,
-                            __LINE__, in_channels);
-        return CL_INVALID_VALUE;
+
+    auto softmax = SOFTMAX_KERNEL_VERSION == 1 ? utilKernel->softmax_online : utilKernel->softmax;
+    err = record::clSetKernelArg(softmax, 0, sizeof(cl_mem), &bufferQK);
+    err |= record::clSetKernelArg(softmax, 1, sizeof(cl_mem), &bufferQK);
+    err |= record::clSetKernelArg(softmax, 2, sizeof(float) * WORK_GROUP_SIZE, nullptr);
+    if (SOFTMAX_KERNEL_VERSION == 1) {
+        /* row (heightXwidth) 가 local memory 보다 커도 됨 */
+        int rowSize = static_cast<int>(heightXwidth);
+        err |= record::clSetKernelArg(softmax, 3, sizeof(float) * WORK_GROUP_SIZE, nullptr);
+        err |= record::clSetKernelArg(softmax, 4, sizeof(int), &rowSize);
+    } else {
+        err |= record::clSetKernelArg(softmax, 3, sizeof(float) * heightXwidth, nullptr);
+        err |= record::clSetKernelArg(softmax, 4, sizeof(size_t), &heightXwidth);
     }
-    err = clSetKernelArg(utilKernel->batch_matmul_scale, 0, sizeof(cl_mem), &bufferPermuteQ);
-    err |= clSetKernelArg(utilKernel->batch_matmul_scale, 1, sizeof(cl_mem), &bufferK);
-    err |= clSetKernelArg(utilKernel->batch_matmul_scale, 2, sizeof(cl_mem), &bufferQK);
-    err |= clSetKernelArg(utilKernel->batch_matmul_scale, 3, sizeof(size_t), &heightXwidth);
-    err |= clSetKernelArg(utilKernel->batch_matmul_scale, 4, sizeof(size_t), &heightXwidth);
-    err |= clSetKernelArg(utilKernel->batch_matmul_scale, 5, sizeof(size_t), &in_channels);
-    err |= clSetKernelArg(utilKernel->batch_matmul_scale, 6, sizeof(float), &scale);
     CHECK_ERROR(err);
 
-    size_t QxKGlobalSize[3] = {1, heightXwidth/reg_size, heightXwidth/reg_size};
-    size_t QxKLocalSize[3] = {1, tile_size/reg_size, tile_size/reg_size};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->batch_matmul_scale, 3, nullptr,
-                                 QxKGlobalSize, QxKLocalSize, 2, &events[2], &events[4]);
+    size_t softmaxGlobalSize[1] = {heightXwidth * WORK_GROUP_SIZE};
+    size_t softmaxLocalSize[1] = {WORK_GROUP_SIZE};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, softmax, 1, nullptr,
+                                         softmaxGlobalSize, softmaxLocalSize, 1, &events[4], &events[5]);
     CHECK_ERROR(err);
-    /* optimized batch matmul - Q x K */
+    Tracer::getInstance().record(SOFTMAX_KERNEL_VERSION == 1 ? "softmax_online" : "softmax",
+                                 events[5]);
+
+    if (!strided) {
+        err = record::clSetKernelArg(utilKernel->permute3D_0_2_1, 0, sizeof(cl_mem), &bufferQK);
+        err |= record::clSetKernelArg(utilKernel->permute3D_0_2_1, 1, sizeof(cl_mem), &bufferPermuteQK);
+        CHECK_ERROR(err);
+
+        size_t QKGlobalSize[3] = {1, heightXwidth, heightXwidth};
+        err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_0_2_1, 3, nullptr,
+                                             QKGlobalSize, nullptr, 1, &events[5], &events[6]);
+        CHECK_ERROR(err);
+        Tracer::getInstance().record("permute3D_0_2_1", events[6]);
+    }
 
-    err = clSetKernelArg(utilKernel->softmax, 0, sizeof(cl_mem), &bufferQK);
-    err |= clSetKernelArg(utilKernel->softmax, 1, sizeof(cl_mem), &bufferQK);
-    err |= clSetKernelArg(utilKernel->softmax, 2, sizeof(float) * WORK_GROUP_SIZE, nullptr);
-    err |= clSetKernelArg(utilKernel->softmax, 3, sizeof(float) * heightXwidth, nullptr);
-    err |= clSetKernelArg(utilKernel->softmax, 4, sizeof(size_t), &heightXwidth);
+    float identity = 1.f;
+    /* naive batch matmul - V x QK
+    err = record::clSetKernelArg(utilKernel->batch_matmul, 0, sizeof(cl_mem), &bufferV);
+    err |= record::clSetKernelArg(utilKernel->batch_matmul, 1, sizeof(cl_mem), &bufferPermuteQK);
+    err |= record::clSetKernelArg(utilKernel->batch_matmul, 2, sizeof(cl_mem), &bufferQ);
+    err |= record::clSetKernelArg(utilKernel->batch_matmul, 3, sizeof(size_t), &heightXwidth);
+    err |= record::clSetKernelArg(utilKernel->batch_matmul, 4, sizeof(float), &identity);
     CHECK_ERROR(err);
 
-    size_t softmaxGlobalSize[1] = {heightXwidth * WORK_GROUP_SIZE};
-    size_t softmaxLocalSize[1] = {WORK_GROUP_SIZE};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->softmax, 1, nullptr,
-                                 softmaxGlobalSize, softmaxLocalSize, 1, &events[4], &events[5]);
+    size_t VQKGlobalSize[3] = {1, in_channels, heightXwidth};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->batch_matmul, 3, nullptr,
+                                         VQKGlobalSize, nullptr, 2, &events[6], &events[8]);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("batch_matmul", events[8]);
+    naive batch matmul - V x QK */
 
-    err = clSetKernelArg(utilKernel->permute3D_0_2_1, 0, sizeof(cl_mem), &bufferQK);
-    err |= clSetKernelArg(utilKernel->permute3D_0_2_1, 1, sizeof(cl_mem), &bufferPermuteQK);
+    if (strided) {
+        /* out (C, HW) = V (C, HW) x softmax(QK)^T (HW, HW) */
+        cl_event vqk[2] = {events[5], events[7]};
+        err = stridedMatmul(bufferV, bufferQK, bufferQ, in_channels, heightXwidth, heightXwidth,
+                            rowMajor, transposed, rowMajor, identity, 2, vqk, &events[8]);
+        CHECK_ERROR(err);
+    } else if (!tiled) {
+        err = batchMatmul(bufferV, bufferPermuteQK, bufferQ, in_channels, heightXwidth,
+                          heightXwidth, identity, 2, &events[6], &events[8]);
+        CHECK_ERROR(err);
+    } else {
+        /* optimized batch matmul - V x QK*/
+        err = record::clSetKernelArg(utilKernel->batch_matmul_scale, 0, sizeof(cl_mem), &bufferV);
+        err |= record::clSetKernelArg(utilKernel->batch_matmul_scale, 1, sizeof(cl_mem), &bufferPermuteQK);
+        err |= record::clSetKernelArg(utilKernel->batch_matmul_scale, 2, sizeof(cl_mem), &bufferQ);
+        err |= record::clSetKernelArg(utilKernel->batch_matmul_scale, 3, sizeof(size_t), &in_channels);
+        err |= record::clSetKernelArg(utilKernel->batch_matmul_scale, 4, sizeof(size_t), &heightXwidth);
+        err |= record::clSetKernelArg(utilKernel->batch_matmul_scale, 5, sizeof(size_t), &heightXwidth);
+        err |= record::clSetKernelArg(utilKernel->batch_matmul_scale, 6, sizeof(float), &identity);
+        CHECK_ERROR(err);
+
+        size_t VQKGlobalSize[3] = {1, in_channels/reg_size, heightXwidth/reg_size};
+        size_t VQKLocalSize[3] = {1, tile_size/reg_size, tile_size/reg_size};
+        err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->batch_matmul_scale, 3, nullptr,
+                                             VQKGlobalSize, VQKLocalSize, 2, &events[6], &events[8]);
+        CHECK_ERROR(err);
+        Tracer::getInstance().record("batch_matmul_scale", events[8]);
+        /*optimized batch matmul - V x QK */
+    }
+
+    out_conv2d->init();
+    {
+        Tracer::Scope scope("proj_out");
+        err = out_conv2d->forward(bufferQ, bufferK, height, width, 1, &events[8], &events[9]);
+    }
     CHECK_ERROR(err);
 
-    size_t QKGlobalSize[3] = {1, heightXwidth, heightXwidth};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_0_2_1, 3, nullptr,
-                                 QKGlobalSize, nullptr, 1, &events[5], &events[6]);
+    err = record::clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &bufferK);
+    err |= record::clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &output);
     CHECK_ERROR(err);
 
-    float identity = 1.f;
-    /* naive batch matmul - V x QK
-    err = clSetKernelArg(utilKernel->batch_matmul, 0, sizeof(cl_mem), &bufferV);
-    err |= clSetKernelArg(utilKernel->batch_matmul, 1, sizeof(cl_mem), &bufferPermuteQK);
-    err |= clSetKernelArg(utilKernel->batch_matmul, 2, sizeof(cl_mem), &bufferQ);
-    err |= clSetKernelArg(utilKernel->batch_matmul, 3, sizeof(size_t), &heightXwidth);
-    err |= clSetKernelArg(utilKernel->batch_matmul, 4, sizeof(float), &identity);
+    size_t elemAddGlobalSize[1] = {inputBytes / sizeof(float)};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr,
+                                         elemAddGlobalSize, nullptr, 1, &events[9], event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("elemwise_add", *event);
+
+    record::clReleaseMemObject(bufferNorm);
+    record::clReleaseMemObject(bufferQ);
+    record::clReleaseMemObject(bufferK);
+    record::clReleaseMemObject(bufferV);
+    record::clReleaseMemObject(bufferQK);
+    if (!strided) {
+        record::clReleaseMemObject(bufferPermuteQ);
+        record::clReleaseMemObject(bufferPermuteQK);
+    }
+    for (auto &e: events) {
+        if (e != nullptr) {
+            clReleaseEvent(e);
+        }
+    }
 
-    size_t VQKGlobalSize[3] = {1, in_channels, heightXwidth};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->batch_matmul, 3, nullptr,
-                                 VQKGlobalSize, nullptr, 2, &events[6], &events[8]);
+    return CL_SUCCESS;
+}
+
+/* C (M, N) = A (M, K) x B (K, N) * scale (tile 크기 제약 없음) */
+cl_int AttnBlock::batchMatmul(cl_mem A, cl_mem B, cl_mem C, size_t M, size_t N, size_t K,
+                              float scale, cl_uint num_events_in_list,
+                              const cl_event *event_wait_list, cl_event *event) {
+    cl_int err;
+    err = record::clSetKernelArg(utilKernel->batch_matmul, 0, sizeof(cl_mem), &A);
+    err |= record::clSetKernelArg(utilKernel->batch_matmul, 1, sizeof(cl_mem), &B);
+    err |= record::clSetKernelArg(utilKernel->batch_matmul, 2, sizeof(cl_mem), &C);
+    err |= record::clSetKernelArg(utilKernel->batch_matmul, 3, sizeof(size_t), &K);
+    err |= record::clSetKernelArg(utilKernel->batch_matmul, 4, sizeof(float), &scale);
     CHECK_ERROR(err);
-    naive batch matmul - V x QK */
 
-    /* optimized batch matmul - V x QK*/
-    if (heightXwidth % tile_size != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] heightXwidth(%ld) %% tile_size(%ld) != 0\n", __FILE__,
-                            __LINE__, heightXwidth, tile_size);
-        return CL_INVALID_VALUE;
+    size_t globalSize[3] = {1, M, N};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->batch_matmul, 3, nullptr,
+                                         globalSize, nullptr, num_events_in_list,
+                                         event_wait_list, event);
+    CHECK_ERROR(err);
+    Tracer::getInstance().record("batch_matmul", *event);
+    return CL_SUCCESS;
+}
+
+/* C (M, N) = A (M, K) x B (K, N) * scale. layout : (offset, batch stride, row stride, col stride) */
+cl_int AttnBlock::stridedMatmul(cl_mem A, cl_mem B, cl_mem C, size_t M, size_t N, size_t K,
+                                cl_int4 layoutA, cl_int4 layoutB, cl_int4 layoutC, float scale,
+                                cl_uint num_events_in_list, const cl_event *event_wait_list,
+                                cl_event *event) {
+    /* util.cl STRIDED_TILE_M, STRIDED_TILE_N, STRIDED_REG_M, STRIDED_REG_N */
+    const size_t tileM = 64, tileN = 64, regM = 4, regN = 4;
+    int m = static_cast<int>(M), n = static_cast<int>(N), k = static_cast<int>(K);
+
+    cl_int err;
+    auto kernel = utilKernel->strided_batch_matmul;
+    err = record::clSetKernelArg(kernel, 0, sizeof(cl_mem), &A);
+    err |= record::clSetKernelArg(kernel, 1, sizeof(cl_mem), &B);
+    err |= record::clSetKernelArg(kernel, 2, sizeof(cl_mem), &C);
+    err |= record::clSetKernelArg(kernel, 3, sizeof(int), &m);
+    err |= record::clSetKernelArg(kernel, 4, sizeof(int), &n);
+    err |= record::clSetKernelArg(kernel, 5, sizeof(int), &k);
+    err |= record::clSetKernelArg(kernel, 6, sizeof(cl_int4), &layoutA);
+    err |= record::clSetKernelArg(kernel, 7, sizeof(cl_int4), &layoutB);
+    err |= record::clSetKernelArg(kernel, 8, sizeof(cl_int4), &layoutC);
+    err |= record::clSetKernelArg(kernel, 9, sizeof(float), &scale);
+    CHECK_ERROR(err);
+
+    size_t globalSize[3] = {1, (M + tileM - 1) / tileM * (tileM / regM),
+                            (N + tileN - 1) / tileN * (tileN / regN)};
+    size_t localSize[3] = {1, tileM / regM, tileN / regN};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel, 3, nullptr, globalSize, localSize,
+                                         num_events_in_list, event_wait_list, event);
+    CHECK_ERROR(err);
+    Tracer::getInstance().record("strided_batch_matmul", *event);
+    return CL_SUCCESS;
+}
+
+/* (C, HW) 를 (HW, C) 로 transpose 해서 single head attention */
+cl_int AttnBlock::forwardCpu(cl_mem input, cl_mem output, size_t height, size_t width,
+                             cl_uint num_events_in_list, const cl_event *event_wait_list,
+                             cl_event *event) {
+    cl_int err;
+    cl_event events[6];
+    cl_mem bufferNorm, bufferQ, bufferK, bufferV;
+
+    size_t inputBytes;
+    err = clGetMemObjectInfo(input, CL_MEM_SIZE, sizeof(size_t), &inputBytes, nullptr);
+    CHECK_ERROR(err);
+
+    size_t heightXwidth = height * width;
+
+    bufferNorm = record::clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes, nullptr, &err);
+    CHECK_ERROR(err);
+    bufferQ = record::clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes, nullptr, &err);
+    CHECK_ERROR(err);
+    bufferK = record::clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes, nullptr, &err);
+    CHECK_ERROR(err);
+    bufferV = record::clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes, nullptr, &err);
+    CHECK_ERROR(err);
+
+    groupNorm->init();
+    {
+        Tracer::Scope scope("norm");
+        err = groupNorm->forward(input, bufferNorm, num_events_in_list, event_wait_list, &events[0]);
     }
-    if (in_channels % tile_size != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] in_channels(%ld) %% tile_size(%ld) != 0\n", __FILE__,
-                            __LINE__, in_channels, tile_size);
-        return CL_INVALID_VALUE;
+    CHECK_ERROR(err);
+
+    to_q_conv2d->init();
+    {
+        Tracer::Scope scope("q");
+        err = to_q_conv2d->forward(bufferNorm, bufferQ, height, width, 1, &events[0], &events[1]);
     }
-    if (heightXwidth % tile_size_k != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] heightXwidth(%ld) %% tile_size_k(%ld) != 0\n", __FILE__,
-                            __LINE__, heightXwidth, tile_size_k);
-        return CL_INVALID_VALUE;
+    CHECK_ERROR(err);
+
+    to_k_conv2d->init();
+    {
+        Tracer::Scope scope("k");
+        err = to_k_conv2d->forward(bufferNorm, bufferK, height, width, 1, &events[0], &events[2]);
     }
-    err = clSetKernelArg(utilKernel->batch_matmul_scale, 0, sizeof(cl_mem), &bufferV);
-    err |= clSetKernelArg(utilKernel->batch_matmul_scale, 1, sizeof(cl_mem), &bufferPermuteQK);
-    err |= clSetKernelArg(utilKernel->batch_matmul_scale, 2, sizeof(cl_mem), &bufferQ);
-    err |= clSetKernelArg(utilKernel->batch_matmul_scale, 3, sizeof(size_t), &in_channels);
-    err |= clSetKernelArg(utilKernel->batch_matmul_scale, 4, sizeof(size_t), &heightXwidth);
-    err |= clSetKernelArg(utilKernel->batch_matmul_scale, 5, sizeof(size_t), &heightXwidth);
-    err |= clSetKernelArg(utilKernel->batch_matmul_scale, 6, sizeof(float), &identity);
     CHECK_ERROR(err);
 
-    size_t VQKGlobalSize[3] = {1, in_channels/reg_size, heightXwidth/reg_size};
-    size_t VQKLocalSize[3] = {1, tile_size/reg_size, tile_size/reg_size};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->batch_matmul_scale, 3, nullptr,
-                                 VQKGlobalSize, VQKLocalSize, 2, &events[6], &events[8]);
+    to_v_conv2d->init();
+    {
+        Tracer::Scope scope("v");
+        err = to_v_conv2d->forward(bufferNorm, bufferV, height, width, 1, &events[0], &events[3]);
+    }
     CHECK_ERROR(err);
-    /*optimized batch matmul - V x QK */
+
+    {
+        Tracer::HostSpan span("cpu_attention");
+        CpuBackend::Mapping mapping(cmdQueue, 3, &events[1]);
+        auto q = mapping.map(bufferQ, &err);
+        CHECK_ERROR(err);
+        auto k = mapping.mapRead(bufferK, &err);
+        CHECK_ERROR(err);
+        auto v = mapping.mapRead(bufferV, &err);
+        CHECK_ERROR(err);
+
+        auto size = in_channels * heightXwidth;
+        std::vector<float> permuteQ(size), permuteK(size), permuteV(size), permuteOut(size);
+        cpu::transpose(q, permuteQ.data(), in_channels, heightXwidth);
+        cpu::transpose(k, permuteK.data(), in_channels, heightXwidth);
+        cpu::transpose(v, permuteV.data(), in_channels, heightXwidth);
+        cpu::attention(permuteQ.data(), in_channels, permuteK.data(), in_channels,
+                       permuteV.data(), in_channels, permuteOut.data(), in_channels, 1,
+                       heightXwidth, heightXwidth, in_channels,
+                       1.f / sqrtf(static_cast<float>(in_channels)), nullptr);
+        /* attention 결과는 bufferQ 에 */
+        cpu::transpose(permuteOut.data(), q, heightXwidth, in_channels);
+
+        err = mapping.unmap(&events[4]);
+        CHECK_ERROR(err);
+    }
 
     out_conv2d->init();
-    err = out_conv2d->forward(bufferQ, bufferK, 1, &events[8], &events[9]);
+    {
+        Tracer::Scope scope("proj_out");
+        err = out_conv2d->forward(bufferQ, bufferK, height, width, 1, &events[4], &events[5]);
+    }
     CHECK_ERROR(err);
 
-    err = clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &bufferK);
-    err |= clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &output);
-    CHECK_ERROR(err);
+    {
+        Tracer::HostSpan span("cpu_elemwise_add");
+        CpuBackend::Mapping mapping(cmdQueue, 1, &events[5]);
+        auto out = mapping.map(output, &err);
+        CHECK_ERROR(err);
+        auto in = mapping.mapRead(input, &err);
+        CHECK_ERROR(err);
+        auto proj = mapping.mapRead(bufferK, &err);
+        CHECK_ERROR(err);
 
-    size_t elemAddGlobalSize[1] = {inputBytes / sizeof(float)};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr,
-                                 elemAddGlobalSize, nullptr, 1, &events[9], event);
-    CHECK_ERROR(err);
+        cpu::add(proj, in, out, inputBytes / sizeof(float));
 
-    clReleaseMemObject(bufferNorm);
-    clReleaseMemObject(bufferQ);
-    clReleaseMemObject(bufferK);
-    clReleaseMemObject(bufferV);
-    clReleaseMemObject(bufferPermuteQ);
-    clReleaseMemObject(bufferQK);
-    clReleaseMemObject(bufferPermuteQK);
+        err = mapping.unmap(event);
+        CHECK_ERROR(err);
+    }
+
+    record::clReleaseMemObject(bufferNorm);
+    record::clReleaseMemObject(bufferQ);
+    record::clReleaseMemObject(bufferK);
+    record::clReleaseMemObject(bufferV);
     for (auto &e: events) {
         clReleaseEvent(e);
     }
 
     return CL_SUCCESS;
-}
\ No newline at end of file
+}
@@ -33,12 +33,28 @@ public:
 
     ~AttnBlock();
 
-    cl_int forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
-                   const cl_event *event_wait_list, cl_event *event);
+    /* `input`: (in_channels, height, width) */
+    cl_int forward(cl_mem input, cl_mem output, size_t height, size_t width,
+                   cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event);
 
     void init();
 
 private:
+    /* CpuBackend::isEnabled() */
+    cl_int forwardCpu(cl_mem input, cl_mem output, size_t height, size_t width,
+                      cl_uint num_events_in_list, const cl_event *event_wait_list,
+                      cl_event *event);
+
+    cl_int batchMatmul(cl_mem A, cl_mem B, cl_mem C, size_t M, size_t N, size_t K, float scale,
+                       cl_uint num_events_in_list, const cl_event *event_wait_list,
+                       cl_event *event);
+
+    /* ATTN_BLOCK_KERNEL_VERSION 1. strided_batch_matmul (transpose 를 stride 로) */
+    cl_int stridedMatmul(cl_mem A, cl_mem B, cl_mem C, size_t M, size_t N, size_t K,
+                         cl_int4 layoutA, cl_int4 layoutB, cl_int4 layoutC, float scale,
+                         cl_uint num_events_in_list, const cl_event *event_wait_list,
+                         cl_event *event);
+
     cl_command_queue cmdQueue;
     cl_context context;
     size_t in_channels;
@@ -6,6 +6,8 @@
 
 #include <android/log.h>
 #include "../util.h"
+#include "../Tracer.h"
+#include "../CommandRecorder.h"
 
 #define LOG_TAG "BASIC_TRANSFORMER_BLOCK"
 
@@ -107,74 +109,95 @@ cl_int BasicTransformerBlock::forward(cl_mem input, cl_mem condition, cl_mem out
 
     size_t inputSize = inputBytes / sizeof(float);
 
-    bufferNorm = clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes, nullptr, &err);
+    bufferNorm = record::clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes, nullptr, &err);
     CHECK_ERROR(err);
 
-    bufferNorm2 = clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes, nullptr, &err);
+    bufferNorm2 = record::clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes, nullptr, &err);
     CHECK_ERROR(err);
 
-    err = layerNorm1->forward(input, bufferNorm, num_events_in_list, event_wait_list, &event0);
+    {
+        Tracer::Scope scope("norm1");
+        err = layerNorm1->forward(input, bufferNorm, num_events_in_list, event_wait_list, &event0);
+    }
     CHECK_ERROR(err);
 
     // max diff: 0.00000542029738426208
     // util::testBuffer(cmdQueue, bufferNorm, "unet/input_block/test/test_basic_norm1.npy");
 
-    err = crossAttention1->forward(bufferNorm, nullptr, bufferNorm,
-                                   1, &event0, &event1);
+    {
+        Tracer::Scope scope("attn1");
+        err = crossAttention1->forward(bufferNorm, nullptr, bufferNorm,
+                                       1, &event0, &event1);
+    }
     CHECK_ERROR(err);
 
-    err = clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &bufferNorm);
-    err |= clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &bufferNorm);
+    err = record::clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &bufferNorm);
+    err |= record::clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &bufferNorm);
     CHECK_ERROR(err);
 
     size_t globalSize[1] = {inputSize};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr, globalSize, nullptr,
-                                 1, &event1, &event2);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr, globalSize, nullptr,
+                                         1, &event1, &event2);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("elemwise_add", event2);
 
-    err = layerNorm2->forward(bufferNorm, bufferNorm2, 1, &event2, &event3);
+    {
+        Tracer::Scope scope("norm2");
+        err = layerNorm2->forward(bufferNorm, bufferNorm2, 1, &event2, &event3);
+    }
     CHECK_ERROR(err);
 
     // max diff: 0.00000345706939697266
     // util::testBuffer(cmdQueue, bufferNorm2, "unet/input_block/test/test_basic_norm2.npy");
 
-    err = crossAttention2->forward(bufferNorm2, condition, bufferNorm2,
-                                   1, &event3, &event4);
+    {
+        Tracer::Scope scope("attn2");
+        err = crossAttention2->forward(bufferNorm2, condition, bufferNorm2,
+                                       1, &event3, &event4);
+    }
     CHECK_ERROR(err);
 
     // max diff: 0.00000175833702087402
     // util::testBuffer(cmdQueue, bufferNorm2, "unet/input_block/test/test_basic_attn2.npy");
 
-    err = clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &bufferNorm2);
-    err |= clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &bufferNorm);
-    err |= clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &bufferNorm2);
+    err = record::clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &bufferNorm2);
+    err |= record::clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &bufferNorm);
+    err |= record::clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &bufferNorm2);
     CHECK_ERROR(err);
 
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr, globalSize, nullptr,
-                                 1, &event4, &event5);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr, globalSize, nullptr,
+                                         1, &event4, &event5);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("elemwise_add", event5);
 
-    err = layerNorm3->forward(bufferNorm2, bufferNorm, 1, &event5, &event6);
+    {
+        Tracer::Scope scope("norm3");
+        err = layerNorm3->forward(bufferNorm2, bufferNorm, 1, &event5, &event6);
+    }
     CHECK_ERROR(err);
 
     // max diff: 0.00000476837158203125
     // util::testBuffer(cmdQueue, bufferNorm, "unet/input_block/test/test_basic_norm_3.npy");
 
-    err = feedForward->forward(bufferNorm, bufferNorm, 1, &event6, &event7);
+    {
+        Tracer::Scope scope("ff");
+        err = feedForward->forward(bufferNorm, bufferNorm, 1, &event6, &event7);
+    }
     CHECK_ERROR(err);
 
     // max diff: 0.00000560283660888672
     // util::testBuffer(cmdQueue, bufferNorm, "unet/input_block/test/test_basic_ff.npy");
 
-    err = clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &bufferNorm);
-    err |= clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &bufferNorm2);
-    err |= clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &output);
+    err = record::clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &bufferNorm);
+    err |= record::clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &bufferNorm2);
+    err |= record::clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &output);
     CHECK_ERROR(err);
 
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr, globalSize, nullptr,
-                                 1, &event7, event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr, globalSize, nullptr,
+                                         1, &event7, event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("elemwise_add", *event);
 
     // max diff: 0.00000572204589843750
     // util::testBuffer(cmdQueue, output, "unet/input_block/test/test_basic.npy");
@@ -187,8 +210,8 @@ cl_int BasicTransformerBlock::forward(cl_mem input, cl_mem condition, cl_mem out
     clReleaseEvent(event5);
     clReleaseEvent(event6);
     clReleaseEvent(event7);
-    clReleaseMemObject(bufferNorm);
-    clReleaseMemObject(bufferNorm2);
+    record::clReleaseMemObject(bufferNorm);
+    record::clReleaseMemObject(bufferNorm2);
 
     return CL_SUCCESS;
 }
\ No newline at end of file
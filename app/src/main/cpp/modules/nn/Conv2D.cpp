@@ -5,7 +5,12 @@
 #include "Conv2D.h"
 #include <android/log.h>
 #include "../util.h"
+#include "../Tracer.h"
+#include "../CommandRecorder.h"
 #include "../setting.h"
+#include "../KernelSelector.h"
+#include "../cpu/CpuBackend.h"
+#include "../cpu/CpuKernel.h"
 
 #define DEBUG 0
 #define LOG_TAG "CONV2D"
@@ -26,6 +31,18 @@
 
 static int count = 0;
 
+const std::map<int, Conv2D::Strategy> Conv2D::strategies = {
+        {0, &Conv2D::matmulVersion0},
+        {1, &Conv2D::matmulVersion1},
+        {2, &Conv2D::matmulVersion2},
+        {3, &Conv2D::matmulVersion3},
+        {4, &Conv2D::matmulVersion4},
+        {5, &Conv2D::matmulVersion5},
+        {6, &Conv2D::matmulVersion6},
+        {7, &Conv2D::matmulVersion7},
+        {8, &Conv2D::matmulVersion8},
+};
+
 Conv2D::Conv2D(
         cl_context context,
         cl_command_queue cmdQueue,
@@ -72,14 +89,10 @@ void Conv2D::init() {
     }
 }
 
-/*
- * Assume square shaped `input` where height = width.
- */
-cl_int Conv2D::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
-                       const cl_event *event_wait_list, cl_event *event) {
+cl_int Conv2D::forward(cl_mem input, cl_mem output, size_t height, size_t width,
+                       cl_uint num_events_in_list, const cl_event *event_wait_list,
+                       cl_event *event) {
     cl_int err;
-    cl_mem bufferCol, bufferWin;
-    cl_event _event[1];
 
     if (input == output) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Conv2D not support input == output");
@@ -90,36 +103,39 @@ cl_int Conv2D::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
     err = clGetMemObjectInfo(input, CL_MEM_SIZE, sizeof(size_t), &inputBytes, nullptr);
     CHECK_ERROR(err);
 
-    auto inputSize = inputBytes / sizeof(float);
-    inputSize /= weightShape[1];
-    inputSize = static_cast<size_t>(sqrt(static_cast<float>(inputSize)));
-
-    if (inputSize * inputSize * weightShape[1] != inputBytes / sizeof(float)) {
+    if (height * width * weightShape[1] != inputBytes / sizeof(float)) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "Conv2D inputSize * inputSize * weightShape[1] != inputBytes / sizeof(float)");
+                            "Conv2D height(%ld) * width(%ld) * weightShape[1] != inputBytes / sizeof(float)",
+                            height, width);
         throw std::runtime_error(
-                "Conv2D inputSize * inputSize * weightShape[1] != inputBytes / sizeof(float)");
+                "Conv2D height * width * weightShape[1] != inputBytes / sizeof(float)");
     }
 
-    auto outputSize = getOutputSize(inputSize);
+    auto outputHeight = getOutputSize(height);
+    auto outputWidth = getOutputSize(width);
+    if (CpuBackend::isEnabled()) {
+        return forwardCpu(input, output, height, width, outputHeight, outputWidth,
+                          num_events_in_list, event_wait_list, event);
+    }
 
     /* naive */
     /*
-    err = clSetKernelArg(kernel->conv2d, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->conv2d, 1, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->conv2d, 2, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->conv2d, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->conv2d, 4, sizeof(int), &inputSize);
-    err |= clSetKernelArg(kernel->conv2d, 5, sizeof(int), &weightShape[1]);
-    err |= clSetKernelArg(kernel->conv2d, 6, sizeof(int), &weightShape[2]);
-    err |= clSetKernelArg(kernel->conv2d, 7, sizeof(int), &stride);
-    err |= clSetKernelArg(kernel->conv2d, 8, sizeof(int), &padding);
+    err = record::clSetKernelArg(kernel->conv2d, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->conv2d, 1, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->conv2d, 2, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->conv2d, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->conv2d, 4, sizeof(int), &inputSize);
+    err |= record::clSetKernelArg(kernel->conv2d, 5, sizeof(int), &weightShape[1]);
+    err |= record::clSetKernelArg(kernel->conv2d, 6, sizeof(int), &weightShape[2]);
+    err |= record::clSetKernelArg(kernel->conv2d, 7, sizeof(int), &stride);
+    err |= record::clSetKernelArg(kernel->conv2d, 8, sizeof(int), &padding);
     CHECK_ERROR(err);
 
     size_t globalSize[3] = {weightShape[0], outputSize, outputSize};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->conv2d, 3, nullptr, globalSize, nullptr,
-                                 num_events_in_list, event_wait_list, event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->conv2d, 3, nullptr, globalSize, nullptr,
+                                         num_events_in_list, event_wait_list, event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("conv2d", *event);
     */
     /* naive */
 
@@ -127,157 +143,413 @@ cl_int Conv2D::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
     /*
     size_t kernel_size = weightShape[2];
     size_t in_channel = weightShape[1];
-    bufferCol = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                               sizeof(float) * (in_channel * kernel_size * kernel_size) *
-                               (outputSize * outputSize),
-                               nullptr, &err);
+    bufferCol = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                       sizeof(float) * (in_channel * kernel_size * kernel_size) *
+                                       (outputSize * outputSize),
+                                       nullptr, &err);
     CHECK_ERROR(err);
 
     size_t num_kernels = in_channel * outputSize * outputSize;
     int im_offset = 0;
     int col_offset = 0;
-    err = clSetKernelArg(kernel->im2col, 0, sizeof(int), &num_kernels);
-    err |= clSetKernelArg(kernel->im2col, 1, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->im2col, 2, sizeof(int), &im_offset);
-    err |= clSetKernelArg(kernel->im2col, 3, sizeof(int), &inputSize);
-    err |= clSetKernelArg(kernel->im2col, 4, sizeof(int), &inputSize);
-    err |= clSetKernelArg(kernel->im2col, 5, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2col, 6, sizeof(int), &padding);
-    err |= clSetKernelArg(kernel->im2col, 7, sizeof(int), &stride);
-    err |= clSetKernelArg(kernel->im2col, 8, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2col, 9, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2col, 10, sizeof(cl_mem), &bufferCol);
-    err |= clSetKernelArg(kernel->im2col, 11, sizeof(int), &col_offset);
+    err = record::clSetKernelArg(kernel->im2col, 0, sizeof(int), &num_kernels);
+    err |= record::clSetKernelArg(kernel->im2col, 1, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->im2col, 2, sizeof(int), &im_offset);
+    err |= record::clSetKernelArg(kernel->im2col, 3, sizeof(int), &inputSize);
+    err |= record::clSetKernelArg(kernel->im2col, 4, sizeof(int), &inputSize);
+    err |= record::clSetKernelArg(kernel->im2col, 5, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(kernel->im2col, 6, sizeof(int), &padding);
+    err |= record::clSetKernelArg(kernel->im2col, 7, sizeof(int), &stride);
+    err |= record::clSetKernelArg(kernel->im2col, 8, sizeof(int), &outputSize);
+    err |= record::clSetKernelArg(kernel->im2col, 9, sizeof(int), &outputSize);
+    err |= record::clSetKernelArg(kernel->im2col, 10, sizeof(cl_mem), &bufferCol);
+    err |= record::clSetKernelArg(kernel->im2col, 11, sizeof(int), &col_offset);
     CHECK_ERROR(err);
 
     size_t globalSize_im2col[1] = {num_kernels};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2col, 1, nullptr, globalSize_im2col, nullptr,
-                                 num_events_in_list, event_wait_list, &_event[0]);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->im2col, 1, nullptr, globalSize_im2col, nullptr,
+                                         num_events_in_list, event_wait_list, &_event[0]);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("im2col", _event[0]);
 
     size_t out_channel = weightShape[0];
     size_t N = outputSize * outputSize;
     size_t K = in_channel * kernel_size * kernel_size;
 
-    err = clSetKernelArg(kernel->conv2d_matmul, 0, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->conv2d_matmul, 1, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->conv2d_matmul, 2, sizeof(cl_mem), &bufferCol);
-    err |= clSetKernelArg(kernel->conv2d_matmul, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->conv2d_matmul, 4, sizeof(int), &out_channel);
-    err |= clSetKernelArg(kernel->conv2d_matmul, 5, sizeof(int), &N);
-    err |= clSetKernelArg(kernel->conv2d_matmul, 6, sizeof(int), &K);
+    err = record::clSetKernelArg(kernel->conv2d_matmul, 0, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->conv2d_matmul, 1, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->conv2d_matmul, 2, sizeof(cl_mem), &bufferCol);
+    err |= record::clSetKernelArg(kernel->conv2d_matmul, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->conv2d_matmul, 4, sizeof(int), &out_channel);
+    err |= record::clSetKernelArg(kernel->conv2d_matmul, 5, sizeof(int), &N);
+    err |= record::clSetKernelArg(kernel->conv2d_matmul, 6, sizeof(int), &K);
     CHECK_ERROR(err);
 
     size_t globalSize_conv2d_matmul[1] = {out_channel * N};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->conv2d_matmul, 1, nullptr,
-                                 globalSize_conv2d_matmul, nullptr,
-                                 1, &_event[0], event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->conv2d_matmul, 1, nullptr,
+                                         globalSize_conv2d_matmul, nullptr,
+                                         1, &_event[0], event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("conv2d_matmul", *event);
 
-    clReleaseMemObject(bufferCol);
+    record::clReleaseMemObject(bufferCol);
     */
     /* im2col version */
 
+    bool configured;
+    auto version = KernelSelector::getInstance().select(KernelSelector::CONV_2D, weight_name,
+                                                        CONV_2D_KERNEL_VERSION, &configured);
+
+    if (version == 9) {
+        err = forwardImplicitGemm(input, output, height, width, outputHeight, outputWidth,
+                                  num_events_in_list, event_wait_list, event);
+    } else {
+        err = forwardIm2win(version, input, output, height, width, outputHeight, outputWidth,
+                            num_events_in_list, event_wait_list, event);
+    }
+
+    if (err == CL_INVALID_VALUE && version != 0 && !configured) {
+        /* shape not supported by tile size of `version` */
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG,
+                            "[%s:%d] version(%d) -> version(0)\n", __FILE__, __LINE__, version);
+        err = forwardIm2win(0, input, output, height, width, outputHeight, outputWidth,
+                            num_events_in_list, event_wait_list, event);
+    }
+    CHECK_ERROR(err);
+
+    return CL_SUCCESS;
+}
+
+/* CpuBackend::isEnabled() */
+cl_int Conv2D::forwardCpu(cl_mem input, cl_mem output, size_t inputHeight, size_t inputWidth,
+                          size_t outputHeight, size_t outputWidth, cl_uint num_events_in_list,
+                          const cl_event *event_wait_list, cl_event *event) {
+    cl_int err;
+    Tracer::HostSpan span("cpu_conv2d");
+    CpuBackend::Mapping mapping(cmdQueue, num_events_in_list, event_wait_list);
+    auto out = mapping.map(output, &err);
+    CHECK_ERROR(err);
+    auto in = mapping.mapRead(input, &err);
+    CHECK_ERROR(err);
+    auto weight = mapping.mapRead(bufferWeight, &err);
+    CHECK_ERROR(err);
+    const float *bias = nullptr;
+    if (bufferBias != nullptr) {
+        bias = mapping.mapRead(bufferBias, &err);
+        CHECK_ERROR(err);
+    }
+
+    cpu::conv2d(in, weight, bias, out, weightShape[1], inputHeight, inputWidth, weightShape[0],
+                weightShape[2], stride, padding, outputHeight, outputWidth);
+
+    err = mapping.unmap(event);
+    CHECK_ERROR(err);
+    return CL_SUCCESS;
+}
+
+/* implicit GEMM version (9) */
+cl_int Conv2D::forwardImplicitGemm(cl_mem input, cl_mem output, size_t inputHeight,
+                                   size_t inputWidth, size_t outputHeight, size_t outputWidth,
+                                   cl_uint num_events_in_list, const cl_event *event_wait_list,
+                                   cl_event *event) {
+    cl_int err;
+    size_t kernel_size = weightShape[2];
+    size_t in_channel = weightShape[1];
+    size_t out_channel = weightShape[0];
+    size_t reg_size_c = 4;
+    size_t reg_size_m = 4;
+    std::vector<size_t> tile_size_ms = {64, 32, 16, 8};
+    std::vector<size_t> tile_size_ns = {8, 8, 16, 8};
+    std::vector<size_t> tile_size_ks = {8, 4, 2, 1};
+    size_t M = outputHeight;
+    size_t N = outputWidth;
+
+    int m_index;
+    for (m_index = 0; m_index < tile_size_ms.size(); m_index++) {
+        if (M % tile_size_ms[m_index] == 0 && N % tile_size_ns[m_index] == 0) {
+            break;
+        }
+    }
+
+    if (m_index >= tile_size_ms.size()) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "[%s:%d] M(%ld) %% tile_size_m != 0 or N(%ld) %% tile_size_n != 0\n",
+                            __FILE__, __LINE__, M, N);
+        return CL_INVALID_VALUE;
+    }
+
+    if (out_channel % reg_size_c != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "[%s:%d] out_channel(%ld) %% reg_size_c(%ld) != 0\n", __FILE__,
+                            __LINE__, out_channel, reg_size_c);
+        return CL_INVALID_VALUE;
+    }
+
+    size_t tile_size_m = tile_size_ms[m_index];
+    size_t tile_size_n = tile_size_ns[m_index];
+    size_t patch_size = ((tile_size_m - 1) * stride + kernel_size) *
+                        ((tile_size_n - 1) * stride + kernel_size);
+
+    // input patch 가 local memory (16KB) 를 넘지 않는 가장 큰 tile_k
+    int k_index;
+    for (k_index = 0; k_index < tile_size_ks.size() - 1; k_index++) {
+        if (in_channel % tile_size_ks[k_index] == 0 &&
+            sizeof(float) * tile_size_ks[k_index] * patch_size <= 16 * 1024) {
+            break;
+        }
+    }
+    size_t tile_size_k = tile_size_ks[k_index];
+
+    err = record::clSetKernelArg(kernel->implicit_gemm_conv2d, 0, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 1, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 2, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 4, sizeof(int), &in_channel);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 5, sizeof(int), &inputHeight);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 6, sizeof(int), &inputWidth);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 7, sizeof(int), &outputHeight);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 8, sizeof(int), &outputWidth);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 9, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 10, sizeof(int), &stride);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 11, sizeof(int), &padding);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 12, sizeof(int), &tile_size_k);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 13,
+                                  sizeof(float) * tile_size_k * patch_size, nullptr);
+    err |= record::clSetKernelArg(kernel->implicit_gemm_conv2d, 14,
+                                  sizeof(float) * reg_size_c * tile_size_k * kernel_size * kernel_size,
+                                  nullptr);
+    CHECK_ERROR(err);
+
+    size_t globalSize_implicit_gemm[3] = {out_channel / reg_size_c, N, M / reg_size_m};
+    size_t localSize_implicit_gemm[3] = {1, tile_size_n, tile_size_m / reg_size_m};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->implicit_gemm_conv2d, 3, nullptr,
+                                         globalSize_implicit_gemm, localSize_implicit_gemm,
+                                         num_events_in_list, event_wait_list, event);
+    CHECK_ERROR(err);
+    Tracer::getInstance().record("implicit_gemm_conv2d", *event);
+
+#if DEBUG
+    clWaitForEvents(1, event);
+    if (count == 0)
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "try, component, index, input size, output size, in channel, out channel, kernel size, kernel, time(ms)\n");
+    auto message =
+            "0, Conv2D, " +
+            std::to_string(count++) + ", " +
+            std::to_string(inputHeight) + "x" + std::to_string(inputWidth) + ", " +
+            std::to_string(outputHeight) + "x" + std::to_string(outputWidth) + ", " +
+            std::to_string(weightShape[1]) + ", " +
+            std::to_string(weightShape[0]) + ", " +
+            std::to_string(weightShape[2]);
+    util::printEventTime(message + ", implicit_gemm", *event);
+#endif
+
+    return CL_SUCCESS;
+}
+
+/* im2win version (0 ~ 8) */
+cl_int Conv2D::forwardIm2win(int version, cl_mem input, cl_mem output, size_t inputHeight,
+                             size_t inputWidth, size_t outputHeight, size_t outputWidth,
+                             cl_uint num_events_in_list, const cl_event *event_wait_list,
+                             cl_event *event) {
+    cl_int err;
+    cl_mem bufferWin;
+    cl_event _event[1];
+
+    auto strategy = strategies.find(version);
+    if (strategy == strategies.end()) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "[%s:%d] unknown version(%d)\n", __FILE__, __LINE__, version);
+        return CL_INVALID_VALUE;
+    }
+
     /* im2win version */
     size_t kernel_size = weightShape[2];
     size_t in_channel = weightShape[1];
-    size_t width_pad = (inputSize + 2 * padding);
-    bufferWin = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                               sizeof(float) * (in_channel * outputSize) *
-                               (width_pad * kernel_size),
-                               nullptr, &err);
+    size_t width_pad = (inputWidth + 2 * padding);
+    bufferWin = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                       sizeof(float) * (in_channel * outputHeight) *
+                                       (width_pad * kernel_size),
+                                       nullptr, &err);
     CHECK_ERROR(err);
 
     int im_offset = 0;
     int col_offset = 0;
-    size_t num_windows = in_channel * outputSize * width_pad;
+    size_t num_windows = in_channel * outputHeight * width_pad;
     size_t width_win = width_pad * kernel_size;
-#if CONV_2D_KERNEL_VERSION == 5 || CONV_2D_KERNEL_VERSION == 6 || CONV_2D_KERNEL_VERSION == 7
-    err = clSetKernelArg(kernel->im2win_transpose, 0, sizeof(int), &num_windows);
-    err |= clSetKernelArg(kernel->im2win_transpose, 1, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->im2win_transpose, 2, sizeof(int), &im_offset);
-    err |= clSetKernelArg(kernel->im2win_transpose, 3, sizeof(int), &inputSize);
-    err |= clSetKernelArg(kernel->im2win_transpose, 4, sizeof(int), &inputSize);
-    err |= clSetKernelArg(kernel->im2win_transpose, 5, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win_transpose, 6, sizeof(int), &padding);
-    err |= clSetKernelArg(kernel->im2win_transpose, 7, sizeof(int), &stride);
-    err |= clSetKernelArg(kernel->im2win_transpose, 8, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_transpose, 9, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win_transpose, 10, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win_transpose, 11, sizeof(int), &col_offset);
-    CHECK_ERROR(err);
+    cl_kernel im2winKernel;
+    const char *im2winName;
+    if (version == 5 || version == 6 || version == 7) {
+        im2winKernel = kernel->im2win_transpose;
+        im2winName = "im2win_transpose";
+    } else if (version == 8) {
+        im2winKernel = kernel->im2win_transpose_reorder;
+        im2winName = "im2win_transpose_reorder";
+    } else {
+        im2winKernel = kernel->im2win;
+        im2winName = "im2win";
+    }
 
-    size_t globalSize_im2win[1] = {num_windows};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_transpose, 1, nullptr, globalSize_im2win, nullptr,
-                                 num_events_in_list, event_wait_list, &_event[0]);
-    CHECK_ERROR(err);
-#elif CONV_2D_KERNEL_VERSION == 8
-    err = clSetKernelArg(kernel->im2win_transpose_reorder, 0, sizeof(int), &num_windows);
-    err |= clSetKernelArg(kernel->im2win_transpose_reorder, 1, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->im2win_transpose_reorder, 2, sizeof(int), &im_offset);
-    err |= clSetKernelArg(kernel->im2win_transpose_reorder, 3, sizeof(int), &inputSize);
-    err |= clSetKernelArg(kernel->im2win_transpose_reorder, 4, sizeof(int), &inputSize);
-    err |= clSetKernelArg(kernel->im2win_transpose_reorder, 5, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win_transpose_reorder, 6, sizeof(int), &padding);
-    err |= clSetKernelArg(kernel->im2win_transpose_reorder, 7, sizeof(int), &stride);
-    err |= clSetKernelArg(kernel->im2win_transpose_reorder, 8, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_transpose_reorder, 9, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win_transpose_reorder, 10, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win_transpose_reorder, 11, sizeof(int), &col_offset);
+    err = record::clSetKernelArg(im2winKernel, 0, sizeof(int), &num_windows);
+    err |= record::clSetKernelArg(im2winKernel, 1, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(im2winKernel, 2, sizeof(int), &im_offset);
+    err |= record::clSetKernelArg(im2winKernel, 3, sizeof(int), &inputHeight);
+    err |= record::clSetKernelArg(im2winKernel, 4, sizeof(int), &inputWidth);
+    err |= record::clSetKernelArg(im2winKernel, 5, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(im2winKernel, 6, sizeof(int), &padding);
+    err |= record::clSetKernelArg(im2winKernel, 7, sizeof(int), &stride);
+    err |= record::clSetKernelArg(im2winKernel, 8, sizeof(int), &outputHeight);
+    err |= record::clSetKernelArg(im2winKernel, 9, sizeof(int), &width_win);
+    err |= record::clSetKernelArg(im2winKernel, 10, sizeof(cl_mem), &bufferWin);
+    err |= record::clSetKernelArg(im2winKernel, 11, sizeof(int), &col_offset);
     CHECK_ERROR(err);
 
     size_t globalSize_im2win[1] = {num_windows};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_transpose_reorder, 1, nullptr, globalSize_im2win, nullptr,
-                                 num_events_in_list, event_wait_list, &_event[0]);
-    CHECK_ERROR(err);
-#else
-    err = clSetKernelArg(kernel->im2win, 0, sizeof(int), &num_windows);
-    err |= clSetKernelArg(kernel->im2win, 1, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->im2win, 2, sizeof(int), &im_offset);
-    err |= clSetKernelArg(kernel->im2win, 3, sizeof(int), &inputSize);
-    err |= clSetKernelArg(kernel->im2win, 4, sizeof(int), &inputSize);
-    err |= clSetKernelArg(kernel->im2win, 5, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win, 6, sizeof(int), &padding);
-    err |= clSetKernelArg(kernel->im2win, 7, sizeof(int), &stride);
-    err |= clSetKernelArg(kernel->im2win, 8, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win, 9, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win, 10, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win, 11, sizeof(int), &col_offset);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, im2winKernel, 1, nullptr, globalSize_im2win, nullptr,
+                                         num_events_in_list, event_wait_list, &_event[0]);
+    CHECK_ERROR(err);
+    Tracer::getInstance().record(im2winName, _event[0]);
+
+    err = (this->*(strategy->second))(bufferWin, output, outputHeight, outputWidth, width_win,
+                                      _event, event);
+    if (err != CL_SUCCESS) {
+        clWaitForEvents(1, _event);
+        record::clReleaseMemObject(bufferWin);
+        clReleaseEvent(_event[0]);
+        return err;
+    }
+
+    /* im2win matmul - register
+    size_t tile_size_m = 1, reg_size_n = 4;
+    size_t tile_size_ns[] = {128, 64, 32, 16, 8};
+    size_t tile_size_ks[] = {16, 4};
+
+    int n_index, n_size = 5;
+    for (n_index = 0; n_index < n_size; n_index++) {
+        if (outputSize % (tile_size_ns[n_index]) == 0) {
+            break;
+        }
+    }
+
+    int k_index, k_size = 2;
+    for (k_index = 0; k_index < k_size; k_index++) {
+        if (in_channel % (tile_size_ks[k_index]) == 0) {
+            break;
+        }
+    }
+
+    if (n_index >= n_size) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "[%s:%d] outputSize(%ld) %% tile_size_n(%ld) != 0\n", __FILE__,
+                            __LINE__, outputSize, tile_size_ns[0]);
+        return CL_INVALID_VALUE;
+    }
+    if (k_index >= k_size) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "[%s:%d] in_channel(%ld) %% tile_size_k(%ld) != 0\n", __FILE__,
+                            __LINE__, in_channel, tile_size_ks[0]);
+        return CL_INVALID_VALUE;
+    }
+    size_t tile_size_n = tile_size_ns[n_index];
+    size_t tile_size_k = tile_size_ks[k_index];
+    err = record::clSetKernelArg(kernel->im2win_batch_matmul, 0, sizeof(cl_mem), &bufferWin);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 1, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 2, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 4, sizeof(int), &outputHeight);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 5, sizeof(int), &outputWidth);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 6, sizeof(int), &in_channel);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 7, sizeof(int), &width_win);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 8, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 9, sizeof(int), &stride);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 10,
+                                  sizeof(float) * tile_size_k * tile_size_m *
+                                  (kernel_size * kernel_size + (tile_size_n - 1) * stride * kernel_size),
+                                  nullptr);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 11,
+                                  sizeof(float) * tile_size_k * kernel_size * kernel_size, nullptr);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 12, sizeof(int), &tile_size_n);
+    err |= record::clSetKernelArg(kernel->im2win_batch_matmul, 13, sizeof(int), &tile_size_k);
     CHECK_ERROR(err);
 
-    size_t globalSize_im2win[1] = {num_windows};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win, 1, nullptr, globalSize_im2win, nullptr,
-                                 num_events_in_list, event_wait_list, &_event[0]);
+    size_t globalSize_im2win_batch_matmul[3] = {out_channel, outputSize, outputSize / reg_size_n};
+    size_t localSize_im2win_batch_matmul[3] = {1, 1, tile_size_n / reg_size_n};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_batch_matmul, 3, nullptr,
+                                         globalSize_im2win_batch_matmul, localSize_im2win_batch_matmul,
+                                         1, &_event[0], event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("im2win_batch_matmul", *event);
+     im2win matmul - register */
+
+#if DEBUG
+    clWaitForEvents(1, event);
+    if (count == 0)
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "try, component, index, input size, output size, in channel, out channel, kernel size, kernel, time(ms)\n");
+    auto message =
+            "0, Conv2D, " +
+            std::to_string(count++) + ", " +
+            std::to_string(inputHeight) + "x" + std::to_string(inputWidth) + ", " +
+            std::to_string(outputHeight) + "x" + std::to_string(outputWidth) + ", " +
+            std::to_string(weightShape[1]) + ", " +
+            std::to_string(weightShape[0]) + ", " +
+            std::to_string(weightShape[2]);
+    util::printEventTime(message + ", im2win", _event[0]);
+    util::printEventTime(message + ", im2win_matmul", *event);
 #endif
 
+    record::clReleaseMemObject(bufferWin);
+    /* im2win version */
+
+
+    for (auto &e: _event) {
+        clReleaseEvent(e);
+    }
+
+    return CL_SUCCESS;
+}
+
+cl_int Conv2D::matmulVersion0(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                              size_t outputWidth, size_t width_win, cl_event *_event,
+                              cl_event *event) {
+    cl_int err;
+    size_t in_channel = weightShape[1];
     size_t out_channel = weightShape[0];
+    size_t kernel_size = weightShape[2];
 
+    err = record::clSetKernelArg(kernel->im2win_matmul, 0, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->im2win_matmul, 1, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->im2win_matmul, 2, sizeof(cl_mem), &bufferWin);
+    err |= record::clSetKernelArg(kernel->im2win_matmul, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->im2win_matmul, 4, sizeof(int), &out_channel);
+    err |= record::clSetKernelArg(kernel->im2win_matmul, 5, sizeof(int), &outputHeight);
+    err |= record::clSetKernelArg(kernel->im2win_matmul, 6, sizeof(int), &outputWidth);
+    err |= record::clSetKernelArg(kernel->im2win_matmul, 7, sizeof(int), &width_win);
+    err |= record::clSetKernelArg(kernel->im2win_matmul, 8, sizeof(int), &in_channel);
+    err |= record::clSetKernelArg(kernel->im2win_matmul, 9, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(kernel->im2win_matmul, 10, sizeof(int), &stride);
+    CHECK_ERROR(err);
+
+    size_t globalSize_im2win_matmul[1] = {out_channel * outputHeight * outputWidth};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_matmul, 1, nullptr,
+                                         globalSize_im2win_matmul, nullptr,
+                                         1, &_event[0], event);
+    CHECK_ERROR(err);
+    Tracer::getInstance().record("im2win_matmul", *event);
     /* im2win matmul - naive */
-#if CONV_2D_KERNEL_VERSION == 0
-    err = clSetKernelArg(kernel->im2win_matmul, 0, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->im2win_matmul, 1, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->im2win_matmul, 2, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win_matmul, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->im2win_matmul, 4, sizeof(int), &out_channel);
-    err |= clSetKernelArg(kernel->im2win_matmul, 5, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_matmul, 6, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_matmul, 7, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win_matmul, 8, sizeof(int), &in_channel);
-    err |= clSetKernelArg(kernel->im2win_matmul, 9, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win_matmul, 10, sizeof(int), &stride);
-    CHECK_ERROR(err);
-
-    size_t globalSize_im2win_matmul[1] = {out_channel * outputSize * outputSize};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_matmul, 1, nullptr,
-                                 globalSize_im2win_matmul, nullptr,
-                                 1, &_event[0], event);
-    CHECK_ERROR(err);
-    /* im2win matmul - naive */
-#elif CONV_2D_KERNEL_VERSION == 1
+
+    return CL_SUCCESS;
+}
+
+cl_int Conv2D::matmulVersion1(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                              size_t outputWidth, size_t width_win, cl_event *_event,
+                              cl_event *event) {
+    cl_int err;
+    size_t in_channel = weightShape[1];
+    size_t out_channel = weightShape[0];
+    size_t kernel_size = weightShape[2];
+
     size_t tile_size_n = 256;
     size_t reg_size_n = 16;
-    size_t MN = outputSize * outputSize;
+    size_t MN = outputHeight * outputWidth;
 
     if (MN % tile_size_n != 0) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
@@ -286,29 +558,40 @@ cl_int Conv2D::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
         return CL_INVALID_VALUE;
     }
 
-    err = clSetKernelArg(kernel->im2win_reg_n_matmul, 0, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->im2win_reg_n_matmul, 1, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->im2win_reg_n_matmul, 2, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win_reg_n_matmul, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->im2win_reg_n_matmul, 4, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_reg_n_matmul, 5, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_reg_n_matmul, 6, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win_reg_n_matmul, 7, sizeof(int), &in_channel);
-    err |= clSetKernelArg(kernel->im2win_reg_n_matmul, 8, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win_reg_n_matmul, 9, sizeof(int), &stride);
+    err = record::clSetKernelArg(kernel->im2win_reg_n_matmul, 0, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->im2win_reg_n_matmul, 1, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->im2win_reg_n_matmul, 2, sizeof(cl_mem), &bufferWin);
+    err |= record::clSetKernelArg(kernel->im2win_reg_n_matmul, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->im2win_reg_n_matmul, 4, sizeof(int), &outputHeight);
+    err |= record::clSetKernelArg(kernel->im2win_reg_n_matmul, 5, sizeof(int), &outputWidth);
+    err |= record::clSetKernelArg(kernel->im2win_reg_n_matmul, 6, sizeof(int), &width_win);
+    err |= record::clSetKernelArg(kernel->im2win_reg_n_matmul, 7, sizeof(int), &in_channel);
+    err |= record::clSetKernelArg(kernel->im2win_reg_n_matmul, 8, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(kernel->im2win_reg_n_matmul, 9, sizeof(int), &stride);
     CHECK_ERROR(err);
 
     size_t globalSize_im2win_matmul[2] = {out_channel,  MN / reg_size_n};
     size_t localSize_im2win_matmul[2] = {1, tile_size_n / reg_size_n};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_reg_n_matmul, 2, nullptr,
-                                 globalSize_im2win_matmul, localSize_im2win_matmul,
-                                 1, &_event[0], event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_reg_n_matmul, 2, nullptr,
+                                         globalSize_im2win_matmul, localSize_im2win_matmul,
+                                         1, &_event[0], event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("im2win_reg_n_matmul", *event);
+
+    return CL_SUCCESS;
+}
+
+cl_int Conv2D::matmulVersion2(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                              size_t outputWidth, size_t width_win, cl_event *_event,
+                              cl_event *event) {
+    cl_int err;
+    size_t in_channel = weightShape[1];
+    size_t out_channel = weightShape[0];
+    size_t kernel_size = weightShape[2];
 
-#elif CONV_2D_KERNEL_VERSION == 2
     size_t reg_size_n = 32;
     size_t tile_size_n = reg_size_n * 16;
-    size_t MN = outputSize * outputSize;
+    size_t MN = outputHeight * outputWidth;
 
     if (MN % tile_size_n != 0) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
@@ -317,30 +600,41 @@ cl_int Conv2D::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
         return CL_INVALID_VALUE;
     }
 
-    err = clSetKernelArg(kernel->im2win_v2_matmul, 0, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->im2win_v2_matmul, 1, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->im2win_v2_matmul, 2, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win_v2_matmul, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->im2win_v2_matmul, 4, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_v2_matmul, 5, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_v2_matmul, 6, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win_v2_matmul, 7, sizeof(int), &in_channel);
-    err |= clSetKernelArg(kernel->im2win_v2_matmul, 8, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win_v2_matmul, 9, sizeof(int), &stride);
+    err = record::clSetKernelArg(kernel->im2win_v2_matmul, 0, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->im2win_v2_matmul, 1, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->im2win_v2_matmul, 2, sizeof(cl_mem), &bufferWin);
+    err |= record::clSetKernelArg(kernel->im2win_v2_matmul, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->im2win_v2_matmul, 4, sizeof(int), &outputHeight);
+    err |= record::clSetKernelArg(kernel->im2win_v2_matmul, 5, sizeof(int), &outputWidth);
+    err |= record::clSetKernelArg(kernel->im2win_v2_matmul, 6, sizeof(int), &width_win);
+    err |= record::clSetKernelArg(kernel->im2win_v2_matmul, 7, sizeof(int), &in_channel);
+    err |= record::clSetKernelArg(kernel->im2win_v2_matmul, 8, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(kernel->im2win_v2_matmul, 9, sizeof(int), &stride);
     CHECK_ERROR(err);
 
     size_t globalSize_im2win_matmul[2] = {out_channel,  MN / reg_size_n};
     size_t localSize_im2win_matmul[2] = {1, tile_size_n / reg_size_n};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_v2_matmul, 2, nullptr,
-                                 globalSize_im2win_matmul, localSize_im2win_matmul,
-                                 1, &_event[0], event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_v2_matmul, 2, nullptr,
+                                         globalSize_im2win_matmul, localSize_im2win_matmul,
+                                         1, &_event[0], event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("im2win_v2_matmul", *event);
+
+    return CL_SUCCESS;
+}
+
+cl_int Conv2D::matmulVersion3(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                              size_t outputWidth, size_t width_win, cl_event *_event,
+                              cl_event *event) {
+    cl_int err;
+    size_t in_channel = weightShape[1];
+    size_t out_channel = weightShape[0];
+    size_t kernel_size = weightShape[2];
 
-#elif CONV_2D_KERNEL_VERSION == 3
     size_t reg_size_c = 2;
     size_t reg_size_n = 1;
     size_t tile_size_n = reg_size_n * 16;
-    size_t MN = outputSize * outputSize;
+    size_t MN = outputHeight * outputWidth;
 
     if (MN % tile_size_n != 0) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
@@ -356,29 +650,41 @@ cl_int Conv2D::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
         return CL_INVALID_VALUE;
     }
 
-    err = clSetKernelArg(kernel->im2win_channel_reg_matmul, 0, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_matmul, 1, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_matmul, 2, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_matmul, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_matmul, 4, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_matmul, 5, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_matmul, 6, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_matmul, 7, sizeof(int), &in_channel);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_matmul, 8, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_matmul, 9, sizeof(int), &stride);
+    err = record::clSetKernelArg(kernel->im2win_channel_reg_matmul, 0, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_matmul, 1, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_matmul, 2, sizeof(cl_mem), &bufferWin);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_matmul, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_matmul, 4, sizeof(int), &outputHeight);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_matmul, 5, sizeof(int), &outputWidth);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_matmul, 6, sizeof(int), &width_win);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_matmul, 7, sizeof(int), &in_channel);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_matmul, 8, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_matmul, 9, sizeof(int), &stride);
     CHECK_ERROR(err);
 
     size_t globalSize_im2win_matmul[2] = {out_channel / reg_size_c,  MN / reg_size_n};
     size_t localSize_im2win_matmul[2] = {1, tile_size_n / reg_size_n};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_channel_reg_matmul, 2, nullptr,
-                                 globalSize_im2win_matmul, localSize_im2win_matmul,
-                                 1, &_event[0], event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_channel_reg_matmul, 2, nullptr,
+                                         globalSize_im2win_matmul, localSize_im2win_matmul,
+                                         1, &_event[0], event);
     CHECK_ERROR(err);
-#elif CONV_2D_KERNEL_VERSION == 4
+    Tracer::getInstance().record("im2win_channel_reg_matmul", *event);
+
+    return CL_SUCCESS;
+}
+
+cl_int Conv2D::matmulVersion4(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                              size_t outputWidth, size_t width_win, cl_event *_event,
+                              cl_event *event) {
+    cl_int err;
+    size_t in_channel = weightShape[1];
+    size_t out_channel = weightShape[0];
+    size_t kernel_size = weightShape[2];
+
     size_t reg_size_c = 16;
     size_t reg_size_n = 1;
     size_t tile_size_n = 64;
-    size_t MN = outputSize * outputSize;
+    size_t MN = outputHeight * outputWidth;
 
     if (MN % tile_size_n != 0) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
@@ -394,43 +700,55 @@ cl_int Conv2D::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
         return CL_INVALID_VALUE;
     }
 
-    err = clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 0, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 1, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 2, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 4, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 5, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 6, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 7, sizeof(int), &in_channel);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 8, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 9, sizeof(int), &stride);
+    err = record::clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 0, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 1, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 2, sizeof(cl_mem), &bufferWin);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 4, sizeof(int), &outputHeight);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 5, sizeof(int), &outputWidth);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 6, sizeof(int), &width_win);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 7, sizeof(int), &in_channel);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 8, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_v4_matmul, 9, sizeof(int), &stride);
     CHECK_ERROR(err);
 
     size_t globalSize_im2win_matmul[2] = {out_channel / reg_size_c,  MN / reg_size_n};
     size_t localSize_im2win_matmul[2] = {1, tile_size_n / reg_size_n};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_channel_reg_v4_matmul, 2, nullptr,
-                                 globalSize_im2win_matmul, localSize_im2win_matmul,
-                                 1, &_event[0], event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_channel_reg_v4_matmul, 2, nullptr,
+                                         globalSize_im2win_matmul, localSize_im2win_matmul,
+                                         1, &_event[0], event);
     CHECK_ERROR(err);
-#elif CONV_2D_KERNEL_VERSION == 5
+    Tracer::getInstance().record("im2win_channel_reg_v4_matmul", *event);
+
+    return CL_SUCCESS;
+}
+
+cl_int Conv2D::matmulVersion5(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                              size_t outputWidth, size_t width_win, cl_event *_event,
+                              cl_event *event) {
+    cl_int err;
+    size_t in_channel = weightShape[1];
+    size_t out_channel = weightShape[0];
+    size_t kernel_size = weightShape[2];
+
     size_t reg_size_c = 4;
     size_t reg_size_m = 4;
     std::vector<size_t> tile_size_ms = {64, 32, 16, 8};
     std::vector<size_t> tile_size_ns = {1, 8, 16, 8};
-    size_t M = outputSize;
-    size_t N = outputSize;
+    size_t M = outputHeight;
+    size_t N = outputWidth;
 
     int m_index;
     for (m_index = 0; m_index < tile_size_ms.size(); m_index++) {
-        if (M % (tile_size_ms[m_index]) == 0) {
+        if (M % (tile_size_ms[m_index]) == 0 && N % (tile_size_ns[m_index]) == 0) {
             break;
         }
     }
 
     if (m_index >= tile_size_ms.size()) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] M(%ld) %% tile_size_m != 0\n", __FILE__,
-                            __LINE__, M);
+                            "[%s:%d] M(%ld) %% tile_size_m != 0 or N(%ld) %% tile_size_n != 0\n",
+                            __FILE__, __LINE__, M, N);
         return CL_INVALID_VALUE;
     }
 
@@ -444,43 +762,55 @@ cl_int Conv2D::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
     size_t tile_size_m = tile_size_ms[m_index];
     size_t tile_size_n = tile_size_ns[m_index];
 
-    err = clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 0, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 1, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 2, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 4, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 5, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 6, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 7, sizeof(int), &in_channel);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 8, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 9, sizeof(int), &stride);
+    err = record::clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 0, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 1, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 2, sizeof(cl_mem), &bufferWin);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 4, sizeof(int), &outputHeight);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 5, sizeof(int), &outputWidth);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 6, sizeof(int), &width_win);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 7, sizeof(int), &in_channel);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 8, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_v5_matmul, 9, sizeof(int), &stride);
     CHECK_ERROR(err);
 
     size_t globalSize_im2win_matmul[3] = {out_channel / reg_size_c, N, M / reg_size_m};
     size_t localSize_im2win_matmul[3] = {1, tile_size_n, tile_size_m / reg_size_m};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_channel_reg_transpose_v5_matmul, 3, nullptr,
-                                 globalSize_im2win_matmul, localSize_im2win_matmul,
-                                 1, &_event[0], event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_channel_reg_transpose_v5_matmul, 3, nullptr,
+                                         globalSize_im2win_matmul, localSize_im2win_matmul,
+                                         1, &_event[0], event);
     CHECK_ERROR(err);
-#elif CONV_2D_KERNEL_VERSION == 6
+    Tracer::getInstance().record("im2win_channel_reg_transpose_v5_matmul", *event);
+
+    return CL_SUCCESS;
+}
+
+cl_int Conv2D::matmulVersion6(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                              size_t outputWidth, size_t width_win, cl_event *_event,
+                              cl_event *event) {
+    cl_int err;
+    size_t in_channel = weightShape[1];
+    size_t out_channel = weightShape[0];
+    size_t kernel_size = weightShape[2];
+
     size_t reg_size_c = 4;
     size_t reg_size_m = 4;
     std::vector<size_t> tile_size_ms = {64, 32, 16, 8};
     std::vector<size_t> tile_size_ns = {8, 8, 16, 8};
-    size_t M = outputSize;
-    size_t N = outputSize;
+    size_t M = outputHeight;
+    size_t N = outputWidth;
 
     int m_index;
     for (m_index = 0; m_index < tile_size_ms.size(); m_index++) {
-        if (M % (tile_size_ms[m_index]) == 0) {
+        if (M % (tile_size_ms[m_index]) == 0 && N % (tile_size_ns[m_index]) == 0) {
             break;
         }
     }
 
     if (m_index >= tile_size_ms.size()) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] M(%ld) %% tile_size_m != 0\n", __FILE__,
-                            __LINE__, M);
+                            "[%s:%d] M(%ld) %% tile_size_m != 0 or N(%ld) %% tile_size_n != 0\n",
+                            __FILE__, __LINE__, M, N);
         return CL_INVALID_VALUE;
     }
 
@@ -494,43 +824,55 @@ cl_int Conv2D::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
     size_t tile_size_m = tile_size_ms[m_index];
     size_t tile_size_n = tile_size_ns[m_index];
 
-    err = clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 0, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 1, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 2, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 4, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 5, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 6, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 7, sizeof(int), &in_channel);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 8, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 9, sizeof(int), &stride);
+    err = record::clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 0, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 1, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 2, sizeof(cl_mem), &bufferWin);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 4, sizeof(int), &outputHeight);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 5, sizeof(int), &outputWidth);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 6, sizeof(int), &width_win);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 7, sizeof(int), &in_channel);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 8, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_vector_v6_matmul, 9, sizeof(int), &stride);
     CHECK_ERROR(err);
 
     size_t globalSize_im2win_matmul[3] = {out_channel / reg_size_c, N, M / reg_size_m};
     size_t localSize_im2win_matmul[3] = {1, tile_size_n, tile_size_m / reg_size_m};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_channel_reg_transpose_vector_v6_matmul, 3, nullptr,
-                                 globalSize_im2win_matmul, localSize_im2win_matmul,
-                                 1, &_event[0], event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_channel_reg_transpose_vector_v6_matmul, 3, nullptr,
+                                         globalSize_im2win_matmul, localSize_im2win_matmul,
+                                         1, &_event[0], event);
     CHECK_ERROR(err);
-#elif CONV_2D_KERNEL_VERSION == 7
+    Tracer::getInstance().record("im2win_channel_reg_transpose_vector_v6_matmul", *event);
+
+    return CL_SUCCESS;
+}
+
+cl_int Conv2D::matmulVersion7(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                              size_t outputWidth, size_t width_win, cl_event *_event,
+                              cl_event *event) {
+    cl_int err;
+    size_t in_channel = weightShape[1];
+    size_t out_channel = weightShape[0];
+    size_t kernel_size = weightShape[2];
+
     size_t reg_size_c = 1;
     size_t reg_size_m = 8;
     std::vector<size_t> tile_size_ms = {64, 32, 16, 8};
     std::vector<size_t> tile_size_ns = {8, 8, 16, 8};
-    size_t M = outputSize;
-    size_t N = outputSize;
+    size_t M = outputHeight;
+    size_t N = outputWidth;
 
     int m_index;
     for (m_index = 0; m_index < tile_size_ms.size(); m_index++) {
-        if (M % (tile_size_ms[m_index]) == 0) {
+        if (M % (tile_size_ms[m_index]) == 0 && N % (tile_size_ns[m_index]) == 0) {
             break;
         }
     }
 
     if (m_index >= tile_size_ms.size()) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] M(%ld) %% tile_size_m != 0\n", __FILE__,
-                            __LINE__, M);
+                            "[%s:%d] M(%ld) %% tile_size_m != 0 or N(%ld) %% tile_size_n != 0\n",
+                            __FILE__, __LINE__, M, N);
         return CL_INVALID_VALUE;
     }
 
@@ -544,43 +886,55 @@ cl_int Conv2D::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
     size_t tile_size_m = tile_size_ms[m_index];
     size_t tile_size_n = tile_size_ns[m_index];
 
-    err = clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 0, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 1, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 2, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 4, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 5, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 6, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 7, sizeof(int), &in_channel);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 8, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 9, sizeof(int), &stride);
+    err = record::clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 0, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 1, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 2, sizeof(cl_mem), &bufferWin);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 4, sizeof(int), &outputHeight);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 5, sizeof(int), &outputWidth);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 6, sizeof(int), &width_win);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 7, sizeof(int), &in_channel);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 8, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 9, sizeof(int), &stride);
     CHECK_ERROR(err);
 
     size_t globalSize_im2win_matmul[3] = {out_channel / reg_size_c, N, M / reg_size_m};
     size_t localSize_im2win_matmul[3] = {1, tile_size_n, tile_size_m / reg_size_m};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 3, nullptr,
-                                 globalSize_im2win_matmul, localSize_im2win_matmul,
-                                 1, &_event[0], event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_channel_reg_transpose_weight_vector_v7_matmul, 3, nullptr,
+                                         globalSize_im2win_matmul, localSize_im2win_matmul,
+                                         1, &_event[0], event);
     CHECK_ERROR(err);
-#elif CONV_2D_KERNEL_VERSION == 8
+    Tracer::getInstance().record("im2win_channel_reg_transpose_weight_vector_v7_matmul", *event);
+
+    return CL_SUCCESS;
+}
+
+cl_int Conv2D::matmulVersion8(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                              size_t outputWidth, size_t width_win, cl_event *_event,
+                              cl_event *event) {
+    cl_int err;
+    size_t in_channel = weightShape[1];
+    size_t out_channel = weightShape[0];
+    size_t kernel_size = weightShape[2];
+
     size_t reg_size_c = 4;
     size_t reg_size_m = 4;
     std::vector<size_t> tile_size_ms = {64, 32, 16, 8};
     std::vector<size_t> tile_size_ns = {8, 8, 16, 8};
-    size_t M = outputSize;
-    size_t N = outputSize;
+    size_t M = outputHeight;
+    size_t N = outputWidth;
 
     int m_index;
     for (m_index = 0; m_index < tile_size_ms.size(); m_index++) {
-        if (M % (tile_size_ms[m_index]) == 0) {
+        if (M % (tile_size_ms[m_index]) == 0 && N % (tile_size_ns[m_index]) == 0) {
             break;
         }
     }
 
     if (m_index >= tile_size_ms.size()) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] M(%ld) %% tile_size_m != 0\n", __FILE__,
-                            __LINE__, M);
+                            "[%s:%d] M(%ld) %% tile_size_m != 0 or N(%ld) %% tile_size_n != 0\n",
+                            __FILE__, __LINE__, M, N);
         return CL_INVALID_VALUE;
     }
 
@@ -594,110 +948,34 @@ cl_int Conv2D::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
     size_t tile_size_m = tile_size_ms[m_index];
     size_t tile_size_n = tile_size_ns[m_index];
 
-    err = clSetKernelArg(kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul, 0, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul, 1, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul, 2, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul, 4, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul, 5, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul, 6, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul, 7, sizeof(int), &in_channel);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul, 8, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul, 9, sizeof(int), &stride);
-    CHECK_ERROR(err);
-
-    size_t globalSize_im2win_matmul[3] = {out_channel / reg_size_c, N, M / reg_size_m};
-    size_t localSize_im2win_matmul[3] = {1, tile_size_n, tile_size_m / reg_size_m};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul, 3, nullptr,
-                                 globalSize_im2win_matmul, localSize_im2win_matmul,
-                                 1, &_event[0], event);
-    CHECK_ERROR(err);
-#endif
-
-    /* im2win matmul - register
-    size_t tile_size_m = 1, reg_size_n = 4;
-    size_t tile_size_ns[] = {128, 64, 32, 16, 8};
-    size_t tile_size_ks[] = {16, 4};
-
-    int n_index, n_size = 5;
-    for (n_index = 0; n_index < n_size; n_index++) {
-        if (outputSize % (tile_size_ns[n_index]) == 0) {
-            break;
-        }
-    }
-
-    int k_index, k_size = 2;
-    for (k_index = 0; k_index < k_size; k_index++) {
-        if (in_channel % (tile_size_ks[k_index]) == 0) {
-            break;
-        }
+    /* SHAPE_SPECIALIZE_MODE: size, channel, kernel_size, tile size 를 상수로 build 한 variant */
+    cl_kernel matmul = kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul_specialized.get(
+            {{"CONV_M", M}, {"CONV_N", N}, {"CONV_WIDTH_WIN", width_win},
+             {"CONV_IN_CHANNEL", in_channel}, {"CONV_KERNEL_SIZE", kernel_size},
+             {"CONV_STRIDE", (size_t) stride}, {"CONV_LOCAL_M", tile_size_m / reg_size_m}});
+    if (matmul == nullptr) {
+        matmul = kernel->im2win_channel_reg_transpose_reorder_vector_v8_matmul;
     }
 
-    if (n_index >= n_size) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] outputSize(%ld) %% tile_size_n(%ld) != 0\n", __FILE__,
-                            __LINE__, outputSize, tile_size_ns[0]);
-        return CL_INVALID_VALUE;
-    }
-    if (k_index >= k_size) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] in_channel(%ld) %% tile_size_k(%ld) != 0\n", __FILE__,
-                            __LINE__, in_channel, tile_size_ks[0]);
-        return CL_INVALID_VALUE;
-    }
-    size_t tile_size_n = tile_size_ns[n_index];
-    size_t tile_size_k = tile_size_ks[k_index];
-    err = clSetKernelArg(kernel->im2win_batch_matmul, 0, sizeof(cl_mem), &bufferWin);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 1, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 2, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 4, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 5, sizeof(int), &outputSize);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 6, sizeof(int), &in_channel);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 7, sizeof(int), &width_win);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 8, sizeof(int), &kernel_size);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 9, sizeof(int), &stride);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 10,
-                          sizeof(float) * tile_size_k * tile_size_m *
-                          (kernel_size * kernel_size + (tile_size_n - 1) * stride * kernel_size),
-                          nullptr);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 11,
-                          sizeof(float) * tile_size_k * kernel_size * kernel_size, nullptr);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 12, sizeof(int), &tile_size_n);
-    err |= clSetKernelArg(kernel->im2win_batch_matmul, 13, sizeof(int), &tile_size_k);
+    err = record::clSetKernelArg(matmul, 0, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(matmul, 1, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(matmul, 2, sizeof(cl_mem), &bufferWin);
+    err |= record::clSetKernelArg(matmul, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(matmul, 4, sizeof(int), &outputHeight);
+    err |= record::clSetKernelArg(matmul, 5, sizeof(int), &outputWidth);
+    err |= record::clSetKernelArg(matmul, 6, sizeof(int), &width_win);
+    err |= record::clSetKernelArg(matmul, 7, sizeof(int), &in_channel);
+    err |= record::clSetKernelArg(matmul, 8, sizeof(int), &kernel_size);
+    err |= record::clSetKernelArg(matmul, 9, sizeof(int), &stride);
     CHECK_ERROR(err);
 
-    size_t globalSize_im2win_batch_matmul[3] = {out_channel, outputSize, outputSize / reg_size_n};
-    size_t localSize_im2win_batch_matmul[3] = {1, 1, tile_size_n / reg_size_n};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->im2win_batch_matmul, 3, nullptr,
-                                 globalSize_im2win_batch_matmul, localSize_im2win_batch_matmul,
-                                 1, &_event[0], event);
+    size_t globalSize_im2win_matmul[3] = {out_channel / reg_size_c, N, M / reg_size_m};
+    size_t localSize_im2win_matmul[3] = {1, tile_size_n, tile_size_m / reg_size_m};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, matmul, 3, nullptr,
+                                         globalSize_im2win_matmul, localSize_im2win_matmul,
+                                         1, &_event[0], event);
     CHECK_ERROR(err);
-     im2win matmul - register */
-
-#if DEBUG
-    clWaitForEvents(1, event);
-    if (count == 0)
-        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "try, component, index, input size, output size, in channel, out channel, kernel size, kernel, time(ms)\n");
-    auto message =
-            "0, Conv2D, " +
-            std::to_string(count++) + ", " +
-            std::to_string(inputSize) + ", " +
-            std::to_string(outputSize) + ", " +
-            std::to_string(weightShape[1]) + ", " +
-            std::to_string(weightShape[0]) + ", " +
-            std::to_string(weightShape[2]);
-    util::printEventTime(message + ", im2win", _event[0]);
-    util::printEventTime(message + ", im2win_matmul", *event);
-#endif
-
-    clReleaseMemObject(bufferWin);
-    /* im2win version */
-
-
-    for (auto &e: _event) {
-        clReleaseEvent(e);
-    }
+    Tracer::getInstance().record("im2win_channel_reg_transpose_reorder_vector_v8_matmul", *event);
 
     return CL_SUCCESS;
 }
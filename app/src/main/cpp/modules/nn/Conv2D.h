@@ -6,6 +6,7 @@
 #define MY_OPENCL_CONV2D_H
 
 #include <android/asset_manager_jni.h>
+#include <map>
 #include <vector>
 #include <string>
 
@@ -25,11 +26,61 @@ public:
 
     void init();
 
-    cl_int forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
-                   const cl_event *event_wait_list, cl_event *event);
+    /* `input`: (in_channel, height, width) */
+    cl_int forward(cl_mem input, cl_mem output, size_t height, size_t width,
+                   cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event);
 
     std::vector<size_t> weightShape;
 private:
+    typedef cl_int (Conv2D::*Strategy)(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                                       size_t outputWidth, size_t width_win, cl_event *_event,
+                                       cl_event *event);
+
+    /* CONV_2D_KERNEL_VERSION -> matmulVersionN (im2win version) */
+    static const std::map<int, Strategy> strategies;
+
+    cl_int forwardImplicitGemm(cl_mem input, cl_mem output, size_t inputHeight, size_t inputWidth,
+                               size_t outputHeight, size_t outputWidth,
+                               cl_uint num_events_in_list, const cl_event *event_wait_list,
+                               cl_event *event);
+
+    cl_int forwardIm2win(int version, cl_mem input, cl_mem output, size_t inputHeight,
+                         size_t inputWidth, size_t outputHeight, size_t outputWidth,
+                         cl_uint num_events_in_list, const cl_event *event_wait_list,
+                         cl_event *event);
+
+    cl_int matmulVersion0(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                          size_t outputWidth, size_t width_win, cl_event *_event, cl_event *event);
+
+    cl_int matmulVersion1(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                          size_t outputWidth, size_t width_win, cl_event *_event, cl_event *event);
+
+    cl_int matmulVersion2(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                          size_t outputWidth, size_t width_win, cl_event *_event, cl_event *event);
+
+    cl_int matmulVersion3(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                          size_t outputWidth, size_t width_win, cl_event *_event, cl_event *event);
+
+    cl_int matmulVersion4(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                          size_t outputWidth, size_t width_win, cl_event *_event, cl_event *event);
+
+    cl_int matmulVersion5(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                          size_t outputWidth, size_t width_win, cl_event *_event, cl_event *event);
+
+    cl_int matmulVersion6(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                          size_t outputWidth, size_t width_win, cl_event *_event, cl_event *event);
+
+    cl_int matmulVersion7(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                          size_t outputWidth, size_t width_win, cl_event *_event, cl_event *event);
+
+    cl_int matmulVersion8(cl_mem bufferWin, cl_mem output, size_t outputHeight,
+                          size_t outputWidth, size_t width_win, cl_event *_event, cl_event *event);
+
+    /* CpuBackend::isEnabled() */
+    cl_int forwardCpu(cl_mem input, cl_mem output, size_t inputHeight, size_t inputWidth,
+                      size_t outputHeight, size_t outputWidth, cl_uint num_events_in_list,
+                      const cl_event *event_wait_list, cl_event *event);
+
     size_t getOutputSize(size_t inputSize);
 
     std::vector<size_t> biasShape;
@@ -5,7 +5,13 @@
 #include "CrossAttention.h"
 #include <android/log.h>
 #include "../util.h"
+#include "../Tracer.h"
+#include "../CommandRecorder.h"
+#include "../Graph.h"
 #include "../setting.h"
+#include "../KernelSelector.h"
+#include "../cpu/CpuBackend.h"
+#include "../cpu/CpuKernel.h"
 
 #define DEBUG 0
 #define LOG_TAG "CROSS_ATTENTION"
@@ -35,30 +41,44 @@ CrossAttention::CrossAttention(
         std::shared_ptr<LinearKernel> linearKernel,
         std::shared_ptr<UtilKernel> utilKernel,
         std::shared_ptr<CrossAttentionKernel> crossAttentionKernel
-) : context(context), cmdQueue(cmdQueue), headSize(headSize), utilKernel(utilKernel),
-    crossAttentionKernel(crossAttentionKernel) {
+) : cmdQueue(cmdQueue), context(context), headSize(headSize), name(q_linear_weight_name),
+    utilKernel(utilKernel), crossAttentionKernel(crossAttentionKernel) {
 
     scale = 1.f / sqrt(static_cast<float>(headDim));
 
     if (context_dim <= 0) {
         context_dim = query_dim;
+        if (QKV_FUSE_MODE == 1) {
+            toQKVLinear = new Linear(context, cmdQueue,
+                                     query_dim, 3 * headSize * headDim,
+                                     std::vector<std::string>{q_linear_weight_name,
+                                                              k_linear_weight_name,
+                                                              v_linear_weight_name},
+                                     "",
+                                     linearKernel, utilKernel);
+        }
+    }
+    queryDim = query_dim;
+    contextDim = context_dim;
+    innerDim = headSize * headDim;
+
+    if (toQKVLinear == nullptr) {
+        toQLinear = new Linear(context, cmdQueue,
+                               query_dim, headSize * headDim,
+                               q_linear_weight_name,
+                               "",
+                               linearKernel, utilKernel);
+        toKLinear = new Linear(context, cmdQueue,
+                               context_dim, headSize * headDim,
+                               k_linear_weight_name,
+                               "",
+                               linearKernel, utilKernel);
+        toVLinear = new Linear(context, cmdQueue,
+                               context_dim, headSize * headDim,
+                               v_linear_weight_name,
+                               "",
+                               linearKernel, utilKernel);
     }
-
-    toQLinear = new Linear(context, cmdQueue,
-                           query_dim, headSize * headDim,
-                           q_linear_weight_name,
-                           "",
-                           linearKernel, utilKernel);
-    toKLinear = new Linear(context, cmdQueue,
-                           context_dim, headSize * headDim,
-                           k_linear_weight_name,
-                           "",
-                           linearKernel, utilKernel);
-    toVLinear = new Linear(context, cmdQueue,
-                           context_dim, headSize * headDim,
-                           v_linear_weight_name,
-                           "",
-                           linearKernel, utilKernel);
     toOutLinear = new Linear(context, cmdQueue,
                              headSize * headDim, query_dim,
                              out_linear_weight_name,
@@ -71,12 +91,17 @@ CrossAttention::~CrossAttention() {
     delete toKLinear;
     delete toVLinear;
     delete toOutLinear;
+    delete toQKVLinear;
 }
 
 void CrossAttention::init() {
-    toQLinear->init();
-    toKLinear->init();
-    toVLinear->init();
+    if (toQKVLinear != nullptr) {
+        toQKVLinear->init();
+    } else {
+        toQLinear->init();
+        toKLinear->init();
+        toVLinear->init();
+    }
     toOutLinear->init();
 }
 
@@ -84,15 +109,23 @@ cl_int
 CrossAttention::forward(cl_mem input, cl_mem condition, cl_mem output, cl_uint num_events_in_list,
                         const cl_event *event_wait_list, cl_event *event) {
     cl_int err;
-    cl_event event0_0, event0_1[2], event0_2;
-    cl_event event1_0;
-    cl_event event2_0, event2_1[2], event2_2, event2_3;
+    cl_event event0_1[2], event0_2;
+    cl_event event2_1[2], event2_2, event2_3;
     cl_mem bufferQ, bufferK, bufferV, bufferPermuteQ, bufferPermuteK, bufferPermuteV;
     cl_mem bufferEinsumQK, bufferEinsumV, bufferOut;
 
     if (condition == nullptr) {
         condition = input;
     }
+    if (toQKVLinear != nullptr && condition != input) {
+        /* to_q, to_k, to_v Linear 는 만들지 않음 */
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "fused qkv needs condition == input");
+        return CL_INVALID_VALUE;
+    }
+
+    if (CpuBackend::isEnabled()) {
+        return forwardCpu(input, condition, output, num_events_in_list, event_wait_list, event);
+    }
 
     size_t inputBytes, inputSize, conditionBytes, conditionSize;
     err = clGetMemObjectInfo(input, CL_MEM_SIZE, sizeof(size_t), &inputBytes, nullptr);
@@ -102,251 +135,338 @@ CrossAttention::forward(cl_mem input, cl_mem condition, cl_mem output, cl_uint n
     inputSize = inputBytes / sizeof(float);
     conditionSize = conditionBytes / sizeof(float);
     size_t B = headSize;
-    size_t M = inputSize / toQLinear->weightShape[1];
-#if CROSS_ATTENTION_KERNEL_VERSION == 0 || CROSS_ATTENTION_KERNEL_VERSION == 1
-    size_t N_first = conditionSize / toKLinear->weightShape[1];
-#elif CROSS_ATTENTION_KERNEL_VERSION == 2
-    size_t N_first = conditionSize / toKLinear->weightShape[1];
-    if (N_first % WIDTH != 0) {
-        N_first += WIDTH - N_first % WIDTH;
+    size_t M = inputSize / queryDim;
+    auto version = KernelSelector::getInstance().select(KernelSelector::CROSS_ATTENTION, name,
+                                                        CROSS_ATTENTION_KERNEL_VERSION);
+    if (version < 0 || version > 3) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "[%s:%d] unknown version(%d)\n", __FILE__, __LINE__, version);
+        return CL_INVALID_VALUE;
     }
-#endif
-    size_t K_first = toQLinear->weightShape[0] / headSize;
-
-    bufferQ = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                             sizeof(float) * inputSize / toQLinear->weightShape[1] *
-                             toQLinear->weightShape[0],
-                             nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferK = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                             sizeof(float) * conditionSize / toKLinear->weightShape[1] *
-                             toKLinear->weightShape[0],
-                             nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferV = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                             sizeof(float) * conditionSize / toVLinear->weightShape[1] *
-                             toVLinear->weightShape[0],
-                             nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferPermuteQ = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * inputSize / toQLinear->weightShape[1] *
-                                    toQLinear->weightShape[0],
-                                    nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferPermuteK = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * B * K_first * N_first,
-                                    nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferPermuteV = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * conditionSize / toVLinear->weightShape[1] *
-                                    toVLinear->weightShape[0],
-                                    nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferEinsumQK = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * headSize *
-                                    inputSize / toQLinear->weightShape[1] *
-                                    conditionSize / toKLinear->weightShape[1],
-                                    nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferEinsumV = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   sizeof(float) * headSize *
-                                   inputSize / toQLinear->weightShape[1] *
-                                   toVLinear->weightShape[0] / headSize,
-                                   nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferOut = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                               sizeof(float) * headSize *
-                               inputSize / toQLinear->weightShape[1] *
-                               toVLinear->weightShape[0] / headSize,
-                               nullptr, &err);
-    CHECK_ERROR(err);
-
-
-    err = toQLinear->forward(input, bufferQ, num_events_in_list, event_wait_list, &event0_0);
-    CHECK_ERROR(err);
-
-    // max diff: 0.00001204013824462891
-    // util::testBuffer(cmdQueue, bufferQ, "unet/input_block/test/test_cross_q.npy");
-
-    err = toKLinear->forward(condition, bufferK, num_events_in_list, event_wait_list, &event1_0);
-    CHECK_ERROR(err);
-
-    if (cnt == 1) {
-        // max diff: 0.00000381469726562500
-        // util::testBuffer(cmdQueue, bufferK, "unet/input_block/test/test_basic_attn2_k.npy");
+    if (version == 3) {
+        return forwardStrided(input, condition, output, num_events_in_list, event_wait_list, event);
     }
 
-    err = toVLinear->forward(condition, bufferV, num_events_in_list, event_wait_list, &event2_0);
-    CHECK_ERROR(err);
-
-    err = clSetKernelArg(utilKernel->permute3D_1_0_2, 0, sizeof(cl_mem), &bufferQ);
-    err |= clSetKernelArg(utilKernel->permute3D_1_0_2, 1, sizeof(cl_mem), &bufferPermuteQ);
-    CHECK_ERROR(err);
-
-    /* assume batch size = 1 */
-    size_t permuteQGlobalSize[3] = {inputSize / toQLinear->weightShape[1], headSize,
-                                    toQLinear->weightShape[0] / headSize};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_1_0_2, 3, nullptr,
-                                 permuteQGlobalSize, nullptr, 1, &event0_0, &event0_1[0]);
-    CHECK_ERROR(err);
-
-    // max diff: 0.00001204013824462891
-    // util::testBuffer(cmdQueue, bufferPermuteQ, "unet/input_block/test/test_cross_q_permute.npy");
+    size_t N_first = conditionSize / contextDim;
+    if (version == 2 && N_first % WIDTH != 0) {
+        N_first += WIDTH - N_first % WIDTH;
+    }
+    size_t K_first = innerDim / headSize;
+
+    /* fused : bufferQ 가 to_qkv 결과 (M, 3 * inner), bufferK, bufferV 는 없음 */
+    bool fused = toQKVLinear != nullptr && condition == input;
+    bufferK = bufferV = nullptr;
+    bufferQ = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                     sizeof(float) * inputSize / queryDim *
+                                     innerDim * (fused ? 3 : 1),
+                                     nullptr, &err);
+    CHECK_ERROR(err);
+
+    if (!fused) {
+        bufferK = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                         sizeof(float) * conditionSize / contextDim *
+                                         innerDim,
+                                         nullptr, &err);
+        CHECK_ERROR(err);
+
+        bufferV = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                         sizeof(float) * conditionSize / contextDim *
+                                         innerDim,
+                                         nullptr, &err);
+        CHECK_ERROR(err);
+    }
 
-#if CROSS_ATTENTION_KERNEL_VERSION == 0 || CROSS_ATTENTION_KERNEL_VERSION == 1
-    err = clSetKernelArg(utilKernel->permute3D_1_0_2, 0, sizeof(cl_mem), &bufferK);
-    err |= clSetKernelArg(utilKernel->permute3D_1_0_2, 1, sizeof(cl_mem), &bufferPermuteK);
+    bufferPermuteQ = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                            sizeof(float) * inputSize / queryDim *
+                                            innerDim,
+                                            nullptr, &err);
     CHECK_ERROR(err);
 
-    size_t permuteKGlobalSize[3] = {conditionSize / toKLinear->weightShape[1], headSize,
-                                    toKLinear->weightShape[0] / headSize};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_1_0_2, 3, nullptr,
-                                 permuteKGlobalSize, nullptr, 1, &event1_0, &event0_1[1]);
+    bufferPermuteK = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                            sizeof(float) * B * K_first * N_first,
+                                            nullptr, &err);
     CHECK_ERROR(err);
 
-    // max diff: 0.00000947713851928711
-    // util::testBuffer(cmdQueue, bufferPermuteK, "unet/input_block/test/test_cross_k_permute.npy");
-#elif CROSS_ATTENTION_KERNEL_VERSION == 2
-    int permuteKDim[3] = {1, 2, 0};
-    err = clSetKernelArg(utilKernel->permute3D_copy, 0, sizeof(cl_mem), &bufferK);
-    err |= clSetKernelArg(utilKernel->permute3D_copy, 1, sizeof(cl_mem), &bufferPermuteK);
-    err |= clSetKernelArg(utilKernel->permute3D_copy, 2, sizeof(int), &permuteKDim[0]);
-    err |= clSetKernelArg(utilKernel->permute3D_copy, 3, sizeof(int), &permuteKDim[1]);
-    err |= clSetKernelArg(utilKernel->permute3D_copy, 4, sizeof(int), &permuteKDim[2]);
-    err |= clSetKernelArg(utilKernel->permute3D_copy, 5, sizeof(int), &N_first);
-    err |= clSetKernelArg(utilKernel->permute3D_copy, 6, sizeof(int), &B);
-    err |= clSetKernelArg(utilKernel->permute3D_copy, 7, sizeof(int), &K_first);
+    bufferPermuteV = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                            sizeof(float) * conditionSize / contextDim *
+                                            innerDim,
+                                            nullptr, &err);
     CHECK_ERROR(err);
 
-    size_t permuteKGlobalSize[3] = {conditionSize / toKLinear->weightShape[1], headSize,
-                                    toKLinear->weightShape[0] / headSize};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_copy, 3, nullptr,
-                                 permuteKGlobalSize, nullptr, 1, &event1_0, &event0_1[1]);
+    bufferEinsumQK = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                            sizeof(float) * headSize *
+                                            inputSize / queryDim *
+                                            conditionSize / contextDim,
+                                            nullptr, &err);
     CHECK_ERROR(err);
-#endif
 
-    err = clSetKernelArg(utilKernel->permute3D_1_0_2, 0, sizeof(cl_mem), &bufferV);
-    err |= clSetKernelArg(utilKernel->permute3D_1_0_2, 1, sizeof(cl_mem), &bufferPermuteV);
+    bufferEinsumV = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                           sizeof(float) * headSize *
+                                           inputSize / queryDim *
+                                           innerDim / headSize,
+                                           nullptr, &err);
     CHECK_ERROR(err);
 
-    size_t permuteVGlobalSize[3] = {conditionSize / toVLinear->weightShape[1], headSize,
-                                    toVLinear->weightShape[0] / headSize};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_1_0_2, 3, nullptr,
-                                 permuteVGlobalSize, nullptr, 1, &event2_0, &event2_1[0]);
+    bufferOut = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                       sizeof(float) * headSize *
+                                       inputSize / queryDim *
+                                       innerDim / headSize,
+                                       nullptr, &err);
     CHECK_ERROR(err);
 
-#if CROSS_ATTENTION_KERNEL_VERSION == 0
-    size_t kSize = toQLinear->weightShape[0] / headSize;
-    err = clSetKernelArg(crossAttentionKernel->einsum_bik_bjk_bij, 0, sizeof(cl_mem), &bufferPermuteQ);
-    err |= clSetKernelArg(crossAttentionKernel->einsum_bik_bjk_bij, 1, sizeof(cl_mem), &bufferPermuteK);
-    err |= clSetKernelArg(crossAttentionKernel->einsum_bik_bjk_bij, 2, sizeof(cl_mem), &bufferEinsumQK);
-    err |= clSetKernelArg(crossAttentionKernel->einsum_bik_bjk_bij, 3, sizeof(size_t), &kSize);
-    err |= clSetKernelArg(crossAttentionKernel->einsum_bik_bjk_bij, 4, sizeof(float), &scale);
-    CHECK_ERROR(err);
 
-    size_t einsumQKGlobalSize[3] = {headSize, inputSize / toQLinear->weightShape[1],
-                                    conditionSize / toKLinear->weightShape[1]};
-    err = clEnqueueNDRangeKernel(cmdQueue, crossAttentionKernel->einsum_bik_bjk_bij, 3, nullptr,
-                                 einsumQKGlobalSize, nullptr, 2, event0_1, &event0_2);
-    CHECK_ERROR(err);
-#elif CROSS_ATTENTION_KERNEL_VERSION == 1
-    int reg_size_m = 8;
-    std::vector<size_t> tile_size_ms = {128};
-    std::vector<size_t> tile_size_ns = {32, 11, 1};
-
-    int m_index;
-    for (m_index = 0; m_index < tile_size_ms.size(); m_index++) {
-        if (M % (tile_size_ms[m_index]) == 0) {
-            break;
-        } else if (m_index == tile_size_ms.size() - 1) {
-            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] M(%ld) %% tile_size_m != 0\n", __FILE__,
-                            __LINE__, M);
-            return CL_INVALID_VALUE;
-        }
+    /* to_q / to_k / to_v 와 permute 는 서로 독립인 3 개의 branch */
+    Graph graph({cmdQueue});
+    graph.input(input, num_events_in_list, event_wait_list);
+    if (condition != input) {
+        graph.input(condition, num_events_in_list, event_wait_list);
     }
 
-    int n_index;
-    for (n_index = 0; n_index < tile_size_ns.size(); n_index++) {
-        if (N_first % (tile_size_ns[n_index]) == 0) {
-            break;
-        } else if (n_index == tile_size_ns.size() - 1) {
-            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] N(%ld) %% tile_size_n != 0\n", __FILE__,
-                            __LINE__, N_first);
-            return CL_INVALID_VALUE;
+    if (fused) {
+        graph.add("to_qkv", {input}, {bufferQ},
+                  [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      Tracer::Scope scope("to_qkv");
+                      return toQKVLinear->forward(input, bufferQ, num_events, wait_list, e);
+                  });
+
+        graph.add("split_qkv", {bufferQ}, {bufferPermuteQ, bufferPermuteK, bufferPermuteV},
+                  [&](cl_command_queue queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      cl_int err;
+                      auto kernel = crossAttentionKernel->split_qkv_heads;
+                      /* version 2 : K 는 (B, K_first, N_first) */
+                      int transposeK = version == 2;
+                      int ldk = static_cast<int>(N_first);
+                      err = record::clSetKernelArg(kernel, 0, sizeof(cl_mem), &bufferQ);
+                      err |= record::clSetKernelArg(kernel, 1, sizeof(cl_mem), &bufferPermuteQ);
+                      err |= record::clSetKernelArg(kernel, 2, sizeof(cl_mem), &bufferPermuteK);
+                      err |= record::clSetKernelArg(kernel, 3, sizeof(cl_mem), &bufferPermuteV);
+                      err |= record::clSetKernelArg(kernel, 4, sizeof(int), &transposeK);
+                      err |= record::clSetKernelArg(kernel, 5, sizeof(int), &ldk);
+                      CHECK_ERROR(err);
+
+                      size_t splitGlobalSize[3] = {M, B, K_first};
+                      err = record::clEnqueueNDRangeKernel(queue, kernel, 3, nullptr,
+                                                           splitGlobalSize, nullptr, num_events,
+                                                           wait_list, e);
+                      CHECK_ERROR(err);
+                      Tracer::getInstance().record("split_qkv_heads", *e);
+                      return CL_SUCCESS;
+                  });
+    } else {
+        graph.add("to_q", {input}, {bufferQ},
+                  [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      Tracer::Scope scope("to_q");
+                      return toQLinear->forward(input, bufferQ, num_events, wait_list, e);
+                  });
+
+        // max diff: 0.00001204013824462891
+        // util::testBuffer(cmdQueue, bufferQ, "unet/input_block/test/test_cross_q.npy");
+
+        graph.add("to_k", {condition}, {bufferK},
+                  [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      Tracer::Scope scope("to_k");
+                      return toKLinear->forward(condition, bufferK, num_events, wait_list, e);
+                  });
+
+        if (cnt == 1) {
+            // max diff: 0.00000381469726562500
+            // util::testBuffer(cmdQueue, bufferK, "unet/input_block/test/test_basic_attn2_k.npy");
         }
-    }
-    size_t tile_size_m = tile_size_ms[m_index];
-    size_t tile_size_n = tile_size_ns[n_index];
-    size_t kSize = toQLinear->weightShape[0] / headSize;
 
-    err = clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bjk_bij, 0, sizeof(cl_mem), &bufferPermuteQ);
-    err |= clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bjk_bij, 1, sizeof(cl_mem), &bufferPermuteK);
-    err |= clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bjk_bij, 2, sizeof(cl_mem), &bufferEinsumQK);
-    err |= clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bjk_bij, 3, sizeof(int), &kSize);
-    err |= clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bjk_bij, 4, sizeof(float), &scale);
-    CHECK_ERROR(err);
+        graph.add("to_v", {condition}, {bufferV},
+                  [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      Tracer::Scope scope("to_v");
+                      return toVLinear->forward(condition, bufferV, num_events, wait_list, e);
+                  });
+
+        /* assume batch size = 1 */
+        graph.add("permute_q", {bufferQ}, {bufferPermuteQ},
+                  [&](cl_command_queue queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      cl_int err;
+                      err = record::clSetKernelArg(utilKernel->permute3D_1_0_2, 0, sizeof(cl_mem), &bufferQ);
+                      err |= record::clSetKernelArg(utilKernel->permute3D_1_0_2, 1, sizeof(cl_mem), &bufferPermuteQ);
+                      CHECK_ERROR(err);
+
+                      size_t permuteQGlobalSize[3] = {inputSize / queryDim, headSize,
+                                                      innerDim / headSize};
+                      err = record::clEnqueueNDRangeKernel(queue, utilKernel->permute3D_1_0_2, 3, nullptr,
+                                                           permuteQGlobalSize, nullptr, num_events, wait_list, e);
+                      CHECK_ERROR(err);
+                      Tracer::getInstance().record("permute3D_1_0_2", *e);
+                      return CL_SUCCESS;
+                  });
+
+        // max diff: 0.00001204013824462891
+        // util::testBuffer(cmdQueue, bufferPermuteQ, "unet/input_block/test/test_cross_q_permute.npy");
+
+        graph.add("permute_k", {bufferK}, {bufferPermuteK},
+                  [&](cl_command_queue queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      cl_int err;
+                      size_t permuteKGlobalSize[3] = {conditionSize / contextDim, headSize,
+                                                      innerDim / headSize};
+                      if (version == 0 || version == 1) {
+                          err = record::clSetKernelArg(utilKernel->permute3D_1_0_2, 0, sizeof(cl_mem), &bufferK);
+                          err |= record::clSetKernelArg(utilKernel->permute3D_1_0_2, 1, sizeof(cl_mem), &bufferPermuteK);
+                          CHECK_ERROR(err);
+
+                          err = record::clEnqueueNDRangeKernel(queue, utilKernel->permute3D_1_0_2, 3, nullptr,
+                                                               permuteKGlobalSize, nullptr, num_events, wait_list, e);
+                          CHECK_ERROR(err);
+                          Tracer::getInstance().record("permute3D_1_0_2", *e);
+
+                          // max diff: 0.00000947713851928711
+                          // util::testBuffer(cmdQueue, bufferPermuteK, "unet/input_block/test/test_cross_k_permute.npy");
+                      } else {
+                          int permuteKDim[3] = {1, 2, 0};
+                          err = record::clSetKernelArg(utilKernel->permute3D_copy, 0, sizeof(cl_mem), &bufferK);
+                          err |= record::clSetKernelArg(utilKernel->permute3D_copy, 1, sizeof(cl_mem), &bufferPermuteK);
+                          err |= record::clSetKernelArg(utilKernel->permute3D_copy, 2, sizeof(int), &permuteKDim[0]);
+                          err |= record::clSetKernelArg(utilKernel->permute3D_copy, 3, sizeof(int), &permuteKDim[1]);
+                          err |= record::clSetKernelArg(utilKernel->permute3D_copy, 4, sizeof(int), &permuteKDim[2]);
+                          err |= record::clSetKernelArg(utilKernel->permute3D_copy, 5, sizeof(int), &N_first);
+                          err |= record::clSetKernelArg(utilKernel->permute3D_copy, 6, sizeof(int), &B);
+                          err |= record::clSetKernelArg(utilKernel->permute3D_copy, 7, sizeof(int), &K_first);
+                          CHECK_ERROR(err);
+
+                          err = record::clEnqueueNDRangeKernel(queue, utilKernel->permute3D_copy, 3, nullptr,
+                                                               permuteKGlobalSize, nullptr, num_events, wait_list, e);
+                          CHECK_ERROR(err);
+                          Tracer::getInstance().record("permute3D_copy", *e);
+                      }
+                      return CL_SUCCESS;
+                  });
+
+        graph.add("permute_v", {bufferV}, {bufferPermuteV},
+                  [&](cl_command_queue queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      cl_int err;
+                      err = record::clSetKernelArg(utilKernel->permute3D_1_0_2, 0, sizeof(cl_mem), &bufferV);
+                      err |= record::clSetKernelArg(utilKernel->permute3D_1_0_2, 1, sizeof(cl_mem), &bufferPermuteV);
+                      CHECK_ERROR(err);
+
+                      size_t permuteVGlobalSize[3] = {conditionSize / contextDim, headSize,
+                                                      innerDim / headSize};
+                      err = record::clEnqueueNDRangeKernel(queue, utilKernel->permute3D_1_0_2, 3, nullptr,
+                                                           permuteVGlobalSize, nullptr, num_events, wait_list, e);
+                      CHECK_ERROR(err);
+                      Tracer::getInstance().record("permute3D_1_0_2", *e);
+                      return CL_SUCCESS;
+                  });
+    }
 
-    size_t einsumQKGlobalSize[3] = {B, M / reg_size_m, N_first };
-    size_t einsumQKLocalSize[3] = {1, tile_size_m / reg_size_m, tile_size_n };
-    err = clEnqueueNDRangeKernel(cmdQueue, crossAttentionKernel->optimized_einsum_bik_bjk_bij, 3, nullptr,
-                                 einsumQKGlobalSize, einsumQKLocalSize, 2, event0_1, &event0_2);
-    CHECK_ERROR(err);
-#elif CROSS_ATTENTION_KERNEL_VERSION == 2
-    int reg_size_m = 4;
-    std::vector<size_t> tile_size_ms = {32};
-    std::vector<size_t> tile_size_ns = {80, 64, 11, 1};
-
-    int m_index;
-    for (m_index = 0; m_index < tile_size_ms.size(); m_index++) {
-        if (M % (tile_size_ms[m_index]) == 0) {
-            break;
-        } else if (m_index == tile_size_ms.size() - 1) {
-            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+    err = graph.run();
+    CHECK_ERROR(err);
+    err = graph.getEvent(bufferPermuteQ, &event0_1[0]);
+    err |= graph.getEvent(bufferPermuteK, &event0_1[1]);
+    err |= graph.getEvent(bufferPermuteV, &event2_1[0]);
+    CHECK_ERROR(err);
+
+    if (version == 0) {
+        size_t kSize = innerDim / headSize;
+        err = record::clSetKernelArg(crossAttentionKernel->einsum_bik_bjk_bij, 0, sizeof(cl_mem), &bufferPermuteQ);
+        err |= record::clSetKernelArg(crossAttentionKernel->einsum_bik_bjk_bij, 1, sizeof(cl_mem), &bufferPermuteK);
+        err |= record::clSetKernelArg(crossAttentionKernel->einsum_bik_bjk_bij, 2, sizeof(cl_mem), &bufferEinsumQK);
+        err |= record::clSetKernelArg(crossAttentionKernel->einsum_bik_bjk_bij, 3, sizeof(size_t), &kSize);
+        err |= record::clSetKernelArg(crossAttentionKernel->einsum_bik_bjk_bij, 4, sizeof(float), &scale);
+        CHECK_ERROR(err);
+
+        size_t einsumQKGlobalSize[3] = {headSize, inputSize / queryDim,
+                                        conditionSize / contextDim};
+        err = record::clEnqueueNDRangeKernel(cmdQueue, crossAttentionKernel->einsum_bik_bjk_bij, 3, nullptr,
+                                             einsumQKGlobalSize, nullptr, 2, event0_1, &event0_2);
+        CHECK_ERROR(err);
+        Tracer::getInstance().record("einsum_bik_bjk_bij", event0_2);
+    } else if (version == 1) {
+        int reg_size_m = 8;
+        std::vector<size_t> tile_size_ms = {128};
+        std::vector<size_t> tile_size_ns = {32, 11, 1};
+
+        int m_index;
+        for (m_index = 0; m_index < tile_size_ms.size(); m_index++) {
+            if (M % (tile_size_ms[m_index]) == 0) {
+                break;
+            } else if (m_index == tile_size_ms.size() - 1) {
+                __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
                                 "[%s:%d] M(%ld) %% tile_size_m != 0\n", __FILE__,
                                 __LINE__, M);
-            return CL_INVALID_VALUE;
+                return CL_INVALID_VALUE;
+            }
         }
-    }
 
-    int n_index;
-    for (n_index = 0; n_index < tile_size_ns.size(); n_index++) {
-        if (N_first % (tile_size_ns[n_index]) == 0) {
-            break;
-        } else if (n_index == tile_size_ns.size() - 1) {
-            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+        int n_index;
+        for (n_index = 0; n_index < tile_size_ns.size(); n_index++) {
+            if (N_first % (tile_size_ns[n_index]) == 0) {
+                break;
+            } else if (n_index == tile_size_ns.size() - 1) {
+                __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
                                 "[%s:%d] N(%ld) %% tile_size_n != 0\n", __FILE__,
                                 __LINE__, N_first);
-            return CL_INVALID_VALUE;
+                return CL_INVALID_VALUE;
+            }
+        }
+        size_t tile_size_m = tile_size_ms[m_index];
+        size_t tile_size_n = tile_size_ns[n_index];
+        size_t kSize = innerDim / headSize;
+
+        err = record::clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bjk_bij, 0, sizeof(cl_mem), &bufferPermuteQ);
+        err |= record::clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bjk_bij, 1, sizeof(cl_mem), &bufferPermuteK);
+        err |= record::clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bjk_bij, 2, sizeof(cl_mem), &bufferEinsumQK);
+        err |= record::clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bjk_bij, 3, sizeof(int), &kSize);
+        err |= record::clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bjk_bij, 4, sizeof(float), &scale);
+        CHECK_ERROR(err);
+
+        size_t einsumQKGlobalSize[3] = {B, M / reg_size_m, N_first };
+        size_t einsumQKLocalSize[3] = {1, tile_size_m / reg_size_m, tile_size_n };
+        err = record::clEnqueueNDRangeKernel(cmdQueue, crossAttentionKernel->optimized_einsum_bik_bjk_bij, 3, nullptr,
+                                             einsumQKGlobalSize, einsumQKLocalSize, 2, event0_1, &event0_2);
+        CHECK_ERROR(err);
+        Tracer::getInstance().record("optimized_einsum_bik_bjk_bij", event0_2);
+    } else if (version == 2) {
+        int reg_size_m = 4;
+        std::vector<size_t> tile_size_ms = {32};
+        std::vector<size_t> tile_size_ns = {80, 64, 11, 1};
+
+        int m_index;
+        for (m_index = 0; m_index < tile_size_ms.size(); m_index++) {
+            if (M % (tile_size_ms[m_index]) == 0) {
+                break;
+            } else if (m_index == tile_size_ms.size() - 1) {
+                __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                                    "[%s:%d] M(%ld) %% tile_size_m != 0\n", __FILE__,
+                                    __LINE__, M);
+                return CL_INVALID_VALUE;
+            }
         }
-    }
-    size_t tile_size_m = tile_size_ms[m_index];
-    size_t tile_size_n = tile_size_ns[n_index];
-    size_t N_first_orig = conditionSize / toKLinear->weightShape[1];
-
-    err = clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 0, sizeof(cl_mem), &bufferPermuteQ);
-    err |= clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 1, sizeof(cl_mem), &bufferPermuteK);
-    err |= clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 2, sizeof(cl_mem), &bufferEinsumQK);
-    err |= clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 3, sizeof(int), &N_first_orig);
-    err |= clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 4, sizeof(int), &K_first);
-    err |= clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 5, sizeof(float), &scale);
-    CHECK_ERROR(err);
 
-    size_t einsumQKGlobalSize[3] = {B, M / reg_size_m, N_first / WIDTH};
-    size_t einsumQKLocalSize[3] = {1, tile_size_m / reg_size_m, tile_size_n / WIDTH };
-    err = clEnqueueNDRangeKernel(cmdQueue, crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 3, nullptr,
-                                 einsumQKGlobalSize, einsumQKLocalSize, 2, event0_1, &event0_2);
-    CHECK_ERROR(err);
-#endif
+        int n_index;
+        for (n_index = 0; n_index < tile_size_ns.size(); n_index++) {
+            if (N_first % (tile_size_ns[n_index]) == 0) {
+                break;
+            } else if (n_index == tile_size_ns.size() - 1) {
+                __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                                    "[%s:%d] N(%ld) %% tile_size_n != 0\n", __FILE__,
+                                    __LINE__, N_first);
+                return CL_INVALID_VALUE;
+            }
+        }
+        size_t tile_size_m = tile_size_ms[m_index];
+        size_t tile_size_n = tile_size_ns[n_index];
+        size_t N_first_orig = conditionSize / contextDim;
+
+        err = record::clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 0, sizeof(cl_mem), &bufferPermuteQ);
+        err |= record::clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 1, sizeof(cl_mem), &bufferPermuteK);
+        err |= record::clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 2, sizeof(cl_mem), &bufferEinsumQK);
+        err |= record::clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 3, sizeof(int), &N_first_orig);
+        err |= record::clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 4, sizeof(int), &K_first);
+        err |= record::clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 5, sizeof(float), &scale);
+        CHECK_ERROR(err);
+
+        size_t einsumQKGlobalSize[3] = {B, M / reg_size_m, N_first / WIDTH};
+        size_t einsumQKLocalSize[3] = {1, tile_size_m / reg_size_m, tile_size_n / WIDTH };
+        err = record::clEnqueueNDRangeKernel(cmdQueue, crossAttentionKernel->optimized_einsum_bik_bkj_bij_general, 3, nullptr,
+                                             einsumQKGlobalSize, einsumQKLocalSize, 2, event0_1, &event0_2);
+        CHECK_ERROR(err);
+        Tracer::getInstance().record("optimized_einsum_bik_bkj_bij_general", event0_2);
+    }
 
     if (cnt == 0) {
         // max diff: 0.00001931190490722656
@@ -355,93 +475,113 @@ CrossAttention::forward(cl_mem input, cl_mem condition, cl_mem output, cl_uint n
     // max diff: 0.00003862380981445312
     // util::testBuffer(cmdQueue, bufferEinsumQK, "unet/input_block/test/test_basic_attn2_einsum_qk.npy");
 
-    size_t chunkSize = conditionSize / toKLinear->weightShape[1];
+    size_t chunkSize = conditionSize / contextDim;
     size_t workGroupSize = WORK_GROUP_SIZE;
 //    if (chunkSize % WORK_GROUP_SIZE == 0) {
 //        workGroupSize = WORK_GROUP_SIZE;
 //    } else {
 //        workGroupSize = chunkSize;
 //    }
-    err = clSetKernelArg(utilKernel->softmax, 0, sizeof(cl_mem), &bufferEinsumQK);
-    err |= clSetKernelArg(utilKernel->softmax, 1, sizeof(cl_mem), &bufferEinsumQK);
-    err |= clSetKernelArg(utilKernel->softmax, 2, sizeof(float) * workGroupSize, nullptr);
-    err |= clSetKernelArg(utilKernel->softmax, 3, sizeof(float) * chunkSize, nullptr);
-    err |= clSetKernelArg(utilKernel->softmax, 4, sizeof(size_t), &chunkSize);
+    auto softmax = SOFTMAX_KERNEL_VERSION == 1 ? utilKernel->softmax_online : utilKernel->softmax;
+    err = record::clSetKernelArg(softmax, 0, sizeof(cl_mem), &bufferEinsumQK);
+    err |= record::clSetKernelArg(softmax, 1, sizeof(cl_mem), &bufferEinsumQK);
+    err |= record::clSetKernelArg(softmax, 2, sizeof(float) * workGroupSize, nullptr);
+    if (SOFTMAX_KERNEL_VERSION == 1) {
+        int rowSize = static_cast<int>(chunkSize);
+        err |= record::clSetKernelArg(softmax, 3, sizeof(float) * workGroupSize, nullptr);
+        err |= record::clSetKernelArg(softmax, 4, sizeof(int), &rowSize);
+    } else {
+        err |= record::clSetKernelArg(softmax, 3, sizeof(float) * chunkSize, nullptr);
+        err |= record::clSetKernelArg(softmax, 4, sizeof(size_t), &chunkSize);
+    }
     CHECK_ERROR(err);
 
     size_t softmaxGlobalSize[1] = {
-            headSize * (inputSize / toQLinear->weightShape[1]) * workGroupSize
+            headSize * (inputSize / queryDim) * workGroupSize
     };
     size_t softmaxLocalSize[1] = {workGroupSize};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->softmax, 1, nullptr,
-                                 softmaxGlobalSize, softmaxLocalSize, 1, &event0_2, &event2_1[1]);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, softmax, 1, nullptr,
+                                         softmaxGlobalSize, softmaxLocalSize, 1, &event0_2, &event2_1[1]);
     CHECK_ERROR(err);
+    Tracer::getInstance().record(SOFTMAX_KERNEL_VERSION == 1 ? "softmax_online" : "softmax",
+                                 event2_1[1]);
 
     // max diff: 0.00000052154064178467
     // util::testBuffer(cmdQueue, bufferEinsumQK, "unet/input_block/test/test_cross_softmax.npy");
     // max diff: 0.00000250339508056641
     // util::testBuffer(cmdQueue, bufferEinsumQK, "unet/input_block/test/test_basic_attn2_softmax.npy");
 
-#if CROSS_ATTENTION_KERNEL_VERSION == 0
-    size_t jSize = conditionSize / toKLinear->weightShape[1];
-    err = clSetKernelArg(crossAttentionKernel->einsum_bij_bjk_bik, 0, sizeof(cl_mem), &bufferEinsumQK);
-    err |= clSetKernelArg(crossAttentionKernel->einsum_bij_bjk_bik, 1, sizeof(cl_mem), &bufferPermuteV);
-    err |= clSetKernelArg(crossAttentionKernel->einsum_bij_bjk_bik, 2, sizeof(cl_mem), &bufferEinsumV);
-    err |= clSetKernelArg(crossAttentionKernel->einsum_bij_bjk_bik, 3, sizeof(size_t), &jSize);
-    CHECK_ERROR(err);
-
-    size_t einsumVGlobalSize[3] = {headSize, inputSize / toQLinear->weightShape[1],
-                                   toVLinear->weightShape[0] / headSize};
-    err = clEnqueueNDRangeKernel(cmdQueue, crossAttentionKernel->einsum_bij_bjk_bik, 3, nullptr,
-                                 einsumVGlobalSize, nullptr, 2, event2_1, &event2_2);
-    CHECK_ERROR(err);
-#elif CROSS_ATTENTION_KERNEL_VERSION == 1 || CROSS_ATTENTION_KERNEL_VERSION == 2
-    int reg_size_m_2 = 4;
-    int WIDTH_2 = 4;
-    std::vector<size_t> tile_size_ms_2 = {32};
-    std::vector<size_t> tile_size_ns_2 = {64, 11, 1};
-
-    size_t N_2 = toVLinear->weightShape[0] / headSize;
-
-    int m_index_2;
-    for (m_index_2 = 0; m_index_2 < tile_size_ms_2.size(); m_index_2++) {
-        if (M % (tile_size_ms_2[m_index_2]) == 0) {
-            break;
-        } else if (m_index_2 == tile_size_ms_2.size() - 1) {
-            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                                "[%s:%d] M(%ld) %% tile_size_m_2 != 0\n", __FILE__,
-                                __LINE__, M);
-            return CL_INVALID_VALUE;
+    if (version == 0) {
+        size_t jSize = conditionSize / contextDim;
+        err = record::clSetKernelArg(crossAttentionKernel->einsum_bij_bjk_bik, 0, sizeof(cl_mem), &bufferEinsumQK);
+        err |= record::clSetKernelArg(crossAttentionKernel->einsum_bij_bjk_bik, 1, sizeof(cl_mem), &bufferPermuteV);
+        err |= record::clSetKernelArg(crossAttentionKernel->einsum_bij_bjk_bik, 2, sizeof(cl_mem), &bufferEinsumV);
+        err |= record::clSetKernelArg(crossAttentionKernel->einsum_bij_bjk_bik, 3, sizeof(size_t), &jSize);
+        CHECK_ERROR(err);
+
+        size_t einsumVGlobalSize[3] = {headSize, inputSize / queryDim,
+                                       innerDim / headSize};
+        err = record::clEnqueueNDRangeKernel(cmdQueue, crossAttentionKernel->einsum_bij_bjk_bik, 3, nullptr,
+                                             einsumVGlobalSize, nullptr, 2, event2_1, &event2_2);
+        CHECK_ERROR(err);
+        Tracer::getInstance().record("einsum_bij_bjk_bik", event2_2);
+    } else if (version == 1 || version == 2) {
+        int reg_size_m_2 = 4;
+        int WIDTH_2 = 4;
+        std::vector<size_t> tile_size_ms_2 = {32};
+        std::vector<size_t> tile_size_ns_2 = {64, 11, 1};
+
+        size_t N_2 = innerDim / headSize;
+
+        int m_index_2;
+        for (m_index_2 = 0; m_index_2 < tile_size_ms_2.size(); m_index_2++) {
+            if (M % (tile_size_ms_2[m_index_2]) == 0) {
+                break;
+            } else if (m_index_2 == tile_size_ms_2.size() - 1) {
+                __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                                    "[%s:%d] M(%ld) %% tile_size_m_2 != 0\n", __FILE__,
+                                    __LINE__, M);
+                return CL_INVALID_VALUE;
+            }
         }
-    }
 
-    int n_index_2;
-    for (n_index_2 = 0; n_index_2 < tile_size_ns_2.size(); n_index_2++) {
-        if (N_2 % (tile_size_ns_2[n_index_2]) == 0) {
-            break;
-        } else if (n_index_2 == tile_size_ns_2.size() - 1) {
-            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                                "[%s:%d] N_2(%ld) %% tile_size_n_2 != 0\n", __FILE__,
-                                __LINE__, N_2);
-            return CL_INVALID_VALUE;
+        int n_index_2;
+        for (n_index_2 = 0; n_index_2 < tile_size_ns_2.size(); n_index_2++) {
+            if (N_2 % (tile_size_ns_2[n_index_2]) == 0) {
+                break;
+            } else if (n_index_2 == tile_size_ns_2.size() - 1) {
+                __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                                    "[%s:%d] N_2(%ld) %% tile_size_n_2 != 0\n", __FILE__,
+                                    __LINE__, N_2);
+                return CL_INVALID_VALUE;
+            }
+        }
+        size_t tile_size_m_2 = tile_size_ms_2[m_index_2];
+        size_t tile_size_n_2 = tile_size_ns_2[n_index_2];
+        size_t kSize_2 = conditionSize / contextDim;
+
+        /* SHAPE_SPECIALIZE_MODE: K, M, N, tile size 를 상수로 build 한 variant */
+        cl_kernel einsumV = crossAttentionKernel->optimized_einsum_bik_bkj_bij_specialized.get(
+                {{"WIDTH", (size_t) WIDTH_2}, {"EINSUM_K", kSize_2}, {"EINSUM_M", M},
+                 {"EINSUM_N", N_2}, {"EINSUM_LOCAL_M", tile_size_m_2 / reg_size_m_2},
+                 {"EINSUM_LOCAL_N", tile_size_n_2 / WIDTH_2}});
+        if (einsumV == nullptr) {
+            einsumV = crossAttentionKernel->optimized_einsum_bik_bkj_bij;
         }
-    }
-    size_t tile_size_m_2 = tile_size_ms_2[m_index_2];
-    size_t tile_size_n_2 = tile_size_ns_2[n_index_2];
-    size_t kSize_2 = conditionSize / toKLinear->weightShape[1];
-
-    err = clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij, 0, sizeof(cl_mem), &bufferEinsumQK);
-    err |= clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij, 1, sizeof(cl_mem), &bufferPermuteV);
-    err |= clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij, 2, sizeof(cl_mem), &bufferEinsumV);
-    err |= clSetKernelArg(crossAttentionKernel->optimized_einsum_bik_bkj_bij, 3, sizeof(int), &kSize_2);
-    CHECK_ERROR(err);
 
-    size_t einsumVGlobalSize[3] = {B, M / reg_size_m_2, N_2 / WIDTH_2};
-    size_t einsumVLocalSize[3] = {1, tile_size_m_2 / reg_size_m_2, tile_size_n_2 / WIDTH_2 };
-    err = clEnqueueNDRangeKernel(cmdQueue, crossAttentionKernel->optimized_einsum_bik_bkj_bij, 3, nullptr,
-                                 einsumVGlobalSize, einsumVLocalSize, 2, event2_1, &event2_2);
-    CHECK_ERROR(err);
-#endif
+        err = record::clSetKernelArg(einsumV, 0, sizeof(cl_mem), &bufferEinsumQK);
+        err |= record::clSetKernelArg(einsumV, 1, sizeof(cl_mem), &bufferPermuteV);
+        err |= record::clSetKernelArg(einsumV, 2, sizeof(cl_mem), &bufferEinsumV);
+        err |= record::clSetKernelArg(einsumV, 3, sizeof(int), &kSize_2);
+        CHECK_ERROR(err);
+
+        size_t einsumVGlobalSize[3] = {B, M / reg_size_m_2, N_2 / WIDTH_2};
+        size_t einsumVLocalSize[3] = {1, tile_size_m_2 / reg_size_m_2, tile_size_n_2 / WIDTH_2 };
+        err = record::clEnqueueNDRangeKernel(cmdQueue, einsumV, 3, nullptr,
+                                             einsumVGlobalSize, einsumVLocalSize, 2, event2_1, &event2_2);
+        CHECK_ERROR(err);
+        Tracer::getInstance().record("optimized_einsum_bik_bkj_bij", event2_2);
+    }
 
     if (cnt == 0) {
         // max diff: 0.00000193715095520020
@@ -452,23 +592,27 @@ CrossAttention::forward(cl_mem input, cl_mem condition, cl_mem output, cl_uint n
         // util::testBuffer(cmdQueue, bufferEinsumV,"unet/input_block/test/test_basic_attn2_einsum_v.npy");
     }
 
-    err = clSetKernelArg(utilKernel->permute3D_1_0_2, 0, sizeof(cl_mem), &bufferEinsumV);
-    err |= clSetKernelArg(utilKernel->permute3D_1_0_2, 1, sizeof(cl_mem), &bufferOut);
+    err = record::clSetKernelArg(utilKernel->permute3D_1_0_2, 0, sizeof(cl_mem), &bufferEinsumV);
+    err |= record::clSetKernelArg(utilKernel->permute3D_1_0_2, 1, sizeof(cl_mem), &bufferOut);
     CHECK_ERROR(err);
 
     size_t permuteOutGlobalSize[3] = {headSize,
-                                      (inputSize / toQLinear->weightShape[1]),
-                                      (toVLinear->weightShape[0] / headSize)};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_1_0_2, 3, nullptr,
-                                 permuteOutGlobalSize, nullptr, 1, &event2_2, &event2_3);
+                                      (inputSize / queryDim),
+                                      (innerDim / headSize)};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_1_0_2, 3, nullptr,
+                                         permuteOutGlobalSize, nullptr, 1, &event2_2, &event2_3);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("permute3D_1_0_2", event2_3);
 
     if (cnt == 1) {
         // max diff: 0.00001007318496704102
         // util::testBuffer(cmdQueue, bufferOut, "unet/input_block/test/test_basic_attn2_out.npy");
     }
 
-    err = toOutLinear->forward(bufferOut, output, 1, &event2_3, event);
+    {
+        Tracer::Scope scope("to_out");
+        err = toOutLinear->forward(bufferOut, output, 1, &event2_3, event);
+    }
     CHECK_ERROR(err);
 
     // max diff: 0.00000205636024475098
@@ -482,43 +626,331 @@ CrossAttention::forward(cl_mem input, cl_mem condition, cl_mem output, cl_uint n
             "0, CrossAttention, " +
             std::to_string(cnt) + ", " +
             std::to_string(headSize) + ", " +
-            std::to_string(inputSize / toQLinear->weightShape[1]) + ", " +
-            std::to_string(conditionSize / toKLinear->weightShape[1]) + ", " +
+            std::to_string(inputSize / queryDim) + ", " +
+            std::to_string(conditionSize / contextDim) + ", " +
             std::to_string(K_first) + ", " +
-            #if CROSS_ATTENTION_KERNEL_VERSION == 0
-            std::to_string(jSize) + ", " +
-            #elif CROSS_ATTENTION_KERNEL_VERSION == 1 || CROSS_ATTENTION_KERNEL_VERSION == 2
-            std::to_string(kSize_2) + ", " +
-            #endif
-            std::to_string(toVLinear->weightShape[0] / headSize) + ", " +
+            std::to_string(conditionSize / contextDim) + ", " +
+            std::to_string(innerDim / headSize) + ", " +
             std::to_string(chunkSize) + ", " +
-            std::to_string(headSize * (inputSize / toQLinear->weightShape[1]) * chunkSize);
+            std::to_string(headSize * (inputSize / queryDim) * chunkSize);
     util::printEventTime(message + ", einsum_bik_bjk_bij", event0_2);
     util::printEventTime(message + ", softmax", event2_1[1]);
     util::printEventTime(message + ", einsum_bij_bjk_bik", event2_2);
 #endif
 
-    clReleaseEvent(event0_0);
     clReleaseEvent(event0_1[0]);
     clReleaseEvent(event0_1[1]);
     clReleaseEvent(event0_2);
-    clReleaseEvent(event1_0);
-    clReleaseEvent(event2_0);
     clReleaseEvent(event2_1[0]);
     clReleaseEvent(event2_1[1]);
     clReleaseEvent(event2_2);
     clReleaseEvent(event2_3);
-    clReleaseMemObject(bufferQ);
-    clReleaseMemObject(bufferK);
-    clReleaseMemObject(bufferV);
-    clReleaseMemObject(bufferPermuteQ);
-    clReleaseMemObject(bufferPermuteK);
-    clReleaseMemObject(bufferPermuteV);
-    clReleaseMemObject(bufferEinsumQK);
-    clReleaseMemObject(bufferEinsumV);
-    clReleaseMemObject(bufferOut);
+    record::clReleaseMemObject(bufferQ);
+    if (!fused) {
+        record::clReleaseMemObject(bufferK);
+        record::clReleaseMemObject(bufferV);
+    }
+    record::clReleaseMemObject(bufferPermuteQ);
+    record::clReleaseMemObject(bufferPermuteK);
+    record::clReleaseMemObject(bufferPermuteV);
+    record::clReleaseMemObject(bufferEinsumQK);
+    record::clReleaseMemObject(bufferEinsumV);
+    record::clReleaseMemObject(bufferOut);
     cnt += 1;
     return CL_SUCCESS;
 }
 
-int CrossAttention::cnt = 0;
\ No newline at end of file
+cl_int CrossAttention::forwardStrided(cl_mem input, cl_mem condition, cl_mem output,
+                                      cl_uint num_events_in_list, const cl_event *event_wait_list,
+                                      cl_event *event) {
+    cl_int err;
+    cl_event event0[3], event1, event2, event3;
+    cl_mem bufferQ, bufferK, bufferV, bufferScore, bufferOut;
+
+    size_t inputBytes, conditionBytes;
+    err = clGetMemObjectInfo(input, CL_MEM_SIZE, sizeof(size_t), &inputBytes, nullptr);
+    err |= clGetMemObjectInfo(condition, CL_MEM_SIZE, sizeof(size_t), &conditionBytes, nullptr);
+    CHECK_ERROR(err);
+
+    size_t M = inputBytes / sizeof(float) / queryDim;
+    size_t N = conditionBytes / sizeof(float) / contextDim;
+    size_t headDim = innerDim / headSize;
+
+    /* fused : q, k, v 는 to_qkv 결과 (M, 3 * inner) 의 열 구간 (sub-buffer 대신 offset) */
+    bool fused = toQKVLinear != nullptr && condition == input;
+    int ldq = static_cast<int>(fused ? 3 * innerDim : innerDim);
+    int offsetK = fused ? static_cast<int>(innerDim) : 0;
+    int offsetV = fused ? static_cast<int>(2 * innerDim) : 0;
+
+    bufferK = bufferV = nullptr;
+    bufferQ = record::clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(float) * M * ldq,
+                                     nullptr, &err);
+    CHECK_ERROR(err);
+    if (!fused) {
+        bufferK = record::clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(float) * N * innerDim,
+                                         nullptr, &err);
+        CHECK_ERROR(err);
+        bufferV = record::clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(float) * N * innerDim,
+                                         nullptr, &err);
+        CHECK_ERROR(err);
+    }
+    bufferScore = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                         sizeof(float) * headSize * M * N, nullptr, &err);
+    CHECK_ERROR(err);
+    bufferOut = record::clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(float) * M * innerDim,
+                                       nullptr, &err);
+    CHECK_ERROR(err);
+
+    Graph graph({cmdQueue});
+    graph.input(input, num_events_in_list, event_wait_list);
+    if (condition != input) {
+        graph.input(condition, num_events_in_list, event_wait_list);
+    }
+    if (fused) {
+        graph.add("to_qkv", {input}, {bufferQ},
+                  [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      Tracer::Scope scope("to_qkv");
+                      return toQKVLinear->forward(input, bufferQ, num_events, wait_list, e);
+                  });
+    } else {
+        graph.add("to_q", {input}, {bufferQ},
+                  [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      Tracer::Scope scope("to_q");
+                      return toQLinear->forward(input, bufferQ, num_events, wait_list, e);
+                  });
+        graph.add("to_k", {condition}, {bufferK},
+                  [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      Tracer::Scope scope("to_k");
+                      return toKLinear->forward(condition, bufferK, num_events, wait_list, e);
+                  });
+        graph.add("to_v", {condition}, {bufferV},
+                  [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      Tracer::Scope scope("to_v");
+                      return toVLinear->forward(condition, bufferV, num_events, wait_list, e);
+                  });
+    }
+    err = graph.run();
+    CHECK_ERROR(err);
+
+    cl_uint numProjEvents = fused ? 1 : 3;
+    err = graph.getEvent(bufferQ, &event0[0]);
+    if (!fused) {
+        err |= graph.getEvent(bufferK, &event0[1]);
+        err |= graph.getEvent(bufferV, &event0[2]);
+    }
+    CHECK_ERROR(err);
+    if (fused) {
+        bufferK = bufferV = bufferQ;
+    }
+
+    /* score (h, M, N) = Q (h, M, D) x K^T (h, D, N) * scale */
+    int ldk = fused ? ldq : static_cast<int>(innerDim);
+    int D = static_cast<int>(headDim);
+    int MxN = static_cast<int>(M * N);
+    cl_int4 layoutQ = {{0, D, ldq, 1}};
+    cl_int4 layoutK = {{offsetK, D, 1, ldk}};
+    cl_int4 layoutScore = {{0, MxN, static_cast<int>(N), 1}};
+    err = stridedMatmul(bufferQ, bufferK, bufferScore, headSize, M, N, headDim,
+                        layoutQ, layoutK, layoutScore, scale,
+                        fused ? 1 : 2, event0, &event1);
+    CHECK_ERROR(err);
+
+    size_t workGroupSize = WORK_GROUP_SIZE;
+    auto softmax = SOFTMAX_KERNEL_VERSION == 1 ? utilKernel->softmax_online : utilKernel->softmax;
+    err = record::clSetKernelArg(softmax, 0, sizeof(cl_mem), &bufferScore);
+    err |= record::clSetKernelArg(softmax, 1, sizeof(cl_mem), &bufferScore);
+    err |= record::clSetKernelArg(softmax, 2, sizeof(float) * workGroupSize, nullptr);
+    if (SOFTMAX_KERNEL_VERSION == 1) {
+        int rowSize = static_cast<int>(N);
+        err |= record::clSetKernelArg(softmax, 3, sizeof(float) * workGroupSize, nullptr);
+        err |= record::clSetKernelArg(softmax, 4, sizeof(int), &rowSize);
+    } else {
+        err |= record::clSetKernelArg(softmax, 3, sizeof(float) * N, nullptr);
+        err |= record::clSetKernelArg(softmax, 4, sizeof(size_t), &N);
+    }
+    CHECK_ERROR(err);
+
+    size_t softmaxGlobalSize[1] = {headSize * M * workGroupSize};
+    size_t softmaxLocalSize[1] = {workGroupSize};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, softmax, 1, nullptr,
+                                         softmaxGlobalSize, softmaxLocalSize, 1, &event1, &event2);
+    CHECK_ERROR(err);
+    Tracer::getInstance().record(SOFTMAX_KERNEL_VERSION == 1 ? "softmax_online" : "softmax",
+                                 event2);
+
+    /* out (M, h * D + d) = score (h, M, N) x V (h, N, D). to_out 의 입력 layout 그대로 */
+    int ldv = ldk;
+    cl_event event2_0[2] = {event2, fused ? event0[0] : event0[2]};
+    cl_int4 layoutV = {{offsetV, D, ldv, 1}};
+    cl_int4 layoutOut = {{0, D, static_cast<int>(innerDim), 1}};
+    err = stridedMatmul(bufferScore, bufferV, bufferOut, headSize, M, headDim, N,
+                        layoutScore, layoutV, layoutOut, 1.f, 2, event2_0, &event3);
+    CHECK_ERROR(err);
+
+    {
+        Tracer::Scope scope("to_out");
+        err = toOutLinear->forward(bufferOut, output, 1, &event3, event);
+    }
+    CHECK_ERROR(err);
+
+    for (cl_uint i = 0; i < numProjEvents; i++) {
+        clReleaseEvent(event0[i]);
+    }
+    clReleaseEvent(event1);
+    clReleaseEvent(event2);
+    clReleaseEvent(event3);
+    record::clReleaseMemObject(bufferQ);
+    if (!fused) {
+        record::clReleaseMemObject(bufferK);
+        record::clReleaseMemObject(bufferV);
+    }
+    record::clReleaseMemObject(bufferScore);
+    record::clReleaseMemObject(bufferOut);
+    cnt += 1;
+    return CL_SUCCESS;
+}
+
+cl_int CrossAttention::stridedMatmul(cl_mem A, cl_mem B, cl_mem C, size_t batch, size_t M,
+                                     size_t N, size_t K, cl_int4 layoutA, cl_int4 layoutB,
+                                     cl_int4 layoutC, float scale, cl_uint num_events_in_list,
+                                     const cl_event *event_wait_list, cl_event *event) {
+    /* util.cl STRIDED_TILE_M, STRIDED_TILE_N, STRIDED_REG_M, STRIDED_REG_N */
+    const size_t tileM = 64, tileN = 64, regM = 4, regN = 4;
+    int m = static_cast<int>(M), n = static_cast<int>(N), k = static_cast<int>(K);
+
+    cl_int err;
+    auto kernel = utilKernel->strided_batch_matmul;
+    err = record::clSetKernelArg(kernel, 0, sizeof(cl_mem), &A);
+    err |= record::clSetKernelArg(kernel, 1, sizeof(cl_mem), &B);
+    err |= record::clSetKernelArg(kernel, 2, sizeof(cl_mem), &C);
+    err |= record::clSetKernelArg(kernel, 3, sizeof(int), &m);
+    err |= record::clSetKernelArg(kernel, 4, sizeof(int), &n);
+    err |= record::clSetKernelArg(kernel, 5, sizeof(int), &k);
+    err |= record::clSetKernelArg(kernel, 6, sizeof(cl_int4), &layoutA);
+    err |= record::clSetKernelArg(kernel, 7, sizeof(cl_int4), &layoutB);
+    err |= record::clSetKernelArg(kernel, 8, sizeof(cl_int4), &layoutC);
+    err |= record::clSetKernelArg(kernel, 9, sizeof(float), &scale);
+    CHECK_ERROR(err);
+
+    size_t globalSize[3] = {batch, (M + tileM - 1) / tileM * (tileM / regM),
+                            (N + tileN - 1) / tileN * (tileN / regN)};
+    size_t localSize[3] = {1, tileM / regM, tileN / regN};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel, 3, nullptr, globalSize, localSize,
+                                         num_events_in_list, event_wait_list, event);
+    CHECK_ERROR(err);
+    Tracer::getInstance().record("strided_batch_matmul", *event);
+    return CL_SUCCESS;
+}
+
+int CrossAttention::cnt = 0;
+
+cl_int CrossAttention::forwardCpu(cl_mem input, cl_mem condition, cl_mem output,
+                                  cl_uint num_events_in_list, const cl_event *event_wait_list,
+                                  cl_event *event) {
+    cl_int err;
+    cl_event event0[3], event1;
+    cl_mem bufferQ, bufferK, bufferV, bufferOut;
+
+    size_t inputBytes, conditionBytes;
+    err = clGetMemObjectInfo(input, CL_MEM_SIZE, sizeof(size_t), &inputBytes, nullptr);
+    err |= clGetMemObjectInfo(condition, CL_MEM_SIZE, sizeof(size_t), &conditionBytes, nullptr);
+    CHECK_ERROR(err);
+
+    size_t M = inputBytes / sizeof(float) / queryDim;
+    size_t N = conditionBytes / sizeof(float) / contextDim;
+
+    bool fused = toQKVLinear != nullptr && condition == input;
+    bufferOut = record::clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(float) * M * innerDim,
+                                       nullptr, &err);
+    CHECK_ERROR(err);
+
+    /* fused : q, k, v 는 to_qkv 결과 (M, 3 * inner) 의 열 구간 */
+    size_t ld = innerDim;
+    if (fused) {
+        ld = 3 * innerDim;
+        bufferQ = record::clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(float) * M * ld,
+                                         nullptr, &err);
+        CHECK_ERROR(err);
+        bufferK = bufferV = nullptr;
+
+        {
+            Tracer::Scope scope("to_qkv");
+            err = toQKVLinear->forward(input, bufferQ, num_events_in_list, event_wait_list,
+                                       &event0[0]);
+        }
+        CHECK_ERROR(err);
+    } else {
+        bufferQ = record::clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(float) * M * innerDim,
+                                         nullptr, &err);
+        CHECK_ERROR(err);
+        bufferK = record::clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(float) * N * innerDim,
+                                         nullptr, &err);
+        CHECK_ERROR(err);
+        bufferV = record::clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(float) * N * innerDim,
+                                         nullptr, &err);
+        CHECK_ERROR(err);
+
+        {
+            Tracer::Scope scope("to_q");
+            err = toQLinear->forward(input, bufferQ, num_events_in_list, event_wait_list,
+                                     &event0[0]);
+        }
+        CHECK_ERROR(err);
+
+        {
+            Tracer::Scope scope("to_k");
+            err = toKLinear->forward(condition, bufferK, num_events_in_list, event_wait_list,
+                                     &event0[1]);
+        }
+        CHECK_ERROR(err);
+
+        {
+            Tracer::Scope scope("to_v");
+            err = toVLinear->forward(condition, bufferV, num_events_in_list, event_wait_list,
+                                     &event0[2]);
+        }
+        CHECK_ERROR(err);
+    }
+    cl_uint numEvents = fused ? 1 : 3;
+
+    {
+        Tracer::HostSpan span("cpu_attention");
+        CpuBackend::Mapping mapping(cmdQueue, numEvents, event0);
+        auto out = mapping.map(bufferOut, &err);
+        CHECK_ERROR(err);
+        auto q = mapping.mapRead(bufferQ, &err);
+        CHECK_ERROR(err);
+        const float *k = q + innerDim, *v = q + 2 * innerDim;
+        if (!fused) {
+            k = mapping.mapRead(bufferK, &err);
+            CHECK_ERROR(err);
+            v = mapping.mapRead(bufferV, &err);
+            CHECK_ERROR(err);
+        }
+
+        cpu::attention(q, ld, k, ld, v, ld, out, innerDim, headSize, M, N,
+                       innerDim / headSize, scale, nullptr);
+
+        err = mapping.unmap(&event1);
+        CHECK_ERROR(err);
+    }
+
+    {
+        Tracer::Scope scope("to_out");
+        err = toOutLinear->forward(bufferOut, output, 1, &event1, event);
+    }
+    CHECK_ERROR(err);
+
+    for (cl_uint i = 0; i < numEvents; i++) {
+        clReleaseEvent(event0[i]);
+    }
+    clReleaseEvent(event1);
+    record::clReleaseMemObject(bufferQ);
+    if (!fused) {
+        record::clReleaseMemObject(bufferK);
+        record::clReleaseMemObject(bufferV);
+    }
+    record::clReleaseMemObject(bufferOut);
+
+    return CL_SUCCESS;
+}
@@ -35,16 +35,42 @@ public:
     void init();
 
 private:
+    /* CpuBackend::isEnabled(). permute 없이 (M, head * dim) layout 그대로 계산 */
+    cl_int forwardCpu(cl_mem input, cl_mem condition, cl_mem output,
+                      cl_uint num_events_in_list, const cl_event *event_wait_list,
+                      cl_event *event);
+
+    /* version 3. Q, K, V 를 Linear 결과 (token, head * dim) 에서 stride 로 읽고 to_out 입력 layout 으로 씀 */
+    cl_int forwardStrided(cl_mem input, cl_mem condition, cl_mem output,
+                          cl_uint num_events_in_list, const cl_event *event_wait_list,
+                          cl_event *event);
+
+    /* strided_batch_matmul. layout : (offset, batch stride, row stride, col stride) */
+    cl_int stridedMatmul(cl_mem A, cl_mem B, cl_mem C, size_t batch, size_t M, size_t N, size_t K,
+                         cl_int4 layoutA, cl_int4 layoutB, cl_int4 layoutC, float scale,
+                         cl_uint num_events_in_list, const cl_event *event_wait_list,
+                         cl_event *event);
+
     cl_command_queue cmdQueue;
     cl_context context;
     size_t headSize;
     float scale;
+    /* layer name for KernelSelector */
+    const std::string name;
     static int cnt;
 
-    Linear *toQLinear;
-    Linear *toKLinear;
-    Linear *toVLinear;
+    /* Linear 입력 (query_dim, context_dim), 출력 (headSize * headDim) 크기 */
+    size_t queryDim;
+    size_t contextDim;
+    size_t innerDim;
+
+    /* toQKVLinear 를 쓰면 nullptr */
+    Linear *toQLinear = nullptr;
+    Linear *toKLinear = nullptr;
+    Linear *toVLinear = nullptr;
     Linear *toOutLinear;
+    /* QKV_FUSE_MODE 1 이고 self attention (context_dim 0) 이면 to_q, to_k, to_v 대신 사용 */
+    Linear *toQKVLinear = nullptr;
 
     std::shared_ptr<UtilKernel> utilKernel;
     std::shared_ptr<CrossAttentionKernel> crossAttentionKernel;
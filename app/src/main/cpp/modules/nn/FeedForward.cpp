@@ -5,6 +5,8 @@
 #include "FeedForward.h"
 #include <android/log.h>
 #include "../util.h"
+#include "../Tracer.h"
+#include "../CommandRecorder.h"
 
 #define LOG_TAG "FEED_FORWARD"
 
@@ -63,22 +65,28 @@ cl_int FeedForward::forward(
     err = clGetMemObjectInfo(input, CL_MEM_SIZE, sizeof(size_t), &inputBytes, nullptr);
     CHECK_ERROR_THROW(err);
 
-    bufferGEGLU = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                 inputBytes / geglu->weightShape[1] * geglu->weightShape[0] / 2,
-                                 nullptr, &err);
+    bufferGEGLU = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                         inputBytes / geglu->weightShape[1] * geglu->weightShape[0] / 2,
+                                         nullptr, &err);
     CHECK_ERROR(err);
 
-    err = geglu->forward(input, bufferGEGLU, num_events_in_list, event_wait_list, &event0);
+    {
+        Tracer::Scope scope("geglu");
+        err = geglu->forward(input, bufferGEGLU, num_events_in_list, event_wait_list, &event0);
+    }
     CHECK_ERROR(err);
 
     // max diff: 0.00000786781311035156
     // util::testBuffer(cmdQueue, bufferGEGLU, "unet/input_block/test/test_basic_ff_geglu.npy");
 
-    err = netLinear->forward(bufferGEGLU, output, 1, &event0, event);
+    {
+        Tracer::Scope scope("linear");
+        err = netLinear->forward(bufferGEGLU, output, 1, &event0, event);
+    }
     CHECK_ERROR(err);
 
     clReleaseEvent(event0);
-    clReleaseMemObject(bufferGEGLU);
+    record::clReleaseMemObject(bufferGEGLU);
 
     return CL_SUCCESS;
 }
\ No newline at end of file
@@ -5,6 +5,10 @@
 #include "GEGLU.h"
 #include <android/log.h>
 #include "../util.h"
+#include "../Tracer.h"
+#include "../CommandRecorder.h"
+#include "../cpu/CpuBackend.h"
+#include "../cpu/CpuKernel.h"
 
 #define LOG_TAG "GEGLU"
 
@@ -57,28 +61,44 @@ cl_int GEGLU::forward(
     CHECK_ERROR_THROW(err);
 
     bufferSize = inputBytes / sizeof(float) / linear->weightShape[1] * linear->weightShape[0];
-    bufferLinear = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                  sizeof(float) * bufferSize,
-                                  nullptr, &err);
+    bufferLinear = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                          sizeof(float) * bufferSize,
+                                          nullptr, &err);
     CHECK_ERROR_THROW(err);
 
-    err = linear->forward(input, bufferLinear, num_events_in_list, event_wait_list, &event0);
+    {
+        Tracer::Scope scope("proj");
+        err = linear->forward(input, bufferLinear, num_events_in_list, event_wait_list, &event0);
+    }
     CHECK_ERROR_THROW(err);
 
     // max diff: 0.00001072883605957031
     // util::testBuffer(cmdQueue, bufferLinear, "unet/input_block/test/test_basic_ff_geglu_proj.npy");
 
-    err = clSetKernelArg(kernel->gelu_multiply, 0, sizeof(cl_mem), &bufferLinear);
-    err = clSetKernelArg(kernel->gelu_multiply, 1, sizeof(cl_mem), &output);
-    CHECK_ERROR(err);
-
     size_t globalSize[2] = {bufferSize / linear->weightShape[0], linear->weightShape[0] / 2};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->gelu_multiply, 2, nullptr, globalSize, nullptr,
-                                 1, &event0, event);
-    CHECK_ERROR(err);
+    if (CpuBackend::isEnabled()) {
+        Tracer::HostSpan span("cpu_gelu_multiply");
+        CpuBackend::Mapping mapping(cmdQueue, 1, &event0);
+        auto out = mapping.map(output, &err);
+        CHECK_ERROR(err);
+        auto in = mapping.mapRead(bufferLinear, &err);
+        CHECK_ERROR(err);
+        cpu::geluMultiply(in, out, globalSize[0], globalSize[1]);
+        err = mapping.unmap(event);
+        CHECK_ERROR(err);
+    } else {
+        err = record::clSetKernelArg(kernel->gelu_multiply, 0, sizeof(cl_mem), &bufferLinear);
+        err = record::clSetKernelArg(kernel->gelu_multiply, 1, sizeof(cl_mem), &output);
+        CHECK_ERROR(err);
+
+        err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->gelu_multiply, 2, nullptr, globalSize,
+                                             nullptr, 1, &event0, event);
+        CHECK_ERROR(err);
+        Tracer::getInstance().record("gelu_multiply", *event);
+    }
 
     clReleaseEvent(event0);
-    clReleaseMemObject(bufferLinear);
+    record::clReleaseMemObject(bufferLinear);
 
     return CL_SUCCESS;
 }
\ No newline at end of file
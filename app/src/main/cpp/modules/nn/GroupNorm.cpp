@@ -6,6 +6,10 @@
 
 #include <android/log.h>
 #include "../util.h"
+#include "../Tracer.h"
+#include "../CommandRecorder.h"
+#include "../cpu/CpuBackend.h"
+#include "../cpu/CpuKernel.h"
 
 #define DEBUG 0
 #define LOG_TAG "GROUP_NORM"
@@ -68,6 +72,20 @@ void GroupNorm::init() {
 cl_int GroupNorm::forward(
         cl_mem input, cl_mem output,
         cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event
+) {
+    return enqueue(input, output, false, num_events_in_list, event_wait_list, event);
+}
+
+cl_int GroupNorm::forwardChannelLast(
+        cl_mem input, cl_mem output,
+        cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event
+) {
+    return enqueue(input, output, true, num_events_in_list, event_wait_list, event);
+}
+
+cl_int GroupNorm::enqueue(
+        cl_mem input, cl_mem output, bool channelLast,
+        cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event
 ) {
     cl_int err;
     cl_event event1, event2;
@@ -86,63 +104,106 @@ cl_int GroupNorm::forward(
         throw std::runtime_error("input_size % weight->num_vals != 0");
     }
 
+    if (CpuBackend::isEnabled()) {
+        if (channelLast) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "channel-last output is GPU only");
+            return CL_INVALID_OPERATION;
+        }
+        return forwardCpu(input, output, input_size, num_events_in_list, event_wait_list,
+                          event);
+    }
+
     if (groupSize % WORK_GROUP_SIZE != 0) {
         __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "groupSize: %ld, WORK_GROUP_SIZE: %d",
                             groupSize, WORK_GROUP_SIZE);
         throw std::runtime_error("groupSize % WORK_GROUP_SIZE != 0");
     }
 
-    cl_mem bufferMean = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                       sizeof(float) * num_groups,
-                                       nullptr, &err);
+    cl_mem bufferMean = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                               sizeof(float) * num_groups,
+                                               nullptr, &err);
     CHECK_ERROR(err);
 
-    cl_mem bufferVariance = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                           sizeof(float) * num_groups,
-                                           nullptr, &err);
+    cl_mem bufferVariance = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                                   sizeof(float) * num_groups,
+                                                   nullptr, &err);
     CHECK_ERROR(err);
 
-    err = clSetKernelArg(kernel->local_reduction_mean, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->local_reduction_mean, 1, sizeof(cl_mem), &bufferMean);
-    err |= clSetKernelArg(kernel->local_reduction_mean, 2, sizeof(float) * groupSize / reductionSize, nullptr);
-    err |= clSetKernelArg(kernel->local_reduction_mean, 3, sizeof(size_t), &reductionSize);
+    err = record::clSetKernelArg(kernel->local_reduction_mean, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->local_reduction_mean, 1, sizeof(cl_mem), &bufferMean);
+    err |= record::clSetKernelArg(kernel->local_reduction_mean, 2, sizeof(float) * groupSize / reductionSize, nullptr);
+    err |= record::clSetKernelArg(kernel->local_reduction_mean, 3, sizeof(size_t), &reductionSize);
     CHECK_ERROR(err);
 
     size_t globalReductionSize[1] = {num_groups * WORK_GROUP_SIZE};
     size_t localReductionSize[1] = {WORK_GROUP_SIZE};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->local_reduction_mean, 1, nullptr, globalReductionSize,
-                                 localReductionSize,
-                                 num_events_in_list, event_wait_list, &event1);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->local_reduction_mean, 1, nullptr, globalReductionSize,
+                                         localReductionSize,
+                                         num_events_in_list, event_wait_list, &event1);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("local_reduction_mean", event1);
 
-    err = clSetKernelArg(kernel->local_reduction_variance, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->local_reduction_variance, 1, sizeof(cl_mem), &bufferMean);
-    err |= clSetKernelArg(kernel->local_reduction_variance, 2, sizeof(cl_mem), &bufferVariance);
-    err |= clSetKernelArg(kernel->local_reduction_variance, 3, sizeof(float) * groupSize / reductionSize, nullptr);
-    err |= clSetKernelArg(kernel->local_reduction_variance, 4, sizeof(size_t), &reductionSize);
+    err = record::clSetKernelArg(kernel->local_reduction_variance, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->local_reduction_variance, 1, sizeof(cl_mem), &bufferMean);
+    err |= record::clSetKernelArg(kernel->local_reduction_variance, 2, sizeof(cl_mem), &bufferVariance);
+    err |= record::clSetKernelArg(kernel->local_reduction_variance, 3, sizeof(float) * groupSize / reductionSize, nullptr);
+    err |= record::clSetKernelArg(kernel->local_reduction_variance, 4, sizeof(size_t), &reductionSize);
     CHECK_ERROR(err);
 
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->local_reduction_variance, 1, nullptr, globalReductionSize,
-                                 localReductionSize, 1,
-                                 &event1, &event2);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->local_reduction_variance, 1, nullptr, globalReductionSize,
+                                         localReductionSize, 1,
+                                         &event1, &event2);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("local_reduction_variance", event2);
+
+    if (channelLast) {
+        if (num_channels % 4 != 0) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "num_channels(%ld) %% 4 != 0",
+                                num_channels);
+            return CL_INVALID_VALUE;
+        }
+        auto groupNormKernel = kernel->group_norm_channel_last;
+        int channelsPerGroup = static_cast<int>(num_channels / num_groups);
+        err = record::clSetKernelArg(groupNormKernel, 0, sizeof(cl_mem), &input);
+        err |= record::clSetKernelArg(groupNormKernel, 1, sizeof(cl_mem), &bufferMean);
+        err |= record::clSetKernelArg(groupNormKernel, 2, sizeof(cl_mem), &bufferVariance);
+        err |= record::clSetKernelArg(groupNormKernel, 3, sizeof(cl_mem), &bufferWeight);
+        err |= record::clSetKernelArg(groupNormKernel, 4, sizeof(cl_mem), &bufferBias);
+        err |= record::clSetKernelArg(groupNormKernel, 5, sizeof(int), &channelsPerGroup);
+        err |= record::clSetKernelArg(groupNormKernel, 6, sizeof(float), &eps);
+        err |= record::clSetKernelArg(groupNormKernel, 7, sizeof(cl_mem), &output);
+        CHECK_ERROR(err);
+
+        size_t channelLastGlobalSize[2] = {input_size / num_channels, num_channels / 4};
+        err = record::clEnqueueNDRangeKernel(cmdQueue, groupNormKernel, 2, nullptr,
+                                             channelLastGlobalSize, nullptr, 1, &event2, event);
+        CHECK_ERROR(err);
+        Tracer::getInstance().record("group_norm_channel_last", *event);
+
+        record::clReleaseMemObject(bufferMean);
+        record::clReleaseMemObject(bufferVariance);
+        clReleaseEvent(event1);
+        clReleaseEvent(event2);
+        return CL_SUCCESS;
+    }
 
     size_t channelSize = input_size / num_channels;
-    err = clSetKernelArg(kernel->group_norm, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->group_norm, 1, sizeof(cl_mem), &bufferMean);
-    err |= clSetKernelArg(kernel->group_norm, 2, sizeof(cl_mem), &bufferVariance);
-    err |= clSetKernelArg(kernel->group_norm, 3, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->group_norm, 4, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->group_norm, 5, sizeof(size_t), &groupSize);
-    err |= clSetKernelArg(kernel->group_norm, 6, sizeof(size_t), &channelSize);
-    err |= clSetKernelArg(kernel->group_norm, 7, sizeof(float), &eps);
-    err |= clSetKernelArg(kernel->group_norm, 8, sizeof(cl_mem), &output);
+    err = record::clSetKernelArg(kernel->group_norm, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->group_norm, 1, sizeof(cl_mem), &bufferMean);
+    err |= record::clSetKernelArg(kernel->group_norm, 2, sizeof(cl_mem), &bufferVariance);
+    err |= record::clSetKernelArg(kernel->group_norm, 3, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->group_norm, 4, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->group_norm, 5, sizeof(size_t), &groupSize);
+    err |= record::clSetKernelArg(kernel->group_norm, 6, sizeof(size_t), &channelSize);
+    err |= record::clSetKernelArg(kernel->group_norm, 7, sizeof(float), &eps);
+    err |= record::clSetKernelArg(kernel->group_norm, 8, sizeof(cl_mem), &output);
     CHECK_ERROR(err);
 
     size_t globalWorkSize[1] = {input_size};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->group_norm, 1, nullptr, globalWorkSize, nullptr, 1,
-                                 &event2, event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->group_norm, 1, nullptr, globalWorkSize, nullptr, 1,
+                                         &event2, event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("group_norm", *event);
 
 #if DEBUG
     clWaitForEvents(1, event);
@@ -161,10 +222,33 @@ cl_int GroupNorm::forward(
     util::printEventTime(message + ", group_norm", *event);
 #endif
 
-    clReleaseMemObject(bufferMean);
-    clReleaseMemObject(bufferVariance);
+    record::clReleaseMemObject(bufferMean);
+    record::clReleaseMemObject(bufferVariance);
     clReleaseEvent(event1);
     clReleaseEvent(event2);
 
     return CL_SUCCESS;
-}
\ No newline at end of file
+}
+
+cl_int GroupNorm::forwardCpu(cl_mem input, cl_mem output, size_t input_size,
+                             cl_uint num_events_in_list, const cl_event *event_wait_list,
+                             cl_event *event) {
+    cl_int err;
+    Tracer::HostSpan span("cpu_group_norm");
+    CpuBackend::Mapping mapping(cmdQueue, num_events_in_list, event_wait_list);
+    auto out = mapping.map(output, &err);
+    CHECK_ERROR(err);
+    auto in = mapping.mapRead(input, &err);
+    CHECK_ERROR(err);
+    auto weight = mapping.mapRead(bufferWeight, &err);
+    CHECK_ERROR(err);
+    auto bias = mapping.mapRead(bufferBias, &err);
+    CHECK_ERROR(err);
+
+    cpu::groupNorm(in, weight, bias, out, num_channels, input_size / num_channels, num_groups,
+                   eps);
+
+    err = mapping.unmap(event);
+    CHECK_ERROR(err);
+    return CL_SUCCESS;
+}
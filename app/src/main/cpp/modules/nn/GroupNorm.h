@@ -28,7 +28,19 @@ public:
     cl_int forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
                    const cl_event *event_wait_list, cl_event *event);
 
+    /* `input`: (C, HW), `output`: (HW, C) channel-last (ACTIVATION_LAYOUT_MODE 1). GPU 만 */
+    cl_int forwardChannelLast(cl_mem input, cl_mem output, cl_uint num_events_in_list,
+                              const cl_event *event_wait_list, cl_event *event);
+
 private:
+    cl_int enqueue(cl_mem input, cl_mem output, bool channelLast, cl_uint num_events_in_list,
+                   const cl_event *event_wait_list, cl_event *event);
+
+    /* CpuBackend::isEnabled() */
+    cl_int forwardCpu(cl_mem input, cl_mem output, size_t input_size,
+                      cl_uint num_events_in_list, const cl_event *event_wait_list,
+                      cl_event *event);
+
     cl_mem bufferWeight;
     cl_mem bufferBias;
     size_t weightSize;
@@ -4,6 +4,10 @@
 
 #include "LayerNorm.h"
 #include "../util.h"
+#include "../Tracer.h"
+#include "../CommandRecorder.h"
+#include "../cpu/CpuBackend.h"
+#include "../cpu/CpuKernel.h"
 #include <android/log.h>
 #define DEBUG 0
 
@@ -81,62 +85,70 @@ cl_int LayerNorm::forward(
         throw std::runtime_error("input_size % weight->num_vals != 0");
     }
 
-    cl_mem bufferMean = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                       sizeof(float) * input_size / weightSize,
-                                       nullptr, &err);
+    if (CpuBackend::isEnabled()) {
+        return forwardCpu(input, output, input_size, num_events_in_list, event_wait_list,
+                          event);
+    }
+
+    cl_mem bufferMean = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                               sizeof(float) * input_size / weightSize,
+                                               nullptr, &err);
     CHECK_ERROR(err);
 
-    cl_mem bufferVariance = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                           sizeof(float) * input_size / weightSize,
-                                           nullptr, &err);
+    cl_mem bufferVariance = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                                   sizeof(float) * input_size / weightSize,
+                                                   nullptr, &err);
     CHECK_ERROR(err);
 
     size_t reductionSize = weightSize / WORK_GROUP_SIZE;
-    err = clSetKernelArg(kernel->mean, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->mean, 1, sizeof(cl_mem), &bufferMean);
-    err |= clSetKernelArg(kernel->mean, 2, sizeof(float) * WORK_GROUP_SIZE, nullptr);
-    err |= clSetKernelArg(kernel->mean, 3, sizeof(size_t), &reductionSize);
+    err = record::clSetKernelArg(kernel->mean, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->mean, 1, sizeof(cl_mem), &bufferMean);
+    err |= record::clSetKernelArg(kernel->mean, 2, sizeof(float) * WORK_GROUP_SIZE, nullptr);
+    err |= record::clSetKernelArg(kernel->mean, 3, sizeof(size_t), &reductionSize);
     CHECK_ERROR(err);
 
     size_t globalReductionSize[1] = {input_size / reductionSize};
     size_t localReductionSize[1] = {WORK_GROUP_SIZE};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->mean, 1, nullptr, globalReductionSize,
-                                 localReductionSize,
-                                 num_events_in_list, event_wait_list, &event1);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->mean, 1, nullptr, globalReductionSize,
+                                         localReductionSize,
+                                         num_events_in_list, event_wait_list, &event1);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("mean", event1);
 
 //    clWaitForEvents(1, &event1);
 //    util::testBuffer(cmdQueue, bufferMean, "encoder/test/local_mean_test_fp32.npy");
 
-    err = clSetKernelArg(kernel->variance, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->variance, 1, sizeof(cl_mem), &bufferMean);
-    err |= clSetKernelArg(kernel->variance, 2, sizeof(cl_mem), &bufferVariance);
-    err |= clSetKernelArg(kernel->variance, 3, sizeof(float) * WORK_GROUP_SIZE, nullptr);
-    err |= clSetKernelArg(kernel->variance, 4, sizeof(size_t), &reductionSize);
+    err = record::clSetKernelArg(kernel->variance, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->variance, 1, sizeof(cl_mem), &bufferMean);
+    err |= record::clSetKernelArg(kernel->variance, 2, sizeof(cl_mem), &bufferVariance);
+    err |= record::clSetKernelArg(kernel->variance, 3, sizeof(float) * WORK_GROUP_SIZE, nullptr);
+    err |= record::clSetKernelArg(kernel->variance, 4, sizeof(size_t), &reductionSize);
     CHECK_ERROR(err);
 
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->variance, 1, nullptr, globalReductionSize,
-                                 localReductionSize, 1,
-                                 &event1, &event2);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->variance, 1, nullptr, globalReductionSize,
+                                         localReductionSize, 1,
+                                         &event1, &event2);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("variance", event2);
 
 //    clWaitForEvents(1, &event2);
 //    util::testBuffer(cmdQueue, bufferVariance, "encoder/test/local_var_test_fp32.npy");
 
-    err = clSetKernelArg(kernel->normalization, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->normalization, 1, sizeof(cl_mem), &bufferMean);
-    err |= clSetKernelArg(kernel->normalization, 2, sizeof(cl_mem), &bufferVariance);
-    err |= clSetKernelArg(kernel->normalization, 3, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->normalization, 4, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->normalization, 5, sizeof(size_t), &weightSize);
-    err |= clSetKernelArg(kernel->normalization, 6, sizeof(cl_mem), &output);
+    err = record::clSetKernelArg(kernel->normalization, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->normalization, 1, sizeof(cl_mem), &bufferMean);
+    err |= record::clSetKernelArg(kernel->normalization, 2, sizeof(cl_mem), &bufferVariance);
+    err |= record::clSetKernelArg(kernel->normalization, 3, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->normalization, 4, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->normalization, 5, sizeof(size_t), &weightSize);
+    err |= record::clSetKernelArg(kernel->normalization, 6, sizeof(cl_mem), &output);
     CHECK_ERROR(err);
 
     size_t globalWorkSize[1] = {input_size};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->normalization, 1, nullptr, globalWorkSize,
-                                 nullptr, 1,
-                                 &event2, event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->normalization, 1, nullptr, globalWorkSize,
+                                         nullptr, 1,
+                                         &event2, event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("normalization", *event);
 
 //    clWaitForEvents(1, event);
 //    util::testBuffer(cmdQueue, output, "encoder/test/layer_norm_0_test_fp32.npy");
@@ -153,10 +165,32 @@ cl_int LayerNorm::forward(
     util::printEventTime(message + ", normalization", *event);
 #endif
 
-    clReleaseMemObject(bufferMean);
-    clReleaseMemObject(bufferVariance);
+    record::clReleaseMemObject(bufferMean);
+    record::clReleaseMemObject(bufferVariance);
     clReleaseEvent(event1);
     clReleaseEvent(event2);
 
     return CL_SUCCESS;
-}
\ No newline at end of file
+}
+
+cl_int LayerNorm::forwardCpu(cl_mem input, cl_mem output, size_t input_size,
+                             cl_uint num_events_in_list, const cl_event *event_wait_list,
+                             cl_event *event) {
+    cl_int err;
+    Tracer::HostSpan span("cpu_layer_norm");
+    CpuBackend::Mapping mapping(cmdQueue, num_events_in_list, event_wait_list);
+    auto out = mapping.map(output, &err);
+    CHECK_ERROR(err);
+    auto in = mapping.mapRead(input, &err);
+    CHECK_ERROR(err);
+    auto weight = mapping.mapRead(bufferWeight, &err);
+    CHECK_ERROR(err);
+    auto bias = mapping.mapRead(bufferBias, &err);
+    CHECK_ERROR(err);
+
+    cpu::layerNorm(in, weight, bias, out, input_size / weightSize, weightSize, 1e-5f);
+
+    err = mapping.unmap(event);
+    CHECK_ERROR(err);
+    return CL_SUCCESS;
+}
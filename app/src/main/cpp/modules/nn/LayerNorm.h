@@ -28,6 +28,11 @@ public:
                    const cl_event *event_wait_list, cl_event *event);
 
 private:
+    /* CpuBackend::isEnabled() */
+    cl_int forwardCpu(cl_mem input, cl_mem output, size_t input_size,
+                      cl_uint num_events_in_list, const cl_event *event_wait_list,
+                      cl_event *event);
+
     cl_mem bufferWeight;
     cl_mem bufferBias;
     size_t weightSize;
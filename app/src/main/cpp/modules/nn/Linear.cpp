@@ -4,8 +4,13 @@
 
 #include "Linear.h"
 #include "../util.h"
+#include "../Tracer.h"
+#include "../CommandRecorder.h"
 #include "android/log.h"
 #include "../setting.h"
+#include "../KernelSelector.h"
+#include "../cpu/CpuBackend.h"
+#include "../cpu/CpuKernel.h"
 
 #define DEBUG 0
 #define WIDTH 4
@@ -25,14 +30,36 @@
 
 static int count = 0;
 
+const std::map<int, Linear::Strategy> Linear::strategies = {
+        {0, &Linear::forwardVersion0},
+        {1, &Linear::forwardVersion1},
+        {2, &Linear::forwardVersion2},
+        {3, &Linear::forwardVersion3},
+        {4, &Linear::forwardVersion4},
+        {5, &Linear::forwardVersion5},
+        {6, &Linear::forwardVersion6},
+};
+
 Linear::Linear(
         cl_context context, cl_command_queue cmdQueue,
         size_t in_features, size_t out_features,
         const std::string &weight_name, const std::string &bias_name,
         std::shared_ptr<LinearKernel> kernel,
         std::shared_ptr<UtilKernel> utilKernel
-) : context(context), cmdQueue(cmdQueue), weight_name(weight_name), bias_name(bias_name),
-    bufferWeight(nullptr), bufferBias(nullptr), kernel(kernel), utilKernel(utilKernel) {
+) : bufferWeight(nullptr), bufferBias(nullptr), cmdQueue(cmdQueue), context(context),
+    weight_name(weight_name), bias_name(bias_name), kernel(kernel), utilKernel(utilKernel) {
+    weightShape = std::vector<size_t>({out_features, in_features});
+}
+
+Linear::Linear(
+        cl_context context, cl_command_queue cmdQueue,
+        size_t in_features, size_t out_features,
+        const std::vector<std::string> &weight_names, const std::string &bias_name,
+        std::shared_ptr<LinearKernel> kernel,
+        std::shared_ptr<UtilKernel> utilKernel
+) : bufferWeight(nullptr), bufferBias(nullptr), cmdQueue(cmdQueue), context(context),
+    weight_name(weight_names.front()), bias_name(bias_name), weight_names(weight_names),
+    kernel(kernel), utilKernel(utilKernel) {
     weightShape = std::vector<size_t>({out_features, in_features});
 }
 
@@ -50,7 +77,11 @@ void Linear::init() {
         return;
     }
     size_t weight_num_vals;
-    bufferWeight = util::load_npy_file(weight_name, &weight_num_vals, context, cmdQueue);
+    if (weight_names.empty()) {
+        bufferWeight = util::load_npy_file(weight_name, &weight_num_vals, context, cmdQueue);
+    } else {
+        bufferWeight = util::load_npy_files(weight_names, &weight_num_vals, context, cmdQueue);
+    }
 
     if (weight_num_vals != (weightShape[0] * weightShape[1])) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
@@ -95,20 +126,217 @@ cl_int Linear::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
     auto M = inputSize / weightShape[1];
     auto N = weightShape[0];
     auto K = weightShape[1];
-#if LINEAR_KERNEL_VERSION == 0
+    if (CpuBackend::isEnabled()) {
+        return forwardCpu(input, output, M, N, K, num_events_in_list, event_wait_list, event);
+    }
+
+    bool configured;
+    auto version = KernelSelector::getInstance().select(KernelSelector::LINEAR, weight_name,
+                                                        LINEAR_KERNEL_VERSION, &configured);
+
+    /* tuned config (version 4 or 5) is used when version is not configured */
+    LinearConfig config{};
+    bool tuned = false;
+    auto &tuner = LinearTuner::getInstance();
+    if (!configured && (version == 4 || version == 5)) {
+        tuned = tuner.find(M, N, K, &config);
+        if (!tuned && tuner.getMode() == LinearTuner::TUNE) {
+            if (num_events_in_list > 0) {
+                clWaitForEvents(num_events_in_list, event_wait_list);
+            }
+            tuned = tuner.tune(M, N, K, [&](const LinearConfig &candidate, cl_event *_event) {
+                return enqueue(candidate, input, output, M, N, K, 0, nullptr, _event);
+            }, &config);
+        }
+        if (tuned) {
+            version = config.version;
+            err = enqueue(config, input, output, M, N, K, num_events_in_list, event_wait_list,
+                          event);
+            CHECK_ERROR(err);
+            Tracer::getInstance().record(config.version == 5 ? "tile_reg_m_n_vector_linear"
+                                                             : "tile_reg_n_vector_linear", *event);
+        }
+    }
+
+    if (!tuned) {
+        auto strategy = strategies.find(version);
+        if (strategy == strategies.end()) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                                "[%s:%d] unknown version(%d)\n", __FILE__, __LINE__, version);
+            return CL_INVALID_VALUE;
+        }
+
+        err = (this->*(strategy->second))(input, output, M, N, K,
+                                          num_events_in_list, event_wait_list, event);
+        if (err == CL_INVALID_VALUE && version != 0 && !configured) {
+            /* shape not supported by tile size of `version` */
+            __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG,
+                                "[%s:%d] version(%d) -> version(0)\n", __FILE__, __LINE__,
+                                version);
+            version = 0;
+            err = forwardVersion0(input, output, M, N, K,
+                                  num_events_in_list, event_wait_list, event);
+        }
+        CHECK_ERROR(err);
+    }
+
+#if DEBUG
+    clWaitForEvents(1, event);
+    if (count == 0)
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG,
+                            "try, component, index, input size, out feature, in feature, tile size m, tile size n, version, kernel, time(ms)\n");
+    auto message =
+            "0, Linear, " +
+            std::to_string(count++) + ", " +
+            std::to_string(inputSize) + ", " +
+            std::to_string(weightShape[0]) + ", " +
+            std::to_string(weightShape[1]) + ", " +
+            std::to_string(config.tile_size_m) + ", " +
+            std::to_string(config.tile_size_n) + ", " +
+            std::to_string(version);
+    util::printEventTime(message + ", register_linear", *event);
+#endif
+
+    return CL_SUCCESS;
+}
+
+
+cl_int Linear::forwardCpu(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                          cl_uint num_events_in_list, const cl_event *event_wait_list,
+                          cl_event *event) {
+    cl_int err;
+    Tracer::HostSpan span("cpu_linear");
+    CpuBackend::Mapping mapping(cmdQueue, num_events_in_list, event_wait_list);
+    auto out = mapping.map(output, &err);
+    CHECK_ERROR(err);
+    auto in = mapping.mapRead(input, &err);
+    CHECK_ERROR(err);
+    auto weight = mapping.mapRead(bufferWeight, &err);
+    CHECK_ERROR(err);
+    const float *bias = nullptr;
+    if (bufferBias != nullptr) {
+        bias = mapping.mapRead(bufferBias, &err);
+        CHECK_ERROR(err);
+    }
+
+    cpu::linear(in, weight, bias, out, M, N, K);
+
+    err = mapping.unmap(event);
+    CHECK_ERROR(err);
+    return CL_SUCCESS;
+}
+
+cl_int Linear::forwardVersion0(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                              cl_uint num_events_in_list, const cl_event *event_wait_list,
+                              cl_event *event) {
+    cl_int err;
     /* naive */
-    err = clSetKernelArg(kernel->naive_linear, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->naive_linear, 1, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->naive_linear, 2, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->naive_linear, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->naive_linear, 4, sizeof(int), &K);
+    err = record::clSetKernelArg(kernel->naive_linear, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->naive_linear, 1, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->naive_linear, 2, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->naive_linear, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->naive_linear, 4, sizeof(int), &K);
     CHECK_ERROR(err);
 
     size_t globalWorkSize[2] = {M, N};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->naive_linear, 2, nullptr, globalWorkSize, nullptr,
-                                 num_events_in_list, event_wait_list, event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->naive_linear, 2, nullptr, globalWorkSize, nullptr,
+                                         num_events_in_list, event_wait_list, event);
+    CHECK_ERROR(err);
+    Tracer::getInstance().record("naive_linear", *event);
+
+    return CL_SUCCESS;
+}
+
+cl_int Linear::forwardVersion1(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                              cl_uint num_events_in_list, const cl_event *event_wait_list,
+                              cl_event *event) {
+    cl_int err;
+    /* register : light throttle 15818 ms -> 8319 ms */
+    size_t reg_size_n = 8;
+    size_t tile_size_k = 16;
+    cl_uchar tile_size_ms[] = {128, 77, 1};
+    cl_uchar reg_size_ms[] = {8, 7, 1};
+    cl_uchar tile_size_ns[] = {128, 64};
+
+    int m_index, m_size = 3;
+    for (m_index = 0; m_index < m_size; m_index++) {
+        if (M % (tile_size_ms[m_index]) == 0) {
+            break;
+        }
+    }
+
+    int n_index, n_size = 2;
+    for (n_index = 0; n_index < n_size; n_index++) {
+        if (N % (tile_size_ns[n_index]) == 0) {
+            break;
+        }
+    }
+
+    if (m_index >= m_size) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "[%s:%d] M(%ld) %% tile_size_m != 0\n", __FILE__,
+                            __LINE__, M);
+        return CL_INVALID_VALUE;
+    }
+    if (n_index >= n_size) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "[%s:%d] N(%ld) %% tile_size_n != 0\n", __FILE__,
+                            __LINE__, N);
+        return CL_INVALID_VALUE;
+    }
+    cl_uchar tile_size_m = tile_size_ms[m_index];
+    cl_uchar reg_size_m = reg_size_ms[m_index];
+    cl_uchar tile_size_n = tile_size_ns[n_index];
+    if (K % tile_size_k != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "[%s:%d] K(%ld) %% tile_size_k(%ld) != 0\n", __FILE__,
+                            __LINE__, K, tile_size_k);
+        return CL_INVALID_VALUE;
+    }
+
+    err = record::clSetKernelArg(kernel->register_linear, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->register_linear, 1, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->register_linear, 2, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->register_linear, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->register_linear, 4, sizeof(int), &M);
+    err |= record::clSetKernelArg(kernel->register_linear, 5, sizeof(int), &N);
+    err |= record::clSetKernelArg(kernel->register_linear, 6, sizeof(int), &K);
+    err |= record::clSetKernelArg(kernel->register_linear, 7, sizeof(cl_uchar), &reg_size_m);
+    err |= record::clSetKernelArg(kernel->register_linear, 8, sizeof(cl_uchar), &tile_size_m);
+    err |= record::clSetKernelArg(kernel->register_linear, 9, sizeof(cl_uchar), &tile_size_n);
+    err |= record::clSetKernelArg(kernel->register_linear, 10, sizeof(float) * tile_size_m * tile_size_k,
+                                  nullptr);
+    err |= record::clSetKernelArg(kernel->register_linear, 11, sizeof(float) * tile_size_k * tile_size_n,
+                                  nullptr);
+    CHECK_ERROR(err);
+
+    size_t globalSize_m, globalSize_n;
+    if (M % (tile_size_m) != 0) {
+        globalSize_m = ((M / tile_size_m) + 1) * tile_size_m;
+    } else {
+        globalSize_m = M;
+    }
+    if (N % (tile_size_n) != 0) {
+        globalSize_n = ((N / tile_size_n) + 1) * tile_size_n;
+    } else {
+        globalSize_n = N;
+    }
+    size_t globalWorkSize_reg_linear[2] = {globalSize_m / reg_size_m, globalSize_n / reg_size_n};
+    size_t localWorkSize_reg_linear[2] = {static_cast<size_t>(tile_size_m / reg_size_m), tile_size_n / reg_size_n};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->register_linear, 2, nullptr,
+                                         globalWorkSize_reg_linear,
+                                         localWorkSize_reg_linear, num_events_in_list, event_wait_list,
+                                         event);
     CHECK_ERROR(err);
-#elif LINEAR_KERNEL_VERSION == 2
+    Tracer::getInstance().record("register_linear", *event);
+
+    return CL_SUCCESS;
+}
+
+cl_int Linear::forwardVersion2(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                              cl_uint num_events_in_list, const cl_event *event_wait_list,
+                              cl_event *event) {
+    cl_int err;
     /** tile(m=11,n=32) without memory copy : light throttle 17295 ms -> 8274ms
      * + local barrier : 4650 ms
      * tile(11, 16) : 5215 ms
@@ -154,21 +382,29 @@ cl_int Linear::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
     size_t tile_size_m = tile_size_ms[m_index];
     size_t tile_size_n = tile_size_ns[n_index];
 
-    err = clSetKernelArg(kernel->tile_linear, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->tile_linear, 1, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->tile_linear, 2, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->tile_linear, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->tile_linear, 4, sizeof(int), &K);
+    err = record::clSetKernelArg(kernel->tile_linear, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->tile_linear, 1, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->tile_linear, 2, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->tile_linear, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->tile_linear, 4, sizeof(int), &K);
     CHECK_ERROR(err);
 
     size_t globalWorkSize[2] = {M, N};
     size_t localWorkSize[2] = {tile_size_m, tile_size_n};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->tile_linear,
-                                 2, nullptr,
-                                 globalWorkSize, localWorkSize,
-                                 num_events_in_list, event_wait_list, event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->tile_linear,
+                                         2, nullptr,
+                                         globalWorkSize, localWorkSize,
+                                         num_events_in_list, event_wait_list, event);
     CHECK_ERROR(err);
-#elif LINEAR_KERNEL_VERSION == 3
+    Tracer::getInstance().record("tile_linear", *event);
+
+    return CL_SUCCESS;
+}
+
+cl_int Linear::forwardVersion3(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                              cl_uint num_events_in_list, const cl_event *event_wait_list,
+                              cl_event *event) {
+    cl_int err;
     /** tile(m=11,n=32) with register n
      * reg_size_m=1 : 4035 ms, 3964 ms, 3924 ms
      * tile(m=11,n=16) reg_size_n=2 : 4295 ms, 4116 ms, 4117 ms
@@ -213,21 +449,29 @@ cl_int Linear::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
     size_t tile_size_m = tile_size_ms[m_index];
     size_t tile_size_n = tile_size_ns[n_index];
 
-    err = clSetKernelArg(kernel->tile_reg_n_linear, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->tile_reg_n_linear, 1, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->tile_reg_n_linear, 2, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->tile_reg_n_linear, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->tile_reg_n_linear, 4, sizeof(int), &K);
+    err = record::clSetKernelArg(kernel->tile_reg_n_linear, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->tile_reg_n_linear, 1, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->tile_reg_n_linear, 2, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->tile_reg_n_linear, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->tile_reg_n_linear, 4, sizeof(int), &K);
     CHECK_ERROR(err);
 
     size_t globalWorkSize[2] = {M, N / reg_size_n};
     size_t localWorkSize[2] = {tile_size_m, tile_size_n / reg_size_n };
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->tile_reg_n_linear,
-                                 2, nullptr,
-                                 globalWorkSize, localWorkSize,
-                                 num_events_in_list, event_wait_list, event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->tile_reg_n_linear,
+                                         2, nullptr,
+                                         globalWorkSize, localWorkSize,
+                                         num_events_in_list, event_wait_list, event);
     CHECK_ERROR(err);
-#elif LINEAR_KERNEL_VERSION == 4
+    Tracer::getInstance().record("tile_reg_n_linear", *event);
+
+    return CL_SUCCESS;
+}
+
+cl_int Linear::forwardVersion4(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                              cl_uint num_events_in_list, const cl_event *event_wait_list,
+                              cl_event *event) {
+    cl_int err;
     /** tile(m=11,n=32) with register n and vectorization
      * width=16 + reg_n=2 : 1275 ms, 1265 ms, 1373 ms
      * width=8 : 1306 ms, 1175 ms, 1358 ms
@@ -241,7 +485,6 @@ cl_int Linear::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
      * L/S Unit : Arithmetic Unit = 2 : 1 비율로 확인.
      * full read 거의 못함.
      */
-    int reg_size_n = 8;
     std::vector<size_t> tile_size_ms = {32, 11, 1};
     std::vector<size_t> tile_size_ns = {128, 64};
     int m_index;
@@ -271,24 +514,18 @@ cl_int Linear::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
         return CL_INVALID_VALUE;
     }
 
-    size_t tile_size_m = tile_size_ms[m_index];
-    size_t tile_size_n = tile_size_ns[n_index];
-
-    err = clSetKernelArg(kernel->tile_reg_n_vector_linear, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->tile_reg_n_vector_linear, 1, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->tile_reg_n_vector_linear, 2, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->tile_reg_n_vector_linear, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->tile_reg_n_vector_linear, 4, sizeof(int), &K);
+    LinearConfig config = {4, tile_size_ms[m_index], tile_size_ns[n_index], 0};
+    err = enqueue(config, input, output, M, N, K, num_events_in_list, event_wait_list, event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("tile_reg_n_vector_linear", *event);
 
-    size_t globalWorkSize[2] = {M, N / reg_size_n};
-    size_t localWorkSize[2] = {tile_size_m, tile_size_n / reg_size_n};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->tile_reg_n_vector_linear,
-                                 2, nullptr,
-                                 globalWorkSize, localWorkSize,
-                                 num_events_in_list, event_wait_list, event);
-    CHECK_ERROR(err);
-#elif LINEAR_KERNEL_VERSION == 5
+    return CL_SUCCESS;
+}
+
+cl_int Linear::forwardVersion5(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                              cl_uint num_events_in_list, const cl_event *event_wait_list,
+                              cl_event *event) {
+    cl_int err;
     /**
      * tile(m=11,n=128) with register m and n and vectorization
      * reg_size_m=2, reg_size_n=2 : 1.2s 대 나옴. 나아보이는게 없음.
@@ -345,22 +582,30 @@ cl_int Linear::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
     }
 
 
-    err = clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 1, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 2, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 4, sizeof(int), &M);
-    err |= clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 5, sizeof(int), &K);
+    err = record::clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 1, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 2, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 4, sizeof(int), &M);
+    err |= record::clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 5, sizeof(int), &K);
     CHECK_ERROR(err);
 
     size_t globalWorkSize[2] = {globalWorkSizeM, N / reg_size_n};
     size_t localWorkSize[2] = {localWorkSizeM, tile_size_n / reg_size_n };
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->tile_reg_m_n_vector_linear,
-                                 2, nullptr,
-                                 globalWorkSize, localWorkSize,
-                                 num_events_in_list, event_wait_list, event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->tile_reg_m_n_vector_linear,
+                                         2, nullptr,
+                                         globalWorkSize, localWorkSize,
+                                         num_events_in_list, event_wait_list, event);
     CHECK_ERROR(err);
-#elif LINEAR_KERNEL_VERSION == 6
+    Tracer::getInstance().record("tile_reg_m_n_vector_linear", *event);
+
+    return CL_SUCCESS;
+}
+
+cl_int Linear::forwardVersion6(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                              cl_uint num_events_in_list, const cl_event *event_wait_list,
+                              cl_event *event) {
+    cl_int err;
     /**
      * 2150ms
      * batch matmul 달리 ik kj 방식이 효율적 않았음.
@@ -374,26 +619,27 @@ cl_int Linear::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
 
     // permute bufferWeight
     cl_event eventPermute;
-    cl_mem bufferWeightPermuted = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                                 sizeof(float) * K * N,
-                                                 nullptr, &err);
+    cl_mem bufferWeightPermuted = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                                         sizeof(float) * K * N,
+                                                         nullptr, &err);
     CHECK_ERROR(err);
 
     int permuteWeight[3] = {0, 2, 1};
-    err = clSetKernelArg(utilKernel->permute3D, 0, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(utilKernel->permute3D, 1, sizeof(cl_mem), &bufferWeightPermuted);
-    err |= clSetKernelArg(utilKernel->permute3D, 2, sizeof(int), &permuteWeight[0]);
-    err |= clSetKernelArg(utilKernel->permute3D, 3, sizeof(int), &permuteWeight[1]);
-    err |= clSetKernelArg(utilKernel->permute3D, 4, sizeof(int), &permuteWeight[2]);
+    err = record::clSetKernelArg(utilKernel->permute3D, 0, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(utilKernel->permute3D, 1, sizeof(cl_mem), &bufferWeightPermuted);
+    err |= record::clSetKernelArg(utilKernel->permute3D, 2, sizeof(int), &permuteWeight[0]);
+    err |= record::clSetKernelArg(utilKernel->permute3D, 3, sizeof(int), &permuteWeight[1]);
+    err |= record::clSetKernelArg(utilKernel->permute3D, 4, sizeof(int), &permuteWeight[2]);
     CHECK_ERROR(err);
 
     size_t globalWorkSizePermute[3] = {1, N, K};
-    err = clEnqueueNDRangeKernel(
+    err = record::clEnqueueNDRangeKernel(
             cmdQueue, utilKernel->permute3D,
             3, nullptr, globalWorkSizePermute, nullptr,
             num_events_in_list, event_wait_list, &eventPermute
     );
     CHECK_ERROR(err);
+    Tracer::getInstance().record("permute3D", eventPermute);
 
     std::vector<size_t> tile_size_ms = {40};
     std::vector<size_t> tile_size_ns = {128};
@@ -440,125 +686,91 @@ cl_int Linear::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
         return CL_INVALID_VALUE;
     }
 
-    err = clSetKernelArg(kernel->tile_reg_m_vector_n_linear, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->tile_reg_m_vector_n_linear, 1, sizeof(cl_mem), &bufferWeightPermuted);
-    err |= clSetKernelArg(kernel->tile_reg_m_vector_n_linear, 2, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->tile_reg_m_vector_n_linear, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->tile_reg_m_vector_n_linear, 4, sizeof(int), &M);
-    err |= clSetKernelArg(kernel->tile_reg_m_vector_n_linear, 5, sizeof(int), &N);
-    err |= clSetKernelArg(kernel->tile_reg_m_vector_n_linear, 6, sizeof(int), &K);
+    /* SHAPE_SPECIALIZE_MODE: M, N, K, tile size 를 상수로 build 한 variant */
+    cl_kernel matmul = kernel->tile_reg_m_vector_n_linear_specialized.get(
+            {{"WIDTH", WIDTH}, {"LINEAR_M", M}, {"LINEAR_N", N}, {"LINEAR_K", K},
+             {"LINEAR_LOCAL_M", localWorkSizeM}, {"LINEAR_LOCAL_N", tile_size_n / WIDTH},
+             {"LINEAR_ALIGNED_M", M % tile_size_m == 0}});
+    if (matmul == nullptr) {
+        matmul = kernel->tile_reg_m_vector_n_linear;
+    }
+
+    err = record::clSetKernelArg(matmul, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(matmul, 1, sizeof(cl_mem), &bufferWeightPermuted);
+    err |= record::clSetKernelArg(matmul, 2, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(matmul, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(matmul, 4, sizeof(int), &M);
+    err |= record::clSetKernelArg(matmul, 5, sizeof(int), &N);
+    err |= record::clSetKernelArg(matmul, 6, sizeof(int), &K);
     CHECK_ERROR(err);
 
     size_t globalWorkSize[3] = {1, globalWorkSizeM, N / WIDTH};
     size_t localWorkSize[3] = {1, localWorkSizeM, tile_size_n / WIDTH};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->tile_reg_m_vector_n_linear,
-                                 3, nullptr,
-                                 globalWorkSize, localWorkSize,
-                                 1, &eventPermute, event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, matmul,
+                                         3, nullptr,
+                                         globalWorkSize, localWorkSize,
+                                         1, &eventPermute, event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("tile_reg_m_vector_n_linear", *event);
 
-    clReleaseMemObject(bufferWeightPermuted);
+    record::clReleaseMemObject(bufferWeightPermuted);
     clReleaseEvent(eventPermute);
-#elif LINEAR_KERNEL_VERSION == 1
-    /* register : light throttle 15818 ms -> 8319 ms */
-    size_t reg_size_n = 8;
-    size_t tile_size_k = 16;
-    cl_uchar tile_size_ms[] = {128, 77, 1};
-    cl_uchar reg_size_ms[] = {8, 7, 1};
-    cl_uchar tile_size_ns[] = {128, 64};
 
-    int m_index, m_size = 3;
-    for (m_index = 0; m_index < m_size; m_index++) {
-        if (M % (tile_size_ms[m_index]) == 0) {
-            break;
-        }
-    }
+    return CL_SUCCESS;
+}
 
-    int n_index, n_size = 2;
-    for (n_index = 0; n_index < n_size; n_index++) {
-        if (N % (tile_size_ns[n_index]) == 0) {
-            break;
+/*
+ * launch tile_reg_n_vector_linear (version 4) or tile_reg_m_n_vector_linear (version 5)
+ * with the tile size of `config`
+ */
+cl_int Linear::enqueue(const LinearConfig &config, cl_mem input, cl_mem output,
+                       size_t M, size_t N, size_t K,
+                       cl_uint num_events_in_list, const cl_event *event_wait_list,
+                       cl_event *event) {
+    cl_int err;
+    size_t tile_size_m = config.tile_size_m;
+    size_t tile_size_n = config.tile_size_n;
+
+    if (config.version == 5) {
+        size_t reg_size_m = 2;
+        size_t reg_size_n = 4;
+        if (M % tile_size_m != 0 || N % tile_size_n != 0 ||
+            tile_size_m % reg_size_m != 0 || tile_size_n % reg_size_n != 0) {
+            return CL_INVALID_VALUE;
         }
-    }
 
-    if (m_index >= m_size) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] M(%ld) %% tile_size_m != 0\n", __FILE__,
-                            __LINE__, M);
-        return CL_INVALID_VALUE;
-    }
-    if (n_index >= n_size) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] N(%ld) %% tile_size_n != 0\n", __FILE__,
-                            __LINE__, N);
-        return CL_INVALID_VALUE;
+        err = record::clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 0, sizeof(cl_mem), &input);
+        err |= record::clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 1, sizeof(cl_mem), &bufferWeight);
+        err |= record::clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 2, sizeof(cl_mem), &bufferBias);
+        err |= record::clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 3, sizeof(cl_mem), &output);
+        err |= record::clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 4, sizeof(int), &M);
+        err |= record::clSetKernelArg(kernel->tile_reg_m_n_vector_linear, 5, sizeof(int), &K);
+        CHECK_ERROR(err);
+
+        size_t globalWorkSize[2] = {M / reg_size_m, N / reg_size_n};
+        size_t localWorkSize[2] = {tile_size_m / reg_size_m, tile_size_n / reg_size_n};
+        return record::clEnqueueNDRangeKernel(cmdQueue, kernel->tile_reg_m_n_vector_linear,
+                                              2, nullptr,
+                                              globalWorkSize, localWorkSize,
+                                              num_events_in_list, event_wait_list, event);
     }
-    cl_uchar tile_size_m = tile_size_ms[m_index];
-    cl_uchar reg_size_m = reg_size_ms[m_index];
-    cl_uchar tile_size_n = tile_size_ns[n_index];
-    if (K % tile_size_k != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] K(%ld) %% tile_size_k(%ld) != 0\n", __FILE__,
-                            __LINE__, K, tile_size_k);
+
+    size_t reg_size_n = 8;
+    if (M % tile_size_m != 0 || N % tile_size_n != 0 || tile_size_n % reg_size_n != 0) {
         return CL_INVALID_VALUE;
     }
 
-    err = clSetKernelArg(kernel->register_linear, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->register_linear, 1, sizeof(cl_mem), &bufferWeight);
-    err |= clSetKernelArg(kernel->register_linear, 2, sizeof(cl_mem), &bufferBias);
-    err |= clSetKernelArg(kernel->register_linear, 3, sizeof(cl_mem), &output);
-    err |= clSetKernelArg(kernel->register_linear, 4, sizeof(int), &M);
-    err |= clSetKernelArg(kernel->register_linear, 5, sizeof(int), &N);
-    err |= clSetKernelArg(kernel->register_linear, 6, sizeof(int), &K);
-    err |= clSetKernelArg(kernel->register_linear, 7, sizeof(cl_uchar), &reg_size_m);
-    err |= clSetKernelArg(kernel->register_linear, 8, sizeof(cl_uchar), &tile_size_m);
-    err |= clSetKernelArg(kernel->register_linear, 9, sizeof(cl_uchar), &tile_size_n);
-    err |= clSetKernelArg(kernel->register_linear, 10, sizeof(float) * tile_size_m * tile_size_k,
-                          nullptr);
-    err |= clSetKernelArg(kernel->register_linear, 11, sizeof(float) * tile_size_k * tile_size_n,
-                          nullptr);
-    CHECK_ERROR(err);
-
-    size_t globalSize_m, globalSize_n;
-    if (M % (tile_size_m) != 0) {
-        globalSize_m = ((M / tile_size_m) + 1) * tile_size_m;
-    } else {
-        globalSize_m = M;
-    }
-    if (N % (tile_size_n) != 0) {
-        globalSize_n = ((N / tile_size_n) + 1) * tile_size_n;
-    } else {
-        globalSize_n = N;
-    }
-    size_t globalWorkSize_reg_linear[2] = {globalSize_m / reg_size_m, globalSize_n / reg_size_n};
-    size_t localWorkSize_reg_linear[2] = {static_cast<size_t>(tile_size_m / reg_size_m), tile_size_n / reg_size_n};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->register_linear, 2, nullptr,
-                                 globalWorkSize_reg_linear,
-                                 localWorkSize_reg_linear, num_events_in_list, event_wait_list,
-                                 event);
+    err = record::clSetKernelArg(kernel->tile_reg_n_vector_linear, 0, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(kernel->tile_reg_n_vector_linear, 1, sizeof(cl_mem), &bufferWeight);
+    err |= record::clSetKernelArg(kernel->tile_reg_n_vector_linear, 2, sizeof(cl_mem), &bufferBias);
+    err |= record::clSetKernelArg(kernel->tile_reg_n_vector_linear, 3, sizeof(cl_mem), &output);
+    err |= record::clSetKernelArg(kernel->tile_reg_n_vector_linear, 4, sizeof(int), &K);
     CHECK_ERROR(err);
-#endif
-
-#if DEBUG
-    clWaitForEvents(1, event);
-    if (count == 0)
-        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG,
-                            "try, component, index, input size, out feature, in feature, tile size m, tile size n, reg size n, kernel, time(ms)\n");
-    auto message =
-            "0, Linear, " +
-            std::to_string(count++) + ", " +
-            std::to_string(inputSize) + ", " +
-            std::to_string(weightShape[0]) + ", " +
-            std::to_string(weightShape[1]) + ", " +
-            std::to_string(tile_size_m) + ", " +
-            std::to_string(tile_size_n) + ", " +
-#if LINEAR_KERNEL_VERSION == 6
-            std::to_string(WIDTH);
-#else
-            std::to_string(reg_size_n);
-#endif
-    util::printEventTime(message + ", register_linear", *event);
-#endif
 
-    return CL_SUCCESS;
-}
\ No newline at end of file
+    size_t globalWorkSize[2] = {M, N / reg_size_n};
+    size_t localWorkSize[2] = {tile_size_m, tile_size_n / reg_size_n};
+    return record::clEnqueueNDRangeKernel(cmdQueue, kernel->tile_reg_n_vector_linear,
+                                          2, nullptr,
+                                          globalWorkSize, localWorkSize,
+                                          num_events_in_list, event_wait_list, event);
+}
@@ -11,10 +11,12 @@
 
 #include "CL/opencl.h"
 
+#include <map>
 #include <vector>
 #include <string>
 #include "../kernel/unit/LinearKernel.h"
 #include "../kernel/unit/UtilKernel.h"
+#include "../LinearTuner.h"
 
 class Linear {
 public:
@@ -24,6 +26,13 @@ public:
            std::shared_ptr<LinearKernel> kernel,
            std::shared_ptr<UtilKernel> utilKernel);
 
+    /* weight 들을 out_features 방향으로 이어 붙인 Linear (e.g. to_q, to_k, to_v -> to_qkv) */
+    Linear(cl_context context, cl_command_queue cmdQueue,
+           size_t in_features, size_t out_features,
+           const std::vector<std::string> &weight_names, const std::string &bias_name,
+           std::shared_ptr<LinearKernel> kernel,
+           std::shared_ptr<UtilKernel> utilKernel);
+
     ~Linear();
 
     cl_int forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
@@ -33,6 +42,50 @@ public:
 
     std::vector<size_t> weightShape;
 private:
+    typedef cl_int (Linear::*Strategy)(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                                       cl_uint num_events_in_list,
+                                       const cl_event *event_wait_list, cl_event *event);
+
+    /* LINEAR_KERNEL_VERSION -> forwardVersionN */
+    static const std::map<int, Strategy> strategies;
+
+    /* CpuBackend::isEnabled() */
+    cl_int forwardCpu(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                      cl_uint num_events_in_list, const cl_event *event_wait_list,
+                      cl_event *event);
+
+    cl_int forwardVersion0(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event);
+
+    cl_int forwardVersion1(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event);
+
+    cl_int forwardVersion2(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event);
+
+    cl_int forwardVersion3(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event);
+
+    cl_int forwardVersion4(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event);
+
+    cl_int forwardVersion5(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event);
+
+    cl_int forwardVersion6(cl_mem input, cl_mem output, size_t M, size_t N, size_t K,
+                           cl_uint num_events_in_list, const cl_event *event_wait_list,
+                           cl_event *event);
+
+    cl_int enqueue(const LinearConfig &config, cl_mem input, cl_mem output,
+                   size_t M, size_t N, size_t K,
+                   cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event);
+
     cl_mem bufferWeight;
     /* bufferBias is nullable */
     cl_mem bufferBias;
@@ -42,6 +95,8 @@ private:
 
     const std::string weight_name;
     const std::string bias_name;
+    /* 이어 붙일 weight (비어 있으면 weight_name 하나) */
+    const std::vector<std::string> weight_names;
 
     std::shared_ptr<LinearKernel> kernel;
     std::shared_ptr<UtilKernel> utilKernel;
@@ -3,13 +3,21 @@
 //
 
 #include "MultiHeadAttention.h"
+#include <algorithm>
 #include <android/log.h>
 #include "../util.h"
+#include "../Tracer.h"
+#include "../cpu/CpuBackend.h"
+#include "../cpu/CpuKernel.h"
+#include "../setting.h"
 
 #define DEBUG 0
 #define LOG_TAG "MULTI_HEAD_ATTENTION"
 #define CONTEXT_LENGTH 77
 #define EMBEDDING_SIZE 1024
+/* causal_attention 의 CAUSAL_HEAD_DIM, CAUSAL_TILE */
+#define CAUSAL_HEAD_DIM 64
+#define CAUSAL_TILE 16
 
 #define CHECK_ERROR(err) \
     if (err != CL_SUCCESS) { \
@@ -67,6 +75,13 @@ void MultiHeadAttention::init() {
 
 cl_int MultiHeadAttention::forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
                                    const cl_event *event_wait_list, cl_event *event) {
+    if (CpuBackend::isEnabled()) {
+        return forwardCpu(input, output, num_events_in_list, event_wait_list, event);
+    }
+    if (MULTI_HEAD_ATTENTION_KERNEL_VERSION == 1 && EMBEDDING_SIZE / numHeads == CAUSAL_HEAD_DIM) {
+        return forwardFused(input, output, num_events_in_list, event_wait_list, event);
+    }
+
     cl_int err;
     size_t inputBytes;
     cl_event event1, event2, event3, event4, event5, event6, event7;
@@ -102,8 +117,11 @@ cl_int MultiHeadAttention::forward(cl_mem input, cl_mem output, cl_uint num_even
     CHECK_ERROR(err);
 
     /* self.model.transformer.resblocks[0].attn.in_proj Linear */
-    err = attnInProj0->forward(input, bufferAttnInProj0, num_events_in_list, event_wait_list,
-                               &event1);
+    {
+        Tracer::Scope scope("in_proj");
+        err = attnInProj0->forward(input, bufferAttnInProj0, num_events_in_list, event_wait_list,
+                                   &event1);
+    }
     CHECK_ERROR(err);
 
     // error=0.00001144409179687500
@@ -120,6 +138,7 @@ cl_int MultiHeadAttention::forward(cl_mem input, cl_mem output, cl_uint num_even
                                  &event1,
                                  &event2);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("permute3D_1_0_2", event2);
 
     // error=0.00001144409179687500
     // util::testBuffer(cmdQueue, bufferAttnInProj0_QKV, "encoder/test/resblock_0_attn_in_proj_qkv_test_fp32.npy");
@@ -136,12 +155,14 @@ cl_int MultiHeadAttention::forward(cl_mem input, cl_mem output, cl_uint num_even
                                  globalSizePermute_QKV_head, nullptr, 1,
                                  &event2,
                                  &event3);
+    Tracer::getInstance().record("permute3D_1_0_2", event3);
 
     size_t globalOffsetK[3] = {CONTEXT_LENGTH, 0, 0};
     err |= clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_1_0_2, 3, globalOffsetK,
                                   globalSizePermute_QKV_head, nullptr, 1,
                                   &event2,
                                   &event3);
+    Tracer::getInstance().record("permute3D_1_0_2", event3);
 
     size_t globalOffsetV[3] = {CONTEXT_LENGTH * 2, 0, 0};
     err |= clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_1_0_2, 3, globalOffsetV,
@@ -149,6 +170,7 @@ cl_int MultiHeadAttention::forward(cl_mem input, cl_mem output, cl_uint num_even
                                   &event2,
                                   &event3);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("permute3D_1_0_2", event3);
 
     // error=0.00001144409179687500
     // util::testBuffer(cmdQueue, bufferAttnInProj0, "encoder/test/resblock_0_attn_in_proj_head_test_fp32.npy");
@@ -181,6 +203,7 @@ cl_int MultiHeadAttention::forward(cl_mem input, cl_mem output, cl_uint num_even
                                  nullptr, 3,
                                  &event3,
                                  &event4);
+    Tracer::getInstance().record("add_matmul_attention", event4);
      naive QxK */
 
     /* optimized QxK */
@@ -202,6 +225,7 @@ cl_int MultiHeadAttention::forward(cl_mem input, cl_mem output, cl_uint num_even
                                  &event3,
                                  &event4);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("batch_matmul_mask", event4);
     /* optimized QxK */
 
 
@@ -221,6 +245,7 @@ cl_int MultiHeadAttention::forward(cl_mem input, cl_mem output, cl_uint num_even
                                  &event4,
                                  &event5);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("softmax", event5);
 
     // util::testBuffer(cmdQueue, bufferAttentionQK, "encoder/test/resblock_0_attn_softmax_test_fp32.npy");
 
@@ -240,6 +265,7 @@ cl_int MultiHeadAttention::forward(cl_mem input, cl_mem output, cl_uint num_even
                                  &event5,
                                  &event6);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("matmul_attention", event6);
      naive - QK x V*/
 
     /* optimized - QK x V */
@@ -259,6 +285,7 @@ cl_int MultiHeadAttention::forward(cl_mem input, cl_mem output, cl_uint num_even
                                  &event5,
                                  &event6);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("batch_matmul", event6);
     /* optimized - QK x V */
 
     // max diff: 0.00000409036874771118
@@ -275,8 +302,12 @@ cl_int MultiHeadAttention::forward(cl_mem input, cl_mem output, cl_uint num_even
                                  &event6,
                                  &event7);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("permute3D_1_0_2", event7);
 
-    err = attnOutProj0->forward(bufferEmbedding, output, 1, &event7, event);
+    {
+        Tracer::Scope scope("out_proj");
+        err = attnOutProj0->forward(bufferEmbedding, output, 1, &event7, event);
+    }
     CHECK_ERROR(err)
 
     // max diff: 0.00000362098217010498
@@ -326,3 +357,127 @@ cl_int MultiHeadAttention::forward(cl_mem input, cl_mem output, cl_uint num_even
 
     return CL_SUCCESS;
 }
+
+cl_int MultiHeadAttention::forwardFused(cl_mem input, cl_mem output, cl_uint num_events_in_list,
+                                        const cl_event *event_wait_list, cl_event *event) {
+    cl_int err;
+    size_t inputBytes;
+    cl_event event0, event1;
+    cl_mem bufferAttnInProj0, bufferEmbedding;
+
+    err = clGetMemObjectInfo(input, CL_MEM_SIZE, sizeof(size_t), &inputBytes, nullptr);
+    CHECK_ERROR(err);
+
+    bufferAttnInProj0 = clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes * 3, nullptr, &err);
+    CHECK_ERROR(err);
+
+    bufferEmbedding = clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes, nullptr, &err);
+    CHECK_ERROR(err);
+
+    {
+        Tracer::Scope scope("in_proj");
+        err = attnInProj0->forward(input, bufferAttnInProj0, num_events_in_list, event_wait_list,
+                                   &event0);
+    }
+    CHECK_ERROR(err);
+
+    /* work-group 하나가 모든 query (key 를 한 번만 local memory 로), 안 되면 나눔 */
+    cl_device_id deviceId;
+    size_t maxLocalSize;
+    err = clGetCommandQueueInfo(cmdQueue, CL_QUEUE_DEVICE, sizeof(cl_device_id), &deviceId,
+                                nullptr);
+    err |= clGetKernelWorkGroupInfo(kernel->causal_attention, deviceId,
+                                    CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &maxLocalSize,
+                                    nullptr);
+    CHECK_ERROR(err);
+
+    cl_int length = CONTEXT_LENGTH;
+    cl_int embedDim = EMBEDDING_SIZE;
+    float scale = 1.f / sqrtf(static_cast<float>(CAUSAL_HEAD_DIM));
+    size_t localBytes = sizeof(float) * CAUSAL_TILE * CAUSAL_HEAD_DIM;
+    err = clSetKernelArg(kernel->causal_attention, 0, sizeof(cl_mem), &bufferAttnInProj0);
+    err |= clSetKernelArg(kernel->causal_attention, 1, sizeof(cl_mem), &bufferEmbedding);
+    err |= clSetKernelArg(kernel->causal_attention, 2, sizeof(cl_int), &length);
+    err |= clSetKernelArg(kernel->causal_attention, 3, sizeof(cl_int), &embedDim);
+    err |= clSetKernelArg(kernel->causal_attention, 4, sizeof(float), &scale);
+    err |= clSetKernelArg(kernel->causal_attention, 5, localBytes, nullptr);
+    err |= clSetKernelArg(kernel->causal_attention, 6, localBytes, nullptr);
+    CHECK_ERROR(err);
+
+    size_t localSize = std::min<size_t>(CONTEXT_LENGTH, maxLocalSize);
+    size_t globalSize[2] = {(CONTEXT_LENGTH + localSize - 1) / localSize * localSize, numHeads};
+    size_t localSizeAttention[2] = {localSize, 1};
+    err = clEnqueueNDRangeKernel(cmdQueue, kernel->causal_attention, 2, nullptr, globalSize,
+                                 localSizeAttention, 1, &event0, &event1);
+    CHECK_ERROR(err);
+    Tracer::getInstance().record("causal_attention", event1);
+
+    {
+        Tracer::Scope scope("out_proj");
+        err = attnOutProj0->forward(bufferEmbedding, output, 1, &event1, event);
+    }
+    CHECK_ERROR(err);
+
+    clReleaseEvent(event0);
+    clReleaseEvent(event1);
+    clReleaseMemObject(bufferAttnInProj0);
+    clReleaseMemObject(bufferEmbedding);
+    return CL_SUCCESS;
+}
+
+cl_int MultiHeadAttention::forwardCpu(cl_mem input, cl_mem output, cl_uint num_events_in_list,
+                                      const cl_event *event_wait_list, cl_event *event) {
+    cl_int err;
+    size_t inputBytes;
+    cl_event event0, event1;
+    cl_mem bufferAttnInProj0, bufferEmbedding;
+
+    err = clGetMemObjectInfo(input, CL_MEM_SIZE, sizeof(size_t), &inputBytes, nullptr);
+    CHECK_ERROR(err);
+
+    bufferAttnInProj0 = clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes * 3, nullptr, &err);
+    CHECK_ERROR(err);
+
+    bufferEmbedding = clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes, nullptr, &err);
+    CHECK_ERROR(err);
+
+    {
+        Tracer::Scope scope("in_proj");
+        err = attnInProj0->forward(input, bufferAttnInProj0, num_events_in_list, event_wait_list,
+                                   &event0);
+    }
+    CHECK_ERROR(err);
+
+    {
+        Tracer::HostSpan span("cpu_attention");
+        CpuBackend::Mapping mapping(cmdQueue, 1, &event0);
+        auto out = mapping.map(bufferEmbedding, &err);
+        CHECK_ERROR(err);
+        auto qkv = mapping.mapRead(bufferAttnInProj0, &err);
+        CHECK_ERROR(err);
+        auto mask = mapping.mapRead(bufferAttentionMask, &err);
+        CHECK_ERROR(err);
+
+        size_t head_dim = EMBEDDING_SIZE / numHeads;
+        cpu::attention(qkv, EMBEDDING_SIZE * 3, qkv + EMBEDDING_SIZE, EMBEDDING_SIZE * 3,
+                       qkv + EMBEDDING_SIZE * 2, EMBEDDING_SIZE * 3, out, EMBEDDING_SIZE,
+                       numHeads, CONTEXT_LENGTH, CONTEXT_LENGTH, head_dim,
+                       1.f / sqrtf(static_cast<float>(head_dim)), mask);
+
+        err = mapping.unmap(&event1);
+        CHECK_ERROR(err);
+    }
+
+    {
+        Tracer::Scope scope("out_proj");
+        err = attnOutProj0->forward(bufferEmbedding, output, 1, &event1, event);
+    }
+    CHECK_ERROR(err);
+
+    clReleaseEvent(event0);
+    clReleaseEvent(event1);
+    clReleaseMemObject(bufferAttnInProj0);
+    clReleaseMemObject(bufferEmbedding);
+
+    return CL_SUCCESS;
+}
@@ -35,6 +35,14 @@ public:
     void init();
 
 private:
+    /* MULTI_HEAD_ATTENTION_KERNEL_VERSION 1. in_proj -> causal_attention -> out_proj */
+    cl_int forwardFused(cl_mem input, cl_mem output, cl_uint num_events_in_list,
+                        const cl_event *event_wait_list, cl_event *event);
+
+    /* CpuBackend::isEnabled(). in_proj 결과 (L, 3E) 에서 permute 없이 계산 */
+    cl_int forwardCpu(cl_mem input, cl_mem output, cl_uint num_events_in_list,
+                      const cl_event *event_wait_list, cl_event *event);
+
     cl_context context;
     cl_command_queue cmdQueue;
 
@@ -5,6 +5,9 @@
 #include "ResBlock.h"
 
 #include "../util.h"
+#include "../Tracer.h"
+#include "../CommandRecorder.h"
+#include "../Graph.h"
 #include <android/log.h>
 
 #define DEBUG 0
@@ -93,195 +96,210 @@ void ResBlock::init() {
 }
 
 cl_int ResBlock::forward(
-        cl_mem &input, cl_mem embed, cl_mem output,
+        cl_mem &input, cl_mem embed, cl_mem output, size_t height, size_t width,
         cl_uint num_events_embed, const cl_event *event_wait_list_embed,
         cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event
 ) {
     cl_int err;
-    cl_event event0_0, event0_1, event0_2[2];
-    cl_event event1_0;
-    cl_event event2_0;
-    cl_event event3_0, event3_1, event3_2[2];
-    cl_mem bufferInGroupNorm, bufferInConv2d, bufferEmbedTemp, bufferEmbed, bufferOut, bufferSkip;
-
-    size_t embSILUGlobalSize[1], chunkAddGlobalSize[1];
-    size_t inputBytes, outSize, embedBytes, chunkSize;
+    cl_mem bufferInGroupNorm, bufferInConv2d, bufferEmbedTemp = nullptr, bufferEmbed = nullptr;
+    cl_mem bufferOut, bufferSkip = nullptr;
+
+    size_t inputBytes, outSize, embedBytes = 0, chunkSize;
     err = clGetMemObjectInfo(input, CL_MEM_SIZE, sizeof(size_t), &inputBytes, nullptr);
     CHECK_ERROR(err);
 
     outSize = inputBytes / sizeof(float) / in_channels * out_channels;
+    chunkSize = outSize / out_channels;
+    bool hasEmbed = embed != nullptr && embed_linear != nullptr;
 
-    /* in_layers */
-    bufferInGroupNorm = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                       inputBytes,
-                                       nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferInConv2d = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * outSize,
-                                    nullptr, &err);
+    bufferInGroupNorm = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                               inputBytes,
+                                               nullptr, &err);
     CHECK_ERROR(err);
 
-    err = in_group_norm->forward(input, bufferInGroupNorm, num_events_in_list, event_wait_list,
-                                 &event0_0);
+    bufferInConv2d = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                            sizeof(float) * outSize,
+                                            nullptr, &err);
     CHECK_ERROR(err);
 
-    // max diff: 0.00000095367431640625
-    // util::testBuffer(cmdQueue, bufferInGroupNorm, "unet/input_block/test/test_resblock_group_norm.npy");
-    if (cnt == 2) {
-        // max diff: 0.00000727176666259766
-        // util::testBuffer(cmdQueue, bufferInGroupNorm, "unet/input_block/test/test_input_block_4_res_in_norm.npy");
-    }
-
-    err = clSetKernelArg(utilKernel->silu, 0, sizeof(cl_mem), &bufferInGroupNorm);
-    err |= clSetKernelArg(utilKernel->silu, 1, sizeof(cl_mem), &bufferInGroupNorm);
+    bufferOut = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                       sizeof(float) * outSize,
+                                       nullptr, &err);
     CHECK_ERROR(err);
 
-    size_t inSILUGlobalSize[3] = {inputBytes / sizeof(float)};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->silu, 1, nullptr, inSILUGlobalSize, nullptr, 1,
-                                 &event0_0, &event0_1);
+    if (hasEmbed) {
+        err = clGetMemObjectInfo(embed, CL_MEM_SIZE, sizeof(size_t), &embedBytes, nullptr);
+        CHECK_ERROR(err);
 
-    err = in_conv2d->forward(bufferInGroupNorm, bufferInConv2d, 1, &event0_1, &event0_2[0]);
-    CHECK_ERROR(err);
+        bufferEmbedTemp = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                                 embedBytes,
+                                                 nullptr, &err);
+        CHECK_ERROR(err);
 
-    // max diff: 0.00000810623168945312
-    // util::testBuffer(cmdQueue, bufferInConv2d, "unet/input_block/test/test_resblock_in_layers.npy");
-    if (cnt == 2) {
-        // max diff: 0.00001049041748046875
-        // util::testBuffer(cmdQueue, bufferInConv2d, "unet/input_block/test/test_input_block_4_res_in.npy");
+        bufferEmbed = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                             embedBytes / embed_linear->weightShape[1] *
+                                             embed_linear->weightShape[0],
+                                             nullptr, &err);
+        CHECK_ERROR(err);
     }
-    /* in_layers */
 
-    /* emb_layers */
-    if (embed == nullptr || embed_linear == nullptr) {
-        goto out_layers;
+    if (in_channels != out_channels) {
+        bufferSkip = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                            sizeof(float) * outSize,
+                                            nullptr, &err);
+        CHECK_ERROR(err);
     }
-    err = clGetMemObjectInfo(embed, CL_MEM_SIZE, sizeof(size_t), &embedBytes, nullptr);
-    CHECK_ERROR(err);
-
-    bufferEmbedTemp = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                     embedBytes,
-                                     nullptr, &err);
-    CHECK_ERROR(err);
-
-    bufferEmbed = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                 embedBytes / embed_linear->weightShape[1] *
-                                 embed_linear->weightShape[0],
-                                 nullptr, &err);
-    CHECK_ERROR(err);
 
-    err = clSetKernelArg(utilKernel->silu, 0, sizeof(cl_mem), &embed);
-    err |= clSetKernelArg(utilKernel->silu, 1, sizeof(cl_mem), &bufferEmbedTemp);
-    CHECK_ERROR(err);
+    /*
+     * in_layers, emb_layers, skip_connection 은 서로 독립이므로 Graph 가 dependency 를 풀어서
+     * 각 branch 의 첫 kernel 을 먼저 enqueue (out-of-order queue 에서 동시에 실행)
+     */
+    Graph graph({cmdQueue});
+    graph.input(input, num_events_in_list, event_wait_list);
+    if (hasEmbed) {
+        graph.input(embed, num_events_embed, event_wait_list_embed);
+    }
 
-    embSILUGlobalSize[0] = embedBytes / sizeof(float);
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->silu, 1, nullptr, embSILUGlobalSize, nullptr,
-                                 num_events_embed, event_wait_list_embed, &event1_0);
-    CHECK_ERROR(err);
+    /* in_layers */
+    graph.add("in_group_norm", {input}, {bufferInGroupNorm},
+              [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                  Tracer::Scope scope("in_group_norm");
+                  return in_group_norm->forward(input, bufferInGroupNorm, num_events, wait_list, e);
+              });
 
-    err = embed_linear->forward(bufferEmbedTemp, bufferEmbed, 1, &event1_0, &event0_2[1]);
-    CHECK_ERROR(err);
+    // max diff: 0.00000095367431640625
+    // util::testBuffer(cmdQueue, bufferInGroupNorm, "unet/input_block/test/test_resblock_group_norm.npy");
 
-    // max diff: 0.00001716613769531250
-    // util::testBuffer(cmdQueue, bufferEmbed, "unet/input_block/test/test_resblock_embed.npy");
+    graph.add("in_silu", {bufferInGroupNorm}, {bufferInGroupNorm},
+              [&](cl_command_queue queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                  return silu(queue, bufferInGroupNorm, bufferInGroupNorm, inputBytes / sizeof(float),
+                              num_events, wait_list, e);
+              });
 
-    chunkSize = outSize / out_channels;
-    err = clSetKernelArg(utilKernel->chunkwise_add, 0, sizeof(cl_mem), &bufferInConv2d);
-    err |= clSetKernelArg(utilKernel->chunkwise_add, 1, sizeof(cl_mem), &bufferEmbed);
-    err |= clSetKernelArg(utilKernel->chunkwise_add, 2, sizeof(cl_mem), &bufferInConv2d);
-    err |= clSetKernelArg(utilKernel->chunkwise_add, 3, sizeof(size_t), &chunkSize);
-    CHECK_ERROR(err);
+    graph.add("in_conv2d", {bufferInGroupNorm}, {bufferInConv2d},
+              [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                  Tracer::Scope scope("in_conv2d");
+                  return in_conv2d->forward(bufferInGroupNorm, bufferInConv2d, height, width,
+                                            num_events, wait_list, e);
+              });
 
-    chunkAddGlobalSize[0] = outSize;
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->chunkwise_add, 1, nullptr, chunkAddGlobalSize,
-                                 nullptr,
-                                 2, event0_2, &event2_0);
-    CHECK_ERROR(err);
+    // max diff: 0.00000810623168945312
+    // util::testBuffer(cmdQueue, bufferInConv2d, "unet/input_block/test/test_resblock_in_layers.npy");
+    /* in_layers */
 
-    // max diff: 0.00002098083496093750
-    // util::testBuffer(cmdQueue, bufferInConv2d, "unet/input_block/test/test_resblock_chunk_add.npy");
-    if (cnt == 2) {
-        //  max diff: 0.00001168251037597656
-        // util::testBuffer(cmdQueue, bufferInConv2d, "unet/input_block/test/test_input_block_4_res_chunk.npy");
+    /* emb_layers */
+    if (hasEmbed) {
+        graph.add("embed_silu", {embed}, {bufferEmbedTemp},
+                  [&](cl_command_queue queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      return silu(queue, embed, bufferEmbedTemp, embedBytes / sizeof(float),
+                                  num_events, wait_list, e);
+                  });
+
+        graph.add("embed_linear", {bufferEmbedTemp}, {bufferEmbed},
+                  [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      Tracer::Scope scope("embed_linear");
+                      return embed_linear->forward(bufferEmbedTemp, bufferEmbed, num_events, wait_list, e);
+                  });
+
+        // max diff: 0.00001716613769531250
+        // util::testBuffer(cmdQueue, bufferEmbed, "unet/input_block/test/test_resblock_embed.npy");
+
+        graph.add("chunkwise_add", {bufferInConv2d, bufferEmbed}, {bufferInConv2d},
+                  [&](cl_command_queue queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      cl_int err;
+                      err = record::clSetKernelArg(utilKernel->chunkwise_add, 0, sizeof(cl_mem), &bufferInConv2d);
+                      err |= record::clSetKernelArg(utilKernel->chunkwise_add, 1, sizeof(cl_mem), &bufferEmbed);
+                      err |= record::clSetKernelArg(utilKernel->chunkwise_add, 2, sizeof(cl_mem), &bufferInConv2d);
+                      err |= record::clSetKernelArg(utilKernel->chunkwise_add, 3, sizeof(size_t), &chunkSize);
+                      CHECK_ERROR(err);
+
+                      size_t chunkAddGlobalSize[1] = {outSize};
+                      err = record::clEnqueueNDRangeKernel(queue, utilKernel->chunkwise_add, 1, nullptr,
+                                                           chunkAddGlobalSize, nullptr,
+                                                           num_events, wait_list, e);
+                      CHECK_ERROR(err);
+                      Tracer::getInstance().record("chunkwise_add", *e);
+                      return CL_SUCCESS;
+                  });
+
+        // max diff: 0.00002098083496093750
+        // util::testBuffer(cmdQueue, bufferInConv2d, "unet/input_block/test/test_resblock_chunk_add.npy");
     }
     /* emb_layers */
 
     /* out_layers */
-    out_layers:
-    bufferOut = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                               sizeof(float) * outSize,
-                               nullptr, &err);
-    CHECK_ERROR(err);
-
-    cl_event *event_emb;
-    if (embed != nullptr) {
-        event_emb = &event2_0;
-    } else {
-        event_emb = &event0_2[0];
-    }
-    err = out_group_norm->forward(bufferInConv2d, bufferInConv2d, 1, event_emb, &event3_0);
-    CHECK_ERROR(err);
-
-    err = clSetKernelArg(utilKernel->silu, 0, sizeof(cl_mem), &bufferInConv2d);
-    err |= clSetKernelArg(utilKernel->silu, 1, sizeof(cl_mem), &bufferInConv2d);
-    CHECK_ERROR(err);
-
-    size_t outSILUGlobalSize[3] = {outSize};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->silu, 1, nullptr, outSILUGlobalSize, nullptr, 1,
-                                 &event3_0, &event3_1);
-    CHECK_ERROR(err);
-
-    err = out_conv2d->forward(bufferInConv2d, bufferOut, 1, &event3_1, &event3_2[0]);
-    CHECK_ERROR(err);
+    graph.add("out_group_norm", {bufferInConv2d}, {bufferInConv2d},
+              [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                  Tracer::Scope scope("out_group_norm");
+                  return out_group_norm->forward(bufferInConv2d, bufferInConv2d, num_events, wait_list, e);
+              });
+
+    graph.add("out_silu", {bufferInConv2d}, {bufferInConv2d},
+              [&](cl_command_queue queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                  return silu(queue, bufferInConv2d, bufferInConv2d, outSize, num_events, wait_list, e);
+              });
+
+    graph.add("out_conv2d", {bufferInConv2d}, {bufferOut},
+              [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                  Tracer::Scope scope("out_conv2d");
+                  return out_conv2d->forward(bufferInConv2d, bufferOut, height, width, num_events,
+                                             wait_list, e);
+              });
 
     // max diff: 0.00000953674316406250
     // util::testBuffer(cmdQueue, bufferOut, "unet/input_block/test/test_resblock_out_layers.npy");
-    if (cnt == 2) {
-        // max diff: 0.00001478195190429688
-        // util::testBuffer(cmdQueue, bufferOut, "unet/input_block/test/test_input_block_4_res_out.npy");
-    }
     /* out_layers */
 
     /* skip_connection */
+    cl_mem bufferResidual = input;
     if (in_channels != out_channels) {
-        bufferSkip = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * outSize,
-                                    nullptr, &err);
-        CHECK_ERROR(err);
-
-        err = skip_conv2d->forward(input, bufferSkip, num_events_in_list, event_wait_list,
-                                   &event3_2[1]);
-        CHECK_ERROR(err);
+        graph.add("skip_conv2d", {input}, {bufferSkip},
+                  [&](cl_command_queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                      Tracer::Scope scope("skip_conv2d");
+                      return skip_conv2d->forward(input, bufferSkip, height, width, num_events,
+                                                  wait_list, e);
+                  });
+        bufferResidual = bufferSkip;
+    }
 
-        if (cnt == 2) {
-            // max diff: 0.00000905990600585938
-            // util::testBuffer(cmdQueue, bufferSkip, "unet/input_block/test/test_input_block_4_res_skip.npy");
-        }
+    graph.add("elemwise_add", {bufferResidual, bufferOut}, {output},
+              [&](cl_command_queue queue, cl_uint num_events, const cl_event *wait_list, cl_event *e) {
+                  cl_int err;
+                  err = record::clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &bufferResidual);
+                  err |= record::clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &bufferOut);
+                  err |= record::clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &output);
+                  CHECK_ERROR(err);
+
+                  size_t elemAddGlobalSize[1] = {outSize};
+                  err = record::clEnqueueNDRangeKernel(queue, utilKernel->elemwise_add, 1, nullptr,
+                                                       elemAddGlobalSize, nullptr,
+                                                       num_events, wait_list, e);
+                  CHECK_ERROR(err);
+                  Tracer::getInstance().record("elemwise_add", *e);
+                  return CL_SUCCESS;
+              });
 
-        err = clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &bufferSkip);
-        err |= clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &bufferOut);
-        err |= clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &output);
-        CHECK_ERROR(err);
+    // max diff: 0.00000953674316406250
+    // util::testBuffer(cmdQueue, output, "unet/input_block/test/test_resblock_skip_connection.npy");
+    /* skip_connection */
 
-        size_t elemAddGlobalSize[1] = {outSize};
-        err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr, elemAddGlobalSize,
-                                     nullptr,
-                                     2, event3_2, event);
-        CHECK_ERROR(err);
-    } else {
-        err = clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &input);
-        err |= clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &bufferOut);
-        err |= clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &output);
-        CHECK_ERROR(err);
+    err = graph.run();
+    if (err == CL_SUCCESS) {
+        err = graph.getEvent(output, event);
+    }
 
-        size_t elemAddGlobalSize[1] = {outSize};
-        err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr, elemAddGlobalSize,
-                                     nullptr,
-                                     1, event3_2, event);
-        CHECK_ERROR(err);
-        // max diff: 0.00000953674316406250
-        // util::testBuffer(cmdQueue, output, "unet/input_block/test/test_resblock_skip_connection.npy");
+    record::clReleaseMemObject(bufferInGroupNorm);
+    record::clReleaseMemObject(bufferInConv2d);
+    record::clReleaseMemObject(bufferOut);
+    if (hasEmbed) {
+        record::clReleaseMemObject(bufferEmbedTemp);
+        record::clReleaseMemObject(bufferEmbed);
     }
+    if (bufferSkip != nullptr) {
+        record::clReleaseMemObject(bufferSkip);
+    }
+    CHECK_ERROR(err);
+
 #if DEBUG
     clWaitForEvents(1, event);
     if (count == 0)
@@ -292,37 +310,26 @@ cl_int ResBlock::forward(
             std::to_string(inputBytes / sizeof(float)) + ", " +
             std::to_string(embedBytes / sizeof(float)) + ", " +
             std::to_string(outSize);
-    util::printEventTime(message + ", input_silu", event0_1);
-    util::printEventTime(message + ", embed_silu", event1_0);
-    util::printEventTime(message + ", in_conv2d_silu", event3_1);
+    util::printEventTime(message + ", elemwise_add", *event);
 #endif
-    /* skip_connection */
-
-    clReleaseEvent(event0_0);
-    clReleaseEvent(event0_1);
-    clReleaseEvent(event0_2[0]);
-    clReleaseEvent(event3_0);
-    clReleaseEvent(event3_1);
-    clReleaseEvent(event3_2[0]);
-    if (in_channels != out_channels) {
-        clReleaseEvent(event3_2[1]);
-    }
-    clReleaseMemObject(bufferInGroupNorm);
-    clReleaseMemObject(bufferInConv2d);
-    clReleaseMemObject(bufferOut);
-    if (embed != nullptr) {
-        clReleaseEvent(event0_2[1]);
-        clReleaseEvent(event1_0);
-        clReleaseEvent(event2_0);
-        clReleaseMemObject(bufferEmbedTemp);
-        clReleaseMemObject(bufferEmbed);
-    }
-    if (in_channels != out_channels) {
-        clReleaseMemObject(bufferSkip);
-    }
 
     cnt += 1;
     return CL_SUCCESS;
 }
 
+cl_int ResBlock::silu(cl_command_queue queue, cl_mem in, cl_mem out, size_t size,
+                      cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event) {
+    cl_int err;
+    err = record::clSetKernelArg(utilKernel->silu, 0, sizeof(cl_mem), &in);
+    err |= record::clSetKernelArg(utilKernel->silu, 1, sizeof(cl_mem), &out);
+    CHECK_ERROR(err);
+
+    size_t globalSize[1] = {size};
+    err = record::clEnqueueNDRangeKernel(queue, utilKernel->silu, 1, nullptr, globalSize, nullptr,
+                                         num_events_in_list, event_wait_list, event);
+    CHECK_ERROR(err);
+    Tracer::getInstance().record("silu", *event);
+    return CL_SUCCESS;
+}
+
 int ResBlock::cnt = 0;
\ No newline at end of file
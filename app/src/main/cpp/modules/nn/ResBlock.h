@@ -40,11 +40,15 @@ public:
 
     void init();
 
-    cl_int forward(cl_mem &input, cl_mem embed, cl_mem output,
+    /* `input`: (in_channels, height, width) */
+    cl_int forward(cl_mem &input, cl_mem embed, cl_mem output, size_t height, size_t width,
                    cl_uint num_events_embed, const cl_event *event_wait_list_embed,
                    cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event);
 
 private:
+    cl_int silu(cl_command_queue queue, cl_mem in, cl_mem out, size_t size,
+                cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event);
+
     cl_context context;
     cl_command_queue cmdQueue;
 
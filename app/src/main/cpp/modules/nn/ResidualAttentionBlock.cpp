@@ -5,6 +5,7 @@
 #include "ResidualAttentionBlock.h"
 #include <android/log.h>
 #include "../util.h"
+#include "../Tracer.h"
 
 #define LOG_TAG "RESIDUAL_ATTENTION_BLOCK"
 #define CONTEXT_LENGTH 77
@@ -114,10 +115,16 @@ cl_int ResidualAttentionBlock::forward(cl_mem input, cl_mem output, cl_uint num_
                                nullptr, &err);
     CHECK_ERROR(err);
 
-    err = ln_1->forward(input, bufferEmbedding, num_events_in_list, event_wait_list, &event1);
+    {
+        Tracer::Scope scope("ln_1");
+        err = ln_1->forward(input, bufferEmbedding, num_events_in_list, event_wait_list, &event1);
+    }
     CHECK_ERROR(err);
 
-    err = attn->forward(bufferEmbedding, bufferEmbedding, 1, &event1, &event2);
+    {
+        Tracer::Scope scope("attn");
+        err = attn->forward(bufferEmbedding, bufferEmbedding, 1, &event1, &event2);
+    }
     CHECK_ERROR(err);
 
     err = clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &input);
@@ -129,16 +136,23 @@ cl_int ResidualAttentionBlock::forward(cl_mem input, cl_mem output, cl_uint num_
     err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr, globalSize, nullptr, 1,
                                  &event2, &event3);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("elemwise_add", event3);
 
     // max diff: 0.00000362098217010498
     // util::testBuffer(cmdQueue, bufferEmbedding, "encoder/test/resblock_0_add_attn_test_fp32.npy");
 
-    err = ln_2->forward(bufferEmbedding, bufferTemp, 1, &event3, &event4);
+    {
+        Tracer::Scope scope("ln_2");
+        err = ln_2->forward(bufferEmbedding, bufferTemp, 1, &event3, &event4);
+    }
 
     // max diff: 0.00003504753112792969
     // util::testBuffer(cmdQueue, bufferTemp, "encoder/test/resblock_0_ln2_test_fp32.npy");
 
-    err = mlp_c_fc->forward(bufferTemp, bufferMLP, 1, &event4, &event5);
+    {
+        Tracer::Scope scope("mlp_c_fc");
+        err = mlp_c_fc->forward(bufferTemp, bufferMLP, 1, &event4, &event5);
+    }
 
     // max diff: 0.00002098083496093750
     // util::testBuffer(cmdQueue, bufferMLP, "encoder/test/resblock_0_mlp_c_fc_test_fp32.npy");
@@ -151,11 +165,15 @@ cl_int ResidualAttentionBlock::forward(cl_mem input, cl_mem output, cl_uint num_
     err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->gelu, 1, nullptr, globalSizeGELU, nullptr, 1,
                                  &event5, &event6);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("gelu", event6);
 
     // max diff: 0.00002098083496093750
     // util::testBuffer(cmdQueue, bufferMLP, "encoder/test/resblock_0_mlp_gelu_test_fp32.npy");
 
-    err = mlp_c_proj->forward(bufferMLP, bufferTemp, 1, &event6, &event7);
+    {
+        Tracer::Scope scope("mlp_c_proj");
+        err = mlp_c_proj->forward(bufferMLP, bufferTemp, 1, &event6, &event7);
+    }
     CHECK_ERROR(err);
 
     // max diff: 0.00003051757812500000
@@ -169,6 +187,7 @@ cl_int ResidualAttentionBlock::forward(cl_mem input, cl_mem output, cl_uint num_
     err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr, globalSize, nullptr, 1,
                                  &event7, event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("elemwise_add", *event);
 
     // max diff: 0.00003051757812500000
     // util::testBuffer(cmdQueue, output, "encoder/test/resblock_0_test_fp32.npy");
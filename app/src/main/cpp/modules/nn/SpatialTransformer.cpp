@@ -6,6 +6,10 @@
 
 #include <android/log.h>
 #include "../util.h"
+#include "../Tracer.h"
+#include "../CommandRecorder.h"
+#include "../setting.h"
+#include "../cpu/CpuBackend.h"
 
 #define LOG_TAG "SPATIAL_TRANSFORMER"
 
@@ -114,61 +118,81 @@ cl_int SpatialTransformer::forward(cl_mem input, cl_mem condition, cl_mem output
     CHECK_ERROR(err);
     size_t inputSize = inputBytes / sizeof(float);
 
-    bufferGroupNorm = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                     inputBytes,
-                                     nullptr, &err);
+    if (ACTIVATION_LAYOUT_MODE == 1 && !CpuBackend::isEnabled()) {
+        return forwardChannelLast(input, condition, output, num_events_in_list, event_wait_list,
+                                  event);
+    }
+
+    bufferGroupNorm = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                             inputBytes,
+                                             nullptr, &err);
     CHECK_ERROR(err);
 
-    bufferPermute = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                   inputBytes,
-                                   nullptr, &err);
+    bufferPermute = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                           inputBytes,
+                                           nullptr, &err);
     CHECK_ERROR(err);
 
-    err = groupNorm->forward(input, bufferGroupNorm, num_events_in_list, event_wait_list, &event0);
+    {
+        Tracer::Scope scope("norm");
+        err = groupNorm->forward(input, bufferGroupNorm, num_events_in_list, event_wait_list, &event0);
+    }
     CHECK_ERROR(err);
 
     // max diff: 0.00000278651714324951
     // util::testBuffer(cmdQueue, bufferGroupNorm, "unet/input_block/test/test_spatial_norm.npy");
 
-    err = clSetKernelArg(utilKernel->permute3D_0_2_1, 0, sizeof(cl_mem), &bufferGroupNorm);
-    err |= clSetKernelArg(utilKernel->permute3D_0_2_1, 1, sizeof(cl_mem), &bufferPermute);
+    err = record::clSetKernelArg(utilKernel->permute3D_0_2_1, 0, sizeof(cl_mem), &bufferGroupNorm);
+    err |= record::clSetKernelArg(utilKernel->permute3D_0_2_1, 1, sizeof(cl_mem), &bufferPermute);
     CHECK_ERROR(err);
 
     size_t permuteGlobalSize[3] = {1, channels, inputSize / channels};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_0_2_1, 3, nullptr,
-                                 permuteGlobalSize, nullptr, 1, &event0, &event1);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_0_2_1, 3, nullptr,
+                                         permuteGlobalSize, nullptr, 1, &event0, &event1);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("permute3D_0_2_1", event1);
 
-    err = projInLinear->forward(bufferPermute, bufferGroupNorm, 1, &event1, &event2);
+    {
+        Tracer::Scope scope("proj_in");
+        err = projInLinear->forward(bufferPermute, bufferGroupNorm, 1, &event1, &event2);
+    }
     CHECK_ERROR(err);
 
     // max diff: 0.00000250339508056641
     // util::testBuffer(cmdQueue, bufferGroupNorm, "unet/input_block/test/test_spatial_proj_in.npy");
 
-    err = transformer->forward(bufferGroupNorm, condition, bufferPermute, 1, &event2, &event3);
+    {
+        Tracer::Scope scope("transformer_block");
+        err = transformer->forward(bufferGroupNorm, condition, bufferPermute, 1, &event2, &event3);
+    }
     CHECK_ERROR(err);
 
-    err = projOutLinear->forward(bufferPermute, bufferGroupNorm, 1, &event3, &event4);
+    {
+        Tracer::Scope scope("proj_out");
+        err = projOutLinear->forward(bufferPermute, bufferGroupNorm, 1, &event3, &event4);
+    }
     CHECK_ERROR(err);
 
-    err = clSetKernelArg(utilKernel->permute3D_0_2_1, 0, sizeof(cl_mem), &bufferGroupNorm);
-    err |= clSetKernelArg(utilKernel->permute3D_0_2_1, 1, sizeof(cl_mem), &bufferPermute);
+    err = record::clSetKernelArg(utilKernel->permute3D_0_2_1, 0, sizeof(cl_mem), &bufferGroupNorm);
+    err |= record::clSetKernelArg(utilKernel->permute3D_0_2_1, 1, sizeof(cl_mem), &bufferPermute);
     CHECK_ERROR(err);
 
     size_t permuteGlobalSize2[3] = {1, inputSize / channels, channels};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_0_2_1, 3, nullptr,
-                                 permuteGlobalSize2, nullptr, 1, &event4, &event5);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->permute3D_0_2_1, 3, nullptr,
+                                         permuteGlobalSize2, nullptr, 1, &event4, &event5);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("permute3D_0_2_1", event5);
 
-    err = clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &bufferPermute);
-    err |= clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &output);
+    err = record::clSetKernelArg(utilKernel->elemwise_add, 0, sizeof(cl_mem), &bufferPermute);
+    err |= record::clSetKernelArg(utilKernel->elemwise_add, 1, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(utilKernel->elemwise_add, 2, sizeof(cl_mem), &output);
     CHECK_ERROR(err);
 
     size_t addGlobalSize[1] = {inputSize};
-    err = clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr, addGlobalSize, nullptr,
-                                 1, &event5, event);
+    err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->elemwise_add, 1, nullptr, addGlobalSize, nullptr,
+                                         1, &event5, event);
     CHECK_ERROR(err);
+    Tracer::getInstance().record("elemwise_add", *event);
 
     // max diff: 0.00001049041748046875
     // util::testBuffer(cmdQueue, output, "unet/input_block/test/test_spatial.npy");
@@ -179,8 +203,73 @@ cl_int SpatialTransformer::forward(cl_mem input, cl_mem condition, cl_mem output
     clReleaseEvent(event3);
     clReleaseEvent(event4);
     clReleaseEvent(event5);
-    clReleaseMemObject(bufferGroupNorm);
-    clReleaseMemObject(bufferPermute);
+    record::clReleaseMemObject(bufferGroupNorm);
+    record::clReleaseMemObject(bufferPermute);
+
+    return CL_SUCCESS;
+}
+
+cl_int SpatialTransformer::forwardChannelLast(cl_mem input, cl_mem condition, cl_mem output,
+                                              cl_uint num_events_in_list,
+                                              const cl_event *event_wait_list, cl_event *event) {
+    cl_int err;
+    cl_event event0, event1, event2, event3;
+    cl_mem bufferTokens, bufferTemp;
+
+    size_t inputBytes;
+    err = clGetMemObjectInfo(input, CL_MEM_SIZE, sizeof(size_t), &inputBytes, nullptr);
+    CHECK_ERROR(err);
+    size_t inputSize = inputBytes / sizeof(float);
+
+    /* (HW, C) */
+    bufferTokens = record::clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes, nullptr, &err);
+    CHECK_ERROR(err);
+
+    bufferTemp = record::clCreateBuffer(context, CL_MEM_READ_WRITE, inputBytes, nullptr, &err);
+    CHECK_ERROR(err);
+
+    {
+        Tracer::Scope scope("norm");
+        err = groupNorm->forwardChannelLast(input, bufferTemp, num_events_in_list,
+                                            event_wait_list, &event0);
+    }
+    CHECK_ERROR(err);
+
+    {
+        Tracer::Scope scope("proj_in");
+        err = projInLinear->forward(bufferTemp, bufferTokens, 1, &event0, &event1);
+    }
+    CHECK_ERROR(err);
+
+    {
+        Tracer::Scope scope("transformer_block");
+        err = transformer->forward(bufferTokens, condition, bufferTemp, 1, &event1, &event2);
+    }
+    CHECK_ERROR(err);
+
+    {
+        Tracer::Scope scope("proj_out");
+        err = projOutLinear->forward(bufferTemp, bufferTokens, 1, &event2, &event3);
+    }
+    CHECK_ERROR(err);
+
+    err = record::clSetKernelArg(utilKernel->channel_first_add, 0, sizeof(cl_mem), &bufferTokens);
+    err |= record::clSetKernelArg(utilKernel->channel_first_add, 1, sizeof(cl_mem), &input);
+    err |= record::clSetKernelArg(utilKernel->channel_first_add, 2, sizeof(cl_mem), &output);
+    CHECK_ERROR(err);
+
+    size_t addGlobalSize[2] = {inputSize / channels, channels / 4};
+    err = record::clEnqueueNDRangeKernel(cmdQueue, utilKernel->channel_first_add, 2, nullptr,
+                                         addGlobalSize, nullptr, 1, &event3, event);
+    CHECK_ERROR(err);
+    Tracer::getInstance().record("channel_first_add", *event);
+
+    clReleaseEvent(event0);
+    clReleaseEvent(event1);
+    clReleaseEvent(event2);
+    clReleaseEvent(event3);
+    record::clReleaseMemObject(bufferTokens);
+    record::clReleaseMemObject(bufferTemp);
 
     return CL_SUCCESS;
 }
\ No newline at end of file
@@ -66,6 +66,11 @@ public:
     void init();
 
 private:
+    /* ACTIVATION_LAYOUT_MODE 1. GroupNorm 이 (HW, C) 로 쓰고 proj_out 결과는 transpose 하면서 residual add */
+    cl_int forwardChannelLast(cl_mem input, cl_mem condition, cl_mem output,
+                              cl_uint num_events_in_list, const cl_event *event_wait_list,
+                              cl_event *event);
+
     size_t channels;
     cl_command_queue cmdQueue;
     cl_context context;
@@ -5,6 +5,10 @@
 #include "UpSample.h"
 
 #include "../util.h"
+#include "../Tracer.h"
+#include "../CommandRecorder.h"
+#include "../cpu/CpuBackend.h"
+#include "../cpu/CpuKernel.h"
 
 #include <android/log.h>
 
@@ -44,7 +48,7 @@ void UpSample::init() {
 }
 
 cl_int UpSample::forward(
-        cl_mem input, cl_mem output,
+        cl_mem input, cl_mem output, size_t height, size_t width,
         cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event
 ) {
     cl_int err;
@@ -53,24 +57,16 @@ cl_int UpSample::forward(
 
     size_t inputBytes;
     err = clGetMemObjectInfo(input, CL_MEM_SIZE, sizeof(size_t), &inputBytes, nullptr);
+    CHECK_ERROR(err);
     size_t inputSize = inputBytes / sizeof(float);
     size_t inputChannel = conv2d->weightShape[1];
+    size_t heightXwidth = height * width;
 
-    if (inputSize % inputChannel != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] inputSize(%ld) %% weightShape[1](%ld) != 0",
-                            __FILE__, __LINE__, inputSize, inputChannel);
-        throw std::runtime_error("inputSize % weightShape[1] != 0");
-    }
-
-    size_t heightXwidth = inputSize / inputChannel;
-    auto height = static_cast<size_t>(sqrt((heightXwidth)));
-
-    if (height * height != heightXwidth) {
+    if (inputSize != inputChannel * heightXwidth) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] height(%ld)^2 != heightXwidth(%ld)",
-                            __FILE__, __LINE__, height, heightXwidth);
-        throw std::runtime_error("height^2 != heightXwidth");
+                            "[%s:%d] inputSize(%ld) != weightShape[1](%ld) * height(%ld) * width(%ld)",
+                            __FILE__, __LINE__, inputSize, inputChannel, height, width);
+        throw std::runtime_error("inputSize != weightShape[1] * height * width");
     }
 
     size_t outputBytes;
@@ -80,32 +76,50 @@ cl_int UpSample::forward(
     size_t outputSize = outputBytes / sizeof(float);
     if (outputSize != heightXwidth * scale * scale * conv2d->weightShape[0]) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "[%s:%d] outputSize(%ld) != (height(%ld) * scale(%ld))^2 * weightShape[0](%ld)",
-                            __FILE__, __LINE__, outputSize, height, scale, conv2d->weightShape[0]);
-        throw std::runtime_error("outputSize != (height * scale)^2 * weightShape[0]");
+                            "[%s:%d] outputSize(%ld) != height(%ld) * width(%ld) * scale(%ld)^2 * weightShape[0](%ld)",
+                            __FILE__, __LINE__, outputSize, height, width, scale,
+                            conv2d->weightShape[0]);
+        throw std::runtime_error("outputSize != height * width * scale^2 * weightShape[0]");
     }
 
-    bufferUpSample = clCreateBuffer(context, CL_MEM_READ_WRITE,
-                                    sizeof(float) * inputChannel * (heightXwidth * scale * scale),
-                                    nullptr, &err);
+    bufferUpSample = record::clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                            sizeof(float) * inputChannel * (heightXwidth * scale * scale),
+                                            nullptr, &err);
     CHECK_ERROR(err);
 
-    err = clSetKernelArg(kernel->up_sample_nearest, 0, sizeof(cl_mem), &input);
-    err |= clSetKernelArg(kernel->up_sample_nearest, 1, sizeof(cl_mem), &bufferUpSample);
-    err |= clSetKernelArg(kernel->up_sample_nearest, 2, sizeof(size_t), &scale);
-    CHECK_ERROR(err);
-
-    size_t upSampleGlobalSize[3] = {inputChannel, height, height};
-    err = clEnqueueNDRangeKernel(cmdQueue, kernel->up_sample_nearest, 3, nullptr,
-                                 upSampleGlobalSize, nullptr, num_events_in_list, event_wait_list,
-                                 &event0);
-    CHECK_ERROR(err);
+    if (CpuBackend::isEnabled()) {
+        Tracer::HostSpan span("cpu_up_sample_nearest");
+        CpuBackend::Mapping mapping(cmdQueue, num_events_in_list, event_wait_list);
+        auto out = mapping.map(bufferUpSample, &err);
+        CHECK_ERROR(err);
+        auto in = mapping.mapRead(input, &err);
+        CHECK_ERROR(err);
+        cpu::upSampleNearest(in, out, inputChannel, height, width, scale);
+        err = mapping.unmap(&event0);
+        CHECK_ERROR(err);
+    } else {
+        err = record::clSetKernelArg(kernel->up_sample_nearest, 0, sizeof(cl_mem), &input);
+        err |= record::clSetKernelArg(kernel->up_sample_nearest, 1, sizeof(cl_mem), &bufferUpSample);
+        err |= record::clSetKernelArg(kernel->up_sample_nearest, 2, sizeof(size_t), &scale);
+        CHECK_ERROR(err);
+
+        size_t upSampleGlobalSize[3] = {inputChannel, height, width};
+        err = record::clEnqueueNDRangeKernel(cmdQueue, kernel->up_sample_nearest, 3, nullptr,
+                                             upSampleGlobalSize, nullptr, num_events_in_list,
+                                             event_wait_list, &event0);
+        CHECK_ERROR(err);
+        Tracer::getInstance().record("up_sample_nearest", event0);
+    }
 
-    err = conv2d->forward(bufferUpSample, output, 1, &event0, event);
+    {
+        Tracer::Scope scope("conv");
+        err = conv2d->forward(bufferUpSample, output, height * scale, width * scale, 1, &event0,
+                              event);
+    }
     CHECK_ERROR(err);
 
     clReleaseEvent(event0);
-    clReleaseMemObject(bufferUpSample);
+    record::clReleaseMemObject(bufferUpSample);
 
     return CL_SUCCESS;
 }
\ No newline at end of file
@@ -26,8 +26,9 @@ public:
 
     ~UpSample();
 
-    cl_int forward(cl_mem input, cl_mem output, cl_uint num_events_in_list,
-                   const cl_event *event_wait_list, cl_event *event);
+    /* `input`: (in_channel, height, width) */
+    cl_int forward(cl_mem input, cl_mem output, size_t height, size_t width,
+                   cl_uint num_events_in_list, const cl_event *event_wait_list, cl_event *event);
 
     void init();
 
@@ -5,9 +5,67 @@
 #ifndef MY_OPENCL_SETTING_H
 #define MY_OPENCL_SETTING_H
 
+/*
+ * *_KERNEL_VERSION : default version.
+ * runtime override (per layer, force) : KernelSelector, kernel_config.txt
+ */
+
 #define LINEAR_KERNEL_VERSION 4
 
-#define CROSS_ATTENTION_KERNEL_VERSION 2
+/**
+ * Linear Tune Mode (LINEAR_KERNEL_VERSION 4)
+ * Version 0: fixed tile size list
+ * Version 1: look up tuning database (tuning/linear_<device>.txt)
+ * Version 2: Version 1 + benchmark (M, N, K) not in database and save
+ */
+#define LINEAR_TUNE_MODE 1
+
+/**
+ * CrossAttention
+ * Version 0: permute (Q, K, V) + einsum_bik_bjk_bij + softmax + einsum_bij_bjk_bik + permute
+ * Version 1: Version 0 + optimized_einsum_bik_bjk_bij, optimized_einsum_bik_bkj_bij
+ * Version 2: Version 1 + K 를 (head, dim, token) 으로 permute 해서 optimized_einsum_bik_bkj_bij_general
+ * Version 3: strided_batch_matmul. Linear 결과 (token, head * dim) 를 stride 로 읽고 to_out 입력 layout 으로 씀 (permute 없음)
+ */
+#define CROSS_ATTENTION_KERNEL_VERSION 3
+
+/**
+ * AttnBlock (decoder)
+ * Version 0: permute Q, softmax 결과 + batch_matmul_scale (tile 로 나누어 떨어지지 않으면 batch_matmul)
+ * Version 1: strided_batch_matmul. conv 결과 (channel, h * w) 를 transpose 로 읽음 (permute 없음)
+ */
+#define ATTN_BLOCK_KERNEL_VERSION 1
+
+/**
+ * MultiHeadAttention (text encoder)
+ * Version 0: permute (Q, K, V) + batch_matmul_mask + local_softmax + batch_matmul + permute
+ * Version 1: causal_attention 하나 (in_proj 결과를 그대로 읽고 out_proj 입력 layout 으로 씀, head dim 64)
+ */
+#define MULTI_HEAD_ATTENTION_KERNEL_VERSION 1
+
+/**
+ * Softmax (CrossAttention, AttnBlock)
+ * Version 0: softmax (max 를 빼지 않음, row 전체를 local memory 에 둠)
+ * Version 1: softmax_online (max 를 빼는 online softmax, float4, row 길이 제한 없음. fp16 : softmax_online_half)
+ */
+#define SOFTMAX_KERNEL_VERSION 1
+
+/**
+ * QKV Fuse Mode (CrossAttention self attention, attn1)
+ * Version 0: to_q, to_k, to_v Linear 3 개 + permute 3 개
+ * Version 1: load 할 때 weight 를 이어 붙인 to_qkv Linear 1 개 + split_qkv_heads (head-major Q, K, V)
+ *            split_qkv_heads 는 CROSS_ATTENTION_KERNEL_VERSION 0 ~ 2 에서만 실행.
+ *            Version 3 (strided) 은 to_qkv 결과를 stride 로 바로 읽음
+ */
+#define QKV_FUSE_MODE 1
+
+/**
+ * Activation Layout Mode (SpatialTransformer 경계)
+ * Version 0: GroupNorm (C, HW) -> permute (HW, C) -> proj_in ... proj_out -> permute (C, HW) -> residual add
+ * Version 1: GroupNorm 이 channel-last (HW, C) 로 씀 (group_norm_channel_last),
+ *            proj_out 결과는 transpose 하면서 residual add (channel_first_add). permute 없음
+ */
+#define ACTIVATION_LAYOUT_MODE 1
 
 /**
  * Conv2D
@@ -20,9 +78,20 @@
  * Version 6: Version 5 + input vectorize
  * Version 7: Version 5 + weight vectorize (1669ms)
  * Version 8: Version 6 + input reorder
+ * Version 9: implicit GEMM. input patch 를 local memory 에 직접 load (im2win buffer 없음)
  */
 #define CONV_2D_KERNEL_VERSION 8
 
+/**
+ * Shape Specialize Mode (SpecializedKernel, ProgramCache)
+ * M, N, K, channel, tile size 를 -D 상수로 build 한 variant 를 shape 마다 사용 (loop unroll, bounds check 제거).
+ * 대상 : tile_reg_m_vector_n_linear (Linear 6), im2win_channel_reg_transpose_reorder_vector_v8_matmul (Conv2D 8),
+ *        optimized_einsum_bik_bkj_bij (CrossAttention 1, 2)
+ * Version 0: off (runtime argument)
+ * Version 1: on (build 실패 시 runtime argument kernel)
+ */
+#define SHAPE_SPECIALIZE_MODE 1
+
 /**
  * UNet Load Mode
  * Version 0: Initial version
@@ -30,4 +99,78 @@
  */
 #define UNET_LOAD_MODE 1
 
+/**
+ * UNet Replay Mode (CommandRecorder)
+ * 첫 forward 의 kernel launch 를 기록하고, 이후 step 은 timestep embedding, x (condition 은 바뀐 경우) 만
+ * 같은 buffer 에 써서 replay. UNet 전체 weight 와 중간 buffer 가 resident.
+ * Version 0: off
+ * Version 1: launch list (argument 가 bind 된 kernel 복제를 enqueue)
+ * Version 2: cl_khr_command_buffer (지원하지 않으면 Version 1)
+ */
+#define UNET_REPLAY_MODE 0
+
+/**
+ * Decoder Tile Mode
+ * mid block (AttnBlock, GroupNorm 통계 포함) 까지는 전체 latent 로 한 번 실행하고, up block ~ out 은 겹치는 tile 로
+ * 나눠 실행 후 겹친 부분을 선형 가중치로 섞음 (up block 의 GroupNorm 은 tile 안의 통계).
+ * 큰 activation (e.g. 128 x 512 x 512) 대신 tile 크기의 activation 만 필요, tile 을 도는 동안 up ~ out weight 는 resident.
+ * Version 0: off (전체 latent 를 한 번에)
+ * Version 1: tile (DECODER_TILE_SIZE, DECODER_TILE_OVERLAP : latent 기준)
+ */
+#define DECODER_TILE_MODE 0
+#define DECODER_TILE_SIZE 40
+#define DECODER_TILE_OVERLAP 8
+
+/**
+ * Embedding Cache Mode (EmbeddingCache, token ids -> TextEncoder 출력 (77, 1024))
+ * hit 이면 TextEncoder 생성 (weight load) 과 실행을 모두 건너뜀. 같은 prompt 의 seed sweep, retry, preset.
+ * Version 0: off
+ * Version 1: memory LRU (EMBEDDING_CACHE_SIZE 개, 개당 308KB)
+ * Version 2: Version 1 + disk (MEDIA_PATH/embedding/<hash>.bin, 삭제는 직접)
+ */
+#define EMBEDDING_CACHE_MODE 1
+#define EMBEDDING_CACHE_SIZE 16
+
+/**
+ * Token Embedding Mode (TextEncoder)
+ * Version 0: host table (embedding_fp32.npy 전체를 host 에 두고 CPU 로 row 복사, 약 200MB RSS)
+ * Version 1: device table (fp32), gather + positional embedding add 를 token_embedding kernel 하나로
+ * Version 2: Version 1 + fp16 table (embedding_fp16.npy, 없으면 fp32 npy 를 load 하면서 변환, 약 100MB)
+ */
+#define TOKEN_EMBEDDING_MODE 1
+
+/**
+ * Residency Mode (ResidencyManager)
+ * TextEncoder / UNet / Decoder 를 JNI 호출마다 새로 만들지 않고, 실행이 끝난 block 의 weight 도 budget 안에서 유지.
+ * budget 을 넘으면 priority (TextEncoder < Decoder < UNet) 가 낮은 것부터, 같으면 오래 쓰지 않은 것부터 evict.
+ * Version 0: off (매번 생성, 실행이 끝난 block 은 바로 삭제)
+ * Version 1: on (RESIDENCY_BUDGET_MB, 0 이면 CL_DEVICE_GLOBAL_MEM_SIZE 의 절반)
+ */
+#define RESIDENCY_MODE 1
+#define RESIDENCY_BUDGET_MB 0
+
+/**
+ * Trace Mode
+ * Version 0: off
+ * Version 1: kernel event + host span trace (MEDIA_PATH/trace/<encode|sample|decode>.json)
+ */
+#define TRACE_MODE 0
+
+/**
+ * CPU Backend Mode (modules/cpu, OpenCL 대신 host 에서 nn layer 실행)
+ * Linear, Conv2D, GroupNorm, LayerNorm, CrossAttention, MultiHeadAttention, GEGLU, UpSample, AttnBlock
+ * Version 0: off
+ * Version 1: text encoder (big core 에서 실행, GPU 는 unet)
+ * Version 2: text encoder + unet + decoder (OpenCL driver 문제 시 fallback)
+ */
+#define CPU_BACKEND_MODE 0
+
+/**
+ * Accuracy Gate (AccuracyGate, golden tensor 비교) tolerance
+ * pass : |result - golden| <= ACCURACY_ATOL + ACCURACY_RTOL * |golden|
+ * fp32 기준 max diff 는 대부분 1e-4 이하 (output_block_5 : 0.00043)
+ */
+#define ACCURACY_ATOL 1e-3f
+#define ACCURACY_RTOL 1e-3f
+
 #endif //MY_OPENCL_SETTING_H
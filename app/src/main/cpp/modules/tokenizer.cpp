@@ -3,24 +3,70 @@
 //
 
 #include "tokenizer.h"
+#include <algorithm>
+#include <codecvt>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
+#include <locale>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define LOG_TAG "TOKENIZER"
 
 #define MEDIA_PATH(filename) "/sdcard/Android/media/com.example.myopencl/" #filename
 
+/* pre-token 종류가 이보다 많아지면 cache 를 비움 */
+#define BPE_CACHE_SIZE 16384
+
+/* Table 이나 Merge 가 바뀌면 version 을 올림 (이전 binary 는 다시 compile) */
+#define BINARY_MAGIC "BPE\0"
+#define BINARY_VERSION 1
+
+static const char *SOT_TEXT = "<start_of_text>";
+static const char *EOT_TEXT = "<end_of_text>";
+
 SimpleTokenizer::SimpleTokenizer() {
-    pat = std::regex(
-            R"(<start_of_text>|<end_of_text>|'s|'t|'re|'ve|'m|'ll|'d|[\w]+|[\d]|[^\s\w\d]+)",
-            std::regex::icase);
-    // below is the original for wstring.
-    // pat = std::wregex(L"<start_of_text>|<end_of_text>|'s|'t|'re|'ve|'m|'ll|'d|[\\p{L}]+|[\\p{N}]|[^\\s\\p{L}\\p{N}]+", std::wregex::icase);
-    cache.insert(std::make_pair("<start_of_text>", "<start_of_text>"));
-    cache.insert(std::make_pair("<end_of_text>", "<end_of_text>"));
+    if (map(MEDIA_PATH(bpe_simple_vocab_16e6.bin))) {
+        return;
+    }
+    if (!parse(MEDIA_PATH(bpe_simple_vocab_16e6.txt))) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "Failed to open the %s", MEDIA_PATH(bpe_simple_vocab_16e6.txt));
+        throw std::runtime_error("Failed to open the file.");
+    }
+    save(MEDIA_PATH(bpe_simple_vocab_16e6.bin));
+}
+
+SimpleTokenizer::~SimpleTokenizer() {
+    if (mapped != nullptr) {
+        munmap(mapped, mappedSize);
+    }
+}
+
+void SimpleTokenizer::clearCache() {
+    cache.clear();
+}
+
+bool SimpleTokenizer::parse(const char *vocabPath) {
+    // read vocab file
+    std::ifstream file(vocabPath);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    memset(&table, 0, sizeof(table));
+    memcpy(table.magic, BINARY_MAGIC, sizeof(table.magic));
+    table.version = BINARY_VERSION;
 
     auto byteToUnicode = bytes_to_unicode();
-    for (auto pair: byteToUnicode) {
-        byte_encoder.insert(pair);
+    for (auto &pair: byteToUnicode) {
+        strncpy(table.byteEncoder[pair.first], pair.second.c_str(),
+                sizeof(table.byteEncoder[0]) - 1);
     }
 
     std::vector<std::string> vocab;
@@ -31,14 +77,7 @@ SimpleTokenizer::SimpleTokenizer() {
         vocab.push_back(pair.second + "</w>");
     }
 
-    // read vocab file
-    std::ifstream file(MEDIA_PATH(bpe_simple_vocab_16e6.txt));
-    if (!file.is_open()) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                            "Failed to open the %s", MEDIA_PATH(bpe_simple_vocab_16e6.txt));
-        throw std::runtime_error("Failed to open the file.");
-    }
-
+    std::vector<std::pair<std::string, std::string>> pairs;
     std::string line;
     int i = 0;
     while (std::getline(file, line)) {
@@ -50,148 +89,312 @@ SimpleTokenizer::SimpleTokenizer() {
             break;
         }
 
-        std::istringstream ss2(line);
-        std::string first;
-        std::string second;
-        std::getline(ss2, first, ' ');
-        std::getline(ss2, second, ' ');
+        auto space = line.find(' ');
+        auto first = line.substr(0, space);
+        auto second = space == std::string::npos ? std::string() : line.substr(
+                space + 1, line.find(' ', space + 1) - space - 1);
 
         vocab.push_back(first + second);
-        bpe_ranks.insert(std::make_pair(std::make_pair(first, second), i - 1));
+        pairs.emplace_back(std::move(first), std::move(second));
         i++;
     }
     file.close();
 
-    vocab.emplace_back("<start_of_text>");
-    vocab.emplace_back("<end_of_text>");
+    vocab.emplace_back(SOT_TEXT);
+    vocab.emplace_back(EOT_TEXT);
 
+    /* 같은 문자열은 처음 id */
+    std::unordered_map<std::string, int> encoder;
+    encoder.reserve(vocab.size());
     for (i = 0; i < vocab.size(); i++) {
         encoder.insert(std::make_pair(vocab[i], i));
     }
-}
+    table.sotToken = encoder[SOT_TEXT];
+    table.eotToken = encoder[EOT_TEXT];
+
+    for (int c = 0; c < 256; c++) {
+        auto symbol = std::string(1, static_cast<char>(c));
+        auto it = encoder.find(symbol);
+        table.byteIds[c] = it != encoder.end() ? it->second : -1;
+        it = encoder.find(symbol + "</w>");
+        table.byteEndIds[c] = it != encoder.end() ? it->second : -1;
+    }
 
-SimpleTokenizer::~SimpleTokenizer() = default;
+    size_t capacity = 1;
+    while (capacity < 2 * pairs.size()) {
+        capacity <<= 1;
+    }
+    table.mergeCapacity = static_cast<uint32_t>(capacity);
+    ownedMerges.assign(capacity, Merge{EMPTY_KEY, 0, 0});
+    for (int rank = 0; rank < pairs.size(); rank++) {
+        auto left = encoder.find(pairs[rank].first);
+        auto right = encoder.find(pairs[rank].second);
+        auto merged = encoder.find(pairs[rank].first + pairs[rank].second);
+        if (left == encoder.end() || right == encoder.end() || merged == encoder.end()) {
+            continue;
+        }
+        insertMerge(ownedMerges, left->second, right->second, rank, merged->second);
+    }
+    merges = ownedMerges.data();
+    mergeMask = capacity - 1;
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "vocab(%ld) merges(%ld)", vocab.size(),
+                        pairs.size());
+    return true;
+}
 
-/*
- * @param text: only alphabet and dot/comma/etc characters with stripped.
- *              (expect basic_clean&whitespace_clean applied)
- */
-std::vector<int> SimpleTokenizer::encode(std::string text) {
-    std::vector<int> bpe_tokens;
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+bool SimpleTokenizer::map(const char *binaryPath) {
+    int fd = open(binaryPath, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Table)) {
+        close(fd);
+        return false;
+    }
+    auto size = static_cast<size_t>(st.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
 
-    // `text` to lower case.
-    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    auto header = static_cast<const Table *>(data);
+    if (memcmp(header->magic, BINARY_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != BINARY_VERSION || header->mergeCapacity == 0 ||
+        (header->mergeCapacity & (header->mergeCapacity - 1)) != 0 ||
+        size != sizeof(Table) + sizeof(Merge) * header->mergeCapacity) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "invalid binary vocab %s", binaryPath);
+        munmap(data, size);
+        return false;
+    }
 
-    std::smatch match;
-    while (std::regex_search(text, match, pat)) {
-        // Expect match.str() is UTF-8 encoding.
-        std::string token;
+    memcpy(&table, header, sizeof(Table));
+    merges = reinterpret_cast<const Merge *>(static_cast<const char *>(data) + sizeof(Table));
+    mergeMask = table.mergeCapacity - 1;
+    mapped = data;
+    mappedSize = size;
+    return true;
+}
 
-        // __android_log_print(ANDROID_LOG_DEBUG, "__TEST__", "match: %s", match.str().c_str());
+/* 임시 파일에 쓴 후 rename (다른 process 가 반쯤 쓴 파일을 mmap 하지 않도록) */
+bool SimpleTokenizer::save(const char *binaryPath) const {
+    auto temp = std::string(binaryPath) + ".tmp";
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to open %s", temp.c_str());
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&table), sizeof(Table));
+    file.write(reinterpret_cast<const char *>(merges), sizeof(Merge) * table.mergeCapacity);
+    file.close();
+    if (!file || rename(temp.c_str(), binaryPath) != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to write %s", binaryPath);
+        remove(temp.c_str());
+        return false;
+    }
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "compiled %s", binaryPath);
+    return true;
+}
 
-        // transform token to byte encoding.
-        for (unsigned char b: match.str()) {
-            token += byte_encoder[static_cast<int>(b)];
-        }
+static inline uint64_t mergeKey(int left, int right) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(left)) << 32) |
+           static_cast<uint32_t>(right);
+}
 
-        // collect bpe tokens.
-        std::string bpe_token = bpe(token);
-        std::istringstream ss(bpe_token);
-        std::string bpe_split;
+/* binary 에 저장되므로 ABI (size_t 크기) 와 무관하게 64 bit 로 */
+static inline uint64_t mergeHash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return key;
+}
 
-        while (std::getline(ss, bpe_split, ' ')) {
-            bpe_tokens.push_back(encoder[bpe_split]);
+void SimpleTokenizer::insertMerge(std::vector<Merge> &table, int left, int right, int rank,
+                                  int id) {
+    auto key = mergeKey(left, right);
+    uint64_t mask = table.size() - 1;
+    for (auto slot = mergeHash(key) & mask;; slot = (slot + 1) & mask) {
+        if (table[slot].key == key) {
+            /* 같은 pair 는 처음 rank */
+            return;
+        }
+        if (table[slot].key == EMPTY_KEY) {
+            table[slot] = Merge{key, rank, id};
+            return;
         }
-
-        text = match.suffix();
     }
-    return bpe_tokens;
 }
 
-std::string SimpleTokenizer::bpe(std::string token) {
-    if (cache.find(token) != cache.end()) {
-        return cache[token];
+const SimpleTokenizer::Merge *SimpleTokenizer::findMerge(int left, int right) const {
+    if (left < 0 || right < 0) {
+        return nullptr;
     }
-
-    std::vector<std::string> word;
-    for (int i = 0; i < token.size() - 1; i++) {
-        word.emplace_back(1, token[i]);
+    auto key = mergeKey(left, right);
+    for (uint64_t slot = mergeHash(key) & mergeMask;; slot = (slot + 1) & mergeMask) {
+        if (merges[slot].key == key) {
+            return &merges[slot];
+        }
+        if (merges[slot].key == EMPTY_KEY) {
+            return nullptr;
+        }
     }
-    auto tmp = std::string(1, token[token.size() - 1]) + "</w>";
-    word.push_back(tmp);
+}
 
-    // get pairs of adjacent characters.
-    std::vector<std::pair<std::string, std::string>> pairs = get_pairs(word);
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+/* std::regex 의 \w (C locale): ASCII alnum, '_' */
+static inline bool isWord(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '_';
+}
 
-    if (pairs.empty()) {
-        return token + "</w>";
+static inline bool startsWith(const std::string &text, size_t pos, const char *prefix) {
+    return text.compare(pos, std::char_traits<char>::length(prefix), prefix) == 0;
+}
+
+/*
+ * regex 의 alternation 순서대로 (leftmost-first).
+ * [\d] 는 [\w]+ 에 포함되므로 생략.
+ */
+bool SimpleTokenizer::nextToken(const std::string &text, size_t pos, size_t *start,
+                                size_t *end) {
+    static const char *specials[] = {"<start_of_text>", "<end_of_text>",
+                                     "'s", "'t", "'re", "'ve", "'m", "'ll", "'d"};
+    while (pos < text.size() && isSpace(text[pos])) {
+        pos++;
     }
+    if (pos >= text.size()) {
+        return false;
+    }
+    *start = pos;
 
-    while (true) {
-        auto bigram = *std::min_element(pairs.begin(), pairs.end(), [this](auto a, auto b) {
-            auto aValue = (bpe_ranks.find(a) != bpe_ranks.end()) ? bpe_ranks[a]
-                                                                 : std::numeric_limits<int>::max();
-            auto bValue = (bpe_ranks.find(b) != bpe_ranks.end()) ? bpe_ranks[b]
-                                                                 : std::numeric_limits<int>::max();
-            return aValue < bValue;
-        });
+    for (auto special: specials) {
+        if (startsWith(text, pos, special)) {
+            *end = pos + std::char_traits<char>::length(special);
+            return true;
+        }
+    }
 
-        if (bpe_ranks.find(bigram) == bpe_ranks.end()) {
-            break;
+    if (isWord(text[pos])) {
+        while (pos < text.size() && isWord(text[pos])) {
+            pos++;
         }
+    } else {
+        while (pos < text.size() && !isWord(text[pos]) && !isSpace(text[pos])) {
+            pos++;
+        }
+    }
+    *end = pos;
+    return true;
+}
 
-        std::vector<std::string> new_word;
-        for (int i = 0; i < word.size();) {
-            auto j = std::find(word.begin() + i, word.end(), bigram.first);
-            if (j != word.end()) {
-                for (auto w = word.begin() + i; w != j; w++) {
-                    new_word.push_back(*w);
-                }
-                i = j - word.begin();
-            } else {
-                for (auto w = word.begin() + i; w != word.end(); w++) {
-                    new_word.push_back(*w);
-                }
-                break;
-            }
+/*
+ * @param text: only alphabet and dot/comma/etc characters with stripped.
+ *              (expect basic_clean&whitespace_clean applied)
+ */
+std::vector<int> SimpleTokenizer::encode(std::string text) {
+    std::vector<int> bpe_tokens;
 
-            if (word[i] == bigram.first && i < word.size() - 1 && word[i + 1] == bigram.second) {
-                new_word.push_back(bigram.first + bigram.second);
-                i += 2;
-            } else {
-                new_word.push_back(word[i]);
-                i += 1;
-            }
+    // `text` to lower case. (ASCII only, same as ::tolower in "C" locale)
+    std::transform(text.begin(), text.end(), text.begin(), [](char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    });
+
+    size_t start, end = 0;
+    while (nextToken(text, end, &start, &end)) {
+        auto token = text.substr(start, end - start);
+        if (token == SOT_TEXT) {
+            bpe_tokens.push_back(table.sotToken);
+            continue;
+        }
+        if (token == EOT_TEXT) {
+            bpe_tokens.push_back(table.eotToken);
+            continue;
         }
 
-        word = new_word;
-        if (word.size() == 1) {
-            break;
-        } else {
-            pairs = get_pairs(word);
+        auto it = cache.find(token);
+        if (it == cache.end()) {
+            if (cache.size() >= BPE_CACHE_SIZE) {
+                cache.clear();
+            }
+            std::vector<int> ids;
+            bpe(token, &ids);
+            it = cache.emplace(token, std::move(ids)).first;
         }
+        bpe_tokens.insert(bpe_tokens.end(), it->second.begin(), it->second.end());
     }
+    return bpe_tokens;
+}
 
-    auto joined_word = std::accumulate(
-            word.begin(), word.end(), std::string(),
-            [](const std::string &a, const std::string &b) {
-                return a.empty() ? b : a + " " + b;
-            }
-    );
+/*
+ * symbol 은 byte encoding 한 문자열의 byte 하나씩 (마지막은 `</w>`), vocab 에 없는 symbol 은 -1 (id 0 으로 출력).
+ * heap 은 (rank, 위치) 순서라 같은 pair 는 왼쪽부터 merge.
+ */
+void SimpleTokenizer::bpe(const std::string &token, std::vector<int> *ids) {
+    std::string encoded;
+    for (unsigned char b: token) {
+        encoded += table.byteEncoder[b];
+    }
 
-    cache[token] = joined_word;
+    auto n = static_cast<int>(encoded.size());
+    std::vector<int> symbols(n), prev(n), next(n);
+    for (int i = 0; i < n; i++) {
+        auto c = static_cast<unsigned char>(encoded[i]);
+        symbols[i] = i == n - 1 ? table.byteEndIds[c] : table.byteIds[c];
+        prev[i] = i - 1;
+        next[i] = i + 1 < n ? i + 1 : -1;
+    }
 
-    return joined_word;
-}
+    struct Candidate {
+        int rank;
+        int left;
+        int leftId;
+        int rightId;
 
-std::vector<std::pair<std::string, std::string>>
-SimpleTokenizer::get_pairs(std::vector<std::string> word) {
-    std::vector<std::pair<std::string, std::string>> pairs;
-    for (int i = 1; i < word.size(); i++) {
-        pairs.emplace_back(word[i - 1], word[i]);
+        bool operator>(const Candidate &other) const {
+            return rank != other.rank ? rank > other.rank : left > other.left;
+        }
+    };
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> queue;
+    auto push = [&](int left) {
+        if (left < 0 || next[left] < 0) {
+            return;
+        }
+        auto merge = findMerge(symbols[left], symbols[next[left]]);
+        if (merge != nullptr) {
+            queue.push(Candidate{merge->rank, left, symbols[left], symbols[next[left]]});
+        }
+    };
+    for (int i = 0; i < n - 1; i++) {
+        push(i);
+    }
+
+    while (!queue.empty()) {
+        auto candidate = queue.top();
+        queue.pop();
+        auto left = candidate.left;
+        auto right = next[left];
+        if (symbols[left] != candidate.leftId || right < 0 ||
+            symbols[right] != candidate.rightId) {
+            continue;
+        }
+
+        symbols[left] = findMerge(candidate.leftId, candidate.rightId)->id;
+        symbols[right] = -1;
+        next[left] = next[right];
+        if (next[right] >= 0) {
+            prev[next[right]] = left;
+        }
+        push(prev[left]);
+        push(left);
+    }
+
+    for (int i = 0; i >= 0; i = next[i]) {
+        ids->push_back(symbols[i] >= 0 ? symbols[i] : 0);
     }
-    return pairs;
 }
 
 std::vector<std::pair<int, std::string>> SimpleTokenizer::bytes_to_unicode() {
@@ -237,15 +440,13 @@ std::vector<long> SimpleTokenizer::tokenize(const std::string &text) {
 
 std::vector<long> SimpleTokenizer::tokenize(const std::vector<std::string> &texts) {
     std::vector<long> result;
-    const auto sot_token = encoder["<start_of_text>"];
-    const auto eot_token = encoder["<end_of_text>"];
 
     for (auto &text: texts) {
         auto tokens = encode(text);
-        tokens.insert(tokens.begin(), sot_token);
-        tokens.push_back(eot_token);
+        tokens.insert(tokens.begin(), table.sotToken);
+        tokens.push_back(table.eotToken);
         if (tokens.size() > CONTEXT_LENGTH) {
-            tokens[CONTEXT_LENGTH - 1] = eot_token;
+            tokens[CONTEXT_LENGTH - 1] = table.eotToken;
         }
         tokens.resize(CONTEXT_LENGTH, 0);
 
@@ -7,45 +7,94 @@
 
 #include <android/log.h>
 
+#include <cstdint>
 #include <string>
 #include <vector>
-#include <regex>
 #include <unordered_map>
-#include <algorithm>
-#include <iostream>
-#include <sstream>
-#include <map>
-#include <limits>
-#include <numeric>
-#include <locale>
-#include <codecvt>
 
 #define CONTEXT_LENGTH 77
 
+/*
+ * CLIP BPE tokenizer.
+ * pre-tokenize 는 regex (<start_of_text>|<end_of_text>|'s|'t|'re|'ve|'m|'ll|'d|[\w]+|[\d]|[^\s\w\d]+) 를 손으로 구현.
+ * bpe 는 symbol 을 vocab id 로 두고 merge rank 를 flat hash ((left, right) -> rank, merged id) 에서 찾아
+ * priority queue 로 rank 가 낮은 pair 부터 merge. 결과는 이전 std::regex / std::map 구현과 같음.
+ *
+ * vocab 은 compile 한 binary (bpe_simple_vocab_16e6.bin: Table + merge hash) 를 mmap 해서 parsing 없이 사용.
+ * binary 가 없거나 형식이 다르면 text vocab 을 parsing 해서 binary 를 저장 (다음 생성부터 mmap).
+ */
 class SimpleTokenizer {
 public:
     SimpleTokenizer();
 
     ~SimpleTokenizer();
 
+    SimpleTokenizer(const SimpleTokenizer &) = delete;
+
+    SimpleTokenizer &operator=(const SimpleTokenizer &) = delete;
+
     // Checked! (2023/11/29)
     std::vector<long> tokenize(const std::vector<std::string> &texts);
 
     std::vector<long> tokenize(const std::string &text);
 
+    /* bpe cache 비움 (benchmark) */
+    void clearCache();
+
 private:
-    std::regex pat;
-    std::unordered_map<int, std::string> byte_encoder;
-    std::unordered_map<std::string, int> encoder;
-    std::map<std::pair<std::string, std::string>, int> bpe_ranks;
-    std::unordered_map<std::string, std::string> cache;
+    struct Merge {
+        /* (left id << 32) | right id, EMPTY_KEY 이면 빈 slot */
+        uint64_t key;
+        int32_t rank;
+        int32_t id;
+    };
+
+    /* binary 의 앞부분. 뒤에 Merge[mergeCapacity] */
+    struct Table {
+        char magic[4];
+        uint32_t version;
+        /* 2 의 거듭제곱 (open addressing, linear probing) */
+        uint32_t mergeCapacity;
+        int32_t sotToken;
+        int32_t eotToken;
+        /* 1 byte symbol 의 vocab id, `</w>` 가 붙은 것. vocab 에 없으면 -1 */
+        int32_t byteIds[256];
+        int32_t byteEndIds[256];
+        /* byte -> bytes_to_unicode 의 UTF-8 문자 (NUL 종료) */
+        char byteEncoder[256][4];
+    };
+
+    static const uint64_t EMPTY_KEY = ~0ull;
+
+    Table table;
+    /* mmap 한 binary 또는 ownedMerges */
+    const Merge *merges;
+    size_t mergeMask;
+    std::vector<Merge> ownedMerges;
+
+    void *mapped = nullptr;
+    size_t mappedSize = 0;
 
-    static std::vector<std::pair<std::string, std::string>>
-    get_pairs(std::vector<std::string> word);
+    /* pre-token -> vocab ids, 크기 제한 */
+    std::unordered_map<std::string, std::vector<int>> cache;
+
+    /* text vocab 을 parsing 해서 table, ownedMerges 를 채움 */
+    bool parse(const char *vocabPath);
+
+    bool map(const char *binaryPath);
+
+    bool save(const char *binaryPath) const;
 
     static std::vector<std::pair<int, std::string>> bytes_to_unicode();
 
-    std::string bpe(std::string token);
+    /* `pos` 부터 다음 pre-token 의 [start, end). 없으면 false */
+    static bool nextToken(const std::string &text, size_t pos, size_t *start, size_t *end);
+
+    const Merge *findMerge(int left, int right) const;
+
+    static void insertMerge(std::vector<Merge> &table, int left, int right, int rank, int id);
+
+    void bpe(const std::string &token, std::vector<int> *ids);
 
     std::vector<int> encode(std::string text);
 };
@@ -3,11 +3,14 @@
 //
 
 #include "util.h"
+#include "Tracer.h"
 
 #include <algorithm>
 #include <android/log.h>
+#include <cmath>
 #include <numeric>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
 
 #define LOG_TAG "UTIL"
@@ -58,7 +61,8 @@ util::permute3D(const std::vector<float> &vec, const int shape[3], const int dim
 cl_program util::create_and_build_program_with_source(cl_context context,
                                                       cl_device_id device,
                                                       AAssetManager *assetManager,
-                                                      const char *file_name) {
+                                                      const char *file_name,
+                                                      const char *options) {
     auto start = std::chrono::system_clock::now();
     AAsset *asset = AAssetManager_open(assetManager, file_name, AASSET_MODE_BUFFER);
     if (asset == nullptr) {
@@ -75,7 +79,7 @@ cl_program util::create_and_build_program_with_source(cl_context context,
             context, 1, (const char **) &buffer, &source_size, &err);
     CHECK_ERROR(err);
     AAsset_close(asset);
-    err = clBuildProgram(program, 1, &device, "", nullptr, nullptr);
+    err = clBuildProgram(program, 1, &device, options, nullptr, nullptr);
     if (err == CL_BUILD_PROGRAM_FAILURE) {
         size_t log_size;
         CHECK_ERROR(clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0,
@@ -89,8 +93,9 @@ cl_program util::create_and_build_program_with_source(cl_context context,
     }
     CHECK_ERROR(err);
     auto end = std::chrono::system_clock::now();
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "create_and_build_program_with_source(%s): %lld ms",
-                        file_name, std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "create_and_build_program_with_source(%s %s): %lld ms",
+                        file_name, options,
+                        static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()));
     return program;
 }
 
@@ -102,6 +107,7 @@ cnpy::NpyArray util::load_npy_file(const std::string &_filename) {
 
 cl_mem util::load_npy_file(const std::string &_filename, size_t *num_vals, cl_context context,
                            cl_command_queue cmdQueue) {
+    Tracer::HostSpan span("load_npy_file(" + _filename + ")");
     auto filename = MEDIA_PATH + _filename;
     cl_int errcode_ret;
 
@@ -146,6 +152,172 @@ cl_mem util::load_npy_file(const std::string &_filename, size_t *num_vals, cl_co
     return buffer;
 }
 
+cl_mem util::load_npy_files(const std::vector<std::string> &_filenames, size_t *num_vals,
+                            cl_context context, cl_command_queue cmdQueue) {
+    Tracer::HostSpan span("load_npy_files(" + _filenames.front() + ")");
+    cl_int errcode_ret;
+
+    std::vector<FILE *> files;
+    std::vector<size_t> bytes;
+    size_t total = 0;
+    size_t word_size = 0;
+    for (auto &_filename: _filenames) {
+        auto filename = MEDIA_PATH + _filename;
+        FILE *fp = fopen(filename.c_str(), "rb");
+        if (!fp) {
+            for (auto f: files) fclose(f);
+            throw std::runtime_error("npy_load: Unable to open file " + filename);
+        }
+        files.push_back(fp);
+
+        std::vector<size_t> shape;
+        size_t size;
+        bool fortran_order;
+        cnpy::parse_npy_header(fp, size, shape, fortran_order);
+        if (word_size != 0 && size != word_size) {
+            for (auto f: files) fclose(f);
+            throw std::runtime_error("npy_load: word size mismatch " + filename);
+        }
+        word_size = size;
+
+        size_t count = 1;
+        for (auto dim: shape) count *= dim;
+        bytes.push_back(count * word_size);
+        total += count;
+    }
+    if (num_vals != nullptr) {
+        *num_vals = total;
+    }
+
+    auto buffer = clCreateBuffer(context, CL_MEM_ALLOC_HOST_PTR, total * word_size, nullptr,
+                                 &errcode_ret);
+    CHECK_ERROR(errcode_ret)
+
+    auto data = static_cast<char *>(clEnqueueMapBuffer(cmdQueue, buffer, CL_TRUE, CL_MAP_WRITE,
+                                                       0, total * word_size, 0, nullptr,
+                                                       nullptr, &errcode_ret));
+    CHECK_ERROR(errcode_ret)
+
+    size_t offset = 0;
+    bool complete = true;
+    for (size_t i = 0; i < files.size(); i++) {
+        complete &= fread(data + offset, 1, bytes[i], files[i]) == bytes[i];
+        offset += bytes[i];
+        fclose(files[i]);
+    }
+    clEnqueueUnmapMemObject(cmdQueue, buffer, data, 0, nullptr, nullptr);
+    if (!complete) {
+        clReleaseMemObject(buffer);
+        throw std::runtime_error("nread != num_bytes");
+    }
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "load_npy_files[cl_mem]: %s (+%ld)",
+                        _filenames.front().c_str(), _filenames.size() - 1);
+    return buffer;
+}
+
+cl_mem util::load_npy_file_half(const std::string &_filename, size_t *num_vals,
+                                cl_context context, cl_command_queue cmdQueue) {
+    Tracer::HostSpan span("load_npy_file_half(" + _filename + ")");
+    auto filename = MEDIA_PATH + _filename;
+    cl_int errcode_ret;
+
+    FILE *fp = fopen(filename.c_str(), "rb");
+
+    if (!fp) throw std::runtime_error("npy_load: Unable to open file " + filename);
+
+    std::vector<size_t> shape;
+    size_t word_size;
+    bool fortran_order;
+    cnpy::parse_npy_header(fp, word_size, shape, fortran_order);
+    if (word_size != 2 && word_size != 4) {
+        fclose(fp);
+        throw std::runtime_error("npy_load: word size must be 2 or 4 " + filename);
+    }
+
+    size_t tmp;
+    auto _num_vals = num_vals ?: &tmp;
+    *_num_vals = 1;
+    for (size_t i = 0; i < shape.size(); i++) *_num_vals *= shape[i];
+
+    auto num_bytes = *_num_vals * sizeof(uint16_t);
+    auto buffer = clCreateBuffer(context, CL_MEM_ALLOC_HOST_PTR, num_bytes, nullptr,
+                                 &errcode_ret);
+    CHECK_ERROR(errcode_ret)
+
+    auto data = static_cast<uint16_t *>(clEnqueueMapBuffer(cmdQueue, buffer, CL_TRUE,
+                                                           CL_MAP_WRITE, 0, num_bytes, 0,
+                                                           nullptr, nullptr, &errcode_ret));
+    CHECK_ERROR(errcode_ret)
+
+    size_t nread;
+    if (word_size == 2) {
+        nread = fread(data, 2, *_num_vals, fp);
+    } else {
+        std::vector<float> chunk(1 << 16);
+        nread = 0;
+        while (nread < *_num_vals) {
+            auto count = fread(chunk.data(), 4, std::min(chunk.size(), *_num_vals - nread), fp);
+            if (count == 0) {
+                break;
+            }
+            for (size_t i = 0; i < count; i++) {
+                data[nread + i] = float_to_half(chunk[i]);
+            }
+            nread += count;
+        }
+    }
+    clEnqueueUnmapMemObject(cmdQueue, buffer, data, 0, nullptr, nullptr);
+    fclose(fp);
+    if (nread != *_num_vals) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "nread(%ld) != num_vals(%ld)", nread,
+                            *_num_vals);
+        clReleaseMemObject(buffer);
+        throw std::runtime_error("nread != num_vals");
+    }
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "load_npy_file_half[cl_mem]: %s",
+                        _filename.c_str());
+    return buffer;
+}
+
+uint16_t util::float_to_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t exponent = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (exponent == 0xff) {
+        /* inf, nan */
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    }
+    int e = static_cast<int>(exponent) - 127 + 15;
+    if (e >= 0x1f) {
+        return sign | 0x7c00;
+    }
+    if (e <= 0) {
+        /* subnormal (또는 0) */
+        if (e < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        auto shift = static_cast<uint32_t>(14 - e);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) {
+            half++;
+        }
+        return sign | half;
+    }
+    uint32_t half = (static_cast<uint32_t>(e) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+        /* mantissa 가 넘치면 exponent 로 올라감 (최대면 inf) */
+        half++;
+    }
+    return sign | half;
+}
+
 void util::testBuffer(
         cl_command_queue cmdQueue, cl_mem buffer, const char *filename
 ) {
@@ -200,7 +372,76 @@ void util::testBuffer(std::vector<float> result, const char *filename) {
     }
 }
 
+util::Accuracy
+util::compareBuffer(cl_command_queue cmdQueue, cl_mem buffer, const std::string &filename,
+                    float atol, float rtol) {
+    cl_int err;
+
+    size_t bufferBytes;
+    err = clGetMemObjectInfo(buffer, CL_MEM_SIZE, sizeof(size_t), &bufferBytes, nullptr);
+    CHECK_ERROR(err);
+
+    std::vector<float> result(bufferBytes / sizeof(float));
+    err = clEnqueueReadBuffer(cmdQueue, buffer, CL_TRUE, 0,
+                              sizeof(float) * result.size(),
+                              result.data(), 0, nullptr, nullptr);
+    CHECK_ERROR(err);
+
+    auto golden = util::load_npy_file(filename);
+    if (result.size() != golden.num_vals) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "%s: bufferSize(%ld) != golden.num_vals(%ld)",
+                            filename.c_str(), result.size(), golden.num_vals);
+        return {result.size(), result.size(), INFINITY, INFINITY, 0, false};
+    }
+
+    auto accuracy = util::compare(result, golden.data<float>(), golden.num_vals, atol, rtol);
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG,
+                        "%s max abs diff: %.20f / max rel diff: %.8f / psnr: %.3f / mismatches: %ld / %s",
+                        filename.c_str(), accuracy.maxAbsDiff, accuracy.maxRelDiff, accuracy.psnr,
+                        accuracy.mismatches, accuracy.passed ? "PASS" : "FAIL");
+    return accuracy;
+}
+
+util::Accuracy util::compare(const std::vector<float> &result, const float *golden, size_t size,
+                             float atol, float rtol) {
+    Accuracy accuracy{size, 0, 0, 0, 0, false};
+
+    double squaredError = 0;
+    float peak = 0;
+    for (size_t i = 0; i < size; i++) {
+        auto diff = std::abs(result[i] - golden[i]);
+        auto magnitude = std::abs(golden[i]);
+        /* NaN 도 mismatch */
+        if (!(diff <= atol + rtol * magnitude)) {
+            accuracy.mismatches++;
+        }
+        if (std::isnan(diff)) {
+            accuracy.maxAbsDiff = NAN;
+            continue;
+        }
+        accuracy.maxAbsDiff = std::max(accuracy.maxAbsDiff, diff);
+        if (magnitude > 0) {
+            accuracy.maxRelDiff = std::max(accuracy.maxRelDiff, diff / magnitude);
+        }
+        squaredError += static_cast<double>(diff) * diff;
+        peak = std::max(peak, magnitude);
+    }
+
+    auto mse = size > 0 ? squaredError / size : 0;
+    accuracy.psnr = mse > 0 ? 10 * std::log10(static_cast<double>(peak) * peak / mse) : INFINITY;
+    accuracy.passed = accuracy.mismatches == 0;
+    return accuracy;
+}
+
 void util::printEventTime(std::string message, cl_event event) {
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "%s, %0.3f\n",
+                        message.c_str(), getEventTime(event));
+}
+
+/*
+ * @return: kernel execution time of `event` in ms
+ */
+double util::getEventTime(cl_event event) {
     cl_ulong time_start;
     cl_ulong time_end;
     cl_int err;
@@ -210,8 +451,7 @@ void util::printEventTime(std::string message, cl_event event) {
     CHECK_ERROR(err);
 
     double nanoSeconds = time_end-time_start;
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "%s, %0.3f\n",
-                        message.c_str(), nanoSeconds / 1000000.0);
+    return nanoSeconds / 1000000.0;
 }
 
 cl_mem util::clCreateBuffer(const std::vector<float> &data, cl_context context, cl_command_queue cmdQueue, cl_int *err) {
@@ -15,23 +15,54 @@
 #include "cnpy.h"
 
 namespace util {
+    /* golden tensor 비교 결과. pass : 모든 원소가 |result - golden| <= atol + rtol * |golden| */
+    struct Accuracy {
+        size_t size;
+        size_t mismatches;
+        float maxAbsDiff;
+        float maxRelDiff;
+        /* 10 * log10(max|golden|^2 / mse), 완전히 같으면 inf */
+        double psnr;
+        bool passed;
+    };
+
     std::vector<float> *
     permute3D(const std::vector<float> &vec, const int shape[3], const int dimensions[3]);
 
     cl_program create_and_build_program_with_source(cl_context context, cl_device_id device,
                                                     AAssetManager *assetManager,
-                                                    const char *file_name);
+                                                    const char *file_name,
+                                                    const char *options = "");
 
     cnpy::NpyArray load_npy_file(const std::string &filename);
 
     cl_mem load_npy_file(const std::string &filename, size_t* num_val, cl_context context, cl_command_queue cmdQueue);
 
+    /* 여러 npy 를 순서대로 이어 붙여서 하나의 buffer 로 (e.g. to_q, to_k, to_v weight -> qkv) */
+    cl_mem load_npy_files(const std::vector<std::string> &filenames, size_t *num_val,
+                          cl_context context, cl_command_queue cmdQueue);
+
+    /* fp16 buffer 로 load. fp16 npy 는 그대로, fp32 npy 는 chunk 단위로 변환 (host 에 전체 사본 없음) */
+    cl_mem load_npy_file_half(const std::string &filename, size_t *num_val, cl_context context,
+                              cl_command_queue cmdQueue);
+
+    /* IEEE 754 half (round to nearest even) */
+    uint16_t float_to_half(float value);
+
     cl_mem clCreateBuffer(const std::vector<float> &data, cl_context context, cl_command_queue cmdQueue, cl_int *err);
 
     void testBuffer(cl_command_queue cmdQueue, cl_mem buffer, const char *filename);
 
     void testBuffer(std::vector<float> result, const char *filename);
 
+    Accuracy compareBuffer(cl_command_queue cmdQueue, cl_mem buffer, const std::string &filename,
+                           float atol, float rtol);
+
+    Accuracy compare(const std::vector<float> &result, const float *golden, size_t size,
+                     float atol, float rtol);
+
     void printEventTime(std::string tag, cl_event event);
+
+    double getEventTime(cl_event event);
 }
 #endif //MY_OPENCL_UTIL_H
@@ -1,5 +1,6 @@
 #include <jni.h>
 #include <string>
+#include <stdexcept>
 #include <android/log.h>
 #include "modules/tokenizer.h"
 #include "modules/TextEncoder.h"
@@ -7,7 +8,20 @@
 #include "modules/UNetModel.h"
 #include "modules/Decoder.h"
 #include "modules/util.h"
+#include "modules/LinearTuner.h"
+#include "modules/KernelSelector.h"
+#include "modules/KernelBenchmark.h"
+#include "modules/TokenizerBenchmark.h"
+#include "modules/AccuracyGate.h"
+#include "modules/Pipeline.h"
+#include "modules/EmbeddingCache.h"
+#include "modules/ResidencyManager.h"
+#include "modules/Tracer.h"
+#include "modules/ProgramCache.h"
+#include "modules/cpu/CpuBackend.h"
+#include "modules/setting.h"
 #include <chrono>
+#include <mutex>
 #include <android/thermal.h>
 
 #define CL_TARGET_OPENCL_VERSION 200
@@ -27,6 +41,9 @@ cl_command_queue cmdQueue;
 cl_device_id deviceId;
 
 DDIMSampler *sampler;
+/* session 동안 유지 (vocab 은 mmap, bpe cache 공유) */
+SimpleTokenizer *tokenizer = nullptr;
+Pipeline *pipeline = nullptr;
 AAssetManager *assetManager;
 AThermalManager* thermalManager;
 
@@ -54,6 +71,10 @@ Java_com_example_myopencl_MainActivity_initOpenCL(
 
     thermalManager = AThermal_acquireManager();
 
+    LinearTuner::getInstance().init(deviceId, LINEAR_TUNE_MODE);
+    KernelSelector::getInstance().init();
+    Tracer::getInstance().init(cmdQueue, TRACE_MODE);
+
     // auto clazz = env->FindClass("com/example/myopencl/MainActivity");
     // auto methodId = env->GetMethodID(clazz, "unet", "([FJ[F)[F");
 
@@ -119,6 +140,11 @@ Java_com_example_myopencl_MainActivity_initOpenCL(
     CHECK_ERROR(err);
     __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "CL_DEVICE_GLOBAL_MEM_SIZE(5.6GB): %ld",
                         globalMemSize);
+#if RESIDENCY_MODE == 1
+    size_t budget = RESIDENCY_BUDGET_MB > 0 ? static_cast<size_t>(RESIDENCY_BUDGET_MB) << 20
+                                            : globalMemSize / 2;
+    ResidencyManager::getInstance().init(budget);
+#endif
 
     cl_device_fp_config fpConfig;
     err = clGetDeviceInfo(deviceId, CL_DEVICE_SINGLE_FP_CONFIG, sizeof(cl_device_fp_config),
@@ -178,9 +204,11 @@ Java_com_example_myopencl_MainActivity_initOpenCL(
 extern "C"
 JNIEXPORT jlongArray JNICALL
 Java_com_example_myopencl_MainActivity_tokenize(JNIEnv *env, jobject thiz, jstring _text) {
-    auto tokenizer = SimpleTokenizer();
+    if (tokenizer == nullptr) {
+        tokenizer = new SimpleTokenizer();
+    }
     const char *text = env->GetStringUTFChars(_text, nullptr);
-    auto result = tokenizer.tokenize(text);
+    auto result = tokenizer->tokenize(text);
     for (const auto i: result) {
         //__android_log_print(ANDROID_LOG_DEBUG, "__TEST__", "encode: %ld", i);
     }
@@ -195,22 +223,38 @@ Java_com_example_myopencl_MainActivity_tokenize(JNIEnv *env, jobject thiz, jstri
 extern "C"
 JNIEXPORT jfloatArray JNICALL
 Java_com_example_myopencl_MainActivity_encode(JNIEnv *env, jobject thiz, jlongArray _token) {
-    auto start = std::chrono::high_resolution_clock::now();
-    auto encoder = TextEncoder(assetManager, context, cmdQueue, deviceId);
-    auto stop = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "text encoder init time: %lld ms",
-                        duration.count());
-
     long *longArray = env->GetLongArrayElements(_token, nullptr);
     auto token = std::vector<long>(longArray, longArray + env->GetArrayLength(_token));
-
-    start = std::chrono::high_resolution_clock::now();
-    auto encodedToken = encoder.encode(token);
-    stop = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
-    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "text encoder exec time: %lld ms",
-                        duration.count());
+    env->ReleaseLongArrayElements(_token, longArray, JNI_ABORT);
+
+    std::vector<float> encodedToken;
+    auto &cache = EmbeddingCache::getInstance();
+    if (cache.get(token, &encodedToken)) {
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "embedding cache hit: %s",
+                            cache.getStats().c_str());
+    } else {
+        auto start = std::chrono::high_resolution_clock::now();
+        Tracer::HostSpan setupSpan("text_encoder/setup");
+        auto encoder = ResidencyManager::getInstance().acquire<TextEncoder>(
+                "text_encoder", TextEncoder::weightBytes(), ResidencyManager::LOW, [] {
+                    return std::make_shared<TextEncoder>(assetManager, context, cmdQueue,
+                                                         deviceId);
+                });
+        setupSpan.end();
+        auto stop = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "text encoder init time: %lld ms",
+                            static_cast<long long>(duration.count()));
+
+        start = std::chrono::high_resolution_clock::now();
+        encodedToken = encoder->encode(token);
+        stop = std::chrono::high_resolution_clock::now();
+        duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "text encoder exec time: %lld ms",
+                            static_cast<long long>(duration.count()));
+        Tracer::getInstance().save("encode");
+        cache.put(token, encodedToken);
+    }
 
     jfloatArray result = env->NewFloatArray(static_cast<int>(encodedToken.size()));
     env->SetFloatArrayRegion(result, 0, static_cast<int>(encodedToken.size()), encodedToken.data());
@@ -229,7 +273,13 @@ Java_com_example_myopencl_MainActivity_sample(JNIEnv *env, jobject thiz, jfloatA
 //    auto result = sampler->sample(&x_vec, 50, shape, condition);
 
     auto start_init = std::chrono::high_resolution_clock::now();
-    auto unet = UNetModel(assetManager, context, cmdQueue, deviceId);
+    Tracer::HostSpan setupSpan("unet/setup");
+    /* weight 는 graph 의 block 단위로 등록 (model 은 0 bytes) */
+    auto unet = ResidencyManager::getInstance().acquire<UNetModel>(
+            "unet", 0, ResidencyManager::HIGH, [] {
+                return std::make_shared<UNetModel>(assetManager, context, cmdQueue, deviceId);
+            });
+    setupSpan.end();
     auto stop_init = std::chrono::high_resolution_clock::now();
     auto duration_init = std::chrono::duration_cast<std::chrono::milliseconds>(stop_init - start_init);
     __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "u-net init time: %lld ms", duration_init.count());
@@ -237,11 +287,12 @@ Java_com_example_myopencl_MainActivity_sample(JNIEnv *env, jobject thiz, jfloatA
     auto x = util::load_npy_file("sampler/test/test_seed_45_img.npy").as_vec<float>();
     auto c = util::load_npy_file("encoder/test/ln_final_test_fp32.npy").as_vec<float>();
     auto start = std::chrono::high_resolution_clock::now();
-    auto result = unet.forward(x, 981, c);
+    auto result = unet->forward(x, 981, c);
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
     AThermalStatus thermalStatus = AThermal_getCurrentThermalStatus(thermalManager);
     __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "thermal(%d) u-net exec time: %lld ms", thermalStatus, duration.count());
+    Tracer::getInstance().save("sample");
 
 //    auto result = util::load_npy_file("sampler/test/test_seed_45_img.npy").as_vec<float>();
 //    unet.test(result, 981, c);
@@ -255,14 +306,22 @@ Java_com_example_myopencl_MainActivity_sample(JNIEnv *env, jobject thiz, jfloatA
 extern "C"
 JNIEXPORT jfloatArray JNICALL
 Java_com_example_myopencl_MainActivity_decode(JNIEnv *env, jobject thiz) {
-    auto decoder = Decoder(context, cmdQueue, deviceId, assetManager);
+    Tracer::HostSpan setupSpan("decoder/setup");
+    auto decoder = ResidencyManager::getInstance().acquire<Decoder>(
+            "decoder", 0, ResidencyManager::NORMAL, [] {
+                return std::make_shared<Decoder>(context, cmdQueue, deviceId, assetManager);
+            });
+    setupSpan.end();
 
     auto x = util::load_npy_file("decoder/test/test_seed_45_step_50_sample.npy").as_vec<float>();
     auto start = std::chrono::high_resolution_clock::now();
-    auto result = decoder.decode(x);
+    auto result = decoder->decode(x);
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
     __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "decoder exec time: %lld ms", duration.count());
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "residency: %s",
+                        ResidencyManager::getInstance().getStats().c_str());
+    Tracer::getInstance().save("decode");
 
 //    auto result = util::load_npy_file("decoder/test/test_mid_block_1.npy").as_vec<float>();
 //    decoder.test(result);
@@ -272,12 +331,232 @@ Java_com_example_myopencl_MainActivity_decode(JNIEnv *env, jobject thiz) {
     return resultArray;
 }
 
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_example_myopencl_MainActivity_benchmark(JNIEnv *env, jobject thiz) {
+    auto benchmark = KernelBenchmark(context, cmdQueue, deviceId, assetManager);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto result = benchmark.run();
+    auto stop = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "kernel benchmark time: %lld ms",
+                        static_cast<long long>(duration.count()));
+
+    return env->NewStringUTF(result.c_str());
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_example_myopencl_MainActivity_tokenizerBenchmark(JNIEnv *env, jobject thiz) {
+    auto benchmark = TokenizerBenchmark();
+    auto result = benchmark.run();
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "tokenizer benchmark: %s", result.c_str());
+    return env->NewStringUTF(result.c_str());
+}
+
+/*
+ * @useCpu: CL_DEVICE_TYPE_CPU device 가 있으면 별도 context 에서 실행, 없으면 GPU
+ */
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_example_myopencl_MainActivity_accuracyGate(JNIEnv *env, jobject thiz, jboolean useCpu) {
+    cl_int err;
+    cl_device_id gateDeviceId = deviceId;
+    cl_context gateContext = context;
+    cl_command_queue gateCmdQueue = cmdQueue;
+    bool cpuBackend = false;
+
+    if (useCpu) {
+        cl_uint numPlatforms = 0;
+        clGetPlatformIDs(0, nullptr, &numPlatforms);
+        std::vector<cl_platform_id> platformIds(numPlatforms);
+        clGetPlatformIDs(numPlatforms, platformIds.data(), nullptr);
+
+        cl_device_id cpuDeviceId = nullptr;
+        for (auto platformId: platformIds) {
+            if (clGetDeviceIDs(platformId, CL_DEVICE_TYPE_CPU, 1, &cpuDeviceId, nullptr) == CL_SUCCESS) {
+                break;
+            }
+            cpuDeviceId = nullptr;
+        }
+
+        if (cpuDeviceId != nullptr) {
+            gateDeviceId = cpuDeviceId;
+            gateContext = clCreateContext(nullptr, 1, &gateDeviceId, nullptr, nullptr, &err);
+            CHECK_ERROR(err);
+
+            cl_queue_properties properties[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE,
+                                                0};
+            gateCmdQueue = clCreateCommandQueueWithProperties(gateContext, gateDeviceId, properties, &err);
+            CHECK_ERROR(err);
+        } else {
+            /* OpenCL CPU device 가 없으면 CPU backend 를 reference 로 */
+            __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "accuracy gate: no cpu device, use cpu backend");
+            cpuBackend = true;
+        }
+    }
+
+    std::string result;
+    {
+        CpuBackend::Scope cpuScope(cpuBackend);
+        auto gate = AccuracyGate(gateContext, gateCmdQueue, gateDeviceId, assetManager,
+                                 ACCURACY_ATOL, ACCURACY_RTOL);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        result = gate.run();
+        auto stop = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "accuracy gate time: %lld ms",
+                            static_cast<long long>(duration.count()));
+    }
+
+    if (gateContext != context) {
+        clReleaseCommandQueue(gateCmdQueue);
+        ProgramCache::getInstance().release(gateContext);
+        clReleaseContext(gateContext);
+    }
+
+    return env->NewStringUTF(result.c_str());
+}
+
+/* 마지막 latent preview 와 그 크기 (pipelinePreview 에서 꺼냄) */
+std::vector<float> pipelinePreviewImage;
+size_t pipelinePreviewHeight = 0;
+size_t pipelinePreviewWidth = 0;
+std::mutex pipelinePreviewMutex;
+
+/*
+ * @capacity: stage 사이 queue 크기
+ * @previewInterval: denoise 중 preview step 간격 (0 이면 preview 없음)
+ */
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_myopencl_MainActivity_pipelineStart(JNIEnv *env, jobject thiz, jint capacity,
+                                                     jint previewInterval) {
+    delete pipeline;
+    pipeline = new Pipeline(context, deviceId, assetManager, capacity);
+    pipeline->setProgress(previewInterval, [](size_t id, int step, int steps,
+                                              const std::vector<float> &image, size_t height,
+                                              size_t width) {
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "pipeline(%ld) step %d / %d", id, step,
+                            steps);
+        std::lock_guard<std::mutex> lock(pipelinePreviewMutex);
+        pipelinePreviewImage = image;
+        pipelinePreviewHeight = height;
+        pipelinePreviewWidth = width;
+        return true;
+    });
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_myopencl_MainActivity_pipelineSubmit(JNIEnv *env, jobject thiz, jstring _prompt,
+                                                      jint steps, jlong seed, jint height,
+                                                      jint width) {
+    const char *chars = env->GetStringUTFChars(_prompt, nullptr);
+    std::string prompt(chars);
+    env->ReleaseStringUTFChars(_prompt, chars);
+    /* C++ exception 이 JNI 경계를 넘으면 process 가 abort 되므로 Java exception 으로 */
+    try {
+        auto id = pipeline->submit(prompt, steps, static_cast<unsigned int>(seed),
+                                   static_cast<size_t>(height), static_cast<size_t>(width));
+        return static_cast<jlong>(id);
+    } catch (const std::invalid_argument &e) {
+        env->ThrowNew(env->FindClass("java/lang/IllegalArgumentException"), e.what());
+    } catch (const std::runtime_error &e) {
+        env->ThrowNew(env->FindClass("java/lang/IllegalStateException"), e.what());
+    }
+    return -1;
+}
+
+/*
+ * @return: submit 순서대로 [height, width, image (3, height, width)...], 실패한 요청은 empty,
+ *          pipelineStop 후 모두 꺼내면 null
+ */
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_myopencl_MainActivity_pipelineTake(JNIEnv *env, jobject thiz) {
+    Pipeline::Result result;
+    if (!pipeline->take(&result)) {
+        return nullptr;
+    }
+    if (!result.error.empty()) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "pipeline(%ld) failed: %s", result.id,
+                            result.error.c_str());
+    }
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "pipeline(%ld) latency: %.0f ms", result.id,
+                        result.latency);
+
+    if (result.image.empty()) {
+        return env->NewFloatArray(0);
+    }
+    float size[2] = {static_cast<float>(result.height), static_cast<float>(result.width)};
+    jfloatArray resultArray = env->NewFloatArray(static_cast<jint>(2 + result.image.size()));
+    env->SetFloatArrayRegion(resultArray, 0, 2, size);
+    env->SetFloatArrayRegion(resultArray, 2, static_cast<jint>(result.image.size()),
+                             result.image.data());
+    return resultArray;
+}
+
+/*
+ * @return: 마지막 호출 이후 새 preview [height, width, image (3, height, width)...]
+ *          (latent 크기 = image / 8), 없으면 null
+ */
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_myopencl_MainActivity_pipelinePreview(JNIEnv *env, jobject thiz) {
+    std::vector<float> image;
+    float size[2];
+    {
+        std::lock_guard<std::mutex> lock(pipelinePreviewMutex);
+        image.swap(pipelinePreviewImage);
+        size[0] = static_cast<float>(pipelinePreviewHeight);
+        size[1] = static_cast<float>(pipelinePreviewWidth);
+    }
+    if (image.empty()) {
+        return nullptr;
+    }
+    jfloatArray resultArray = env->NewFloatArray(static_cast<jint>(2 + image.size()));
+    env->SetFloatArrayRegion(resultArray, 0, 2, size);
+    env->SetFloatArrayRegion(resultArray, 2, static_cast<jint>(image.size()), image.data());
+    return resultArray;
+}
+
+/*
+ * 요청 `id` 를 중단. 해당 image 는 take 에서 empty
+ */
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_myopencl_MainActivity_pipelineCancel(JNIEnv *env, jobject thiz, jlong id) {
+    pipeline->cancel(static_cast<size_t>(id));
+}
+
+/*
+ * 남은 요청을 끝까지 실행한 후 종료. 남은 image 는 계속 take 가능 (pipelineStart, destroyOpenCL 에서 해제)
+ * @return: stage 별 throughput (JSON)
+ */
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_example_myopencl_MainActivity_pipelineStop(JNIEnv *env, jobject thiz) {
+    pipeline->join();
+    auto stats = pipeline->getStats();
+    __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "pipeline: %s", stats.c_str());
+    return env->NewStringUTF(stats.c_str());
+}
+
 extern "C"
 JNIEXPORT void JNICALL
 Java_com_example_myopencl_MainActivity_destroyOpenCL(JNIEnv *env, jobject thiz) {
     delete sampler;
+    delete pipeline;
+    pipeline = nullptr;
+    delete tokenizer;
+    tokenizer = nullptr;
+    ResidencyManager::getInstance().clear();
 
     clReleaseCommandQueue(cmdQueue);
+    ProgramCache::getInstance().release(context);
     clReleaseContext(context);
 
     AThermal_releaseManager(thermalManager);
@@ -70,6 +70,72 @@ class MainActivity : AppCompatActivity() {
                      */
                     val result = sample(FloatArray(77 * 1024))
                 }
+                takeIf { false }?.run {
+                    /**
+                     * benchmark() block
+                     * result : MEDIA_PATH/benchmark/kernel_benchmark.json
+                     */
+                    val result = benchmark()
+                    Log.d("__TEST__", result)
+                }
+                takeIf { false }?.run {
+                    /**
+                     * tokenizerBenchmark() block
+                     * result : MEDIA_PATH/benchmark/tokenizer_benchmark.json
+                     */
+                    val result = tokenizerBenchmark()
+                    Log.d("__TEST__", result)
+                }
+                takeIf { false }?.run {
+                    /**
+                     * accuracyGate() block
+                     * result : MEDIA_PATH/accuracy/accuracy_gate.json
+                     */
+                    val result = accuracyGate(true)
+                    Log.d("__TEST__", result)
+                }
+                takeIf { false }?.run {
+                    /**
+                     * pipeline block (encode -> denoise -> decode, stage 별 worker)
+                     * result : images per minute, stage 별 busy / idle / blocked time
+                     */
+                    val prompts = listOf(
+                        "a professional photograph of an astronaut riding a horse",
+                        "a photograph of a cat sitting on a sofa",
+                        "an oil painting of a lighthouse at sunset",
+                    )
+                    pipelineStart(2, 10)
+                    val consumer = thread(start = true) {
+                        while (true) {
+                            /* [height, width, image...], 실패한 요청은 empty */
+                            val result = pipelineTake() ?: break
+                            if (result.isNotEmpty()) {
+                                val height = result[0].toInt()
+                                val width = result[1].toInt()
+                                val image = result.copyOfRange(2, result.size)
+                                runOnUiThread { drawImage(image, height, width) }
+                            }
+                        }
+                    }
+                    /* denoise 중간 결과 (latent preview, [height, width, image...], image 크기 / 8) */
+                    val previewer = thread(start = true) {
+                        while (consumer.isAlive) {
+                            pipelinePreview()?.let { result ->
+                                val height = result[0].toInt()
+                                val width = result[1].toInt()
+                                val preview = result.copyOfRange(2, result.size)
+                                runOnUiThread { drawImage(preview, height, width) }
+                            }
+                            Thread.sleep(200)
+                        }
+                    }
+                    prompts.forEachIndexed { index, prompt ->
+                        pipelineSubmit(prompt, 50, 45L + index, 512, 512)
+                    }
+                    Log.d("__TEST__", pipelineStop())
+                    consumer.join()
+                    previewer.join()
+                }
                 destroyOpenCL()
                 initialized = false
 //                MainScope().launch {
@@ -180,9 +246,7 @@ class MainActivity : AppCompatActivity() {
         }
     }
 
-    private fun drawImage(imageArray: FloatArray) {
-        val height = 512
-        val width = 512
+    private fun drawImage(imageArray: FloatArray, height: Int = 512, width: Int = 512) {
         val imgByte = imageArray.map { x ->
             (((x + 1f) / 2f).coerceIn(0f, 1f) * 255f).toUInt().toUByte()
         }
@@ -245,6 +309,15 @@ class MainActivity : AppCompatActivity() {
     external fun encode(token: LongArray): FloatArray
     external fun sample(condition: FloatArray): FloatArray
     external fun decode(): FloatArray
+    external fun benchmark(): String
+    external fun tokenizerBenchmark(): String
+    external fun accuracyGate(useCpu: Boolean): String
+    external fun pipelineStart(capacity: Int, previewInterval: Int)
+    external fun pipelineSubmit(prompt: String, steps: Int, seed: Long, height: Int, width: Int): Long
+    external fun pipelineTake(): FloatArray?
+    external fun pipelinePreview(): FloatArray?
+    external fun pipelineCancel(id: Long)
+    external fun pipelineStop(): String
     external fun destroyOpenCL()
 
     companion object {